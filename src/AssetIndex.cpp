@@ -0,0 +1,139 @@
+/* Copyright(C) 2016 Björn Stresing, Denis Manthey, Wolfgang Ruppel
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "AssetIndex.h"
+#include "ImfPackage.h"
+#include "MetadataExtractor.h"
+#include "Trace.h"
+#include <QThreadPool>
+#include <QRunnable>
+#include <QMutexLocker>
+#include <QVector>
+#include <QDebug>
+
+#define ASSET_INDEX_PREFETCH_THREADS 2 // Every read starts a Java VM for the RegXML dump (see AssetMxfTrack::ReadEssenceDescriptor()).
+#define ASSET_INDEX_PRUNE_SIZE 64 // [entries] Expired entries are removed when the index grows beyond twice the size after the last pruning.
+
+
+namespace {
+
+class PrefetchTask : public QRunnable {
+
+public:
+	PrefetchTask(const AssetIndex::Request &rRequest, AssetIndex::Entry *pEntry) : QRunnable(), mRequest(rRequest), mpEntry(pEntry) {}
+	virtual ~PrefetchTask() {}
+	virtual void run() { *mpEntry = AssetIndex::Instance().Acquire(mRequest.id, mRequest.hash, mRequest.filePath); }
+
+private:
+	Q_DISABLE_COPY(PrefetchTask);
+	const AssetIndex::Request mRequest;
+	AssetIndex::Entry *mpEntry;
+};
+}
+
+AssetIndex& AssetIndex::Instance() {
+
+	static AssetIndex index;
+	return index;
+}
+
+AssetIndex::AssetIndex() :
+mMutex(), mEntryRead(), mEntries(), mPending(), mHitCount(0), mPruneSize(ASSET_INDEX_PRUNE_SIZE) {
+
+}
+
+AssetIndex::Entry AssetIndex::Acquire(const QUuid &rId, const QByteArray &rHash, const QString &rFilePath) {
+
+	if(rHash.isEmpty() == true) return Read(rFilePath);
+	const Key key(rId, rHash);
+	{
+		QMutexLocker locker(&mMutex);
+		while(mPending.contains(key) == true) mEntryRead.wait(&mMutex);
+		Entry entry = mEntries.value(key).toStrongRef();
+		if(entry) {
+			mHitCount++;
+			return entry;
+		}
+		mPending.insert(key);
+	}
+	// Read outside the lock. Other threads asking for this key wait for the result.
+	Entry entry = Read(rFilePath);
+	QMutexLocker locker(&mMutex);
+	mEntries.insert(key, entry.toWeakRef());
+	if(mEntries.size() >= mPruneSize) PruneExpired();
+	mPending.remove(key);
+	mEntryRead.wakeAll();
+	return entry;
+}
+
+QList<AssetIndex::Entry> AssetIndex::Prefetch(const QList<Request> &rRequests) {
+
+	TRACE_SPAN_DETAIL("AssetIndex::Prefetch", "package", QString::number(rRequests.size()));
+	// Every task writes its own entry. No locking needed.
+	QVector<Entry> entries(rRequests.size());
+	QThreadPool thread_pool;
+	thread_pool.setMaxThreadCount(ASSET_INDEX_PREFETCH_THREADS);
+	QList<PrefetchTask*> tasks;
+	for(int i = 0; i < rRequests.size(); i++) {
+		PrefetchTask *p_task = new PrefetchTask(rRequests.at(i), &entries[i]);
+		p_task->setAutoDelete(false);
+		tasks << p_task;
+		thread_pool.start(p_task);
+	}
+	thread_pool.waitForDone();
+	qDeleteAll(tasks);
+	return entries.toList();
+}
+
+AssetIndex::Entry AssetIndex::Read(const QString &rFilePath) {
+
+	TRACE_SPAN_DETAIL("AssetIndex::Read", "mxf", QFileInfo(rFilePath).fileName());
+	TrackFile *p_track_file = new TrackFile;
+	MetadataExtractor extractor;
+	Error error = extractor.ReadMetadata(p_track_file->metadata, rFilePath);
+	if(error.IsError() == true) qDebug() << "Failed to read metadata from " << rFilePath << error;
+	p_track_file->essenceDescriptor = AssetMxfTrack::ReadEssenceDescriptor(rFilePath, error);
+	if(p_track_file->essenceDescriptor) p_track_file->sourceEncoding = ImfXmlHelper::Convert(p_track_file->essenceDescriptor->getId());
+	else qDebug() << "Failed to extract essence descriptor from " << rFilePath << error;
+	return Entry(p_track_file);
+}
+
+void AssetIndex::PruneExpired() {
+
+	QHash<Key, QWeakPointer<const TrackFile> >::iterator i = mEntries.begin();
+	while(i != mEntries.end()) {
+		if(i.value().isNull() == true) i = mEntries.erase(i);
+		else ++i;
+	}
+	// Amortized: The next pruning happens after the live entries doubled.
+	mPruneSize = qMax(ASSET_INDEX_PRUNE_SIZE, mEntries.size() * 2);
+}
+
+int AssetIndex::GetCount() const {
+
+	QMutexLocker locker(&mMutex);
+	int count = 0;
+	QHash<Key, QWeakPointer<const TrackFile> >::const_iterator i = mEntries.constBegin();
+	for(; i != mEntries.constEnd(); ++i) {
+		if(i.value().isNull() == false) count++;
+	}
+	return count;
+}
+
+qint64 AssetIndex::GetHitCount() const {
+
+	QMutexLocker locker(&mMutex);
+	return mHitCount;
+}
@@ -0,0 +1,81 @@
+/* Copyright(C) 2016 Björn Stresing, Denis Manthey, Wolfgang Ruppel
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include "MetadataExtractorCommon.h"
+#include "EssenceDescriptorTable.h"
+#include <QByteArray>
+#include <QString>
+#include <QUuid>
+#include <QHash>
+#include <QPair>
+#include <QList>
+#include <QSet>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QSharedPointer>
+#include <QWeakPointer>
+
+
+/*! \brief Process wide index of the imported track files of all loaded packages.
+Track files are keyed by Id and content hash (the hash of the Packing List). The metadata, essence descriptor and source encoding
+of a track file are read once and shared by all assets with the same key, regardless of the package that lists them. A supplemental
+package and its OV (original version) therefore read a shared track file once. Reading the essence descriptor (RegXML dump) is the
+expensive part of an ingest.
+An entry lives as long as an asset references it. Expired keys are removed as new track files are indexed. Thread safe.
+*/
+class AssetIndex {
+
+public:
+	struct TrackFile {
+		Metadata metadata;
+		EssenceDescriptorTable::Descriptor essenceDescriptor; // Null if the descriptor couldn't be extracted.
+		QUuid sourceEncoding;
+	};
+	typedef QSharedPointer<const TrackFile> Entry;
+	//! A track file to read: Id, content hash and absolute file path.
+	struct Request {
+		Request(const QUuid &rId = QUuid(), const QByteArray &rHash = QByteArray(), const QString &rFilePath = QString()) : id(rId), hash(rHash), filePath(rFilePath) {}
+		QUuid id;
+		QByteArray hash;
+		QString filePath;
+	};
+	static AssetIndex& Instance();
+	//! Returns the shared entry of the track file. Reads rFilePath if the track file isn't indexed. Concurrent calls for the same key read the file once. Track files without hash aren't indexed.
+	Entry Acquire(const QUuid &rId, const QByteArray &rHash, const QString &rFilePath);
+	//! Acquires the track files on two threads. The entries are only kept while they are referenced: Hold the returned list until the assets were created.
+	QList<Entry> Prefetch(const QList<Request> &rRequests);
+	//! Reads the metadata and the essence descriptor of a track file without indexing it.
+	static Entry Read(const QString &rFilePath);
+	//! Number of distinct track files currently referenced.
+	int GetCount() const;
+	//! Number of Acquire() calls served by an existing entry.
+	qint64 GetHitCount() const;
+
+private:
+	AssetIndex();
+	~AssetIndex() {}
+	Q_DISABLE_COPY(AssetIndex);
+	typedef QPair<QUuid, QByteArray> Key;
+	//! Removes the keys of entries no longer referenced. Call with mMutex held.
+	void PruneExpired();
+
+	mutable QMutex mMutex;
+	QWaitCondition mEntryRead;
+	QHash<Key, QWeakPointer<const TrackFile> > mEntries;
+	QSet<Key> mPending; // Keys currently read by some thread.
+	qint64 mHitCount;
+	int mPruneSize; // Size of mEntries that triggers the next pruning.
+};
@@ -0,0 +1,247 @@
+/* Copyright(C) 2016 Björn Stresing, Denis Manthey, Wolfgang Ruppel
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "AudioAnalysis.h"
+#include "ImfCommon.h"
+#include "AudioKernels.h"
+#include <QStringList>
+#include <QtNumeric>
+#include <cmath>
+#include <limits>
+
+
+namespace {
+
+	// ITU-R BS.1770-4 Annex 2: 4x oversampling interpolation filter (48 taps, one row per phase).
+	const float interpolation_filter[AudioAnalyzer::OversamplingFactor][12] = {
+		{ 0.0017089843750f, 0.0109863281250f, -0.0196533203125f, 0.0332031250000f, -0.0594482421875f, 0.1373291015625f, 0.9721679687500f, -0.1022949218750f, 0.0476074218750f, -0.0266113281250f, 0.0148925781250f, -0.0083007812500f },
+		{ -0.0291748046875f, 0.0292968750000f, -0.0517578125000f, 0.0891113281250f, -0.1665039062500f, 0.4650878906250f, 0.7797851562500f, -0.2003173828125f, 0.1015625000000f, -0.0582275390625f, 0.0330810546875f, -0.0189208984375f },
+		{ -0.0189208984375f, 0.0330810546875f, -0.0582275390625f, 0.1015625000000f, -0.2003173828125f, 0.7797851562500f, 0.4650878906250f, -0.1665039062500f, 0.0891113281250f, -0.0517578125000f, 0.0292968750000f, -0.0291748046875f },
+		{ -0.0083007812500f, 0.0148925781250f, -0.0266113281250f, 0.0476074218750f, -0.1022949218750f, 0.9721679687500f, 0.1373291015625f, -0.0594482421875f, 0.0332031250000f, -0.0196533203125f, 0.0109863281250f, 0.0017089843750f }
+	};
+
+	double to_db(double value) {
+
+		if(value <= 0) return -std::numeric_limits<double>::infinity();
+		return 20. * std::log10(value);
+	}
+
+	double to_lufs(double meanSquare) {
+
+		if(meanSquare <= 0) return -std::numeric_limits<double>::infinity();
+		return -0.691 + 10. * std::log10(meanSquare);
+	}
+
+	QString format_level(double level, const QString &rUnit) {
+
+		if(qIsInf(level)) return QString("-inf %1").arg(rUnit);
+		return QString("%1 %2").arg(level, 0, 'f', 1).arg(rUnit);
+	}
+}
+
+AudioAnalysisResult::AudioAnalysisResult() :
+integratedLoudness(-std::numeric_limits<double>::infinity()), truePeak(-std::numeric_limits<double>::infinity()), channelTruePeak(), silentChannels() {
+
+}
+
+QString AudioAnalysisResult::GetAsString() const {
+
+	return QString("%1, %2").arg(format_level(integratedLoudness, "LUFS")).arg(format_level(truePeak, "dBTP"));
+}
+
+QString AudioAnalysisResult::GetSilentChannelsAsString() const {
+
+	QStringList channels;
+	for(int i = 0; i < silentChannels.size(); i++) channels << QString::number(silentChannels.at(i) + 1);
+	return channels.join(", ");
+}
+
+AudioAnalyzer::AudioAnalyzer(double sampleRate, int channelCount, int bitsPerSample, const QVector<double> &rChannelWeights /*= QVector<double>()*/) :
+mChannelCount(qMax(1, channelCount)), mBytesPerSample(qBound(2, (bitsPerSample + 7) / 8, 4)), mBlockFrames(qMax(1, qRound(sampleRate / 10.))), mWeights(rChannelWeights),
+mPreFilter(), mRlbFilter(), mBlock(), mBlockPointers(mChannelCount), mBlockFill(0), mInterpolationInput(), mInterpolationOutput(), mChannels(mChannelCount), mBlockEnergy() {
+
+	if(mWeights.size() != mChannelCount) mWeights = QVector<double>(mChannelCount, 1.);
+	mBlock.resize(mChannelCount * mBlockFrames);
+	mInterpolationInput.resize(TapsPerPhase - 1 + mBlockFrames);
+	mInterpolationOutput.resize(mBlockFrames);
+	// K-weighting filter coefficients for arbitrary sampling rates. Derived from the 48 kHz coefficients of BS.1770-4 (identical at 48 kHz).
+	const double pi = 3.14159265358979323846;
+	double K = std::tan(pi * 1681.974450955533 / sampleRate);
+	double Q = 0.7071752369554196;
+	const double Vh = std::pow(10., 3.999843853973347 / 20.);
+	const double Vb = std::pow(Vh, 0.4996667741545416);
+	double a0 = 1. + K / Q + K * K;
+	mPreFilter.b0 = (Vh + Vb * K / Q + K * K) / a0;
+	mPreFilter.b1 = 2. * (K * K - Vh) / a0;
+	mPreFilter.b2 = (Vh - Vb * K / Q + K * K) / a0;
+	mPreFilter.a1 = 2. * (K * K - 1.) / a0;
+	mPreFilter.a2 = (1. - K / Q + K * K) / a0;
+	K = std::tan(pi * 38.13547087602444 / sampleRate);
+	Q = 0.5003270373238773;
+	a0 = 1. + K / Q + K * K;
+	mRlbFilter.b0 = 1.;
+	mRlbFilter.b1 = -2.;
+	mRlbFilter.b2 = 1.;
+	mRlbFilter.a1 = 2. * (K * K - 1.) / a0;
+	mRlbFilter.a2 = (1. - K / Q + K * K) / a0;
+}
+
+void AudioAnalyzer::Process(const unsigned char *pData, int frameCount) {
+
+	while(frameCount > 0) {
+		const int count = qMin(frameCount, mBlockFrames - mBlockFill);
+		for(int channel = 0; channel < mChannelCount; channel++) mBlockPointers[channel] = mBlock.data() + channel * mBlockFrames + mBlockFill;
+		AudioKernels::DeinterleaveToFloat(pData, mBytesPerSample, mChannelCount, mBlockPointers.constData(), count);
+		mBlockFill += count;
+		pData += count * mChannelCount * mBytesPerSample;
+		frameCount -= count;
+		if(mBlockFill == mBlockFrames) {
+			ProcessBlock(mBlockFill);
+			mBlockFill = 0;
+		}
+	}
+}
+
+void AudioAnalyzer::ProcessBlock(int frameCount) {
+
+	double energy = 0;
+	for(int channel = 0; channel < mChannelCount; channel++) {
+		const float *p_samples = mBlock.constData() + channel * mBlockFrames;
+		ChannelState &r_state = mChannels[channel];
+		float min = 0, max = 0;
+		AudioKernels::MinMax(p_samples, frameCount, min, max);
+		r_state.samplePeak = qMax(r_state.samplePeak, qMax(-min, max));
+		r_state.truePeak = qMax(r_state.truePeak, TruePeak(r_state, p_samples, frameCount));
+		const double channel_energy = KWeightedEnergy(r_state, p_samples, frameCount);
+		energy += mWeights.at(channel) * channel_energy;
+	}
+	// Incomplete blocks (end of file) don't take part in gating.
+	if(frameCount == mBlockFrames) mBlockEnergy.push_back(energy);
+}
+
+double AudioAnalyzer::KWeightedEnergy(ChannelState &rState, const float *pSamples, int frameCount) const {
+
+	// Two cascaded biquads, transposed direct form II.
+	double z0 = rState.z[0], z1 = rState.z[1], z2 = rState.z[2], z3 = rState.z[3];
+	double sum = 0;
+	for(int i = 0; i < frameCount; i++) {
+		const double x = pSamples[i];
+		const double y = mPreFilter.b0 * x + z0;
+		z0 = mPreFilter.b1 * x - mPreFilter.a1 * y + z1;
+		z1 = mPreFilter.b2 * x - mPreFilter.a2 * y;
+		const double w = mRlbFilter.b0 * y + z2;
+		z2 = mRlbFilter.b1 * y - mRlbFilter.a1 * w + z3;
+		z3 = mRlbFilter.b2 * y - mRlbFilter.a2 * w;
+		sum += w * w;
+	}
+	rState.z[0] = z0;
+	rState.z[1] = z1;
+	rState.z[2] = z2;
+	rState.z[3] = z3;
+	return sum;
+}
+
+float AudioAnalyzer::TruePeak(ChannelState &rState, const float *pSamples, int frameCount) {
+
+	// mInterpolationInput holds the last TapsPerPhase - 1 samples of the previous block followed by this block.
+	float *p_input = mInterpolationInput.data();
+	float *p_output = mInterpolationOutput.data();
+	for(int i = 0; i < TapsPerPhase - 1; i++) p_input[i] = rState.history[i];
+	for(int i = 0; i < frameCount; i++) p_input[TapsPerPhase - 1 + i] = pSamples[i];
+	float min = 0, max = 0;
+	for(int phase = 0; phase < OversamplingFactor; phase++) {
+		for(int i = 0; i < frameCount; i++) p_output[i] = 0;
+		for(int tap = 0; tap < TapsPerPhase; tap++) {
+			const float coefficient = interpolation_filter[phase][tap];
+			const float *p_tap_input = p_input + TapsPerPhase - 1 - tap;
+			for(int i = 0; i < frameCount; i++) p_output[i] += coefficient * p_tap_input[i];
+		}
+		AudioKernels::MinMax(p_output, frameCount, min, max);
+	}
+	for(int i = 0; i < TapsPerPhase - 1; i++) rState.history[i] = p_input[frameCount + i];
+	return qMax(-min, max);
+}
+
+AudioAnalysisResult AudioAnalyzer::Finish() {
+
+	if(mBlockFill > 0) {
+		ProcessBlock(mBlockFill);
+		mBlockFill = 0;
+	}
+	AudioAnalysisResult result;
+	// Gating blocks of 400 ms overlap by 75 %, i.e. every gating block is the sum of four 100 ms blocks.
+	QVector<double> gating_blocks;
+	for(int i = 3; i < mBlockEnergy.size(); i++) {
+		gating_blocks.push_back((mBlockEnergy.at(i - 3) + mBlockEnergy.at(i - 2) + mBlockEnergy.at(i - 1) + mBlockEnergy.at(i)) / (4. * mBlockFrames));
+	}
+	double sum = 0;
+	int count = 0;
+	for(int i = 0; i < gating_blocks.size(); i++) {
+		if(to_lufs(gating_blocks.at(i)) > -70.) { // absolute gate
+			sum += gating_blocks.at(i);
+			count++;
+		}
+	}
+	if(count > 0) {
+		const double relative_gate = to_lufs(sum / count) - 10.;
+		sum = 0;
+		count = 0;
+		for(int i = 0; i < gating_blocks.size(); i++) {
+			const double loudness = to_lufs(gating_blocks.at(i));
+			if(loudness > -70. && loudness > relative_gate) {
+				sum += gating_blocks.at(i);
+				count++;
+			}
+		}
+		if(count > 0) result.integratedLoudness = to_lufs(sum / count);
+	}
+	const double silence_threshold = std::pow(10., SilenceThreshold / 20.);
+	for(int channel = 0; channel < mChannelCount; channel++) {
+		const ChannelState &r_state = mChannels.at(channel);
+		// The interpolation filter doesn't pass every sample unaltered, the true-peak is never below the sample peak.
+		const double channel_true_peak = to_db(qMax(r_state.truePeak, r_state.samplePeak));
+		result.channelTruePeak.push_back(channel_true_peak);
+		result.truePeak = qMax(result.truePeak, channel_true_peak);
+		if(r_state.samplePeak < silence_threshold) result.silentChannels.push_back(channel);
+	}
+	return result;
+}
+
+QVector<double> AudioAnalyzer::GetChannelWeights(const SoundfieldGroup &rSoundfieldGroup) {
+
+	QVector<double> weights;
+	for(int i = 0; i < rSoundfieldGroup.GetChannelCount(); i++) {
+		switch(rSoundfieldGroup.GetChannel(i)) {
+			case SoundfieldGroup::ChannelLFE:
+				weights.push_back(0.);
+				break;
+			case SoundfieldGroup::ChannelLs:
+			case SoundfieldGroup::ChannelRs:
+			case SoundfieldGroup::ChannelLss:
+			case SoundfieldGroup::ChannelRss:
+			case SoundfieldGroup::ChannelLrs:
+			case SoundfieldGroup::ChannelRrs:
+			case SoundfieldGroup::ChannelLst:
+			case SoundfieldGroup::ChannelRst:
+			case SoundfieldGroup::ChannelCs:
+				weights.push_back(1.41);
+				break;
+			default:
+				weights.push_back(1.);
+				break;
+		}
+	}
+	return weights;
+}
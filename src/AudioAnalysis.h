@@ -0,0 +1,94 @@
+/* Copyright(C) 2016 Björn Stresing, Denis Manthey, Wolfgang Ruppel
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <QVector>
+#include <QList>
+#include <QString>
+#include <QMetaType>
+
+
+class SoundfieldGroup;
+
+//! Result of AudioAnalyzer. Levels of digital silence are -inf.
+struct AudioAnalysisResult {
+
+	AudioAnalysisResult();
+	//! False if no analysis was performed.
+	bool IsValid() const { return channelTruePeak.isEmpty() == false; }
+	//! Returns a short human readable summary, e.g. "-23.0 LUFS, -1.2 dBTP".
+	QString GetAsString() const;
+	//! Returns the one based numbers of the silent channels, e.g. "3, 4".
+	QString GetSilentChannelsAsString() const;
+	double integratedLoudness; // ITU-R BS.1770-4 gated loudness [LUFS]
+	double truePeak; // Maximum of all channels [dBTP]
+	QVector<double> channelTruePeak; // [dBTP]
+	QList<int> silentChannels; // Zero based indexes of channels which never exceed AudioAnalyzer::SilenceThreshold.
+};
+
+/*! \brief Measures integrated loudness (ITU-R BS.1770-4 / EBU R128), true-peak and silent channels of interleaved PCM.
+The samples are fed block wise (AudioAnalyzer::Process()) while they are read anyway, e.g. by JobWrapWav. Samples are collected per channel in
+blocks of 100 ms and converted to float (AudioKernels). Every block is K-weighted (two biquads) and its mean square is kept for gating, the true-peak
+is measured by 4x oversampling with the 48 tap interpolation filter of BS.1770-4 Annex 2. Peaks are searched with AudioKernels::MinMax(), the interpolation
+filter runs over contiguous float arrays and is vectorized by the compiler.
+*/
+class AudioAnalyzer {
+
+public:
+	static const int SilenceThreshold = -90; // [dBFS]
+	static const int OversamplingFactor = 4;
+	//! rChannelWeights: One weight per channel, see AudioAnalyzer::GetChannelWeights(). All channels are weighted 1 if empty.
+	AudioAnalyzer(double sampleRate, int channelCount, int bitsPerSample, const QVector<double> &rChannelWeights = QVector<double>());
+	~AudioAnalyzer() {}
+	//! Analyzes frameCount interleaved little endian PCM frames (16, 24 or 32 bit). May be called with any number of frames.
+	void Process(const unsigned char *pData, int frameCount);
+	//! Analyzes pending samples and returns the result. Call once after the last AudioAnalyzer::Process().
+	AudioAnalysisResult Finish();
+	//! BS.1770-4 channel weights for the assigned channels: 0 for LFE, 1.41 for surround channels, 1 otherwise.
+	static QVector<double> GetChannelWeights(const SoundfieldGroup &rSoundfieldGroup);
+
+private:
+	Q_DISABLE_COPY(AudioAnalyzer);
+	struct Biquad {
+		double b0, b1, b2, a1, a2;
+	};
+	static const int TapsPerPhase = 12;
+	struct ChannelState {
+		ChannelState() : samplePeak(0), truePeak(0) { for(int i = 0; i < 4; i++) z[i] = 0; for(int i = 0; i < TapsPerPhase - 1; i++) history[i] = 0; }
+		double z[4]; // K-weighting filter states, two per stage.
+		float history[TapsPerPhase - 1]; // Last samples of the previous block for the interpolation filter.
+		float samplePeak;
+		float truePeak;
+	};
+	void ProcessBlock(int frameCount);
+	double KWeightedEnergy(ChannelState &rState, const float *pSamples, int frameCount) const;
+	float TruePeak(ChannelState &rState, const float *pSamples, int frameCount);
+
+	const int mChannelCount;
+	const int mBytesPerSample;
+	const int mBlockFrames; // 100 ms
+	QVector<double> mWeights;
+	Biquad mPreFilter;
+	Biquad mRlbFilter;
+	QVector<float> mBlock; // Planar: mBlockFrames samples per channel.
+	QVector<float*> mBlockPointers; // Write position per channel.
+	int mBlockFill; // [frames]
+	QVector<float> mInterpolationInput;
+	QVector<float> mInterpolationOutput;
+	QVector<ChannelState> mChannels;
+	QVector<double> mBlockEnergy; // Weighted sum of squares of every complete 100 ms block.
+};
+
+Q_DECLARE_METATYPE(AudioAnalysisResult)
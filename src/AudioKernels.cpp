@@ -0,0 +1,637 @@
+/* Copyright(C) 2016 Björn Stresing, Denis Manthey, Wolfgang Ruppel
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "AudioKernels.h"
+#include <QtGlobal>
+#include <QAtomicPointer>
+#include <cstring>
+#include <cmath>
+
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN && (defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86))
+#define AUDIO_KERNELS_X86
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define AUDIO_KERNELS_TARGET_SSE2
+#define AUDIO_KERNELS_TARGET_AVX2
+#else
+#include <immintrin.h>
+#define AUDIO_KERNELS_TARGET_SSE2 __attribute__((target("sse2")))
+#define AUDIO_KERNELS_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#elif Q_BYTE_ORDER == Q_LITTLE_ENDIAN && (defined(__aarch64__) || defined(_M_ARM64))
+#define AUDIO_KERNELS_NEON
+#include <arm_neon.h>
+#endif
+
+
+namespace {
+
+	struct KernelTable {
+		AudioKernels::eInstructionSet instructionSet;
+		void (*toFloat)(const unsigned char*, int, float*, int);
+		void (*fromFloat)(const float*, unsigned char*, int, int);
+		void (*deinterleaveToFloat)(const unsigned char*, int, int, float * const *, int);
+		void (*minMax)(const float*, int, float&, float&);
+	};
+
+	const float to_float_scale = 1.f / 2147483648.f; // Samples are converted as if they were the most significant bytes of a 32 bit integer.
+
+	// Full scale and largest positive float value which converts to an in range integer.
+	inline float full_scale(int bytesPerSample) { return (float)(1u << (8 * bytesPerSample - 1)); }
+	inline float max_value(int bytesPerSample) { return bytesPerSample == 4 ? 2147483520.f : full_scale(bytesPerSample) - 1.f; }
+
+	// Reads 4 bytes. The bytes beyond the sample are shifted out by the caller.
+	inline quint32 load_word(const unsigned char *pData) {
+
+		quint32 word;
+		std::memcpy(&word, pData, sizeof(word));
+		return word;
+	}
+
+	template<int bytes>
+	inline qint32 load_sample(const unsigned char *pData) {
+
+		quint32 value = 0;
+		for(int b = 0; b < bytes; b++) value |= (quint32)pData[b] << (32 - 8 * bytes + 8 * b);
+		return (qint32)value;
+	}
+
+	template<int bytes>
+	inline void store_sample(qint32 value, unsigned char *pData) {
+
+		for(int b = 0; b < bytes; b++) pData[b] = (unsigned char)((quint32)value >> (8 * b));
+	}
+
+	template<int bytes>
+	void scalar_to_float(const unsigned char *pSource, float *pDestination, int count) {
+
+		for(int i = 0; i < count; i++) pDestination[i] = load_sample<bytes>(pSource + i * bytes) * to_float_scale;
+	}
+
+	void scalar_to_float(const unsigned char *pSource, int bytesPerSample, float *pDestination, int count) {
+
+		switch(bytesPerSample) {
+			case 2: scalar_to_float<2>(pSource, pDestination, count); break;
+			case 3: scalar_to_float<3>(pSource, pDestination, count); break;
+			case 4: scalar_to_float<4>(pSource, pDestination, count); break;
+		}
+	}
+
+	template<int bytes>
+	void scalar_from_float(const float *pSource, unsigned char *pDestination, int count) {
+
+		const float scale = full_scale(bytes);
+		const float max = max_value(bytes);
+		for(int i = 0; i < count; i++) {
+			const float product = pSource[i] * scale;
+			// NaN converts to 0.
+			const float value = (product == product) ? qMin(qMax(product, -scale), max) : 0.f;
+			store_sample<bytes>((qint32)lrintf(value), pDestination + i * bytes);
+		}
+	}
+
+	void scalar_from_float(const float *pSource, unsigned char *pDestination, int bytesPerSample, int count) {
+
+		switch(bytesPerSample) {
+			case 2: scalar_from_float<2>(pSource, pDestination, count); break;
+			case 3: scalar_from_float<3>(pSource, pDestination, count); break;
+			case 4: scalar_from_float<4>(pSource, pDestination, count); break;
+		}
+	}
+
+	template<int bytes>
+	void scalar_deinterleave_to_float(const unsigned char *pSource, int channelCount, float *pDestination, int frameCount) {
+
+		const int stride = channelCount * bytes;
+		for(int i = 0; i < frameCount; i++) pDestination[i] = load_sample<bytes>(pSource + i * stride) * to_float_scale;
+	}
+
+	// Converts the frames [first, frameCount) of every channel.
+	void scalar_deinterleave_to_float(const unsigned char *pSource, int bytesPerSample, int channelCount, float * const *ppDestination, int first, int frameCount) {
+
+		for(int channel = 0; channel < channelCount; channel++) {
+			const unsigned char *p_source = pSource + (first * channelCount + channel) * bytesPerSample;
+			switch(bytesPerSample) {
+				case 2: scalar_deinterleave_to_float<2>(p_source, channelCount, ppDestination[channel] + first, frameCount - first); break;
+				case 3: scalar_deinterleave_to_float<3>(p_source, channelCount, ppDestination[channel] + first, frameCount - first); break;
+				case 4: scalar_deinterleave_to_float<4>(p_source, channelCount, ppDestination[channel] + first, frameCount - first); break;
+			}
+		}
+	}
+
+	void scalar_deinterleave_to_float(const unsigned char *pSource, int bytesPerSample, int channelCount, float * const *ppDestination, int frameCount) {
+
+		scalar_deinterleave_to_float(pSource, bytesPerSample, channelCount, ppDestination, 0, frameCount);
+	}
+
+	void scalar_min_max(const float *pSource, int count, float &rMin, float &rMax) {
+
+		float min = rMin, max = rMax;
+		for(int i = 0; i < count; i++) {
+			min = qMin(min, pSource[i]);
+			max = qMax(max, pSource[i]);
+		}
+		rMin = min;
+		rMax = max;
+	}
+
+	const KernelTable scalar_kernels = { AudioKernels::Scalar, scalar_to_float, scalar_from_float, scalar_deinterleave_to_float, scalar_min_max };
+
+#ifdef AUDIO_KERNELS_X86
+
+	// The vector loops stop early enough that 4 byte loads and stores of 3 byte samples stay within the buffers. The scalar kernels process the rest.
+
+	AUDIO_KERNELS_TARGET_SSE2 void sse2_to_float(const unsigned char *pSource, int bytesPerSample, float *pDestination, int count) {
+
+		const __m128 scale = _mm_set1_ps(to_float_scale);
+		const __m128i zero = _mm_setzero_si128();
+		int i = 0;
+		if(bytesPerSample == 2) {
+			for(; i + 8 <= count; i += 8) {
+				const __m128i samples = _mm_loadu_si128((const __m128i*)(pSource + i * 2));
+				_mm_storeu_ps(pDestination + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(zero, samples)), scale));
+				_mm_storeu_ps(pDestination + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(zero, samples)), scale));
+			}
+		}
+		else if(bytesPerSample == 3) {
+			for(; i + 5 <= count; i += 4) {
+				const unsigned char *p_source = pSource + i * 3;
+				const __m128i words = _mm_set_epi32(load_word(p_source + 9), load_word(p_source + 6), load_word(p_source + 3), load_word(p_source));
+				_mm_storeu_ps(pDestination + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_slli_epi32(words, 8)), scale));
+			}
+		}
+		else if(bytesPerSample == 4) {
+			for(; i + 4 <= count; i += 4) {
+				_mm_storeu_ps(pDestination + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)(pSource + i * 4))), scale));
+			}
+		}
+		scalar_to_float(pSource + i * bytesPerSample, bytesPerSample, pDestination + i, count - i);
+	}
+
+	AUDIO_KERNELS_TARGET_SSE2 inline __m128i sse2_convert(const float *pSource, __m128 scale, __m128 min, __m128 max) {
+
+		const __m128 product = _mm_mul_ps(_mm_loadu_ps(pSource), scale);
+		// Zeroes NaN lanes, _mm_max_ps() would turn them into min.
+		return _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(_mm_and_ps(product, _mm_cmpord_ps(product, product)), min), max));
+	}
+
+	AUDIO_KERNELS_TARGET_SSE2 void sse2_from_float(const float *pSource, unsigned char *pDestination, int bytesPerSample, int count) {
+
+		const __m128 scale = _mm_set1_ps(full_scale(bytesPerSample));
+		const __m128 min = _mm_set1_ps(-full_scale(bytesPerSample));
+		const __m128 max = _mm_set1_ps(max_value(bytesPerSample));
+		int i = 0;
+		if(bytesPerSample == 2) {
+			for(; i + 8 <= count; i += 8) {
+				const __m128i low = sse2_convert(pSource + i, scale, min, max);
+				const __m128i high = sse2_convert(pSource + i + 4, scale, min, max);
+				_mm_storeu_si128((__m128i*)(pDestination + i * 2), _mm_packs_epi32(low, high));
+			}
+		}
+		else if(bytesPerSample == 3) {
+			for(; i + 5 <= count; i += 4) {
+				quint32 words[4];
+				_mm_storeu_si128((__m128i*)words, sse2_convert(pSource + i, scale, min, max));
+				// Every store overwrites the surplus byte of the previous one.
+				for(int k = 0; k < 4; k++) std::memcpy(pDestination + (i + k) * 3, &words[k], 4);
+			}
+		}
+		else if(bytesPerSample == 4) {
+			for(; i + 4 <= count; i += 4) {
+				_mm_storeu_si128((__m128i*)(pDestination + i * 4), sse2_convert(pSource + i, scale, min, max));
+			}
+		}
+		scalar_from_float(pSource + i, pDestination + i * bytesPerSample, bytesPerSample, count - i);
+	}
+
+	AUDIO_KERNELS_TARGET_SSE2 void sse2_deinterleave_to_float(const unsigned char *pSource, int bytesPerSample, int channelCount, float * const *ppDestination, int frameCount) {
+
+		const __m128 scale = _mm_set1_ps(to_float_scale);
+		const __m128i shift = _mm_cvtsi32_si128(32 - 8 * bytesPerSample);
+		const int stride = channelCount * bytesPerSample;
+		// The 4 byte loads of the last frame would read beyond the buffer.
+		const int vector_frames = qMax(0, frameCount - 1) / 4 * 4;
+		for(int channel = 0; channel < channelCount; channel++) {
+			const unsigned char *p_source = pSource + channel * bytesPerSample;
+			float *p_destination = ppDestination[channel];
+			for(int i = 0; i < vector_frames; i += 4) {
+				const unsigned char *p = p_source + i * stride;
+				const __m128i words = _mm_set_epi32(load_word(p + 3 * stride), load_word(p + 2 * stride), load_word(p + stride), load_word(p));
+				_mm_storeu_ps(p_destination + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_sll_epi32(words, shift)), scale));
+			}
+		}
+		scalar_deinterleave_to_float(pSource, bytesPerSample, channelCount, ppDestination, vector_frames, frameCount);
+	}
+
+	AUDIO_KERNELS_TARGET_SSE2 void sse2_min_max(const float *pSource, int count, float &rMin, float &rMax) {
+
+		__m128 min = _mm_set1_ps(rMin);
+		__m128 max = _mm_set1_ps(rMax);
+		int i = 0;
+		for(; i + 4 <= count; i += 4) {
+			const __m128 samples = _mm_loadu_ps(pSource + i);
+			// The second operand is returned for NaN, so NaN samples are skipped like in scalar_min_max().
+			min = _mm_min_ps(samples, min);
+			max = _mm_max_ps(samples, max);
+		}
+		float mins[4], maxs[4];
+		_mm_storeu_ps(mins, min);
+		_mm_storeu_ps(maxs, max);
+		for(int k = 0; k < 4; k++) {
+			rMin = qMin(rMin, mins[k]);
+			rMax = qMax(rMax, maxs[k]);
+		}
+		scalar_min_max(pSource + i, count - i, rMin, rMax);
+	}
+
+	const KernelTable sse2_kernels = { AudioKernels::Sse2, sse2_to_float, sse2_from_float, sse2_deinterleave_to_float, sse2_min_max };
+
+	AUDIO_KERNELS_TARGET_AVX2 void avx2_to_float(const unsigned char *pSource, int bytesPerSample, float *pDestination, int count) {
+
+		const __m256 scale = _mm256_set1_ps(to_float_scale);
+		int i = 0;
+		if(bytesPerSample == 2) {
+			const __m256 scale_16 = _mm256_set1_ps(1.f / 32768.f);
+			for(; i + 8 <= count; i += 8) {
+				const __m256i samples = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(pSource + i * 2)));
+				_mm256_storeu_ps(pDestination + i, _mm256_mul_ps(_mm256_cvtepi32_ps(samples), scale_16));
+			}
+		}
+		else if(bytesPerSample == 3) {
+			// Moves the 3 bytes of every sample to the most significant bytes of a 32 bit lane.
+			const __m256i expand = _mm256_setr_epi8(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11);
+			for(; i + 10 <= count; i += 8) {
+				const unsigned char *p_source = pSource + i * 3;
+				const __m256i bytes = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)p_source)), _mm_loadu_si128((const __m128i*)(p_source + 12)), 1);
+				_mm256_storeu_ps(pDestination + i, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_shuffle_epi8(bytes, expand)), scale));
+			}
+		}
+		else if(bytesPerSample == 4) {
+			for(; i + 8 <= count; i += 8) {
+				_mm256_storeu_ps(pDestination + i, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i*)(pSource + i * 4))), scale));
+			}
+		}
+		scalar_to_float(pSource + i * bytesPerSample, bytesPerSample, pDestination + i, count - i);
+	}
+
+	AUDIO_KERNELS_TARGET_AVX2 inline __m256i avx2_convert(const float *pSource, __m256 scale, __m256 min, __m256 max) {
+
+		const __m256 product = _mm256_mul_ps(_mm256_loadu_ps(pSource), scale);
+		return _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(_mm256_and_ps(product, _mm256_cmp_ps(product, product, _CMP_ORD_Q)), min), max));
+	}
+
+	AUDIO_KERNELS_TARGET_AVX2 void avx2_from_float(const float *pSource, unsigned char *pDestination, int bytesPerSample, int count) {
+
+		const __m256 scale = _mm256_set1_ps(full_scale(bytesPerSample));
+		const __m256 min = _mm256_set1_ps(-full_scale(bytesPerSample));
+		const __m256 max = _mm256_set1_ps(max_value(bytesPerSample));
+		int i = 0;
+		if(bytesPerSample == 2) {
+			for(; i + 16 <= count; i += 16) {
+				const __m256i packed = _mm256_packs_epi32(avx2_convert(pSource + i, scale, min, max), avx2_convert(pSource + i + 8, scale, min, max));
+				_mm256_storeu_si256((__m256i*)(pDestination + i * 2), _mm256_permute4x64_epi64(packed, 0xD8)); // packs works per 128 bit lane
+			}
+		}
+		else if(bytesPerSample == 3) {
+			// Packs the 3 least significant bytes of every 32 bit lane to the first 12 bytes of every 128 bit lane.
+			const __m256i pack = _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1, 0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+			for(; i + 10 <= count; i += 8) {
+				const __m256i packed = _mm256_shuffle_epi8(avx2_convert(pSource + i, scale, min, max), pack);
+				// The 16 byte stores write 4 surplus bytes each. The second store and the next iteration overwrite them.
+				_mm_storeu_si128((__m128i*)(pDestination + i * 3), _mm256_castsi256_si128(packed));
+				_mm_storeu_si128((__m128i*)(pDestination + i * 3 + 12), _mm256_extracti128_si256(packed, 1));
+			}
+		}
+		else if(bytesPerSample == 4) {
+			for(; i + 8 <= count; i += 8) {
+				_mm256_storeu_si256((__m256i*)(pDestination + i * 4), avx2_convert(pSource + i, scale, min, max));
+			}
+		}
+		scalar_from_float(pSource + i, pDestination + i * bytesPerSample, bytesPerSample, count - i);
+	}
+
+	AUDIO_KERNELS_TARGET_AVX2 void avx2_deinterleave_to_float(const unsigned char *pSource, int bytesPerSample, int channelCount, float * const *ppDestination, int frameCount) {
+
+		const __m256 scale = _mm256_set1_ps(to_float_scale);
+		const __m128i shift = _mm_cvtsi32_si128(32 - 8 * bytesPerSample);
+		const int stride = channelCount * bytesPerSample;
+		const __m256i offsets = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(stride));
+		// The 4 byte loads of the last frame would read beyond the buffer.
+		const int vector_frames = qMax(0, frameCount - 1) / 8 * 8;
+		for(int channel = 0; channel < channelCount; channel++) {
+			const unsigned char *p_source = pSource + channel * bytesPerSample;
+			float *p_destination = ppDestination[channel];
+			for(int i = 0; i < vector_frames; i += 8) {
+				const __m256i words = _mm256_i32gather_epi32((const int*)(p_source + i * stride), offsets, 1);
+				_mm256_storeu_ps(p_destination + i, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_sll_epi32(words, shift)), scale));
+			}
+		}
+		scalar_deinterleave_to_float(pSource, bytesPerSample, channelCount, ppDestination, vector_frames, frameCount);
+	}
+
+	AUDIO_KERNELS_TARGET_AVX2 void avx2_min_max(const float *pSource, int count, float &rMin, float &rMax) {
+
+		__m256 min = _mm256_set1_ps(rMin);
+		__m256 max = _mm256_set1_ps(rMax);
+		int i = 0;
+		for(; i + 8 <= count; i += 8) {
+			const __m256 samples = _mm256_loadu_ps(pSource + i);
+			min = _mm256_min_ps(samples, min);
+			max = _mm256_max_ps(samples, max);
+		}
+		float mins[8], maxs[8];
+		_mm256_storeu_ps(mins, min);
+		_mm256_storeu_ps(maxs, max);
+		for(int k = 0; k < 8; k++) {
+			rMin = qMin(rMin, mins[k]);
+			rMax = qMax(rMax, maxs[k]);
+		}
+		scalar_min_max(pSource + i, count - i, rMin, rMax);
+	}
+
+	const KernelTable avx2_kernels = { AudioKernels::Avx2, avx2_to_float, avx2_from_float, avx2_deinterleave_to_float, avx2_min_max };
+
+	bool cpu_supports_sse2() {
+
+#if defined(__x86_64__) || defined(_M_X64)
+		return true;
+#elif defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 1);
+		return (info[3] & (1 << 26)) != 0;
+#else
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("sse2");
+#endif
+	}
+
+	bool cpu_supports_avx2() {
+
+#if defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 0);
+		if(info[0] < 7) return false;
+		__cpuid(info, 1);
+		const bool os_saves_ymm = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6; // OSXSAVE, AVX, XMM and YMM state
+		if(os_saves_ymm == false) return false;
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#else
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2");
+#endif
+	}
+
+#endif // AUDIO_KERNELS_X86
+
+#ifdef AUDIO_KERNELS_NEON
+
+	void neon_to_float(const unsigned char *pSource, int bytesPerSample, float *pDestination, int count) {
+
+		const float32x4_t scale = vdupq_n_f32(to_float_scale);
+		int i = 0;
+		if(bytesPerSample == 2) {
+			const float32x4_t scale_16 = vdupq_n_f32(1.f / 32768.f);
+			for(; i + 8 <= count; i += 8) {
+				const int16x8_t samples = vld1q_s16((const int16_t*)(pSource + i * 2));
+				vst1q_f32(pDestination + i, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(samples))), scale_16));
+				vst1q_f32(pDestination + i + 4, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(samples))), scale_16));
+			}
+		}
+		else if(bytesPerSample == 3) {
+			for(; i + 8 <= count; i += 8) {
+				// vld3 splits 8 samples into their first, second and third bytes.
+				const uint8x8x3_t bytes = vld3_u8(pSource + i * 3);
+				const uint16x8_t high = vorrq_u16(vshll_n_u8(bytes.val[2], 8), vmovl_u8(bytes.val[1]));
+				const uint16x8_t low = vshll_n_u8(bytes.val[0], 8);
+				const uint32x4_t words_0 = vorrq_u32(vshll_n_u16(vget_low_u16(high), 16), vmovl_u16(vget_low_u16(low)));
+				const uint32x4_t words_1 = vorrq_u32(vshll_n_u16(vget_high_u16(high), 16), vmovl_u16(vget_high_u16(low)));
+				vst1q_f32(pDestination + i, vmulq_f32(vcvtq_f32_s32(vreinterpretq_s32_u32(words_0)), scale));
+				vst1q_f32(pDestination + i + 4, vmulq_f32(vcvtq_f32_s32(vreinterpretq_s32_u32(words_1)), scale));
+			}
+		}
+		else if(bytesPerSample == 4) {
+			for(; i + 4 <= count; i += 4) {
+				vst1q_f32(pDestination + i, vmulq_f32(vcvtq_f32_s32(vld1q_s32((const int32_t*)(pSource + i * 4))), scale));
+			}
+		}
+		scalar_to_float(pSource + i * bytesPerSample, bytesPerSample, pDestination + i, count - i);
+	}
+
+	inline int32x4_t neon_convert(const float *pSource, float32x4_t scale, float32x4_t min, float32x4_t max) {
+
+		// vmaxq_f32() and vminq_f32() keep NaN, vcvtnq_s32_f32() converts it to 0.
+		return vcvtnq_s32_f32(vminq_f32(vmaxq_f32(vmulq_f32(vld1q_f32(pSource), scale), min), max));
+	}
+
+	void neon_from_float(const float *pSource, unsigned char *pDestination, int bytesPerSample, int count) {
+
+		const float32x4_t scale = vdupq_n_f32(full_scale(bytesPerSample));
+		const float32x4_t min = vdupq_n_f32(-full_scale(bytesPerSample));
+		const float32x4_t max = vdupq_n_f32(max_value(bytesPerSample));
+		int i = 0;
+		if(bytesPerSample == 2) {
+			for(; i + 8 <= count; i += 8) {
+				vst1q_s16((int16_t*)(pDestination + i * 2), vcombine_s16(vqmovn_s32(neon_convert(pSource + i, scale, min, max)), vqmovn_s32(neon_convert(pSource + i + 4, scale, min, max))));
+			}
+		}
+		else if(bytesPerSample == 3) {
+			for(; i + 8 <= count; i += 8) {
+				const uint32x4_t words_0 = vreinterpretq_u32_s32(neon_convert(pSource + i, scale, min, max));
+				const uint32x4_t words_1 = vreinterpretq_u32_s32(neon_convert(pSource + i + 4, scale, min, max));
+				uint8x8x3_t bytes;
+				bytes.val[0] = vmovn_u16(vcombine_u16(vmovn_u32(words_0), vmovn_u32(words_1)));
+				bytes.val[1] = vmovn_u16(vcombine_u16(vmovn_u32(vshrq_n_u32(words_0, 8)), vmovn_u32(vshrq_n_u32(words_1, 8))));
+				bytes.val[2] = vmovn_u16(vcombine_u16(vmovn_u32(vshrq_n_u32(words_0, 16)), vmovn_u32(vshrq_n_u32(words_1, 16))));
+				vst3_u8(pDestination + i * 3, bytes);
+			}
+		}
+		else if(bytesPerSample == 4) {
+			for(; i + 4 <= count; i += 4) {
+				vst1q_s32((int32_t*)(pDestination + i * 4), neon_convert(pSource + i, scale, min, max));
+			}
+		}
+		scalar_from_float(pSource + i, pDestination + i * bytesPerSample, bytesPerSample, count - i);
+	}
+
+	void neon_deinterleave_to_float(const unsigned char *pSource, int bytesPerSample, int channelCount, float * const *ppDestination, int frameCount) {
+
+		const float32x4_t scale = vdupq_n_f32(to_float_scale);
+		const int32x4_t shift = vdupq_n_s32(32 - 8 * bytesPerSample);
+		const int stride = channelCount * bytesPerSample;
+		// The 4 byte loads of the last frame would read beyond the buffer.
+		const int vector_frames = qMax(0, frameCount - 1) / 4 * 4;
+		for(int channel = 0; channel < channelCount; channel++) {
+			const unsigned char *p_source = pSource + channel * bytesPerSample;
+			float *p_destination = ppDestination[channel];
+			for(int i = 0; i < vector_frames; i += 4) {
+				const unsigned char *p = p_source + i * stride;
+				const quint32 words[4] = { load_word(p), load_word(p + stride), load_word(p + 2 * stride), load_word(p + 3 * stride) };
+				const int32x4_t samples = vreinterpretq_s32_u32(vshlq_u32(vld1q_u32(words), shift));
+				vst1q_f32(p_destination + i, vmulq_f32(vcvtq_f32_s32(samples), scale));
+			}
+		}
+		scalar_deinterleave_to_float(pSource, bytesPerSample, channelCount, ppDestination, vector_frames, frameCount);
+	}
+
+	void neon_min_max(const float *pSource, int count, float &rMin, float &rMax) {
+
+		float32x4_t min = vdupq_n_f32(rMin);
+		float32x4_t max = vdupq_n_f32(rMax);
+		int i = 0;
+		for(; i + 4 <= count; i += 4) {
+			const float32x4_t samples = vld1q_f32(pSource + i);
+			// Unlike vminq_f32() and vmaxq_f32() these skip NaN samples.
+			min = vminnmq_f32(min, samples);
+			max = vmaxnmq_f32(max, samples);
+		}
+		rMin = vminvq_f32(min);
+		rMax = vmaxvq_f32(max);
+		scalar_min_max(pSource + i, count - i, rMin, rMax);
+	}
+
+	const KernelTable neon_kernels = { AudioKernels::Neon, neon_to_float, neon_from_float, neon_deinterleave_to_float, neon_min_max };
+
+#endif // AUDIO_KERNELS_NEON
+
+	const KernelTable* get_kernels(AudioKernels::eInstructionSet instructionSet) {
+
+		switch(instructionSet) {
+#ifdef AUDIO_KERNELS_X86
+			case AudioKernels::Sse2: return cpu_supports_sse2() ? &sse2_kernels : NULL;
+			case AudioKernels::Avx2: return cpu_supports_avx2() ? &avx2_kernels : NULL;
+#endif
+#ifdef AUDIO_KERNELS_NEON
+			case AudioKernels::Neon: return &neon_kernels;
+#endif
+			case AudioKernels::Scalar: return &scalar_kernels;
+			default: return NULL;
+		}
+	}
+
+	const KernelTable* get_best_kernels() {
+
+		const AudioKernels::eInstructionSet preference[] = { AudioKernels::Avx2, AudioKernels::Neon, AudioKernels::Sse2 };
+		for(unsigned int i = 0; i < sizeof(preference) / sizeof(preference[0]); i++) {
+			const KernelTable *p_kernels = get_kernels(preference[i]);
+			if(p_kernels) return p_kernels;
+		}
+		return &scalar_kernels;
+	}
+
+	QAtomicPointer<const KernelTable>& current_kernels() {
+
+		static QAtomicPointer<const KernelTable> kernels(get_best_kernels());
+		return kernels;
+	}
+
+	inline const KernelTable* kernels() {
+
+		return current_kernels().loadAcquire();
+	}
+
+	// Copies whole words: Every 4 byte store overwrites the surplus byte of the previous one, the last sample of every run is copied byte wise.
+	template<int bytes>
+	void deinterleave(const unsigned char *pSource, int channelCount, unsigned char * const *ppDestination, int frameCount) {
+
+		const int stride = channelCount * bytes;
+		for(int channel = 0; channel < channelCount; channel++) {
+			const unsigned char *p_source = pSource + channel * bytes;
+			unsigned char *p_destination = ppDestination[channel];
+			int i = 0;
+			if(bytes == 3) for(; i + 1 < frameCount; i++) std::memcpy(p_destination + i * 3, p_source + i * stride, 4);
+			for(; i < frameCount; i++) std::memcpy(p_destination + i * bytes, p_source + i * stride, bytes);
+		}
+	}
+
+	template<int bytes>
+	void interleave(const unsigned char * const *ppSource, int channelCount, unsigned char *pDestination, int frameCount) {
+
+		const int stride = channelCount * bytes;
+		for(int i = 0; i < frameCount; i++) {
+			unsigned char *p_destination = pDestination + i * stride;
+			int channel = 0;
+			if(bytes == 3 && i + 1 < frameCount) for(; channel < channelCount; channel++) std::memcpy(p_destination + channel * 3, ppSource[channel] + i * 3, 4);
+			for(; channel < channelCount; channel++) std::memcpy(p_destination + channel * bytes, ppSource[channel] + i * bytes, bytes);
+		}
+	}
+}
+
+AudioKernels::eInstructionSet AudioKernels::GetInstructionSet() {
+
+	return kernels()->instructionSet;
+}
+
+bool AudioKernels::SetInstructionSet(eInstructionSet instructionSet) {
+
+	const KernelTable *p_kernels = get_kernels(instructionSet);
+	if(p_kernels == NULL) return false;
+	current_kernels().storeRelease(p_kernels);
+	return true;
+}
+
+bool AudioKernels::IsSupported(eInstructionSet instructionSet) {
+
+	return get_kernels(instructionSet) != NULL;
+}
+
+QString AudioKernels::GetInstructionSetName(eInstructionSet instructionSet) {
+
+	switch(instructionSet) {
+		case AudioKernels::Scalar: return "Scalar";
+		case AudioKernels::Sse2: return "SSE2";
+		case AudioKernels::Avx2: return "AVX2";
+		case AudioKernels::Neon: return "NEON";
+	}
+	return QString();
+}
+
+void AudioKernels::ToFloat(const unsigned char *pSource, int bytesPerSample, float *pDestination, int count) {
+
+	if(count > 0) kernels()->toFloat(pSource, bytesPerSample, pDestination, count);
+}
+
+void AudioKernels::FromFloat(const float *pSource, unsigned char *pDestination, int bytesPerSample, int count) {
+
+	if(count > 0) kernels()->fromFloat(pSource, pDestination, bytesPerSample, count);
+}
+
+void AudioKernels::Deinterleave(const unsigned char *pSource, int bytesPerSample, int channelCount, unsigned char * const *ppDestination, int frameCount) {
+
+	switch(bytesPerSample) {
+		case 2: deinterleave<2>(pSource, channelCount, ppDestination, frameCount); break;
+		case 3: deinterleave<3>(pSource, channelCount, ppDestination, frameCount); break;
+		case 4: deinterleave<4>(pSource, channelCount, ppDestination, frameCount); break;
+	}
+}
+
+void AudioKernels::Interleave(const unsigned char * const *ppSource, int bytesPerSample, int channelCount, unsigned char *pDestination, int frameCount) {
+
+	switch(bytesPerSample) {
+		case 2: interleave<2>(ppSource, channelCount, pDestination, frameCount); break;
+		case 3: interleave<3>(ppSource, channelCount, pDestination, frameCount); break;
+		case 4: interleave<4>(ppSource, channelCount, pDestination, frameCount); break;
+	}
+}
+
+void AudioKernels::DeinterleaveToFloat(const unsigned char *pSource, int bytesPerSample, int channelCount, float * const *ppDestination, int frameCount) {
+
+	if(frameCount > 0 && channelCount > 0) kernels()->deinterleaveToFloat(pSource, bytesPerSample, channelCount, ppDestination, frameCount);
+}
+
+void AudioKernels::MinMax(const float *pSource, int count, float &rMin, float &rMax) {
+
+	if(count > 0) kernels()->minMax(pSource, count, rMin, rMax);
+}
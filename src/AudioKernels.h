@@ -0,0 +1,55 @@
+/* Copyright(C) 2016 Björn Stresing, Denis Manthey, Wolfgang Ruppel
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <QString>
+
+
+/*! \brief Conversion, (de-)interleaving and peak kernels for little endian integer PCM with 16, 24 or 32 bit per sample.
+Float samples are in the range [-1, 1). The float kernels exist in scalar, SSE2, AVX2 and NEON variants, the best variant supported by the CPU
+is selected at first use. All variants produce identical results, including for NaN. Deinterleave() and Interleave() copy whole machine words and are the same for all
+instruction sets. Thread safe.
+*/
+class AudioKernels {
+
+public:
+	enum eInstructionSet {
+		Scalar = 0,
+		Sse2,
+		Avx2,
+		Neon
+	};
+	//! Returns the instruction set of the kernels in use.
+	static eInstructionSet GetInstructionSet();
+	//! Forces an instruction set, e.g. for benchmarks. Returns false and changes nothing if the CPU doesn't support it.
+	static bool SetInstructionSet(eInstructionSet instructionSet);
+	static bool IsSupported(eInstructionSet instructionSet);
+	static QString GetInstructionSetName(eInstructionSet instructionSet);
+	//! Converts count samples to float.
+	static void ToFloat(const unsigned char *pSource, int bytesPerSample, float *pDestination, int count);
+	//! Converts count float samples to PCM. Rounds to nearest (ties to even) and clips. NaN converts to 0.
+	static void FromFloat(const float *pSource, unsigned char *pDestination, int bytesPerSample, int count);
+	//! Splits frameCount frames of channelCount samples into one array per channel (ppDestination[channel]).
+	static void Deinterleave(const unsigned char *pSource, int bytesPerSample, int channelCount, unsigned char * const *ppDestination, int frameCount);
+	//! Inverse of AudioKernels::Deinterleave().
+	static void Interleave(const unsigned char * const *ppSource, int bytesPerSample, int channelCount, unsigned char *pDestination, int frameCount);
+	//! AudioKernels::Deinterleave() and AudioKernels::ToFloat() in one pass.
+	static void DeinterleaveToFloat(const unsigned char *pSource, int bytesPerSample, int channelCount, float * const *ppDestination, int frameCount);
+	//! Lowers rMin and raises rMax to the extremes of count float samples, NaN samples are skipped. Initialize both before the first call.
+	static void MinMax(const float *pSource, int count, float &rMin, float &rMax);
+
+private:
+	AudioKernels() {}
+};
@@ -0,0 +1,587 @@
+/* Copyright(C) 2016 Björn Stresing, Denis Manthey, Wolfgang Ruppel
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "AudioPlayback.h"
+#include "global.h"
+#include "MxfReaderPool.h"
+#include "AudioKernels.h"
+#include "AS_02.h"
+#include "Metadata.h"
+#include <QAudioOutput>
+#include <QElapsedTimer>
+#include <QSettings>
+#include <QTimer>
+#include <QtEndian>
+#include <QDebug>
+#include <cstring>
+#include <algorithm>
+
+// The decoder reads and mixes blocks of 10 ms.
+#define AUDIO_DECODER_BLOCK_RATE 100
+
+namespace
+{
+	bool starts_before(const AudioPlaybackResource &rLeft, const AudioPlaybackResource &rRight) {
+
+		return rLeft.timelineStart < rRight.timelineStart;
+	}
+}
+
+AudioRingBuffer::AudioRingBuffer(qint64 capacity) :
+mpBuffer(NULL), mCapacity(1), mWritePosition(0), mReadPosition(0), mEndOfStream(0) {
+
+	while(mCapacity < capacity) mCapacity <<= 1;
+	mpBuffer = new char[mCapacity];
+}
+
+AudioRingBuffer::~AudioRingBuffer() {
+
+	delete[] mpBuffer;
+}
+
+qint64 AudioRingBuffer::Write(const char *pData, qint64 size) {
+
+	const quint64 write_position = mWritePosition.loadAcquire();
+	const quint64 read_position = mReadPosition.loadAcquire();
+	const qint64 count = qMin(size, mCapacity - (qint64)(write_position - read_position));
+	if(count <= 0) return 0;
+	const qint64 offset = write_position & (mCapacity - 1);
+	const qint64 first = qMin(count, mCapacity - offset);
+	std::memcpy(mpBuffer + offset, pData, first);
+	std::memcpy(mpBuffer, pData + first, count - first);
+	// Publishes the data to the consumer.
+	mWritePosition.storeRelease(write_position + count);
+	return count;
+}
+
+qint64 AudioRingBuffer::Read(char *pData, qint64 size) {
+
+	const quint64 read_position = mReadPosition.loadAcquire();
+	const quint64 write_position = mWritePosition.loadAcquire();
+	const qint64 count = qMin(size, (qint64)(write_position - read_position));
+	if(count <= 0) return 0;
+	const qint64 offset = read_position & (mCapacity - 1);
+	const qint64 first = qMin(count, mCapacity - offset);
+	std::memcpy(pData, mpBuffer + offset, first);
+	std::memcpy(pData + first, mpBuffer, count - first);
+	// Hands the space back to the producer.
+	mReadPosition.storeRelease(read_position + count);
+	return count;
+}
+
+qint64 AudioRingBuffer::GetReadAvailable() const {
+
+	return (qint64)(mWritePosition.loadAcquire() - mReadPosition.loadAcquire());
+}
+
+void AudioRingBuffer::Reset() {
+
+	mWritePosition.storeRelease(0);
+	mReadPosition.storeRelease(0);
+	mEndOfStream.storeRelease(0);
+}
+
+class AudioDecoder::Reader {
+
+public:
+	Reader() : table(), essence(), block(), reader(), buffer(), filePath(), channelCount(0), bytesPerSample(0), blockSamples(0), currentBlock(-1), isOpen(false), planar(), planarPointers() {}
+	void Close() { if(isOpen && table.isNull()) reader.Close(); table.clear(); isOpen = false; currentBlock = -1; filePath.clear(); }
+	const byte_t* GetBlockData() const { return (table ? reinterpret_cast<const byte_t*>(block.constData()) : buffer.RoData()); }
+	qint64 GetBlockSize() const { return (table ? block.size() : buffer.Size()); }
+
+	// The clip wrapped essence is read through the MxfReaderPool. asdcplib is used if the pool can't index the file or the format is unknown.
+	QSharedPointer<const MxfIndexTable> table;
+	MxfByteRange essence;
+	QByteArray block;
+	AS_02::PCM::MXFReader reader;
+	ASDCP::PCM::FrameBuffer buffer;
+	QString filePath;
+	int channelCount;
+	int bytesPerSample;
+	qint64 blockSamples;
+	qint64 currentBlock;
+	bool isOpen;
+	QVector<float> planar; // Decoded samples, one run per channel.
+	QVector<float*> planarPointers;
+};
+
+AudioDecoder::AudioDecoder(QObject *pParent /*= NULL*/) :
+QThread(pParent), mpBuffer(NULL), mFormat(), mPlaylist(), mRouting(), mStartSample(0), mTargetFill(0), mpReader(NULL), mDecodedSamples(0), mDecodedBytes(0), mDecodeTime(0) {
+
+}
+
+void AudioDecoder::Setup(AudioRingBuffer *pBuffer, const QAudioFormat &rFormat, const QList<AudioPlaybackResource> &rPlaylist, const QVector<Channels> &rRouting, qint64 startSample, qint64 targetFill) {
+
+	mpBuffer = pBuffer;
+	mFormat = rFormat;
+	mPlaylist = rPlaylist;
+	std::sort(mPlaylist.begin(), mPlaylist.end(), starts_before);
+	mRouting = rRouting;
+	mStartSample = startSample;
+	mTargetFill = targetFill;
+	mDecodedSamples.storeRelease(0);
+	mDecodedBytes.storeRelease(0);
+	mDecodeTime.storeRelease(0);
+}
+
+void AudioDecoder::run() {
+
+	if(mpBuffer == NULL) return;
+	Reader reader;
+	mpReader = &reader;
+	const int output_channels = mFormat.channelCount();
+	const qint64 block_samples = mFormat.sampleRate() / AUDIO_DECODER_BLOCK_RATE;
+	const qint64 block_bytes = block_samples * output_channels * sizeof(qint16);
+	QVector<float> mix(block_samples * output_channels);
+	QVector<qint16> output(block_samples * output_channels);
+	qint64 end = 0;
+	for(int i = 0; i < mPlaylist.size(); i++) end = qMax(end, mPlaylist.at(i).GetTimelineEnd());
+	qint64 position = mStartSample;
+	int index = 0;
+	QElapsedTimer timer;
+	while(isInterruptionRequested() == false && position < end) {
+		// Stay at the latency target. The sink drains the buffer in real time.
+		if(mpBuffer->GetReadAvailable() + block_bytes > mTargetFill || mpBuffer->GetWriteAvailable() < block_bytes) {
+			QThread::usleep(500);
+			continue;
+		}
+		timer.start();
+		mix.fill(0);
+		const qint64 count = qMin(block_samples, end - position);
+		qint64 done = 0;
+		while(done < count) {
+			// Resolve the resource at the playhead. Resources may start and end at any sample.
+			const qint64 sample = position + done;
+			while(index < mPlaylist.size() && mPlaylist.at(index).GetTimelineEnd() <= sample) index++;
+			qint64 n = count - done;
+			if(index < mPlaylist.size() && mPlaylist.at(index).timelineStart <= sample) {
+				const AudioPlaybackResource &r_resource = mPlaylist.at(index);
+				const qint64 local_sample = r_resource.entryPoint + (sample - r_resource.timelineStart) % r_resource.sourceDuration;
+				n = qMin(n, qMin(r_resource.GetTimelineEnd() - sample, r_resource.entryPoint + r_resource.sourceDuration - local_sample));
+				Decode(r_resource, local_sample, n, mix.data() + done * output_channels);
+			}
+			else if(index < mPlaylist.size()) {
+				// Gap: silence until the next resource starts.
+				n = qMin(n, mPlaylist.at(index).timelineStart - sample);
+			}
+			done += n;
+		}
+		AudioKernels::FromFloat(mix.constData(), (unsigned char*)output.data(), sizeof(qint16), count * output_channels);
+		mpBuffer->Write((const char*)output.constData(), count * output_channels * sizeof(qint16));
+		position += count;
+		mDecodedSamples.fetchAndAddRelease(count);
+		mDecodeTime.fetchAndAddRelease(timer.nsecsElapsed());
+	}
+	reader.Close();
+	mpReader = NULL;
+	mpBuffer->SetEndOfStream();
+}
+
+bool AudioDecoder::OpenReader(const AudioPlaybackResource &rResource) {
+
+	const QString &rFilePath = rResource.filePath;
+	if(mpReader->isOpen && mpReader->filePath == rFilePath) return true;
+	mpReader->Close();
+	QSharedPointer<const MxfIndexTable> table;
+	if((rResource.quantizationBits == 16 || rResource.quantizationBits == 24) && rResource.channelCount > 0 &&
+		 MxfReaderPool::Instance().GetIndexTable(rFilePath, table).IsError() == false && table->GetElementCount() == 1) {
+		mpReader->table = table;
+		mpReader->essence = table->GetElement(0);
+		mpReader->channelCount = rResource.channelCount;
+		mpReader->bytesPerSample = rResource.quantizationBits / 8;
+		mpReader->blockSamples = mFormat.sampleRate() / AUDIO_DECODER_BLOCK_RATE;
+		mpReader->filePath = rFilePath;
+		mpReader->isOpen = true;
+		return true;
+	}
+	// The reader slices the clip wrapped essence into blocks of AUDIO_DECODER_BLOCK_RATE.
+	ASDCP::Result_t result = mpReader->reader.OpenRead(rFilePath.toStdString(), ASDCP::Rational(AUDIO_DECODER_BLOCK_RATE, 1));
+	if(ASDCP_FAILURE(result)) {
+		qWarning() << "Couldn't open track file for playback:" << rFilePath << result.Label();
+		return false;
+	}
+	ASDCP::MXF::InterchangeObject *p_object = NULL;
+	result = mpReader->reader.OP1aHeader().GetMDObjectByType(ASDCP::DefaultCompositeDict().ul(ASDCP::MDD_WaveAudioDescriptor), &p_object);
+	ASDCP::MXF::WaveAudioDescriptor *p_descriptor = dynamic_cast<ASDCP::MXF::WaveAudioDescriptor*>(p_object);
+	if(ASDCP_FAILURE(result) || p_descriptor == NULL) {
+		qWarning() << "No Wave Audio Descriptor:" << rFilePath;
+		mpReader->reader.Close();
+		return false;
+	}
+	const qint64 sample_rate = p_descriptor->AudioSamplingRate.Numerator / qMax(1, p_descriptor->AudioSamplingRate.Denominator);
+	if(sample_rate != mFormat.sampleRate() || (p_descriptor->QuantizationBits != 16 && p_descriptor->QuantizationBits != 24)) {
+		qWarning() << "Unsupported audio format for playback:" << rFilePath << sample_rate << "Hz" << p_descriptor->QuantizationBits << "bit";
+		mpReader->reader.Close();
+		return false;
+	}
+	mpReader->channelCount = p_descriptor->ChannelCount;
+	mpReader->bytesPerSample = p_descriptor->QuantizationBits / 8;
+	mpReader->blockSamples = sample_rate / AUDIO_DECODER_BLOCK_RATE;
+	mpReader->buffer.Capacity(mpReader->blockSamples * mpReader->channelCount * mpReader->bytesPerSample);
+	mpReader->filePath = rFilePath;
+	mpReader->isOpen = true;
+	return true;
+}
+
+bool AudioDecoder::Decode(const AudioPlaybackResource &rResource, qint64 localSample, qint64 count, float *pMix) {
+
+	if(OpenReader(rResource) == false) return false;
+	const int output_channels = mFormat.channelCount();
+	const int source_channels = mpReader->channelCount;
+	// Output channels each source channel is mixed into.
+	QVector<quint32> targets(source_channels, 0);
+	bool routing_configured = false;
+	for(int i = 0; i < mRouting.size(); i++) if(mRouting.at(i) != 0) routing_configured = true;
+	for(int channel = 0; channel < source_channels; channel++) {
+		if(routing_configured == true) {
+			if(channel >= rResource.soundfieldGroup.GetChannelCount()) continue;
+			const Channels label = rResource.soundfieldGroup.GetChannel(channel);
+			for(int output = 0; output < mRouting.size() && output < output_channels; output++) {
+				if(mRouting.at(output) & label) targets[channel] |= (1u << output);
+			}
+		}
+		// No routing configured: Source channel n is played on output channel n.
+		else if(channel < output_channels) targets[channel] = (1u << channel);
+	}
+	const int frame_size = source_channels * mpReader->bytesPerSample;
+	while(count > 0) {
+		const qint64 block = localSample / mpReader->blockSamples;
+		if(block != mpReader->currentBlock) {
+			if(mpReader->table) {
+				const qint64 block_size = mpReader->blockSamples * frame_size;
+				const qint64 block_offset = block * block_size;
+				Error error;
+				if(block_offset >= mpReader->essence.size) error = Error(Error::UnknownDuration, QString("Block %1 out of range").arg(block));
+				else error = MxfReaderPool::Instance().Read(rResource.filePath, mpReader->essence.offset + block_offset, qMin(block_size, mpReader->essence.size - block_offset), mpReader->block);
+				if(error.IsError()) {
+					qWarning() << "Couldn't read audio block" << block << "of" << rResource.filePath << error;
+					mpReader->currentBlock = -1;
+					return false;
+				}
+			}
+			else {
+				ASDCP::Result_t result = mpReader->reader.ReadFrame(block, mpReader->buffer);
+				if(ASDCP_FAILURE(result)) {
+					qWarning() << "Couldn't read audio block" << block << "of" << rResource.filePath << result.Label();
+					mpReader->currentBlock = -1;
+					return false;
+				}
+			}
+			mpReader->currentBlock = block;
+			mDecodedBytes.fetchAndAddRelease(mpReader->GetBlockSize());
+		}
+		const qint64 offset = localSample - block * mpReader->blockSamples;
+		const qint64 available = mpReader->GetBlockSize() / frame_size - offset;
+		if(available <= 0) return false;
+		const qint64 n = qMin(count, available);
+		const byte_t *p_source = mpReader->GetBlockData() + offset * frame_size;
+		if(mpReader->planar.size() < source_channels * n) mpReader->planar.resize(source_channels * n);
+		mpReader->planarPointers.resize(source_channels);
+		for(int channel = 0; channel < source_channels; channel++) mpReader->planarPointers[channel] = mpReader->planar.data() + channel * n;
+		AudioKernels::DeinterleaveToFloat(p_source, mpReader->bytesPerSample, source_channels, mpReader->planarPointers.constData(), n);
+		for(int channel = 0; channel < source_channels; channel++) {
+			const float *p_channel = mpReader->planarPointers.at(channel);
+			const quint32 target = targets.at(channel);
+			for(int output = 0; target >> output; output++) {
+				if(target & (1u << output)) for(qint64 i = 0; i < n; i++) pMix[i * output_channels + output] += p_channel[i];
+			}
+		}
+		pMix += n * output_channels;
+		localSample += n;
+		count -= n;
+	}
+	return true;
+}
+
+bool AbstractAudioSink::Start(const QAudioFormat &rFormat, AudioRingBuffer *pBuffer) {
+
+	mFormat = rFormat;
+	mpBuffer = pBuffer;
+	mPlayedBytes.storeRelease(0);
+	mUnderruns.storeRelease(0);
+	mUnderrunBytes.storeRelease(0);
+	return mpBuffer != NULL;
+}
+
+qint64 AbstractAudioSink::Pull(char *pData, qint64 size) {
+
+	const qint64 read = (mpBuffer ? mpBuffer->Read(pData, size) : 0);
+	if(read < size) {
+		std::memset(pData + read, 0, size - read);
+		// Draining the end of the playlist isn't an underrun.
+		if(mpBuffer && mpBuffer->IsEndOfStream() == false) {
+			mUnderruns.fetchAndAddRelaxed(1);
+			mUnderrunBytes.fetchAndAddRelaxed(size - read);
+		}
+	}
+	mPlayedBytes.fetchAndAddRelease(read);
+	return read;
+}
+
+AudioOutputSink::AudioOutputSink(const QAudioDeviceInfo &rDevice, qint64 latencyBytes, QObject *pParent /*= NULL*/) :
+QIODevice(pParent), AbstractAudioSink(), mDevice(rDevice), mLatencyBytes(latencyBytes), mpAudioOutput(NULL) {
+
+}
+
+AudioOutputSink::~AudioOutputSink() {
+
+	Stop();
+}
+
+bool AudioOutputSink::Start(const QAudioFormat &rFormat, AudioRingBuffer *pBuffer) {
+
+	if(AbstractAudioSink::Start(rFormat, pBuffer) == false) return false;
+	if(mDevice.isNull() || mDevice.isFormatSupported(rFormat) == false) {
+		qWarning() << "Audio device doesn't support the playback format:" << mDevice.deviceName() << rFormat;
+		return false;
+	}
+	mpAudioOutput = new QAudioOutput(mDevice, rFormat, this);
+	// The device buffer is part of the latency budget. The ring buffer holds the rest.
+	mpAudioOutput->setBufferSize(mLatencyBytes / 2);
+	open(QIODevice::ReadOnly);
+	mpAudioOutput->start(this);
+	if(mpAudioOutput->error() != QAudio::NoError) {
+		qWarning() << "Couldn't start audio output:" << mpAudioOutput->error();
+		Stop();
+		return false;
+	}
+	return true;
+}
+
+void AudioOutputSink::Stop() {
+
+	if(mpAudioOutput) {
+		mpAudioOutput->stop();
+		delete mpAudioOutput;
+		mpAudioOutput = NULL;
+	}
+	if(isOpen()) close();
+}
+
+qint64 AudioOutputSink::GetBufferedBytes() const {
+
+	if(mpAudioOutput) return mpAudioOutput->bufferSize() - mpAudioOutput->bytesFree();
+	return 0;
+}
+
+NullAudioSink::NullAudioSink(const QString &rFilePath /*= QString()*/, bool realtime /*= true*/, QObject *pParent /*= NULL*/) :
+QThread(pParent), AbstractAudioSink(), mFile(rFilePath), mRealtime(realtime) {
+
+}
+
+NullAudioSink::~NullAudioSink() {
+
+	Stop();
+}
+
+bool NullAudioSink::Start(const QAudioFormat &rFormat, AudioRingBuffer *pBuffer) {
+
+	if(AbstractAudioSink::Start(rFormat, pBuffer) == false) return false;
+	if(mFile.fileName().isEmpty() == false) {
+		if(mFile.open(QIODevice::WriteOnly | QIODevice::Truncate) == false) {
+			qWarning() << "Couldn't open audio output file:" << mFile.fileName();
+			return false;
+		}
+		WriteWavHeader(0);
+	}
+	start();
+	return true;
+}
+
+void NullAudioSink::Stop() {
+
+	requestInterruption();
+	wait();
+	if(mFile.isOpen()) {
+		WriteWavHeader(mFile.size() - 44);
+		mFile.close();
+	}
+}
+
+void NullAudioSink::run() {
+
+	// A period of 10 ms like a typical sound card.
+	const qint64 period_bytes = mFormat.sampleRate() / 100 * mFormat.channelCount() * mFormat.sampleSize() / 8;
+	QByteArray period(period_bytes, 0);
+	QElapsedTimer timer;
+	timer.start();
+	qint64 periods = 0;
+	while(isInterruptionRequested() == false) {
+		if(mRealtime == true) {
+			const qint64 due = periods * 10 - timer.elapsed();
+			if(due > 0) QThread::msleep(due);
+			const qint64 read = Pull(period.data(), period_bytes);
+			periods++;
+			if(mFile.isOpen()) mFile.write(period);
+			if(read == 0 && mpBuffer->IsEndOfStream()) break;
+		}
+		else {
+			// Wait for the decoder instead of counting underruns. Measures decode throughput.
+			if(mpBuffer->GetReadAvailable() < period_bytes && mpBuffer->IsEndOfStream() == false) {
+				QThread::usleep(100);
+				continue;
+			}
+			const qint64 read = Pull(period.data(), period_bytes);
+			if(mFile.isOpen() && read > 0) mFile.write(period.constData(), read);
+			if(read == 0 && mpBuffer->IsEndOfStream()) break;
+		}
+	}
+}
+
+void NullAudioSink::WriteWavHeader(qint64 dataSize) {
+
+	const quint16 channels = mFormat.channelCount();
+	const quint32 sample_rate = mFormat.sampleRate();
+	const quint16 block_align = channels * mFormat.sampleSize() / 8;
+	uchar header[44];
+	std::memcpy(header, "RIFF", 4);
+	qToLittleEndian<quint32>(36 + dataSize, header + 4);
+	std::memcpy(header + 8, "WAVEfmt ", 8);
+	qToLittleEndian<quint32>(16, header + 16);
+	qToLittleEndian<quint16>(1, header + 20); // PCM
+	qToLittleEndian<quint16>(channels, header + 22);
+	qToLittleEndian<quint32>(sample_rate, header + 24);
+	qToLittleEndian<quint32>(sample_rate * block_align, header + 28);
+	qToLittleEndian<quint16>(block_align, header + 32);
+	qToLittleEndian<quint16>(mFormat.sampleSize(), header + 34);
+	std::memcpy(header + 36, "data", 4);
+	qToLittleEndian<quint32>(dataSize, header + 40);
+	const qint64 position = mFile.pos();
+	mFile.seek(0);
+	mFile.write((const char*)header, sizeof(header));
+	if(position > 0) mFile.seek(position);
+}
+
+AudioPlaybackEngine::AudioPlaybackEngine(QObject *pParent /*= NULL*/) :
+QObject(pParent), mFormat(), mDeviceName(), mUseNullSink(false), mNullSinkFilePath(), mNullSinkRealtime(true), mLatencyTarget(100), mPlaylist(), mRouting(),
+mpBuffer(NULL), mpDecoder(NULL), mpSink(NULL), mpTimer(NULL), mStartSample(0), mLastStatistics() {
+
+	mFormat.setSampleRate(48000);
+	mFormat.setChannelCount(2);
+	mFormat.setSampleSize(16);
+	mFormat.setCodec("audio/pcm");
+	mFormat.setByteOrder(QAudioFormat::LittleEndian);
+	mFormat.setSampleType(QAudioFormat::SignedInt);
+	mpDecoder = new AudioDecoder(this);
+	mpTimer = new QTimer(this);
+	mpTimer->setInterval(20);
+	connect(mpTimer, SIGNAL(timeout()), this, SLOT(rTimeout()));
+}
+
+AudioPlaybackEngine::~AudioPlaybackEngine() {
+
+	Stop();
+	delete mpBuffer;
+}
+
+void AudioPlaybackEngine::LoadSettings() {
+
+	QSettings settings;
+	mDeviceName = settings.value(SETTINGS_AUDIO_DEVICE, QVariant(QAudioDeviceInfo::defaultOutputDevice().deviceName())).toString();
+	mFormat.setChannelCount(qBound(1, settings.value(SETTINGS_AUDIO_CHANNEL_CONFIGURATION, 2).toInt(), 8));
+	mRouting.clear();
+	for(int i = 0; i < mFormat.channelCount(); i++) {
+		QString key(SETTINGS_AUDIO_SELECTED_CHANNELS_FOR_TARGET_CHANNEL);
+		key.append(QString::number(i));
+		// Bit n equals SoundfieldGroup::eChannel (1 << n).
+		mRouting << settings.value(key, 0x00).toUInt();
+	}
+}
+
+void AudioPlaybackEngine::SetNullSink(const QString &rFilePath /*= QString()*/, bool realtime /*= true*/) {
+
+	mUseNullSink = true;
+	mNullSinkFilePath = rFilePath;
+	mNullSinkRealtime = realtime;
+}
+
+bool AudioPlaybackEngine::Start(qint64 startSample) {
+
+	Stop();
+	const qint64 latency_bytes = (qint64)mFormat.sampleRate() * GetBytesPerSample() * mLatencyTarget / 1000;
+	delete mpBuffer;
+	// The decoder stops filling at the latency target. The headroom keeps Write() from failing.
+	mpBuffer = new AudioRingBuffer(2 * latency_bytes);
+	mStartSample = startSample;
+	mpDecoder->Setup(mpBuffer, mFormat, mPlaylist, mRouting, startSample, latency_bytes);
+	mpDecoder->start(QThread::HighPriority);
+	if(mUseNullSink == true) {
+		mpSink = new NullAudioSink(mNullSinkFilePath, mNullSinkRealtime);
+	}
+	else {
+		QAudioDeviceInfo device = QAudioDeviceInfo::defaultOutputDevice();
+		QList<QAudioDeviceInfo> devices = QAudioDeviceInfo::availableDevices(QAudio::AudioOutput);
+		for(int i = 0; i < devices.size(); i++) {
+			if(devices.at(i).deviceName() == mDeviceName) {
+				device = devices.at(i);
+				break;
+			}
+		}
+		mpSink = new AudioOutputSink(device, latency_bytes);
+	}
+	// Prefill half of the latency target. Otherwise the first sink periods underrun.
+	QElapsedTimer timer;
+	timer.start();
+	while(mpBuffer->GetReadAvailable() < latency_bytes / 2 && mpBuffer->IsEndOfStream() == false && timer.elapsed() < mLatencyTarget) QThread::msleep(1);
+	if(mpSink->Start(mFormat, mpBuffer) == false) {
+		Stop();
+		return false;
+	}
+	mpTimer->start();
+	return true;
+}
+
+void AudioPlaybackEngine::Stop() {
+
+	mpTimer->stop();
+	if(mpSink) {
+		mLastStatistics = GetStatistics();
+		mpSink->Stop();
+		delete mpSink;
+		mpSink = NULL;
+	}
+	mpDecoder->requestInterruption();
+	mpDecoder->wait();
+}
+
+qint64 AudioPlaybackEngine::GetPosition() const {
+
+	if(mpSink == NULL) return mStartSample + mLastStatistics.playedSamples;
+	const qint64 audible_bytes = mpSink->GetPlayedBytes() - mpSink->GetBufferedBytes();
+	return mStartSample + qMax(Q_INT64_C(0), audible_bytes) / GetBytesPerSample();
+}
+
+AudioPlaybackStatistics AudioPlaybackEngine::GetStatistics() const {
+
+	if(mpSink == NULL) return mLastStatistics;
+	AudioPlaybackStatistics statistics;
+	statistics.decodedSamples = mpDecoder->GetDecodedSamples();
+	statistics.decodedBytes = mpDecoder->GetDecodedBytes();
+	statistics.decodeTime = mpDecoder->GetDecodeTime();
+	statistics.playedSamples = mpSink->GetPlayedBytes() / GetBytesPerSample();
+	statistics.underruns = mpSink->GetUnderruns();
+	statistics.underrunSamples = mpSink->GetUnderrunBytes() / GetBytesPerSample();
+	return statistics;
+}
+
+void AudioPlaybackEngine::rTimeout() {
+
+	if(mpSink == NULL) return;
+	emit PositionChanged(GetPosition());
+	if(mpBuffer->IsEndOfStream() && mpBuffer->GetReadAvailable() == 0 && mpSink->GetBufferedBytes() == 0) {
+		Stop();
+		emit Finished();
+	}
+}
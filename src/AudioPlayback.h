@@ -0,0 +1,266 @@
+/* Copyright(C) 2016 Björn Stresing, Denis Manthey, Wolfgang Ruppel
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include "ImfCommon.h"
+#include <QObject>
+#include <QThread>
+#include <QIODevice>
+#include <QAudioFormat>
+#include <QAudioDeviceInfo>
+#include <QAtomicInteger>
+#include <QVector>
+#include <QList>
+#include <QFile>
+
+class QAudioOutput;
+class QTimer;
+
+/*! \brief Lock-free single producer single consumer byte ring buffer.
+Exactly one thread may invoke Write() and exactly one other thread may invoke Read(). Neither call blocks.
+*/
+class AudioRingBuffer {
+
+public:
+	//! capacity is rounded up to the next power of two.
+	AudioRingBuffer(qint64 capacity);
+	~AudioRingBuffer();
+	//! Producer: Writes up to size bytes. Returns the number of bytes written.
+	qint64 Write(const char *pData, qint64 size);
+	//! Consumer: Reads up to size bytes. Returns the number of bytes read.
+	qint64 Read(char *pData, qint64 size);
+	qint64 GetReadAvailable() const;
+	qint64 GetWriteAvailable() const { return mCapacity - GetReadAvailable(); }
+	qint64 GetCapacity() const { return mCapacity; }
+	//! Producer: No more data will be written.
+	void SetEndOfStream() { mEndOfStream.storeRelease(1); }
+	bool IsEndOfStream() const { return mEndOfStream.loadAcquire() != 0; }
+	//! Neither producer nor consumer may be active.
+	void Reset();
+
+private:
+	Q_DISABLE_COPY(AudioRingBuffer);
+	char *mpBuffer;
+	qint64 mCapacity;
+	QAtomicInteger<quint64> mWritePosition; // Only modified by the producer.
+	QAtomicInteger<quint64> mReadPosition; // Only modified by the consumer.
+	QAtomicInt mEndOfStream;
+};
+
+//! A PCM track file resource on the playback timeline. Positions and durations are counted in samples.
+struct AudioPlaybackResource {
+
+	AudioPlaybackResource() : filePath(), timelineStart(0), entryPoint(0), sourceDuration(0), repeatCount(1), soundfieldGroup(), channelCount(0), quantizationBits(0) {}
+	qint64 GetTimelineEnd() const { return timelineStart + sourceDuration * repeatCount; }
+
+	QString filePath;
+	qint64 timelineStart;
+	qint64 entryPoint;
+	qint64 sourceDuration;
+	int repeatCount;
+	SoundfieldGroup soundfieldGroup;
+	// Format of the track file. The essence is read through the MxfReaderPool if known, otherwise the descriptor is read by asdcplib.
+	int channelCount;
+	int quantizationBits;
+};
+
+struct AudioPlaybackStatistics {
+
+	AudioPlaybackStatistics() : decodedSamples(0), decodedBytes(0), decodeTime(0), playedSamples(0), underruns(0), underrunSamples(0) {}
+	//! Decoded samples per second of decode thread time.
+	double GetDecodeThroughput() const { return (decodeTime > 0 ? decodedSamples * 1e9 / decodeTime : 0); }
+
+	qint64 decodedSamples;
+	qint64 decodedBytes; // PCM bytes read from the track files.
+	qint64 decodeTime; // Nanoseconds spent reading and mixing.
+	qint64 playedSamples;
+	qint64 underruns; // Number of sink periods that couldn't be served completely.
+	qint64 underrunSamples; // Samples replaced by silence.
+};
+
+/*! \brief Decode thread of AudioPlaybackEngine.
+Pulls PCM edit units of the resources at the playhead from the AS-02 MXF files, routes the source channels to the output channels and writes 16 bit samples into the ring buffer.
+*/
+class AudioDecoder : public QThread {
+
+	Q_OBJECT
+
+public:
+	AudioDecoder(QObject *pParent = NULL);
+	virtual ~AudioDecoder() {}
+	//! The decoder must not be running.
+	void Setup(AudioRingBuffer *pBuffer, const QAudioFormat &rFormat, const QList<AudioPlaybackResource> &rPlaylist, const QVector<Channels> &rRouting, qint64 startSample, qint64 targetFill);
+	qint64 GetDecodedSamples() const { return mDecodedSamples.loadAcquire(); }
+	qint64 GetDecodedBytes() const { return mDecodedBytes.loadAcquire(); }
+	qint64 GetDecodeTime() const { return mDecodeTime.loadAcquire(); }
+
+protected:
+	virtual void run();
+
+private:
+	Q_DISABLE_COPY(AudioDecoder);
+	//! Mixes count samples of rResource starting at the resource local sample into pMix.
+	bool Decode(const AudioPlaybackResource &rResource, qint64 localSample, qint64 count, float *pMix);
+	bool OpenReader(const AudioPlaybackResource &rResource);
+
+	AudioRingBuffer *mpBuffer;
+	QAudioFormat mFormat;
+	QList<AudioPlaybackResource> mPlaylist;
+	QVector<Channels> mRouting;
+	qint64 mStartSample;
+	qint64 mTargetFill;
+	// Reader state. Only accessed by the decode thread.
+	class Reader;
+	Reader *mpReader;
+	QAtomicInteger<qint64> mDecodedSamples;
+	QAtomicInteger<qint64> mDecodedBytes;
+	QAtomicInteger<qint64> mDecodeTime;
+};
+
+/*! \brief Consumer side of AudioPlaybackEngine.
+Pull() never blocks. Missing samples are replaced by silence and counted as underrun.
+*/
+class AbstractAudioSink {
+
+public:
+	AbstractAudioSink() : mpBuffer(NULL), mFormat(), mPlayedBytes(0), mUnderruns(0), mUnderrunBytes(0) {}
+	virtual ~AbstractAudioSink() {}
+	virtual bool Start(const QAudioFormat &rFormat, AudioRingBuffer *pBuffer);
+	virtual void Stop() = 0;
+	//! Bytes pulled from the ring buffer but not yet audible.
+	virtual qint64 GetBufferedBytes() const { return 0; }
+	qint64 GetPlayedBytes() const { return mPlayedBytes.loadAcquire(); }
+	qint64 GetUnderruns() const { return mUnderruns.loadAcquire(); }
+	qint64 GetUnderrunBytes() const { return mUnderrunBytes.loadAcquire(); }
+
+protected:
+	//! Fills size bytes. Returns the number of bytes taken from the ring buffer.
+	qint64 Pull(char *pData, qint64 size);
+	AudioRingBuffer *mpBuffer;
+	QAudioFormat mFormat;
+
+private:
+	Q_DISABLE_COPY(AbstractAudioSink);
+	QAtomicInteger<qint64> mPlayedBytes;
+	QAtomicInteger<qint64> mUnderruns;
+	QAtomicInteger<qint64> mUnderrunBytes;
+};
+
+//! Plays the ring buffer on an audio device using QAudioOutput in pull mode.
+class AudioOutputSink : public QIODevice, public AbstractAudioSink {
+
+	Q_OBJECT
+
+public:
+	AudioOutputSink(const QAudioDeviceInfo &rDevice, qint64 latencyBytes, QObject *pParent = NULL);
+	virtual ~AudioOutputSink();
+	virtual bool Start(const QAudioFormat &rFormat, AudioRingBuffer *pBuffer);
+	virtual void Stop();
+	virtual qint64 GetBufferedBytes() const;
+	virtual bool isSequential() const { return true; }
+	virtual qint64 bytesAvailable() const { return mpBuffer ? mpBuffer->GetCapacity() + QIODevice::bytesAvailable() : 0; }
+
+protected:
+	virtual qint64 readData(char *pData, qint64 maxSize) { Pull(pData, maxSize); return maxSize; }
+	virtual qint64 writeData(const char *pData, qint64 maxSize) { return -1; }
+
+private:
+	Q_DISABLE_COPY(AudioOutputSink);
+	QAudioDeviceInfo mDevice;
+	qint64 mLatencyBytes;
+	QAudioOutput *mpAudioOutput;
+};
+
+/*! \brief Headless sink. Used without audio hardware (e.g. benchmarks on a CI machine).
+If realtime is true the sink consumes the ring buffer at the sample rate and counts underruns like a sound card. Otherwise the sink consumes as fast as the decoder delivers and measures decode throughput.
+The output is written to a WAV file if rFilePath isn't empty.
+*/
+class NullAudioSink : public QThread, public AbstractAudioSink {
+
+	Q_OBJECT
+
+public:
+	NullAudioSink(const QString &rFilePath = QString(), bool realtime = true, QObject *pParent = NULL);
+	virtual ~NullAudioSink();
+	virtual bool Start(const QAudioFormat &rFormat, AudioRingBuffer *pBuffer);
+	virtual void Stop();
+
+protected:
+	virtual void run();
+
+private:
+	Q_DISABLE_COPY(NullAudioSink);
+	void WriteWavHeader(qint64 dataSize);
+
+	QFile mFile;
+	const bool mRealtime;
+};
+
+/*! \brief Plays the PCM resources of a main audio sequence.
+The decode thread keeps the ring buffer filled up to the latency target. The sink pulls from the ring buffer without locking. Source channels are routed to the output channels by their SoundfieldGroup channel labels (see WidgetAudioSettingsPage).
+*/
+class AudioPlaybackEngine : public QObject {
+
+	Q_OBJECT
+
+public:
+	AudioPlaybackEngine(QObject *pParent = NULL);
+	virtual ~AudioPlaybackEngine();
+	//! Reads audio device, output channel count and channel routing from QSettings.
+	void LoadSettings();
+	//! Uses a NullAudioSink instead of the audio device (see NullAudioSink).
+	void SetNullSink(const QString &rFilePath = QString(), bool realtime = true);
+	void SetPlaylist(const QList<AudioPlaybackResource> &rPlaylist) { mPlaylist = rPlaylist; }
+	//! rRouting[i] contains the source channels (eChannel flags) mixed into output channel i.
+	void SetRouting(const QVector<Channels> &rRouting) { mRouting = rRouting; }
+	void SetOutputChannelCount(int channelCount) { mFormat.setChannelCount(channelCount); }
+	//! Amount of decoded audio buffered ahead of the sink.
+	void SetLatencyTarget(int milliseconds) { mLatencyTarget = milliseconds; }
+	int GetSampleRate() const { return mFormat.sampleRate(); }
+	//! Starts playback at startSample of the playlist timeline. A running playback is stopped first.
+	bool Start(qint64 startSample);
+	void Stop();
+	bool IsPlaying() const { return mpSink != NULL; }
+	//! Returns the playlist sample that is currently audible.
+	qint64 GetPosition() const;
+	AudioPlaybackStatistics GetStatistics() const;
+
+signals:
+	void PositionChanged(qint64 sample);
+	//! Emitted when the end of the playlist was played.
+	void Finished();
+
+	private slots:
+	void rTimeout();
+
+private:
+	Q_DISABLE_COPY(AudioPlaybackEngine);
+	qint64 GetBytesPerSample() const { return mFormat.channelCount() * mFormat.sampleSize() / 8; }
+
+	QAudioFormat mFormat;
+	QString mDeviceName;
+	bool mUseNullSink;
+	QString mNullSinkFilePath;
+	bool mNullSinkRealtime;
+	int mLatencyTarget;
+	QList<AudioPlaybackResource> mPlaylist;
+	QVector<Channels> mRouting;
+	AudioRingBuffer *mpBuffer;
+	AudioDecoder *mpDecoder;
+	AbstractAudioSink *mpSink;
+	QTimer *mpTimer;
+	qint64 mStartSample;
+	AudioPlaybackStatistics mLastStatistics;
+};
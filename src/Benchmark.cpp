@@ -0,0 +1,1341 @@
+/* Copyright(C) 2016 Björn Stresing, Denis Manthey, Wolfgang Ruppel
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "Benchmark.h"
+#include "global.h"
+#include "ImfPackage.h"
+#include "WidgetComposition.h"
+#include "MetadataExtractor.h"
+#include "Jobs.h"
+#include "AudioPlayback.h"
+#include "VideoDecoder.h"
+#include "MxfReaderPool.h"
+#include "XmlValidationService.h"
+#include "EssenceDescriptorTable.h"
+#include "AudioKernels.h"
+#include "ImfPackageCommon.h"
+#include "GraphicScenes.h"
+#include "GraphicsViewScaleable.h"
+#include "GraphicsWidgetResources.h"
+#include "MainWindow.h"
+#include "TimedTextRenderer.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QRegularExpression>
+#include <QJsonDocument>
+#include <QDateTime>
+#include <QSysInfo>
+#include <QThread>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QSharedPointer>
+#include <QSet>
+#include <QPainter>
+#include <QImage>
+#include <QEventLoop>
+#include <QTimer>
+#include <xercesc/dom/DOM.hpp>
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#endif
+
+
+namespace
+{
+	double cpu_time_ms() {
+
+		return 1000. * (double)std::clock() / CLOCKS_PER_SEC;
+	}
+
+	Error to_error(const ImfError &rError) {
+
+		return Error(Error::Unknown, rError.GetErrorMsg().append(": ").append(rError.GetErrorDescription()));
+	}
+
+	double mean(const QList<double> &rValues) {
+
+		double sum = 0;
+		for(int i = 0; i < rValues.size(); i++) sum += rValues.at(i);
+		return rValues.isEmpty() ? 0 : sum / rValues.size();
+	}
+
+	double median(QList<double> values) {
+
+		if(values.isEmpty()) return 0;
+		std::sort(values.begin(), values.end());
+		const int center = values.size() / 2;
+		return (values.size() % 2) ? values.at(center) : (values.at(center - 1) + values.at(center)) / 2.;
+	}
+
+	double stddev(const QList<double> &rValues) {
+
+		if(rValues.size() < 2) return 0;
+		const double average = mean(rValues);
+		double sum = 0;
+		for(int i = 0; i < rValues.size(); i++) sum += (rValues.at(i) - average) * (rValues.at(i) - average);
+		return std::sqrt(sum / (rValues.size() - 1));
+	}
+
+	qint64 count_nodes(const xercesc::DOMNode *pNode) {
+
+		qint64 count = 1;
+		for(const xercesc::DOMNode *p_child = pNode->getFirstChild(); p_child != NULL; p_child = p_child->getNextSibling()) count += count_nodes(p_child);
+		return count;
+	}
+
+	//! Resident set size of the process [KiB]. -1 if unknown.
+	qint64 resident_kib() {
+
+#ifdef Q_OS_LINUX
+		QFile statm("/proc/self/statm");
+		if(statm.open(QIODevice::ReadOnly) == false) return -1;
+		const QList<QByteArray> fields = statm.readAll().split(' ');
+		if(fields.size() < 2) return -1;
+		return fields.at(1).toLongLong() * (sysconf(_SC_PAGESIZE) / 1024);
+#else
+		return -1;
+#endif
+	}
+
+	//! Ingests the synthetic IMP. Assets, asset map and PKL are parsed, MXF metadata is read.
+	class BenchmarkIngest : public AbstractBenchmark {
+
+	public:
+		BenchmarkIngest() : AbstractBenchmark("ImfPackage/Ingest"), mDir() {}
+		virtual Error SetUp(const BenchmarkContext &rContext) { mDir = rContext.impDir; return Error(); }
+		virtual Error Run() {
+
+			QSharedPointer<ImfPackage> imp(new ImfPackage(mDir));
+			ImfError error = imp->Ingest();
+			if(error.IsError()) return to_error(error);
+			SetItemsProcessed(imp->GetAssetCount());
+			return Error();
+		}
+
+	private:
+		QDir mDir;
+	};
+
+	//! Parses the first CPL of the synthetic IMP (WidgetComposition::ParseCpl()).
+	class BenchmarkParseCpl : public AbstractBenchmark {
+
+	public:
+		BenchmarkParseCpl() : AbstractBenchmark("WidgetComposition/ParseCpl"), mImp(), mCplId(), mpComposition(NULL), mSegmentCount(0) {}
+		virtual Error SetUp(const BenchmarkContext &rContext) {
+
+			if(rContext.cplIds.isEmpty()) return Error(Error::SourceFilesMissing, "No CPL");
+			mImp = QSharedPointer<ImfPackage>(new ImfPackage(rContext.impDir));
+			ImfError error = mImp->Ingest();
+			if(error.IsError()) return to_error(error);
+			mCplId = rContext.cplIds.first();
+			mSegmentCount = rContext.parameters.segmentCount;
+			return Error();
+		}
+		virtual void TearDown() { mImp.clear(); }
+		virtual Error BeginIteration() { mpComposition = new WidgetComposition(mImp, mCplId); return Error(); }
+		virtual void EndIteration() { delete mpComposition; mpComposition = NULL; }
+		virtual Error Run() {
+
+			ImfError error = mpComposition->Read();
+			if(error.IsError()) return to_error(error);
+			SetItemsProcessed(mSegmentCount);
+			return Error();
+		}
+
+	private:
+		QSharedPointer<ImfPackage> mImp;
+		QUuid mCplId;
+		WidgetComposition *mpComposition;
+		int mSegmentCount;
+	};
+
+	//! Serializes the first CPL of the synthetic IMP (WidgetComposition::Write()).
+	class BenchmarkWriteCpl : public AbstractBenchmark {
+
+	public:
+		BenchmarkWriteCpl() : AbstractBenchmark("WidgetComposition/Write"), mImp(), mpComposition(NULL), mDestination(), mSegmentCount(0) {}
+		virtual Error SetUp(const BenchmarkContext &rContext) {
+
+			if(rContext.cplIds.isEmpty()) return Error(Error::SourceFilesMissing, "No CPL");
+			mImp = QSharedPointer<ImfPackage>(new ImfPackage(rContext.impDir));
+			ImfError error = mImp->Ingest();
+			if(error.IsError()) return to_error(error);
+			mpComposition = new WidgetComposition(mImp, rContext.cplIds.first());
+			error = mpComposition->Read();
+			if(error.IsError()) return to_error(error);
+			mDestination = rContext.scratchDir.absoluteFilePath("CPL_write.xml");
+			mSegmentCount = rContext.parameters.segmentCount;
+			return Error();
+		}
+		virtual void TearDown() { delete mpComposition; mpComposition = NULL; mImp.clear(); }
+		virtual Error Run() {
+
+			ImfError error = mpComposition->Write(mDestination);
+			if(error.IsError()) return to_error(error);
+			SetBytesProcessed(QFileInfo(mDestination).size());
+			SetItemsProcessed(mSegmentCount);
+			return Error();
+		}
+
+	private:
+		QSharedPointer<ImfPackage> mImp;
+		WidgetComposition *mpComposition;
+		QString mDestination;
+		int mSegmentCount;
+	};
+
+	//! Reads the descriptors of all track files (MetadataExtractor::ReadMetadata()).
+	class BenchmarkReadMetadata : public AbstractBenchmark {
+
+	public:
+		BenchmarkReadMetadata() : AbstractBenchmark("MetadataExtractor/ReadMetadata"), mFiles() {}
+		virtual Error SetUp(const BenchmarkContext &rContext) { mFiles = rContext.trackFiles; return Error(); }
+		virtual Error Run() {
+
+			MetadataExtractor extractor;
+			for(int i = 0; i < mFiles.size(); i++) {
+				Metadata metadata;
+				Error error = extractor.ReadMetadata(metadata, mFiles.at(i));
+				if(error.IsError()) return error;
+			}
+			SetItemsProcessed(mFiles.size());
+			return Error();
+		}
+
+	private:
+		QStringList mFiles;
+	};
+
+	//! Validates Asset Map, PKL and CPLs of the synthetic IMP against their schemas (XmlValidationService). The cached case measures unchanged documents.
+	class BenchmarkValidateXml : public AbstractBenchmark {
+
+	public:
+		BenchmarkValidateXml(bool cached) : AbstractBenchmark(cached ? "XmlValidationService/Validate/Cached" : "XmlValidationService/Validate"), mCached(cached), mFiles() {}
+		virtual Error SetUp(const BenchmarkContext &rContext) {
+
+			QSharedPointer<ImfPackage> imp(new ImfPackage(rContext.impDir));
+			ImfError error = imp->Ingest();
+			if(error.IsError()) return to_error(error);
+			mFiles = imp->GetXmlFiles();
+			XmlValidationCache::Instance().Clear();
+			return Error();
+		}
+		virtual Error BeginIteration() {
+
+			if(mCached == false) XmlValidationCache::Instance().Clear();
+			return Error();
+		}
+		virtual Error Run() {
+
+			XmlValidationService service;
+			service.Validate(mFiles);
+			service.WaitForDone();
+			QList<XmlValidationResult> results = service.GetResults();
+			int invalid_count = 0;
+			for(int i = 0; i < results.size(); i++) {
+				if(results.at(i).error.IsError()) return results.at(i).error;
+				if(results.at(i).IsValid() == false) invalid_count++;
+			}
+			SetItemsProcessed(results.size());
+			SetCounter("invalid_documents", invalid_count);
+			SetCounter("schemas", XmlParserPool::Instance().GetSchemaNamespaces().size());
+			return Error();
+		}
+
+	private:
+		const bool mCached;
+		QStringList mFiles;
+	};
+
+	/*! Loads the RegXML essence descriptors of a synthetic IMP with BenchmarkContext::descriptorTrackCount audio track files (8 distinct descriptors).
+	The interned case shares descriptors through EssenceDescriptorTable, the per asset case keeps one copy per track file (the behavior before EssenceDescriptorTable).
+	The descriptors are held until the iteration ends, like assets hold them.
+	*/
+	class BenchmarkEssenceDescriptors : public AbstractBenchmark {
+
+	public:
+		BenchmarkEssenceDescriptors(bool interned) : AbstractBenchmark(interned ? "EssenceDescriptorTable/Intern" : "EssenceDescriptorTable/PerAsset"), mInterned(interned), mRegXml(), mDescriptors(), mResidentBefore(-1) {}
+		virtual Error SetUp(const BenchmarkContext &rContext) {
+
+			SyntheticImpGenerator generator(rContext.parameters);
+			for(int i = 0; i < rContext.descriptorTrackCount; i++) mRegXml << generator.CreateEssenceDescriptor(i, 8);
+			return Error();
+		}
+		virtual Error BeginIteration() {
+
+			mResidentBefore = resident_kib();
+			return Error();
+		}
+		virtual Error Run() {
+
+			qint64 bytes = 0;
+			for(int i = 0; i < mRegXml.size(); i++) {
+				const QString system_id = QString("descriptor_%1.xml").arg(i);
+				Error error;
+				if(mInterned == true) {
+					EssenceDescriptorTable::Descriptor descriptor = EssenceDescriptorTable::Instance().Intern(mRegXml.at(i), system_id, error);
+					if(error.IsError() == true) return error;
+					mDescriptors << descriptor;
+				}
+				else {
+					xsd::cxx::xml::dom::auto_ptr<xercesc::DOMDocument> document(XmlParserPool::Instance().Parse(mRegXml.at(i), system_id, error));
+					if(error.IsError() == true) return error;
+					cpl::EssenceDescriptorBaseType *p_descriptor = new cpl::EssenceDescriptorBaseType(ImfXmlHelper::Convert(QUuid::createUuid()));
+					p_descriptor->getAny().push_back(*document->getDocumentElement());
+					mDescriptors << EssenceDescriptorTable::Descriptor(p_descriptor);
+				}
+				bytes += mRegXml.at(i).size();
+			}
+			const qint64 resident_after = resident_kib();
+			QSet<const cpl::EssenceDescriptorBaseType*> distinct;
+			qint64 nodes = 0;
+			for(int i = 0; i < mDescriptors.size(); i++) {
+				const cpl::EssenceDescriptorBaseType *p_descriptor = mDescriptors.at(i).data();
+				if(distinct.contains(p_descriptor) == true) continue;
+				distinct.insert(p_descriptor);
+				for(cpl::EssenceDescriptorBaseType::AnySequence::const_iterator it = p_descriptor->getAny().begin(); it != p_descriptor->getAny().end(); ++it) nodes += count_nodes(&(*it));
+			}
+			SetItemsProcessed(mRegXml.size());
+			SetBytesProcessed(bytes);
+			SetCounter("unique_descriptors", distinct.size());
+			SetCounter("retained_dom_nodes", nodes);
+			SetCounter("rss_delta_kib", mResidentBefore >= 0 && resident_after >= 0 ? resident_after - mResidentBefore : -1);
+			return Error();
+		}
+		virtual void EndIteration() {
+
+			mDescriptors.clear();
+		}
+
+	private:
+		const bool mInterned;
+		QList<QByteArray> mRegXml;
+		QList<EssenceDescriptorTable::Descriptor> mDescriptors;
+		qint64 mResidentBefore; // [KiB]
+	};
+
+	/*! Paints a marker resource with BenchmarkContext::markerCount markers (one hour at 24 fps) in an offscreen view of 1920 x 64 px.
+	Every iteration scrolls by a quarter of the view and paints it, like scrolling the timeline. ZoomedOut shows the whole hour (aggregate glyphs),
+	ZoomedIn shows ten seconds (individual markers).
+	*/
+	class BenchmarkPaintMarkers : public AbstractBenchmark {
+
+	public:
+		BenchmarkPaintMarkers(bool zoomedIn) : AbstractBenchmark(zoomedIn ? "GraphicsWidgetMarkerResource/Paint/ZoomedIn" : "GraphicsWidgetMarkerResource/Paint/ZoomedOut"),
+			mZoomedIn(zoomedIn), mDuration(24 * 3600), mpScene(NULL), mpView(NULL), mpResource(NULL), mImage(), mCenter(0) {}
+		virtual Error SetUp(const BenchmarkContext &rContext) {
+
+			const QStringList labels = MarkerLabel::GetMarkerLabels();
+			cpl::MarkerResourceType *p_data = new cpl::MarkerResourceType(ImfXmlHelper::Convert(QUuid::createUuid()), mDuration);
+			cpl::MarkerResourceType::MarkerSequence marker_sequence;
+			for(int i = 0; i < rContext.markerCount; i++) {
+				marker_sequence.push_back(cpl::MarkerType(ImfXmlHelper::Convert(MarkerLabel::GetMarker(labels.at(i % labels.size()))), (qint64)i * mDuration / rContext.markerCount));
+			}
+			p_data->setMarker(marker_sequence);
+			mpScene = new GraphicsSceneBase(EditRate::EditRate24);
+			mpView = new GraphicsViewScaleable;
+			mpView->setScene(mpScene);
+			mpView->resize(1920, 64);
+			mpView->show();
+			mpResource = new GraphicsWidgetMarkerResource(NULL, p_data);
+			mpScene->addItem(mpResource);
+			mpResource->setGeometry(QRectF(0, 0, mDuration, 32));
+			const qreal scale = mZoomedIn ? 1920. / (24 * 10) : 1920. / mDuration; // [px per frame]
+			mpView->ScaleView(scale / mpView->transform().m11());
+			mCenter = mDuration / 2;
+			mpView->centerOn(mCenter, 16);
+			QCoreApplication::processEvents(); // Deferred level of detail update.
+			mImage = QImage(mpView->viewport()->size(), QImage::Format_ARGB32_Premultiplied);
+			return Error();
+		}
+		virtual void TearDown() {
+
+			delete mpView;
+			mpView = NULL;
+			delete mpScene; // Deletes mpResource.
+			mpScene = NULL;
+			mpResource = NULL;
+		}
+		virtual Error Run() {
+
+			const qreal visible_width = mpView->mapToScene(mpView->viewport()->rect()).boundingRect().width();
+			mCenter += visible_width / 4;
+			if(mCenter > mDuration) mCenter = 0;
+			mpView->centerOn(mCenter, 16);
+			QCoreApplication::processEvents();
+			mImage.fill(Qt::black);
+			QPainter painter(&mImage);
+			mpView->render(&painter);
+			painter.end();
+			const QRectF visible_rect = mpResource->mapRectFromScene(mpView->mapToScene(mpView->viewport()->rect()).boundingRect());
+			SetItemsProcessed(1); // frames
+			SetCounter("markers", mpResource->GetMarkerCount());
+			SetCounter("visible_markers", mpResource->GetMarkerCount(visible_rect.left(), visible_rect.right()));
+			SetCounter("materialized_markers", mpResource->GetMaterializedMarkerCount());
+			return Error();
+		}
+
+	private:
+		const qint64 mDuration; // [frames]
+		const bool mZoomedIn;
+		GraphicsSceneBase *mpScene;
+		GraphicsViewScaleable *mpView;
+		GraphicsWidgetMarkerResource *mpResource;
+		QImage mImage;
+		qreal mCenter;
+	};
+
+	//! Calculates the SHA-1 of all track files (JobCalculateHash). Hash checkpoints are neither used nor written.
+	class BenchmarkCalculateHash : public AbstractBenchmark {
+
+	public:
+		BenchmarkCalculateHash() : AbstractBenchmark("JobCalculateHash"), mFiles() {}
+		virtual Error SetUp(const BenchmarkContext &rContext) { mFiles = rContext.trackFiles; return Error(); }
+		virtual Error Run() {
+
+			qint64 bytes = 0;
+			for(int i = 0; i < mFiles.size(); i++) {
+				JobCalculateHash job(mFiles.at(i), false);
+				job.setAutoDelete(false);
+				Error error = job.PerformRun();
+				if(error.IsError()) return error;
+				bytes += QFileInfo(mFiles.at(i)).size();
+			}
+			SetBytesProcessed(bytes);
+			SetItemsProcessed(mFiles.size());
+			return Error();
+		}
+
+	private:
+		QStringList mFiles;
+	};
+
+	/*! Runs one AudioKernels kernel with a forced instruction set on ten seconds of 24 bit 5.1 PCM at 48 kHz. The data stays in memory.
+	bytes_per_second refers to the PCM side, items_per_second to samples.
+	*/
+	class BenchmarkAudioKernel : public AbstractBenchmark {
+
+	public:
+		enum eKernel {
+			ToFloat = 0,
+			FromFloat,
+			DeinterleaveToFloat,
+			Deinterleave,
+			MinMax
+		};
+		BenchmarkAudioKernel(eKernel kernel, AudioKernels::eInstructionSet instructionSet) :
+			AbstractBenchmark(QString("AudioKernels/%1/%2").arg(GetKernelName(kernel)).arg(AudioKernels::GetInstructionSetName(instructionSet))),
+			mKernel(kernel), mInstructionSet(instructionSet), mPreviousInstructionSet(AudioKernels::Scalar), mPcm(), mPlanarPcm(), mFloat(), mFloatPointers(), mPcmPointers() {}
+		virtual Error SetUp(const BenchmarkContext &rContext) {
+
+			mPreviousInstructionSet = AudioKernels::GetInstructionSet();
+			if(AudioKernels::SetInstructionSet(mInstructionSet) == false) return Error(Error::Unknown, "Instruction set not supported");
+			mPcm.resize(frames * channels * 3);
+			for(int i = 0; i < mPcm.size(); i++) mPcm[i] = (char)qrand();
+			mFloat.resize(frames * channels);
+			AudioKernels::ToFloat((const unsigned char*)mPcm.constData(), 3, mFloat.data(), mFloat.size());
+			mPlanarPcm.resize(mPcm.size());
+			for(int channel = 0; channel < channels; channel++) {
+				mFloatPointers.push_back(mFloat.data() + channel * frames);
+				mPcmPointers.push_back((unsigned char*)mPlanarPcm.data() + channel * frames * 3);
+			}
+			return Error();
+		}
+		virtual void TearDown() { AudioKernels::SetInstructionSet(mPreviousInstructionSet); }
+		virtual Error Run() {
+
+			float min = 0, max = 0;
+			switch(mKernel) {
+				case ToFloat: AudioKernels::ToFloat((const unsigned char*)mPcm.constData(), 3, mFloat.data(), mFloat.size()); break;
+				case FromFloat: AudioKernels::FromFloat(mFloat.constData(), (unsigned char*)mPcm.data(), 3, mFloat.size()); break;
+				case DeinterleaveToFloat: AudioKernels::DeinterleaveToFloat((const unsigned char*)mPcm.constData(), 3, channels, mFloatPointers.constData(), frames); break;
+				case Deinterleave: AudioKernels::Deinterleave((const unsigned char*)mPcm.constData(), 3, channels, mPcmPointers.constData(), frames); break;
+				case MinMax: AudioKernels::MinMax(mFloat.constData(), mFloat.size(), min, max); break;
+			}
+			SetBytesProcessed(mKernel == MinMax ? mFloat.size() * sizeof(float) : mPcm.size());
+			SetItemsProcessed(frames * channels);
+			return Error();
+		}
+		static QString GetKernelName(eKernel kernel) {
+
+			switch(kernel) {
+				case ToFloat: return "ToFloat24";
+				case FromFloat: return "FromFloat24";
+				case DeinterleaveToFloat: return "DeinterleaveToFloat24";
+				case Deinterleave: return "Deinterleave24";
+				case MinMax: return "MinMax";
+			}
+			return QString();
+		}
+
+	private:
+		static const int frames = 48000 * 10;
+		static const int channels = 6;
+		const eKernel mKernel;
+		const AudioKernels::eInstructionSet mInstructionSet;
+		AudioKernels::eInstructionSet mPreviousInstructionSet;
+		QByteArray mPcm;
+		QByteArray mPlanarPcm;
+		QVector<float> mFloat;
+		QVector<float*> mFloatPointers;
+		QVector<unsigned char*> mPcmPointers;
+	};
+
+	//! Wraps the first WAV source into an MXF track file (JobWrapWav). With analyzeAudio the fused loudness analysis runs as well (AudioAnalyzer).
+	class BenchmarkWrapWav : public AbstractBenchmark {
+
+	public:
+		BenchmarkWrapWav(bool analyzeAudio = false) : AbstractBenchmark(analyzeAudio ? "JobWrapWav/Analysis" : "JobWrapWav"), mAnalyzeAudio(analyzeAudio), mSource(), mDestination(), mSoundfieldGroup() {}
+		virtual Error SetUp(const BenchmarkContext &rContext) {
+
+			if(rContext.wavFiles.isEmpty()) return Error(Error::SourceFilesMissing, "No WAV source");
+			mSource = rContext.wavFiles.first();
+			mDestination = rContext.scratchDir.absoluteFilePath("wrap_wav.mxf");
+			mSoundfieldGroup = (rContext.parameters.audioChannelCount == 6 ? SoundfieldGroup::SoundFieldGroup51 : SoundfieldGroup::SoundFieldGroupST);
+			return Error();
+		}
+		virtual void TearDown() { QFile::remove(mDestination); }
+		virtual Error Run() {
+
+			JobWrapWav job(QStringList() << mSource, mDestination, mSoundfieldGroup, QUuid::createUuid(), mAnalyzeAudio);
+			job.setAutoDelete(false);
+			Error error = job.PerformRun();
+			if(error.IsError()) return error;
+			SetBytesProcessed(QFileInfo(mSource).size());
+			SetItemsProcessed(1);
+			return Error();
+		}
+
+	private:
+		const bool mAnalyzeAudio;
+		QString mSource;
+		QString mDestination;
+		SoundfieldGroup mSoundfieldGroup;
+	};
+
+	Error find_ttml_sources(const BenchmarkContext &rContext, QStringList &rSources) {
+
+		QDir source_dir(rContext.impDir.absoluteFilePath("sources"));
+		const QStringList sources = source_dir.entryList(QStringList() << "*.ttml", QDir::Files, QDir::Name);
+		if(sources.isEmpty()) return Error(Error::SourceFilesMissing, "No TTML source");
+		rSources.clear();
+		for(int i = 0; i < sources.size(); i++) rSources << source_dir.absoluteFilePath(sources.at(i));
+		return Error();
+	}
+
+	//! Parses the synthetic TTML documents into cue indices (TimedTextDocument).
+	class BenchmarkParseTimedText : public AbstractBenchmark {
+
+	public:
+		BenchmarkParseTimedText() : AbstractBenchmark("TimedTextDocument/Parse"), mSources() {}
+		virtual Error SetUp(const BenchmarkContext &rContext) { return find_ttml_sources(rContext, mSources); }
+		virtual Error Run() {
+
+			qint64 bytes = 0;
+			qint64 cues = 0;
+			for(int i = 0; i < mSources.size(); i++) {
+				TimedTextDocument document;
+				Error error = document.Load(mSources.at(i));
+				if(error.IsError()) return error;
+				bytes += QFileInfo(mSources.at(i)).size();
+				cues += document.GetCueCount();
+			}
+			SetBytesProcessed(bytes);
+			SetItemsProcessed(mSources.size());
+			SetCounter("cues", cues);
+			return Error();
+		}
+
+	private:
+		QStringList mSources;
+	};
+
+	//! Plays a synthetic TTML document at the edit rate of the IMP and fetches the active cues of every frame at 1920x1080 (WidgetVideoPreview overlay).
+	class BenchmarkTimedTextPlayback : public AbstractBenchmark {
+
+	public:
+		BenchmarkTimedTextPlayback() : AbstractBenchmark("TimedTextRenderCache/Playback"), mDocument(), mFrameCount(0), mEditRate() {}
+		virtual Error SetUp(const BenchmarkContext &rContext) {
+
+			QStringList sources;
+			Error error = find_ttml_sources(rContext, sources);
+			if(error.IsError()) return error;
+			mDocument = TimedTextRenderCache::Instance().LoadDocument(sources.first(), error);
+			if(error.IsError()) return error;
+			mEditRate = rContext.parameters.editRate;
+			mFrameCount = qMin((qint64)rContext.parameters.trackDuration * mEditRate.GetNumerator() / mEditRate.GetDenominator(), (qint64)2000);
+			return Error();
+		}
+		virtual void TearDown() { mDocument.clear(); }
+		virtual Error BeginIteration() {
+
+			TimedTextRenderCache::Instance().Clear();
+			return Error();
+		}
+		virtual Error Run() {
+
+			const QSize frame_size(1920, 1080);
+			const TimedTextRenderStatistics before = TimedTextRenderCache::Instance().GetStatistics();
+			QElapsedTimer timer;
+			timer.start();
+			qint64 shown_cues = 0;
+			for(qint64 frame = 0; frame < mFrameCount; frame++) {
+				const qint64 time = (qint64)(frame * 1000. / mEditRate.GetQuotient());
+				const QList<int> cues = mDocument->GetCuesAt(time);
+				for(int i = 0; i < cues.size(); i++) {
+					if(TimedTextRenderCache::Instance().GetCueImage(mDocument, cues.at(i), frame_size).isNull()) return Error(Error::Unknown, QString("Cue %1 wasn't rendered.").arg(cues.at(i)));
+					shown_cues++;
+				}
+			}
+			const double seconds = timer.nsecsElapsed() / 1e9;
+			const TimedTextRenderStatistics after = TimedTextRenderCache::Instance().GetStatistics();
+			const qint64 requests = (after.cacheHits - before.cacheHits) + (after.cacheMisses - before.cacheMisses);
+			SetItemsProcessed(mFrameCount);
+			SetCounter("fps", seconds > 0 ? mFrameCount / seconds : 0);
+			SetCounter("rendered_cues", after.renderedCues - before.renderedCues);
+			SetCounter("cache_hit_ratio", requests > 0 ? (double)(after.cacheHits - before.cacheHits) / requests : 0);
+			SetCounter("render_ms_per_cue", after.renderedCues > before.renderedCues ? (after.renderTime - before.renderTime) / 1e6 / (after.renderedCues - before.renderedCues) : 0);
+			SetCounter("shown_cues", shown_cues);
+			return Error();
+		}
+
+	private:
+		QSharedPointer<const TimedTextDocument> mDocument;
+		qint64 mFrameCount;
+		EditRate mEditRate;
+	};
+
+	//! Wraps a synthetic JPEG 2000 codestream sequence into an MXF track file (JobWrapJ2c). The SHA-1 of the track file is part of the job.
+	class BenchmarkWrapJ2c : public AbstractBenchmark {
+
+	public:
+		BenchmarkWrapJ2c() : AbstractBenchmark("JobWrapJ2c"), mFrames(), mDestination(), mEditRate() {}
+		virtual Error SetUp(const BenchmarkContext &rContext) {
+
+			SyntheticImpGenerator generator(rContext.parameters);
+			Error error = generator.GenerateJ2cSources(rContext.impDir, rContext.j2cFrameCount, mFrames);
+			if(error.IsError()) return error;
+			mDestination = rContext.scratchDir.absoluteFilePath("wrap_j2c.mxf");
+			mEditRate = rContext.parameters.editRate;
+			return Error();
+		}
+		virtual void TearDown() { QFile::remove(mDestination); }
+		virtual Error Run() {
+
+			JobWrapJ2c job(mFrames, mDestination, mEditRate, QUuid::createUuid());
+			job.setAutoDelete(false);
+			Error error = job.PerformRun();
+			if(error.IsError()) return error;
+			const JobTelemetry telemetry = job.GetTelemetry();
+			SetBytesProcessed(telemetry.bytesWritten);
+			SetItemsProcessed(telemetry.framesProcessed);
+			SetCounter("frames_per_second", telemetry.wallTimeMs > 0 ? telemetry.framesProcessed * 1000. / telemetry.wallTimeMs : 0);
+			return Error();
+		}
+
+	private:
+		QStringList mFrames;
+		QString mDestination;
+		EditRate mEditRate;
+	};
+
+#ifdef ARCHIVIST
+	//! Wraps the ACES frame sequence given with --aces-dir (JobWrapAces).
+	class BenchmarkWrapAces : public AbstractBenchmark {
+
+	public:
+		BenchmarkWrapAces() : AbstractBenchmark("JobWrapAces"), mSource(), mDestination(), mEditRate() {}
+		virtual Error SetUp(const BenchmarkContext &rContext) {
+
+			if(rContext.acesDir.isEmpty()) return Error(Error::SourceFilesMissing, "No ACES frame sequence given (--aces-dir)");
+			mSource = rContext.acesDir;
+			mDestination = rContext.scratchDir.absoluteFilePath("wrap_aces.mxf");
+			mEditRate = rContext.parameters.editRate;
+			return Error();
+		}
+		virtual void TearDown() { QFile::remove(mDestination); }
+		virtual Error Run() {
+
+			JobWrapAces job(QStringList() << mSource, mDestination, mEditRate, QUuid::createUuid());
+			job.setAutoDelete(false);
+			Error error = job.PerformRun();
+			if(error.IsError()) return error;
+			const JobTelemetry telemetry = job.GetTelemetry();
+			SetBytesProcessed(telemetry.bytesRead);
+			SetItemsProcessed(telemetry.framesProcessed);
+			SetCounter("frames_per_second", telemetry.wallTimeMs > 0 ? telemetry.framesProcessed * 1000. / telemetry.wallTimeMs : 0);
+			return Error();
+		}
+
+	private:
+		QString mSource;
+		QString mDestination;
+		EditRate mEditRate;
+	};
+#endif // ARCHIVIST
+
+	//! Builds a playlist of all PCM track files played back to back.
+	Error create_audio_playlist(const QStringList &rTrackFiles, int sampleRate, QList<AudioPlaybackResource> &rPlaylist) {
+
+		MetadataExtractor extractor;
+		qint64 timeline_start = 0;
+		for(int i = 0; i < rTrackFiles.size(); i++) {
+			Metadata metadata;
+			Error error = extractor.ReadMetadata(metadata, rTrackFiles.at(i));
+			if(error.IsError()) return error;
+			if(metadata.type != Metadata::Pcm || metadata.editRate.IsValid() == false) continue;
+			AudioPlaybackResource resource;
+			resource.filePath = rTrackFiles.at(i);
+			resource.timelineStart = timeline_start;
+			resource.sourceDuration = metadata.duration.GetCount() * sampleRate * metadata.editRate.GetDenominator() / metadata.editRate.GetNumerator();
+			resource.soundfieldGroup = metadata.soundfieldGroup;
+			if(metadata.editRate.GetNumerator() == sampleRate * metadata.editRate.GetDenominator()) {
+				resource.channelCount = metadata.audioChannelCount;
+				resource.quantizationBits = metadata.audioQuantization;
+			}
+			timeline_start = resource.GetTimelineEnd();
+			rPlaylist << resource;
+		}
+		if(rPlaylist.isEmpty()) return Error(Error::SourceFilesMissing, "No PCM track file");
+		return Error();
+	}
+
+	//! Plays the engine until the end of the playlist. The position timer of the engine needs the event loop.
+	Error play_to_end(AudioPlaybackEngine &rEngine, AudioPlaybackStatistics &rStatistics) {
+
+		if(rEngine.Start(0) == false) return Error(Error::Unknown, "Couldn't start audio playback");
+		while(rEngine.IsPlaying()) {
+			QCoreApplication::processEvents(QEventLoop::AllEvents, 5);
+			QThread::msleep(1);
+		}
+		rStatistics = rEngine.GetStatistics();
+		return Error();
+	}
+
+	//! Decodes and mixes all PCM track files into a free-running NullAudioSink (AudioPlaybackEngine).
+	class BenchmarkAudioDecode : public AbstractBenchmark {
+
+	public:
+		BenchmarkAudioDecode() : AbstractBenchmark("AudioPlaybackEngine/Decode"), mEngine() {}
+		virtual Error SetUp(const BenchmarkContext &rContext) {
+
+			QList<AudioPlaybackResource> playlist;
+			Error error = create_audio_playlist(rContext.trackFiles, mEngine.GetSampleRate(), playlist);
+			if(error.IsError()) return error;
+			mEngine.SetPlaylist(playlist);
+			mEngine.SetNullSink(QString(), false);
+			return Error();
+		}
+		virtual Error Run() {
+
+			AudioPlaybackStatistics statistics;
+			Error error = play_to_end(mEngine, statistics);
+			if(error.IsError()) return error;
+			SetBytesProcessed(statistics.decodedBytes);
+			SetItemsProcessed(statistics.decodedSamples);
+			SetCounter("decode_realtime_factor", statistics.GetDecodeThroughput() / mEngine.GetSampleRate());
+			return Error();
+		}
+
+	private:
+		AudioPlaybackEngine mEngine;
+	};
+
+	//! Plays the first two seconds in real time into a NullAudioSink and reports underruns (AudioPlaybackEngine).
+	class BenchmarkAudioRealtime : public AbstractBenchmark {
+
+	public:
+		BenchmarkAudioRealtime() : AbstractBenchmark("AudioPlaybackEngine/Realtime"), mEngine() {}
+		virtual Error SetUp(const BenchmarkContext &rContext) {
+
+			QList<AudioPlaybackResource> playlist;
+			Error error = create_audio_playlist(rContext.trackFiles, mEngine.GetSampleRate(), playlist);
+			if(error.IsError()) return error;
+			AudioPlaybackResource resource = playlist.first();
+			resource.sourceDuration = qMin(resource.sourceDuration, 2 * (qint64)mEngine.GetSampleRate());
+			mEngine.SetPlaylist(QList<AudioPlaybackResource>() << resource);
+			mEngine.SetNullSink(rContext.scratchDir.absoluteFilePath("playback.wav"), true);
+			return Error();
+		}
+		virtual Error Run() {
+
+			AudioPlaybackStatistics statistics;
+			Error error = play_to_end(mEngine, statistics);
+			if(error.IsError()) return error;
+			SetItemsProcessed(statistics.playedSamples);
+			SetCounter("underruns", statistics.underruns);
+			SetCounter("underrun_samples", statistics.underrunSamples);
+			return Error();
+		}
+
+	private:
+		AudioPlaybackEngine mEngine;
+	};
+
+	//! Indexes all track files without sidecar files (MxfReaderPool).
+	class BenchmarkIndexBuild : public AbstractBenchmark {
+
+	public:
+		BenchmarkIndexBuild() : AbstractBenchmark("MxfReaderPool/Build"), mTrackFiles(), mCacheDir() {}
+		virtual Error SetUp(const BenchmarkContext &rContext) {
+
+			mTrackFiles = rContext.trackFiles;
+			mCacheDir = QDir(rContext.scratchDir.absoluteFilePath("mxfindex"));
+			MxfReaderPool::Instance().SetCacheDir(mCacheDir.absolutePath());
+			return Error();
+		}
+		virtual Error BeginIteration() {
+
+			MxfReaderPool::Instance().Clear();
+			mCacheDir.removeRecursively();
+			return Error();
+		}
+		virtual Error Run() {
+
+			qint64 elements = 0;
+			for(int i = 0; i < mTrackFiles.size(); i++) {
+				QSharedPointer<const MxfIndexTable> table;
+				Error error = MxfReaderPool::Instance().GetIndexTable(mTrackFiles.at(i), table);
+				if(error.IsError()) return error;
+				elements += table->GetElementCount();
+			}
+			SetItemsProcessed(mTrackFiles.size());
+			SetCounter("elements", elements);
+			return Error();
+		}
+
+	private:
+		QStringList mTrackFiles;
+		QDir mCacheDir;
+	};
+
+	//! Loads the index tables of all track files from the sidecar files (MxfReaderPool).
+	class BenchmarkIndexSidecar : public AbstractBenchmark {
+
+	public:
+		BenchmarkIndexSidecar() : AbstractBenchmark("MxfReaderPool/Sidecar"), mTrackFiles() {}
+		virtual Error SetUp(const BenchmarkContext &rContext) {
+
+			mTrackFiles = rContext.trackFiles;
+			MxfReaderPool::Instance().SetCacheDir(rContext.scratchDir.absoluteFilePath("mxfindex"));
+			// Writes the sidecar files.
+			for(int i = 0; i < mTrackFiles.size(); i++) {
+				QSharedPointer<const MxfIndexTable> table;
+				Error error = MxfReaderPool::Instance().GetIndexTable(mTrackFiles.at(i), table);
+				if(error.IsError()) return error;
+			}
+			return Error();
+		}
+		virtual Error BeginIteration() {
+
+			MxfReaderPool::Instance().Clear();
+			return Error();
+		}
+		virtual Error Run() {
+
+			const MxfReaderPoolStatistics before = MxfReaderPool::Instance().GetStatistics();
+			for(int i = 0; i < mTrackFiles.size(); i++) {
+				QSharedPointer<const MxfIndexTable> table;
+				Error error = MxfReaderPool::Instance().GetIndexTable(mTrackFiles.at(i), table);
+				if(error.IsError()) return error;
+			}
+			SetItemsProcessed(mTrackFiles.size());
+			SetCounter("builds", MxfReaderPool::Instance().GetStatistics().builds - before.builds);
+			return Error();
+		}
+
+	private:
+		QStringList mTrackFiles;
+	};
+
+	//! Reads the JPEG 2000 track file given with --video-mxf.
+	Error read_video_metadata(const BenchmarkContext &rContext, Metadata &rMetadata) {
+
+		if(rContext.videoFile.isEmpty()) return Error(Error::SourceFilesMissing, "No JPEG 2000 track file given (--video-mxf)");
+		MetadataExtractor extractor;
+		Error error = extractor.ReadMetadata(rMetadata, rContext.videoFile);
+		if(error.IsError()) return error;
+		if(rMetadata.type != Metadata::Jpeg2000 || rMetadata.duration.GetCount() <= 0) return Error(Error::UnsupportedEssence, rContext.videoFile);
+		return Error();
+	}
+
+	//! Polls the cache of the pipeline. FrameReady() isn't needed, but the queued task signals are delivered by the event loop.
+	Error wait_for_frame(VideoDecodePipeline &rPipeline, qint64 frame) {
+
+		QImage image;
+		QElapsedTimer timer;
+		timer.start();
+		while(rPipeline.Lookup(frame, image) == false) {
+			if(timer.elapsed() > 10000) return Error(Error::VideoDecoding, QString("Frame %1 wasn't decoded within 10 s").arg(frame));
+			QCoreApplication::processEvents(QEventLoop::AllEvents, 1);
+			QThread::usleep(100);
+		}
+		return Error();
+	}
+
+	//! Plays up to 500 frames as fast as possible and reports the sustained frame rate (WidgetVideoPreview decode pipeline).
+	class BenchmarkVideoPlayback : public AbstractBenchmark {
+
+	public:
+		BenchmarkVideoPlayback() : AbstractBenchmark("WidgetVideoPreview/Playback"), mPipeline(), mMetadata(), mFrameCount(0) {}
+		virtual Error SetUp(const BenchmarkContext &rContext) {
+
+			Error error = read_video_metadata(rContext, mMetadata);
+			if(error.IsError()) return error;
+			mFrameCount = qMin(mMetadata.duration.GetCount(), (qint64)500);
+			mPipeline.SetTrackFile(rContext.videoFile, mMetadata.duration.GetCount());
+			mPipeline.SetReduction(rContext.videoReduction);
+			return Error();
+		}
+		virtual Error BeginIteration() {
+
+			mPipeline.Cancel();
+			mPipeline.WaitForDone();
+			mPipeline.ClearCache();
+			return Error();
+		}
+		virtual Error Run() {
+
+			const VideoDecodeStatistics before = mPipeline.GetStatistics();
+			QElapsedTimer timer;
+			timer.start();
+			for(qint64 frame = 0; frame < mFrameCount; frame++) {
+				mPipeline.Request(frame);
+				Error error = wait_for_frame(mPipeline, frame);
+				if(error.IsError()) return error;
+			}
+			const double seconds = timer.nsecsElapsed() / 1e9;
+			const VideoDecodeStatistics after = mPipeline.GetStatistics();
+			const qint64 requests = (after.cacheHits - before.cacheHits) + (after.cacheMisses - before.cacheMisses);
+			SetItemsProcessed(mFrameCount);
+			SetCounter("fps", seconds > 0 ? mFrameCount / seconds : 0);
+			SetCounter("realtime_factor", seconds > 0 ? mFrameCount / seconds / mMetadata.editRate.GetQuotient() : 0);
+			SetCounter("prefetch_hit_ratio", requests > 0 ? (double)(after.cacheHits - before.cacheHits) / requests : 0);
+			return Error();
+		}
+
+	private:
+		VideoDecodePipeline mPipeline;
+		Metadata mMetadata;
+		qint64 mFrameCount;
+	};
+
+	//! Constructs and shows the main window and waits until the first frame was painted (offscreen). Guards the deferred initialization at startup.
+	class BenchmarkFirstPaint : public AbstractBenchmark {
+
+	public:
+		BenchmarkFirstPaint() : AbstractBenchmark("MainWindow/FirstPaint"), mpWindow(NULL) {}
+		virtual Error Run() {
+
+			QElapsedTimer timer;
+			timer.start();
+			mpWindow = new MainWindow;
+			const double construct_ms = timer.nsecsElapsed() / 1e6;
+			QEventLoop loop;
+			QTimer timeout;
+			timeout.setSingleShot(true);
+			QObject::connect(mpWindow, SIGNAL(FirstFramePainted()), &loop, SLOT(quit()));
+			QObject::connect(&timeout, SIGNAL(timeout()), &loop, SLOT(quit()));
+			timeout.start(10000);
+			mpWindow->resize(1920, 1080);
+			mpWindow->show();
+			loop.exec();
+			if(timeout.isActive() == false) return Error(Error::Unknown, "Main window wasn't painted within 10 s.");
+			SetItemsProcessed(1); // frames
+			SetCounter("construct_ms", construct_ms);
+			SetCounter("first_paint_ms", timer.nsecsElapsed() / 1e6);
+			return Error();
+		}
+		virtual void EndIteration() {
+
+			delete mpWindow;
+			mpWindow = NULL;
+		}
+
+	private:
+		MainWindow *mpWindow;
+	};
+
+	//! Seeks to 20 frames spread over the track file and reports the latency until the frame is decoded (WidgetVideoPreview decode pipeline).
+	class BenchmarkVideoSeek : public AbstractBenchmark {
+
+	public:
+		BenchmarkVideoSeek() : AbstractBenchmark("WidgetVideoPreview/Seek"), mPipeline(), mMetadata() {}
+		virtual Error SetUp(const BenchmarkContext &rContext) {
+
+			Error error = read_video_metadata(rContext, mMetadata);
+			if(error.IsError()) return error;
+			mPipeline.SetTrackFile(rContext.videoFile, mMetadata.duration.GetCount());
+			mPipeline.SetReduction(rContext.videoReduction);
+			return Error();
+		}
+		virtual Error BeginIteration() {
+
+			mPipeline.Cancel();
+			mPipeline.WaitForDone();
+			mPipeline.ClearCache();
+			return Error();
+		}
+		virtual Error Run() {
+
+			const int seek_count = 20;
+			const qint64 duration = mMetadata.duration.GetCount();
+			QList<double> latencies;
+			for(int i = 0; i < seek_count; i++) {
+				// Alternates between the first and the second half so every request is a seek.
+				const qint64 frame = ((i % 2) * duration / 2 + (qint64)i * 7919) % duration;
+				QElapsedTimer timer;
+				timer.start();
+				mPipeline.Request(frame);
+				Error error = wait_for_frame(mPipeline, frame);
+				if(error.IsError()) return error;
+				latencies << timer.nsecsElapsed() / 1e6;
+			}
+			SetItemsProcessed(seek_count);
+			SetCounter("seek_latency_mean_ms", mean(latencies));
+			SetCounter("seek_latency_median_ms", median(latencies));
+			SetCounter("seek_latency_max_ms", *std::max_element(latencies.begin(), latencies.end()));
+			return Error();
+		}
+
+	private:
+		VideoDecodePipeline mPipeline;
+		Metadata mMetadata;
+	};
+}
+
+BenchmarkRunner::BenchmarkRunner(QObject *pParent /*= NULL*/) :
+QObject(pParent), mBenchmarks() {
+
+}
+
+BenchmarkRunner::~BenchmarkRunner() {
+
+	qDeleteAll(mBenchmarks);
+}
+
+void BenchmarkRunner::AddBenchmark(AbstractBenchmark *pBenchmark) {
+
+	if(pBenchmark) mBenchmarks << pBenchmark;
+}
+
+void BenchmarkRunner::AddDefaultBenchmarks() {
+
+	AddBenchmark(new BenchmarkIngest);
+	AddBenchmark(new BenchmarkParseCpl);
+	AddBenchmark(new BenchmarkWriteCpl);
+	AddBenchmark(new BenchmarkReadMetadata);
+	AddBenchmark(new BenchmarkValidateXml(false));
+	AddBenchmark(new BenchmarkValidateXml(true));
+	AddBenchmark(new BenchmarkEssenceDescriptors(true));
+	AddBenchmark(new BenchmarkEssenceDescriptors(false));
+	AddBenchmark(new BenchmarkPaintMarkers(false));
+	AddBenchmark(new BenchmarkPaintMarkers(true));
+	AddBenchmark(new BenchmarkCalculateHash);
+	AddBenchmark(new BenchmarkWrapWav);
+	AddBenchmark(new BenchmarkWrapWav(true));
+	const AudioKernels::eInstructionSet instruction_sets[] = { AudioKernels::Scalar, AudioKernels::Sse2, AudioKernels::Avx2, AudioKernels::Neon };
+	for(unsigned int i = 0; i < sizeof(instruction_sets) / sizeof(instruction_sets[0]); i++) {
+		if(AudioKernels::IsSupported(instruction_sets[i]) == false) continue;
+		AddBenchmark(new BenchmarkAudioKernel(BenchmarkAudioKernel::ToFloat, instruction_sets[i]));
+		AddBenchmark(new BenchmarkAudioKernel(BenchmarkAudioKernel::FromFloat, instruction_sets[i]));
+		AddBenchmark(new BenchmarkAudioKernel(BenchmarkAudioKernel::DeinterleaveToFloat, instruction_sets[i]));
+		AddBenchmark(new BenchmarkAudioKernel(BenchmarkAudioKernel::MinMax, instruction_sets[i]));
+	}
+	// Deinterleave() is the same for all instruction sets.
+	AddBenchmark(new BenchmarkAudioKernel(BenchmarkAudioKernel::Deinterleave, AudioKernels::GetInstructionSet()));
+	AddBenchmark(new BenchmarkParseTimedText);
+	AddBenchmark(new BenchmarkTimedTextPlayback);
+	AddBenchmark(new BenchmarkWrapJ2c);
+#ifdef ARCHIVIST
+	AddBenchmark(new BenchmarkWrapAces);
+#endif
+	AddBenchmark(new BenchmarkAudioDecode);
+	AddBenchmark(new BenchmarkAudioRealtime);
+	AddBenchmark(new BenchmarkIndexBuild);
+	AddBenchmark(new BenchmarkIndexSidecar);
+	AddBenchmark(new BenchmarkVideoPlayback);
+	AddBenchmark(new BenchmarkVideoSeek);
+	AddBenchmark(new BenchmarkFirstPaint);
+}
+
+int BenchmarkRunner::Execute(const QStringList &rArguments) {
+
+	SyntheticImpGenerator::Parameters parameters;
+	QCommandLineParser parser;
+	parser.setApplicationDescription(tr("Runs the IMF Tool benchmarks against a synthetic IMP."));
+	parser.addHelpOption();
+	QCommandLineOption filter_option("benchmark-filter", tr("Only run benchmarks whose name matches <regex>."), "regex", ".*");
+	QCommandLineOption out_option("benchmark-out", tr("Write the JSON report to <file> instead of stdout."), "file");
+	QCommandLineOption iterations_option("benchmark-iterations", tr("Timed iterations per benchmark."), "n", "3");
+	QCommandLineOption list_option("benchmark-list", tr("List the benchmark names and exit."));
+	QCommandLineOption dir_option("benchmark-dir", tr("Directory for the synthetic IMP and scratch files."), "dir", QDir::temp().absoluteFilePath("imftool-bench"));
+	QCommandLineOption generate_option("generate-imp", tr("Only generate the synthetic IMP into <dir> and exit."), "dir");
+	QCommandLineOption pcm_option("pcm-tracks", tr("Number of PCM track files."), "n", QString::number(parameters.pcmTrackCount));
+	QCommandLineOption ttml_option("ttml-tracks", tr("Number of timed text track files."), "n", QString::number(parameters.timedTextTrackCount));
+	QCommandLineOption cpl_option("cpls", tr("Number of CPLs."), "n", QString::number(parameters.cplCount));
+	QCommandLineOption segment_option("segments", tr("Segments per CPL."), "n", QString::number(parameters.segmentCount));
+	QCommandLineOption resource_option("resources", tr("Resources per sequence and segment."), "n", QString::number(parameters.resourcesPerSequence));
+	QCommandLineOption frames_option("frames-per-resource", tr("Duration of a resource in CPL edit units."), "n", QString::number(parameters.framesPerResource));
+	QCommandLineOption marker_option("markers", tr("Markers per segment."), "n", QString::number(parameters.markersPerSegment));
+	QCommandLineOption duration_option("duration", tr("Track file duration in seconds."), "s", QString::number(parameters.trackDuration));
+	QCommandLineOption channel_option("channels", tr("Audio channels (2 or 6)."), "n", QString::number(parameters.audioChannelCount));
+	QCommandLineOption video_option("video-mxf", tr("JPEG 2000 track file for the WidgetVideoPreview benchmarks."), "file");
+	QCommandLineOption reduction_option("video-reduction", tr("Discarded DWT levels when decoding <file>."), "n", "1");
+	QCommandLineOption j2c_option("j2c-frames", tr("Length of the synthetic JPEG 2000 codestream sequence for the JobWrapJ2c benchmark."), "n", "240");
+	QCommandLineOption aces_option("aces-dir", tr("ACES frame sequence (directory of OpenEXR files) for the JobWrapAces benchmark."), "dir");
+	QCommandLineOption descriptor_option("descriptor-tracks", tr("Number of audio track files for the EssenceDescriptorTable benchmarks."), "n", "1000");
+	QCommandLineOption paint_marker_option("paint-markers", tr("Number of markers for the GraphicsWidgetMarkerResource paint benchmarks."), "n", "50000");
+	QCommandLineOption seed_option("seed", tr("Seed for Ids and essence."), "n", QString::number(parameters.seed));
+	parser.addOption(filter_option);
+	parser.addOption(out_option);
+	parser.addOption(iterations_option);
+	parser.addOption(list_option);
+	parser.addOption(dir_option);
+	parser.addOption(generate_option);
+	parser.addOption(pcm_option);
+	parser.addOption(ttml_option);
+	parser.addOption(cpl_option);
+	parser.addOption(segment_option);
+	parser.addOption(resource_option);
+	parser.addOption(frames_option);
+	parser.addOption(marker_option);
+	parser.addOption(duration_option);
+	parser.addOption(channel_option);
+	parser.addOption(video_option);
+	parser.addOption(reduction_option);
+	parser.addOption(aces_option);
+	parser.addOption(j2c_option);
+	parser.addOption(descriptor_option);
+	parser.addOption(paint_marker_option);
+	parser.addOption(seed_option);
+	parser.process(rArguments);
+
+	QTextStream err(stderr);
+	if(parser.isSet(list_option)) {
+		QTextStream out(stdout);
+		for(int i = 0; i < mBenchmarks.size(); i++) out << mBenchmarks.at(i)->GetName() << "\n";
+		return 0;
+	}
+	parameters.pcmTrackCount = parser.value(pcm_option).toInt();
+	parameters.timedTextTrackCount = parser.value(ttml_option).toInt();
+	parameters.cplCount = parser.value(cpl_option).toInt();
+	parameters.segmentCount = parser.value(segment_option).toInt();
+	parameters.resourcesPerSequence = parser.value(resource_option).toInt();
+	parameters.framesPerResource = parser.value(frames_option).toInt();
+	parameters.markersPerSegment = parser.value(marker_option).toInt();
+	parameters.trackDuration = parser.value(duration_option).toInt();
+	parameters.audioChannelCount = parser.value(channel_option).toInt() == 6 ? 6 : 2;
+	parameters.seed = parser.value(seed_option).toUInt();
+	const int iterations = qMax(1, parser.value(iterations_option).toInt());
+	const QRegularExpression filter(parser.value(filter_option));
+	if(filter.isValid() == false) {
+		err << "Invalid benchmark filter: " << filter.errorString() << "\n";
+		return 1;
+	}
+
+	BenchmarkContext context;
+	context.parameters = parameters;
+	context.videoFile = parser.value(video_option);
+	context.videoReduction = qMax(0, parser.value(reduction_option).toInt());
+	context.acesDir = parser.value(aces_option);
+	context.j2cFrameCount = qMax(1, parser.value(j2c_option).toInt());
+	context.descriptorTrackCount = qMax(1, parser.value(descriptor_option).toInt());
+	context.markerCount = qMax(1, parser.value(paint_marker_option).toInt());
+	QDir root_dir(parser.isSet(generate_option) ? parser.value(generate_option) : parser.value(dir_option));
+	if(parser.isSet(generate_option) == false) {
+		root_dir.mkpath("imp");
+		root_dir.mkpath("scratch");
+		context.impDir = QDir(root_dir.absoluteFilePath("imp"));
+		context.scratchDir = QDir(root_dir.absoluteFilePath("scratch"));
+	}
+	else context.impDir = root_dir;
+
+	SyntheticImpGenerator generator(parameters);
+	QElapsedTimer generation_timer;
+	generation_timer.start();
+	Error error = generator.Generate(context.impDir);
+	if(error.IsError()) {
+		err << "Couldn't generate synthetic IMP: " << error.GetErrorMsg() << " " << error.GetErrorDescription() << "\n";
+		return 1;
+	}
+	err << "Generated synthetic IMP in " << context.impDir.absolutePath() << " (" << generation_timer.elapsed() << " ms)\n";
+	if(parser.isSet(generate_option)) return 0;
+	context.cplIds = generator.GetCplIds();
+	context.wavFiles = generator.GetWavFiles();
+	context.trackFiles = generator.GetTrackFiles();
+
+	int ret = 0;
+	QJsonArray benchmarks;
+	for(int i = 0; i < mBenchmarks.size(); i++) {
+		AbstractBenchmark *p_benchmark = mBenchmarks.at(i);
+		if(filter.match(p_benchmark->GetName()).hasMatch() == false) continue;
+		err << "Running " << p_benchmark->GetName() << "\n";
+		err.flush();
+		Result result;
+		error = RunBenchmark(p_benchmark, context, iterations, result);
+		if(error.IsError()) {
+			QJsonObject entry;
+			entry.insert("name", p_benchmark->GetName());
+			entry.insert("run_name", p_benchmark->GetName());
+			entry.insert("run_type", QString("iteration"));
+			entry.insert("error_occurred", true);
+			entry.insert("error_message", QString("%1 %2").arg(error.GetErrorMsg()).arg(error.GetErrorDescription()));
+			benchmarks.append(entry);
+			err << "  failed: " << error.GetErrorMsg() << " " << error.GetErrorDescription() << "\n";
+			ret = 1;
+			continue;
+		}
+		AppendResult(benchmarks, p_benchmark->GetName(), result);
+	}
+
+	QJsonObject report;
+	report.insert("context", CreateContext(context));
+	report.insert("benchmarks", benchmarks);
+	const QByteArray json = QJsonDocument(report).toJson(QJsonDocument::Indented);
+	if(parser.isSet(out_option)) {
+		QFile out_file(parser.value(out_option));
+		if(out_file.open(QIODevice::WriteOnly | QIODevice::Truncate) == false || out_file.write(json) != json.size()) {
+			err << "Couldn't write benchmark report: " << out_file.fileName() << "\n";
+			return 1;
+		}
+	}
+	else {
+		QFile out_file;
+		out_file.open(stdout, QIODevice::WriteOnly);
+		out_file.write(json);
+	}
+	return ret;
+}
+
+Error BenchmarkRunner::RunBenchmark(AbstractBenchmark *pBenchmark, const BenchmarkContext &rContext, int iterations, Result &rResult) {
+
+	Error error = pBenchmark->SetUp(rContext);
+	if(error.IsError()) {
+		pBenchmark->TearDown();
+		return error;
+	}
+	QElapsedTimer timer;
+	for(int i = 0; i < iterations && error.IsError() == false; i++) {
+		error = pBenchmark->BeginIteration();
+		if(error.IsError()) break;
+		const double cpu_start = cpu_time_ms();
+		timer.start();
+		error = pBenchmark->Run();
+		const double real_time = timer.nsecsElapsed() / 1e6;
+		const double cpu_time = cpu_time_ms() - cpu_start;
+		pBenchmark->EndIteration();
+		// Deliver events posted during the iteration (e.g. deferred deletes) outside of the measurement.
+		QCoreApplication::processEvents();
+		if(error.IsError()) break;
+		rResult.iterations++;
+		rResult.realTimes << real_time;
+		rResult.cpuTimes << cpu_time;
+		rResult.bytesProcessed = pBenchmark->GetBytesProcessed();
+		rResult.itemsProcessed = pBenchmark->GetItemsProcessed();
+		rResult.counters << pBenchmark->GetCounters();
+	}
+	pBenchmark->TearDown();
+	return error;
+}
+
+QJsonObject BenchmarkRunner::CreateContext(const BenchmarkContext &rContext) const {
+
+	QJsonObject context;
+	context.insert("date", QDateTime::currentDateTime().toString(Qt::ISODate));
+	context.insert("host_name", QSysInfo::machineHostName());
+	context.insert("executable", QCoreApplication::applicationFilePath());
+	context.insert("num_cpus", QThread::idealThreadCount());
+	context.insert("kernel", QString("%1 %2").arg(QSysInfo::kernelType()).arg(QSysInfo::kernelVersion()));
+	context.insert("imftool_version", QString(CREATOR_STRING));
+#ifdef NDEBUG
+	context.insert("library_build_type", QString("release"));
+#else
+	context.insert("library_build_type", QString("debug"));
+#endif
+	QJsonObject synthetic;
+	synthetic.insert("pcm_tracks", rContext.parameters.pcmTrackCount);
+	synthetic.insert("ttml_tracks", rContext.parameters.timedTextTrackCount);
+	synthetic.insert("cpls", rContext.parameters.cplCount);
+	synthetic.insert("segments", rContext.parameters.segmentCount);
+	synthetic.insert("resources_per_sequence", rContext.parameters.resourcesPerSequence);
+	synthetic.insert("frames_per_resource", rContext.parameters.framesPerResource);
+	synthetic.insert("markers_per_segment", rContext.parameters.markersPerSegment);
+	synthetic.insert("track_duration_s", rContext.parameters.trackDuration);
+	synthetic.insert("audio_channels", rContext.parameters.audioChannelCount);
+	synthetic.insert("seed", (qint64)rContext.parameters.seed);
+	context.insert("synthetic_imp", synthetic);
+	if(rContext.videoFile.isEmpty() == false) {
+		context.insert("video_file", rContext.videoFile);
+		context.insert("video_reduction", rContext.videoReduction);
+	}
+	if(rContext.acesDir.isEmpty() == false) context.insert("aces_dir", rContext.acesDir);
+	return context;
+}
+
+void BenchmarkRunner::AppendResult(QJsonArray &rBenchmarks, const QString &rName, const Result &rResult) const {
+
+	for(int i = 0; i < rResult.iterations; i++) {
+		QJsonObject entry;
+		entry.insert("name", rName);
+		entry.insert("run_name", rName);
+		entry.insert("run_type", QString("iteration"));
+		entry.insert("repetition_index", i);
+		entry.insert("iterations", 1);
+		entry.insert("real_time", rResult.realTimes.at(i));
+		entry.insert("cpu_time", rResult.cpuTimes.at(i));
+		entry.insert("time_unit", QString("ms"));
+		if(rResult.bytesProcessed > 0 && rResult.realTimes.at(i) > 0) entry.insert("bytes_per_second", rResult.bytesProcessed * 1000. / rResult.realTimes.at(i));
+		if(rResult.itemsProcessed > 0 && rResult.realTimes.at(i) > 0) entry.insert("items_per_second", rResult.itemsProcessed * 1000. / rResult.realTimes.at(i));
+		QMapIterator<QString, double> iter(rResult.counters.at(i));
+		while(iter.hasNext()) {
+			iter.next();
+			entry.insert(iter.key(), iter.value());
+		}
+		rBenchmarks.append(entry);
+	}
+	const char *aggregates[] = {"mean", "median", "stddev"};
+	for(int i = 0; i < 3; i++) {
+		double real_time = 0, cpu_time = 0;
+		if(i == 0) { real_time = mean(rResult.realTimes); cpu_time = mean(rResult.cpuTimes); }
+		else if(i == 1) { real_time = median(rResult.realTimes); cpu_time = median(rResult.cpuTimes); }
+		else { real_time = stddev(rResult.realTimes); cpu_time = stddev(rResult.cpuTimes); }
+		QJsonObject entry;
+		entry.insert("name", QString("%1_%2").arg(rName).arg(aggregates[i]));
+		entry.insert("run_name", rName);
+		entry.insert("run_type", QString("aggregate"));
+		entry.insert("aggregate_name", QString(aggregates[i]));
+		entry.insert("iterations", rResult.iterations);
+		entry.insert("real_time", real_time);
+		entry.insert("cpu_time", cpu_time);
+		entry.insert("time_unit", QString("ms"));
+		if(i != 2 && rResult.bytesProcessed > 0 && real_time > 0) entry.insert("bytes_per_second", rResult.bytesProcessed * 1000. / real_time);
+		if(i != 2 && rResult.itemsProcessed > 0 && real_time > 0) entry.insert("items_per_second", rResult.itemsProcessed * 1000. / real_time);
+		const QStringList counter_names = (rResult.counters.isEmpty() ? QStringList() : rResult.counters.first().keys());
+		for(int ii = 0; ii < counter_names.size(); ii++) {
+			QList<double> values;
+			for(int iii = 0; iii < rResult.counters.size(); iii++) values << rResult.counters.at(iii).value(counter_names.at(ii));
+			if(i == 0) entry.insert(counter_names.at(ii), mean(values));
+			else if(i == 1) entry.insert(counter_names.at(ii), median(values));
+			else entry.insert(counter_names.at(ii), stddev(values));
+		}
+		rBenchmarks.append(entry);
+	}
+}
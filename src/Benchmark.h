@@ -0,0 +1,112 @@
+/* Copyright(C) 2016 Björn Stresing, Denis Manthey, Wolfgang Ruppel
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include "Error.h"
+#include "SyntheticImpGenerator.h"
+#include <QObject>
+#include <QDir>
+#include <QList>
+#include <QStringList>
+#include <QMap>
+#include <QJsonObject>
+#include <QJsonArray>
+
+
+//! Everything a benchmark may use. The synthetic IMP is generated once per run.
+struct BenchmarkContext {
+	QDir impDir;
+	QDir scratchDir; // Benchmarks may write here.
+	SyntheticImpGenerator::Parameters parameters;
+	QList<QUuid> cplIds;
+	QStringList wavFiles;
+	QStringList trackFiles;
+	QString videoFile; // JPEG 2000 track file given on the command line. The synthetic IMP has no video.
+	int videoReduction;
+	QString acesDir; // ACES frame sequence given on the command line.
+	int j2cFrameCount; // Length of the synthetic JPEG 2000 codestream sequence.
+	int descriptorTrackCount; // Number of track files for the EssenceDescriptorTable benchmarks.
+	int markerCount; // Number of markers for the GraphicsWidgetMarkerResource paint benchmarks.
+};
+
+/*! \brief A single benchmark case.
+AbstractBenchmark::SetUp() and AbstractBenchmark::TearDown() are invoked once, AbstractBenchmark::BeginIteration() and AbstractBenchmark::EndIteration() around every iteration.
+Only AbstractBenchmark::Run() is timed.
+*/
+class AbstractBenchmark {
+
+public:
+	AbstractBenchmark(const QString &rName) : mName(rName), mBytesProcessed(0), mItemsProcessed(0), mCounters() {}
+	virtual ~AbstractBenchmark() {}
+	QString GetName() const { return mName; }
+	virtual Error SetUp(const BenchmarkContext &rContext) { return Error(); }
+	virtual void TearDown() {}
+	virtual Error BeginIteration() { return Error(); }
+	virtual void EndIteration() {}
+	virtual Error Run() = 0;
+	//! Bytes processed by the last iteration. Used for bytes_per_second.
+	qint64 GetBytesProcessed() const { return mBytesProcessed; }
+	//! Items processed by the last iteration. Used for items_per_second.
+	qint64 GetItemsProcessed() const { return mItemsProcessed; }
+	//! Counters of the last iteration. Reported like Google Benchmark user counters.
+	QMap<QString, double> GetCounters() const { return mCounters; }
+
+protected:
+	void SetBytesProcessed(qint64 bytes) { mBytesProcessed = bytes; }
+	void SetItemsProcessed(qint64 items) { mItemsProcessed = items; }
+	void SetCounter(const QString &rName, double value) { mCounters.insert(rName, value); }
+
+private:
+	Q_DISABLE_COPY(AbstractBenchmark);
+	const QString mName;
+	qint64 mBytesProcessed;
+	qint64 mItemsProcessed;
+	QMap<QString, double> mCounters;
+};
+
+/*! \brief Runs the benchmark cases against a synthetic IMP and writes a JSON report.
+The report follows the Google Benchmark JSON layout ("context" and "benchmarks") so existing tooling for trend tracking can consume it.
+*/
+class BenchmarkRunner : public QObject {
+
+	Q_OBJECT
+
+public:
+	BenchmarkRunner(QObject *pParent = NULL);
+	virtual ~BenchmarkRunner();
+	//! Takes ownership.
+	void AddBenchmark(AbstractBenchmark *pBenchmark);
+	//! Registers the benchmarks shipped with IMF Tool.
+	void AddDefaultBenchmarks();
+	//! Parses the command line, generates the synthetic IMP, runs the matching benchmarks and writes the report. Returns the process exit code.
+	int Execute(const QStringList &rArguments);
+
+private:
+	Q_DISABLE_COPY(BenchmarkRunner);
+	struct Result {
+		Result() : iterations(0), realTimes(), cpuTimes(), bytesProcessed(0), itemsProcessed(0), counters() {}
+		int iterations;
+		QList<double> realTimes; // [ms]
+		QList<double> cpuTimes; // [ms]
+		qint64 bytesProcessed;
+		qint64 itemsProcessed;
+		QList<QMap<QString, double> > counters; // One map per iteration.
+	};
+	Error RunBenchmark(AbstractBenchmark *pBenchmark, const BenchmarkContext &rContext, int iterations, Result &rResult);
+	QJsonObject CreateContext(const BenchmarkContext &rContext) const;
+	void AppendResult(QJsonArray &rBenchmarks, const QString &rName, const Result &rResult) const;
+
+	QList<AbstractBenchmark*> mBenchmarks;
+};
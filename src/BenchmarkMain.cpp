@@ -0,0 +1,57 @@
+/* Copyright(C) 2016 Björn Stresing, Denis Manthey, Wolfgang Ruppel
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "global.h"
+#include "Benchmark.h"
+#include "ImfCommon.h"
+#include "MetadataExtractorCommon.h"
+#include "JobQueue.h"
+#include "KMQtLogSink.h"
+#include "XmlValidationService.h"
+#include <QtWidgets/QApplication>
+#include <QSettings>
+#include <xercesc/util/PlatformUtils.hpp>
+
+
+//! Entry point of imftool-bench. Runs without display, GPU or network.
+int main(int argc, char *argv[]) {
+
+	// WidgetComposition is a widget. Use the offscreen platform unless the caller chose one.
+	if(qEnvironmentVariableIsSet("QT_QPA_PLATFORM") == false) qputenv("QT_QPA_PLATFORM", "offscreen");
+	QApplication a(argc, argv);
+	a.setApplicationName(PROJECT_NAME);
+	a.setOrganizationName("hsrm");
+	a.setOrganizationDomain("hsrm.de");
+	a.setApplicationVersion(QString("%1.%2.%3").arg(VERSION_MAJOR).arg(VERSION_MINOR).arg(VERSION_PATCH));
+	QSettings::setDefaultFormat(QSettings::IniFormat);
+	// Keep the report on stdout free of Kumu messages.
+	Kumu::KMQtLogSink qt_kumu_log_sinc;
+	Kumu::SetDefaultLogSink(&qt_kumu_log_sinc);
+
+	qRegisterMetaType<SoundfieldGroup>("SoundfieldGroup");
+	qRegisterMetaType<Metadata>("Metadata");
+	qRegisterMetaType<EditRate>("EditRate");
+	qRegisterMetaType<Timecode>("Timecode");
+	qRegisterMetaType<Duration>("Duration");
+	qRegisterMetaType<JobTelemetry>("JobTelemetry");
+	qRegisterMetaType<JobQueueStatistics>("JobQueueStatistics");
+	qRegisterMetaType<XmlValidationResult>("XmlValidationResult");
+	qRegisterMetaType<AudioAnalysisResult>("AudioAnalysisResult");
+
+	xercesc::XMLPlatformUtils::Initialize();
+	BenchmarkRunner runner;
+	runner.AddDefaultBenchmarks();
+	return runner.Execute(a.arguments());
+}
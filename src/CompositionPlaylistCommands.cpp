@@ -312,70 +312,52 @@ void RemoveSegmentCommand::redo() {
 	}
 }
 
-MoveMarkerCommand::MoveMarkerCommand(GraphicsObjectVerticalIndicator *pMarker, const QPointF &rNewPosition, const QPointF &rOldPosition, QUndoCommand *pParent /*= NULL*/) :
-QUndoCommand(pParent), mpMarker(pMarker), mOldPosition(rOldPosition), mNewPosition(rNewPosition) {
+MoveMarkerCommand::MoveMarkerCommand(GraphicsWidgetMarkerResource *pResource, quint32 markerId, qint64 newOffset, qint64 oldOffset, QUndoCommand *pParent /*= NULL*/) :
+QUndoCommand(pParent), mpResource(pResource), mMarkerId(markerId), mOldOffset(oldOffset), mNewOffset(newOffset) {
 
 }
 
 void MoveMarkerCommand::undo() {
 
-	mpMarker->setPos(mOldPosition);
+	mpResource->SetMarkerOffset(mMarkerId, mOldOffset);
 }
 
 void MoveMarkerCommand::redo() {
 
-	mpMarker->setPos(mNewPosition);
+	mpResource->SetMarkerOffset(mMarkerId, mNewOffset);
 }
 
-AddMarkerCommand::AddMarkerCommand(GraphicsObjectVerticalIndicator *pMarker, const QPointF &rPosition, GraphicsWidgetMarkerResource *pResource, QUndoCommand *pParent /*= NULL*/) :
-QUndoCommand(pParent), mpMarker(pMarker), mpResource(pResource), mPosition(rPosition), mIsRedone(false) {
+AddMarkerCommand::AddMarkerCommand(GraphicsWidgetMarkerResource *pResource, const MarkerLabel &rLabel, qint64 offset, QUndoCommand *pParent /*= NULL*/) :
+QUndoCommand(pParent), mpResource(pResource), mLabel(rLabel), mOffset(offset), mMarkerId(0) {
 
 }
 
-AddMarkerCommand::~AddMarkerCommand() {
-
-	if(mIsRedone == false && mpMarker) mpMarker->deleteLater(); // TODO: Is this safe.
-}
-
 void AddMarkerCommand::undo() {
 
-	mpMarker->hide();
-	mpMarker->setParentItem(NULL); // Gets top level item. Deleted by scene.
-	mIsRedone = false;
+	mpResource->RemoveMarker(mMarkerId);
 }
 
 void AddMarkerCommand::redo() {
 
-	mpMarker->setParentItem(mpResource);
-	mpMarker->setPos(mPosition);
-	mpMarker->show();
-	mIsRedone = true;
-}
-
-RemoveMarkerCommand::RemoveMarkerCommand(GraphicsObjectVerticalIndicator *pMarker, GraphicsWidgetMarkerResource *pResource, QUndoCommand *pParent /*= NULL*/) :
-QUndoCommand(pParent), mpMarker(pMarker), mpResource(pResource), mPosition(pMarker->pos()), mIsRedone(false) {
-
+	// Reuse the Id. Later commands reference the marker by Id.
+	mMarkerId = mpResource->AddMarker(mLabel, mOffset, UserText(), mMarkerId);
 }
 
-RemoveMarkerCommand::~RemoveMarkerCommand() {
+RemoveMarkerCommand::RemoveMarkerCommand(GraphicsWidgetMarkerResource *pResource, quint32 markerId, QUndoCommand *pParent /*= NULL*/) :
+QUndoCommand(pParent), mpResource(pResource), mMarkerId(markerId), mLabel(), mOffset(0), mAnnotation() {
 
-	if(mIsRedone == true && mpMarker) mpMarker->deleteLater(); // TODO: Is this safe.
+	mpResource->GetMarker(mMarkerId, mLabel, mOffset, mAnnotation);
 }
 
 void RemoveMarkerCommand::undo() {
 
-	mpMarker->setParentItem(mpResource);
-	mpMarker->setPos(mPosition);
-	mpMarker->show();
-	mIsRedone = false;
+	mpResource->AddMarker(mLabel, mOffset, mAnnotation, mMarkerId);
 }
 
 void RemoveMarkerCommand::redo() {
 
-	mPosition = mpMarker->pos();
-	mpMarker->hide();
-	mpMarker->setParentItem(NULL); // Gets top level item. Deleted by scene.
-	mIsRedone = true;
+	mpResource->GetMarker(mMarkerId, mLabel, mOffset, mAnnotation);
+	mpResource->RemoveMarker(mMarkerId);
 }
 
 AddTrackDetailsCommand::AddTrackDetailsCommand(AbstractWidgetTrackDetails *pTrackDetails, WidgetComposition *pComposition, int trackIndex, QUndoCommand *pParent /*= NULL*/) :
@@ -15,6 +15,7 @@
  */
 #pragma once
 #include "ImfCommon.h"
+#include "ImfPackageCommon.h"
 #include <QUndoCommand>
 
 
@@ -237,10 +238,12 @@ private:
 };
 
 
+//! Markers are addressed by Id. Their graphics items may be created and destroyed by the level of detail of GraphicsWidgetMarkerResource.
 class MoveMarkerCommand : public QUndoCommand {
 
 public:
-	MoveMarkerCommand(GraphicsObjectVerticalIndicator *pMarker, const QPointF &rNewPosition, const QPointF &rOldPosition, QUndoCommand *pParent = NULL);
+	//! Offsets are given in resource edit units.
+	MoveMarkerCommand(GraphicsWidgetMarkerResource *pResource, quint32 markerId, qint64 newOffset, qint64 oldOffset, QUndoCommand *pParent = NULL);
 	virtual ~MoveMarkerCommand() {}
 	virtual void undo();
 	//! Called once when pushed on Undo Stack.
@@ -248,45 +251,48 @@ public:
 
 private:
 	Q_DISABLE_COPY(MoveMarkerCommand);
-	GraphicsObjectVerticalIndicator *mpMarker;
-	QPointF mOldPosition;
-	QPointF mNewPosition;
+	GraphicsWidgetMarkerResource *mpResource;
+	quint32 mMarkerId;
+	qint64 mOldOffset;
+	qint64 mNewOffset;
 };
 
 
 class AddMarkerCommand : public QUndoCommand {
 
 public:
-	AddMarkerCommand(GraphicsObjectVerticalIndicator *pMarker, const QPointF &rPosition, GraphicsWidgetMarkerResource *pResource, QUndoCommand *pParent = NULL);
-	virtual ~AddMarkerCommand();
+	//! offset is given in resource edit units.
+	AddMarkerCommand(GraphicsWidgetMarkerResource *pResource, const MarkerLabel &rLabel, qint64 offset, QUndoCommand *pParent = NULL);
+	virtual ~AddMarkerCommand() {}
 	virtual void undo();
 	//! Called once when pushed on Undo Stack.
 	virtual void redo();
 
 private:
 	Q_DISABLE_COPY(AddMarkerCommand);
-	GraphicsObjectVerticalIndicator *mpMarker;
 	GraphicsWidgetMarkerResource *mpResource;
-	QPointF mPosition;
-	bool mIsRedone;
+	MarkerLabel mLabel;
+	qint64 mOffset;
+	quint32 mMarkerId; // Assigned by the first redo.
 };
 
 
 class RemoveMarkerCommand : public QUndoCommand {
 
 public:
-	RemoveMarkerCommand(GraphicsObjectVerticalIndicator *pMarker, GraphicsWidgetMarkerResource *pResource, QUndoCommand *pParent = NULL);
-	virtual ~RemoveMarkerCommand();
+	RemoveMarkerCommand(GraphicsWidgetMarkerResource *pResource, quint32 markerId, QUndoCommand *pParent = NULL);
+	virtual ~RemoveMarkerCommand() {}
 	virtual void undo();
 	//! Called once when pushed on Undo Stack.
 	virtual void redo();
 
 private:
 	Q_DISABLE_COPY(RemoveMarkerCommand);
-	GraphicsObjectVerticalIndicator *mpMarker;
 	GraphicsWidgetMarkerResource *mpResource;
-	QPointF mPosition;
-	bool mIsRedone;
+	quint32 mMarkerId;
+	MarkerLabel mLabel;
+	qint64 mOffset;
+	UserText mAnnotation;
 };
 
 
@@ -14,37 +14,35 @@
  * along with this program.If not, see <http://www.gnu.org/licenses/>.
  */
 #include "EmptyTimedTextGenerator.h"
+#include "XmlParserPool.h"
 #include <QFile>
 
 
 
 EmptyTimedTextGenerator::EmptyTimedTextGenerator(QString filePath, QString dur){
 
-	int error;
-	mpFilePath = &filePath;
-	mpDur = &dur;
-	error = GenerateEmptyXml();
-	if (error > 0)
-		QFile::remove(mpFilePath->at(0));
+	QByteArray document = Generate(dur);
+	QFile file(filePath);
+	if (document.isEmpty() == false && file.open(QIODevice::WriteOnly))
+		file.write(document);
 }
 
 EmptyTimedTextGenerator::~EmptyTimedTextGenerator(){
 	qDebug("Terminated");
 }
 
-int EmptyTimedTextGenerator::GenerateEmptyXml()
+QByteArray EmptyTimedTextGenerator::Generate(const QString &rDuration, const QString &rLanguage /*= "en"*/, const QString &rProfile /*= IMSC1_TEXT_PROFILE*/)
 {
-    try
-    {
-        XMLPlatformUtils::Initialize();
-    }
-    catch(const XMLException& e)
-    {
-        char* message = XMLString::transcode(e.getMessage());
-        qDebug() << "Error Message: " << message << "\n";
-        XMLString::release(&message);
-        return 1;
-    }
+	QByteArray document;
+	if (GenerateEmptyXml(rDuration, rLanguage, rProfile, document) > 0)
+		document.clear();
+	return document;
+}
+
+int EmptyTimedTextGenerator::GenerateEmptyXml(const QString &rDuration, const QString &rLanguage, const QString &rProfile, QByteArray &rDocument)
+{
+    // Xerces is initialized once per process by the parser pool.
+    XmlParserPool::Instance();
 
     int error = 0;
     {
@@ -66,8 +64,8 @@ int EmptyTimedTextGenerator::GenerateEmptyXml()
                 rootElem->setAttribute(X("xmlns:ttm"), X("http://www.w3.org/ns/ttml#metadata"));
                 rootElem->setAttribute(X("xmlns:ttp"), X("http://www.w3.org/ns/ttml#parameter"));
 
-                rootElem->setAttribute(X("xml:lang"), X("en"));
-                rootElem->setAttribute(X("ttp:profile"), X("http://www.w3.org/ns/ttml/profile/imsc1/text"));
+                rootElem->setAttribute(X("xml:lang"), X(rLanguage.toStdString().c_str()));
+                rootElem->setAttribute(X("ttp:profile"), X(rProfile.toStdString().c_str()));
 
 
                 // <head>
@@ -95,9 +93,9 @@ int EmptyTimedTextGenerator::GenerateEmptyXml()
                 bodyElem->appendChild(divElem);
 
                 divElem->setAttribute(X("begin"), X("0s"));
-                divElem->setAttribute(X("end"), X(mpDur->toStdString().c_str()));
+                divElem->setAttribute(X("end"), X(rDuration.toStdString().c_str()));
 
-                OutputXML(doc);
+                OutputXML(doc, rDocument);
 
                 doc->release();
             }
@@ -126,15 +124,11 @@ int EmptyTimedTextGenerator::GenerateEmptyXml()
        }
     }
 
-    XMLPlatformUtils::Terminate();
-
     return error;
 }
 
-void EmptyTimedTextGenerator::OutputXML(DOMDocument* pmyDOMDocument)
+void EmptyTimedTextGenerator::OutputXML(DOMDocument* pmyDOMDocument, QByteArray &rDocument)
 {
-	QTemporaryFile file;
-
 	DOMImplementation *implementation = DOMImplementationRegistry::getDOMImplementation(X("LS"));
     DOMLSSerializer *serializer = ((DOMImplementationLS*)implementation)->createLSSerializer();
 
@@ -142,15 +136,14 @@ void EmptyTimedTextGenerator::OutputXML(DOMDocument* pmyDOMDocument)
         serializer->getDomConfig()->setParameter(XMLUni::fgDOMWRTFormatPrettyPrint, true);
 
     serializer->setNewLine(XMLString::transcode("\r\n"));
-    XMLCh *tempFilePath = XMLString::transcode(mpFilePath->toStdString().c_str());
-    XMLFormatTarget *formatTarget = new LocalFileFormatTarget(tempFilePath);
+    MemBufFormatTarget *formatTarget = new MemBufFormatTarget();
     DOMLSOutput *output = ((DOMImplementationLS*)implementation)->createLSOutput();
 
     output->setByteStream(formatTarget);
     serializer->write(pmyDOMDocument, output);
+    rDocument = QByteArray((const char*)formatTarget->getRawBuffer(), (int)formatTarget->getLen());
 
     serializer->release();
-    XMLString::release(&tempFilePath);
     delete formatTarget;
     output->release();
 }
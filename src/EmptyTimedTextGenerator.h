@@ -22,13 +22,14 @@
 #include <QDebug>
 #include <cstring>
 #include <QMessageBox>
+#include "global.h"
 
 #include <xercesc/util/PlatformUtils.hpp>
 #include <xercesc/util/XMLString.hpp>
 #include <xercesc/dom/DOM.hpp>
 #include <xercesc/util/OutOfMemoryException.hpp>
 #include <xercesc/framework/XMLFormatter.hpp>
-#include <xercesc/framework/LocalFileFormatTarget.hpp>
+#include <xercesc/framework/MemBufFormatTarget.hpp>
 #include <xercesc/dom/DOMDocument.hpp>
 #include <xercesc/dom/DOMImplementation.hpp>
 #include <xercesc/dom/DOMImplementationRegistry.hpp>
@@ -59,6 +60,8 @@ public:
 	EmptyTimedTextGenerator();
 	EmptyTimedTextGenerator(QString filePath, QString dur);
 	virtual ~EmptyTimedTextGenerator();
+	//! Returns an empty IMSC1 document. rDuration is a TTML time expression (e.g. "30s"). Returns an empty array on error.
+	static QByteArray Generate(const QString &rDuration, const QString &rLanguage = "en", const QString &rProfile = IMSC1_TEXT_PROFILE);
 
 	Q_SIGNALS:
 	void FileComplete(const QStringList &files);
@@ -66,10 +69,7 @@ public:
 private:
 	Q_DISABLE_COPY(EmptyTimedTextGenerator);
 
-	int GenerateEmptyXml();
-	void OutputXML(DOMDocument* pmyDOMDocument);
-
-	QString *mpFilePath;
-	QString *mpDur;
+	static int GenerateEmptyXml(const QString &rDuration, const QString &rLanguage, const QString &rProfile, QByteArray &rDocument);
+	static void OutputXML(DOMDocument* pmyDOMDocument, QByteArray &rDocument);
 };
 
@@ -40,6 +40,8 @@ public:
 		WorkerRunning,
 		OpenCLError,
 		XMLSchemeError,
+		DestinationFileOpenError,
+		VideoDecoding,
 		Unknown
 	};
 	//! Constructs empty error (IsError returns false).
@@ -62,6 +64,8 @@ public:
 				ret = QObject::tr("No source file(s) found"); break;
 			case SourceFileOpenError:
 				ret = QObject::tr("Couldn't open source file(s)."); break;
+			case DestinationFileOpenError:
+				ret = QObject::tr("Couldn't open destination file."); break;
 			case UnsupportedEssence:
 				ret = QObject::tr("The file contains an unsupported essence"); break;
 			case UnknownDuration:
@@ -82,6 +86,8 @@ public:
 				ret = QObject::tr("OpenCL Error"); break;
 			case XMLSchemeError:
 				ret = QObject::tr("XML Schema Error"); break;
+			case VideoDecoding:
+				ret = QObject::tr("Couldn't decode the JPEG 2000 codestream"); break;
 			case Unknown:
 				ret = QObject::tr("Unknown error"); break;
 			default:
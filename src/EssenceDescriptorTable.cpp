@@ -0,0 +1,163 @@
+/* Copyright(C) 2016 Björn Stresing, Denis Manthey, Wolfgang Ruppel
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "EssenceDescriptorTable.h"
+#include "ImfPackageCommon.h"
+#include "XmlParserPool.h"
+#include "Trace.h"
+#include <QCryptographicHash>
+#include <QMutexLocker>
+#include <QStringList>
+#include <QDebug>
+#include <xercesc/dom/DOM.hpp>
+
+
+namespace {
+
+// Name space of the descriptor Ids (UUID v5).
+const QUuid descriptor_namespace("{5b0f0ab2-4b5e-4f0c-9a43-2c1a6a2fd3b7}");
+const char *xmlns_namespace = "http://www.w3.org/2000/xmlns/";
+
+QString to_qstring(const XMLCh *pString) {
+
+	if(pString == NULL) return QString();
+	return QString::fromUtf16(reinterpret_cast<const ushort*>(pString));
+}
+
+// Every string is terminated so that concatenations can't collide.
+void add_string(QCryptographicHash &rHash, const QString &rString) {
+
+	rHash.addData(rString.toUtf8());
+	rHash.addData("\0", 1);
+}
+
+void add_node(QCryptographicHash &rHash, const xercesc::DOMNode *pNode) {
+
+	switch(pNode->getNodeType()) {
+		case xercesc::DOMNode::ELEMENT_NODE:
+		{
+			const QString local_name = to_qstring(pNode->getLocalName() ? pNode->getLocalName() : pNode->getNodeName());
+			if(local_name == "InstanceID") return;
+			rHash.addData("<", 1);
+			add_string(rHash, to_qstring(pNode->getNamespaceURI()));
+			add_string(rHash, local_name);
+			QStringList attributes;
+			const xercesc::DOMNamedNodeMap *p_attributes = pNode->getAttributes();
+			for(XMLSize_t i = 0; p_attributes && i < p_attributes->getLength(); i++) {
+				const xercesc::DOMNode *p_attribute = p_attributes->item(i);
+				const QString attribute_namespace = to_qstring(p_attribute->getNamespaceURI());
+				if(attribute_namespace == xmlns_namespace) continue;
+				const QString attribute_name = to_qstring(p_attribute->getLocalName() ? p_attribute->getLocalName() : p_attribute->getNodeName());
+				attributes << QString("%1 %2=%3").arg(attribute_namespace).arg(attribute_name).arg(to_qstring(p_attribute->getNodeValue()));
+			}
+			attributes.sort();
+			for(int i = 0; i < attributes.size(); i++) add_string(rHash, attributes.at(i));
+			for(const xercesc::DOMNode *p_child = pNode->getFirstChild(); p_child != NULL; p_child = p_child->getNextSibling()) add_node(rHash, p_child);
+			rHash.addData(">", 1);
+			break;
+		}
+		case xercesc::DOMNode::TEXT_NODE:
+		case xercesc::DOMNode::CDATA_SECTION_NODE:
+		{
+			const QString text = to_qstring(pNode->getNodeValue()).trimmed();
+			if(text.isEmpty() == false) {
+				rHash.addData("#", 1);
+				add_string(rHash, text);
+			}
+			break;
+		}
+		default:
+			break;
+	}
+}
+}
+
+EssenceDescriptorTable& EssenceDescriptorTable::Instance() {
+
+	static EssenceDescriptorTable table;
+	return table;
+}
+
+EssenceDescriptorTable::EssenceDescriptorTable() :
+mMutex(), mDescriptors(), mHitCount(0) {
+
+}
+
+EssenceDescriptorTable::Descriptor EssenceDescriptorTable::Intern(const QByteArray &rRegXml, const QString &rSystemId, Error &rError) {
+
+	TRACE_SPAN_DETAIL("EssenceDescriptorTable::Intern", "xml", rSystemId);
+	xsd::cxx::xml::dom::auto_ptr<xercesc::DOMDocument> document(XmlParserPool::Instance().Parse(rRegXml, rSystemId, rError));
+	if(rError.IsError() == true) return Descriptor();
+	const xercesc::DOMElement *p_element = document->getDocumentElement();
+	if(p_element == NULL) {
+		rError = Error(Error::XMLSchemeError, QObject::tr("%1: Essence descriptor is empty").arg(rSystemId));
+		return Descriptor();
+	}
+	return Intern(*p_element);
+}
+
+EssenceDescriptorTable::Descriptor EssenceDescriptorTable::Intern(const xercesc::DOMElement &rElement) {
+
+	const QByteArray hash = CanonicalHash(rElement);
+	{
+		QMutexLocker locker(&mMutex);
+		Descriptor descriptor = mDescriptors.value(hash).toStrongRef();
+		if(descriptor) {
+			mHitCount++;
+			return descriptor;
+		}
+	}
+	// Copy the element outside the lock. Another thread may intern the same content meanwhile, the first one wins.
+	cpl::EssenceDescriptorBaseType *p_descriptor = new cpl::EssenceDescriptorBaseType(ImfXmlHelper::Convert(QUuid::createUuidV5(descriptor_namespace, QString(hash.toHex()))));
+	p_descriptor->getAny().push_back(rElement);
+	Descriptor new_descriptor(p_descriptor);
+	QMutexLocker locker(&mMutex);
+	Descriptor descriptor = mDescriptors.value(hash).toStrongRef();
+	if(descriptor) {
+		mHitCount++;
+		return descriptor;
+	}
+	mDescriptors.insert(hash, new_descriptor.toWeakRef());
+	return new_descriptor;
+}
+
+EssenceDescriptorTable::Descriptor EssenceDescriptorTable::CreateEmpty(const QUuid &rId) {
+
+	return Descriptor(new cpl::EssenceDescriptorBaseType(ImfXmlHelper::Convert(rId)));
+}
+
+QByteArray EssenceDescriptorTable::CanonicalHash(const xercesc::DOMElement &rElement) {
+
+	QCryptographicHash hash(QCryptographicHash::Sha1);
+	add_node(hash, &rElement);
+	return hash.result();
+}
+
+int EssenceDescriptorTable::GetCount() const {
+
+	QMutexLocker locker(&mMutex);
+	int count = 0;
+	QHash<QByteArray, QWeakPointer<const cpl::EssenceDescriptorBaseType> >::const_iterator i = mDescriptors.constBegin();
+	for(; i != mDescriptors.constEnd(); ++i) {
+		if(i.value().isNull() == false) count++;
+	}
+	return count;
+}
+
+qint64 EssenceDescriptorTable::GetHitCount() const {
+
+	QMutexLocker locker(&mMutex);
+	return mHitCount;
+}
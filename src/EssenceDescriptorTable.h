@@ -0,0 +1,60 @@
+/* Copyright(C) 2016 Björn Stresing, Denis Manthey, Wolfgang Ruppel
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include "Error.h"
+#include "SMPTE-2067-3-2013-CPL.h"
+#include <QByteArray>
+#include <QString>
+#include <QUuid>
+#include <QHash>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QWeakPointer>
+
+
+/*! \brief Intern table of RegXML essence descriptors.
+Descriptors are keyed by a canonical SHA-1 of their content: namespace URIs, local names, sorted attributes and trimmed text
+in document order. Prefixes, comments, whitespace-only text and InstanceID elements (MXF object identity) are ignored.
+All assets with identical descriptors share one immutable cpl::EssenceDescriptorBaseType. Its Id (the SourceEncoding of
+CPL resources) is a name based UUID derived from the hash, so CPLs list one descriptor per unique content.
+An entry lives as long as an asset references it. Thread safe.
+*/
+class EssenceDescriptorTable {
+
+public:
+	typedef QSharedPointer<const cpl::EssenceDescriptorBaseType> Descriptor;
+	static EssenceDescriptorTable& Instance();
+	//! Parses the RegXML dump of an essence descriptor and returns the shared instance. Returns a null pointer and sets rError on failure.
+	Descriptor Intern(const QByteArray &rRegXml, const QString &rSystemId, Error &rError);
+	//! Returns the shared instance for a RegXML descriptor element. The element is copied if the content is new.
+	Descriptor Intern(const xercesc::DOMElement &rElement);
+	//! Descriptor without RegXML content for track files which don't exist yet. Not interned.
+	static Descriptor CreateEmpty(const QUuid &rId);
+	static QByteArray CanonicalHash(const xercesc::DOMElement &rElement);
+	//! Number of distinct descriptors currently referenced.
+	int GetCount() const;
+	//! Number of Intern() calls served by an existing descriptor.
+	qint64 GetHitCount() const;
+
+private:
+	EssenceDescriptorTable();
+	~EssenceDescriptorTable() {}
+	Q_DISABLE_COPY(EssenceDescriptorTable);
+
+	mutable QMutex mMutex;
+	QHash<QByteArray, QWeakPointer<const cpl::EssenceDescriptorBaseType> > mDescriptors;
+	qint64 mHitCount;
+};
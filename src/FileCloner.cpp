@@ -0,0 +1,289 @@
+/* Copyright(C) 2016 Björn Stresing, Denis Manthey, Wolfgang Ruppel
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "FileCloner.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QThread>
+#include <QByteArray>
+#include <cstring>
+
+#if defined(Q_OS_UNIX)
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+#if defined(Q_OS_LINUX)
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/fs.h>
+#elif defined(Q_OS_MAC)
+#include <sys/clonefile.h>
+#endif
+
+#if defined(Q_OS_LINUX) && defined(FICLONE)
+#define FILE_CLONER_REFLINK
+#elif defined(Q_OS_MAC)
+#define FILE_CLONER_REFLINK
+#endif
+#if defined(Q_OS_LINUX) && defined(__NR_copy_file_range)
+#define FILE_CLONER_COPY_FILE_RANGE
+#endif
+
+
+namespace {
+
+	enum eResult {
+		Done = 0,
+		Unsupported, // Try the next method.
+		Failed
+	};
+
+	const qint64 range_chunk_size = 64 * 1024 * 1024; // Bytes per copy_file_range() call. Bounds the interval between progress reports.
+	const qint64 stream_buffer_size = 4 * 1024 * 1024;
+
+	bool proceed(FileCloner::Listener *pListener, qint64 bytes) {
+
+		if(pListener) return pListener->BytesCopied(bytes);
+		return QThread::currentThread()->isInterruptionRequested() == false;
+	}
+
+#if defined(Q_OS_UNIX)
+	QString errno_string(int error) {
+
+		return QString::fromLocal8Bit(std::strerror(error));
+	}
+
+	// Opens the source for reading and creates the (not yet existing) destination.
+	eResult open_pair(const QString &rSource, const QString &rDestination, int &rSourceFd, int &rDestinationFd, Error &rError) {
+
+		rSourceFd = ::open(QFile::encodeName(rSource).constData(), O_RDONLY | O_CLOEXEC);
+		if(rSourceFd < 0) {
+			rError = Error(Error::SourceFileOpenError, QString("%1: %2").arg(rSource).arg(errno_string(errno)));
+			return Failed;
+		}
+		rDestinationFd = ::open(QFile::encodeName(rDestination).constData(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+		if(rDestinationFd < 0) {
+			rError = Error(Error::DestinationFileOpenError, QString("%1: %2").arg(rDestination).arg(errno_string(errno)));
+			::close(rSourceFd);
+			return Failed;
+		}
+		return Done;
+	}
+#endif
+
+	eResult reflink(const QString &rSource, const QString &rDestination, Error &rError) {
+
+#if defined(Q_OS_LINUX) && defined(FILE_CLONER_REFLINK)
+		int source_fd = -1;
+		int destination_fd = -1;
+		if(open_pair(rSource, rDestination, source_fd, destination_fd, rError) != Done) return Failed;
+		// Fails with EOPNOTSUPP, EXDEV or EINVAL if the file system can't share extents between these files.
+		int ret = ::ioctl(destination_fd, FICLONE, source_fd);
+		::close(source_fd);
+		if(::close(destination_fd) != 0) ret = -1;
+		return ret == 0 ? Done : Unsupported;
+#elif defined(Q_OS_MAC)
+		Q_UNUSED(rError);
+		return ::clonefile(QFile::encodeName(rSource).constData(), QFile::encodeName(rDestination).constData(), 0) == 0 ? Done : Unsupported;
+#else
+		Q_UNUSED(rSource); Q_UNUSED(rDestination); Q_UNUSED(rError);
+		return Unsupported;
+#endif
+	}
+
+	eResult copy_range(const QString &rSource, const QString &rDestination, qint64 size, FileCloner::Listener *pListener, Error &rError) {
+
+#if defined(FILE_CLONER_COPY_FILE_RANGE)
+		int source_fd = -1;
+		int destination_fd = -1;
+		if(open_pair(rSource, rDestination, source_fd, destination_fd, rError) != Done) return Failed;
+		eResult result = Done;
+		qint64 copied = 0;
+		while(copied < size) {
+			// The syscall is used directly because glibc provides the wrapper only since 2.27.
+			long ret = ::syscall(__NR_copy_file_range, source_fd, NULL, destination_fd, NULL, (size_t)qMin(range_chunk_size, size - copied), 0u);
+			if(ret < 0) {
+				int error = errno;
+				if(error == EINTR) continue;
+				if(copied == 0 && (error == ENOSYS || error == EXDEV || error == EOPNOTSUPP || error == EINVAL || error == EBADF)) result = Unsupported;
+				else {
+					rError = Error(Error::DestinationFileOpenError, QString("%1: %2").arg(rDestination).arg(errno_string(error)));
+					result = Failed;
+				}
+				break;
+			}
+			if(ret == 0) {
+				rError = Error(Error::SourceFileOpenError, QObject::tr("%1 was truncated while copying.").arg(rSource));
+				result = Failed;
+				break;
+			}
+			copied += ret;
+			if(proceed(pListener, ret) == false) {
+				rError = Error(Error::WorkerInterruptionRequest);
+				result = Failed;
+				break;
+			}
+		}
+		::close(source_fd);
+		if(::close(destination_fd) != 0 && result == Done) {
+			rError = Error(Error::DestinationFileOpenError, QString("%1: %2").arg(rDestination).arg(errno_string(errno)));
+			result = Failed;
+		}
+		return result;
+#else
+		Q_UNUSED(rSource); Q_UNUSED(rDestination); Q_UNUSED(size); Q_UNUSED(pListener); Q_UNUSED(rError);
+		return Unsupported;
+#endif
+	}
+
+	eResult hardlink(const QString &rSource, const QString &rDestination, Error &rError) {
+
+#if defined(Q_OS_UNIX)
+		Q_UNUSED(rError);
+		// Fails with EXDEV across file systems and with EPERM on file systems without hard links.
+		return ::link(QFile::encodeName(rSource).constData(), QFile::encodeName(rDestination).constData()) == 0 ? Done : Unsupported;
+#else
+		Q_UNUSED(rSource); Q_UNUSED(rDestination); Q_UNUSED(rError);
+		return Unsupported;
+#endif
+	}
+
+	eResult stream(const QString &rSource, const QString &rDestination, FileCloner::Listener *pListener, Error &rError) {
+
+		QFile source(rSource);
+		if(source.open(QIODevice::ReadOnly) == false) {
+			rError = Error(Error::SourceFileOpenError, QString("%1: %2").arg(rSource).arg(source.errorString()));
+			return Failed;
+		}
+		QFile destination(rDestination);
+		if(destination.open(QIODevice::WriteOnly) == false) {
+			rError = Error(Error::DestinationFileOpenError, QString("%1: %2").arg(rDestination).arg(destination.errorString()));
+			return Failed;
+		}
+		QByteArray buffer(stream_buffer_size, Qt::Uninitialized);
+		while(source.atEnd() == false) {
+			qint64 count = source.read(buffer.data(), buffer.size());
+			if(count < 0) {
+				rError = Error(Error::SourceFileOpenError, QString("%1: %2").arg(rSource).arg(source.errorString()));
+				return Failed;
+			}
+			if(count == 0) break;
+			if(destination.write(buffer.constData(), count) != count) {
+				rError = Error(Error::DestinationFileOpenError, QString("%1: %2").arg(rDestination).arg(destination.errorString()));
+				return Failed;
+			}
+			if(proceed(pListener, count) == false) {
+				rError = Error(Error::WorkerInterruptionRequest);
+				return Failed;
+			}
+		}
+		if(destination.flush() == false) {
+			rError = Error(Error::DestinationFileOpenError, QString("%1: %2").arg(rDestination).arg(destination.errorString()));
+			return Failed;
+		}
+		return Done;
+	}
+}
+
+Error FileCloner::Clone(const QString &rSource, const QString &rDestination, eMethod &rMethod, eMethod firstMethod /*= Reflink*/, Listener *pListener /*= NULL*/) {
+
+	QFileInfo source_info(rSource);
+	if(source_info.isFile() == false) return Error(Error::SourceFilesMissing, rSource);
+	QFileInfo destination_info(rDestination);
+	if(destination_info.exists() == true) return Error(Error::DestinationFileOpenError, QObject::tr("%1 already exists.").arg(rDestination));
+	if(QDir().mkpath(destination_info.absolutePath()) == false) return Error(Error::DestinationFileOpenError, QObject::tr("Couldn't create directory %1.").arg(destination_info.absolutePath()));
+	// The destination appears under its name only when it is complete.
+	const QString temp_file(destination_info.absoluteDir().absoluteFilePath(QString(".%1.part").arg(destination_info.fileName())));
+	QFile::remove(temp_file); // Remains of an interrupted clone.
+
+	const qint64 size = source_info.size();
+	for(int method = firstMethod; method < MethodCount; method++) {
+		Error error;
+		eResult result = Failed;
+		switch(method) {
+			case Reflink:
+				result = reflink(rSource, temp_file, error); break;
+			case CopyFileRange:
+				result = copy_range(rSource, temp_file, size, pListener, error); break;
+			case Hardlink:
+				result = hardlink(rSource, temp_file, error); break;
+			case Stream:
+				result = stream(rSource, temp_file, pListener, error); break;
+		}
+		if(result == Unsupported) {
+			QFile::remove(temp_file);
+			continue;
+		}
+		if(result == Done && QFile::rename(temp_file, rDestination) == false) {
+			error = Error(Error::DestinationFileOpenError, QObject::tr("Couldn't rename %1 to %2.").arg(temp_file).arg(rDestination));
+			result = Failed;
+		}
+		if(result == Failed) {
+			QFile::remove(temp_file);
+			return error;
+		}
+		// Reflinks and hard links complete at once. Report the size so progress stays proportional to the bytes exported.
+		if(method == Reflink || method == Hardlink) proceed(pListener, size);
+		rMethod = (eMethod)method;
+		return Error();
+	}
+	return Error(Error::Unknown, QObject::tr("No copy method available for %1.").arg(rSource));
+}
+
+bool FileCloner::IsSupported(eMethod method) {
+
+	switch(method) {
+		case Reflink:
+#if defined(FILE_CLONER_REFLINK)
+			return true;
+#else
+			return false;
+#endif
+		case CopyFileRange:
+#if defined(FILE_CLONER_COPY_FILE_RANGE)
+			return true;
+#else
+			return false;
+#endif
+		case Hardlink:
+#if defined(Q_OS_UNIX)
+			return true;
+#else
+			return false;
+#endif
+		case Stream:
+			return true;
+		default:
+			return false;
+	}
+}
+
+QString FileCloner::GetMethodName(eMethod method) {
+
+	switch(method) {
+		case Reflink:
+			return "Reflink";
+		case CopyFileRange:
+			return "CopyFileRange";
+		case Hardlink:
+			return "Hardlink";
+		case Stream:
+			return "Stream";
+		default:
+			return "Unknown";
+	}
+}
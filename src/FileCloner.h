@@ -0,0 +1,54 @@
+/* Copyright(C) 2016 Björn Stresing, Denis Manthey, Wolfgang Ruppel
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include "Error.h"
+#include <QString>
+
+
+/*! \brief Copies files without moving the data through user space where the file system allows it.
+FileCloner::Clone() tries the methods in the order of FileCloner::eMethod, starting with the method passed as firstMethod, and falls back to the next
+one if a method isn't supported for the source and destination (e.g. different file systems):
+- Reflink: The destination shares the extents of the source (Linux FICLONE on XFS, Btrfs, OCFS2, NFS 4.2; clonefile() on APFS). Instant, copy on write.
+- CopyFileRange: Linux copy_file_range(). The kernel copies the data. Offloaded to the server on NFS 4.2 and SMB 3.
+- Hardlink: The destination is a second name of the source inode. Only use this for files that are replaced and never modified in place (MXF track files).
+- Stream: Plain read/write loop. Always available.
+The destination is written under a temporary name and renamed when complete. An existing destination is never overwritten. Thread safe.
+*/
+class FileCloner {
+
+public:
+	enum eMethod {
+		Reflink = 0,
+		CopyFileRange,
+		Hardlink,
+		Stream,
+		MethodCount
+	};
+	//! Receives the progress of copying methods. Cloning is canceled if FileCloner::Listener::BytesCopied() returns false.
+	class Listener {
+	public:
+		virtual ~Listener() {}
+		virtual bool BytesCopied(qint64 bytes) = 0;
+	};
+	//! Copies rSource to rDestination. rMethod is set to the method that succeeded.
+	static Error Clone(const QString &rSource, const QString &rDestination, eMethod &rMethod, eMethod firstMethod = Reflink, Listener *pListener = NULL);
+	//! Returns false if the method is never available on this platform.
+	static bool IsSupported(eMethod method);
+	static QString GetMethodName(eMethod method);
+
+private:
+	FileCloner() {}
+};
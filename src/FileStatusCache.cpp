@@ -0,0 +1,149 @@
+/* Copyright(C) 2016 Björn Stresing, Denis Manthey, Wolfgang Ruppel
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "FileStatusCache.h"
+#include <QFileSystemWatcher>
+#include <QGuiApplication>
+#include <QFileInfo>
+#include <QTimer>
+#include <QDir>
+
+
+FileStatusCache::FileStatusCache(QObject *pParent /*= NULL*/) :
+QObject(pParent), mpWatcher(NULL), mpBatchTimer(NULL), mStatus(), mFilesPerDirectory(), mPendingDirectories(), mStatCount(0) {
+
+	mpWatcher = new QFileSystemWatcher(this);
+	mpBatchTimer = new QTimer(this);
+	mpBatchTimer->setSingleShot(true);
+	mpBatchTimer->setInterval(BatchInterval);
+	connect(mpWatcher, SIGNAL(directoryChanged(const QString&)), this, SLOT(rDirectoryChanged(const QString&)));
+	connect(mpBatchTimer, SIGNAL(timeout()), this, SLOT(rProcessPendingChanges()));
+	// The user may have rewritten files in another application.
+	if(qobject_cast<QGuiApplication*>(QCoreApplication::instance())) {
+		connect(QCoreApplication::instance(), SIGNAL(applicationStateChanged(Qt::ApplicationState)), this, SLOT(rApplicationStateChanged(Qt::ApplicationState)));
+	}
+}
+
+void FileStatusCache::Watch(const QString &rFilePath) {
+
+	if(mStatus.contains(rFilePath) == true) return;
+	mStatus.insert(rFilePath, Stat(rFilePath));
+	const QString directory = QFileInfo(rFilePath).absolutePath();
+	mFilesPerDirectory[directory].insert(rFilePath);
+	WatchDirectory(directory);
+}
+
+void FileStatusCache::Unwatch(const QString &rFilePath) {
+
+	if(mStatus.remove(rFilePath) == 0) return;
+	const QString directory = QFileInfo(rFilePath).absolutePath();
+	QHash<QString, QSet<QString> >::iterator iter = mFilesPerDirectory.find(directory);
+	if(iter == mFilesPerDirectory.end()) return;
+	iter->remove(rFilePath);
+	if(iter->isEmpty() == true) {
+		mFilesPerDirectory.erase(iter);
+		mPendingDirectories.remove(directory);
+		mpWatcher->removePath(directory);
+	}
+}
+
+FileStatusCache::FileStatus FileStatusCache::GetStatus(const QString &rFilePath) const {
+
+	QHash<QString, FileStatus>::const_iterator iter = mStatus.constFind(rFilePath);
+	if(iter != mStatus.constEnd()) return iter.value();
+	return Stat(rFilePath);
+}
+
+bool FileStatusCache::Refresh(const QString &rFilePath) {
+
+	QHash<QString, FileStatus>::iterator iter = mStatus.find(rFilePath);
+	if(iter == mStatus.end()) return false;
+	const FileStatus status = Stat(rFilePath);
+	// The directory might have been created after FileStatusCache::Watch().
+	WatchDirectory(QFileInfo(rFilePath).absolutePath());
+	if(status == iter.value()) return false;
+	iter.value() = status;
+	return true;
+}
+
+void FileStatusCache::rDirectoryChanged(const QString &rDirectory) {
+
+	mPendingDirectories.insert(QDir(rDirectory).absolutePath());
+	StartBatch();
+}
+
+void FileStatusCache::Rescan() {
+
+	QStringList changed_files;
+	Update(mStatus.keys().toSet(), changed_files);
+	if(changed_files.isEmpty() == false) emit StatusChanged(changed_files);
+}
+
+void FileStatusCache::rApplicationStateChanged(Qt::ApplicationState state) {
+
+	if(state == Qt::ApplicationActive) Rescan();
+}
+
+void FileStatusCache::StartBatch() {
+
+	// Don't restart the timer. A continuously written file must not delay the update forever.
+	if(mpBatchTimer->isActive() == false) mpBatchTimer->start();
+}
+
+void FileStatusCache::rProcessPendingChanges() {
+
+	QStringList changed_files;
+	QSet<QString> pending_files;
+	const QSet<QString> pending_directories = mPendingDirectories;
+	mPendingDirectories.clear();
+	for(QSet<QString>::const_iterator dir_iter = pending_directories.constBegin(); dir_iter != pending_directories.constEnd(); ++dir_iter) {
+		pending_files.unite(mFilesPerDirectory.value(*dir_iter));
+		// QFileSystemWatcher drops directories which were removed. Watch them again if they were recreated.
+		WatchDirectory(*dir_iter);
+	}
+	Update(pending_files, changed_files);
+	if(changed_files.isEmpty() == false) emit StatusChanged(changed_files);
+}
+
+void FileStatusCache::Update(const QSet<QString> &rFilePaths, QStringList &rChangedFiles) {
+
+	for(QSet<QString>::const_iterator file_iter = rFilePaths.constBegin(); file_iter != rFilePaths.constEnd(); ++file_iter) {
+		QHash<QString, FileStatus>::iterator status_iter = mStatus.find(*file_iter);
+		if(status_iter == mStatus.end()) continue;
+		const FileStatus status = Stat(*file_iter);
+		if(status != status_iter.value()) {
+			status_iter.value() = status;
+			rChangedFiles << *file_iter;
+		}
+	}
+}
+
+FileStatusCache::FileStatus FileStatusCache::Stat(const QString &rFilePath) const {
+
+	mStatCount++;
+	QFileInfo file_info(rFilePath);
+	FileStatus status;
+	status.exists = file_info.exists() && file_info.isFile() && !file_info.isSymLink();
+	if(status.exists == true) {
+		status.size = file_info.size();
+		status.lastModified = file_info.lastModified();
+	}
+	return status;
+}
+
+void FileStatusCache::WatchDirectory(const QString &rDirectory) {
+
+	if(mpWatcher->directories().contains(rDirectory) == false && QFileInfo(rDirectory).isDir() == true) mpWatcher->addPath(rDirectory);
+}
@@ -0,0 +1,87 @@
+/* Copyright(C) 2016 Björn Stresing, Denis Manthey, Wolfgang Ruppel
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QDateTime>
+#include <QHash>
+#include <QSet>
+
+
+class QFileSystemWatcher;
+class QTimer;
+
+/*! \brief Caches existence, size and modification time of files.
+Watched files are stat'ed once. Afterwards only the directories of the files are watched by a QFileSystemWatcher, a package with thousands of files needs a handful of watches.
+A directory notification (file created, removed or renamed) stats the watched files of that directory. Notifications are collected for FileStatusCache::BatchInterval ms
+and FileStatusCache::StatusChanged() is emitted once per batch for files whose status really changed.
+Directory watches don't report files rewritten in place (inotify doesn't report IN_MODIFY for directory watches). FileStatusCache::Rescan() stats all watched files, it is invoked
+when the application becomes active and should be invoked before the status is relied upon (e.g. before a package is saved).
+Files written by IMF Tool itself should be refreshed explicitly (FileStatusCache::Refresh()). Not thread safe, use from the GUI thread.
+*/
+class FileStatusCache : public QObject {
+
+	Q_OBJECT
+
+public:
+	struct FileStatus {
+		FileStatus() : exists(false), size(0), lastModified() {}
+		bool operator==(const FileStatus &rOther) const { return exists == rOther.exists && size == rOther.size && lastModified == rOther.lastModified; }
+		bool operator!=(const FileStatus &rOther) const { return !(*this == rOther); }
+		bool exists; // Regular file, no symbolic link.
+		qint64 size; // [bytes]
+		QDateTime lastModified;
+	};
+	static const int BatchInterval = 250; // [ms]
+	FileStatusCache(QObject *pParent = NULL);
+	virtual ~FileStatusCache() {}
+	//! Stats rFilePath and watches its directory. rFilePath must be absolute. The file doesn't need to exist.
+	void Watch(const QString &rFilePath);
+	void Unwatch(const QString &rFilePath);
+	//! Returns the cached status. Files which aren't watched are stat'ed.
+	FileStatus GetStatus(const QString &rFilePath) const;
+	//! Stats rFilePath immediately. Doesn't emit FileStatusCache::StatusChanged(). Returns true if the status changed.
+	bool Refresh(const QString &rFilePath);
+	//! Stats all watched files and emits FileStatusCache::StatusChanged() for the files whose status changed.
+	void Rescan();
+	int GetWatchedFileCount() const { return mStatus.size(); }
+	//! Number of stats issued since construction.
+	qint64 GetStatCount() const { return mStatCount; }
+
+signals:
+	void StatusChanged(const QStringList &rFilePaths);
+
+	private slots:
+	void rDirectoryChanged(const QString &rDirectory);
+	void rProcessPendingChanges();
+	void rApplicationStateChanged(Qt::ApplicationState state);
+
+private:
+	Q_DISABLE_COPY(FileStatusCache);
+	FileStatus Stat(const QString &rFilePath) const;
+	void WatchDirectory(const QString &rDirectory);
+	void StartBatch();
+	//! Stats rFilePaths and appends the files whose status changed to rChangedFiles.
+	void Update(const QSet<QString> &rFilePaths, QStringList &rChangedFiles);
+
+	QFileSystemWatcher *mpWatcher;
+	QTimer *mpBatchTimer;
+	QHash<QString, FileStatus> mStatus; // Key: absolute file path.
+	QHash<QString, QSet<QString> > mFilesPerDirectory;
+	QSet<QString> mPendingDirectories;
+	mutable qint64 mStatCount;
+};
@@ -619,8 +619,12 @@ void GraphicsSceneComposition::keyPressEvent(QKeyEvent *pEvent) {
 					emit PushCommand(new RemoveResourceCommand(static_cast<AbstractGraphicsWidgetResource*>(p_item), static_cast<AbstractGraphicsWidgetResource*>(p_item)->GetSequence()));
 					break;
 				case GraphicsWidgetMarkerType:
-					emit PushCommand(new RemoveMarkerCommand(static_cast<GraphicsObjectVerticalIndicator*>(p_item), static_cast<GraphicsWidgetMarkerResource*>(p_item->parentItem())));
+				{
+					GraphicsWidgetMarkerResource *p_resource = static_cast<GraphicsWidgetMarkerResource*>(p_item->parentItem());
+					const quint32 marker_id = p_resource ? p_resource->GetMarkerId(p_item) : 0;
+					if(marker_id != 0) emit PushCommand(new RemoveMarkerCommand(p_resource, marker_id));
 					break;
+				}
 			}
 		}
 	}
@@ -29,6 +29,7 @@
 #define CPL_COLOR_VIDEO_RESOURCE 116, 102, 171
 #define CPL_COLOR_AUDIO_RESOURCE 110, 162, 110
 #define CPL_COLOR_TIMED_TEXT_RESOURCE 191, 159, 72
+#define CPL_COLOR_TIMED_TEXT_CUE 120, 96, 36, 160
 #define CPL_COLOR_ANC_RESOURCE 153, 72, 191
 #define CPL_COLOR_DUMMY_RESOURCE 129, 129, 129
 #define CPL_COLOR_MARKER_RESOURCE 255, 255, 255, 50
@@ -14,6 +14,7 @@
  * along with this program.If not, see <http://www.gnu.org/licenses/>.
  */
 #include "GraphicsViewScaleable.h"
+#include "Trace.h"
 #include <QKeyEvent>
 #include <QGraphicsItem>
 #include <cmath>
@@ -28,6 +29,12 @@ QGraphicsView(pParent) {
 	// 	setRenderHints(QPainter::Antialiasing | QPainter::SmoothPixmapTransform);
 }
 
+void GraphicsViewScaleable::paintEvent(QPaintEvent *pEvent) {
+
+	TRACE_SPAN("GraphicsViewScaleable::paintEvent", "paint");
+	QGraphicsView::paintEvent(pEvent);
+}
+
 void GraphicsViewScaleable::ZoomIn() {
 
 	ScaleView(qreal(1.1));
@@ -30,6 +30,9 @@ public:
 	void ZoomOut();
 	void ScaleView(qreal scaleFactor);
 
+protected:
+	virtual void paintEvent(QPaintEvent *pEvent);
+
 private:
 	Q_DISABLE_COPY(GraphicsViewScaleable);
 
@@ -19,10 +19,15 @@
 #include "CompositionPlaylistCommands.h"
 #include "GraphicsWidgetComposition.h"
 #include "MetadataExtractor.h"
+#include "TimedTextRenderer.h"
 #include <QGraphicsSceneResizeEvent>
 #include <QStyleOptionGraphicsItem>
 #include <QMenu>
 #include <QToolTip>
+#include <QTimer>
+#include <QPainter>
+#include <QGraphicsView>
+#include <cmath>
 
 
 AbstractGraphicsWidgetResource::AbstractGraphicsWidgetResource(GraphicsWidgetSequence *pParent, cpl::BaseResourceType *pResource, const QSharedPointer<AssetMxfTrack> &rAsset /*= QSharedPointer<AssetMxfTrack>(NULL)*/, const QColor &rColor /*= QColor(Qt::white)*/) :
@@ -992,13 +997,14 @@ SoundfieldGroup GraphicsWidgetAudioResource::GetSoundfieldGroup() const {
 GraphicsWidgetTimedTextResource::GraphicsWidgetTimedTextResource(GraphicsWidgetSequence *pParent, cpl::TrackFileResourceType *pResource, const QSharedPointer<AssetMxfTrack> &rAsset /*= QSharedPointer<AssetMxfTrack>(NULL)*/) :
 GraphicsWidgetFileResource(pParent, pResource, rAsset, QColor(CPL_COLOR_TIMED_TEXT_RESOURCE)) {
 
+	connect(&TimedTextRenderCache::Instance(), SIGNAL(DocumentLoaded(const QString&)), this, SLOT(rDocumentLoaded(const QString&)));
 }
 
 GraphicsWidgetTimedTextResource::GraphicsWidgetTimedTextResource(GraphicsWidgetSequence *pParent, const QSharedPointer<AssetMxfTrack> &rAsset) :
 GraphicsWidgetFileResource(pParent, rAsset, QColor(CPL_COLOR_TIMED_TEXT_RESOURCE)) {
 
 	if(mAssset) mpData->setEditRate(ImfXmlHelper::Convert(mAssset->GetEditRate()));
-
+	connect(&TimedTextRenderCache::Instance(), SIGNAL(DocumentLoaded(const QString&)), this, SLOT(rDocumentLoaded(const QString&)));
 }
 
 void GraphicsWidgetTimedTextResource::paint(QPainter *pPainter, const QStyleOptionGraphicsItem *pOption, QWidget *pWidget /*= NULL*/) {
@@ -1024,6 +1030,7 @@ void GraphicsWidgetTimedTextResource::paint(QPainter *pPainter, const QStyleOpti
 		visible_rect.adjust(0, 0, -1. / pPainter->transform().m11(), -1. / pPainter->transform().m22());
 		if(visible_rect.isEmpty() == true) continue;
 
+		PaintCues(pPainter, resource_rect, visible_rect);
 		QTransform transf = pPainter->transform();
 
 		QFontMetricsF font_metrics(pPainter->font());
@@ -1069,6 +1076,49 @@ void GraphicsWidgetTimedTextResource::paint(QPainter *pPainter, const QStyleOpti
 	}
 }
 
+void GraphicsWidgetTimedTextResource::PaintCues(QPainter *pPainter, const QRectF &rResourceRect, const QRectF &rVisibleRect) {
+
+	if(mAssset.isNull() == true || mAssset->Exists() == false || GetEditRate().IsValid() == false) return;
+	// Doesn't block. The item is updated when the document was loaded.
+	const QSharedPointer<const TimedTextDocument> document(TimedTextRenderCache::Instance().GetDocument(mAssset->GetPath().absoluteFilePath()));
+	if(document.isNull() == true) return;
+	const qreal scale = pPainter->worldTransform().m11(); // [px per CPL edit unit]
+	if(scale <= 0) return;
+	const double factor = ResourceErPerCompositionEr(GetCplEditRate());
+	const double ms_per_edit_unit = 1000. / GetEditRate().GetQuotient();
+	const double entry_point = GetEntryPoint().GetCount();
+	const qint64 first_ms = (qint64)std::floor((entry_point + (rVisibleRect.left() - rResourceRect.left()) * factor) * ms_per_edit_unit);
+	const qint64 last_ms = (qint64)std::ceil((entry_point + (rVisibleRect.right() - rResourceRect.left()) * factor) * ms_per_edit_unit);
+	const QList<int> cues(document->GetCues(first_ms, last_ms + 1));
+	if(cues.isEmpty() == true) return;
+
+	const QRectF band(rVisibleRect.left(), rResourceRect.top() + rResourceRect.height() * .4, rVisibleRect.width(), rResourceRect.height() * .25);
+	pPainter->save();
+	pPainter->setPen(Qt::NoPen);
+	pPainter->setBrush(QColor(CPL_COLOR_TIMED_TEXT_CUE));
+	// Cues less than a pixel apart are drawn as one box. Zoomed out, dense cues become blocks.
+	QRectF box;
+	for(int i = 0; i < cues.size(); i++) {
+		const TimedTextCue &r_cue = document->GetCue(cues.at(i));
+		const qreal left = qMax(band.left(), rResourceRect.left() + (r_cue.begin / ms_per_edit_unit - entry_point) / factor);
+		qreal right = band.right();
+		if(r_cue.end != TimedTextDocument::Indefinite) right = qMin(right, rResourceRect.left() + (r_cue.end / ms_per_edit_unit - entry_point) / factor);
+		right = qMax(right, left + 1 / scale);
+		if(box.isNull() == false && left <= box.right() + 1 / scale) box.setRight(qMax(box.right(), right));
+		else {
+			if(box.isNull() == false) pPainter->drawRect(box);
+			box = QRectF(QPointF(left, band.top()), QPointF(right, band.bottom()));
+		}
+	}
+	if(box.isNull() == false) pPainter->drawRect(box);
+	pPainter->restore();
+}
+
+void GraphicsWidgetTimedTextResource::rDocumentLoaded(const QString &rFilePath) {
+
+	if(mAssset && mAssset->GetPath().absoluteFilePath() == rFilePath) update();
+}
+
 GraphicsWidgetTimedTextResource* GraphicsWidgetTimedTextResource::Clone() const {
 
 	cpl::TrackFileResourceType intermediate_resource(*(static_cast<cpl::TrackFileResourceType*>(mpData)));
@@ -1173,40 +1223,46 @@ double GraphicsWidgetAncillaryDataResource::ResourceErPerCompositionEr(const Edi
 }
 
 GraphicsWidgetMarkerResource::GraphicsWidgetMarkerResource(GraphicsWidgetSequence *pParent, cpl::MarkerResourceType *pResource) :
-AbstractGraphicsWidgetResource(pParent, pResource, QSharedPointer<AssetMxfTrack>(NULL), QColor(CPL_COLOR_MARKER_RESOURCE)), mActiveMarkerOldPosition(-1, -1),
-mOldSourceDuration(-1), mOldIntrinsicDuration(-1) {
+AbstractGraphicsWidgetResource(pParent, pResource, QSharedPointer<AssetMxfTrack>(NULL), QColor(CPL_COLOR_MARKER_RESOURCE)), AbstractViewTransformNotifier(),
+mMarkers(), mMarkerOffsets(), mMaterializedMarkers(), mNextMarkerId(1), mIsMaterialized(false), mLevelOfDetailFirst(0), mLevelOfDetailLast(-1),
+mpLevelOfDetailTimer(NULL), mActiveMarkerId(0), mActiveMarkerOldOffset(-1), mOldSourceDuration(-1), mOldIntrinsicDuration(-1) {
 
 	setFlag(QGraphicsItem::ItemClipsChildrenToShape);
 	DisableTrimHandle(AbstractGraphicsWidgetResource::Left, true);
 	DisableTrimHandle(AbstractGraphicsWidgetResource::Right, true);
 	setAcceptHoverEvents(false);
+	mpLevelOfDetailTimer = new QTimer(this);
+	mpLevelOfDetailTimer->setSingleShot(true);
+	mpLevelOfDetailTimer->setInterval(0);
+	connect(mpLevelOfDetailTimer, SIGNAL(timeout()), this, SLOT(rUpdateLevelOfDetail()));
 	InitMarker();
 }
 
 GraphicsWidgetMarkerResource::GraphicsWidgetMarkerResource(GraphicsWidgetSequence *pParent) :
 AbstractGraphicsWidgetResource(pParent,
 new cpl::MarkerResourceType(ImfXmlHelper::Convert(QUuid::createUuid()), pParent && pParent->GetSegment() ? pParent->GetSegment()->GetDuration().GetCount() : 1),
-QSharedPointer<AssetMxfTrack>(NULL), QColor(CPL_COLOR_MARKER_RESOURCE)), mActiveMarkerOldPosition(-1, -1),
-mOldSourceDuration(-1), mOldIntrinsicDuration(-1) {
+QSharedPointer<AssetMxfTrack>(NULL), QColor(CPL_COLOR_MARKER_RESOURCE)), AbstractViewTransformNotifier(),
+mMarkers(), mMarkerOffsets(), mMaterializedMarkers(), mNextMarkerId(1), mIsMaterialized(false), mLevelOfDetailFirst(0), mLevelOfDetailLast(-1),
+mpLevelOfDetailTimer(NULL), mActiveMarkerId(0), mActiveMarkerOldOffset(-1), mOldSourceDuration(-1), mOldIntrinsicDuration(-1) {
 
 	setFlag(QGraphicsItem::ItemClipsChildrenToShape);
 	DisableTrimHandle(AbstractGraphicsWidgetResource::Left, true);
 	DisableTrimHandle(AbstractGraphicsWidgetResource::Right, true);
 	setAcceptHoverEvents(false);
+	mpLevelOfDetailTimer = new QTimer(this);
+	mpLevelOfDetailTimer->setSingleShot(true);
+	mpLevelOfDetailTimer->setInterval(0);
+	connect(mpLevelOfDetailTimer, SIGNAL(timeout()), this, SLOT(rUpdateLevelOfDetail()));
 }
 
 std::auto_ptr<cpl::BaseResourceType> GraphicsWidgetMarkerResource::Write() const {
 
 	cpl::MarkerResourceType *p_marker_resource = static_cast<cpl::MarkerResourceType*>(mpData->_clone());
 	cpl::MarkerResourceType::MarkerSequence marker_sequence;
-	QList<QGraphicsItem*> child_items = childItems();
-	for(int i = 0; i < child_items.size(); i++) {
-		GraphicsWidgetMarker *p_marker = dynamic_cast<GraphicsWidgetMarker*>(child_items.at(i));
-		if(p_marker) {
-			cpl::MarkerType marker(ImfXmlHelper::Convert(p_marker->GetMarkerLabel()), p_marker->pos().x() * ResourceErPerCompositionEr(GetCplEditRate()));
-			if(p_marker->GetAnnotation().IsEmpty() == false) marker.setAnnotation(ImfXmlHelper::Convert(p_marker->GetAnnotation()));
-			marker_sequence.push_back(marker);
-		}
+	for(int i = 0; i < mMarkers.size(); i++) {
+		cpl::MarkerType marker(ImfXmlHelper::Convert(mMarkers.at(i).label), mMarkers.at(i).offset);
+		if(mMarkers.at(i).annotation.IsEmpty() == false) marker.setAnnotation(ImfXmlHelper::Convert(mMarkers.at(i).annotation));
+		marker_sequence.push_back(marker);
 	}
 	p_marker_resource->setMarker(marker_sequence);
 	return std::auto_ptr<cpl::BaseResourceType>(p_marker_resource);
@@ -1229,9 +1285,271 @@ void GraphicsWidgetMarkerResource::InitMarker() {
 	cpl::MarkerResourceType *p_marker_resource = static_cast<cpl::MarkerResourceType*>(mpData);
 	const cpl::MarkerResourceType::MarkerSequence &r_marker_sequence = p_marker_resource->getMarker();
 	for(unsigned int i = 0; i < r_marker_sequence.size(); i++) {
-		GraphicsWidgetMarker *p_marker = new GraphicsWidgetMarker(this, 1, boundingRect().height(), ImfXmlHelper::Convert(r_marker_sequence.at(i).getLabel()), QColor(CPL_COLOR_DEFAULT_MARKER));
-		p_marker->setPos((qint64)(r_marker_sequence.at(i).getOffset() / ResourceErPerCompositionEr(GetCplEditRate())), 1);
+		UserText annotation;
+		if(r_marker_sequence.at(i).getAnnotation().present() == true) annotation = ImfXmlHelper::Convert(r_marker_sequence.at(i).getAnnotation().get());
+		AddMarker(ImfXmlHelper::Convert(r_marker_sequence.at(i).getLabel()), r_marker_sequence.at(i).getOffset(), annotation);
+	}
+}
+
+quint32 GraphicsWidgetMarkerResource::AddMarker(const MarkerLabel &rLabel, qint64 offset, const UserText &rAnnotation /*= UserText()*/, quint32 markerId /*= 0*/) {
+
+	if(markerId == 0) markerId = mNextMarkerId++;
+	else if(markerId >= mNextMarkerId) mNextMarkerId = markerId + 1;
+	MarkerEntry marker;
+	marker.id = markerId;
+	marker.label = rLabel;
+	marker.annotation = rAnnotation;
+	marker.offset = offset;
+	// Markers with equal offsets keep their insertion order.
+	const int index = LowerBound(offset + 1);
+	mMarkers.insert(index, marker);
+	mMarkerOffsets.insert(markerId, offset);
+	if(mIsMaterialized == true && scene()) {
+		const qreal x = MapFromMarkerOffset(offset);
+		if(x >= mLevelOfDetailFirst && x <= mLevelOfDetailLast) Materialize(mMarkers[index]);
+	}
+	// Too many markers might be visible now.
+	ScheduleLevelOfDetailUpdate();
+	update();
+	return markerId;
+}
+
+bool GraphicsWidgetMarkerResource::RemoveMarker(quint32 markerId) {
+
+	const int index = FindMarker(markerId);
+	if(index < 0) return false;
+	if(mActiveMarkerId == markerId) mActiveMarkerId = 0;
+	Dematerialize(mMarkers[index]);
+	mMarkers.removeAt(index);
+	mMarkerOffsets.remove(markerId);
+	ScheduleLevelOfDetailUpdate();
+	update();
+	return true;
+}
+
+void GraphicsWidgetMarkerResource::SetMarkerOffset(quint32 markerId, qint64 offset) {
+
+	const int index = FindMarker(markerId);
+	if(index < 0) return;
+	MarkerEntry marker = mMarkers.takeAt(index);
+	marker.offset = offset;
+	const int new_index = LowerBound(offset + 1);
+	mMarkers.insert(new_index, marker);
+	mMarkerOffsets.insert(markerId, offset);
+	if(marker.pItem) marker.pItem->setPos(MapFromMarkerOffset(offset), 1);
+	else if(mIsMaterialized == true && scene()) {
+		const qreal x = MapFromMarkerOffset(offset);
+		if(x >= mLevelOfDetailFirst && x <= mLevelOfDetailLast) Materialize(mMarkers[new_index]);
+	}
+	update();
+}
+
+bool GraphicsWidgetMarkerResource::GetMarker(quint32 markerId, MarkerLabel &rLabel, qint64 &rOffset, UserText &rAnnotation) const {
+
+	const int index = FindMarker(markerId);
+	if(index < 0) return false;
+	rLabel = mMarkers.at(index).label;
+	rOffset = mMarkers.at(index).offset;
+	rAnnotation = mMarkers.at(index).annotation;
+	return true;
+}
+
+quint32 GraphicsWidgetMarkerResource::GetMarkerId(const QGraphicsItem *pItem) const {
+
+	const GraphicsWidgetMarker *p_marker = dynamic_cast<const GraphicsWidgetMarker*>(pItem);
+	if(p_marker && p_marker->parentItem() == this) return p_marker->GetMarkerId();
+	return 0;
+}
+
+quint32 GraphicsWidgetMarkerResource::GetMarkerAt(qreal x, qreal tolerance) const {
+
+	int index = LowerBound(MapToMarkerOffset(x - tolerance));
+	const qint64 last_offset = MapToMarkerOffset(x + tolerance);
+	quint32 marker_id = 0;
+	qreal distance = tolerance;
+	for(; index < mMarkers.size() && mMarkers.at(index).offset <= last_offset; index++) {
+		const qreal marker_distance = qAbs(MapFromMarkerOffset(mMarkers.at(index).offset) - x);
+		if(marker_distance <= distance) {
+			distance = marker_distance;
+			marker_id = mMarkers.at(index).id;
+		}
+	}
+	return marker_id;
+}
+
+int GraphicsWidgetMarkerResource::GetMarkerCount(qreal first, qreal last) const {
+
+	if(last < first) return 0;
+	return LowerBound(MapToMarkerOffset(last) + 1) - LowerBound(MapToMarkerOffset(first));
+}
+
+qint64 GraphicsWidgetMarkerResource::MapToMarkerOffset(qreal x) const {
+
+	return (qint64)(x * ResourceErPerCompositionEr(GetCplEditRate()));
+}
+
+qreal GraphicsWidgetMarkerResource::MapFromMarkerOffset(qint64 offset) const {
+
+	return (qint64)(offset / ResourceErPerCompositionEr(GetCplEditRate()));
+}
+
+int GraphicsWidgetMarkerResource::LowerBound(qint64 offset) const {
+
+	int first = 0;
+	int count = mMarkers.size();
+	while(count > 0) {
+		const int step = count / 2;
+		if(mMarkers.at(first + step).offset < offset) {
+			first += step + 1;
+			count -= step + 1;
+		}
+		else count = step;
 	}
+	return first;
+}
+
+int GraphicsWidgetMarkerResource::FindMarker(quint32 markerId) const {
+
+	QHash<quint32, qint64>::const_iterator iter = mMarkerOffsets.constFind(markerId);
+	if(iter == mMarkerOffsets.constEnd()) return -1;
+	for(int i = LowerBound(iter.value()); i < mMarkers.size() && mMarkers.at(i).offset == iter.value(); i++) {
+		if(mMarkers.at(i).id == markerId) return i;
+	}
+	return -1;
+}
+
+void GraphicsWidgetMarkerResource::Materialize(MarkerEntry &rMarker) {
+
+	if(rMarker.pItem) return;
+	rMarker.pItem = new GraphicsWidgetMarker(this, 1, boundingRect().height(), rMarker.label, QColor(CPL_COLOR_DEFAULT_MARKER), rMarker.id);
+	rMarker.pItem->SetAnnotation(rMarker.annotation);
+	rMarker.pItem->setPos(MapFromMarkerOffset(rMarker.offset), 1);
+	mMaterializedMarkers.insert(rMarker.id);
+}
+
+void GraphicsWidgetMarkerResource::Dematerialize(MarkerEntry &rMarker) {
+
+	if(rMarker.pItem == NULL) return;
+	delete rMarker.pItem;
+	rMarker.pItem = NULL;
+	mMaterializedMarkers.remove(rMarker.id);
+}
+
+bool GraphicsWidgetMarkerResource::GetVisibleRange(qreal &rFirst, qreal &rLast) const {
+
+	QGraphicsView *p_view = GetObservableView();
+	if(p_view == NULL) return false;
+	const QRectF visible_rect = mapRectFromScene(p_view->mapToScene(p_view->viewport()->rect()).boundingRect());
+	rFirst = visible_rect.left();
+	rLast = visible_rect.right();
+	return true;
+}
+
+void GraphicsWidgetMarkerResource::ScheduleLevelOfDetailUpdate() {
+
+	// Deferred: Items must not be deleted while the view iterates them (e.g. GraphicsViewScaleable::ScaleView()).
+	if(scene() && mpLevelOfDetailTimer->isActive() == false) mpLevelOfDetailTimer->start();
+}
+
+void GraphicsWidgetMarkerResource::rUpdateLevelOfDetail() {
+
+	// The marker which is dragged must survive.
+	if(scene() == NULL || mActiveMarkerId != 0) return;
+	qreal first = boundingRect().left();
+	qreal last = boundingRect().right();
+	GetVisibleRange(first, last);
+	// Keep one viewport width on both sides so that scrolling doesn't immediately require a new update.
+	const qreal width = last - first;
+	first -= width;
+	last += width;
+	const int first_index = LowerBound(MapToMarkerOffset(first));
+	const int last_index = LowerBound(MapToMarkerOffset(last) + 1); // exclusive
+	const bool materialize = last_index - first_index <= MaxMaterializedMarkers;
+	if(mMaterializedMarkers.isEmpty() == false) {
+		for(int i = 0; i < mMarkers.size(); i++) {
+			if(mMarkers.at(i).pItem && (materialize == false || i < first_index || i >= last_index)) Dematerialize(mMarkers[i]);
+		}
+	}
+	if(materialize == true) {
+		for(int i = first_index; i < last_index; i++) Materialize(mMarkers[i]);
+	}
+	mIsMaterialized = materialize;
+	mLevelOfDetailFirst = first;
+	mLevelOfDetailLast = last;
+	update();
+}
+
+void GraphicsWidgetMarkerResource::ViewTransformEvent(const QTransform &rViewTransform) {
+
+	// Zooming changes the number of visible markers and the aggregation.
+	mLevelOfDetailFirst = 0;
+	mLevelOfDetailLast = -1;
+	ScheduleLevelOfDetailUpdate();
+}
+
+QGraphicsView* GraphicsWidgetMarkerResource::GetObservableView() const {
+
+	if(scene() && scene()->views().empty() == false) {
+		return scene()->views().first();
+	}
+	return NULL;
+}
+
+void GraphicsWidgetMarkerResource::paint(QPainter *pPainter, const QStyleOptionGraphicsItem *pOption, QWidget *pWidget /*= NULL*/) {
+
+	AbstractGraphicsWidgetResource::paint(pPainter, pOption, pWidget);
+
+	// Scrolling may have exposed an area the level of detail wasn't evaluated for.
+	qreal visible_first = 0;
+	qreal visible_last = -1;
+	if(GetVisibleRange(visible_first, visible_last) == true && (visible_first < mLevelOfDetailFirst || visible_last > mLevelOfDetailLast)) ScheduleLevelOfDetailUpdate();
+	if(mIsMaterialized == true || mMarkers.isEmpty() == true) return;
+
+	const QTransform world_transform(pPainter->worldTransform());
+	const qreal scale = world_transform.m11(); // [px per CPL edit unit]
+	if(scale <= 0) return;
+	const double factor = ResourceErPerCompositionEr(GetCplEditRate());
+	const QRectF exposed_rect(pOption->exposedRect.intersected(boundingRect()));
+	if(exposed_rect.isEmpty() == true) return;
+	const QRectF head_rect(0, 0, ClusterWidth, 20);
+	QColor color(CPL_COLOR_DEFAULT_MARKER);
+	QFont font;
+	font.setPixelSize(9);
+	QPen pen;
+	pen.setWidth(0); // cosmetic
+
+	pPainter->save();
+	// Unscaled pixels in x direction like the heads of GraphicsWidgetMarker.
+	pPainter->setWorldTransform(QTransform::fromScale(1 / scale, 1) * world_transform);
+	pPainter->setFont(font);
+	int index = LowerBound((qint64)((exposed_rect.left() - ClusterWidth / scale) * factor));
+	const qint64 last_offset = (qint64)((exposed_rect.right() + ClusterWidth / scale) * factor);
+	while(index < mMarkers.size() && mMarkers.at(index).offset <= last_offset) {
+		// Buckets are anchored to the resource. Glyphs don't jitter while scrolling.
+		const qint64 bucket = (qint64)std::floor((qint64)(mMarkers.at(index).offset / factor) * scale / ClusterWidth);
+		int count = 0;
+		for(; index < mMarkers.size() && (qint64)std::floor((qint64)(mMarkers.at(index).offset / factor) * scale / ClusterWidth) == bucket; index++) count++;
+		QRectF glyph_rect(head_rect.translated(bucket * ClusterWidth, 0));
+		glyph_rect.adjust(0, 0, -1, -1);
+		const QPointF points[5] = {
+			QPointF(glyph_rect.center().x(), glyph_rect.bottom()),
+			QPointF(glyph_rect.left(), glyph_rect.bottom() - (glyph_rect.center().x() - glyph_rect.left())),
+			glyph_rect.topLeft(),
+			glyph_rect.topRight(),
+			QPointF(glyph_rect.right(), glyph_rect.bottom() - (glyph_rect.center().x() - glyph_rect.left())),
+		};
+		const QColor glyph_color(count > 1 ? color.darker(130) : color);
+		pen.setColor(glyph_color);
+		pPainter->setPen(pen);
+		pPainter->setBrush(QBrush(glyph_color));
+		pPainter->drawPolygon(points, 5);
+		if(count > 1) {
+			pen.setColor(QColor(CPL_FONT_COLOR));
+			pPainter->setPen(pen);
+			pPainter->drawText(QRectF(glyph_rect.left(), glyph_rect.top(), glyph_rect.width(), points[1].y() - glyph_rect.top()), Qt::AlignCenter, count > 99 ? QString("99+") : QString::number(count));
+		}
+	}
+	pPainter->restore();
 }
 
 void GraphicsWidgetMarkerResource::contextMenuEvent(QGraphicsSceneContextMenuEvent *pEvent) {
@@ -1246,26 +1564,25 @@ void GraphicsWidgetMarkerResource::contextMenuEvent(QGraphicsSceneContextMenuEve
 		QAction *p_add_marker_action = sub_menu.addAction(marker.at(i));
 		p_add_marker_action->setToolTip(MarkerLabel::GetMarker(marker.at(i)).GetDescription());
 	}
-	GraphicsObjectVerticalIndicator *p_marker = NULL;
-	QList<QGraphicsItem*> items = scene()->items(pEvent->scenePos());
-	for(int i = 0; i < items.size(); i++) {
-		p_marker = dynamic_cast<GraphicsObjectVerticalIndicator*>(items.at(i));
-		if(p_marker != NULL) break;
-	}
+	// Half a marker head [CPL edit units].
+	const qreal scale = GetViewTransform().m11();
+	const qreal tolerance = scale > 0 ? ClusterWidth / 2. / scale : 0;
+	quint32 marker_id = GetMarkerAt(pEvent->pos().x(), tolerance);
+	// An aggregate glyph represents several markers. It's unclear which one should be removed.
+	if(mIsMaterialized == false && GetMarkerCount(pEvent->pos().x() - tolerance, pEvent->pos().x() + tolerance) > 1) marker_id = 0;
 	QAction *p_delete_marker_action = NULL;
-	if(p_marker != NULL) p_delete_marker_action = menu.addAction(QIcon(":/delete.png"), tr("&Remove Marker"));
+	if(marker_id != 0) p_delete_marker_action = menu.addAction(QIcon(":/delete.png"), tr("&Remove Marker"));
 	QAction *p_selected_action = menu.exec(pEvent->screenPos());
 
 	if(p_selected_action) {
 		if(p_delete_marker_action && p_selected_action == p_delete_marker_action) {
-			if(GraphicsSceneComposition* p_scene = qobject_cast<GraphicsSceneComposition*>(scene())) p_scene->DelegateCommand(new RemoveMarkerCommand(p_marker, this));
+			if(GraphicsSceneComposition* p_scene = qobject_cast<GraphicsSceneComposition*>(scene())) p_scene->DelegateCommand(new RemoveMarkerCommand(this, marker_id));
 			else qWarning() << "Couldn't delegate remove marker command.";
 		}
 		else {
 			MarkerLabel label = MarkerLabel::GetMarker(p_selected_action->text());
 			if(label.IsWellKnown()) {
-				GraphicsWidgetMarker *p_marker = new GraphicsWidgetMarker(this, 1, boundingRect().height(), label, QColor(CPL_COLOR_DEFAULT_MARKER));
-				if(GraphicsSceneComposition* p_scene = qobject_cast<GraphicsSceneComposition*>(scene())) p_scene->DelegateCommand(new AddMarkerCommand(p_marker, QPointF((qint64)(pEvent->pos().x()), 1), this));
+				if(GraphicsSceneComposition* p_scene = qobject_cast<GraphicsSceneComposition*>(scene())) p_scene->DelegateCommand(new AddMarkerCommand(this, label, MapToMarkerOffset((qint64)(pEvent->pos().x()))));
 				else qWarning() << "Couldn't delegate add marker command.";
 			}
 		}
@@ -1284,13 +1601,9 @@ void GraphicsWidgetMarkerResource::MoveMarker(GraphicsWidgetMarker *pMarker, qin
 		if(local_pos.x() > boundingRect().right()) local_pos.setX(boundingRect().right());
 		//WR
 		qint64 max_offset = local_pos.x();
-		QList<QGraphicsItem*> items = childItems();
-		for(int i = 0; i < items.size(); i++) {
-			GraphicsWidgetMarker *p_marker = dynamic_cast<GraphicsWidgetMarker*>(items.at(i));
-			if(p_marker && p_marker != pMarker) {
-				qint64 offset = p_marker->pos().x();
-				if(offset > max_offset) max_offset = offset;
-			}
+		if(mMarkers.isEmpty() == false && mMarkers.last().id != pMarker->GetMarkerId()) {
+			qint64 offset = MapFromMarkerOffset(mMarkers.last().offset);
+			if(offset > max_offset) max_offset = offset;
 		}
 		Duration new_source_duration = max_offset * samples_factor;
 		//WR
@@ -1314,28 +1627,31 @@ void GraphicsWidgetMarkerResource::MoveMarker(GraphicsWidgetMarker *pMarker, qin
 void GraphicsWidgetMarkerResource::CplEditRateChanged() {
 
 	AbstractGraphicsWidgetResource::CplEditRateChanged();
-	QList<QGraphicsItem*> items = childItems();
-	for(int i = 0; i < items.size(); i++) {
-		GraphicsWidgetMarker *p_marker = dynamic_cast<GraphicsWidgetMarker*>(items.at(i));
-		if(p_marker) {
-			p_marker->deleteLater();
-		}
+	// The offsets are given in resource edit units. Only the local positions change.
+	for(int i = 0; i < mMarkers.size(); i++) {
+		if(mMarkers.at(i).pItem) mMarkers.at(i).pItem->setPos(MapFromMarkerOffset(mMarkers.at(i).offset), 1);
 	}
-	InitMarker();
+	mLevelOfDetailFirst = 0;
+	mLevelOfDetailLast = -1;
+	ScheduleLevelOfDetailUpdate();
+	update();
 }
 
 void GraphicsWidgetMarkerResource::MarkerInUse(GraphicsWidgetMarker *pMarker, bool active) {
 
 	if(pMarker) {
 		if(active == true) {
-			mActiveMarkerOldPosition = pMarker->pos();
+			mActiveMarkerId = pMarker->GetMarkerId();
+			mActiveMarkerOldOffset = mMarkerOffsets.value(mActiveMarkerId, -1);
 			mOldSourceDuration = GetSourceDuration();
 			mOldIntrinsicDuration = GetIntrinsicDuration();
 		}
 		else {
-			if(mActiveMarkerOldPosition != pMarker->pos()) {
+			const quint32 marker_id = pMarker->GetMarkerId();
+			const qint64 new_offset = MapToMarkerOffset(pMarker->pos().x());
+			if(marker_id == mActiveMarkerId && mActiveMarkerOldOffset != new_offset) {
 				QUndoCommand *p_root = new QUndoCommand(NULL);
-				new MoveMarkerCommand(pMarker, pMarker->pos(), mActiveMarkerOldPosition, p_root);
+				new MoveMarkerCommand(this, marker_id, new_offset, mActiveMarkerOldOffset, p_root);
 				if(mOldSourceDuration > GetSourceDuration()) {
 					new SetSourceDurationCommand(this, mOldSourceDuration, GetSourceDuration(), p_root);
 					new SetIntrinsicDurationCommand(this, mOldIntrinsicDuration, GetIntrinsicDuration(), p_root);
@@ -1348,11 +1664,15 @@ void GraphicsWidgetMarkerResource::MarkerInUse(GraphicsWidgetMarker *pMarker, bo
 				else {
 					qWarning() << "Couldn't delegate move marker command.";
 					delete p_root;
+					SetMarkerOffset(marker_id, new_offset);
 				}
 			}
-			mActiveMarkerOldPosition = QPointF(-1, -1);
+			mActiveMarkerId = 0;
+			mActiveMarkerOldOffset = -1;
 			mOldSourceDuration = Duration(-1);
 			mOldIntrinsicDuration = Duration(-1);
+			// Updates were suppressed during the drag.
+			ScheduleLevelOfDetailUpdate();
 		}
 	}
 }
@@ -1367,11 +1687,15 @@ void GraphicsWidgetMarkerResource::SetIntrinsicDuaration(const Duration &rIntrin
 
 void GraphicsWidgetMarkerResource::resizeEvent(QGraphicsSceneResizeEvent *pEvent) {
 
-
+	// The marker lines span the resource height.
+	for(int i = 0; i < mMarkers.size(); i++) {
+		if(mMarkers.at(i).pItem) mMarkers.at(i).pItem->SetHeight(pEvent->newSize().height());
+	}
+	ScheduleLevelOfDetailUpdate();
 }
 
-GraphicsWidgetMarkerResource::GraphicsWidgetMarker::GraphicsWidgetMarker(GraphicsWidgetMarkerResource *pParent, qreal width, qreal height, const MarkerLabel &rLabel, const QColor &rColor) :
-GraphicsObjectVerticalIndicator(width, height, rColor, pParent), mAnnotation(), mLabel(rLabel) {
+GraphicsWidgetMarkerResource::GraphicsWidgetMarker::GraphicsWidgetMarker(GraphicsWidgetMarkerResource *pParent, qreal width, qreal height, const MarkerLabel &rLabel, const QColor &rColor, quint32 markerId) :
+GraphicsObjectVerticalIndicator(width, height, rColor, pParent), mAnnotation(), mLabel(rLabel), mMarkerId(markerId) {
 
 	ShowHead();
 	HideLine();
@@ -18,9 +18,12 @@
 #include "ImfPackageCommon.h"
 #include "ImfPackage.h"
 #include "GraphicsViewScaleable.h"
+#include <QHash>
+#include <QSet>
 
 
 class GraphicsWidgetSequence;
+class QTimer;
 
 class AbstractGraphicsWidgetResource : public GraphicsWidgetBase {
 
@@ -266,8 +269,13 @@ private:
 };
 
 
+/*! \brief Timed text resource. Shows the cues of the track file as boxes.
+The cue index of the track file is loaded on a worker thread by TimedTextRenderCache and shared with WidgetVideoPreview.
+*/
 class GraphicsWidgetTimedTextResource : public GraphicsWidgetFileResource {
 
+	Q_OBJECT
+
 public:
 	//! Import existing Resource. pResource is owned by this.
 	GraphicsWidgetTimedTextResource(GraphicsWidgetSequence *pParent, cpl::TrackFileResourceType *pResource, const QSharedPointer<AssetMxfTrack> &rAsset = QSharedPointer<AssetMxfTrack>(NULL));
@@ -278,11 +286,16 @@ public:
 	virtual void paint(QPainter *pPainter, const QStyleOptionGraphicsItem *pOption, QWidget *pWidget = NULL);
 	virtual GraphicsWidgetTimedTextResource* Clone() const;
 
+	private slots:
+	void rDocumentLoaded(const QString &rFilePath);
+
 protected:
 	virtual double ResourceErPerCompositionEr(const EditRate &rCompositionEditRate) const;
 
 private:
 	Q_DISABLE_COPY(GraphicsWidgetTimedTextResource);
+	//! Draws the cues intersecting rVisibleRect. rResourceRect is a single repetition of the resource.
+	void PaintCues(QPainter *pPainter, const QRectF &rResourceRect, const QRectF &rVisibleRect);
 };
 
 
@@ -306,7 +319,13 @@ private:
 };
 
 
-class GraphicsWidgetMarkerResource : public AbstractGraphicsWidgetResource {
+/*! \brief Marker sequence resource.
+The markers are kept in an index sorted by offset. Only if few markers are visible (GraphicsWidgetMarkerResource::MaxMaterializedMarkers) every marker
+is represented by an own graphics item (GraphicsWidgetMarker). Otherwise the resource paints one aggregate glyph per GraphicsWidgetMarkerResource::ClusterWidth
+pixels and the number of markers it represents. The level of detail is reevaluated if the view is zoomed or scrolled.
+Markers are addressed by Ids which stay valid while the graphics items are created and destroyed.
+*/
+class GraphicsWidgetMarkerResource : public AbstractGraphicsWidgetResource, public AbstractViewTransformNotifier {
 
 	Q_OBJECT
 
@@ -314,11 +333,12 @@ private:
 	class GraphicsWidgetMarker : public GraphicsObjectVerticalIndicator {
 
 	public:
-		GraphicsWidgetMarker(GraphicsWidgetMarkerResource *pParent, qreal width, qreal height, const MarkerLabel &rLabel, const QColor &rColor);
+		GraphicsWidgetMarker(GraphicsWidgetMarkerResource *pParent, qreal width, qreal height, const MarkerLabel &rLabel, const QColor &rColor, quint32 markerId);
 		virtual ~GraphicsWidgetMarker() {}
 		virtual int type() const { return GraphicsWidgetMarkerType; }
 		UserText GetAnnotation() const { return mAnnotation; }
 		MarkerLabel GetMarkerLabel() const { return mLabel; }
+		quint32 GetMarkerId() const { return mMarkerId; }
 		void SetLabel(const MarkerLabel &rLabel) { mLabel = rLabel; }
 		void SetAnnotation(const UserText &rAnnotation) { mAnnotation = rAnnotation; }
 
@@ -334,9 +354,23 @@ private:
 
 		UserText mAnnotation;
 		MarkerLabel mLabel;
+		const quint32 mMarkerId;
+	};
+
+	struct MarkerEntry {
+		MarkerEntry() : id(0), label(), annotation(), offset(0), pItem(NULL) {}
+		quint32 id;
+		MarkerLabel label;
+		UserText annotation;
+		qint64 offset; // [resource edit units]
+		GraphicsWidgetMarker *pItem; // NULL if the marker isn't materialized.
 	};
 
 public:
+	//! Markers are materialized if at most this number of markers is within three viewport widths.
+	static const int MaxMaterializedMarkers = 256;
+	//! Width of an aggregate glyph [px]. Equals the width of a marker head.
+	static const int ClusterWidth = 15;
 	//! Import existing Resource. pResource is owned by this.
 	GraphicsWidgetMarkerResource(GraphicsWidgetSequence *pParent, cpl::MarkerResourceType *pResource);
 	//! Creates new Resource.
@@ -345,21 +379,66 @@ public:
 	virtual int type() const { return GraphicsWidgetMarkerResourceType; }
 	virtual GraphicsWidgetMarkerResource* Clone() const;
 	virtual std::auto_ptr<cpl::BaseResourceType> Write() const;
+	virtual void paint(QPainter *pPainter, const QStyleOptionGraphicsItem *pOption, QWidget *pWidget = NULL);
 	void SetIntrinsicDuaration(const Duration &rIntrinsicDuration);
+	//! Adds a marker at offset [resource edit units] and returns its Id. Pass the Id of a removed marker to restore it (undo).
+	quint32 AddMarker(const MarkerLabel &rLabel, qint64 offset, const UserText &rAnnotation = UserText(), quint32 markerId = 0);
+	//! Returns false if there is no marker with this Id.
+	bool RemoveMarker(quint32 markerId);
+	void SetMarkerOffset(quint32 markerId, qint64 offset);
+	//! Returns false if there is no marker with this Id.
+	bool GetMarker(quint32 markerId, MarkerLabel &rLabel, qint64 &rOffset, UserText &rAnnotation) const;
+	//! Returns the Id of the marker represented by pItem or 0.
+	quint32 GetMarkerId(const QGraphicsItem *pItem) const;
+	//! Returns the Id of the marker next to the local position x [CPL edit units] within tolerance or 0.
+	quint32 GetMarkerAt(qreal x, qreal tolerance) const;
+	//! Number of markers within the local range [first, last] [CPL edit units].
+	int GetMarkerCount(qreal first, qreal last) const;
+	int GetMarkerCount() const { return mMarkers.size(); }
+	//! Number of markers currently represented by an own graphics item.
+	int GetMaterializedMarkerCount() const { return mMaterializedMarkers.size(); }
+	//! Maps a local x position [CPL edit units] to a marker offset [resource edit units].
+	qint64 MapToMarkerOffset(qreal x) const;
+	//! Maps a marker offset [resource edit units] to a local x position [CPL edit units].
+	qreal MapFromMarkerOffset(qint64 offset) const;
 
 protected:
 	virtual double ResourceErPerCompositionEr(const EditRate &rCompositionEditRate) const;
 	virtual void contextMenuEvent(QGraphicsSceneContextMenuEvent *pEvent);
 	virtual void CplEditRateChanged();
 	virtual void resizeEvent(QGraphicsSceneResizeEvent *pEvent);
+	virtual void ViewTransformEvent(const QTransform &rViewTransform);
+	virtual QGraphicsView* GetObservableView() const;
+
+	private slots:
+	//! Materializes the markers near the visible area or removes all marker items if there are too many.
+	void rUpdateLevelOfDetail();
 
 private:
 	Q_DISABLE_COPY(GraphicsWidgetMarkerResource);
 	void MoveMarker(GraphicsWidgetMarker *pMarker, qint64 pos, qint64 lastPos);
 	void MarkerInUse(GraphicsWidgetMarker *pMarker, bool active);
 	void InitMarker();
-
-	QPointF mActiveMarkerOldPosition;
+	//! Index of the first marker with an offset not less than offset.
+	int LowerBound(qint64 offset) const;
+	//! Returns the index of the marker or -1.
+	int FindMarker(quint32 markerId) const;
+	void Materialize(MarkerEntry &rMarker);
+	void Dematerialize(MarkerEntry &rMarker);
+	//! Returns the visible local range [CPL edit units]. Returns false if there is no view.
+	bool GetVisibleRange(qreal &rFirst, qreal &rLast) const;
+	void ScheduleLevelOfDetailUpdate();
+
+	QList<MarkerEntry> mMarkers; // Sorted by offset.
+	QHash<quint32, qint64> mMarkerOffsets; // Key: Marker Id.
+	QSet<quint32> mMaterializedMarkers;
+	quint32 mNextMarkerId;
+	bool mIsMaterialized;
+	qreal mLevelOfDetailFirst; // The level of detail is valid for this local range [CPL edit units].
+	qreal mLevelOfDetailLast;
+	QTimer *mpLevelOfDetailTimer;
+	quint32 mActiveMarkerId;
+	qint64 mActiveMarkerOldOffset;
 	Duration mOldSourceDuration;
 	Duration mOldIntrinsicDuration;
 };
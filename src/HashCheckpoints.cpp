@@ -0,0 +1,179 @@
+/* Copyright(C) 2016 Björn Stresing, Denis Manthey, Wolfgang Ruppel
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "HashCheckpoints.h"
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QDateTime>
+#include <QStandardPaths>
+#include <QCryptographicHash>
+#include <QDebug>
+#if defined(Q_OS_UNIX)
+#include <sys/types.h>
+#include <sys/stat.h>
+#endif
+
+#define HASH_CHECKPOINT_MAGIC 0x53484131 // "SHA1"
+#define HASH_CHECKPOINT_VERSION 2
+#define HASH_CHECKPOINT_MAX_AGE 30 // [days] Since the record was written.
+#define HASH_CHECKPOINT_MAX_RECORDS 4096
+
+
+namespace
+{
+	// Removes records older than HASH_CHECKPOINT_MAX_AGE days, then the oldest ones beyond HASH_CHECKPOINT_MAX_RECORDS.
+	void prune_cache_dir(const QString &rCacheDir) {
+
+		const QFileInfoList records = QDir(rCacheDir).entryInfoList(QStringList() << "*.sha1", QDir::Files, QDir::Time);
+		const QDateTime expiry = QDateTime::currentDateTime().addDays(-HASH_CHECKPOINT_MAX_AGE);
+		int removed = 0;
+		for(int i = 0; i < records.size(); i++) {
+			if(i >= HASH_CHECKPOINT_MAX_RECORDS || records.at(i).lastModified() < expiry) {
+				if(QFile::remove(records.at(i).absoluteFilePath()) == true) removed++;
+			}
+		}
+		if(removed > 0) qDebug() << "Removed" << removed << "hash checkpoints from" << rCacheDir;
+	}
+}
+
+HashCheckpoints::HashCheckpoints() :
+mMutex(), mCacheDir(QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)).absoluteFilePath("hashcheckpoints")), mCachePruned(false) {
+
+}
+
+HashCheckpoints& HashCheckpoints::Instance() {
+
+	static HashCheckpoints checkpoints;
+	return checkpoints;
+}
+
+HashCheckpoints::FileStamp HashCheckpoints::GetStamp(const QFileInfo &rFile) {
+
+	FileStamp stamp;
+	QFileInfo file(rFile.absoluteFilePath()); // Not cached.
+	if(file.exists() == false) return stamp;
+	stamp.size = file.size();
+	stamp.modified = file.lastModified().toMSecsSinceEpoch();
+	stamp.changed = file.created().toMSecsSinceEpoch();
+#if defined(Q_OS_UNIX)
+	struct stat status;
+	if(::stat(QFile::encodeName(file.absoluteFilePath()).constData(), &status) == 0) {
+		stamp.device = (quint64)status.st_dev;
+		stamp.inode = (quint64)status.st_ino;
+	}
+#endif
+	return stamp;
+}
+
+void HashCheckpoints::SetCacheDir(const QString &rCacheDir) {
+
+	QMutexLocker locker(&mMutex);
+	if(mCacheDir != rCacheDir) mCachePruned = false;
+	mCacheDir = rCacheDir;
+}
+
+QString HashCheckpoints::GetCacheDir() const {
+
+	QMutexLocker locker(&mMutex);
+	return mCacheDir;
+}
+
+QString HashCheckpoints::GetRecordPath(const QFileInfo &rFile) const {
+
+	QMutexLocker locker(&mMutex);
+	const QString name(QCryptographicHash::hash(rFile.absoluteFilePath().toUtf8(), QCryptographicHash::Sha1).toHex());
+	return QDir(mCacheDir).absoluteFilePath(name + ".sha1");
+}
+
+bool HashCheckpoints::Read(const QFileInfo &rFile, Record &rRecord) const {
+
+	QFile file(GetRecordPath(rFile));
+	if(file.open(QIODevice::ReadOnly) == false) return false;
+	QDataStream stream(&file);
+	quint32 magic = 0;
+	quint32 version = 0;
+	QString file_path;
+	stream >> magic >> version;
+	if(magic != HASH_CHECKPOINT_MAGIC || version != HASH_CHECKPOINT_VERSION) return false;
+	stream >> file_path >> rRecord.stamp.size >> rRecord.stamp.modified >> rRecord.stamp.changed >> rRecord.stamp.device >> rRecord.stamp.inode >> rRecord.digest >> rRecord.state;
+	if(stream.status() != QDataStream::Ok || file_path != rFile.absoluteFilePath()) return false;
+	// The record is stale if the file was modified or replaced.
+	return rRecord.stamp.size >= 0 && GetStamp(rFile) == rRecord.stamp;
+}
+
+void HashCheckpoints::Write(const QFileInfo &rFile, const Record &rRecord) {
+
+	const QString record_path = GetRecordPath(rFile);
+	const QString cache_dir = QFileInfo(record_path).absolutePath();
+	bool prune_cache = false;
+	{
+		QMutexLocker locker(&mMutex);
+		prune_cache = (mCachePruned == false);
+		mCachePruned = true;
+	}
+	if(prune_cache == true) prune_cache_dir(cache_dir);
+	QDir().mkpath(cache_dir);
+	QByteArray data;
+	QDataStream stream(&data, QIODevice::WriteOnly);
+	stream << (quint32)HASH_CHECKPOINT_MAGIC << (quint32)HASH_CHECKPOINT_VERSION << rFile.absoluteFilePath();
+	stream << rRecord.stamp.size << rRecord.stamp.modified << rRecord.stamp.changed << rRecord.stamp.device << rRecord.stamp.inode << rRecord.digest << rRecord.state;
+	// QSaveFile replaces the previous record atomically. A crash leaves the previous checkpoint.
+	QSaveFile file(record_path);
+	if(file.open(QIODevice::WriteOnly) == false || file.write(data) != data.size() || file.commit() == false) {
+		qWarning() << "Couldn't write hash checkpoint" << record_path;
+	}
+}
+
+QByteArray HashCheckpoints::GetDigest(const QFileInfo &rFile) const {
+
+	Record record;
+	if(Read(rFile, record) == false) return QByteArray();
+	return record.digest;
+}
+
+bool HashCheckpoints::Restore(const QFileInfo &rFile, Sha1 &rHasher) const {
+
+	Record record;
+	rHasher.Reset();
+	if(Read(rFile, record) == false || record.digest.isEmpty() == false) return false;
+	if(rHasher.RestoreState(record.state) == false || rHasher.GetLength() > record.stamp.size) {
+		rHasher.Reset();
+		return false;
+	}
+	return true;
+}
+
+void HashCheckpoints::SaveCheckpoint(const QFileInfo &rFile, const FileStamp &rStamp, const Sha1 &rHasher) {
+
+	Record record;
+	record.stamp = rStamp;
+	record.state = rHasher.SaveState();
+	Write(rFile, record);
+}
+
+void HashCheckpoints::SaveDigest(const QFileInfo &rFile, const FileStamp &rStamp, const QByteArray &rDigest) {
+
+	Record record;
+	record.stamp = rStamp;
+	record.digest = rDigest;
+	Write(rFile, record);
+}
+
+void HashCheckpoints::Remove(const QFileInfo &rFile) {
+
+	QFile::remove(GetRecordPath(rFile));
+}
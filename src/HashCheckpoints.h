@@ -0,0 +1,76 @@
+/* Copyright(C) 2016 Björn Stresing, Denis Manthey, Wolfgang Ruppel
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include "Sha1.h"
+#include <QString>
+#include <QByteArray>
+#include <QFileInfo>
+#include <QMutex>
+
+
+/*! \brief Persists the progress of SHA-1 calculations (see JobCalculateHash).
+For every hashed file a small record in the cache directory holds either the state of an in-progress hash (Sha1::SaveState(), the byte offset
+is Sha1::GetLength()) or the digest of a completed hash. Records are keyed by the absolute file path and are only used while the FileStamp of the file
+(size, modification time, status change time and inode) is the same as when hashing started. A copy that preserves the modification time gets a new inode
+and status change time. Remove() the record of a file the application rewrites, coarse time stamps may not tell the versions apart.
+Records older than HASH_CHECKPOINT_MAX_AGE days and the oldest records beyond HASH_CHECKPOINT_MAX_RECORDS are removed once per cache directory and process. Thread safe.
+*/
+class HashCheckpoints {
+
+public:
+	struct FileStamp {
+		FileStamp() : size(-1), modified(0), changed(0), device(0), inode(0) {}
+		bool operator==(const FileStamp &rOther) const { return size == rOther.size && modified == rOther.modified && changed == rOther.changed && device == rOther.device && inode == rOther.inode; }
+		bool operator!=(const FileStamp &rOther) const { return !(*this == rOther); }
+		qint64 size;
+		qint64 modified; // [ms since epoch]
+		qint64 changed; // [ms since epoch] Status change time on Unix, creation time on Windows.
+		quint64 device; // 0 on Windows.
+		quint64 inode; // 0 on Windows.
+	};
+	static HashCheckpoints& Instance();
+	//! Captures the stamp of rFile. Returns a stamp with size -1 if the file doesn't exist.
+	static FileStamp GetStamp(const QFileInfo &rFile);
+	//! Defaults to <cache location>/hashcheckpoints.
+	void SetCacheDir(const QString &rCacheDir);
+	QString GetCacheDir() const;
+	//! Returns the digest of a completed hash of rFile. Returns an empty array if there is none or the file changed since.
+	QByteArray GetDigest(const QFileInfo &rFile) const;
+	//! Restores rHasher to the last checkpoint of rFile. Continue reading at rHasher.GetLength(). Returns false and resets rHasher if there is no valid checkpoint.
+	bool Restore(const QFileInfo &rFile, Sha1 &rHasher) const;
+	//! rStamp must be the stamp of rFile when hashing started. A file changed since then is never matched.
+	void SaveCheckpoint(const QFileInfo &rFile, const FileStamp &rStamp, const Sha1 &rHasher);
+	//! Replaces the checkpoint with the digest of the completed hash. See SaveCheckpoint() for rStamp.
+	void SaveDigest(const QFileInfo &rFile, const FileStamp &rStamp, const QByteArray &rDigest);
+	void Remove(const QFileInfo &rFile);
+
+private:
+	HashCheckpoints();
+	Q_DISABLE_COPY(HashCheckpoints);
+	struct Record {
+		Record() : stamp(), digest(), state() {}
+		FileStamp stamp;
+		QByteArray digest; // Empty if the hash isn't completed.
+		QByteArray state;
+	};
+	QString GetRecordPath(const QFileInfo &rFile) const;
+	bool Read(const QFileInfo &rFile, Record &rRecord) const;
+	void Write(const QFileInfo &rFile, const Record &rRecord);
+
+	mutable QMutex mMutex;
+	QString mCacheDir;
+	bool mCachePruned;
+};
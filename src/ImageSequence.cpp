@@ -0,0 +1,238 @@
+/* Copyright(C) 2016 Björn Stresing, Denis Manthey, Wolfgang Ruppel
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "ImageSequence.h"
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QFile>
+#include <QVector>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QAtomicInt>
+#include <QMutexLocker>
+#include <algorithm>
+
+#define IMAGE_SEQUENCE_VALIDATION_CHUNK 32 // Frames per validation task.
+
+
+namespace
+{
+	struct SequenceFrame {
+
+		QString prefix;
+		qint64 number;
+		QString filePath;
+	};
+
+	bool frame_less_than(const SequenceFrame &rLeft, const SequenceFrame &rRight) {
+
+		if(rLeft.prefix != rRight.prefix) return rLeft.prefix < rRight.prefix;
+		return rLeft.number < rRight.number;
+	}
+
+	//! Splits "shot_000123.exr" into prefix "shot_" and number 123. number is -1 if there are no digits.
+	SequenceFrame split_frame_name(const QString &rFilePath) {
+
+		SequenceFrame frame;
+		frame.filePath = rFilePath;
+		const QString base_name = QFileInfo(rFilePath).completeBaseName();
+		int digits_start = base_name.size();
+		while(digits_start > 0 && base_name.at(digits_start - 1).isDigit()) digits_start--;
+		frame.prefix = base_name.left(digits_start);
+		frame.number = (digits_start < base_name.size() ? base_name.mid(digits_start).toLongLong() : -1);
+		return frame;
+	}
+}
+
+Error ImageSequence::Scan(const QStringList &rSources, const QString &rSuffix, QStringList &rFrames) {
+
+	QVector<SequenceFrame> frames;
+	for(int i = 0; i < rSources.size(); i++) {
+		QFileInfo source(rSources.at(i));
+		if(source.isDir() == true) {
+			// QDirIterator doesn't stat the entries. QDir::entryList() would.
+			QDirIterator iterator(source.absoluteFilePath(), QStringList() << QString("*.%1").arg(rSuffix), QDir::Files | QDir::NoDotAndDotDot);
+			while(iterator.hasNext()) frames << split_frame_name(iterator.next());
+		}
+		else if(source.suffix().compare(rSuffix, Qt::CaseInsensitive) == 0) {
+			if(source.exists() == false) return Error(Error::SourceFileOpenError, source.absoluteFilePath());
+			frames << split_frame_name(source.absoluteFilePath());
+		}
+	}
+	rFrames.clear();
+	if(frames.isEmpty() == true) return Error(Error::SourceFilesMissing);
+	std::sort(frames.begin(), frames.end(), frame_less_than);
+	const QString prefix = frames.first().prefix;
+	for(int i = 0; i < frames.size(); i++) {
+		const SequenceFrame &r_frame = frames.at(i);
+		if(r_frame.prefix != prefix) return Error(Error::UnsupportedEssence, QObject::tr("%1 doesn't belong to sequence %2").arg(QFileInfo(r_frame.filePath).fileName()).arg(prefix));
+		if(i > 0) {
+			const qint64 previous = frames.at(i - 1).number;
+			if(r_frame.number == previous) continue; // Same file given twice.
+			if(r_frame.number != previous + 1) return Error(Error::SourceFilesMissing, QObject::tr("Frames %1 to %2 of sequence %3 are missing").arg(previous + 1).arg(r_frame.number - 1).arg(prefix));
+		}
+		rFrames << r_frame.filePath;
+	}
+	return Error();
+}
+
+class ImageSequenceValidationTask : public QRunnable {
+
+public:
+	ImageSequenceValidationTask(const ImageSequenceValidator *pValidator, const QStringList &rFrames, int first, int last, Error *pErrors, ImageSequenceFormat *pFormats, QAtomicInt *pAbort) :
+		QRunnable(), mpValidator(pValidator), mFrames(rFrames), mFirst(first), mLast(last), mpErrors(pErrors), mpFormats(pFormats), mpAbort(pAbort) {}
+	virtual ~ImageSequenceValidationTask() {}
+	virtual void run() {
+
+		for(int i = mFirst; i < mLast && mpAbort->load() == 0; i++) {
+			QFile file(mFrames.at(i));
+			if(file.open(QIODevice::ReadOnly) == false) mpErrors[i] = Error(Error::SourceFileOpenError, file.fileName());
+			else {
+				mpErrors[i] = mpValidator->ParseHeader(file, mpFormats[i]);
+				mpFormats[i].frameSize = file.size();
+				if(mpErrors[i].IsError() == true) mpErrors[i].AppendErrorDescription(QString(" (%1)").arg(QFileInfo(file).fileName()));
+			}
+			if(mpErrors[i].IsError() == true) mpAbort->store(1);
+		}
+	}
+
+private:
+	Q_DISABLE_COPY(ImageSequenceValidationTask);
+	const ImageSequenceValidator *mpValidator;
+	const QStringList &mFrames;
+	const int mFirst;
+	const int mLast;
+	Error *mpErrors;
+	ImageSequenceFormat *mpFormats;
+	QAtomicInt *mpAbort;
+};
+
+Error ImageSequenceValidator::Validate(const QStringList &rFrames, ImageSequenceFormat &rFormat, QThreadPool *pThreadPool /*= NULL*/) {
+
+	if(rFrames.isEmpty() == true) return Error(Error::SourceFilesMissing);
+	QThreadPool local_thread_pool;
+	QThreadPool *p_thread_pool = (pThreadPool ? pThreadPool : &local_thread_pool);
+	// Every task writes its own range. No locking needed.
+	QVector<Error> errors(rFrames.size());
+	QVector<ImageSequenceFormat> formats(rFrames.size());
+	QAtomicInt abort(0);
+	QList<ImageSequenceValidationTask*> tasks;
+	for(int first = 0; first < rFrames.size(); first += IMAGE_SEQUENCE_VALIDATION_CHUNK) {
+		ImageSequenceValidationTask *p_task = new ImageSequenceValidationTask(this, rFrames, first, qMin(first + IMAGE_SEQUENCE_VALIDATION_CHUNK, rFrames.size()), errors.data(), formats.data(), &abort);
+		p_task->setAutoDelete(false);
+		tasks << p_task;
+		p_thread_pool->start(p_task);
+	}
+	p_thread_pool->waitForDone();
+	qDeleteAll(tasks);
+
+	rFormat = formats.first();
+	for(int i = 0; i < rFrames.size(); i++) {
+		if(errors.at(i).IsError() == true) return errors.at(i);
+		if(formats.at(i).IsCompatible(rFormat) == false) {
+			return Error(Error::UnsupportedEssence, QObject::tr("Format of %1 differs from %2").arg(QFileInfo(rFrames.at(i)).fileName()).arg(QFileInfo(rFrames.first()).fileName()));
+		}
+		rFormat.frameSize = qMax(rFormat.frameSize, formats.at(i).frameSize);
+	}
+	return Error();
+}
+
+class ImageSequenceReadTask : public QRunnable {
+
+public:
+	ImageSequenceReadTask(ImageSequenceReadAhead *pReadAhead) : QRunnable(), mpReadAhead(pReadAhead) {}
+	virtual ~ImageSequenceReadTask() {}
+	virtual void run() { mpReadAhead->Read(); }
+
+private:
+	Q_DISABLE_COPY(ImageSequenceReadTask);
+	ImageSequenceReadAhead *mpReadAhead;
+};
+
+ImageSequenceReadAhead::ImageSequenceReadAhead(const QStringList &rFrames, int window /*= 8*/, int readerCount /*= 2*/) :
+mFrames(rFrames), mWindow(qMax(1, window)), mpThreadPool(new QThreadPool), mMutex(), mFrameRead(), mSlotFree(), mData(), mErrors(), mNextRead(0), mNextTake(0), mStop(false) {
+
+	mpThreadPool->setMaxThreadCount(qBound(1, readerCount, mWindow));
+}
+
+ImageSequenceReadAhead::~ImageSequenceReadAhead() {
+
+	Stop();
+	delete mpThreadPool;
+}
+
+void ImageSequenceReadAhead::Start() {
+
+	mMutex.lock();
+	mStop = false;
+	mMutex.unlock();
+	for(int i = 0; i < mpThreadPool->maxThreadCount(); i++) mpThreadPool->start(new ImageSequenceReadTask(this));
+}
+
+void ImageSequenceReadAhead::Stop() {
+
+	mMutex.lock();
+	mStop = true;
+	mSlotFree.wakeAll();
+	mMutex.unlock();
+	mpThreadPool->waitForDone();
+	mMutex.lock();
+	mData.clear();
+	mErrors.clear();
+	mMutex.unlock();
+}
+
+Error ImageSequenceReadAhead::Take(int frame, QByteArray &rData) {
+
+	if(frame < 0 || frame >= mFrames.size()) return Error(Error::SourceFilesMissing, QString::number(frame));
+	QMutexLocker locker(&mMutex);
+	while(mData.contains(frame) == false && mErrors.contains(frame) == false) {
+		if(mStop == true) return Error(Error::WorkerInterruptionRequest);
+		mFrameRead.wait(&mMutex);
+	}
+	Error error = mErrors.take(frame);
+	rData = mData.take(frame);
+	mNextTake = frame + 1;
+	mSlotFree.wakeAll();
+	return error;
+}
+
+void ImageSequenceReadAhead::Read() {
+
+	QMutexLocker locker(&mMutex);
+	while(mStop == false && mNextRead < mFrames.size()) {
+		if(mNextRead - mNextTake >= mWindow) {
+			mSlotFree.wait(&mMutex);
+			continue;
+		}
+		const int frame = mNextRead++;
+		locker.unlock();
+		QByteArray data;
+		Error error;
+		QFile file(mFrames.at(frame));
+		// Unbuffered. The frame is read with a single call.
+		if(file.open(QIODevice::ReadOnly | QIODevice::Unbuffered) == false) error = Error(Error::SourceFileOpenError, file.fileName());
+		else {
+			data = file.readAll();
+			if(data.size() != file.size()) error = Error(Error::SourceFileOpenError, file.fileName());
+		}
+		locker.relock();
+		if(error.IsError() == true) mErrors.insert(frame, error);
+		else mData.insert(frame, data);
+		mFrameRead.wakeAll();
+	}
+	mFrameRead.wakeAll();
+}
@@ -0,0 +1,106 @@
+/* Copyright(C) 2016 Björn Stresing, Denis Manthey, Wolfgang Ruppel
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include "Error.h"
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QWaitCondition>
+
+class QIODevice;
+class QThreadPool;
+
+
+//! Format of a single frame. All frames of a sequence must have the same format.
+struct ImageSequenceFormat {
+
+	ImageSequenceFormat() : width(0), height(0), components(), frameSize(0) {}
+	//! Compares everything but the frame size.
+	bool IsCompatible(const ImageSequenceFormat &rOther) const { return width == rOther.width && height == rOther.height && components == rOther.components; }
+
+	quint32 width;
+	quint32 height;
+	QByteArray components; // Format specific, e.g. the channel list.
+	qint64 frameSize; // [bytes] Largest frame of the sequence.
+};
+
+/*! \brief Frame sequences (one image file per frame).
+Sequences are ordered by the frame number preceding the file suffix (e.g. "shot_000123.exr"). Gaps in the numbering are errors.
+*/
+namespace ImageSequence
+{
+	/*! \brief Collects the frames of rSources.
+	Directories are enumerated (not recursive) without querying file attributes, files are taken as they are. Only files with suffix rSuffix are considered.
+	*/
+	Error Scan(const QStringList &rSources, const QString &rSuffix, QStringList &rFrames);
+}
+
+/*! \brief Checks the headers of all frames of a sequence in parallel.
+Reimplement ImageSequenceValidator::ParseHeader() for a specific file format.
+*/
+class ImageSequenceValidator {
+
+public:
+	ImageSequenceValidator() {}
+	virtual ~ImageSequenceValidator() {}
+	/*! \brief Parses the header of every frame on pThreadPool (a private thread pool if NULL). Blocks until pThreadPool is done.
+	Returns the error of the first invalid frame or an error if a frame differs from the first one. rFormat is the format of the sequence.
+	*/
+	Error Validate(const QStringList &rFrames, ImageSequenceFormat &rFormat, QThreadPool *pThreadPool = NULL);
+
+protected:
+	//! Called concurrently. rDevice is positioned at the beginning of the file.
+	virtual Error ParseHeader(QIODevice &rDevice, ImageSequenceFormat &rFormat) const = 0;
+
+private:
+	Q_DISABLE_COPY(ImageSequenceValidator);
+	friend class ImageSequenceValidationTask;
+};
+
+/*! \brief Reads the frames of a sequence ahead of the consumer.
+Reader threads fetch the next frames in order while the consumer (e.g. an MXF writer) processes the current one. At most window frames are held in memory.
+*/
+class ImageSequenceReadAhead {
+
+public:
+	ImageSequenceReadAhead(const QStringList &rFrames, int window = 8, int readerCount = 2);
+	//! Stops the readers.
+	~ImageSequenceReadAhead();
+	void Start();
+	//! Blocks until frame is read. Frames must be taken in ascending order.
+	Error Take(int frame, QByteArray &rData);
+	//! Stops the readers and waits until they are finished. Frames not taken are discarded.
+	void Stop();
+
+private:
+	Q_DISABLE_COPY(ImageSequenceReadAhead);
+	friend class ImageSequenceReadTask;
+	void Read();
+
+	const QStringList mFrames;
+	const int mWindow;
+	QThreadPool *mpThreadPool;
+	QMutex mMutex;
+	QWaitCondition mFrameRead;
+	QWaitCondition mSlotFree;
+	QHash<int, QByteArray> mData;
+	QHash<int, Error> mErrors;
+	int mNextRead;
+	int mNextTake;
+	bool mStop;
+};
@@ -89,8 +89,9 @@ QStringList SoundfieldGroup::GetAdmittedChannelNames() const {
 SoundfieldGroup SoundfieldGroup::GetSoundFieldGroup(const QString &rSoundFieldGroupName) {
 
 	SoundfieldGroup ret = SoundfieldGroup::SoundFieldGroupNone;
-	for(int i = 0; i < SoundfieldGroup::mMap.size(); i++) {
-		if(SoundfieldGroup::mMap.at(i) && rSoundFieldGroupName.compare(SoundfieldGroup::mMap.at(i)->GetName(), Qt::CaseSensitive) == 0) ret = *SoundfieldGroup::mMap.at(i);
+	const QList<const SoundfieldGroup*> &r_registry = GetRegistry();
+	for(int i = 0; i < r_registry.size(); i++) {
+		if(rSoundFieldGroupName.compare(r_registry.at(i)->GetName(), Qt::CaseSensitive) == 0) ret = *r_registry.at(i);
 	}
 	return ret;
 }
@@ -98,8 +99,9 @@ SoundfieldGroup SoundfieldGroup::GetSoundFieldGroup(const QString &rSoundFieldGr
 QStringList SoundfieldGroup::GetSoundFieldGroupNames() {
 
 	QStringList ret;
-	for(int i = 0; i < SoundfieldGroup::mMap.size(); i++) {
-		if(SoundfieldGroup::mMap.at(i)) ret.push_back(SoundfieldGroup::mMap.at(i)->GetName());
+	const QList<const SoundfieldGroup*> &r_registry = GetRegistry();
+	for(int i = 0; i < r_registry.size(); i++) {
+		ret.push_back(r_registry.at(i)->GetName());
 	}
 	return ret;
 }
@@ -133,6 +135,29 @@ bool SoundfieldGroup::operator!=(const SoundfieldGroup& rOther) const {
 	return !(*this == rOther);
 }
 
+const QList<const SoundfieldGroup*>& SoundfieldGroup::GetRegistry() {
+
+	static const QList<const SoundfieldGroup*> registry = QList<const SoundfieldGroup*>()
+		<< &SoundFieldGroupNone
+		<< &SoundFieldGroupVA
+		<< &SoundFieldGroupHA
+		<< &SoundFieldGroup51EX
+		<< &SoundFieldGroupLtRt
+		<< &SoundFieldGroup70
+		<< &SoundFieldGroup60
+		<< &SoundFieldGroup50
+		<< &SoundFieldGroup40
+		<< &SoundFieldGroup30
+		<< &SoundFieldGroupDM
+		<< &SoundFieldGroupST
+		<< &SoundFieldGroup51
+		<< &SoundFieldGroup71
+		<< &SoundFieldGroupSDS
+		<< &SoundFieldGroup61
+		<< &SoundFieldGroupM;
+	return registry;
+}
+
 SoundfieldGroup::eChannel SoundfieldGroup::GetChannelForName(const QString &rChannelName) const {
 
 	for(int i = 0; i < mChannelNamesSymbolsMap.size(); i++) {
@@ -177,7 +202,6 @@ SoundfieldGroup::eChannel SoundfieldGroup::GetChannel(int Indexes) const {
 	return static_cast<eChannel>(0x00);
 }
 
-QList<SoundfieldGroup*> SoundfieldGroup::mMap;
 // IMF
 const SoundfieldGroup SoundfieldGroup::SoundFieldGroupNone("None", "No Soundfield", 0, 0x00);
 const SoundfieldGroup SoundfieldGroup::SoundFieldGroupVA("VA", "Visual Accessibility", 1, ChannelVIN);
@@ -349,7 +373,6 @@ Duration Timecode::AsDuration(const Timecode &rOther) const {
 	return (mFramesCount - rOther.mFramesCount);
 }
 
-QList<EditRate*> EditRate::mMap;
 const EditRate EditRate::EditRate23_98(24000, 1001, "23.976");
 const EditRate EditRate::EditRate24(24, 1, "24");
 const EditRate EditRate::EditRate25(25, 1, "25");
@@ -367,20 +390,42 @@ const EditRate EditRate::EditRate120(120, 1, "120");
 const EditRate EditRate::EditRate48000(48000, 1, "48000");
 const EditRate EditRate::EditRate96000(96000, 1, "96000");
 
-EditRate::EditRate(qint32 n, qint32 d) : mNumerator(n), mDenominator(d), mName() {
+EditRate::EditRate(qint32 n, qint32 d) : mNumerator(n), mDenominator(d), mName(GetWellKnownName(n, d)) {
+
+}
+
+EditRate::EditRate(const ASDCP::Rational &rRational) : mNumerator(rRational.Numerator), mDenominator(rRational.Denominator), mName(GetWellKnownName(rRational.Numerator, rRational.Denominator)) {
 
-	for(int i = 0; i < EditRate::mMap.size(); i++) {
-		EditRate *p_edit_rate = EditRate::mMap.at(i);
-		if(p_edit_rate && p_edit_rate->mNumerator == n && p_edit_rate->mDenominator == d) mName = p_edit_rate->mName;
-	}
 }
 
-EditRate::EditRate(const ASDCP::Rational &rRational) : mNumerator(rRational.Numerator), mDenominator(rRational.Denominator), mName() {
+const QList<const EditRate*>& EditRate::GetRegistry() {
 
-	for(int i = 0; i < EditRate::mMap.size(); i++) {
-		EditRate *p_edit_rate = EditRate::mMap.at(i);
-		if(p_edit_rate && p_edit_rate->mNumerator == rRational.Numerator && p_edit_rate->mDenominator == rRational.Denominator) mName = p_edit_rate->mName;
+	static const QList<const EditRate*> registry = QList<const EditRate*>()
+		<< &EditRate23_98
+		<< &EditRate24
+		<< &EditRate25
+		<< &EditRate29_97
+		<< &EditRate30
+		<< &EditRate48
+		<< &EditRate50
+		<< &EditRate59_94
+		<< &EditRate60
+		<< &EditRate96
+		<< &EditRate100
+		<< &EditRate119_88
+		<< &EditRate120
+		<< &EditRate48000
+		<< &EditRate96000;
+	return registry;
+}
+
+QString EditRate::GetWellKnownName(qint32 n, qint32 d) {
+
+	const QList<const EditRate*> &r_registry = GetRegistry();
+	for(int i = 0; i < r_registry.size(); i++) {
+		if(r_registry.at(i)->mNumerator == n && r_registry.at(i)->mDenominator == d) return r_registry.at(i)->mName;
 	}
+	return QString();
 }
 
 bool EditRate::operator==(const EditRate& rhs) const {
@@ -410,8 +455,9 @@ bool EditRate::operator>(const EditRate& rhs) const {
 EditRate EditRate::GetEditRate(const QString &rEditRateName) {
 
 	EditRate ret;
-	for(int i = 0; i < EditRate::mMap.size(); i++) {
-		if(EditRate::mMap.at(i) && rEditRateName.compare(EditRate::mMap.at(i)->GetName(), Qt::CaseSensitive) == 0) ret = *EditRate::mMap.at(i);
+	const QList<const EditRate*> &r_registry = GetRegistry();
+	for(int i = 0; i < r_registry.size(); i++) {
+		if(rEditRateName.compare(r_registry.at(i)->GetName(), Qt::CaseSensitive) == 0) ret = *r_registry.at(i);
 	}
 	return ret;
 }
@@ -419,8 +465,9 @@ EditRate EditRate::GetEditRate(const QString &rEditRateName) {
 QStringList EditRate::GetFrameRateNames() {
 
 	QStringList ret;
-	for(int i = 0; i < EditRate::mMap.size(); i++) {
-		if(EditRate::mMap.at(i) && *EditRate::mMap.at(i) != EditRate48000 && *EditRate::mMap.at(i) != EditRate96000) ret.push_back(EditRate::mMap.at(i)->GetName());
+	const QList<const EditRate*> &r_registry = GetRegistry();
+	for(int i = 0; i < r_registry.size(); i++) {
+		if(*r_registry.at(i) != EditRate48000 && *r_registry.at(i) != EditRate96000) ret.push_back(r_registry.at(i)->GetName());
 	}
 	return ret;
 }
@@ -440,7 +487,6 @@ Duration operator*(const Duration &rOther, int i) {
 	return Duration(rOther.GetCount() * i);
 }
 
-QList<MarkerLabel*> MarkerLabel::mMap;
 const MarkerLabel MarkerLabel::MarkerLabelNone("None", "No Label", "");
 const MarkerLabel MarkerLabel::MarkerLabelFFBT("FFBT", "First Frame of Bars and Tone");
 const MarkerLabel MarkerLabel::MarkerLabelFFCB("FFCB", "First Frame of Commercial Blacks");
@@ -480,6 +526,50 @@ const MarkerLabel MarkerLabel::MarkerLabelLFCO("LFCO", "Last Frame of Candidate
 const MarkerLabel MarkerLabel::MarkerLabelFFOA("FFOA", "Audio First Frame. First frame of audio ring-in/ring-out where the video is in black.");
 const MarkerLabel MarkerLabel::MarkerLabelLFOA("LFOA", "Audio Last Frame. Last frame of audio ring-in/ring-out where the video is in black.");
 
+const QList<const MarkerLabel*>& MarkerLabel::GetRegistry() {
+
+	static const QList<const MarkerLabel*> registry = QList<const MarkerLabel*>()
+		<< &MarkerLabelNone
+		<< &MarkerLabelFFBT
+		<< &MarkerLabelFFCB
+		<< &MarkerLabelFFCL
+		<< &MarkerLabelFFDL
+		<< &MarkerLabelFFEC
+		<< &MarkerLabelFFHS
+		<< &MarkerLabelFFMC
+		<< &MarkerLabelFFOB
+		<< &MarkerLabelFFOC
+		<< &MarkerLabelFFOI
+		<< &MarkerLabelFFSP
+		<< &MarkerLabelFFTC
+		<< &MarkerLabelFFTS
+		<< &MarkerLabelFTXC
+		<< &MarkerLabelFTXE
+		<< &MarkerLabelFTXM
+		<< &MarkerLabelLFBT
+		<< &MarkerLabelLFCB
+		<< &MarkerLabelLFCL
+		<< &MarkerLabelLFDL
+		<< &MarkerLabelLFEC
+		<< &MarkerLabelLFHS
+		<< &MarkerLabelLFMC
+		<< &MarkerLabelLFOB
+		<< &MarkerLabelLFOC
+		<< &MarkerLabelLFOI
+		<< &MarkerLabelLFSP
+		<< &MarkerLabelLFTC
+		<< &MarkerLabelLFTS
+		<< &MarkerLabelLTXC
+		<< &MarkerLabelLTXE
+		<< &MarkerLabelLTXM
+		<< &MarkerLabelFPCI
+		<< &MarkerLabelFFCO
+		<< &MarkerLabelLFCO
+		<< &MarkerLabelFFOA
+		<< &MarkerLabelLFOA;
+	return registry;
+}
+
 bool MarkerLabel::IsWellKnown() const {
 
 	return mScope.compare(WELL_KNOWN_MARKER_LABEL_SCOPE) == 0 && GetMarker(this->GetLabel()).GetLabel().compare(MarkerLabel::MarkerLabelNone.GetLabel()) != 0;
@@ -488,8 +578,9 @@ bool MarkerLabel::IsWellKnown() const {
 QStringList MarkerLabel::GetMarkerLabels() {
 
 	QStringList ret;
-	for(int i = 0; i < mMap.size(); i++) {
-		ret << mMap.at(i)->GetLabel();
+	const QList<const MarkerLabel*> &r_registry = GetRegistry();
+	for(int i = 0; i < r_registry.size(); i++) {
+		ret << r_registry.at(i)->GetLabel();
 	}
 	return ret;
 }
@@ -497,8 +588,9 @@ QStringList MarkerLabel::GetMarkerLabels() {
 MarkerLabel MarkerLabel::GetMarker(const QString &rMarkerLabel) {
 
 	MarkerLabel ret = MarkerLabel::MarkerLabelNone;
-	for(int i = 0; i < mMap.size(); i++) {
-		if(rMarkerLabel.compare(mMap.at(i)->GetLabel()) == 0) return *mMap.at(i);
+	const QList<const MarkerLabel*> &r_registry = GetRegistry();
+	for(int i = 0; i < r_registry.size(); i++) {
+		if(rMarkerLabel.compare(r_registry.at(i)->GetLabel()) == 0) return *r_registry.at(i);
 	}
 	return ret;
 }
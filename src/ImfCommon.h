@@ -119,10 +119,9 @@ public:
 
 private:
 	SoundfieldGroup(const QString &rSymbol, const QString &rName, int admittedChannelCount, Channels admittedChannelSymbols) :
-		mSymbol(rSymbol), mName(rName), mAdmittedChannels(admittedChannelSymbols), mChannels(admittedChannelCount, static_cast<eChannel>(0x00)) {
-
-		SoundfieldGroup::mMap.push_back(this);
-	}
+		mSymbol(rSymbol), mName(rName), mAdmittedChannels(admittedChannelSymbols), mChannels(admittedChannelCount, static_cast<eChannel>(0x00)) {}
+	//! The well known soundfield groups. Built on first use.
+	static const QList<const SoundfieldGroup*>& GetRegistry();
 
 	QString GetChannelSymbol(eChannel channel) const;
 	QString GetChannelName(eChannel channel) const;
@@ -133,7 +132,6 @@ private:
 	QString mName;
 	Channels mAdmittedChannels;
 	QVector<eChannel> mChannels;
-	static QList<SoundfieldGroup*> mMap;
 };
 
 
@@ -196,15 +194,13 @@ public:
 	static MarkerLabel GetMarker(const QString &rMarkerLabel);
 private:
 	MarkerLabel(const QString &rLabel, const QString &rDescription) :
-		mLabel(rLabel), mDescription(rDescription), mScope(WELL_KNOWN_MARKER_LABEL_SCOPE) {
-
-		MarkerLabel::mMap.push_back(this);
-	}
+		mLabel(rLabel), mDescription(rDescription), mScope(WELL_KNOWN_MARKER_LABEL_SCOPE) {}
+	//! The well known marker labels. Built on first use.
+	static const QList<const MarkerLabel*>& GetRegistry();
 
 	QString mLabel;
 	QString mDescription;
 	QString mScope;
-	static QList<MarkerLabel*> mMap;
 };
 
 
@@ -249,15 +245,15 @@ public:
 	static QStringList GetFrameRateNames();
 
 private:
-	EditRate(qint32 n, qint32 d, const QString &rName) : mNumerator(n), mDenominator(d), mName(rName) {
-
-		EditRate::mMap.push_back(this);
-	}
+	EditRate(qint32 n, qint32 d, const QString &rName) : mNumerator(n), mDenominator(d), mName(rName) {}
+	//! The well known edit rates. Built on first use.
+	static const QList<const EditRate*>& GetRegistry();
+	//! Returns the name of a well known edit rate or an empty string.
+	static QString GetWellKnownName(qint32 n, qint32 d);
 
 	qint32									mNumerator;
 	qint32									mDenominator;
 	QString									mName;
-	static QList<EditRate*>	mMap;
 };
 
 //! Represents the number of frames or samples between two time codes (e.g.: 00:00:00:00 - 00:00:00:30 ---> Dur.: 30 frames).
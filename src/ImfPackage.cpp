@@ -18,12 +18,19 @@
 #include "SMPTE-2067-3-2013-CPL.h"
 #include "SMPTE-2067-100a-2014-OPL.h"
 #include "ImfMimeData.h"
+#include "Trace.h"
+#include "MxfReaderPool.h"
+#include "ImageSequence.h"
+#include "XmlParserPool.h"
+#include "FileStatusCache.h"
+#include "Jobs.h"
+#include "HashCheckpoints.h"
 #include <QFile>
 #include <fstream>
 #include <QThreadPool>
+#include <QProcess>
 //WR begin
-#include <xercesc/parsers/XercesDOMParser.hpp>
-#include <xercesc/framework/MemBufInputSource.hpp>
+#include<iterator>
 #include<iostream>
 #include<fstream>
 #include<string>
@@ -33,9 +40,95 @@
 //WR end
 
 
+namespace
+{
+	// Replaces the Asset List entry with the same Id or appends rEntry.
+	template<typename Sequence, typename Entry>
+	void patch_entry(Sequence &rSequence, const Entry &rEntry) {
+
+		const QUuid id = ImfXmlHelper::Convert(rEntry.getId());
+		for(typename Sequence::iterator iter = rSequence.begin(); iter != rSequence.end(); ++iter) {
+			if(ImfXmlHelper::Convert(iter->getId()) == id) {
+				*iter = rEntry;
+				return;
+			}
+		}
+		rSequence.push_back(rEntry);
+	}
+
+	// Removes the Asset List entry with Id rId. Returns true if an entry was removed.
+	template<typename Sequence>
+	bool remove_entry(Sequence &rSequence, const QUuid &rId) {
+
+		for(typename Sequence::iterator iter = rSequence.begin(); iter != rSequence.end(); ++iter) {
+			if(ImfXmlHelper::Convert(iter->getId()) == rId) {
+				rSequence.erase(iter);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	XmlSerializationError serialize_packing_list(const pkl::PackingListType &rPackingList, QByteArray &rData) {
+
+		xml_schema::NamespaceInfomap pkl_namespace;
+		pkl_namespace[""].name = XML_NAMESPACE_PKL;
+		pkl_namespace["ds"].name = XML_NAMESPACE_DS;
+		pkl_namespace["xs"].name = XML_NAMESPACE_XS;
+		std::ostringstream pkl_stream;
+		try {
+			pkl::serializePackingList(pkl_stream, rPackingList, pkl_namespace, "UTF-8", xml_schema::Flags::dont_initialize);
+		}
+		catch(xml_schema::Serialization &e) { return XmlSerializationError(e); }
+		catch(xml_schema::UnexpectedElement &e) { return XmlSerializationError(e); }
+		catch(xml_schema::NoTypeInfo &e) { return XmlSerializationError(e); }
+		catch(...) { return XmlSerializationError(XmlSerializationError::Unknown); }
+		rData = QByteArray::fromStdString(pkl_stream.str());
+		return XmlSerializationError();
+	}
+
+	XmlSerializationError serialize_asset_map(const am::AssetMapType &rAssetMap, QByteArray &rData) {
+
+		xml_schema::NamespaceInfomap am_namespace;
+		am_namespace[""].name = XML_NAMESPACE_AM;
+		am_namespace["xs"].name = XML_NAMESPACE_XS;
+		std::ostringstream am_stream;
+		try {
+			am::serializeAssetMap(am_stream, rAssetMap, am_namespace, "UTF-8", xml_schema::Flags::dont_initialize);
+		}
+		catch(xml_schema::Serialization &e) { return XmlSerializationError(e); }
+		catch(xml_schema::UnexpectedElement &e) { return XmlSerializationError(e); }
+		catch(xml_schema::NoTypeInfo &e) { return XmlSerializationError(e); }
+		catch(...) { return XmlSerializationError(XmlSerializationError::Unknown); }
+		rData = QByteArray::fromStdString(am_stream.str());
+		return XmlSerializationError();
+	}
+
+	// The content of VOLINDEX.xml never changes.
+	XmlSerializationError serialize_volume_index(QByteArray &rData) {
+
+		xml_schema::NamespaceInfomap am_namespace;
+		am_namespace[""].name = XML_NAMESPACE_AM;
+		am_namespace["xs"].name = XML_NAMESPACE_XS;
+		am::VolumeIndexType volume_index(xml_schema::PositiveInteger(1));
+		std::ostringstream volindex_stream;
+		try {
+			am::serializeVolumeIndex(volindex_stream, volume_index, am_namespace, "UTF-8", xml_schema::Flags::dont_initialize);
+		}
+		catch(xml_schema::Serialization &e) { return XmlSerializationError(e); }
+		catch(xml_schema::UnexpectedElement &e) { return XmlSerializationError(e); }
+		catch(xml_schema::NoTypeInfo &e) { return XmlSerializationError(e); }
+		catch(...) { return XmlSerializationError(XmlSerializationError::Unknown); }
+		rData = QByteArray::fromStdString(volindex_stream.str());
+		return XmlSerializationError();
+	}
+}
+
 ImfPackage::ImfPackage(const QDir &rWorkingDir) :
-QAbstractTableModel(NULL), mpAssetMap(NULL), mPackingLists(), mAssetList(), mRootDir(rWorkingDir), mIsDirty(false), mIsIngest(false) {
+QAbstractTableModel(NULL), mpAssetMap(NULL), mPackingLists(), mAssetList(), mAssetsById(), mReferencePackages(), mReferencedAssets(), mRootDir(rWorkingDir), mIsDirty(false), mIsIngest(false), mRemovedAssets(), mAssetListsCached(false), mpFileStatusCache(NULL) {
 
+	mpFileStatusCache = new FileStatusCache(this);
+	connect(mpFileStatusCache, SIGNAL(StatusChanged(const QStringList&)), this, SLOT(rFileStatusChanged(const QStringList&)));
 	mpAssetMap = new AssetMap(this, mRootDir.absoluteFilePath(ASSET_SEARCH_NAME));
 	QUuid pkl_id = QUuid::createUuid();
 	QString pkl_file_path(mRootDir.absoluteFilePath(QString("PKL_%1.xml").arg(strip_uuid(pkl_id))));
@@ -45,8 +138,10 @@ QAbstractTableModel(NULL), mpAssetMap(NULL), mPackingLists(), mAssetList(), mRoo
 }
 
 ImfPackage::ImfPackage(const QDir &rWorkingDir, const UserText &rIssuer, const UserText &rAnnotationText /*= QString()*/) :
-QAbstractTableModel(NULL), mpAssetMap(NULL), mPackingLists(), mAssetList(), mRootDir(rWorkingDir), mIsDirty(true), mIsIngest(false) {
+QAbstractTableModel(NULL), mpAssetMap(NULL), mPackingLists(), mAssetList(), mAssetsById(), mReferencePackages(), mReferencedAssets(), mRootDir(rWorkingDir), mIsDirty(true), mIsIngest(false), mRemovedAssets(), mAssetListsCached(false), mpFileStatusCache(NULL) {
 
+	mpFileStatusCache = new FileStatusCache(this);
+	connect(mpFileStatusCache, SIGNAL(StatusChanged(const QStringList&)), this, SLOT(rFileStatusChanged(const QStringList&)));
 	mpAssetMap = new AssetMap(this, mRootDir.absoluteFilePath(ASSET_SEARCH_NAME), rAnnotationText, rIssuer);
 	QUuid pkl_id = QUuid::createUuid();
 	QString pkl_file_path(mRootDir.absoluteFilePath(QString("PKL_%1.xml").arg(strip_uuid(pkl_id))));
@@ -57,6 +152,7 @@ QAbstractTableModel(NULL), mpAssetMap(NULL), mPackingLists(), mAssetList(), mRoo
 
 ImfError ImfPackage::Ingest() {
 
+	TRACE_SPAN_DETAIL("ImfPackage::Ingest", "package", mRootDir.absolutePath());
 	mIsIngest = true;
 	// see SMPTE ST 429-9:2014 Annex A Basic Map Profile v2
 	ImfError error; // Reset last error.
@@ -75,7 +171,10 @@ ImfError ImfPackage::Ingest() {
 			mPackingLists.clear();
 			beginResetModel();
 			mAssetList.clear(); // dismiss all Assets
+			mAssetsById.clear();
 			endResetModel();
+			mRemovedAssets.clear();
+			mAssetListsCached = false; // The first outgest regenerates all Asset List entries.
 			error = ParseAssetMap(mRootDir.absoluteFilePath(ASSET_SEARCH_NAME));
 		}
 		else {
@@ -104,106 +203,141 @@ ImfError ImfPackage::Ingest() {
 
 ImfError ImfPackage::Outgest() {
 
+	TRACE_SPAN_DETAIL("ImfPackage::Outgest", "package", mRootDir.absolutePath());
 	ImfError error; // Reset last error.
 	XmlSerializationError serialization_error;
-	// namespace maps
-	xml_schema::NamespaceInfomap am_namespace;
-	am_namespace[""].name = XML_NAMESPACE_AM;
-	am_namespace["xs"].name = XML_NAMESPACE_XS;
-
-	xml_schema::NamespaceInfomap pkl_namespace;
-	pkl_namespace[""].name = XML_NAMESPACE_PKL;
-	pkl_namespace["ds"].name = XML_NAMESPACE_DS;
-	pkl_namespace["xs"].name = XML_NAMESPACE_XS;
 
-	QUuid pkl_id = QUuid::createUuid();
-	QString pkl_file_path(mRootDir.absoluteFilePath(QString("PKL_%1.xml").arg(strip_uuid(pkl_id))));
-
+	// Collect the Assets whose entries changed since the last outgest. Without cached Asset Lists every entry is regenerated.
+	QList<QSharedPointer<Asset> > changed_assets;
+	for(int i = 0; i < mAssetList.size(); i++) {
+		if(mAssetList.at(i)->GetType() != Asset::pkl && (mAssetListsCached == false || mAssetList.at(i)->NeedsOutgest())) changed_assets.push_back(mAssetList.at(i));
+	}
+	bool files_missing = (mpAssetMap && mpAssetMap->Exists() == false) || mRootDir.exists(VOLINDEX_SEARCH_NAME) == false;
 	for(int i = 0; i < mPackingLists.size(); i++) {
-		if(mPackingLists.at(i)) {
-
-			pkl::PackingListType packing_list(mPackingLists.at(i)->Write());
-			packing_list.setAssetList(pkl::PackingListType_AssetListType());
-			packing_list.getAssetList().setAsset(pkl::PackingListType_AssetListType::AssetSequence());
-			for(int ii = 0; ii < mAssetList.size(); ii++) {
-				// Pkl Asset must not be written in Packing List
-				if(mAssetList.at(ii)->GetType() != Asset::pkl) {
-					if(mAssetList.at(ii)->Exists()) {
-						if(mAssetList.at(ii)->GetPklId() == mPackingLists.at(i)->GetId()) {
-							packing_list.getAssetList().getAsset().push_back(*mAssetList.at(ii)->WritePkl().get());
-						}
-					}
-					else qWarning() << "Asset doesn't exist on file system. Asset will not be written into Asset.";
-				}
-			}
-			// Write Packing List
-			packing_list.setId(ImfXmlHelper::Convert(pkl_id));
+		if(mPackingLists.at(i) && mPackingLists.at(i)->Exists() == false) files_missing = true;
+	}
+	if(mAssetListsCached == true && changed_assets.isEmpty() && mRemovedAssets.isEmpty() && files_missing == false) {
+		qDebug() << "Outgest: Package is unchanged.";
+		bool old_dirty = mIsDirty;
+		mIsDirty = false;
+		if(old_dirty != false) emit DirtyChanged(false);
+		return error;
+	}
 
-			std::ofstream pkl_ofs(mPackingLists.at(i)->GetFilePath().absoluteFilePath().toStdString().c_str(), std::ofstream::out);
-			try {
-				pkl::serializePackingList(pkl_ofs, packing_list, pkl_namespace, "UTF-8", xml_schema::Flags::dont_initialize);
+	PackageTransaction transaction;
+	// Staged content (e.g. CPLs) is committed before the Packing Lists that list its hash.
+	for(int i = 0; i < changed_assets.size() && error.IsError() == false; i++) {
+		if(changed_assets.at(i)->HasStagedContent() == true) error = transaction.Stage(changed_assets.at(i)->GetPath().absoluteFilePath(), changed_assets.at(i)->mStagedContent);
+	}
+	// Packing Lists
+	QList<int> new_packing_list_indexes;
+	QList<QUuid> new_packing_list_ids;
+	QList<QSharedPointer<pkl::PackingListType> > new_packing_lists;
+	for(int i = 0; i < mPackingLists.size() && error.IsError() == false; i++) {
+		PackingList *p_packing_list = mPackingLists.at(i);
+		if(p_packing_list == NULL) continue;
+		QSharedPointer<pkl::PackingListType> packing_list(new pkl::PackingListType(p_packing_list->Write()));
+		pkl::PackingListType_AssetListType::AssetSequence &r_assets = packing_list->getAssetList().getAsset();
+		bool packing_list_changed = (mAssetListsCached == false || p_packing_list->Exists() == false);
+		for(QSet<QUuid>::const_iterator iter = mRemovedAssets.constBegin(); iter != mRemovedAssets.constEnd(); ++iter) {
+			if(remove_entry(r_assets, *iter) == true) packing_list_changed = true;
+		}
+		for(int ii = 0; ii < changed_assets.size(); ii++) {
+			// Pkl Asset must not be written in Packing List
+			if(changed_assets.at(ii)->GetPklId() != p_packing_list->GetId()) continue;
+			packing_list_changed = true;
+			if(changed_assets.at(ii)->HasContent() && changed_assets.at(ii)->WritePkl().get()) {
+				if(mAssetListsCached == true) patch_entry(r_assets, *changed_assets.at(ii)->WritePkl().get());
+				else r_assets.push_back(*changed_assets.at(ii)->WritePkl().get());
 			}
-			catch(xml_schema::Serialization &e) { serialization_error = XmlSerializationError(e); }
-			catch(xml_schema::UnexpectedElement &e) { serialization_error = XmlSerializationError(e); }
-			catch(xml_schema::NoTypeInfo &e) { serialization_error = XmlSerializationError(e); }
-			catch(...) { serialization_error = XmlSerializationError(XmlSerializationError::Unknown); }
-			pkl_ofs.close();
-			if(serialization_error.IsError() == false) {
-				if(QSharedPointer<Asset> pkl_asset = GetAsset(mPackingLists.at(i)->GetId())) {
-					pkl_asset->FileModified();
-				}
+			else {
+				remove_entry(r_assets, changed_assets.at(ii)->GetId());
+				qWarning() << "Asset doesn't exist on file system. Asset will not be written into Packing List.";
 			}
-			else break;
 		}
+		if(packing_list_changed == false) continue;
+
+		// Every modified Packing List gets a new Id and file name. The old file is removed after ASSETMAP.xml was replaced.
+		QUuid pkl_id = QUuid::createUuid();
+		QString pkl_file_path(mRootDir.absoluteFilePath(QString("PKL_%1.xml").arg(strip_uuid(pkl_id))));
+		packing_list->setId(ImfXmlHelper::Convert(pkl_id));
+		QByteArray pkl_data;
+		serialization_error = serialize_packing_list(*packing_list, pkl_data);
+		if(serialization_error.IsError() == true) break;
+		error = transaction.Stage(pkl_file_path, pkl_data);
+		if(error.IsError() == true) break;
+		transaction.RemoveOnCommit(p_packing_list->GetFilePath().absoluteFilePath());
+		new_packing_list_indexes.push_back(i);
+		new_packing_list_ids.push_back(pkl_id);
+		new_packing_lists.push_back(packing_list);
 	}
-
-	QString old_pkl_file_path;
-	for(int i = 0; i < mPackingLists.size(); i++){
-		old_pkl_file_path = mPackingLists.at(i)->GetFilePath().absoluteFilePath();
-		RemoveAsset(mPackingLists.at(i)->GetId());
-	}
-	QFile::rename(old_pkl_file_path, pkl_file_path);
-	QSharedPointer<AssetPkl> pkl_asset(new AssetPkl(pkl_file_path, pkl_id));
-	mPackingLists.clear();
-	mPackingLists.push_back(new PackingList(this, pkl_file_path, pkl_id));
-	AddAsset(pkl_asset, QUuid());
-
-	if(serialization_error.IsError() == false) {
-		// Write VOLINDEX.xml
-		am::VolumeIndexType volume_index(xml_schema::PositiveInteger(1));
-		std::ofstream volindex_ofs(mRootDir.absoluteFilePath(VOLINDEX_SEARCH_NAME).toStdString().c_str(), std::ofstream::out);
-		try {
-			am::serializeVolumeIndex(volindex_ofs, volume_index, am_namespace, "UTF-8", xml_schema::Flags::dont_initialize);
-		}
-		catch(xml_schema::Serialization &e) { serialization_error = XmlSerializationError(e); }
-		catch(xml_schema::UnexpectedElement &e) { serialization_error = XmlSerializationError(e); }
-		catch(xml_schema::NoTypeInfo &e) { serialization_error = XmlSerializationError(e); }
-		catch(...) { serialization_error = XmlSerializationError(XmlSerializationError::Unknown); }
-		volindex_ofs.close();
+
+	if(serialization_error.IsError() == false && error.IsError() == false && mRootDir.exists(VOLINDEX_SEARCH_NAME) == false) {
+		// Write VOLINDEX.xml. Its content never changes.
+		QByteArray volindex_data;
+		serialization_error = serialize_volume_index(volindex_data);
+		if(serialization_error.IsError() == false) error = transaction.Stage(mRootDir.absoluteFilePath(VOLINDEX_SEARCH_NAME), volindex_data);
 	}
 
-	if(serialization_error.IsError() == false) {
-		if(mpAssetMap) {
-			am::AssetMapType asset_map(mpAssetMap->Write());
-			asset_map.setAssetList(am::AssetMapType_AssetListType());
-			asset_map.getAssetList().setAsset(am::AssetMapType_AssetListType::AssetSequence());
-			for(int i = 0; i < mAssetList.size(); i++) {
-				if(mAssetList.at(i)->Exists()) asset_map.getAssetList().getAsset().push_back(mAssetList.at(i)->WriteAm());
-				else qWarning() << "Asset doesn't exist on file system. Asset will not be written into Packing List.";
+	QSharedPointer<am::AssetMapType> asset_map;
+	if(serialization_error.IsError() == false && error.IsError() == false && mpAssetMap) {
+		asset_map = QSharedPointer<am::AssetMapType>(new am::AssetMapType(mpAssetMap->Write()));
+		am::AssetMapType_AssetListType::AssetSequence &r_assets = asset_map->getAssetList().getAsset();
+		for(QSet<QUuid>::const_iterator iter = mRemovedAssets.constBegin(); iter != mRemovedAssets.constEnd(); ++iter) {
+			remove_entry(r_assets, *iter);
+		}
+		for(int i = 0; i < changed_assets.size(); i++) {
+			if(changed_assets.at(i)->HasContent()) {
+				if(mAssetListsCached == true) patch_entry(r_assets, changed_assets.at(i)->WriteAm());
+				else r_assets.push_back(changed_assets.at(i)->WriteAm());
 			}
-
-			// Write ASSETMAP.xml
-			mpAssetMap->SetId();	//Generates new UUID for AM everytime the AM is written
-			std::ofstream am_ofs(mpAssetMap->GetFilePath().absoluteFilePath().toStdString().c_str(), std::ofstream::out);
-			try {
-				am::serializeAssetMap(am_ofs, asset_map, am_namespace, "UTF-8", xml_schema::Flags::dont_initialize);
+			else {
+				remove_entry(r_assets, changed_assets.at(i)->GetId());
+				qWarning() << "Asset doesn't exist on file system. Asset will not be written into Asset Map.";
 			}
-			catch(xml_schema::Serialization &e) { serialization_error = XmlSerializationError(e); }
-			catch(xml_schema::UnexpectedElement &e) { serialization_error = XmlSerializationError(e); }
-			catch(xml_schema::NoTypeInfo &e) { serialization_error = XmlSerializationError(e); }
-			catch(...) { serialization_error = XmlSerializationError(XmlSerializationError::Unknown); }
-			am_ofs.close();
 		}
+		for(int i = 0; i < new_packing_lists.size(); i++) {
+			remove_entry(r_assets, mPackingLists.at(new_packing_list_indexes.at(i))->GetId());
+			QString pkl_file_path(mRootDir.absoluteFilePath(QString("PKL_%1.xml").arg(strip_uuid(new_packing_list_ids.at(i)))));
+			am::AssetType pkl_entry(ImfXmlHelper::Convert(new_packing_list_ids.at(i)), am::AssetType_ChunkListType());
+			pkl_entry.setPackingList(xml_schema::Boolean(true));
+			pkl_entry.getChunkList().getChunk().push_back(am::ChunkType(xml_schema::Uri(mRootDir.relativeFilePath(pkl_file_path).toStdString())));
+			r_assets.push_back(pkl_entry);
+		}
+		asset_map->setId(ImfXmlHelper::Convert(QUuid::createUuid())); //Generates new UUID for AM everytime the AM is written
+
+		// Write ASSETMAP.xml. This is the last file of the transaction. Replacing it makes the new package state visible.
+		QByteArray am_data;
+		serialization_error = serialize_asset_map(*asset_map, am_data);
+		if(serialization_error.IsError() == false) error = transaction.Stage(mpAssetMap->GetFilePath().absoluteFilePath(), am_data);
+	}
+
+	if(serialization_error.IsError() == false && error.IsError() == false) error = transaction.Commit();
+	else transaction.Rollback();
+
+	if(serialization_error.IsError() == false && error.IsError() == false) {
+		// The files are written. Adopt the new state.
+		for(int i = 0; i < new_packing_lists.size(); i++) {
+			PackingList *p_packing_list = mPackingLists.at(new_packing_list_indexes.at(i));
+			QString pkl_file_path(mRootDir.absoluteFilePath(QString("PKL_%1.xml").arg(strip_uuid(new_packing_list_ids.at(i)))));
+			RemoveAsset(p_packing_list->GetId());
+			p_packing_list->mData = *new_packing_lists.at(i);
+			p_packing_list->mFilePath = QFileInfo(pkl_file_path);
+			AddAsset(QSharedPointer<AssetPkl>(new AssetPkl(pkl_file_path, new_packing_list_ids.at(i))), QUuid());
+		}
+		if(mpAssetMap && asset_map) mpAssetMap->mData = *asset_map;
+		for(int i = 0; i < changed_assets.size(); i++) {
+			if(changed_assets.at(i)->HasStagedContent() == false) continue;
+			changed_assets.at(i)->mStagedContent.clear();
+			changed_assets.at(i)->mContentStaged = false;
+			changed_assets.at(i)->mFilePath.refresh();
+			mpFileStatusCache->Refresh(changed_assets.at(i)->GetPath().absoluteFilePath()); // Written by us. Not an external modification.
+		}
+		for(int i = 0; i < changed_assets.size(); i++) {
+			if(changed_assets.at(i)->Exists()) changed_assets.at(i)->mNeedsOutgest = false;
+		}
+		mRemovedAssets.clear();
+		mAssetListsCached = true;
 	}
 
 	if(serialization_error.IsError() == true) error = ImfError(serialization_error);
@@ -216,25 +350,118 @@ ImfError ImfPackage::Outgest() {
 	return error;
 }
 
+JobExportPackage* ImfPackage::CreateExportJob(const QDir &rTargetDir, const QSet<QUuid> &rBaseAssetIds, ImfError &rError) {
+
+	rError = ImfError();
+	RescanFiles(); // An Asset file rewritten in place makes the package dirty.
+	if(mIsDirty == true) {
+		rError = ImfError(ImfError::PackageUnsaved, tr("Save the package before exporting it."));
+		return NULL;
+	}
+	if(mpAssetMap == NULL || mpAssetMap->Exists() == false) {
+		rError = ImfError(ImfError::NoAssetMapFound);
+		return NULL;
+	}
+	const QDir target_dir(rTargetDir.absolutePath());
+	if(target_dir == mRootDir || target_dir.exists(ASSET_SEARCH_NAME) == true) {
+		rError = ImfError(ImfError::DestinationFileWrite, tr("%1 already contains a package.").arg(target_dir.absolutePath()));
+		return NULL;
+	}
+
+	PackingList *p_template = NULL;
+	for(int i = 0; i < mPackingLists.size() && p_template == NULL; i++) p_template = mPackingLists.at(i);
+	if(p_template == NULL) {
+		rError = ImfError(ImfError::NoPackingListFound);
+		return NULL;
+	}
+
+	// Chunk paths are relative to the directory of the Asset Map. The exported package keeps this layout.
+	const QDir source_dir = mpAssetMap->GetFilePath().absoluteDir();
+	const QUuid pkl_id = QUuid::createUuid();
+	const QString pkl_file_name(QString("PKL_%1.xml").arg(strip_uuid(pkl_id)));
+	QSharedPointer<am::AssetMapType> asset_map(new am::AssetMapType(mpAssetMap->Write()));
+	asset_map->setId(ImfXmlHelper::Convert(QUuid::createUuid()));
+	am::AssetMapType_AssetListType::AssetSequence &r_am_assets = asset_map->getAssetList().getAsset();
+	r_am_assets.clear();
+	QSharedPointer<pkl::PackingListType> packing_list(new pkl::PackingListType(p_template->Write()));
+	packing_list->setId(ImfXmlHelper::Convert(pkl_id));
+	pkl::PackingListType_AssetListType::AssetSequence &r_pkl_assets = packing_list->getAssetList().getAsset();
+	r_pkl_assets.clear();
+
+	JobExportPackage *p_job = new JobExportPackage(target_dir.absolutePath());
+	for(int i = 0; i < mAssetList.size(); i++) {
+		QSharedPointer<Asset> asset = mAssetList.at(i);
+		if(asset->GetType() == Asset::pkl) continue;
+		if(rBaseAssetIds.contains(asset->GetId()) == true) continue; // Referenced by Id in the base package.
+		if(asset->Exists() == false) {
+			rError = ImfError(ImfError::AssetFileMissing, asset->GetPath().absoluteFilePath());
+			break;
+		}
+		if(asset->NeedsNewHash() == true || asset->WritePkl().get() == NULL) {
+			rError = ImfError(ImfError::PackageUnsaved, tr("The hash of %1 isn't calculated yet. Save the package before exporting it.").arg(asset->GetPath().fileName()));
+			break;
+		}
+		QString relative_path = source_dir.relativeFilePath(asset->GetPath().absoluteFilePath());
+		if(relative_path.startsWith("..") == true) relative_path = asset->GetPath().fileName(); // Assets outside the package directory are placed in the root directory.
+		am::AssetType am_entry(asset->WriteAm());
+		am_entry.setChunkList(am::AssetType_ChunkListType());
+		am_entry.getChunkList().getChunk().push_back(am::ChunkType(xml_schema::Uri(relative_path.toStdString())));
+		r_am_assets.push_back(am_entry);
+		// The Packing List entry carries the known hash and size forward.
+		r_pkl_assets.push_back(*asset->WritePkl().get());
+		p_job->AddFile(asset->GetPath().absoluteFilePath(), target_dir.absoluteFilePath(relative_path));
+	}
+	if(rError.IsError() == false && r_pkl_assets.empty() == true) rError = ImfError(ImfError::NothingToExport);
+
+	am::AssetType pkl_entry(ImfXmlHelper::Convert(pkl_id), am::AssetType_ChunkListType());
+	pkl_entry.setPackingList(xml_schema::Boolean(true));
+	pkl_entry.getChunkList().getChunk().push_back(am::ChunkType(xml_schema::Uri(pkl_file_name.toStdString())));
+	r_am_assets.push_back(pkl_entry);
+
+	QByteArray pkl_data;
+	QByteArray volindex_data;
+	QByteArray am_data;
+	XmlSerializationError serialization_error;
+	if(rError.IsError() == false) serialization_error = serialize_packing_list(*packing_list, pkl_data);
+	if(rError.IsError() == false && serialization_error.IsError() == false) serialization_error = serialize_volume_index(volindex_data);
+	if(rError.IsError() == false && serialization_error.IsError() == false) serialization_error = serialize_asset_map(*asset_map, am_data);
+	if(serialization_error.IsError() == true) rError = ImfError(serialization_error);
+	if(rError.IsError() == true) {
+		delete p_job;
+		return NULL;
+	}
+	// ASSETMAP.xml is added last. It makes the exported package visible.
+	p_job->AddDocument(target_dir.absoluteFilePath(pkl_file_name), pkl_data);
+	p_job->AddDocument(target_dir.absoluteFilePath(VOLINDEX_SEARCH_NAME), volindex_data);
+	p_job->AddDocument(target_dir.absoluteFilePath(ASSET_SEARCH_NAME), am_data);
+	return p_job;
+}
+
 ImfError ImfPackage::ParseAssetMap(const QFileInfo &rAssetMapFilePath) {
 
+	TRACE_SPAN_DETAIL("ImfPackage::ParseAssetMap", "xml", rAssetMapFilePath.fileName());
 	ImfError error;
 	XmlParsingError parse_error;
 	// ---Parse Asset Map---
 	std::auto_ptr<am::AssetMapType> asset_map;
-	try {
-		asset_map = am::parseAssetMap(rAssetMapFilePath.absoluteFilePath().toStdString(), xml_schema::Flags::dont_validate | xml_schema::Flags::dont_initialize);
-	}
-	catch(const xml_schema::Parsing &e) { parse_error = XmlParsingError(e); }
-	catch(const xml_schema::ExpectedElement &e) { parse_error = XmlParsingError(e); }
-	catch(const xml_schema::UnexpectedElement &e) { parse_error = XmlParsingError(e); }
-	catch(const xml_schema::ExpectedAttribute &e) { parse_error = XmlParsingError(e); }
-	catch(const xml_schema::UnexpectedEnumerator &e) { parse_error = XmlParsingError(e); }
-	catch(const xml_schema::ExpectedTextContent &e) { parse_error = XmlParsingError(e); }
-	catch(const xml_schema::NoTypeInfo &e) { parse_error = XmlParsingError(e); }
-	catch(const xml_schema::NotDerived &e) { parse_error = XmlParsingError(e); }
-	catch(const xml_schema::NoPrefixMapping &e) { parse_error = XmlParsingError(e); }
-	catch(...) { parse_error = XmlParsingError(XmlParsingError::Unknown); }
+	Error dom_error;
+	xml_schema::dom::auto_ptr<xercesc::DOMDocument> asset_map_document(XmlParserPool::Instance().Parse(rAssetMapFilePath.absoluteFilePath(), dom_error));
+	if(dom_error.IsError() == true) parse_error = XmlParsingError(XmlParsingError::Parsing, dom_error.GetErrorDescription());
+	else {
+		try {
+			asset_map = am::parseAssetMap(*asset_map_document, xml_schema::Flags::dont_initialize);
+		}
+		catch(const xml_schema::Parsing &e) { parse_error = XmlParsingError(e); }
+		catch(const xml_schema::ExpectedElement &e) { parse_error = XmlParsingError(e); }
+		catch(const xml_schema::UnexpectedElement &e) { parse_error = XmlParsingError(e); }
+		catch(const xml_schema::ExpectedAttribute &e) { parse_error = XmlParsingError(e); }
+		catch(const xml_schema::UnexpectedEnumerator &e) { parse_error = XmlParsingError(e); }
+		catch(const xml_schema::ExpectedTextContent &e) { parse_error = XmlParsingError(e); }
+		catch(const xml_schema::NoTypeInfo &e) { parse_error = XmlParsingError(e); }
+		catch(const xml_schema::NotDerived &e) { parse_error = XmlParsingError(e); }
+		catch(const xml_schema::NoPrefixMapping &e) { parse_error = XmlParsingError(e); }
+		catch(...) { parse_error = XmlParsingError(XmlParsingError::Unknown); }
+	}
 
 	if(parse_error.IsError() == false) {
 		// XML parsing succeeds.
@@ -251,19 +478,24 @@ ImfError ImfPackage::ParseAssetMap(const QFileInfo &rAssetMapFilePath) {
 						if(packing_list_path.exists() == true) {
 							// ---Parse Packing List---
 							std::auto_ptr<pkl::PackingListType> packing_list;
-							try {
-								packing_list = (pkl::parsePackingList(QDir::toNativeSeparators(packing_list_path.absoluteFilePath()).toStdString(), xml_schema::Flags::dont_validate | xml_schema::Flags::dont_initialize));
+							Error pkl_dom_error;
+							xml_schema::dom::auto_ptr<xercesc::DOMDocument> packing_list_document(XmlParserPool::Instance().Parse(packing_list_path.absoluteFilePath(), pkl_dom_error));
+							if(pkl_dom_error.IsError() == true) parse_error = XmlParsingError(XmlParsingError::Parsing, pkl_dom_error.GetErrorDescription());
+							else {
+								try {
+									packing_list = pkl::parsePackingList(*packing_list_document, xml_schema::Flags::dont_initialize);
+								}
+								catch(const xml_schema::Parsing &e) { parse_error = XmlParsingError(e); }
+								catch(const xml_schema::ExpectedElement &e) { parse_error = XmlParsingError(e); }
+								catch(const xml_schema::UnexpectedElement &e) { parse_error = XmlParsingError(e); }
+								catch(const xml_schema::ExpectedAttribute &e) { parse_error = XmlParsingError(e); }
+								catch(const xml_schema::UnexpectedEnumerator &e) { parse_error = XmlParsingError(e); }
+								catch(const xml_schema::ExpectedTextContent &e) { parse_error = XmlParsingError(e); }
+								catch(const xml_schema::NoTypeInfo &e) { parse_error = XmlParsingError(e); }
+								catch(const xml_schema::NotDerived &e) { parse_error = XmlParsingError(e); }
+								catch(const xml_schema::NoPrefixMapping &e) { parse_error = XmlParsingError(e); }
+								catch(...) { parse_error = XmlParsingError(XmlParsingError::Unknown); }
 							}
-							catch(const xml_schema::Parsing &e) { parse_error = XmlParsingError(e); }
-							catch(const xml_schema::ExpectedElement &e) { parse_error = XmlParsingError(e); }
-							catch(const xml_schema::UnexpectedElement &e) { parse_error = XmlParsingError(e); }
-							catch(const xml_schema::ExpectedAttribute &e) { parse_error = XmlParsingError(e); }
-							catch(const xml_schema::UnexpectedEnumerator &e) { parse_error = XmlParsingError(e); }
-							catch(const xml_schema::ExpectedTextContent &e) { parse_error = XmlParsingError(e); }
-							catch(const xml_schema::NoTypeInfo &e) { parse_error = XmlParsingError(e); }
-							catch(const xml_schema::NotDerived &e) { parse_error = XmlParsingError(e); }
-							catch(const xml_schema::NoPrefixMapping &e) { parse_error = XmlParsingError(e); }
-							catch(...) { parse_error = XmlParsingError(XmlParsingError::Unknown); }
 
 							if(parse_error.IsError() == false) {
 								// XML parsing succeeds
@@ -291,10 +523,19 @@ ImfError ImfPackage::ParseAssetMap(const QFileInfo &rAssetMapFilePath) {
 													bool is_opl = true;
 													bool is_cpl = true;
 
-													try { cpl::parseCompositionPlaylist(new_asset_path.absoluteFilePath().toStdString(), xml_schema::Flags::dont_validate | xml_schema::Flags::dont_initialize); }
-													catch(...) { is_cpl = false; }
-													try { opl::parseOutputProfileList(new_asset_path.absoluteFilePath().toStdString(), xml_schema::Flags::dont_validate | xml_schema::Flags::dont_initialize); }
-													catch(...) { is_opl = false; }
+													// The document is parsed once and bound to both types.
+													Error xml_error;
+													xml_schema::dom::auto_ptr<xercesc::DOMDocument> xml_document(XmlParserPool::Instance().Parse(new_asset_path.absoluteFilePath(), xml_error));
+													if(xml_error.IsError() == false) {
+														try { cpl::parseCompositionPlaylist(*xml_document, xml_schema::Flags::dont_initialize); }
+														catch(...) { is_cpl = false; }
+														try { opl::parseOutputProfileList(*xml_document, xml_schema::Flags::dont_initialize); }
+														catch(...) { is_opl = false; }
+													}
+													else {
+														is_cpl = false;
+														is_opl = false;
+													}
 													if(is_cpl && !is_opl) {
 														// Add CPL
 														QSharedPointer<AssetCpl> cpl(new AssetCpl(new_asset_path, am_asset, pkl_asset));
@@ -378,6 +619,26 @@ QUuid ImfPackage::GetPackingListId(int index /*= 0*/) {
 	return QUuid();
 }
 
+QStringList ImfPackage::GetXmlFiles() const {
+
+	QStringList files;
+	if(mpAssetMap && mpAssetMap->Exists()) files << mpAssetMap->GetFilePath().absoluteFilePath();
+	for(int i = 0; i < mAssetList.size(); i++) {
+		const QSharedPointer<Asset> &r_asset = mAssetList.at(i);
+		if(r_asset->GetType() == Asset::pkl || r_asset->GetType() == Asset::cpl || r_asset->GetType() == Asset::opl) {
+			const QFileInfo file_path = r_asset->GetPath();
+			if(file_path.exists() == true) files << file_path.absoluteFilePath();
+		}
+	}
+	return files;
+}
+
+void ImfPackage::RescanFiles() {
+
+	// Changed files are passed to ImfPackage::rFileStatusChanged() before this returns.
+	mpFileStatusCache->Rescan();
+}
+
 bool ImfPackage::AddAsset(const QSharedPointer<Asset> &rAsset, const QUuid &rPackingListId) {
 
 	bool success = true;
@@ -389,9 +650,13 @@ bool ImfPackage::AddAsset(const QSharedPointer<Asset> &rAsset, const QUuid &rPac
 					connect(p_packing_list, SIGNAL(destroyed(QObject *)), rAsset.data(), SLOT(AffinityLost(QObject *)));
 					connect(mpAssetMap, SIGNAL(destroyed(QObject *)), rAsset.data(), SLOT(AffinityLost(QObject *)));
 					connect(rAsset.data(), SIGNAL(AssetModified(Asset *)), this, SLOT(rAssetModified(Asset *)));
+					mpFileStatusCache->Watch(rAsset->GetPath().absoluteFilePath());
 					beginInsertRows(QModelIndex(), mAssetList.size(), mAssetList.size());
 					mAssetList.push_back(rAsset);
+					mAssetsById.insert(rAsset->GetId(), rAsset);
 					endInsertRows();
+					mRemovedAssets.remove(rAsset->GetId());
+					rAsset->mNeedsOutgest = true; // The asset might have been removed and added again (undo).
 					rAsset->AffinityWon(p_packing_list);
 					rAsset->AffinityWon(mpAssetMap);
 				}
@@ -403,8 +668,10 @@ bool ImfPackage::AddAsset(const QSharedPointer<Asset> &rAsset, const QUuid &rPac
 			else {
 				connect(mpAssetMap, SIGNAL(destroyed(QObject *)), rAsset.data(), SLOT(AffinityLost(QObject *)));
 				connect(rAsset.data(), SIGNAL(AssetModified(Asset *)), this, SLOT(rAssetModified(Asset *)));
+				mpFileStatusCache->Watch(rAsset->GetPath().absoluteFilePath());
 				beginInsertRows(QModelIndex(), mAssetList.size(), mAssetList.size());
 				mAssetList.push_back(rAsset);
+				mAssetsById.insert(rAsset->GetId(), rAsset);
 				endInsertRows();
 				rAsset->AffinityWon(mpAssetMap);
 			}
@@ -423,10 +690,27 @@ bool ImfPackage::AddAsset(const QSharedPointer<Asset> &rAsset, const QUuid &rPac
 
 QSharedPointer<Asset> ImfPackage::GetAsset(const QUuid &rUuid) {
 
-	for(int i = 0; i < mAssetList.size(); i++) {
-		if(rUuid == mAssetList.at(i)->GetId()) return mAssetList.at(i);
+	return mAssetsById.value(rUuid);
+}
+
+QSharedPointer<Asset> ImfPackage::ResolveAsset(const QUuid &rUuid) {
+
+	QSharedPointer<Asset> asset = mAssetsById.value(rUuid);
+	if(asset.isNull() == true) return mReferencedAssets.value(rUuid);
+	return asset;
+}
+
+void ImfPackage::SetReferencePackages(const QList<QSharedPointer<ImfPackage> > &rPackages) {
+
+	mReferencePackages = rPackages;
+	mReferencedAssets.clear();
+	for(int i = 0; i < mReferencePackages.size(); i++) {
+		const QList<QSharedPointer<Asset> > &r_assets = mReferencePackages.at(i)->mAssetList;
+		for(int ii = 0; ii < r_assets.size(); ii++) {
+			// The first reference package listing an Asset wins.
+			if(r_assets.at(ii)->GetType() != Asset::pkl && mReferencedAssets.contains(r_assets.at(ii)->GetId()) == false) mReferencedAssets.insert(r_assets.at(ii)->GetId(), r_assets.at(ii));
+		}
 	}
-	return QSharedPointer<Asset>();
 }
 
 QSharedPointer<Asset> ImfPackage::GetAsset(int index) {
@@ -443,8 +727,11 @@ void ImfPackage::RemoveAsset(const QUuid &rUuid) {
 			mAssetList.at(i)->AffinityLost(mpAssetMap);
 			mAssetList.at(i)->AffinityLost(GetPackingList(mAssetList.at(i)->GetPklId()));
 			disconnect(mAssetList.at(i).data(), NULL, this, NULL);
+			mpFileStatusCache->Unwatch(mAssetList.at(i)->GetPath().absoluteFilePath());
+			if(mAssetList.at(i)->GetType() != Asset::pkl) mRemovedAssets.insert(rUuid);
 			beginRemoveRows(QModelIndex(), i, i);
 			mAssetList.removeAt(i);
+			mAssetsById.remove(rUuid);
 			endRemoveRows();
 		}
 	}
@@ -532,8 +819,8 @@ QVariant ImfPackage::data(const QModelIndex &rIndex, int role /*= Qt::DisplayRol
 		}
 		else if(column == ImfPackage::ColumnFileSize) {
 			if(role == Qt::DisplayRole) {
-				if(mAssetList.at(row)->Exists() == true) {
-					quint32 size = mAssetList.at(row)->GetSize();
+				if(mpFileStatusCache->GetStatus(mAssetList.at(row)->GetPath().absoluteFilePath()).exists == true) {
+					qint64 size = mAssetList.at(row)->GetSize();
 					if(size < 1048576) return QVariant(QString::number((double)size / 1024., 'f', 2).append(" KiB"));
 					else if(size < 1073741824) return QVariant(QString::number((double)size / 1048576., 'f', 2).append(" MiB"));
 					else return QVariant(QString::number((double)size / 1073741824., 'f', 2).append(" GiB"));
@@ -546,7 +833,7 @@ QVariant ImfPackage::data(const QModelIndex &rIndex, int role /*= Qt::DisplayRol
 		}
 		else if(column == ImfPackage::ColumnFinalized) {
 			if(role == Qt::CheckStateRole) {
-				if(mAssetList.at(row)->Exists() == true) return Qt::Checked;
+				if(mpFileStatusCache->GetStatus(mAssetList.at(row)->GetPath().absoluteFilePath()).exists == true) return Qt::Checked;
 				else return Qt::Unchecked;
 			}
 		}
@@ -659,6 +946,7 @@ bool ImfPackage::setData(const QModelIndex &rIndex, const QVariant &rValue, int
 void ImfPackage::rAssetModified(Asset *pAsset) {
 
 	if(pAsset) {
+		mpFileStatusCache->Refresh(pAsset->GetPath().absoluteFilePath());
 		for(int i = 0; i < mAssetList.size(); i++) {
 			if(*pAsset == *mAssetList.at(i)) {
 				if(mIsIngest == false) {
@@ -672,6 +960,20 @@ void ImfPackage::rAssetModified(Asset *pAsset) {
 	}
 }
 
+void ImfPackage::rFileStatusChanged(const QStringList &rFilePaths) {
+
+	const QSet<QString> file_paths = rFilePaths.toSet();
+	for(int i = 0; i < mAssetList.size(); i++) {
+		if(file_paths.contains(mAssetList.at(i)->GetPath().absoluteFilePath()) == false) continue;
+		if(mAssetList.at(i)->RefreshFileStatus() == true && mIsIngest == false) {
+			bool old_dirty = mIsDirty;
+			mIsDirty = true;
+			if(old_dirty != true) emit DirtyChanged(true);
+		}
+		emit dataChanged(index(i, ImfPackage::ColumnFileSize), index(i, ImfPackage::ColumnFinalized));
+	}
+}
+
 QMimeData* ImfPackage::mimeData(const QModelIndexList &indexes) const {
 
 	ImfMimeData *mimeData = new ImfMimeData();
@@ -768,7 +1070,7 @@ const pkl::PackingListType& PackingList::Write() {
 Asset::Asset(eAssetType type, const QFileInfo &rFilePath, const QUuid &rId, const UserText &rAnnotationText /*= QString()*/) :
 QObject(NULL), mpAssetMap(NULL), mpPackageList(NULL), mType(type), mFilePath(rFilePath),
 mAmData(ImfXmlHelper::Convert(QUuid() /*empty*/), am::AssetType_ChunkListType() /*empty*/),
-mpPklData(NULL), mFileNeedsNewHash(true) {
+mpPklData(NULL), mFileNeedsNewHash(true), mNeedsOutgest(true), mContentStaged(false), mStagedContent() {
 
 	if(mType != pkl) {
 		mpPklData = std::auto_ptr<pkl::AssetType>(new pkl::AssetType(
@@ -802,7 +1104,7 @@ mpPklData(NULL), mFileNeedsNewHash(true) {
 
 // Import existing Asset
 Asset::Asset(eAssetType type, const QFileInfo &rFilePath, const am::AssetType &rAsset, std::auto_ptr<pkl::AssetType> assetType /*= std::auto_ptr<pkl::AssetType>(NULL)*/) :
-QObject(NULL), mpAssetMap(NULL), mpPackageList(NULL), mType(type), mFilePath(rFilePath), mAmData(rAsset), mpPklData(assetType), mFileNeedsNewHash(false) {
+QObject(NULL), mpAssetMap(NULL), mpPackageList(NULL), mType(type), mFilePath(rFilePath), mAmData(rAsset), mpPklData(assetType), mFileNeedsNewHash(false), mNeedsOutgest(false), mContentStaged(false), mStagedContent() {
 
 	connect(this, SIGNAL(AssetModified(Asset*)), this, SLOT(rAssetModified(Asset*)));
 }
@@ -811,7 +1113,7 @@ const am::AssetType& Asset::WriteAm() {
 
 	// Update values before serialization.
 	if(mType == pkl) mAmData.setPackingList(xml_schema::Boolean(true));
-	if(Exists() == true) {
+	if(HasContent() == true) {
 		if(mpAssetMap) {
 			QDir root_dir = mpAssetMap->GetFilePath().absoluteDir();
 			mAmData.setChunkList(am::AssetType_ChunkListType()); // Remove old Chunks.
@@ -850,7 +1152,28 @@ void Asset::SetAnnotationText(const UserText &rAnnotationText) {
 void Asset::SetHash(const QByteArray &rHash) {
 
 	mFileNeedsNewHash = false;
-	if(mpPklData.get()) mpPklData->setHash(ImfXmlHelper::Convert(rHash));
+	if(mpPklData.get() && rHash != GetHash()) {
+		mpPklData->setHash(ImfXmlHelper::Convert(rHash));
+		mNeedsOutgest = true;
+	}
+}
+
+void Asset::FileWritten(const QByteArray &rHash) {
+
+	FileModified();
+	SetHash(rHash);
+}
+
+void Asset::StageContent(const QByteArray &rData, const QByteArray &rHash) {
+
+	mStagedContent = rData;
+	mContentStaged = true;
+	if(mpPklData.get()) {
+		mpPklData->setSize(xml_schema::PositiveInteger(rData.size()));
+		mpPklData->setOriginalFileName(ImfXmlHelper::Convert(UserText(mFilePath.fileName())));
+	}
+	emit AssetModified(this);
+	SetHash(rHash);
 }
 
 void Asset::AffinityLost(QObject *pPklOrAm) {
@@ -886,16 +1209,29 @@ void Asset::AffinityWon(QObject *pPklOrAm) {
 
 void Asset::rAssetModified(Asset *pAsset) {
 
+	mNeedsOutgest = true;
 	mFilePath.refresh(); // Qt caches information (e.g. QFileInfo::exists()).
-	if(mpPklData.get()) {
+	// The Packing List entry of staged content describes the staged data.
+	if(mpPklData.get() && mContentStaged == false) {
 		mpPklData->setSize(xml_schema::PositiveInteger(mFilePath.size()));
 		mpPklData->setOriginalFileName(ImfXmlHelper::Convert(UserText(mFilePath.fileName())));
 	}
 }
 
+bool Asset::RefreshFileStatus() {
+
+	mFilePath.refresh(); // Qt caches information (e.g. QFileInfo::exists()).
+	if(Exists() == false || mContentStaged == true) return false; // Staged content replaces the file with the next outgest.
+	// Size or modification time changed. Asset::rAssetModified() updates the Packing List size, the old hash is stale.
+	FileModified();
+	return mpPklData.get() != NULL;
+}
+
 void Asset::FileModified() {
 
-	mFileNeedsNewHash = true;
+	mFileNeedsNewHash = true;
+	// The file was rewritten. A checkpoint of the previous content must never be matched.
+	HashCheckpoints::Instance().Remove(mFilePath);
 	emit AssetModified(this);
 	//WR begin
 	//This slot is called when wrapping was successful. "this" points to the Asset that was modified.
@@ -945,23 +1281,30 @@ Asset(Asset::opl, rFilePath, rId, rAnnotationText) {
 
 AssetMxfTrack::AssetMxfTrack(const QFileInfo &rFilePath, const am::AssetType &rAmAsset, const pkl::AssetType &rPklAsset) :
 Asset(Asset::mxf, rFilePath, rAmAsset, std::auto_ptr<pkl::AssetType>(new pkl::AssetType(rPklAsset))), mMetadata(), mSourceFiles(), mFirstProxyImage(), mMetadataExtr() {
-	mMetadataExtr.ReadMetadata(mMetadata, rFilePath.absoluteFilePath());
+	MxfReaderPool::Instance().RegisterAsset(rFilePath.absoluteFilePath(), GetId());
+	// Track files already read for another package (or prefetched, see ImfWorkspace) aren't read again.
+	mTrackFile = AssetIndex::Instance().Acquire(GetId(), GetHash(), rFilePath.absoluteFilePath());
+	mMetadata = mTrackFile->metadata;
 	SetDefaultProxyImages();
 	//WR begin
-	//New UUID for SourceENcoding
-	mSourceEncoding = QUuid::createUuid();
-	//new ED with SourceEncoding as ID
-	mEssenceDescriptor = new cpl::EssenceDescriptorBaseType(ImfXmlHelper::Convert(mSourceEncoding));
-	//Extract ED from MXF and write it into mEssenceDescriptor
-	SetEssenceDescriptorSetAny(QString(rFilePath.absoluteFilePath()));
-
+	if(mTrackFile->essenceDescriptor) {
+		mEssenceDescriptor = mTrackFile->essenceDescriptor;
+		mSourceEncoding = mTrackFile->sourceEncoding;
+	}
+	else {
+		//New UUID for SourceENcoding
+		mSourceEncoding = QUuid::createUuid();
+		//empty ED with SourceEncoding as ID
+		mEssenceDescriptor = EssenceDescriptorTable::CreateEmpty(mSourceEncoding);
+	}
 	//WR end
 }
 
 AssetMxfTrack::AssetMxfTrack(const QFileInfo &rFilePath, const QUuid &rId, const UserText &rAnnotationText /*= QString()*/) :
 Asset(Asset::mxf, rFilePath, rId, rAnnotationText), mMetadata(), mSourceFiles(), mFirstProxyImage() {
+	MxfReaderPool::Instance().RegisterAsset(rFilePath.absoluteFilePath(), rId);
 	mSourceEncoding = QUuid::createUuid();
-	mEssenceDescriptor = new cpl::EssenceDescriptorBaseType(ImfXmlHelper::Convert(mSourceEncoding));
+	mEssenceDescriptor = EssenceDescriptorTable::CreateEmpty(mSourceEncoding);
 	//leave ED empty because file does not exist yet on the file system
 
 
@@ -974,6 +1317,7 @@ void AssetMxfTrack::SetSourceFiles(const QStringList &rSourceFiles) {
 		if(mSourceFiles.isEmpty() == false) {
 			if(is_wav_file(mSourceFiles.first()) == true) {
 				mMetadataExtr.ReadMetadata(mMetadata, mSourceFiles.first());
+				mMetadata.audioAnalysis = AudioAnalysisResult();
 				SetDefaultProxyImages();
 				int channel_count = 0;
 				for(int i = 0; i < mSourceFiles.size(); i++) {
@@ -993,6 +1337,16 @@ void AssetMxfTrack::SetSourceFiles(const QStringList &rSourceFiles) {
 				emit AssetModified(this);
 			}
 			/* -----Denis Manthey----- */
+			else if(is_j2c_file(mSourceFiles.first()) == true) {
+				// One codestream per frame. The edit rate is set with AssetMxfTrack::SetFrameRate().
+				QStringList frames;
+				ImageSequence::Scan(mSourceFiles, "j2c", frames);
+				mMetadata = Metadata(Metadata::Jpeg2000);
+				mMetadata.fileName = QFileInfo(mSourceFiles.first()).fileName();
+				mMetadata.duration = Duration(frames.size());
+				SetDefaultProxyImages();
+				emit AssetModified(this);
+			}
 
 
 		}
@@ -1001,6 +1355,10 @@ void AssetMxfTrack::SetSourceFiles(const QStringList &rSourceFiles) {
 
 void AssetMxfTrack::SetFrameRate(const EditRate &rFrameRate) {
 
+	if(Exists() == false && GetEssenceType() == Metadata::Jpeg2000 && rFrameRate.IsValid() == true) {
+		mMetadata.editRate = rFrameRate;
+		emit AssetModified(this);
+	}
 }
 
 void AssetMxfTrack::SetSoundfieldGroup(const SoundfieldGroup &rSoundfieldGroup) {
@@ -1015,6 +1373,14 @@ void AssetMxfTrack::SetDuration(const Duration &rDuration) {
 
 	if(Exists() == false && GetEssenceType() == Metadata::TimedText) {
 		mMetadata.duration = rDuration;
+		emit AssetModified(this);
+	}
+}
+
+void AssetMxfTrack::SetAudioAnalysis(const AudioAnalysisResult &rResult) {
+
+	if(GetEssenceType() == Metadata::Pcm) {
+		mMetadata.audioAnalysis = rResult;
 		emit AssetModified(this);
 	}
 }
@@ -1029,19 +1395,24 @@ void AssetMxfTrack::rTransformationFinished(const QImage &rImage, const QVariant
 
 void AssetMxfTrack::SetDefaultProxyImages() {
 
+	// Decoded once. QImage is implicitly shared by all assets.
+	static const QImage proxy_film(":/proxy_film.png");
+	static const QImage proxy_sound(":/proxy_sound.png");
+	static const QImage proxy_text(":/proxy_text.png");
+	static const QImage proxy_unknown(":/proxy_unknown.png");
 	switch(GetEssenceType()) {
 		case Metadata::Jpeg2000:
-			mFirstProxyImage = QImage(":/proxy_film.png");
+			mFirstProxyImage = proxy_film;
 			break;
 		case Metadata::Pcm:
-			mFirstProxyImage = QImage(":/proxy_sound.png");
+			mFirstProxyImage = proxy_sound;
 			break;
 		case Metadata::TimedText:
-			mFirstProxyImage = QImage(":/proxy_text.png");
+			mFirstProxyImage = proxy_text;
 			break;
 		case Metadata::Unknown_Type:
 		default:
-			mFirstProxyImage = QImage(":/proxy_unknown.png");
+			mFirstProxyImage = proxy_unknown;
 			break;
 	}
 }
@@ -1049,8 +1420,21 @@ void AssetMxfTrack::SetDefaultProxyImages() {
 //WR begin
 
 void AssetMxfTrack::SetEssenceDescriptorSetAny(const QString &filePath) {
-	QString fPath = filePath;
-	QString classPath = QApplication::applicationDirPath() + QString("/regxmllib/regxmllib.jar");
+
+	mTrackFile.clear(); // The file changed. The indexed entry describes the old content.
+	Error error;
+	EssenceDescriptorTable::Descriptor descriptor = ReadEssenceDescriptor(filePath, error);
+	if(descriptor) {
+		mEssenceDescriptor = descriptor;
+		mSourceEncoding = ImfXmlHelper::Convert(descriptor->getId());
+	}
+	else qDebug() << "Failed to extract essence descriptor from " << filePath << error;
+}
+
+EssenceDescriptorTable::Descriptor AssetMxfTrack::ReadEssenceDescriptor(const QString &rFilePath, Error &rError) {
+
+	TRACE_SPAN_DETAIL("AssetMxfTrack::ReadEssenceDescriptor", "xml", QFileInfo(rFilePath).fileName());
+	const QString classPath = QApplication::applicationDirPath() + QString("/regxmllib/regxmllib.jar");
 	const unsigned short dictLength = 4;
 	QString dict[dictLength] = {
 		QApplication::applicationDirPath() + QString("/regxmllib/www-smpte-ra-org-reg-335-2012.xml"),
@@ -1058,97 +1442,30 @@ void AssetMxfTrack::SetEssenceDescriptorSetAny(const QString &filePath) {
 		QApplication::applicationDirPath() + QString("/regxmllib/www-smpte-ra-org-reg-395-2014-13-1-aaf.xml"),
 		QApplication::applicationDirPath() + QString("/regxmllib/www-smpte-ra-org-reg-2003-2012.xml")
 	};
-#ifdef WIN32
-	classPath = QString("\"") + classPath + QString("\"");
-	fPath = QString("\"") + fPath + QString("\"");
-	for (int i=0; i < dictLength; i++) {
-		dict[i] = QString("\"") + dict[i] + QString("\"");
-	}
-#else
-	classPath = classPath.replace(" ", "\\ ");
-	fPath = fPath.replace(" ", "\\ ");
-	for (int i=0; i < dictLength; i++) {
-		dict[i] = dict[i].replace(" ", "\\ ");
-	}
-#endif
 
-	QString command = "java -cp " + classPath + " com.sandflow.smpte.tools.RegXMLDump -ed -d ";
+	QStringList arguments;
+	arguments << "-cp" << classPath << "com.sandflow.smpte.tools.RegXMLDump" << "-ed" << "-d";
 	for (int i=0; i < dictLength; i++) {
-		command += dict[i] + QString(" ");
+		arguments << dict[i];
 	}
-	command += QString("-i ") + fPath;
-
-	std::string result = this->ssystem(command.toStdString().c_str());
-	QString qresult = QString::fromStdString(result.c_str());
-
-	if (result.length() > 0) {
-		cpl::EssenceDescriptorBaseType::AnySequence &r_any_sequence(mEssenceDescriptor->getAny());
-		xercesc::DOMElement * p_dom_element;
-		const char * strEssenceDescriptor;
-		xercesc::DOMNode * node;
-		xercesc::XercesDOMParser * parser = new xercesc::XercesDOMParser();
-		try {
-			strEssenceDescriptor = qresult.toUtf8();
-			xercesc::MemBufInputSource src((const XMLByte*)strEssenceDescriptor, qresult.length(), "dummy", false);
-			parser->parse(src);
-
-			xercesc::DOMDocument * p_dom_document2 = parser->getDocument();
+	arguments << "-i" << rFilePath;
 
-			xercesc::DOMDocument &p_dom_document  = mEssenceDescriptor->getDomDocument();
-			p_dom_element = p_dom_document2->getDocumentElement();
-			if (p_dom_element) {
-			  node = p_dom_document.importNode(p_dom_element, true);
-
-			  // Appending the node to the new document
-			  if (node) {
-				  p_dom_document.appendChild(node);
-			  }
-			}
-			p_dom_element = p_dom_document.getDocumentElement();
-		}
-	  catch (const xercesc::DOMException& toCatch) {
-			char* message = xercesc::XMLString::transcode(toCatch.msg);
-			qDebug() << "Exception message is:"
-				 << QString(message);
-			xercesc::XMLString::release(&message);
-			delete parser;
-			return;
-	  }
-	  catch (...) {
-			qDebug() << "Failed to extract essence descriptor from " << filePath;
-			return;
-	  }
-
-	  if (p_dom_element) {
-		  //p_dom_element->setAttribute(X("xmlns"), NULL);
-		  try {
-		  r_any_sequence.push_back(p_dom_element);
-		  mEssenceDescriptor->setAny(r_any_sequence);
-		  }
-		  catch (...) {
-				qDebug() << "Failed to extract essence descriptor from " << filePath;
-				return;
-		  }
-	  }
-	  else
-		  qDebug() << "p_dom_element == NULL";
+	// QProcess quotes the arguments and captures stdout. No shell and no temporary file are involved. Diagnostics of RegXMLDump go to our stderr.
+	QProcess process;
+	process.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+	process.start("java", arguments, QIODevice::ReadOnly);
+	if (process.waitForStarted(-1) == false) {
+		rError = Error(Error::UnsupportedEssence, QObject::tr("%1: Couldn't start java: %2").arg(rFilePath).arg(process.errorString()));
+		return EssenceDescriptorTable::Descriptor();
+	}
+	process.waitForFinished(-1);
+	const QByteArray result = process.readAllStandardOutput();
 
-	  delete parser;
-  }
-}
-std::string AssetMxfTrack::ssystem (const char *command) {
-    char tmpname [L_tmpnam];
-    std::tmpnam ( tmpname );
-    std::string scommand = command;
-    std::string cmd = scommand + " >> " + tmpname;
-    std::system(cmd.c_str());
-    std::ifstream file(tmpname, std::ios::in );
-    std::string result;
-        if (file) {
-      while (!file.eof()) result.push_back(file.get());
-          file.close();
-    }
-    remove(tmpname);
-    return result;
+	if (result.isEmpty() == true) {
+		rError = Error(Error::UnsupportedEssence, QObject::tr("%1: RegXMLDump returned no essence descriptor").arg(rFilePath));
+		return EssenceDescriptorTable::Descriptor();
+	}
+	// Assets with identical descriptors share one instance.
+	return EssenceDescriptorTable::Instance().Intern(result, rFilePath, rError);
 }
 //WR end
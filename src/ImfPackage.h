@@ -19,6 +19,8 @@
 #include "SMPTE-429-8-2006-PKL.h"
 #include "MetadataExtractor.h"
 #include "MetadataExtractorCommon.h"
+#include "EssenceDescriptorTable.h"
+#include "AssetIndex.h"
 #include <QObject>
 #include <QDir>
 #include <QString>
@@ -27,6 +29,8 @@
 #include <QFileInfo>
 #include <QStringList>
 #include <QList>
+#include <QSet>
+#include <QHash>
 #include <QByteArray>
 #include <QTime>
 #include <QSharedPointer>
@@ -38,6 +42,8 @@
 class Asset;
 class AssetMap;
 class PackingList;
+class FileStatusCache;
+class JobExportPackage;
 class QAbstractItemModel;
 
 class ImfPackage : public QAbstractTableModel {
@@ -65,14 +71,26 @@ public:
 	bool IsDirty() const { return mIsDirty; }
 	//! Ingests an existing Imf package from file system.
 	ImfError Ingest();
-	//! Outgests (writes) everything back to file system.
+	/*! \brief Outgests (writes) the staged Asset content (see Asset::StageContent()), the Packing Lists, VOLINDEX.xml and ASSETMAP.xml.
+	Only the entries of Assets that changed since the last outgest are regenerated, unchanged Packing Lists aren't rewritten. All files are written in one PackageTransaction:
+	ASSETMAP.xml is replaced last so an interrupted outgest leaves the previous package valid.
+	*/
 	ImfError Outgest();
+	/*! \brief Returns a job that materializes the package in rTargetDir (see JobExportPackage). Must be invoked in the GUI thread. The job may run in any thread.
+	The Asset files are cloned (reflink, copy_file_range, hard link or copy). The Packing List and ASSETMAP.xml are generated from the current entries, the hashes of the Assets are carried forward without re-hashing.
+	All Packing Lists are merged into one new Packing List.
+	If rBaseAssetIds isn't empty a supplemental package is created: Assets whose Id is in rBaseAssetIds are neither copied nor listed, compositions reference them by Id in the base package.
+	The package must be saved. Returns NULL and sets rError if the package can't be exported.
+	*/
+	JobExportPackage* CreateExportJob(const QDir &rTargetDir, const QSet<QUuid> &rBaseAssetIds, ImfError &rError);
 	//! Returns the root directory of the current IMF package.
 	QDir GetRootDir() { return mRootDir; }
 	//! Number of Assets this Imf package holds.
 	int GetAssetCount() const { return mAssetList.size(); }
 	//! Returns Asset with corresponding Uuid. Returns NULL Pointer if Asset is not found.
 	QSharedPointer<Asset> GetAsset(const QUuid &rUuid);
+	//! Like ImfPackage::GetAsset() but falls back to the Assets of the reference packages (e.g. the OV of a supplemental package).
+	QSharedPointer<Asset> ResolveAsset(const QUuid &rUuid);
 	//! Returns Asset at index. Returns NULL Pointer if Asset is not found.
 	QSharedPointer<Asset> GetAsset(int index);
 	//! Removes Asset from Asset List.
@@ -83,6 +101,15 @@ public:
 	bool AddAsset(const QSharedPointer<Asset> &rAsset, const QUuid &rPackingListId);
 	//! Returns next best Packing List if index is 0.
 	QUuid GetPackingListId(int index = 0);
+	//! Returns the Asset Map and all Packing Lists, CPLs and OPLs that exist on the file system.
+	QStringList GetXmlFiles() const;
+	//! Stats all Asset files. Catches files rewritten in place, which the directory watches don't report. Invoke before the Asset files are hashed or listed.
+	void RescanFiles();
+	/*! \brief Sets the read only packages whose Assets compositions of this package may reference (see ImfWorkspace).
+	The Assets of rPackages are indexed by Id. The reference packages must not be modified afterwards.
+	*/
+	void SetReferencePackages(const QList<QSharedPointer<ImfPackage> > &rPackages);
+	QList<QSharedPointer<ImfPackage> > GetReferencePackages() const { return mReferencePackages; }
 
 	//! Model View related.
 	virtual int rowCount(const QModelIndex &rParent = QModelIndex()) const;
@@ -99,6 +126,7 @@ signals:
 
 	private slots:
 	void rAssetModified(Asset *pAsset);
+	void rFileStatusChanged(const QStringList &rFilePaths);
 
 private:
 	Q_DISABLE_COPY(ImfPackage);
@@ -110,9 +138,15 @@ private:
 	AssetMap						*mpAssetMap;
 	QList<PackingList*>				mPackingLists;
 	QList<QSharedPointer<Asset> >	mAssetList;
+	QHash<QUuid, QSharedPointer<Asset> > mAssetsById; // Same Assets as mAssetList.
+	QList<QSharedPointer<ImfPackage> > mReferencePackages;
+	QHash<QUuid, QSharedPointer<Asset> > mReferencedAssets; // Assets of mReferencePackages.
 	const QDir						mRootDir;
 	bool mIsDirty;
 	bool mIsIngest; // Used for suppressing DirtyChanged signals during ingest.
+	QSet<QUuid> mRemovedAssets; // Assets removed since the last outgest.
+	bool mAssetListsCached; // True if the Asset Lists of mpAssetMap and mPackingLists reflect the files written by the last outgest.
+	FileStatusCache *mpFileStatusCache; // Existence and size of the asset files for the model. Kept current by watching the package directories.
 };
 
 
@@ -173,7 +207,7 @@ public:
 	void SetIconId(const QUuid &rIconId) { mData.setIconId(ImfXmlHelper::Convert(rIconId)); }
 	void SetGroupId(const QUuid &rGroupId) { mData.setGroupId(ImfXmlHelper::Convert(rGroupId)); }
 
-	const QFileInfo				mFilePath;
+	QFileInfo							mFilePath; // Changes with every outgest (PKL_<Id>.xml).
 	pkl::PackingListType	mData;
 };
 
@@ -198,12 +232,23 @@ public:
 	virtual ~Asset() {}
 	//! Check if Asset physically exists on file system.
 	bool Exists() const { return mFilePath.exists() && mFilePath.isFile() && !mFilePath.isSymLink(); }
+	/*! Stages new content of the file. rHash is the SHA-1 of rData. The Packing List entry describes rData from now on.
+	The next ImfPackage::Outgest() writes rData in the same PackageTransaction as the Packing Lists and ASSETMAP.xml. Nothing is written while the Asset isn't part of the package.
+	*/
+	void StageContent(const QByteArray &rData, const QByteArray &rHash);
+	bool HasStagedContent() const { return mContentStaged; }
+	//! Returns true if the file exists or content is staged.
+	bool HasContent() const { return mContentStaged || Exists(); }
+	//! Invoke after the size or modification time of the file changed on the file system. Invalidates the hash like Asset::FileModified(). Returns true if the Packing List entry changed.
+	bool RefreshFileStatus();
 	//! Check if Asset belongs to an Asset Map.
 	bool HasAffinity() const { if(mType != Asset::pkl) return mpAssetMap; else return mpAssetMap && mpPackageList; }
 	//! Checks saved Hash against new calculated Hash. Useful for imported Assets.
 	bool ValidateHash(const QByteArray &rHash) const { return rHash == GetHash(); }
 	//! Hashes are calculated externally (time consuming). Check if this Asset needs a new Hash. Set the new Hash using Asset::SetHash().
 	bool NeedsNewHash() const { return (mFileNeedsNewHash || GetHash() == QByteArray()); }
+	//! Check if the Packing List or Asset Map entry of this Asset changed since the last ImfPackage::Outgest().
+	bool NeedsOutgest() const { return mNeedsOutgest; }
 	//! Call this function to receive the Dom Tree for serialization.
 	const am::AssetType& WriteAm();
 	//! Call this function to receive the Dom Tree for serialization.
@@ -215,7 +260,7 @@ public:
 	QUuid GetAmId() const { if(mpAssetMap) return mpAssetMap->GetId(); else return QUuid(); }
 	UserText GetAnnotationText() const;
 	QByteArray GetHash() const { if(mpPklData.get()) return ImfXmlHelper::Convert(mpPklData->getHash()); else return QByteArray(); }
-	quint32 GetSize() const { if(mpPklData.get()) return mpPklData->getSize(); else return quint32(0); }
+	qint64 GetSize() const { if(mpPklData.get()) return (qint64)mpPklData->getSize(); else return qint64(0); }
 	eAssetType GetType() const { return mType; }
 	UserText GetOriginalFileName() const { if(mpPklData.get() && mpPklData->getOriginalFileName().present() == true) return ImfXmlHelper::Convert(mpPklData->getOriginalFileName().get()); else return UserText(); }
 
@@ -226,6 +271,7 @@ public:
 
 	friend bool ImfPackage::AddAsset(const QSharedPointer<Asset> &rAsset, const QUuid &rPackingListId);
 	friend void ImfPackage::RemoveAsset(const QUuid &rUuid);
+	friend ImfError ImfPackage::Outgest();
 
 signals:
 	/*! This signal hast to be emitted if the asset on the file system has changed (e.g. size changes, asset was deleted, ...) or some metadata have changed (e.g. soundfield group).
@@ -234,9 +280,11 @@ signals:
 	void AssetModified(Asset *pAsset);
 
 	public slots:
-	//! Invoke if the file of the asset is modified externally. Emits Asset::AssetModified().
+	//! Invoke if the file of the asset is modified externally. Removes the hash checkpoint of the file and emits Asset::AssetModified().
 	void FileModified();
 	void SetHash(const QByteArray &rHash);
+	//! Invoke if the file was written and rHash is the hash of the new content. Like Asset::FileModified() but no new hash must be calculated.
+	void FileWritten(const QByteArray &rHash);
 
 	private slots:
 	void AffinityLost(QObject *pPklOrAm);
@@ -258,6 +306,9 @@ private:
 	am::AssetType									mAmData;
 	std::auto_ptr<pkl::AssetType>	mpPklData;
 	bool mFileNeedsNewHash;
+	bool mNeedsOutgest;
+	bool mContentStaged;
+	QByteArray mStagedContent;
 };
 
 
@@ -338,12 +389,13 @@ public:
 	QImage GetProxyImage() const { return mFirstProxyImage; }
 	//WR begin
 	//Getter methods for the corresponding members
-	cpl::EssenceDescriptorBaseType* GetEssenceDescriptor() { return mEssenceDescriptor;};
+	//! Shared with all assets whose descriptors have identical content (see EssenceDescriptorTable).
+	EssenceDescriptorTable::Descriptor GetEssenceDescriptor() const { return mEssenceDescriptor;};
 	QUuid GetSourceEncoding() const {return mSourceEncoding;};
 	//WR end
 	//! Set the Wav or Aces files that should be wrapped into Mxf. Does nothing if finalized. WARNING: overwrites old frame rate, soundfield group.
 	void SetSourceFiles(const QStringList &rSourceFiles);
-	//! Set the frame rate for Aces Asset. Does nothing if finalized.
+	//! Set the frame rate for Aces or JPEG 2000 Asset. Does nothing if finalized.
 	void SetFrameRate(const EditRate &rFrameRate);
 	//! Set the soundfield group for Pcm Asset. Does nothing if finalized.
 	void SetSoundfieldGroup(const SoundfieldGroup &rSoundfieldGroup);
@@ -353,8 +405,14 @@ public:
 	//WR begin
 	//This method extracts the essence descriptor from rFilePath and writes it into mEssenceDescriptor
 	void SetEssenceDescriptorSetAny(const QString &filePath);
-	std::string ssystem (const char *command);
+	//! Extracts the essence descriptor of rFilePath (RegXML dump) and returns the shared instance. Returns a null pointer and sets rError on failure. Thread safe.
+	static EssenceDescriptorTable::Descriptor ReadEssenceDescriptor(const QString &rFilePath, Error &rError);
 	//WR end
+
+	public slots:
+	//! Stores the loudness analysis performed while wrapping (see JobWrapWav). Does nothing if this isn't a Pcm Asset.
+	void SetAudioAnalysis(const AudioAnalysisResult &rResult);
+
 	private slots :
 	void rTransformationFinished(const QImage &rImage, const QVariant &rIdentifier = QVariant());
 
@@ -366,9 +424,10 @@ private:
 	QStringList mSourceFiles;
 	QImage			mFirstProxyImage;
 	MetadataExtractor mMetadataExtr;
+	AssetIndex::Entry mTrackFile; // Shared with the assets of other packages listing the same track file. Null for new tracks.
 //WR begin
 	//These are member variables for the corresponding CPL elements
-	cpl::EssenceDescriptorBaseType* mEssenceDescriptor;
+	EssenceDescriptorTable::Descriptor mEssenceDescriptor;
 	QUuid mSourceEncoding;
 //WR end
 };
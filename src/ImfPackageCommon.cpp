@@ -15,6 +15,8 @@
  */
 #include "ImfPackageCommon.h"
 #include <fstream>
+#include <sstream>
+#include <QFile>
 
 
 XmlSerializationError::XmlSerializationError(const xml_schema::Serialization &rError) {
@@ -101,3 +103,76 @@ QDebug operator<<(QDebug dbg, const XmlSerializationError &rError) {
 	dbg.nospace() << "XML Serialization Error: " << rError.GetErrorMsg() << " Detail: " << rError.GetErrorDescription();
 	return dbg.space();
 }
+
+ImfError PackageTransaction::Stage(const QString &rDestination, const QByteArray &rData) {
+
+	QSaveFile *p_file = new QSaveFile(rDestination);
+	if(p_file->open(QIODevice::WriteOnly) == false || p_file->write(rData) != rData.size()) {
+		ImfError error(ImfError::DestinationFileWrite, QString("%1: %2").arg(rDestination).arg(p_file->errorString()));
+		p_file->cancelWriting();
+		delete p_file;
+		return error;
+	}
+	mStagedFiles << p_file;
+	return ImfError();
+}
+
+ImfError PackageTransaction::Commit() {
+
+	ImfError error;
+	while(mStagedFiles.isEmpty() == false) {
+		QSaveFile *p_file = mStagedFiles.takeFirst();
+		// QSaveFile::commit() flushes the temporary file to disk and atomically replaces the destination.
+		if(p_file->commit() == false) {
+			error = ImfError(ImfError::DestinationFileWrite, QString("%1: %2").arg(p_file->fileName()).arg(p_file->errorString()));
+			delete p_file;
+			break;
+		}
+		delete p_file;
+	}
+	if(error.IsError() == false) {
+		for(int i = 0; i < mObsoleteFiles.size(); i++) {
+			if(QFile::exists(mObsoleteFiles.at(i)) && QFile::remove(mObsoleteFiles.at(i)) == false) qWarning() << "Couldn't remove obsolete file: " << mObsoleteFiles.at(i);
+		}
+		mObsoleteFiles.clear();
+	}
+	Rollback();
+	return error;
+}
+
+void PackageTransaction::Rollback() {
+
+	for(int i = 0; i < mStagedFiles.size(); i++) {
+		mStagedFiles.at(i)->cancelWriting();
+		delete mStagedFiles.at(i); // Removes the temporary file.
+	}
+	mStagedFiles.clear();
+	mObsoleteFiles.clear();
+}
+
+ImfError serialize_cpl(const cpl::CompositionPlaylistType &rCpl, QByteArray &rData) {
+
+	// namespace maps
+	xml_schema::NamespaceInfomap cpl_namespace;
+	cpl_namespace[""].name = XML_NAMESPACE_CPL;
+	cpl_namespace["dcml"].name = XML_NAMESPACE_DCML;
+	cpl_namespace["cc"].name = XML_NAMESPACE_CC;
+	cpl_namespace["ds"].name = XML_NAMESPACE_DS;
+	cpl_namespace["xs"].name = XML_NAMESPACE_XS;
+
+	XmlSerializationError serialization_error;
+	std::ostringstream cpl_stream;
+	try {
+		cpl::serializeCompositionPlaylist(cpl_stream, rCpl, cpl_namespace, "UTF-8", xml_schema::Flags::dont_initialize);
+	}
+	catch(xml_schema::Serialization &e) { serialization_error = XmlSerializationError(e); }
+	catch(xml_schema::UnexpectedElement &e) { serialization_error = XmlSerializationError(e); }
+	catch(xml_schema::NoTypeInfo &e) { serialization_error = XmlSerializationError(e); }
+	catch(...) { serialization_error = XmlSerializationError(XmlSerializationError::Unknown); }
+	if(serialization_error.IsError() == true) {
+		qDebug() << serialization_error;
+		return ImfError(serialization_error);
+	}
+	rData = QByteArray::fromStdString(cpl_stream.str());
+	return ImfError();
+}
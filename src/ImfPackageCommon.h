@@ -26,6 +26,7 @@
 #include <QUuid>
 #include <QStringList>
 #include <QPair>
+#include <QSaveFile>
 
 
 
@@ -178,6 +179,10 @@ public:
 		UnknownInheritance,
 		XMLParsing,
 		XMLSerialization,
+		DestinationFileWrite,
+		PackageUnsaved,
+		NothingToExport,
+		ReferencePackageFailed,
 		Unknown
 	};
 	//! Constructs empty error (IsError returns false).
@@ -220,6 +225,14 @@ public:
 				ret = QObject::tr("The XML parsing failed."); break;
 			case XMLSerialization:
 				ret = QObject::tr("The XML serialization failed."); break;
+			case DestinationFileWrite:
+				ret = QObject::tr("Couldn't write the destination file."); break;
+			case PackageUnsaved:
+				ret = QObject::tr("The package has unsaved changes."); break;
+			case NothingToExport:
+				ret = QObject::tr("There are no Assets to export."); break;
+			case ReferencePackageFailed:
+				ret = QObject::tr("A reference package couldn't be loaded."); break;
 			case Unknown:
 				ret = QObject::tr("Unknown error"); break;
 			default:
@@ -236,6 +249,31 @@ private:
 	bool		mRecoverable;
 };
 
+/*! \brief Writes package files all or nothing.
+PackageTransaction::Stage() writes the content into a temporary file next to its destination. PackageTransaction::Commit() renames the staged files in staging order (stage the file that makes the new state visible, e.g. ASSETMAP.xml, last) and removes the files scheduled with PackageTransaction::RemoveOnCommit().
+Temporary files that weren't committed are discarded on destruction. A failed or interrupted save leaves the previous files untouched.
+*/
+class PackageTransaction {
+
+public:
+	PackageTransaction() : mStagedFiles(), mObsoleteFiles() {}
+	~PackageTransaction() { Rollback(); }
+	ImfError Stage(const QString &rDestination, const QByteArray &rData);
+	//! The file is removed after all staged files were committed.
+	void RemoveOnCommit(const QString &rFilePath) { mObsoleteFiles << rFilePath; }
+	ImfError Commit();
+	void Rollback();
+	bool IsEmpty() const { return mStagedFiles.isEmpty() && mObsoleteFiles.isEmpty(); }
+
+private:
+	Q_DISABLE_COPY(PackageTransaction);
+	QList<QSaveFile*> mStagedFiles;
+	QStringList mObsoleteFiles;
+};
+
+//! Serializes rCpl into rData (UTF-8). Doesn't touch any widget and may be invoked in any thread.
+ImfError serialize_cpl(const cpl::CompositionPlaylistType &rCpl, QByteArray &rData);
+
 class ImfXmlHelper {
 
 public:
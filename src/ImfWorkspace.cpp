@@ -0,0 +1,102 @@
+/* Copyright(C) 2016 Björn Stresing, Denis Manthey, Wolfgang Ruppel
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "ImfWorkspace.h"
+#include "AssetIndex.h"
+#include "XmlParserPool.h"
+#include "Trace.h"
+#include "global.h"
+#include <QHash>
+#include <QStringList>
+#include <QDebug>
+
+
+namespace {
+
+// Lists the track files of the package in rRootDir. Errors are ignored, ImfPackage::Ingest() reports them.
+void list_track_files(const QDir &rRootDir, QList<AssetIndex::Request> &rRequests) {
+
+	if(rRootDir.exists(ASSET_SEARCH_NAME) == false) return;
+	std::auto_ptr<am::AssetMapType> asset_map;
+	Error error;
+	xml_schema::dom::auto_ptr<xercesc::DOMDocument> asset_map_document(XmlParserPool::Instance().Parse(rRootDir.absoluteFilePath(ASSET_SEARCH_NAME), error));
+	if(error.IsError() == true) return;
+	try {
+		asset_map = am::parseAssetMap(*asset_map_document, xml_schema::Flags::dont_initialize);
+	}
+	catch(...) { return; }
+
+	QHash<QUuid, QString> file_paths;
+	QStringList packing_list_paths;
+	for(unsigned int i = 0; i < asset_map->getAssetList().getAsset().size(); i++) {
+		const am::AssetType &r_asset = asset_map->getAssetList().getAsset().at(i);
+		if(r_asset.getChunkList().getChunk().size() != 1) continue;
+		const QString file_path = rRootDir.absolutePath().append("/").append(r_asset.getChunkList().getChunk().back().getPath().c_str());
+		if(r_asset.getPackingList().present() && r_asset.getPackingList().get() == xml_schema::Boolean(true)) packing_list_paths << file_path;
+		else file_paths.insert(ImfXmlHelper::Convert(r_asset.getId()), file_path);
+	}
+	for(int i = 0; i < packing_list_paths.size(); i++) {
+		std::auto_ptr<pkl::PackingListType> packing_list;
+		Error pkl_error;
+		xml_schema::dom::auto_ptr<xercesc::DOMDocument> packing_list_document(XmlParserPool::Instance().Parse(packing_list_paths.at(i), pkl_error));
+		if(pkl_error.IsError() == true) continue;
+		try {
+			packing_list = pkl::parsePackingList(*packing_list_document, xml_schema::Flags::dont_initialize);
+		}
+		catch(...) { continue; }
+		for(unsigned int ii = 0; ii < packing_list->getAssetList().getAsset().size(); ii++) {
+			const pkl::AssetType &r_asset = packing_list->getAssetList().getAsset().at(ii);
+			if(r_asset.getType().compare(MIME_TYPE_MXF) != 0) continue;
+			const QUuid id = ImfXmlHelper::Convert(r_asset.getId());
+			if(file_paths.contains(id) == true) rRequests << AssetIndex::Request(id, ImfXmlHelper::Convert(r_asset.getHash()), file_paths.value(id));
+		}
+	}
+}
+}
+
+ImfWorkspace::ImfWorkspace(const QDir &rPrimaryDir, const QList<QDir> &rReferenceDirs /*= QList<QDir>()*/) :
+mPrimaryDir(rPrimaryDir), mReferenceDirs(rReferenceDirs), mPrimaryPackage(), mReferencePackages() {
+
+}
+
+ImfError ImfWorkspace::Load() {
+
+	TRACE_SPAN_DETAIL("ImfWorkspace::Load", "package", mPrimaryDir.absolutePath());
+	QList<AssetIndex::Request> requests;
+	list_track_files(mPrimaryDir, requests);
+	for(int i = 0; i < mReferenceDirs.size(); i++) list_track_files(mReferenceDirs.at(i), requests);
+	// Keeps the entries alive until the assets reference them.
+	const QList<AssetIndex::Entry> entries = AssetIndex::Instance().Prefetch(requests);
+
+	mPrimaryPackage = QSharedPointer<ImfPackage>(new ImfPackage(mPrimaryDir));
+	mReferencePackages.clear();
+	ImfError error = mPrimaryPackage->Ingest();
+	if(error.IsError() == true) return error;
+	for(int i = 0; i < mReferenceDirs.size(); i++) {
+		if(mReferenceDirs.at(i) == mPrimaryDir) continue;
+		QSharedPointer<ImfPackage> reference_package(new ImfPackage(mReferenceDirs.at(i)));
+		ImfError reference_error = reference_package->Ingest();
+		if(reference_error.IsError() == true) {
+			qWarning() << "Couldn't load reference package " << mReferenceDirs.at(i).absolutePath() << reference_error.GetErrorMsg();
+			const QString description = QString("%1: %2 %3").arg(QDir::toNativeSeparators(mReferenceDirs.at(i).absolutePath())).arg(reference_error.GetErrorMsg()).arg(reference_error.GetErrorDescription());
+			if(error.IsRecoverableError() == true) error.AppendErrorDescription(QString("\n%1").arg(description));
+			else error = ImfError(ImfError::ReferencePackageFailed, description, true);
+			continue;
+		}
+		mReferencePackages << reference_package;
+	}
+	mPrimaryPackage->SetReferencePackages(mReferencePackages);
+	return error;
+}
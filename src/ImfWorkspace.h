@@ -0,0 +1,46 @@
+/* Copyright(C) 2016 Björn Stresing, Denis Manthey, Wolfgang Ruppel
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include "ImfPackage.h"
+#include <QDir>
+#include <QList>
+#include <QSharedPointer>
+
+
+/*! \brief Loads an IMF package together with read only reference packages, e.g. a supplemental package together with its OV (original version) and further supplemental packages.
+The Asset Maps and Packing Lists of all packages are scanned first. Then the track files of all packages are read concurrently, track files listed
+by several packages (same Id and hash) are read once (see AssetIndex). Finally the packages are ingested, the track files are served by the index.
+Compositions of the primary package resolve track files of the reference packages in O(1) (see ImfPackage::ResolveAsset()).
+*/
+class ImfWorkspace {
+
+public:
+	ImfWorkspace(const QDir &rPrimaryDir, const QList<QDir> &rReferenceDirs = QList<QDir>());
+	~ImfWorkspace() {}
+	//! Ingests all packages. Must be invoked in the GUI thread. A reference package that can't be ingested is skipped and reported as recoverable error. If the primary package can't be ingested the reference packages aren't loaded.
+	ImfError Load();
+	//! The package to edit. Null before ImfWorkspace::Load() was invoked.
+	QSharedPointer<ImfPackage> GetPrimaryPackage() const { return mPrimaryPackage; }
+	QList<QSharedPointer<ImfPackage> > GetReferencePackages() const { return mReferencePackages; }
+
+private:
+	Q_DISABLE_COPY(ImfWorkspace);
+
+	const QDir mPrimaryDir;
+	const QList<QDir> mReferenceDirs;
+	QSharedPointer<ImfPackage> mPrimaryPackage;
+	QList<QSharedPointer<ImfPackage> > mReferencePackages;
+};
@@ -14,23 +14,110 @@
  * along with this program.If not, see <http://www.gnu.org/licenses/>.
  */
 #include "JobQueue.h"
+#include "global.h"
+#include "Trace.h"
 #include <QGlobalStatic>
 #include <QMutexLocker>
 #include <QPointer>
+#include <QFile>
+#include <QDateTime>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#ifdef Q_OS_WIN32
+#include <qt_windows.h> // GetThreadTimes()
+#else
+#include <time.h>
+#endif // Q_OS_WIN32
+
+#define JOB_QUEUE_SUMMARY_FILE_NAME "JobQueueRuns.json"
+#define MAX_JOB_QUEUE_SUMMARY_FILE_SIZE 5000000 // [Byte]
 
 
 Q_GLOBAL_STATIC(JobQueue, theInstance)
 
+namespace
+{
+	//! Returns the CPU time consumed by the calling thread.
+	qint64 thread_cpu_time_ms() {
+
+#ifdef Q_OS_WIN32
+		FILETIME creation_time, exit_time, kernel_time, user_time;
+		if(GetThreadTimes(GetCurrentThread(), &creation_time, &exit_time, &kernel_time, &user_time)) {
+			ULARGE_INTEGER kernel, user;
+			kernel.LowPart = kernel_time.dwLowDateTime;
+			kernel.HighPart = kernel_time.dwHighDateTime;
+			user.LowPart = user_time.dwLowDateTime;
+			user.HighPart = user_time.dwHighDateTime;
+			return (kernel.QuadPart + user.QuadPart) / 10000; // 100 ns units
+		}
+		return 0;
+#else
+		timespec time_spec;
+		if(clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time_spec) == 0) return (qint64)time_spec.tv_sec * 1000 + time_spec.tv_nsec / 1000000;
+		return 0;
+#endif // Q_OS_WIN32
+	}
+
+	QString format_bytes_per_second(double bytesPerSecond) {
+
+		if(bytesPerSecond >= 1024. * 1024. * 1024.) return QObject::tr("%1 GiB/s").arg(bytesPerSecond / (1024. * 1024. * 1024.), 0, 'f', 2);
+		if(bytesPerSecond >= 1024. * 1024.) return QObject::tr("%1 MiB/s").arg(bytesPerSecond / (1024. * 1024.), 0, 'f', 1);
+		return QObject::tr("%1 KiB/s").arg(bytesPerSecond / 1024., 0, 'f', 0);
+	}
+
+	QJsonObject telemetry_to_json(const JobTelemetry &rTelemetry) {
+
+		QJsonObject object;
+		object.insert("bytesRead", (double)rTelemetry.bytesRead);
+		object.insert("bytesWritten", (double)rTelemetry.bytesWritten);
+		object.insert("framesProcessed", (double)rTelemetry.framesProcessed);
+		object.insert("cpuTimeMs", (double)rTelemetry.cpuTimeMs);
+		object.insert("wallTimeMs", (double)rTelemetry.wallTimeMs);
+		return object;
+	}
+}
+
+JobTelemetry& JobTelemetry::operator+=(const JobTelemetry &rOther) {
+
+	bytesRead += rOther.bytesRead;
+	bytesWritten += rOther.bytesWritten;
+	framesProcessed += rOther.framesProcessed;
+	cpuTimeMs += rOther.cpuTimeMs;
+	wallTimeMs += rOther.wallTimeMs;
+	return *this;
+}
+
+QString JobQueueStatistics::GetAsString() const {
+
+	QStringList list;
+	if(readThroughput > 0) list << QObject::tr("Read: %1").arg(format_bytes_per_second(readThroughput));
+	if(writeThroughput > 0) list << QObject::tr("Write: %1").arg(format_bytes_per_second(writeThroughput));
+	if(frameRate > 0) list << QObject::tr("%1 frames/s").arg(frameRate, 0, 'f', 0);
+	if(total.wallTimeMs > 0) list << QObject::tr("CPU: %1 %").arg(GetCpuLoad() * 100., 0, 'f', 0);
+	if(etaMs >= 0) list << QObject::tr("Remaining: %1").arg(QTime(0, 0).addMSecs(etaMs).toString("hh:mm:ss"));
+	return list.join(" | ");
+}
+
 AbstractJob::AbstractJob(const QString &rDescription) :
-QObject(NULL), mMutex(), mError(), mDescription(rDescription), mIdentifier() {
+QObject(NULL), mMutex(), mError(), mDescription(rDescription), mIdentifier(), mTelemetry(), mTimer(), mCpuTimeStart(0), mLastTelemetryEmission(0), mReportCount(0), mLastTelemetry() {
 
 }
 
 Error AbstractJob::PerformRun() {
 
 	Error error;
+	mTelemetry = JobTelemetry();
+	mReportCount = 0;
+	mLastTelemetryEmission = 0;
+	mCpuTimeStart = thread_cpu_time_ms();
+	mTimer.start();
 	emit Progress(0);
-	error = Execute();
+	{
+		TRACE_SPAN_DETAIL("AbstractJob::Execute", "job", mDescription);
+		error = Execute();
+	}
+	EmitTelemetry(true);
 	emit Progress(100);
 	mMutex.lock();
 	mError = error;
@@ -47,6 +134,25 @@ Error AbstractJob::GetLastError() {
 	return mError;
 }
 
+void AbstractJob::EmitTelemetry(bool force) {
+
+	qint64 elapsed = mTimer.elapsed();
+	if(force == false && elapsed - mLastTelemetryEmission < 100) return;
+	mLastTelemetryEmission = elapsed;
+	mTelemetry.wallTimeMs = elapsed;
+	mTelemetry.cpuTimeMs = thread_cpu_time_ms() - mCpuTimeStart;
+	mMutex.lock();
+	mLastTelemetry = mTelemetry;
+	mMutex.unlock();
+	emit Telemetry(mTelemetry);
+}
+
+JobTelemetry AbstractJob::GetTelemetry() {
+
+	QMutexLocker locker(&mMutex);
+	return mLastTelemetry;
+}
+
 void AbstractJob::run() {
 
 	PerformRun();
@@ -66,8 +172,10 @@ QVariant AbstractJob::GetIdentifier() {
 }
 
 JobQueue::JobQueue(QObject *pParent /*= NULL*/) :
-QThread(pParent), mMutex(), mQueue(), mErrors(), mMaxProgress(0), mJobProgress(0), mCurrentProgress(0), mInterruptIfError(false) {
+QThread(pParent), mMutex(), mQueue(), mErrors(), mMaxProgress(0), mJobProgress(0), mCurrentProgress(0), mInterruptIfError(false),
+mRunTimer(), mLastStatisticsEmission(0), mFinishedTelemetry(), mCurrentTelemetry(), mSamples(), mJobSummaries(), mCurrentJob(), mFinishedJobs(0), mJobCount(0), mStatisticsMutex(), mStatistics() {
 
+	setObjectName("JobQueue");
 }
 
 JobQueue::~JobQueue() {
@@ -85,16 +193,38 @@ void JobQueue::run() {
 	emit Progress(0);
 	mMutex.lock();
 	bool stop = false;
+	mRunTimer.start();
+	mLastStatisticsEmission = 0;
+	mFinishedTelemetry = JobTelemetry();
+	mCurrentTelemetry = JobTelemetry();
+	mSamples.clear();
+	mJobSummaries.clear();
+	mCurrentJob.clear();
+	mFinishedJobs = 0;
+	mJobCount = mQueue.size();
 
 	while(mQueue.empty() == false) {
 		QPointer<AbstractJob> p_job(mQueue.dequeue());
 		mMutex.unlock();
-		connect(p_job.data(), SIGNAL(Progress(int)), this, SLOT(JobProgress(int)));
 
 		if(p_job.isNull() == false) {
-			emit NextJobStarted(p_job->GetDescription());
+			// Direct connections: Progress and telemetry are aggregated in this thread.
+			connect(p_job.data(), SIGNAL(Progress(int)), this, SLOT(JobProgress(int)), Qt::DirectConnection);
+			connect(p_job.data(), SIGNAL(Telemetry(const JobTelemetry&)), this, SLOT(JobTelemetryChanged(const JobTelemetry&)), Qt::DirectConnection);
+			mCurrentJob = p_job->GetDescription();
+			mCurrentTelemetry = JobTelemetry();
+			emit NextJobStarted(mCurrentJob);
 			bool auto_delete = p_job->autoDelete();
 			Error error = p_job->PerformRun();
+			JobSummary summary;
+			summary.description = mCurrentJob;
+			summary.success = !error.IsError();
+			summary.telemetry = p_job->GetTelemetry();
+			mJobSummaries.push_back(summary);
+			mFinishedTelemetry += summary.telemetry;
+			mCurrentTelemetry = JobTelemetry();
+			mFinishedJobs++;
+			disconnect(p_job.data(), 0, this, 0);
 			if(error.IsError() == true) {
 				mMutex.lock();
 				mErrors.push_back(p_job->GetLastError());
@@ -111,10 +241,85 @@ void JobQueue::run() {
 		if(isInterruptionRequested() == true || stop == true) break;
 	}
 
+	bool interrupted = mQueue.empty() == false;
 	mMutex.unlock();
+	mCurrentJob.clear();
+	UpdateStatistics(true);
+	WriteRunSummary(interrupted);
 	emit Progress(100);
 }
 
+void JobQueue::UpdateStatistics(bool force /*= false*/) {
+
+	qint64 now = mRunTimer.elapsed();
+	if(force == false && now - mLastStatisticsEmission < StatisticsInterval) return;
+	mLastStatisticsEmission = now;
+
+	JobQueueStatistics statistics;
+	statistics.total = mFinishedTelemetry;
+	statistics.total += mCurrentTelemetry;
+	statistics.finishedJobs = mFinishedJobs;
+	statistics.jobCount = mJobCount;
+	statistics.currentJob = mCurrentJob;
+	int max_progress = mMaxProgress;
+	int current_progress = mCurrentProgress;
+	if(max_progress > 0) statistics.progress = qBound(0, current_progress * 100 / max_progress, 100);
+
+	// Rolling window: Compare the newest sample with the oldest sample not older than ThroughputWindow.
+	Sample sample;
+	sample.timeMs = now;
+	sample.progress = current_progress;
+	sample.telemetry = statistics.total;
+	mSamples.enqueue(sample);
+	while(mSamples.size() > 2 && now - mSamples.at(1).timeMs >= ThroughputWindow) mSamples.dequeue();
+	const Sample &r_oldest = mSamples.head();
+	double delta_s = (now - r_oldest.timeMs) / 1000.;
+	if(delta_s > 0) {
+		statistics.readThroughput = (sample.telemetry.bytesRead - r_oldest.telemetry.bytesRead) / delta_s;
+		statistics.writeThroughput = (sample.telemetry.bytesWritten - r_oldest.telemetry.bytesWritten) / delta_s;
+		statistics.frameRate = (sample.telemetry.framesProcessed - r_oldest.telemetry.framesProcessed) / delta_s;
+		double progress_rate = (sample.progress - r_oldest.progress) / delta_s;
+		if(progress_rate > 0 && max_progress > current_progress) statistics.etaMs = (qint64)((max_progress - current_progress) / progress_rate * 1000.);
+	}
+	if(force == true && mCurrentJob.isEmpty()) statistics.etaMs = 0;
+
+	TRACE_COUNTER("JobQueue read throughput [Byte/s]", (qint64)statistics.readThroughput);
+	TRACE_COUNTER("JobQueue write throughput [Byte/s]", (qint64)statistics.writeThroughput);
+	TRACE_COUNTER("JobQueue progress [%]", statistics.progress);
+	mStatisticsMutex.lock();
+	mStatistics = statistics;
+	mStatisticsMutex.unlock();
+	emit Statistics(statistics);
+}
+
+void JobQueue::WriteRunSummary(bool interrupted) {
+
+	if(mJobSummaries.isEmpty()) return;
+	QJsonArray jobs;
+	for(int i = 0; i < mJobSummaries.size(); i++) {
+		QJsonObject job = telemetry_to_json(mJobSummaries.at(i).telemetry);
+		job.insert("description", mJobSummaries.at(i).description);
+		job.insert("success", mJobSummaries.at(i).success);
+		jobs.append(job);
+	}
+	QJsonObject run = telemetry_to_json(mFinishedTelemetry);
+	run.insert("start", QDateTime::currentDateTime().addMSecs(-mRunTimer.elapsed()).toString(Qt::ISODate));
+	run.insert("elapsedMs", (double)mRunTimer.elapsed());
+	run.insert("interrupted", interrupted);
+	run.insert("jobs", jobs);
+
+	// One JSON object per line.
+	QFile file(get_app_data_location().absoluteFilePath(JOB_QUEUE_SUMMARY_FILE_NAME));
+	if(file.size() > MAX_JOB_QUEUE_SUMMARY_FILE_SIZE) file.resize(0);
+	if(file.open(QIODevice::WriteOnly | QIODevice::Append) == false) {
+		qWarning() << "Couldn't write job queue summary:" << file.fileName();
+		return;
+	}
+	file.write(QJsonDocument(run).toJson(QJsonDocument::Compact));
+	file.write("\n");
+	file.close();
+}
+
 void JobQueue::StartQueue() {
 
 	if(isRunning() == false) {
@@ -141,9 +346,26 @@ void JobQueue::AddJob(AbstractJob *pJob) {
 void JobQueue::JobProgress(int progress) {
 
 	if(progress == 0) mJobProgress = 0;
+	int last_overall_progress = mMaxProgress > 0 ? mCurrentProgress * 100 / mMaxProgress : 0;
 	mCurrentProgress += progress - mJobProgress;
 	mJobProgress = progress;
-	if(mMaxProgress > 0) emit Progress(mCurrentProgress * 100 / mMaxProgress);
+	if(mMaxProgress > 0) {
+		int overall_progress = mCurrentProgress * 100 / mMaxProgress;
+		if(overall_progress != last_overall_progress || progress == 0) emit Progress(overall_progress);
+	}
+	UpdateStatistics();
+}
+
+void JobQueue::JobTelemetryChanged(const JobTelemetry &rTelemetry) {
+
+	mCurrentTelemetry = rTelemetry;
+	UpdateStatistics();
+}
+
+JobQueueStatistics JobQueue::GetStatistics() {
+
+	QMutexLocker locker(&mStatisticsMutex);
+	return mStatistics;
 }
 
 JobQueue* JobQueue::GetGlobalInstance() {
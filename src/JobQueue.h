@@ -21,10 +21,46 @@
 #include <QRunnable>
 #include <QVariant>
 #include <QAtomicInteger>
+#include <QElapsedTimer>
+#include <QMetaType>
 
 
 class AbstractJob;
 
+//! Cumulative counters of a single job (or the sum of several jobs). Filled by AbstractJob::ReportBytesRead() etc.
+struct JobTelemetry {
+
+	JobTelemetry() : bytesRead(0), bytesWritten(0), framesProcessed(0), cpuTimeMs(0), wallTimeMs(0) {}
+	JobTelemetry& operator+=(const JobTelemetry &rOther);
+	qint64 bytesRead;
+	qint64 bytesWritten;
+	qint64 framesProcessed;
+	qint64 cpuTimeMs;
+	qint64 wallTimeMs;
+};
+
+//! Snapshot of a running (or finished) JobQueue. Throughput values are averaged over a rolling window.
+struct JobQueueStatistics {
+
+	JobQueueStatistics() : progress(0), finishedJobs(0), jobCount(0), readThroughput(0), writeThroughput(0), frameRate(0), etaMs(-1), currentJob(), total() {}
+	//! Returns a short human readable summary (throughput, ETA, CPU load).
+	QString GetAsString() const;
+	//! The ratio of CPU time to wall time of the finished and running jobs. Values near 1 indicate CPU-bound jobs, values near 0 I/O bound jobs.
+	double GetCpuLoad() const { return total.wallTimeMs > 0 ? (double)total.cpuTimeMs / total.wallTimeMs : 0.; }
+	int progress; // [%]
+	int finishedJobs;
+	int jobCount;
+	double readThroughput; // [Byte/s]
+	double writeThroughput; // [Byte/s]
+	double frameRate; // [frames/s]
+	qint64 etaMs; // -1 if unknown
+	QString currentJob;
+	JobTelemetry total;
+};
+
+Q_DECLARE_METATYPE(JobTelemetry);
+Q_DECLARE_METATYPE(JobQueueStatistics);
+
 class JobQueue : public QThread {
 
 	Q_OBJECT
@@ -41,11 +77,15 @@ public:
 	//! Waits for Queue interruption, removes (and deletes if AbstractJob::SetAutoDelete() is set) all jobs and errors.
 	void FlushQueue();
 	QList<Error> GetErrors();
+	//! Returns the latest statistics of the current or last run. This method is thread safe.
+	JobQueueStatistics GetStatistics();
 	static JobQueue* GetGlobalInstance();
 
 signals:
 	void Progress(int progress);
 	void NextJobStarted(const QString &rDescription);
+	//! Emitted at most every JobQueue::StatisticsInterval ms and once when the queue finished.
+	void Statistics(const JobQueueStatistics &rStatistics);
 
 	public slots:
 	void StartQueue();
@@ -54,12 +94,28 @@ signals:
 
 	private slots:
 	void JobProgress(int progress);
+	void JobTelemetryChanged(const JobTelemetry &rTelemetry);
 
 protected:
 	virtual void run();
 
 private:
 	Q_DISABLE_COPY(JobQueue);
+	static const qint64 StatisticsInterval = 100; // [ms]
+	static const qint64 ThroughputWindow = 5000; // [ms]
+	struct Sample {
+		qint64 timeMs;
+		qint64 progress;
+		JobTelemetry telemetry;
+	};
+	struct JobSummary {
+		QString description;
+		bool success;
+		JobTelemetry telemetry;
+	};
+	//! Must be called from the queue thread.
+	void UpdateStatistics(bool force = false);
+	void WriteRunSummary(bool interrupted);
 
 	QQueue<AbstractJob*> mQueue;
 	QMutex mMutex;
@@ -68,6 +124,18 @@ private:
 	QAtomicInteger<int> mJobProgress;
 	QAtomicInteger<int> mCurrentProgress;
 	QAtomicInteger<int> mInterruptIfError;
+	// Only accessed from the queue thread.
+	QElapsedTimer mRunTimer;
+	qint64 mLastStatisticsEmission;
+	JobTelemetry mFinishedTelemetry;
+	JobTelemetry mCurrentTelemetry;
+	QQueue<Sample> mSamples;
+	QList<JobSummary> mJobSummaries;
+	QString mCurrentJob;
+	int mFinishedJobs;
+	int mJobCount;
+	QMutex mStatisticsMutex;
+	JobQueueStatistics mStatistics;
 };
 
 
@@ -87,9 +155,13 @@ public:
 	//! Don't reimplement this method or make sure that base class implementation is invoked.
 	virtual void run();
 	Error PerformRun();
+	//! Returns the counters of the last run. This method is thread safe.
+	JobTelemetry GetTelemetry();
 
 signals:
 	void Progress(int progress);
+	//! Emitted at most every 100 ms while the job is running and once when the job finished. Connect with Qt::DirectConnection to aggregate the values in the executing thread.
+	void Telemetry(const JobTelemetry &rTelemetry);
 	void Finished(bool success, QPrivateSignal);
 	void Success(QPrivateSignal);
 	void Failure(QPrivateSignal);
@@ -101,13 +173,26 @@ protected:
 	Return empty error if everything went fine. Otherwise return filled error.
 	*/
 	virtual Error Execute() = 0;
+	//! Call these methods from Execute() to inform the JobQueue about the amount of processed data. They are cheap enough to be called for every buffer or frame.
+	void ReportBytesRead(qint64 bytes) { mTelemetry.bytesRead += bytes; TelemetryReported(); }
+	void ReportBytesWritten(qint64 bytes) { mTelemetry.bytesWritten += bytes; TelemetryReported(); }
+	void ReportFramesProcessed(qint64 frames = 1) { mTelemetry.framesProcessed += frames; TelemetryReported(); }
 
 private:
 	Q_DISABLE_COPY(AbstractJob);
 	void SetParent(QObject *pParent) {}
+	void TelemetryReported() { if((++mReportCount & 0x3f) == 0) EmitTelemetry(false); }
+	void EmitTelemetry(bool force);
 
 	QMutex mMutex;
 	Error mError;
 	QString mDescription;
 	QVariant mIdentifier;
+	// Only accessed from the executing thread while the job is running.
+	JobTelemetry mTelemetry;
+	QElapsedTimer mTimer;
+	qint64 mCpuTimeStart;
+	qint64 mLastTelemetryEmission;
+	quint32 mReportCount;
+	JobTelemetry mLastTelemetry;
 };
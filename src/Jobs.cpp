@@ -17,62 +17,107 @@
 #include "Jobs.h"
 #include "AS_02.h"
 #include "Metadata.h"
+#include "TimedTextResourceResolver.h"
+#include "ImageSequence.h"
+#include "XmlParserPool.h"
+#ifdef ARCHIVIST
+#include "AS_02_ACES.h"
+#endif
 #include <vector>
 #include "PCMParserList.h"
 #include "AS_DCP_internal.h"
 #include <QFileInfo>
 #include <QCryptographicHash>
+#include <QDebug>
 #include <QFile>
 #include <QProcess>
 #include <QDir>
+#include <QVector>
+#include <QSet>
+#include <QTextStream>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QMutexLocker>
+#include <QDateTime>
+#include <xercesc/dom/DOM.hpp>
+#include <cstring>
 
-JobCalculateHash::JobCalculateHash(const QString &rSourceFile) :
-AbstractJob(tr("Calculating Hash: %1").arg(QFileInfo(rSourceFile).fileName())), mSourceFile(rSourceFile) {
+#define ACES_READ_AHEAD_SIZE (512 * 1024 * 1024) // [bytes] Upper bound of the frames held by the read ahead.
+#define J2C_READ_AHEAD_SIZE (256 * 1024 * 1024) // [bytes] Upper bound of the codestreams held by the read ahead.
+
+JobCalculateHash::JobCalculateHash(const QString &rSourceFile, bool resumable /*= true*/) :
+AbstractJob(tr("Calculating Hash: %1").arg(QFileInfo(rSourceFile).fileName())), mSourceFile(rSourceFile), mResumable(resumable) {
 
 }
 
 Error JobCalculateHash::Execute() {
 
+	// The stamp is captured now. Checkpoints written for a file that changes while it is hashed are never matched.
+	QFileInfo file_info(mSourceFile);
+	const HashCheckpoints::FileStamp stamp = HashCheckpoints::GetStamp(file_info);
+	const qint64 file_size = file_info.size();
+	HashCheckpoints &r_checkpoints = HashCheckpoints::Instance();
+	if(mResumable == true) {
+		const QByteArray digest = r_checkpoints.GetDigest(file_info);
+		if(digest.isEmpty() == false) {
+			emit Progress(100);
+			emit Result(digest, GetIdentifier());
+			return Error();
+		}
+	}
+
 	QFile file(mSourceFile);
 	if(file.open(QIODevice::ReadOnly) == false) {
 		return Error(Error::SourceFileOpenError, file.fileName());
 	}
 
-	QCryptographicHash hasher(QCryptographicHash::Sha1);
+	Sha1 hasher;
+	if(mResumable == true && r_checkpoints.Restore(file_info, hasher) == true && file.seek(hasher.GetLength()) == false) hasher.Reset();
 
 	Error error;
-	char buffer[16 * 1024];
+	QByteArray buffer(1024 * 1024, Qt::Uninitialized);
 	qint64 count;
-	qint64 file_size = file.size();
-	qint64 bytes_read = 0;
+	qint64 bytes_read = hasher.GetLength();
+	qint64 last_checkpoint = bytes_read;
 	int progress = 0;
 	int last_progress = 0;
-	do {
+	while(bytes_read < file_size) {
 		if(QThread::currentThread()->isInterruptionRequested()) {
 			error = Error(Error::WorkerInterruptionRequest);
 			break;
 		}
-		count = file.read(buffer, sizeof(buffer));
-		if(count == -1) {
+		count = file.read(buffer.data(), buffer.size());
+		if(count <= 0) {
 			error = Error(Error::HashCalculation, tr("Couldn't read file for Hash calculation."));
 			break;
 		}
 		bytes_read += count;
+		ReportBytesRead(count);
 		progress = bytes_read * 100 / file_size;
 		if(progress != last_progress) emit Progress(progress);
 		last_progress = progress;
-		hasher.addData(buffer, count);
-	} while(!file.atEnd());
+		hasher.AddData(buffer.constData(), count);
+		if(mResumable == true && bytes_read - last_checkpoint >= CheckpointInterval) {
+			r_checkpoints.SaveCheckpoint(file_info, stamp, hasher);
+			last_checkpoint = bytes_read;
+		}
+	}
+	file.close();
 
 	if(error.IsError() == false) {
-		emit Result(hasher.result(), GetIdentifier());
+		const QByteArray digest = hasher.Result();
+		if(mResumable == true) r_checkpoints.SaveDigest(file_info, stamp, digest);
+		emit Result(digest, GetIdentifier());
+	}
+	else if(mResumable == true && hasher.GetLength() > last_checkpoint) {
+		// Keep the progress of an interrupted job.
+		r_checkpoints.SaveCheckpoint(file_info, stamp, hasher);
 	}
-	file.close();
 	return error;
 }
 
-JobWrapWav::JobWrapWav(const QStringList &rSourceFiles, const QString &rOutputFile, const SoundfieldGroup &rSoundFieldGroup, const QUuid &rAssetId) :
-AbstractJob(tr("Wrapping %1").arg(QFileInfo(rOutputFile).fileName())), mOutputFile(rOutputFile), mSourceFiles(rSourceFiles), mSoundFieldGoup(rSoundFieldGroup), mWriterInfo() {
+JobWrapWav::JobWrapWav(const QStringList &rSourceFiles, const QString &rOutputFile, const SoundfieldGroup &rSoundFieldGroup, const QUuid &rAssetId, bool analyzeAudio /*= false*/) :
+AbstractJob(tr("Wrapping %1").arg(QFileInfo(rOutputFile).fileName())), mOutputFile(rOutputFile), mSourceFiles(rSourceFiles), mSoundFieldGoup(rSoundFieldGroup), mAnalyzeAudio(analyzeAudio), mWriterInfo() {
 
 	convert_uuid(rAssetId, (unsigned char*)mWriterInfo.AssetUUID);
 }
@@ -134,6 +179,12 @@ Error JobWrapWav::Execute() {
 				result = writer.OpenWrite(output_file.absoluteFilePath().toStdString(), mWriterInfo, essence_descriptor, mca_config, audio_descriptor.EditRate);
 			}
 
+			// The analysis shares the samples read for wrapping. No additional I/O.
+			QSharedPointer<AudioAnalyzer> analyzer;
+			if(ASDCP_SUCCESS(result) && mAnalyzeAudio == true) {
+				analyzer = QSharedPointer<AudioAnalyzer>(new AudioAnalyzer(audio_descriptor.AudioSamplingRate.Quotient(), audio_descriptor.ChannelCount, audio_descriptor.QuantizationBits, AudioAnalyzer::GetChannelWeights(mSoundFieldGoup)));
+			}
+
 			if(ASDCP_SUCCESS(result)) {
 				result = parser.Reset();
 				unsigned int duration = 0;
@@ -150,7 +201,11 @@ Error JobWrapWav::Execute() {
 					}
 					result = parser.ReadFrame(buffer);
 					if(ASDCP_SUCCESS(result)) {
+						ReportBytesRead(buffer.Size());
+						if(analyzer) analyzer->Process(buffer.RoData(), buffer.Size() / audio_descriptor.BlockAlign);
 						result = writer.WriteFrame(buffer);
+						ReportBytesWritten(buffer.Size());
+						ReportFramesProcessed();
 						progress = frame_num * 100 / audio_descriptor.ContainerDuration;
 						if(progress != last_progress) emit Progress(progress);
 						last_progress = progress;
@@ -164,6 +219,7 @@ Error JobWrapWav::Execute() {
 				writer.Finalize();
 				QFile::remove(output_file.absoluteFilePath());
 			}
+			if(ASDCP_SUCCESS(result) && analyzer) emit AudioAnalysisFinished(analyzer->Finish());
 		}
 		else error = Error(Error::SoundfieldGroupIncomplete, mSoundFieldGoup.GetAsString());
 	}
@@ -194,9 +250,10 @@ Error JobWrapTimedText::Execute() {
 	QFileInfo output_file(mOutputFile);
 	QFileInfo file_info(mSourceFiles.first());
 
-	//We need to change the working directory to resolve the ancillary resources!
-	QString dirCopyPath = QDir::currentPath();
-	QDir::setCurrent(file_info.absolutePath());
+	// Ancillary resources are resolved relative to the TTML document. The process wide working directory is never touched so several jobs may run concurrently.
+	TimedTextResourceResolver resolver;
+	error = resolver.Open(file_info.absolutePath());
+	if(error.IsError() == true) return error;
 
 	Result_t result = Parser.OpenRead(file_info.absoluteFilePath().toStdString());
 	result = Parser.FillTimedTextDescriptor(TDesc);
@@ -214,17 +271,23 @@ Error JobWrapTimedText::Execute() {
 
 		result = Parser.ReadTimedTextResource(XMLDoc);
 		if(ASDCP_SUCCESS(result)){
+			ReportBytesRead(XMLDoc.size());
 			result = Writer.WriteTimedTextResource(XMLDoc);
+			ReportBytesWritten(XMLDoc.size());
+			ReportFramesProcessed();
 
 			if(ASDCP_SUCCESS(result)){
 
 				for (ri = TDesc.ResourceList.begin(); ri != TDesc.ResourceList.end() && ASDCP_SUCCESS(result); ri++){
 
-					result = Parser.ReadAncillaryResource((*ri).ResourceID, buffer);
+					result = Parser.ReadAncillaryResource((*ri).ResourceID, buffer, &resolver);
 
 					if(ASDCP_SUCCESS(result)){
 
+						ReportBytesRead(buffer.Size());
 						result = Writer.WriteAncillaryResource(buffer);
+						ReportBytesWritten(buffer.Size());
+						ReportFramesProcessed();
 						if(ASDCP_FAILURE(result)) error = Error(result);
 					}
 					else { error = Error(result); QFile::remove(output_file.absoluteFilePath()); }
@@ -239,9 +302,897 @@ Error JobWrapTimedText::Execute() {
 	result = Writer.Finalize();
 	if(ASDCP_FAILURE(result)) { error = Error(result); QFile::remove(output_file.absoluteFilePath()); }
 
-	//return to default working directory
-	QDir::setCurrent(dirCopyPath);
+	return error;
+}
+
+namespace
+{
+	//! The parts of the JPEG 2000 main header (SIZ and COD marker segments) relevant for wrapping.
+	struct J2cMainHeader {
+
+		J2cMainHeader() : rsiz(0), width(0), height(0), componentCount(0), depth(), horizontalSubsampling(), verticalSubsampling(),
+			progressionOrder(0), layerCount(0), multipleComponentTransformation(false), decompositionLevels(0), transformation(0) {}
+		//! Everything that must be identical for all frames of a track file.
+		QByteArray GetSignature() const {
+
+			QByteArray signature = QString("rsiz=%1;progression=%2;layers=%3;mct=%4;levels=%5;transformation=%6").arg(rsiz).arg(progressionOrder).arg(layerCount)
+				.arg(multipleComponentTransformation).arg(decompositionLevels).arg(transformation).toLatin1();
+			for(int i = 0; i < componentCount; i++) signature.append(QString(";c%1=%2/%3x%4").arg(i).arg(depth.at(i)).arg(horizontalSubsampling.at(i)).arg(verticalSubsampling.at(i)).toLatin1());
+			return signature;
+		}
+
+		quint16 rsiz;
+		quint32 width;
+		quint32 height;
+		int componentCount;
+		QVector<int> depth; // Bits, without sign
+		QVector<int> horizontalSubsampling;
+		QVector<int> verticalSubsampling;
+		int progressionOrder;
+		int layerCount;
+		bool multipleComponentTransformation;
+		int decompositionLevels;
+		int transformation; // 0: 9-7 irreversible, 1: 5-3 reversible
+	};
+
+	quint32 to_be(const QByteArray &rData, int position, int size) {
+
+		quint32 value = 0;
+		for(int i = 0; i < size; i++) value = (value << 8) | (quint8)rData.at(position + i);
+		return value;
+	}
+
+	//! Reads the main header up to the first tile part. Only SIZ and COD are evaluated.
+	Error parse_j2c_main_header(QIODevice &rDevice, J2cMainHeader &rHeader) {
+
+		QByteArray marker = rDevice.read(2);
+		if(marker.size() != 2 || to_be(marker, 0, 2) != 0xff4f) return Error(Error::UnsupportedEssence, QObject::tr("Not a JPEG 2000 codestream"));
+		bool has_siz = false;
+		bool has_cod = false;
+		while(has_siz == false || has_cod == false) {
+			const QByteArray marker_and_length = rDevice.read(4);
+			if(marker_and_length.size() != 4) return Error(Error::UnsupportedEssence, QObject::tr("Truncated JPEG 2000 main header"));
+			const quint32 marker_code = to_be(marker_and_length, 0, 2);
+			const int length = to_be(marker_and_length, 2, 2) - 2;
+			if(marker_code == 0xff90 || length < 0) break; // First tile part
+			const QByteArray segment = rDevice.read(length);
+			if(segment.size() != length) return Error(Error::UnsupportedEssence, QObject::tr("Truncated JPEG 2000 main header"));
+			if(marker_code == 0xff51 && length >= 36) { // SIZ
+				rHeader.rsiz = to_be(segment, 0, 2);
+				rHeader.width = to_be(segment, 2, 4) - to_be(segment, 10, 4);
+				rHeader.height = to_be(segment, 6, 4) - to_be(segment, 14, 4);
+				rHeader.componentCount = to_be(segment, 34, 2);
+				if(length < 36 + 3 * rHeader.componentCount) return Error(Error::UnsupportedEssence, QObject::tr("Invalid SIZ marker segment"));
+				for(int i = 0; i < rHeader.componentCount; i++) {
+					rHeader.depth << (to_be(segment, 36 + 3 * i, 1) & 0x7f) + 1;
+					rHeader.horizontalSubsampling << to_be(segment, 37 + 3 * i, 1);
+					rHeader.verticalSubsampling << to_be(segment, 38 + 3 * i, 1);
+				}
+				has_siz = true;
+			}
+			else if(marker_code == 0xff52 && length >= 10) { // COD
+				rHeader.progressionOrder = to_be(segment, 1, 1);
+				rHeader.layerCount = to_be(segment, 2, 2);
+				rHeader.multipleComponentTransformation = (to_be(segment, 4, 1) != 0);
+				rHeader.decompositionLevels = to_be(segment, 5, 1);
+				rHeader.transformation = to_be(segment, 9, 1);
+				has_cod = true;
+			}
+		}
+		if(has_siz == false || has_cod == false) return Error(Error::UnsupportedEssence, QObject::tr("SIZ or COD marker segment missing"));
+		if(rHeader.rsiz & 0x8000) return Error(Error::UnsupportedEssence, QObject::tr("JPEG 2000 Part 2 codestreams are not supported"));
+		if(rHeader.componentCount != 3 && rHeader.componentCount != 4) return Error(Error::UnsupportedEssence, QObject::tr("Unsupported number of components: %1").arg(rHeader.componentCount));
+		for(int i = 1; i < rHeader.componentCount; i++) {
+			if(rHeader.depth.at(i) != rHeader.depth.first()) return Error(Error::UnsupportedEssence, QObject::tr("Components have different bit depths"));
+		}
+		return Error();
+	}
+
+	class J2cHeaderValidator : public ImageSequenceValidator {
+
+	public:
+		J2cHeaderValidator() : ImageSequenceValidator() {}
+		virtual ~J2cHeaderValidator() {}
+
+	protected:
+		virtual Error ParseHeader(QIODevice &rDevice, ImageSequenceFormat &rFormat) const {
+
+			J2cMainHeader header;
+			Error error = parse_j2c_main_header(rDevice, header);
+			if(error.IsError() == true) return error;
+			rFormat.width = header.width;
+			rFormat.height = header.height;
+			rFormat.components = header.GetSignature();
+			return Error();
+		}
+
+	private:
+		Q_DISABLE_COPY(J2cHeaderValidator);
+	};
+}
+
+JobWrapJ2c::JobWrapJ2c(const QStringList &rSourceFiles, const QString &rOutputFile, const EditRate &rFrameRate, const QUuid &rAssetId) :
+AbstractJob(tr("Wrapping %1").arg(QFileInfo(rOutputFile).fileName())), mOutputFile(rOutputFile), mSourceFiles(rSourceFiles), mFrameRate(rFrameRate), mWriterInfo() {
+
+	convert_uuid(rAssetId, (unsigned char*)mWriterInfo.AssetUUID);
+}
+
+Error JobWrapJ2c::Execute() {
+
+	if(mFrameRate.IsValid() == false) return Error(Error::Unknown, tr("Invalid frame rate"));
+	QStringList frames;
+	Error error = ImageSequence::Scan(mSourceFiles, "j2c", frames);
+	if(error.IsError() == true) return error;
+	ImageSequenceFormat format;
+	J2cHeaderValidator validator;
+	error = validator.Validate(frames, format);
+	if(error.IsError() == true) return error;
+	if(QThread::currentThread()->isInterruptionRequested()) return Error(Error::WorkerInterruptionRequest);
+	J2cMainHeader header;
+	QFile first_frame(frames.first());
+	if(first_frame.open(QIODevice::ReadOnly) == false) return Error(Error::SourceFileOpenError, first_frame.fileName());
+	error = parse_j2c_main_header(first_frame, header);
+	first_frame.close();
+	if(error.IsError() == true) return error;
+
+	QFileInfo output_file(mOutputFile);
+	if(output_file.exists() && output_file.isFile() && !output_file.isSymLink()) QFile::remove(output_file.absoluteFilePath());
+	ASDCP::JP2K::CodestreamParser parser;
+	ASDCP::JP2K::PictureDescriptor picture_descriptor;
+	ASDCP::JP2K::FrameBuffer buffer;
+	const ASDCP::Dictionary *dict = &ASDCP::DefaultSMPTEDict();
+	ASDCP::MXF::InterchangeObject_list_t essence_sub_descriptors;
+	ASDCP::MXF::FileDescriptor *essence_descriptor = NULL;
+	AS_02::JP2K::MXFWriter writer;
+	const ASDCP::Rational edit_rate(mFrameRate.GetNumerator(), mFrameRate.GetDenominator());
+	Result_t result = buffer.Capacity(format.frameSize);
+	if(ASDCP_SUCCESS(result)) result = parser.OpenReadFrame(frames.first().toStdString(), buffer);
+	if(ASDCP_SUCCESS(result)) result = parser.FillPictureDescriptor(picture_descriptor);
+	if(ASDCP_FAILURE(result)) return Error(result);
+	picture_descriptor.EditRate = edit_rate;
+	picture_descriptor.SampleRate = edit_rate;
+	picture_descriptor.ContainerDuration = frames.size();
+	essence_sub_descriptors.push_back(new ASDCP::MXF::JPEG2000PictureSubDescriptor(dict));
+	ASDCP::MXF::JPEG2000PictureSubDescriptor *p_sub_descriptor = static_cast<ASDCP::MXF::JPEG2000PictureSubDescriptor*>(essence_sub_descriptors.back());
+	const int depth = header.depth.first();
+	if(header.multipleComponentTransformation == true) {
+		ASDCP::MXF::RGBAEssenceDescriptor *p_rgba_descriptor = new ASDCP::MXF::RGBAEssenceDescriptor(dict);
+		result = ASDCP::JP2K_PDesc_to_MD(picture_descriptor, *dict, *p_rgba_descriptor, *p_sub_descriptor);
+		p_rgba_descriptor->ComponentMaxRef = (1 << depth) - 1;
+		p_rgba_descriptor->ComponentMinRef = 0;
+		essence_descriptor = p_rgba_descriptor;
+	}
+	else {
+		// Narrow range YCbCr (ITU-R BT.709 levels) scaled to the component depth.
+		ASDCP::MXF::CDCIEssenceDescriptor *p_cdci_descriptor = new ASDCP::MXF::CDCIEssenceDescriptor(dict);
+		result = ASDCP::JP2K_PDesc_to_MD(picture_descriptor, *dict, *p_cdci_descriptor, *p_sub_descriptor);
+		p_cdci_descriptor->ComponentDepth = depth;
+		p_cdci_descriptor->HorizontalSubsampling = header.horizontalSubsampling.at(1);
+		p_cdci_descriptor->VerticalSubsampling = header.verticalSubsampling.at(1);
+		const int shift = qMax(0, depth - 8);
+		p_cdci_descriptor->BlackRefLevel = 16 << shift;
+		p_cdci_descriptor->WhiteReflevel = 235 << shift;
+		p_cdci_descriptor->ColorRange = ((240 - 16) << shift) + 1;
+		essence_descriptor = p_cdci_descriptor;
+	}
+	if(ASDCP_SUCCESS(result)) result = writer.OpenWrite(output_file.absoluteFilePath().toStdString(), mWriterInfo, essence_descriptor, essence_sub_descriptors, edit_rate);
+	if(ASDCP_FAILURE(result)) {
+		// MXFWriter doesn't free the descriptors if OpenWrite() fails or wasn't called.
+		delete essence_descriptor;
+		for(ASDCP::MXF::InterchangeObject_list_t::iterator i = essence_sub_descriptors.begin(); i != essence_sub_descriptors.end(); ++i) delete *i;
+		return Error(result);
+	}
+
+	// Storage reads overlap with the MXF writer.
+	ImageSequenceReadAhead read_ahead(frames, qBound(4, (int)(J2C_READ_AHEAD_SIZE / qMax((qint64)1, format.frameSize)), 64), 2);
+	read_ahead.Start();
+	QByteArray frame_data;
+	int progress = 0;
+	int last_progress = 0;
+	for(int i = 0; i < frames.size() && ASDCP_SUCCESS(result); i++) {
+		if(QThread::currentThread()->isInterruptionRequested()) {
+			error = Error(Error::WorkerInterruptionRequest);
+			break;
+		}
+		error = read_ahead.Take(i, frame_data);
+		if(error.IsError() == true) break;
+		ReportBytesRead(frame_data.size());
+		result = buffer.Capacity(frame_data.size());
+		if(ASDCP_SUCCESS(result)) {
+			memcpy(buffer.Data(), frame_data.constData(), frame_data.size());
+			buffer.Size(frame_data.size());
+			result = writer.WriteFrame(buffer);
+		}
+		if(ASDCP_SUCCESS(result)) {
+			ReportBytesWritten(frame_data.size());
+			ReportFramesProcessed();
+		}
+		progress = (i + 1) * 95 / frames.size(); // The last 5 % are left for the hash.
+		if(progress != last_progress) emit Progress(progress);
+		last_progress = progress;
+	}
+	read_ahead.Stop();
+	if(ASDCP_FAILURE(result) && error.IsError() == false) error = Error(result);
+	result = writer.Finalize();
+	if(ASDCP_FAILURE(result) && error.IsError() == false) error = Error(result);
+	QByteArray hash;
+	if(error.IsError() == false) error = Hash(output_file.absoluteFilePath(), hash);
+	if(error.IsError() == true) {
+		QFile::remove(output_file.absoluteFilePath());
+		return error;
+	}
+	emit Result(hash, GetIdentifier());
+	return error;
+}
+
+Error JobWrapJ2c::Hash(const QString &rFilePath, QByteArray &rHash) {
+
+	// The header partition is rewritten by MXFWriter::Finalize(). The file can't be hashed before.
+	QFile file(rFilePath);
+	if(file.open(QIODevice::ReadOnly | QIODevice::Unbuffered) == false) return Error(Error::HashCalculation, rFilePath);
+	QCryptographicHash hasher(QCryptographicHash::Sha1);
+	QByteArray buffer(4 * 1024 * 1024, Qt::Uninitialized);
+	qint64 count = 0;
+	while((count = file.read(buffer.data(), buffer.size())) > 0) {
+		if(QThread::currentThread()->isInterruptionRequested()) return Error(Error::WorkerInterruptionRequest);
+		hasher.addData(buffer.constData(), count);
+		ReportBytesRead(count);
+	}
+	if(count < 0) return Error(Error::HashCalculation, tr("Couldn't read file for Hash calculation."));
+	rHash = hasher.result();
+	return Error();
+}
+
+#ifdef ARCHIVIST
+namespace
+{
+	qint32 to_le32(const char *pData) {
 
+		const unsigned char *p_bytes = (const unsigned char*)pData;
+		return (qint32)((quint32)p_bytes[0] | ((quint32)p_bytes[1] << 8) | ((quint32)p_bytes[2] << 16) | ((quint32)p_bytes[3] << 24));
+	}
+
+	bool read_le32(QIODevice &rDevice, qint32 &rValue) {
+
+		char bytes[4];
+		if(rDevice.read(bytes, 4) != 4) return false;
+		rValue = to_le32(bytes);
+		return true;
+	}
+
+	//! Reads a null terminated OpenEXR attribute name or type (at most 255 characters).
+	bool read_name(QIODevice &rDevice, QByteArray &rName) {
+
+		rName.clear();
+		char c = 0;
+		while(rDevice.getChar(&c) == true) {
+			if(c == 0) return true;
+			if(rName.size() >= 255) return false;
+			rName.append(c);
+		}
+		return false;
+	}
+
+	//! Checks the constraints of SMPTE ST 2065-4: single part scan line image, no compression, HALF channels B, G, R and optionally A.
+	class AcesHeaderValidator : public ImageSequenceValidator {
+
+	public:
+		AcesHeaderValidator() : ImageSequenceValidator() {}
+		virtual ~AcesHeaderValidator() {}
+
+	protected:
+		virtual Error ParseHeader(QIODevice &rDevice, ImageSequenceFormat &rFormat) const {
+
+			qint32 magic = 0;
+			qint32 version = 0;
+			if(read_le32(rDevice, magic) == false || magic != 20000630) return Error(Error::UnsupportedEssence, QObject::tr("Not an OpenEXR file"));
+			if(read_le32(rDevice, version) == false || (version & 0xff) != 2) return Error(Error::UnsupportedEssence, QObject::tr("Unsupported OpenEXR version"));
+			if(version & (0x200 | 0x800 | 0x1000)) return Error(Error::UnsupportedEssence, QObject::tr("Tiled, deep or multi part OpenEXR files are not ACES compliant"));
+			bool has_data_window = false;
+			bool has_compression = false;
+			QByteArray name;
+			QByteArray type;
+			rFormat.components.clear();
+			while(true) {
+				if(read_name(rDevice, name) == false) return Error(Error::UnsupportedEssence, QObject::tr("Truncated OpenEXR header"));
+				if(name.isEmpty() == true) break; // End of header
+				qint32 size = 0;
+				if(read_name(rDevice, type) == false || read_le32(rDevice, size) == false || size < 0) return Error(Error::UnsupportedEssence, QObject::tr("Truncated OpenEXR header"));
+				const QByteArray value = rDevice.read(size);
+				if(value.size() != size) return Error(Error::UnsupportedEssence, QObject::tr("Truncated OpenEXR header"));
+				if(name == "channels" && type == "chlist") {
+					// Channel name, pixel type (int), pLinear (uchar), reserved (3 x char), x sampling (int), y sampling (int)
+					int position = 0;
+					while(position < value.size() && value.at(position) != 0) {
+						const int name_end = value.indexOf('\0', position);
+						if(name_end < 0 || name_end + 17 > value.size()) return Error(Error::UnsupportedEssence, QObject::tr("Invalid channel list"));
+						const QByteArray channel = value.mid(position, name_end - position);
+						if(to_le32(value.constData() + name_end + 1) != 1) return Error(Error::UnsupportedEssence, QObject::tr("Channel %1 is not HALF").arg(QString(channel)));
+						if(to_le32(value.constData() + name_end + 9) != 1 || to_le32(value.constData() + name_end + 13) != 1) return Error(Error::UnsupportedEssence, QObject::tr("Channel %1 is subsampled").arg(QString(channel)));
+						if(rFormat.components.isEmpty() == false) rFormat.components.append(',');
+						rFormat.components.append(channel);
+						position = name_end + 17;
+					}
+				}
+				else if(name == "compression" && type == "compression" && size == 1) {
+					if(value.at(0) != 0) return Error(Error::UnsupportedEssence, QObject::tr("Compressed OpenEXR files are not ACES compliant"));
+					has_compression = true;
+				}
+				else if(name == "dataWindow" && type == "box2i" && size == 16) {
+					const qint32 x_min = to_le32(value.constData());
+					const qint32 y_min = to_le32(value.constData() + 4);
+					const qint32 x_max = to_le32(value.constData() + 8);
+					const qint32 y_max = to_le32(value.constData() + 12);
+					if(x_max < x_min || y_max < y_min) return Error(Error::UnsupportedEssence, QObject::tr("Invalid data window"));
+					rFormat.width = x_max - x_min + 1;
+					rFormat.height = y_max - y_min + 1;
+					has_data_window = true;
+				}
+			}
+			// Channels are stored in alphabetical order.
+			if(rFormat.components != "B,G,R" && rFormat.components != "A,B,G,R") return Error(Error::UnsupportedEssence, QObject::tr("Unsupported channels %1").arg(QString(rFormat.components)));
+			if(has_data_window == false || has_compression == false) return Error(Error::UnsupportedEssence, QObject::tr("Mandatory OpenEXR attribute missing"));
+			return Error();
+		}
+
+	private:
+		Q_DISABLE_COPY(AcesHeaderValidator);
+	};
+}
+
+JobWrapAces::JobWrapAces(const QStringList &rSourceFiles, const QString &rOutputFile, const EditRate &rFrameRate, const QUuid &rAssetId) :
+AbstractJob(tr("Wrapping %1").arg(QFileInfo(rOutputFile).fileName())), mOutputFile(rOutputFile), mSourceFiles(rSourceFiles), mFrameRate(rFrameRate), mWriterInfo() {
+
+	convert_uuid(rAssetId, (unsigned char*)mWriterInfo.AssetUUID);
+}
+
+Error JobWrapAces::Execute() {
+
+	if(mFrameRate.IsValid() == false) return Error(Error::Unknown, tr("Invalid frame rate"));
+	QStringList frames;
+	Error error = ImageSequence::Scan(mSourceFiles, "exr", frames);
+	if(error.IsError() == true) return error;
+	ImageSequenceFormat format;
+	AcesHeaderValidator validator;
+	error = validator.Validate(frames, format);
+	if(error.IsError() == true) return error;
+	if(QThread::currentThread()->isInterruptionRequested()) return Error(Error::WorkerInterruptionRequest);
+
+	QFileInfo output_file(mOutputFile);
+	if(output_file.exists() && output_file.isFile() && !output_file.isSymLink()) QFile::remove(output_file.absoluteFilePath());
+	// The picture descriptor is derived from the first frame. The headers of all frames are compatible.
+	AS_02::ACES::CodestreamParser parser;
+	AS_02::ACES::PictureDescriptor picture_descriptor;
+	AS_02::ACES::FrameBuffer buffer;
+	const ASDCP::Dictionary *dict = &ASDCP::DefaultSMPTEDict();
+	ASDCP::MXF::InterchangeObject_list_t essence_sub_descriptors;
+	AS_02::ACES::MXFWriter writer;
+	const ASDCP::Rational edit_rate(mFrameRate.GetNumerator(), mFrameRate.GetDenominator());
+	Result_t result = buffer.Capacity(format.frameSize);
+	if(ASDCP_SUCCESS(result)) result = parser.OpenReadFrame(frames.first().toStdString(), buffer);
+	if(ASDCP_SUCCESS(result)) result = parser.FillPictureDescriptor(picture_descriptor);
+	if(ASDCP_FAILURE(result)) return Error(result);
+	picture_descriptor.EditRate = edit_rate;
+	picture_descriptor.ContainerDuration = frames.size();
+	ASDCP::MXF::RGBAEssenceDescriptor *essence_descriptor = new ASDCP::MXF::RGBAEssenceDescriptor(dict);
+	result = AS_02::ACES::ACES_PDesc_to_MD(picture_descriptor, *dict, *essence_descriptor);
+	if(ASDCP_SUCCESS(result)) result = writer.OpenWrite(output_file.absoluteFilePath().toStdString(), mWriterInfo, essence_descriptor, essence_sub_descriptors, edit_rate);
+	else delete essence_descriptor;
+	if(ASDCP_FAILURE(result)) return Error(result);
+
+	// Storage reads overlap with the MXF writer. At least two frames, at most ACES_READ_AHEAD_SIZE bytes.
+	ImageSequenceReadAhead read_ahead(frames, qBound(2, (int)(ACES_READ_AHEAD_SIZE / qMax((qint64)1, format.frameSize)), 32), 2);
+	read_ahead.Start();
+	QByteArray frame_data;
+	int progress = 0;
+	int last_progress = 0;
+	for(int i = 0; i < frames.size() && ASDCP_SUCCESS(result); i++) {
+		if(QThread::currentThread()->isInterruptionRequested()) {
+			error = Error(Error::WorkerInterruptionRequest);
+			break;
+		}
+		error = read_ahead.Take(i, frame_data);
+		if(error.IsError() == true) break;
+		ReportBytesRead(frame_data.size());
+		result = buffer.Capacity(frame_data.size());
+		if(ASDCP_SUCCESS(result)) {
+			memcpy(buffer.Data(), frame_data.constData(), frame_data.size());
+			buffer.Size(frame_data.size());
+			result = writer.WriteFrame(buffer);
+		}
+		if(ASDCP_SUCCESS(result)) {
+			ReportBytesWritten(frame_data.size());
+			ReportFramesProcessed();
+		}
+		progress = (i + 1) * 100 / frames.size();
+		if(progress != last_progress) emit Progress(progress);
+		last_progress = progress;
+	}
+	read_ahead.Stop();
+	if(ASDCP_FAILURE(result) && error.IsError() == false) error = Error(result);
+	result = writer.Finalize();
+	if(ASDCP_FAILURE(result) && error.IsError() == false) error = Error(result);
+	if(error.IsError() == true) QFile::remove(output_file.absoluteFilePath());
 	return error;
 }
+#endif // ARCHIVIST
+
+JobWriteCpl::JobWriteCpl(const QSharedPointer<cpl::CompositionPlaylistType> &rCpl, const QString &rDestination, const QByteArray &rPreviousHash /*= QByteArray()*/, bool stage /*= false*/) :
+AbstractJob(tr("Writing CPL: %1").arg(QFileInfo(rDestination).fileName())), mpCpl(rCpl), mDestination(rDestination), mPreviousHash(rPreviousHash), mStage(stage) {
+
+}
+
+Error JobWriteCpl::Execute() {
+
+	QByteArray data;
+	QByteArray digest;
+	if(mPreviousHash.isEmpty() == false) {
+		// Serialize with the previous issue date first. If the digest matches the file on disk nothing was edited.
+		ImfError imf_error = serialize_cpl(*mpCpl, data);
+		if(imf_error.IsError() == true) return Error(Error::XMLSchemeError, imf_error.GetErrorDescription());
+		digest = QCryptographicHash::hash(data, QCryptographicHash::Sha1);
+		if(digest == mPreviousHash) {
+			emit Result(digest, QByteArray(), false, GetIdentifier());
+			return Error();
+		}
+	}
+	if(QThread::currentThread()->isInterruptionRequested()) return Error(Error::WorkerInterruptionRequest);
+	mpCpl->setIssueDate(ImfXmlHelper::Convert(QDateTime::currentDateTimeUtc()));
+	ImfError imf_error = serialize_cpl(*mpCpl, data);
+	if(imf_error.IsError() == true) return Error(Error::XMLSchemeError, imf_error.GetErrorDescription());
+	digest = QCryptographicHash::hash(data, QCryptographicHash::Sha1);
+	if(mStage == false) {
+		PackageTransaction transaction;
+		imf_error = transaction.Stage(mDestination, data);
+		if(imf_error.IsError() == false) imf_error = transaction.Commit();
+		if(imf_error.IsError() == true) return Error(Error::DestinationFileOpenError, imf_error.GetErrorDescription());
+		ReportBytesWritten(data.size());
+	}
+	emit Result(digest, data, true, GetIdentifier());
+	return Error();
+}
+
+JobExportPackage::JobExportPackage(const QString &rTargetDir) :
+AbstractJob(tr("Exporting package: %1").arg(QDir(rTargetDir).dirName())), mTargetDir(rTargetDir), mFirstMethod(FileCloner::Reflink), mFiles(), mDocuments(), mTotalSize(0), mBytesCopied(0), mLastProgress(0) {
+
+	for(int i = 0; i < FileCloner::MethodCount; i++) mMethodCount[i] = 0;
+}
+
+void JobExportPackage::AddFile(const QString &rSource, const QString &rDestination) {
 
+	mFiles << qMakePair(rSource, rDestination);
+}
+
+void JobExportPackage::AddDocument(const QString &rDestination, const QByteArray &rData) {
+
+	mDocuments << qMakePair(rDestination, rData);
+}
+
+Error JobExportPackage::Execute() {
+
+	if(QDir().mkpath(mTargetDir) == false) return Error(Error::DestinationFileOpenError, tr("Couldn't create directory %1.").arg(mTargetDir));
+	for(int i = 0; i < mDocuments.size(); i++) {
+		if(QFileInfo::exists(mDocuments.at(i).first) == true) return Error(Error::DestinationFileOpenError, tr("%1 already exists.").arg(mDocuments.at(i).first));
+	}
+	mTotalSize = 0;
+	mBytesCopied = 0;
+	mLastProgress = 0;
+	for(int i = 0; i < FileCloner::MethodCount; i++) mMethodCount[i] = 0;
+	for(int i = 0; i < mFiles.size(); i++) mTotalSize += QFileInfo(mFiles.at(i).first).size();
+
+	Error error;
+	for(int i = 0; i < mFiles.size(); i++) {
+		if(QThread::currentThread()->isInterruptionRequested()) {
+			error = Error(Error::WorkerInterruptionRequest);
+			break;
+		}
+		FileCloner::eMethod method = FileCloner::Stream;
+		error = FileCloner::Clone(mFiles.at(i).first, mFiles.at(i).second, method, mFirstMethod, this);
+		if(error.IsError() == true) break;
+		mMethodCount[method]++;
+	}
+	if(error.IsError() == true) return error;
+
+	PackageTransaction transaction;
+	ImfError imf_error;
+	for(int i = 0; i < mDocuments.size() && imf_error.IsError() == false; i++) {
+		imf_error = transaction.Stage(mDocuments.at(i).first, mDocuments.at(i).second);
+		ReportBytesWritten(mDocuments.at(i).second.size());
+	}
+	if(imf_error.IsError() == false) imf_error = transaction.Commit();
+	if(imf_error.IsError() == true) return Error(Error::DestinationFileOpenError, imf_error.GetErrorDescription());
+
+	QStringList summary;
+	for(int i = 0; i < FileCloner::MethodCount; i++) {
+		if(mMethodCount[i] > 0) summary << QString("%1: %2").arg(FileCloner::GetMethodName((FileCloner::eMethod)i)).arg(mMethodCount[i]);
+	}
+	emit Result(summary.join(", "), GetIdentifier());
+	return Error();
+}
+
+bool JobExportPackage::BytesCopied(qint64 bytes) {
+
+	mBytesCopied += bytes;
+	ReportBytesWritten(bytes);
+	if(mTotalSize > 0) {
+		int progress = mBytesCopied * 100 / mTotalSize;
+		if(progress != mLastProgress) emit Progress(progress);
+		mLastProgress = progress;
+	}
+	return QThread::currentThread()->isInterruptionRequested() == false;
+}
+
+namespace {
+
+QString to_qstring(const XMLCh *pString) {
+
+	if(pString == NULL) return QString();
+	return QString::fromUtf16(reinterpret_cast<const ushort*>(pString));
+}
+
+void set_text(xercesc::DOMElement *pElement, const QString &rText) {
+
+	pElement->setTextContent(reinterpret_cast<const XMLCh*>(rText.utf16()));
+}
+
+// Accepts plain UUIDs, UUIDs in braces and urn:uuid: URNs.
+QUuid parse_uuid(const QString &rText) {
+
+	return QUuid(rText.trimmed().split(':').last());
+}
+
+QString urn(const QUuid &rId) {
+
+	return QString("urn:uuid:").append(strip_uuid(rId));
+}
+
+xercesc::DOMElement* child_element(xercesc::DOMElement *pParent, const QString &rLocalName) {
+
+	for(xercesc::DOMElement *p_child = pParent->getFirstElementChild(); p_child != NULL; p_child = p_child->getNextElementSibling()) {
+		if(to_qstring(p_child->getLocalName()) == rLocalName) return p_child;
+	}
+	return NULL;
+}
+
+// Integer content of the child element rLocalName or defaultValue if the element is missing or isn't an integer.
+qint64 child_integer(xercesc::DOMElement *pParent, const QString &rLocalName, qint64 defaultValue) {
+
+	xercesc::DOMElement *p_child = child_element(pParent, rLocalName);
+	if(p_child == NULL) return defaultValue;
+	bool ok = false;
+	const qint64 value = to_qstring(p_child->getTextContent()).trimmed().toLongLong(&ok);
+	return ok == true ? value : defaultValue;
+}
+
+// Edit rate of a resource ("<numerator> <denominator>") or rDefault if the resource doesn't carry one.
+EditRate resource_edit_rate(xercesc::DOMElement *pResource, const EditRate &rDefault) {
+
+	xercesc::DOMElement *p_edit_rate = child_element(pResource, "EditRate");
+	if(p_edit_rate == NULL) return rDefault;
+	const QStringList fields = to_qstring(p_edit_rate->getTextContent()).simplified().split(' ');
+	if(fields.size() != 2) return EditRate();
+	return EditRate(fields.at(0).toInt(), fields.at(1).toInt());
+}
+
+// Resource elements of a virtual track sequence (wildcard content of the SequenceList).
+QList<xercesc::DOMElement*> resource_elements(xercesc::DOMElement *pSequence) {
+
+	QList<xercesc::DOMElement*> resources;
+	xercesc::DOMElement *p_resource_list = child_element(pSequence, "ResourceList");
+	if(p_resource_list == NULL) return resources;
+	for(xercesc::DOMElement *p_child = p_resource_list->getFirstElementChild(); p_child != NULL; p_child = p_child->getNextElementSibling()) {
+		if(to_qstring(p_child->getLocalName()) == "Resource") resources << p_child;
+	}
+	return resources;
+}
+
+QStringList split_row(const QString &rLine, QChar separator) {
+
+	QStringList fields;
+	QString field;
+	bool quoted = false;
+	for(int i = 0; i < rLine.size(); i++) {
+		const QChar c = rLine.at(i);
+		if(quoted == true) {
+			if(c != '"') field.append(c);
+			else if(i + 1 < rLine.size() && rLine.at(i + 1) == '"') field.append(rLine.at(++i));
+			else quoted = false;
+		}
+		else if(c == '"') quoted = true;
+		else if(c == separator) {
+			fields << field;
+			field.clear();
+		}
+		else field.append(c);
+	}
+	fields << field;
+	return fields;
+}
+}
+
+class JobGenerateCplVariants::VariantTask : public QRunnable {
+
+public:
+	VariantTask(const JobGenerateCplVariants *pJob, const cpl::CompositionPlaylistType *pTemplate, QMutex *pTemplateMutex, int index, const QUuid &rId, QByteArray *pData, QByteArray *pHash, Error *pError, QAtomicInt *pDone, QAtomicInt *pAbort) :
+		QRunnable(), mpJob(pJob), mpTemplate(pTemplate), mpTemplateMutex(pTemplateMutex), mIndex(index), mId(rId), mpData(pData), mpHash(pHash), mpError(pError), mpDone(pDone), mpAbort(pAbort) {}
+	virtual ~VariantTask() {}
+	virtual void run() {
+
+		if(mpAbort->load() == 0) {
+			*mpError = mpJob->BuildVariant(*mpTemplate, *mpTemplateMutex, mpJob->mVariants.at(mIndex), mId, *mpData);
+			if(mpError->IsError() == true) mpAbort->store(1);
+			else *mpHash = QCryptographicHash::hash(*mpData, QCryptographicHash::Sha1);
+		}
+		mpDone->fetchAndAddOrdered(1);
+	}
+
+private:
+	Q_DISABLE_COPY(VariantTask);
+	const JobGenerateCplVariants *mpJob;
+	const cpl::CompositionPlaylistType *mpTemplate;
+	QMutex *mpTemplateMutex;
+	const int mIndex;
+	const QUuid mId;
+	QByteArray *mpData;
+	QByteArray *mpHash;
+	Error *mpError;
+	QAtomicInt *mpDone;
+	QAtomicInt *mpAbort;
+};
+
+JobGenerateCplVariants::JobGenerateCplVariants(const QString &rTemplate, const QList<Variant> &rVariants, const QDir &rTargetDir) :
+AbstractJob(tr("Generating %n CPL variant(s) of %1", "", rVariants.size()).arg(QFileInfo(rTemplate).fileName())), mTemplate(rTemplate), mVariants(rVariants), mTargetDir(rTargetDir), mTrackFiles() {
+
+}
+
+void JobGenerateCplVariants::AddTrackFile(const QUuid &rId, const QUuid &rSourceEncoding, const EditRate &rEditRate, const Duration &rDuration, const EssenceDescriptorTable::Descriptor &rDescriptor, const QByteArray &rHash /*= QByteArray()*/) {
+
+	TrackFile track_file;
+	track_file.sourceEncoding = rSourceEncoding;
+	track_file.editRate = rEditRate;
+	track_file.duration = rDuration;
+	track_file.descriptor = rDescriptor;
+	track_file.hash = rHash;
+	mTrackFiles.insert(rId, track_file);
+}
+
+Error JobGenerateCplVariants::ParseSubstitutionTable(const QString &rFilePath, QList<Variant> &rVariants) {
+
+	rVariants.clear();
+	QFile file(rFilePath);
+	if(file.open(QIODevice::ReadOnly | QIODevice::Text) == false) return Error(Error::SourceFileOpenError, rFilePath);
+	QTextStream stream(&file);
+	stream.setCodec("UTF-8");
+	QList<QStringList> rows;
+	QChar separator;
+	while(stream.atEnd() == false) {
+		const QString line = stream.readLine();
+		if(line.trimmed().isEmpty() == true) continue;
+		// The header holds no free text. Its separator is the separator of the table.
+		if(separator.isNull() == true) separator = (line.contains('\t') ? '\t' : (line.contains(';') ? ';' : ','));
+		rows << split_row(line, separator);
+	}
+	if(rows.size() < 2) return Error(Error::Unknown, tr("%1 holds no variants.").arg(QFileInfo(rFilePath).fileName()));
+
+	const QStringList &r_header = rows.first();
+	int title_column = -1;
+	QList<QUuid> template_track_files;
+	for(int i = 0; i < r_header.size(); i++) {
+		const QString name = r_header.at(i).trimmed();
+		const QUuid id = parse_uuid(name);
+		if(name.compare("ContentTitle", Qt::CaseInsensitive) == 0 && title_column < 0) title_column = i;
+		else if(id.isNull() == true) return Error(Error::Unknown, tr("Column %1 is neither ContentTitle nor a track file Id: %2").arg(i + 1).arg(name));
+		template_track_files << id;
+	}
+	if(title_column < 0) return Error(Error::Unknown, tr("%1 has no ContentTitle column.").arg(QFileInfo(rFilePath).fileName()));
+
+	for(int row = 1; row < rows.size(); row++) {
+		const QStringList &r_row = rows.at(row);
+		if(r_row.size() > r_header.size()) return Error(Error::Unknown, tr("Row %1 has more columns than the header.").arg(row + 1));
+		Variant variant;
+		for(int i = 0; i < r_row.size(); i++) {
+			const QString cell = r_row.at(i).trimmed();
+			if(i == title_column) variant.contentTitle = cell;
+			else if(cell.isEmpty() == false) {
+				const QUuid id = parse_uuid(cell);
+				if(id.isNull() == true) return Error(Error::Unknown, tr("Row %1, column %2 isn't a track file Id: %3").arg(row + 1).arg(i + 1).arg(cell));
+				variant.trackFiles.insert(template_track_files.at(i), id);
+			}
+		}
+		if(variant.contentTitle.IsEmpty() == true) return Error(Error::Unknown, tr("Row %1 has no ContentTitle.").arg(row + 1));
+		rVariants << variant;
+	}
+	return Error();
+}
+
+Error JobGenerateCplVariants::Execute() {
+
+	if(mVariants.isEmpty() == true) return Error();
+
+	// Parse the template once. All variants are copied from it.
+	XmlParsingError parse_error;
+	std::auto_ptr<cpl::CompositionPlaylistType> template_cpl;
+	Error dom_error;
+	xml_schema::dom::auto_ptr<xercesc::DOMDocument> template_document(XmlParserPool::Instance().Parse(mTemplate, dom_error));
+	if(dom_error.IsError() == true) parse_error = XmlParsingError(XmlParsingError::Parsing, dom_error.GetErrorDescription());
+	else {
+		try {
+			template_cpl = cpl::parseCompositionPlaylist(*template_document, xml_schema::Flags::dont_initialize);
+		}
+		catch(const xml_schema::Parsing &e) { parse_error = XmlParsingError(e); }
+		catch(const xml_schema::ExpectedElement &e) { parse_error = XmlParsingError(e); }
+		catch(const xml_schema::UnexpectedElement &e) { parse_error = XmlParsingError(e); }
+		catch(const xml_schema::ExpectedAttribute &e) { parse_error = XmlParsingError(e); }
+		catch(const xml_schema::UnexpectedEnumerator &e) { parse_error = XmlParsingError(e); }
+		catch(const xml_schema::ExpectedTextContent &e) { parse_error = XmlParsingError(e); }
+		catch(const xml_schema::NoTypeInfo &e) { parse_error = XmlParsingError(e); }
+		catch(const xml_schema::NotDerived &e) { parse_error = XmlParsingError(e); }
+		catch(const xml_schema::NoPrefixMapping &e) { parse_error = XmlParsingError(e); }
+		catch(...) { parse_error = XmlParsingError(XmlParsingError::Unknown); }
+	}
+	if(parse_error.IsError() == true) return Error(Error::XMLSchemeError, QString("%1: %2%3").arg(QFileInfo(mTemplate).fileName()).arg(parse_error.GetErrorMsg()).arg(parse_error.GetErrorDescription()));
+
+	// Every substitution must replace a track file of the template with a registered track file of the same edit rate
+	// that covers every resource referencing the template track file (EntryPoint + SourceDuration).
+	const EditRate composition_edit_rate = ImfXmlHelper::Convert(template_cpl->getEditRate());
+	QHash<QUuid, EditRate> template_edit_rates;
+	QHash<QUuid, qint64> template_extents;
+	cpl::CompositionPlaylistType_SegmentListType::SegmentSequence &r_segments = template_cpl->getSegmentList().getSegment();
+	for(cpl::CompositionPlaylistType_SegmentListType::SegmentSequence::iterator segment_iter(r_segments.begin()); segment_iter != r_segments.end(); ++segment_iter) {
+		cpl::SegmentType_SequenceListType::AnySequence &r_any_sequence(segment_iter->getSequenceList().getAny());
+		for(cpl::SegmentType_SequenceListType::AnySequence::iterator sequence_iter(r_any_sequence.begin()); sequence_iter != r_any_sequence.end(); ++sequence_iter) {
+			const QList<xercesc::DOMElement*> resources = resource_elements(&(*sequence_iter));
+			for(int i = 0; i < resources.size(); i++) {
+				xercesc::DOMElement *p_resource = resources.at(i);
+				xercesc::DOMElement *p_track_file_id = child_element(p_resource, "TrackFileId");
+				if(p_track_file_id == NULL) continue;
+				const QUuid track_file_id = parse_uuid(to_qstring(p_track_file_id->getTextContent()));
+				const qint64 entry_point = child_integer(p_resource, "EntryPoint", 0);
+				const qint64 source_duration = child_integer(p_resource, "SourceDuration", child_integer(p_resource, "IntrinsicDuration", 0) - entry_point);
+				if(template_edit_rates.contains(track_file_id) == false) template_edit_rates.insert(track_file_id, resource_edit_rate(p_resource, composition_edit_rate));
+				template_extents.insert(track_file_id, qMax(template_extents.value(track_file_id, 0), entry_point + source_duration));
+			}
+		}
+	}
+	for(int i = 0; i < mVariants.size(); i++) {
+		for(QHash<QUuid, QUuid>::const_iterator iter = mVariants.at(i).trackFiles.constBegin(); iter != mVariants.at(i).trackFiles.constEnd(); ++iter) {
+			if(template_edit_rates.contains(iter.key()) == false) return Error(Error::SourceFilesMissing, tr("The template doesn't reference track file %1.").arg(strip_uuid(iter.key())));
+			if(mTrackFiles.contains(iter.value()) == false) return Error(Error::SourceFilesMissing, tr("Track file %1 isn't part of the package or has no essence descriptor.").arg(strip_uuid(iter.value())));
+			const TrackFile &r_track_file = mTrackFiles[iter.value()];
+			const EditRate template_edit_rate = template_edit_rates.value(iter.key());
+			if(r_track_file.editRate != template_edit_rate) {
+				return Error(Error::UnsupportedEssence, tr("Track file %1 (edit rate %2/%3) can't replace track file %4 (edit rate %5/%6).").arg(strip_uuid(iter.value()))
+										 .arg(r_track_file.editRate.GetNumerator()).arg(r_track_file.editRate.GetDenominator()).arg(strip_uuid(iter.key()))
+										 .arg(template_edit_rate.GetNumerator()).arg(template_edit_rate.GetDenominator()));
+			}
+			if(r_track_file.duration.GetCount() < template_extents.value(iter.key())) {
+				return Error(Error::UnknownDuration, tr("Track file %1 is %2 edit units long. The template resources of track file %3 need %4 edit units.").arg(strip_uuid(iter.value()))
+										 .arg(r_track_file.duration.GetCount()).arg(strip_uuid(iter.key())).arg(template_extents.value(iter.key())));
+			}
+		}
+	}
+	if(QThread::currentThread()->isInterruptionRequested()) return Error(Error::WorkerInterruptionRequest);
+
+	// Build and serialize the variants in parallel. Every task writes its own slot. No locking needed.
+	const int count = mVariants.size();
+	QVector<QUuid> ids(count);
+	QVector<QByteArray> data(count);
+	QVector<QByteArray> hashes(count);
+	QVector<Error> errors(count);
+	QMutex template_mutex;
+	QAtomicInt done(0);
+	QAtomicInt abort(0);
+	QThreadPool thread_pool;
+	QList<VariantTask*> tasks;
+	for(int i = 0; i < count; i++) {
+		ids[i] = QUuid::createUuid();
+		VariantTask *p_task = new VariantTask(this, template_cpl.get(), &template_mutex, i, ids.at(i), &data[i], &hashes[i], &errors[i], &done, &abort);
+		p_task->setAutoDelete(false);
+		tasks << p_task;
+		thread_pool.start(p_task);
+	}
+	int last_progress = 0;
+	while(thread_pool.waitForDone(100) == false) {
+		if(QThread::currentThread()->isInterruptionRequested()) abort.store(1);
+		const int progress = done.load() * 90 / count;
+		if(progress != last_progress) emit Progress(progress);
+		last_progress = progress;
+	}
+	qDeleteAll(tasks);
+	if(QThread::currentThread()->isInterruptionRequested()) return Error(Error::WorkerInterruptionRequest);
+	for(int i = 0; i < count; i++) {
+		if(errors.at(i).IsError() == true) return errors.at(i);
+	}
+
+	for(int i = 0; i < count; i++) {
+		emit Result(mTargetDir.absoluteFilePath(QString("CPL_%1.xml").arg(strip_uuid(ids.at(i)))), ids.at(i), data.at(i), hashes.at(i), GetIdentifier());
+	}
+	emit Progress(100);
+	return Error();
+}
+
+Error JobGenerateCplVariants::BuildVariant(const cpl::CompositionPlaylistType &rTemplate, QMutex &rTemplateMutex, const Variant &rVariant, const QUuid &rId, QByteArray &rData) const {
+
+	std::auto_ptr<cpl::CompositionPlaylistType> variant_cpl;
+	{
+		// Copying reads the DOM documents of the template wildcard content.
+		QMutexLocker locker(&rTemplateMutex);
+		variant_cpl.reset(new cpl::CompositionPlaylistType(rTemplate));
+	}
+	variant_cpl->setId(ImfXmlHelper::Convert(rId));
+	variant_cpl->setIssueDate(ImfXmlHelper::Convert(QDateTime::currentDateTimeUtc()));
+	variant_cpl->setContentTitle(ImfXmlHelper::Convert(rVariant.contentTitle));
+	variant_cpl->getSigner().reset();
+	variant_cpl->getSignature().reset();
+
+	QSet<QUuid> source_encodings; // Referenced by the variant.
+	QHash<QUuid, EssenceDescriptorTable::Descriptor> new_descriptors; // Source encodings of the substituted track files.
+	cpl::CompositionPlaylistType_SegmentListType::SegmentSequence &r_segments = variant_cpl->getSegmentList().getSegment();
+	for(cpl::CompositionPlaylistType_SegmentListType::SegmentSequence::iterator segment_iter(r_segments.begin()); segment_iter != r_segments.end(); ++segment_iter) {
+		segment_iter->setId(ImfXmlHelper::Convert(QUuid::createUuid()));
+		cpl::SegmentType::SequenceListType &r_sequence_list = segment_iter->getSequenceList();
+		if(r_sequence_list.getMarkerSequence().present() == true) {
+			cpl::SequenceType &r_marker_sequence = r_sequence_list.getMarkerSequence().get();
+			r_marker_sequence.setId(ImfXmlHelper::Convert(QUuid::createUuid()));
+			cpl::SequenceType_ResourceListType::ResourceSequence &r_resources = r_marker_sequence.getResourceList().getResource();
+			for(cpl::SequenceType_ResourceListType::ResourceIterator resource_iter(r_resources.begin()); resource_iter != r_resources.end(); ++resource_iter) {
+				resource_iter->setId(ImfXmlHelper::Convert(QUuid::createUuid()));
+			}
+		}
+		// Virtual track sequences are wildcard content. They are edited in place instead of being parsed and serialized again.
+		cpl::SegmentType_SequenceListType::AnySequence &r_any_sequence(r_sequence_list.getAny());
+		for(cpl::SegmentType_SequenceListType::AnySequence::iterator sequence_iter(r_any_sequence.begin()); sequence_iter != r_any_sequence.end(); ++sequence_iter) {
+			xercesc::DOMElement *p_sequence = &(*sequence_iter);
+			xercesc::DOMElement *p_sequence_id = child_element(p_sequence, "Id");
+			if(p_sequence_id) set_text(p_sequence_id, urn(QUuid::createUuid()));
+			const QList<xercesc::DOMElement*> resources = resource_elements(p_sequence);
+			for(int i = 0; i < resources.size(); i++) {
+				xercesc::DOMElement *p_resource = resources.at(i);
+				xercesc::DOMElement *p_resource_id = child_element(p_resource, "Id");
+				if(p_resource_id) set_text(p_resource_id, urn(QUuid::createUuid()));
+				xercesc::DOMElement *p_track_file_id = child_element(p_resource, "TrackFileId");
+				xercesc::DOMElement *p_source_encoding = child_element(p_resource, "SourceEncoding");
+				if(p_track_file_id) {
+					const QUuid track_file_id = rVariant.trackFiles.value(parse_uuid(to_qstring(p_track_file_id->getTextContent())));
+					if(track_file_id.isNull() == false) {
+						const TrackFile track_file = mTrackFiles.value(track_file_id);
+						set_text(p_track_file_id, urn(track_file_id));
+						if(p_source_encoding) set_text(p_source_encoding, urn(track_file.sourceEncoding));
+						xercesc::DOMElement *p_intrinsic_duration = child_element(p_resource, "IntrinsicDuration");
+						if(p_intrinsic_duration) set_text(p_intrinsic_duration, QString::number(track_file.duration.GetCount()));
+						xercesc::DOMElement *p_hash = child_element(p_resource, "Hash");
+						if(p_hash && track_file.hash.isEmpty() == false) set_text(p_hash, QString::fromLatin1(track_file.hash.toBase64()));
+						else if(p_hash) p_resource->removeChild(p_hash)->release();
+						new_descriptors.insert(track_file.sourceEncoding, track_file.descriptor);
+					}
+				}
+				if(p_source_encoding) source_encodings.insert(parse_uuid(to_qstring(p_source_encoding->getTextContent())));
+			}
+		}
+	}
+
+	// Essence descriptors: keep the referenced template descriptors, add the shared descriptors of the substituted track files.
+	if(variant_cpl->getEssenceDescriptorList().present() == false && new_descriptors.isEmpty() == false) {
+		variant_cpl->setEssenceDescriptorList(cpl::CompositionPlaylistType_EssenceDescriptorListType());
+	}
+	if(variant_cpl->getEssenceDescriptorList().present() == true) {
+		QSet<QUuid> listed_descriptors;
+		cpl::CompositionPlaylistType_EssenceDescriptorListType::EssenceDescriptorSequence &r_descriptors = variant_cpl->getEssenceDescriptorList().get().getEssenceDescriptor();
+		for(cpl::CompositionPlaylistType_EssenceDescriptorListType::EssenceDescriptorSequence::iterator iter(r_descriptors.begin()); iter != r_descriptors.end();) {
+			const QUuid id = ImfXmlHelper::Convert(iter->getId());
+			if(source_encodings.contains(id) == true && listed_descriptors.contains(id) == false) {
+				listed_descriptors.insert(id);
+				++iter;
+			}
+			else iter = r_descriptors.erase(iter);
+		}
+		QMutexLocker locker(&rTemplateMutex);
+		for(QHash<QUuid, EssenceDescriptorTable::Descriptor>::const_iterator iter = new_descriptors.constBegin(); iter != new_descriptors.constEnd(); ++iter) {
+			if(iter.value() && listed_descriptors.contains(iter.key()) == false) r_descriptors.push_back(*iter.value());
+		}
+	}
+
+	ImfError imf_error = serialize_cpl(*variant_cpl, rData);
+	if(imf_error.IsError() == true) return Error(Error::XMLSchemeError, imf_error.GetErrorDescription());
+	return Error();
+}
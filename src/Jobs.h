@@ -17,6 +17,15 @@
 #include "JobQueue.h"
 #include "info.h"
 #include "ImfCommon.h"
+#include "ImfPackageCommon.h"
+#include "AudioAnalysis.h"
+#include "FileCloner.h"
+#include "HashCheckpoints.h"
+#include "EssenceDescriptorTable.h"
+#include <QPair>
+#include <QSharedPointer>
+#include <QHash>
+#include <QDir>
 
 
 namespace
@@ -40,12 +49,16 @@ public:
 
 } // namespace
 
+/*! Calculates the SHA-1 of rSourceFile. If resumable is true the job saves a checkpoint every JobCalculateHash::CheckpointInterval bytes and when it is interrupted,
+and resumes from the last checkpoint of an unchanged file. The digest of a file that was completely hashed before and didn't change since is reused (see HashCheckpoints).
+Pass resumable = false for files the application has just written.
+*/
 class JobCalculateHash : public AbstractJob {
 
 	Q_OBJECT
 
 public:
-	JobCalculateHash(const QString &rSourceFile);
+	JobCalculateHash(const QString &rSourceFile, bool resumable = true);
 	virtual ~JobCalculateHash() {}
 
 signals:
@@ -56,8 +69,10 @@ protected:
 
 private:
 	Q_DISABLE_COPY(JobCalculateHash);
+	static const qint64 CheckpointInterval = 256 * 1024 * 1024; // [Byte]
 
 	const QString mSourceFile;
+	const bool mResumable;
 };
 
 
@@ -66,9 +81,14 @@ class JobWrapWav : public AbstractJob {
 	Q_OBJECT
 
 public:
-	JobWrapWav(const QStringList &rSourceFiles, const QString &rOutputFile, const SoundfieldGroup &rSoundFieldGroup, const QUuid &rAssetId);
+	//! If analyzeAudio is true loudness, true-peak and silent channels are measured while wrapping (see AudioAnalyzer).
+	JobWrapWav(const QStringList &rSourceFiles, const QString &rOutputFile, const SoundfieldGroup &rSoundFieldGroup, const QUuid &rAssetId, bool analyzeAudio = false);
 	virtual ~JobWrapWav() {}
 
+signals:
+	//! Emitted after successful wrapping if analyzeAudio was set.
+	void AudioAnalysisFinished(const AudioAnalysisResult &rResult);
+
 protected:
 	virtual Error Execute();
 
@@ -78,6 +98,7 @@ private:
 	const QString mOutputFile;
 	const QStringList mSourceFiles;
 	const SoundfieldGroup	mSoundFieldGoup;
+	const bool mAnalyzeAudio;
 	Info mWriterInfo;
 };
 
@@ -110,3 +131,187 @@ private:
 	Info mWriterInfo;
 };
 
+/*! \brief Wraps a JPEG 2000 codestream sequence (one .j2c file per frame) into an AS-02 track file.
+rSourceFiles may contain directories and frames. The main headers (SIZ, COD) of all codestreams are checked in parallel. Part 2 codestreams are rejected, all frames must share resolution, components and coding style.
+Codestreams are read ahead while the current frame is written. RGB codestreams (multiple component transformation) get an RGBA descriptor, all others a CDCI descriptor.
+Result() is emitted with the SHA-1 of the track file. The hash is calculated right after writing while the file is still in the page cache, no JobCalculateHash is needed.
+*/
+class JobWrapJ2c : public AbstractJob {
+
+	Q_OBJECT
+
+public:
+	JobWrapJ2c(const QStringList &rSourceFiles, const QString &rOutputFile, const EditRate &rFrameRate, const QUuid &rAssetId);
+	virtual ~JobWrapJ2c() {}
+
+signals:
+	void Result(const QByteArray &rHash, const QVariant &rIdentifier = QVariant());
+
+protected:
+	virtual Error Execute();
+
+private:
+	Q_DISABLE_COPY(JobWrapJ2c);
+	Error Hash(const QString &rFilePath, QByteArray &rHash);
+
+	const QString mOutputFile;
+	const QStringList mSourceFiles;
+	const EditRate mFrameRate;
+	Info mWriterInfo;
+};
+
+#ifdef ARCHIVIST
+/*! \brief Wraps an ACES (SMPTE ST 2065-4 OpenEXR) frame sequence into an AS-02 track file.
+rSourceFiles may contain directories and frames. The frames are ordered by frame number, their headers are checked in parallel.
+Frames are read ahead on separate threads while the current frame is written. The frame rate is reported by the job telemetry.
+*/
+class JobWrapAces : public AbstractJob {
+
+	Q_OBJECT
+
+public:
+	JobWrapAces(const QStringList &rSourceFiles, const QString &rOutputFile, const EditRate &rFrameRate, const QUuid &rAssetId);
+	virtual ~JobWrapAces() {}
+
+protected:
+	virtual Error Execute();
+
+private:
+	Q_DISABLE_COPY(JobWrapAces);
+
+	const QString mOutputFile;
+	const QStringList mSourceFiles;
+	const EditRate mFrameRate;
+	Info mWriterInfo;
+};
+#endif // ARCHIVIST
+
+
+/*! Serializes a CPL snapshot (see WidgetComposition::CreateWriteJob()) and writes it to rDestination using a PackageTransaction.
+If rPreviousHash isn't empty the snapshot is serialized with its current issue date first. If the SHA-1 matches rPreviousHash the file isn't rewritten. Otherwise the issue date is set to now.
+If stage is true the job only serializes. The content is passed with JobWriteCpl::Result() and is meant to be staged in the CPL asset (see Asset::StageContent()),
+ImfPackage::Outgest() writes it together with the Packing Lists and ASSETMAP.xml.
+The job owns the snapshot until it finished. Don't access the snapshot from other threads while the job is running.
+*/
+class JobWriteCpl : public AbstractJob {
+
+	Q_OBJECT
+
+public:
+	JobWriteCpl(const QSharedPointer<cpl::CompositionPlaylistType> &rCpl, const QString &rDestination, const QByteArray &rPreviousHash = QByteArray(), bool stage = false);
+	virtual ~JobWriteCpl() {}
+
+signals:
+	/*! rHash is the SHA-1 of the content. changed is false if the content was unchanged and therefore not rewritten.
+	rData is the serialized content if changed is true.
+	*/
+	void Result(const QByteArray &rHash, const QByteArray &rData, bool changed, const QVariant &rIdentifier = QVariant());
+
+protected:
+	virtual Error Execute();
+
+private:
+	Q_DISABLE_COPY(JobWriteCpl);
+
+	QSharedPointer<cpl::CompositionPlaylistType> mpCpl;
+	const QString mDestination;
+	const QByteArray mPreviousHash;
+	const bool mStage;
+};
+
+
+/*! Materializes a package export prepared by ImfPackage::CreateExportJob(). The files are cloned with FileCloner first, then the documents (Packing List,
+VOLINDEX.xml, ASSETMAP.xml) are written with a PackageTransaction in the order they were added. The job never overwrites existing files.
+*/
+class JobExportPackage : public AbstractJob, private FileCloner::Listener {
+
+	Q_OBJECT
+
+public:
+	JobExportPackage(const QString &rTargetDir);
+	virtual ~JobExportPackage() {}
+	void AddFile(const QString &rSource, const QString &rDestination);
+	void AddDocument(const QString &rDestination, const QByteArray &rData);
+	//! Forces the first method tried by FileCloner::Clone(), e.g. for benchmarks.
+	void SetFirstMethod(FileCloner::eMethod method) { mFirstMethod = method; }
+	//! Number of files the last run cloned with method. Don't invoke while the job is running.
+	int GetMethodCount(FileCloner::eMethod method) const { return mMethodCount[method]; }
+
+signals:
+	//! rSummary lists how many files were cloned with which method.
+	void Result(const QString &rSummary, const QVariant &rIdentifier = QVariant());
+
+protected:
+	virtual Error Execute();
+
+private:
+	Q_DISABLE_COPY(JobExportPackage);
+	virtual bool BytesCopied(qint64 bytes);
+
+	const QString mTargetDir;
+	FileCloner::eMethod mFirstMethod;
+	QList<QPair<QString, QString> > mFiles;
+	QList<QPair<QString, QByteArray> > mDocuments;
+	// Only accessed from the executing thread while the job is running.
+	qint64 mTotalSize;
+	qint64 mBytesCopied;
+	int mLastProgress;
+	int mMethodCount[FileCloner::MethodCount];
+};
+
+
+/*! \brief Builds variants of a template CPL in parallel.
+Every variant is a copy of the template with new CPL, segment, sequence and resource Ids, its own ContentTitle and the track files listed in
+JobGenerateCplVariants::Variant::trackFiles substituted. The Essence Descriptor List of a variant holds the template descriptors that are still
+referenced plus the interned descriptors (see EssenceDescriptorTable) of the substituted track files. Signer and Signature are dropped.
+A substitute must have the edit rate of the template track file and must be at least as long as EntryPoint + SourceDuration of every resource
+referencing the template track file. The IntrinsicDuration of the resources is set to the duration of the substitute.
+The template is parsed once and shared by all variants. The job doesn't write any file: the variants are serialized in memory and passed with
+JobGenerateCplVariants::Result() after all variants were built. Their file paths are rTargetDir/CPL_<Id>.xml. Stage them in CPL assets (see Asset::StageContent()),
+ImfPackage::Outgest() writes them together with the Packing List and ASSETMAP.xml. No variant is passed if one of them fails.
+*/
+class JobGenerateCplVariants : public AbstractJob {
+
+	Q_OBJECT
+
+public:
+	struct Variant {
+		UserText contentTitle;
+		QHash<QUuid, QUuid> trackFiles; // Template TrackFileId -> TrackFileId of the variant.
+	};
+	JobGenerateCplVariants(const QString &rTemplate, const QList<Variant> &rVariants, const QDir &rTargetDir);
+	virtual ~JobGenerateCplVariants() {}
+	/*! Registers a track file a template track file may be replaced with. rEditRate and rDuration are the edit rate and the duration (in edit units) of the track file.
+	rHash is the SHA-1 of the track file (may be empty).
+	*/
+	void AddTrackFile(const QUuid &rId, const QUuid &rSourceEncoding, const EditRate &rEditRate, const Duration &rDuration, const EssenceDescriptorTable::Descriptor &rDescriptor, const QByteArray &rHash = QByteArray());
+	/*! Reads a substitution table (CSV separated by comma, semicolon or tab, fields may be quoted). The header names the column ContentTitle and one column per template track file (its Id).
+	Every other row is a variant: its title and the Ids of the track files replacing the template track files. Empty cells keep the template track file.
+	*/
+	static Error ParseSubstitutionTable(const QString &rFilePath, QList<Variant> &rVariants);
+
+signals:
+	//! Emitted for every variant after all variants were built. rData is the serialized CPL, rHash its SHA-1.
+	void Result(const QString &rFilePath, const QUuid &rId, const QByteArray &rData, const QByteArray &rHash, const QVariant &rIdentifier = QVariant());
+
+protected:
+	virtual Error Execute();
+
+private:
+	Q_DISABLE_COPY(JobGenerateCplVariants);
+	class VariantTask;
+	struct TrackFile {
+		QUuid sourceEncoding;
+		EditRate editRate;
+		Duration duration;
+		EssenceDescriptorTable::Descriptor descriptor;
+		QByteArray hash;
+	};
+	//! Copies rTemplate (locks rTemplateMutex while reading shared documents) and serializes the variant into rData. May be invoked in any thread.
+	Error BuildVariant(const cpl::CompositionPlaylistType &rTemplate, QMutex &rTemplateMutex, const Variant &rVariant, const QUuid &rId, QByteArray &rData) const;
+
+	const QString mTemplate;
+	const QList<Variant> mVariants;
+	const QDir mTargetDir;
+	QHash<QUuid, TrackFile> mTrackFiles;
+};
@@ -22,6 +22,10 @@
 #include "MetadataExtractor.h"
 #include "WidgetCentral.h"
 #include "WidgetSettings.h"
+#include "Trace.h"
+#include "StartupReport.h"
+#include "XmlParserPool.h"
+#include "ImfWorkspace.h"
 #include <QMenuBar>
 #include <QUndoGroup>
 #include <QToolBar>
@@ -35,13 +39,31 @@
 #include <QMainWindow>
 #include <QMessageBox>
 #include <QStatusBar>
+#include <QSettings>
+#include <QTimer>
+#include <QThreadPool>
+#include <QRunnable>
 
 
 
 
 
+namespace
+{
+	//! Compiles the XML schemas off the GUI thread so opening the first IMP doesn't have to wait for it.
+	class XmlSchemaWarmUp : public QRunnable {
+
+	public:
+		virtual void run() {
+
+			XmlParserPool::Instance();
+			StartupReport::Mark("XML schemas");
+		}
+	};
+}
+
 MainWindow::MainWindow(QWidget *pParent /*= NULL*/) :
-QMainWindow(pParent) {
+QMainWindow(pParent), mFirstFramePainted(false), mReferenceDirs() {
 
 	InitLayout();
 	InitMenuAndToolbar();
@@ -75,7 +97,7 @@ void MainWindow::InitLayout() {
 	connect(qApp, SIGNAL(focusChanged(QWidget*, QWidget*)), this, SLOT(rFocusChanged(QWidget*, QWidget*)));
 	connect(mpWidgetImpBrowser, SIGNAL(WritePackageComplete()), this, SLOT(rReinstallImp()));
 	//WR begin
-	connect(mpCentralWidget, SIGNAL(SaveAllCplFinished()), mpWidgetImpBrowser, SLOT(RecalcHashForCpls()));
+	connect(mpCentralWidget, SIGNAL(SaveAllCplFinished(const QList<QUuid>&)), mpWidgetImpBrowser, SLOT(RecalcHashForCpls(const QList<QUuid>&)));
 	//WR end
 }
 
@@ -135,6 +157,11 @@ void MainWindow::InitMenuAndToolbar() {
 	//WR
 	p_action_preferences->setDisabled(true);
 	p_menu_tools->addAction(p_action_preferences);
+	QAction *p_action_trace = new QAction(tr("Record Performance &Trace"), menuBar());
+	p_action_trace->setCheckable(true);
+	p_action_trace->setChecked(Trace::IsEnabled());
+	connect(p_action_trace, SIGNAL(toggled(bool)), this, SLOT(rRecordTrace(bool)));
+	p_menu_tools->addAction(p_action_trace);
 
 	menuBar()->addMenu(p_menu_file);
 	menuBar()->addMenu(p_menu_tools);
@@ -181,6 +208,24 @@ void MainWindow::closeEvent (QCloseEvent *event)
 		event->accept();
 }
 
+bool MainWindow::event(QEvent *pEvent) {
+
+	const bool ret = QMainWindow::event(pEvent);
+	if(pEvent->type() == QEvent::Paint && mFirstFramePainted == false) {
+		mFirstFramePainted = true;
+		StartupReport::Mark("First paint");
+		emit FirstFramePainted();
+		QTimer::singleShot(0, this, SLOT(rDeferredInit()));
+	}
+	return ret;
+}
+
+void MainWindow::rDeferredInit() {
+
+	StartupReport::Finish();
+	QThreadPool::globalInstance()->start(new XmlSchemaWarmUp);
+}
+
 //Check unsaved changes when opening new IMP
 void MainWindow::rOpenImpRequest() {
 	if (checkUndoStack() == 1)
@@ -259,8 +304,12 @@ void MainWindow::rWorkspaceLauncherAccepted() {
 	if(p_workspace_launcher) {
 		QString working_dir = p_workspace_launcher->field(FIELD_NAME_WORKING_DIR).toString();
 		QDir dir(working_dir);
-		QSharedPointer<ImfPackage> imf_package(new ImfPackage(dir));
-		ImfError error = imf_package->Ingest();
+		QStringList reference_dirs = p_workspace_launcher->field(FIELD_NAME_REFERENCE_DIRS).toStringList();
+		mReferenceDirs.clear();
+		for(int i = 0; i < reference_dirs.size(); i++) mReferenceDirs << QDir(reference_dirs.at(i));
+		ImfWorkspace workspace(dir, mReferenceDirs);
+		ImfError error = workspace.Load();
+		QSharedPointer<ImfPackage> imf_package = workspace.GetPrimaryPackage();
 		if(error.IsError() == false) {
 			if(error.IsRecoverableError() == true) {
 				QString error_msg = QString("%1\n%2").arg(error.GetErrorMsg()).arg(error.GetErrorDescription());
@@ -367,11 +416,31 @@ void MainWindow::rReinstallImp() {
 
 	QDir dir(mpWidgetImpBrowser->GetWorkingDir());
 	CloseImfPackage();
-	QSharedPointer<ImfPackage> imf_package(new ImfPackage(dir));
-	imf_package->Ingest();
+	ImfWorkspace workspace(dir, mReferenceDirs);
+	workspace.Load();
+	QSharedPointer<ImfPackage> imf_package = workspace.GetPrimaryPackage();
 	mpWidgetImpBrowser->InstallImp(imf_package);
 	mpCentralWidget->InstallImp(imf_package);
 }
+
+void MainWindow::rRecordTrace(bool enable) {
+
+	QSettings settings;
+	settings.setValue(SETTINGS_TRACE_ENABLED, enable);
+	if(enable == true) {
+		Trace::Enable(settings.value(SETTINGS_TRACE_FILE, Trace::GetDefaultOutputFile()).toString());
+	}
+	else if(Trace::IsEnabled() == true) {
+		Trace::Disable();
+		if(Trace::Export() == true) {
+			mpMsgBox->setText(tr("Performance trace written."));
+			mpMsgBox->setInformativeText(tr("Attach %1 to your performance bug report. Open it with chrome://tracing or ui.perfetto.dev.").arg(QDir::toNativeSeparators(Trace::GetOutputFile())));
+			mpMsgBox->setStandardButtons(QMessageBox::Ok);
+			mpMsgBox->setIcon(QMessageBox::Information);
+			mpMsgBox->exec();
+		}
+	}
+}
 			/* -----Denis Manthey----- */
 
 void MainWindow::WritePackage() {
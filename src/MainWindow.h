@@ -17,6 +17,8 @@
 #include "ImfPackage.h"
 #include <QtWidgets/QMainWindow>
 #include <QCloseEvent>
+#include <QDir>
+#include <QList>
 
 class QFileDialog;
 class QDockWidget;
@@ -36,6 +38,8 @@ public:
 
 signals:
 	void SettingsSaved();
+	//! Emitted once when the main window painted its first frame.
+	void FirstFramePainted();
 
 public slots:
 	void ShowWidgetAbout();
@@ -56,6 +60,9 @@ private slots:
 	void rOpenImpRequest();
 	void rCloseImpRequest();
 	void rReinstallImp();
+	void rRecordTrace(bool enable);
+	//! Runs once after the first frame was painted.
+	void rDeferredInit();
 
 private:
 	Q_DISABLE_COPY(MainWindow);
@@ -63,6 +70,7 @@ private:
 	void InitMenuAndToolbar();
 	void CenterWidget(QWidget *pWidget, bool useSizeHint);
 	void closeEvent (QCloseEvent *event);
+	virtual bool event(QEvent *pEvent);
 	//writes all via "Save as new CPL" created CPL-Filepaths to QList "mpUnwrittenCPL"
 	void SetUnwrittenCPL(QString FilePath);
 	//returns 0 if undostack is empty
@@ -76,4 +84,6 @@ private:
 	QAction	*mpActionSaveAll;
 	QAction	*mpActionSaveAsNewCPL;
 	QList <QString> mpUnwrittenCPLs;
+	bool mFirstFramePainted;
+	QList<QDir> mReferenceDirs; // Reference packages of the installed package (see ImfWorkspace).
 };
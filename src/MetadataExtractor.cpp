@@ -36,6 +36,8 @@
 #include <QCryptographicHash>
 #include <QMessageBox>
 #include "ImfPackageCommon.h"
+#include "Trace.h"
+#include "XmlParserPool.h"
 
 using namespace xercesc;
 
@@ -48,6 +50,7 @@ QObject(pParent) {
 
 Error MetadataExtractor::ReadMetadata(Metadata &rMetadata, const QString &rSourceFile) {
 
+	TRACE_SPAN_DETAIL("MetadataExtractor::ReadMetadata", "io", QFileInfo(rSourceFile).fileName());
 	Error error;
 	QFileInfo source_file(rSourceFile);
 	if(source_file.exists() && source_file.isFile() && !source_file.isSymLink()) {
@@ -606,40 +609,15 @@ Error MetadataExtractor::ReadTimedTextMetadata(Metadata &rMetadata, const QFileI
 	metadata.fileName = rSourceFile.fileName();
 	metadata.filePath = rSourceFile.filePath();
 
-	try {
-		XMLPlatformUtils::Initialize();
-	}
-	catch (const XMLException& toCatch) {
-		char* message = XMLString::transcode(toCatch.getMessage());
-		qDebug() << "Error during initialization! :\n" << message << "\n";
-		XMLString::release(&message);
-		error = (Error::Unknown);
-		error.AppendErrorDescription(XMLString::transcode(toCatch.getMessage()));
+	// Well-formedness check only. TODO:Schema validation
+	xsd::cxx::xml::dom::auto_ptr<DOMDocument> document(XmlParserPool::Instance().Parse(rSourceFile.absoluteFilePath(), error));
+	if(error.IsError() == true) {
+		qDebug() << error;
 		return error;
 	}
 
-	XercesDOMParser *parser = new XercesDOMParser();
-	ErrorHandler *errHandler = (ErrorHandler*) new HandlerBase();
-
-	parser->setValidationScheme(XercesDOMParser::Val_Always);		//TODO:Schema validation
-	parser->setValidationSchemaFullChecking(true);
-	parser->useScanner(XMLUni::fgWFXMLScanner);
-	parser->setErrorHandler(errHandler);
-	parser->setDoNamespaces(true);
-	parser->setDoSchema(true);
-
-
-
-	//convert QString to char*
-	std::string fname = rSourceFile.absoluteFilePath().toStdString();
-	char* xmlFile = new char [fname.size()+1];
-	std::strcpy( xmlFile, fname.c_str() );
-
-	DOMDocument *dom_doc = 0;
+	DOMDocument *dom_doc = document.get();
 	try {
-
-		parser->parse(xmlFile);
-		dom_doc = parser->getDocument();
 
 		//Profile Extractor
 		DOMNodeList *pritem = dom_doc->getElementsByTagName(XMLString::transcode("tt"));
@@ -717,9 +695,6 @@ Error MetadataExtractor::ReadTimedTextMetadata(Metadata &rMetadata, const QFileI
     }
 
 	rMetadata = metadata;
-    delete parser;
-    delete errHandler;
-    XMLPlatformUtils::Terminate();
 	return error;
 }
 			/* -----Denis Manthey----- */
@@ -38,7 +38,8 @@ soundfieldGroup(),
 fileName(),
 filePath(),
 profile(),
-infoEditRate()
+infoEditRate(),
+audioAnalysis()
 {
 }
 
@@ -67,6 +68,10 @@ QString Metadata::GetAsString() {
 			if(audioQuantization != 0)										ret.append(QObject::tr("Bit Depth: %1 bit\n").arg(audioQuantization));
 			if(audioChannelCount != 0)										ret.append(QObject::tr("Channels: %1\n").arg(audioChannelCount));
 			ret.append(QObject::tr("Channel Configuration: %1\n").arg(soundfieldGroup.GetName()));
+			if(audioAnalysis.IsValid() == true) {
+				ret.append(QObject::tr("Loudness: %1\n").arg(audioAnalysis.GetAsString()));
+				if(audioAnalysis.silentChannels.isEmpty() == false) ret.append(QObject::tr("Silent Channels: %1\n").arg(audioAnalysis.GetSilentChannelsAsString()));
+			}
 			break;
 		case Metadata::TimedText:
 			ret.append(QObject::tr("%1").arg("Timed Text\n"));
@@ -158,6 +163,11 @@ void Metadata::GetAsTextDocument(QTextDocument &rDoc) {
 		if(audioChannelCount != 0)																				table->cellAt(2, 0).firstCursorPosition().insertText(font_metrics.elidedText(QObject::tr("Channels: %1").arg(audioChannelCount), Qt::ElideRight, column_text_width));
 		else																															table->cellAt(2, 0).firstCursorPosition().insertText(font_metrics.elidedText(QObject::tr("Channels: Unknown"), Qt::ElideRight, column_text_width));
 		table->cellAt(2, 1).firstCursorPosition().insertText(font_metrics.elidedText(QObject::tr("Channel Configuration: %1").arg(soundfieldGroup.GetName()), Qt::ElideRight, column_text_width));
+		if(audioAnalysis.IsValid() == true) {
+			table->cellAt(3, 0).firstCursorPosition().insertText(font_metrics.elidedText(QObject::tr("Loudness: %1").arg(audioAnalysis.GetAsString()), Qt::ElideRight, column_text_width));
+			if(audioAnalysis.silentChannels.isEmpty() == false)	table->cellAt(3, 1).firstCursorPosition().insertText(font_metrics.elidedText(QObject::tr("Silent Channels: %1").arg(audioAnalysis.GetSilentChannelsAsString()), Qt::ElideRight, column_text_width));
+			else																								table->cellAt(3, 1).firstCursorPosition().insertText(font_metrics.elidedText(QObject::tr("Silent Channels: None"), Qt::ElideRight, column_text_width));
+		}
 	}
 	else if(type == Metadata::TimedText) {
 
@@ -18,6 +18,7 @@
 #include "Metadata.h"
 #include <vector>
 #include "ImfCommon.h"
+#include "AudioAnalysis.h"
 #include <QString>
 #include <QTextDocument>
 #include <QTextOption>
@@ -66,6 +67,7 @@ public:
 	QString									fileType;
 	EditRate								infoEditRate; //TT Edit Rate is based od milliseconds in this application. infoEdirRate is used for the real ER of the tt
 	QString									profile;	//Timed Text Profile
+	AudioAnalysisResult			audioAnalysis; // Pcm only. Measured while wrapping (JobWrapWav).
 };
 
 
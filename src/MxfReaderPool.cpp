@@ -0,0 +1,699 @@
+/* Copyright(C) 2016 Björn Stresing, Denis Manthey, Wolfgang Ruppel
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "MxfReaderPool.h"
+#include "Trace.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDateTime>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QCryptographicHash>
+#include <QStandardPaths>
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <QDebug>
+#include <QtEndian>
+#include <cstring>
+#include <algorithm>
+
+#define MXF_INDEX_MAGIC 0x4d584958 // "MXIX"
+#define MXF_INDEX_VERSION 1
+// Sidecar index files.
+#define MXF_INDEX_CACHE_MAX_AGE 30 // [days] Since the sidecar file was last read or written.
+#define MXF_INDEX_CACHE_MAX_SIZE (256 * 1024 * 1024) // [bytes]
+// Idle file handles kept open.
+#define MXF_POOL_MAX_IDLE_FILES 64
+#define MXF_POOL_MAX_IDLE_FILES_PER_TRACK 4
+// Minimum read size while parsing partitions and index table segments.
+#define MXF_INDEX_READ_SIZE (16 * 1024)
+// Elements checked against the file after the index table segments were parsed.
+#define MXF_INDEX_CHECKED_ELEMENTS 16
+
+namespace
+{
+	// SMPTE UL prefix.
+	const uchar ul_prefix[] = {0x06, 0x0e, 0x2b, 0x34};
+	// Generic container essence element, bytes 8 to 11 (SMPTE ST 379-1).
+	const uchar essence_element[] = {0x0d, 0x01, 0x03, 0x01};
+	// Encrypted triplet, bytes 8 to 13 (SMPTE ST 429-6).
+	const uchar encrypted_triplet[] = {0x0d, 0x01, 0x03, 0x01, 0x02, 0x7e};
+	// CDCI and RGBA picture essence descriptor, bytes 8 to 13 (byte 14 is 0x28 or 0x29).
+	const uchar picture_descriptor[] = {0x0d, 0x01, 0x01, 0x01, 0x01, 0x01};
+	// Partition pack, bytes 0 to 12 (byte 13 is 0x02 header, 0x03 body or 0x04 footer) (SMPTE ST 377-1).
+	const uchar partition_pack[] = {0x06, 0x0e, 0x2b, 0x34, 0x02, 0x05, 0x01, 0x01, 0x0d, 0x01, 0x02, 0x01, 0x01};
+	const uchar random_index_pack[] = {0x06, 0x0e, 0x2b, 0x34, 0x02, 0x05, 0x01, 0x01, 0x0d, 0x01, 0x02, 0x01, 0x01, 0x11, 0x01, 0x00};
+	// Index table segment, bytes 8 to 14.
+	const uchar index_table_segment[] = {0x0d, 0x01, 0x02, 0x01, 0x01, 0x10, 0x01};
+
+	bool is_essence_element(const uchar *pKey) {
+
+		return pKey[4] == 0x01 && std::memcmp(pKey + 8, essence_element, sizeof(essence_element)) == 0;
+	}
+
+	bool is_encrypted_triplet(const uchar *pKey) {
+
+		return pKey[4] == 0x02 && std::memcmp(pKey + 8, encrypted_triplet, sizeof(encrypted_triplet)) == 0;
+	}
+
+	MxfIndexTable::ePictureEncoding get_picture_encoding(const uchar *pKey) {
+
+		if(pKey[4] != 0x02 || std::memcmp(pKey + 8, picture_descriptor, sizeof(picture_descriptor)) != 0) return MxfIndexTable::UnknownEncoding;
+		if(pKey[14] == 0x28) return MxfIndexTable::Cdci;
+		if(pKey[14] == 0x29) return MxfIndexTable::Rgba;
+		return MxfIndexTable::UnknownEncoding;
+	}
+
+	qint64 get_modified(const QFileInfo &rFile) {
+
+		return rFile.lastModified().toMSecsSinceEpoch();
+	}
+
+	// Removes sidecar files not used for MXF_INDEX_CACHE_MAX_AGE days, then the least recently written ones until the directory fits MXF_INDEX_CACHE_MAX_SIZE.
+	void prune_cache_dir(const QString &rCacheDir) {
+
+		const QFileInfoList sidecars = QDir(rCacheDir).entryInfoList(QStringList() << "*.mxfidx", QDir::Files, QDir::Time);
+		const QDateTime expiry = QDateTime::currentDateTime().addDays(-MXF_INDEX_CACHE_MAX_AGE);
+		qint64 total_size = 0;
+		int removed = 0;
+		for(int i = 0; i < sidecars.size(); i++) {
+			const QFileInfo &r_sidecar = sidecars.at(i);
+			const QDateTime last_used = qMax(r_sidecar.lastModified(), r_sidecar.lastRead());
+			if(last_used < expiry || total_size + r_sidecar.size() > MXF_INDEX_CACHE_MAX_SIZE) {
+				if(QFile::remove(r_sidecar.absoluteFilePath()) == true) removed++;
+			}
+			else total_size += r_sidecar.size();
+		}
+		if(removed > 0) qDebug() << "Removed" << removed << "MXF index cache files from" << rCacheDir;
+	}
+
+	bool is_partition_pack(const uchar *pKey) {
+
+		return std::memcmp(pKey, partition_pack, sizeof(partition_pack)) == 0 && pKey[13] >= 0x02 && pKey[13] <= 0x04;
+	}
+
+	bool is_random_index_pack(const uchar *pKey) {
+
+		return std::memcmp(pKey, random_index_pack, sizeof(random_index_pack)) == 0;
+	}
+
+	bool is_index_table_segment(const uchar *pKey) {
+
+		return pKey[4] == 0x02 && pKey[5] == 0x53 && std::memcmp(pKey + 8, index_table_segment, sizeof(index_table_segment)) == 0;
+	}
+
+	//! Reads a file in chunks of at least MXF_INDEX_READ_SIZE bytes. Requests within the current chunk are served from memory.
+	class ChunkReader {
+
+	public:
+		explicit ChunkReader(QFile &rFile) : mrFile(rFile), mFileSize(rFile.size()), mChunk(), mChunkOffset(-1) {}
+		qint64 GetFileSize() const { return mFileSize; }
+		//! Returns size bytes at offset or NULL if they are beyond the end of the file. Valid until the next call.
+		const uchar* Get(qint64 offset, qint64 size) {
+
+			if(offset < 0 || size < 0 || offset + size > mFileSize) return NULL;
+			if(mChunkOffset < 0 || offset < mChunkOffset || offset + size > mChunkOffset + mChunk.size()) {
+				if(mrFile.seek(offset) == false) return NULL;
+				mChunk = mrFile.read(qMin(qMax(size, (qint64)MXF_INDEX_READ_SIZE), mFileSize - offset));
+				mChunkOffset = offset;
+				if(mChunk.size() < size) return NULL;
+			}
+			return reinterpret_cast<const uchar*>(mChunk.constData()) + (offset - mChunkOffset);
+		}
+		//! Returns the key at offset and its BER encoded length. rKlSize is the size of key and length. Returns NULL if there is no KLV packet at offset.
+		const uchar* GetKl(qint64 offset, int &rKlSize, qint64 &rLength) {
+
+			const uchar *p_kl = Get(offset, 17);
+			if(p_kl == NULL || std::memcmp(p_kl, ul_prefix, sizeof(ul_prefix)) != 0) return NULL;
+			rKlSize = 17;
+			rLength = p_kl[16];
+			if(p_kl[16] & 0x80) {
+				const int bytes = p_kl[16] & 0x7f;
+				if(bytes == 0 || bytes > 8 || (p_kl = Get(offset, 17 + bytes)) == NULL) return NULL;
+				rLength = 0;
+				for(int i = 0; i < bytes; i++) rLength = (rLength << 8) | p_kl[17 + i];
+				rKlSize += bytes;
+			}
+			if(rLength < 0 || offset + rKlSize + rLength > mFileSize) return NULL;
+			return p_kl;
+		}
+
+	private:
+		QFile &mrFile;
+		const qint64 mFileSize;
+		QByteArray mChunk;
+		qint64 mChunkOffset;
+	};
+
+	struct PartitionPack {
+
+		PartitionPack() : size(0), previousPartition(0), footerPartition(0), headerByteCount(0), indexByteCount(0), bodyOffset(0), bodySid(0) {}
+
+		qint64 size; // Key, length and value.
+		qint64 previousPartition;
+		qint64 footerPartition;
+		qint64 headerByteCount;
+		qint64 indexByteCount;
+		qint64 bodyOffset; // Essence stream offset of the first essence element in the partition.
+		quint32 bodySid;
+	};
+
+	struct Partition {
+
+		Partition() : offset(0), bodySid(0), bodyOffset(0), essenceOffset(-1), essenceKlSize(0) {}
+		bool operator<(const Partition &rOther) const { return offset < rOther.offset; }
+
+		qint64 offset;
+		quint32 bodySid;
+		qint64 bodyOffset;
+		qint64 essenceOffset; // First essence element, -1 if the partition has no essence.
+		int essenceKlSize;
+	};
+
+	struct IndexTableSegment {
+
+		IndexTableSegment() : startPosition(0), duration(0), editUnitByteCount(0), bodySid(0), streamOffsets() {}
+
+		qint64 startPosition;
+		qint64 duration;
+		quint32 editUnitByteCount; // Constant bytes per edit unit (clip wrapped essence). The segment has no index entries then.
+		quint32 bodySid;
+		QVector<qint64> streamOffsets; // Index entries
+	};
+
+	Error read_partition_pack(ChunkReader &rReader, qint64 offset, PartitionPack &rPack) {
+
+		int kl_size = 0;
+		qint64 length = 0;
+		const uchar *p_kl = rReader.GetKl(offset, kl_size, length);
+		if(p_kl == NULL || is_partition_pack(p_kl) == false || length < 88) return Error(Error::UnsupportedEssence, QObject::tr("No partition pack at byte %1").arg(offset));
+		const uchar *p_value = rReader.Get(offset + kl_size, 64);
+		if(p_value == NULL) return Error(Error::UnsupportedEssence, QObject::tr("Truncated partition pack at byte %1").arg(offset));
+		rPack.size = kl_size + length;
+		rPack.previousPartition = qFromBigEndian<quint64>(p_value + 16);
+		rPack.footerPartition = qFromBigEndian<quint64>(p_value + 24);
+		rPack.headerByteCount = qFromBigEndian<quint64>(p_value + 32);
+		rPack.indexByteCount = qFromBigEndian<quint64>(p_value + 40);
+		rPack.bodyOffset = qFromBigEndian<quint64>(p_value + 52);
+		rPack.bodySid = qFromBigEndian<quint32>(p_value + 60);
+		if(rPack.headerByteCount < 0 || rPack.indexByteCount < 0 || rPack.bodyOffset < 0) return Error(Error::UnsupportedEssence, QObject::tr("Invalid partition pack at byte %1").arg(offset));
+		return Error();
+	}
+
+	//! Returns the partitions listed in the random index pack at the end of the file.
+	Error read_random_index_pack(ChunkReader &rReader, QList<qint64> &rPartitions) {
+
+		const qint64 file_size = rReader.GetFileSize();
+		// Reads the tail of the file. The random index pack is usually much smaller.
+		const qint64 tail_offset = qMax((qint64)0, file_size - MXF_INDEX_READ_SIZE);
+		const uchar *p_length = rReader.Get(tail_offset, file_size - tail_offset) ? rReader.Get(file_size - 4, 4) : NULL;
+		if(p_length == NULL) return Error(Error::UnsupportedEssence, QObject::tr("No random index pack"));
+		const qint64 offset = file_size - qFromBigEndian<quint32>(p_length);
+		int kl_size = 0;
+		qint64 length = 0;
+		const uchar *p_kl = (offset >= 0 ? rReader.GetKl(offset, kl_size, length) : NULL);
+		if(p_kl == NULL || is_random_index_pack(p_kl) == false || offset + kl_size + length != file_size || length < 4 || (length - 4) % 12 != 0) {
+			return Error(Error::UnsupportedEssence, QObject::tr("No random index pack"));
+		}
+		const uchar *p_value = rReader.Get(offset + kl_size, length - 4);
+		if(p_value == NULL) return Error(Error::UnsupportedEssence, QObject::tr("Truncated random index pack"));
+		for(qint64 i = 0; i < (length - 4) / 12; i++) rPartitions << (qint64)qFromBigEndian<quint64>(p_value + i * 12 + 4);
+		return Error();
+	}
+
+	//! Follows the partition chain from the footer partition to the header partition.
+	Error read_partition_chain(ChunkReader &rReader, QList<qint64> &rPartitions) {
+
+		PartitionPack pack;
+		Error error = read_partition_pack(rReader, 0, pack);
+		if(error.IsError()) return error;
+		qint64 offset = pack.footerPartition;
+		if(offset <= 0) return Error(Error::UnsupportedEssence, QObject::tr("No footer partition"));
+		QList<qint64> partitions;
+		while(offset > 0) {
+			error = read_partition_pack(rReader, offset, pack);
+			if(error.IsError()) return error;
+			if(pack.previousPartition >= offset) return Error(Error::UnsupportedEssence, QObject::tr("Invalid partition chain at byte %1").arg(offset));
+			partitions.prepend(offset);
+			offset = pack.previousPartition;
+		}
+		partitions.prepend(0);
+		rPartitions = partitions;
+		return Error();
+	}
+
+	bool parse_index_table_segment(const uchar *pValue, qint64 length, IndexTableSegment &rSegment) {
+
+		qint64 position = 0;
+		while(position + 4 <= length) {
+			const quint16 tag = qFromBigEndian<quint16>(pValue + position);
+			qint64 size = qFromBigEndian<quint16>(pValue + position + 2);
+			const uchar *p_item = pValue + position + 4;
+			if(tag == 0x3f0a) {
+				// Index entry array. Large arrays don't fit the 16 bit local length, the batch header is authoritative.
+				if(position + 12 > length) return false;
+				const qint64 count = qFromBigEndian<quint32>(p_item);
+				const qint64 entry_size = qFromBigEndian<quint32>(p_item + 4);
+				// Temporal offset, key frame offset, flags and stream offset, followed by slice offsets and position table entries.
+				if(entry_size < 11) return false;
+				size = 8 + count * entry_size;
+				if(position + 4 + size > length) return false;
+				rSegment.streamOffsets.resize(count);
+				for(qint64 i = 0; i < count; i++) rSegment.streamOffsets[i] = (qint64)qFromBigEndian<quint64>(p_item + 8 + i * entry_size + 3);
+			}
+			else if(position + 4 + size > length) return false;
+			else if(tag == 0x3f0c && size == 8) rSegment.startPosition = (qint64)qFromBigEndian<quint64>(p_item);
+			else if(tag == 0x3f0d && size == 8) rSegment.duration = (qint64)qFromBigEndian<quint64>(p_item);
+			else if(tag == 0x3f05 && size == 4) rSegment.editUnitByteCount = qFromBigEndian<quint32>(p_item);
+			else if(tag == 0x3f07 && size == 4) rSegment.bodySid = qFromBigEndian<quint32>(p_item);
+			position += 4 + size;
+		}
+		return rSegment.startPosition >= 0 && rSegment.duration >= 0;
+	}
+
+	/*! Reads the partition pack at offset and the KLV packets following it up to the first essence element or the next partition.
+	Header metadata and index table segments are read in one piece. Essence isn't read.
+	*/
+	Error read_partition(ChunkReader &rReader, qint64 offset, Partition &rPartition, QList<IndexTableSegment> &rSegments, MxfIndexTable::ePictureEncoding &rEncoding) {
+
+		PartitionPack pack;
+		Error error = read_partition_pack(rReader, offset, pack);
+		if(error.IsError()) return error;
+		rPartition.offset = offset;
+		rPartition.bodySid = pack.bodySid;
+		rPartition.bodyOffset = pack.bodyOffset;
+		qint64 position = offset + pack.size;
+		// Prefetches header metadata, index table segments and the key of the first essence element.
+		rReader.Get(position, qMin(pack.headerByteCount + pack.indexByteCount + 1024, rReader.GetFileSize() - position));
+		int kl_size = 0;
+		qint64 length = 0;
+		const uchar *p_key = NULL;
+		while((p_key = rReader.GetKl(position, kl_size, length)) != NULL) {
+			if(is_essence_element(p_key)) {
+				if(pack.bodySid != 0) {
+					rPartition.essenceOffset = position;
+					rPartition.essenceKlSize = kl_size;
+				}
+				break;
+			}
+			if(is_encrypted_triplet(p_key)) return Error(Error::UnsupportedEssence, QObject::tr("Encrypted essence"));
+			if(is_partition_pack(p_key) || is_random_index_pack(p_key)) break;
+			if(is_index_table_segment(p_key)) {
+				IndexTableSegment segment;
+				const uchar *p_value = rReader.Get(position + kl_size, length);
+				if(p_value == NULL || parse_index_table_segment(p_value, length, segment) == false) {
+					return Error(Error::UnsupportedEssence, QObject::tr("Invalid index table segment at byte %1").arg(position));
+				}
+				rSegments << segment;
+			}
+			else if(rEncoding == MxfIndexTable::UnknownEncoding) rEncoding = get_picture_encoding(p_key);
+			position += kl_size + length;
+		}
+		return Error();
+	}
+}
+
+Error MxfIndexTable::Build(const QString &rFilePath) {
+
+	TRACE_SPAN_DETAIL("MxfIndexTable::Build", "mxf", QFileInfo(rFilePath).fileName());
+	QFile file(rFilePath);
+	// Only a few large reads (partitions) and small reads (keys and lengths) are issued. Buffering would only read data we don't need.
+	if(file.open(QIODevice::ReadOnly | QIODevice::Unbuffered) == false) return Error(Error::SourceFileOpenError, rFilePath);
+	Error error = ReadIndexTableSegments(file);
+	if(error.IsError()) {
+		qWarning() << "No usable index table in" << rFilePath << error.GetErrorDescription() << "Walking the KLV packets.";
+		error = WalkKlvPackets(file);
+	}
+	if(error.IsError()) {
+		mOffsets.clear();
+		mSizes.clear();
+		error.AppendErrorDescription(QString(": %1").arg(rFilePath));
+		return error;
+	}
+	const QFileInfo file_info(rFilePath);
+	mFileSize = file_info.size();
+	mModified = get_modified(file_info);
+	return Error();
+}
+
+Error MxfIndexTable::ReadIndexTableSegments(QFile &rFile) {
+
+	mOffsets.clear();
+	mSizes.clear();
+	mPictureEncoding = UnknownEncoding;
+	ChunkReader reader(rFile);
+	QList<qint64> partition_offsets;
+	Error error = read_random_index_pack(reader, partition_offsets);
+	if(error.IsError()) error = read_partition_chain(reader, partition_offsets);
+	if(error.IsError()) return error;
+
+	QList<Partition> partitions;
+	QList<IndexTableSegment> segments;
+	for(int i = 0; i < partition_offsets.size(); i++) {
+		Partition partition;
+		error = read_partition(reader, partition_offsets.at(i), partition, segments, mPictureEncoding);
+		if(error.IsError()) return error;
+		partitions << partition;
+	}
+	std::sort(partitions.begin(), partitions.end());
+	if(segments.isEmpty()) return Error(Error::UnsupportedEssence, QObject::tr("No index table segment"));
+
+	// Segments may be repeated in several partitions.
+	quint32 body_sid = 0;
+	qint64 duration = 0;
+	bool constant_edit_unit_size = false;
+	for(int i = 0; i < segments.size(); i++) {
+		if(body_sid == 0) body_sid = segments.at(i).bodySid;
+		if(segments.at(i).streamOffsets.isEmpty() && segments.at(i).editUnitByteCount > 0) constant_edit_unit_size = true;
+		// Every element needs at least a key and a length.
+		if(segments.at(i).startPosition > reader.GetFileSize() / 17) return Error(Error::UnsupportedEssence, QObject::tr("Invalid index start position"));
+		duration = qMax(duration, segments.at(i).startPosition + segments.at(i).streamOffsets.size());
+	}
+	QList<Partition> essence_partitions;
+	for(int i = 0; i < partitions.size(); i++) {
+		if(partitions.at(i).essenceOffset >= 0 && (body_sid == 0 || partitions.at(i).bodySid == body_sid)) essence_partitions << partitions.at(i);
+	}
+	if(essence_partitions.isEmpty()) return Error(Error::UnsupportedEssence, QObject::tr("No essence element"));
+
+	if(duration == 0) {
+		// Clip wrapped essence: A single element at the start of the essence container.
+		if(constant_edit_unit_size == false) return Error(Error::UnsupportedEssence, QObject::tr("No index entries"));
+		const Partition &r_partition = essence_partitions.first();
+		int kl_size = 0;
+		qint64 length = 0;
+		if(r_partition.bodyOffset != 0 || reader.GetKl(r_partition.essenceOffset, kl_size, length) == NULL) return Error(Error::UnsupportedEssence, QObject::tr("No essence element"));
+		mOffsets << r_partition.essenceOffset + kl_size;
+		mSizes << length;
+		return Error();
+	}
+
+	QVector<qint64> stream_offsets(duration, -1);
+	for(int i = 0; i < segments.size(); i++) {
+		for(int k = 0; k < segments.at(i).streamOffsets.size(); k++) stream_offsets[segments.at(i).startPosition + k] = segments.at(i).streamOffsets.at(k);
+	}
+	// Stream offsets are translated to file offsets using the partition containing them. All elements are expected to share the BER length size
+	// of the first element (asdcplib writes 4 byte lengths), the size of an element follows from the stream offset of the next one.
+	const int kl_size = essence_partitions.first().essenceKlSize;
+	mOffsets.resize(duration);
+	mSizes.resize(duration);
+	int partition = 0;
+	for(qint64 i = 0; i < duration; i++) {
+		const qint64 stream_offset = stream_offsets.at(i);
+		if(stream_offset < 0 || (i > 0 && stream_offset <= stream_offsets.at(i - 1))) return Error(Error::UnsupportedEssence, QObject::tr("Incomplete or unordered index table"));
+		while(partition + 1 < essence_partitions.size() && essence_partitions.at(partition + 1).bodyOffset <= stream_offset) partition++;
+		const Partition &r_partition = essence_partitions.at(partition);
+		if(stream_offset < r_partition.bodyOffset) return Error(Error::UnsupportedEssence, QObject::tr("Stream offset %1 outside of the essence container").arg(stream_offset));
+		mOffsets[i] = r_partition.essenceOffset + stream_offset - r_partition.bodyOffset + kl_size;
+		if(i > 0) mSizes[i - 1] = stream_offset - stream_offsets.at(i - 1) - kl_size;
+	}
+	int last_kl_size = 0;
+	if(reader.GetKl(mOffsets.last() - kl_size, last_kl_size, mSizes.last()) == NULL) return Error(Error::UnsupportedEssence, QObject::tr("No essence element at the last index entry"));
+
+	// Fill items between the elements (KAG) or other BER length sizes would corrupt the table. Samples are checked against the file.
+	const qint64 samples = qMin(duration, (qint64)MXF_INDEX_CHECKED_ELEMENTS);
+	for(qint64 s = 0; s < samples; s++) {
+		const qint64 i = (samples > 1 ? s * (duration - 1) / (samples - 1) : 0);
+		int element_kl_size = 0;
+		qint64 length = 0;
+		const uchar *p_key = reader.GetKl(mOffsets.at(i) - kl_size, element_kl_size, length);
+		if(p_key == NULL || is_essence_element(p_key) == false || element_kl_size != kl_size || length != mSizes.at(i)) {
+			return Error(Error::UnsupportedEssence, QObject::tr("Index entry %1 doesn't match the essence element").arg(i));
+		}
+	}
+	return Error();
+}
+
+Error MxfIndexTable::WalkKlvPackets(QFile &rFile) {
+
+	mOffsets.clear();
+	mSizes.clear();
+	mPictureEncoding = UnknownEncoding;
+	const qint64 file_size = rFile.size();
+	qint64 position = 0;
+	uchar kl[25];
+	while(position + 17 <= file_size) {
+		if(rFile.seek(position) == false) return Error(Error::SourceFileOpenError, rFile.fileName());
+		const qint64 read = rFile.read(reinterpret_cast<char*>(kl), qMin((qint64)sizeof(kl), file_size - position));
+		if(read < 17 || std::memcmp(kl, ul_prefix, sizeof(ul_prefix)) != 0) {
+			return Error(Error::UnsupportedEssence, QObject::tr("No KLV packet at byte %1").arg(position));
+		}
+		// BER encoded length.
+		qint64 length = kl[16];
+		int length_size = 1;
+		if(kl[16] & 0x80) {
+			const int bytes = kl[16] & 0x7f;
+			if(bytes == 0 || bytes > 8 || 17 + bytes > read) return Error(Error::UnsupportedEssence, QObject::tr("Invalid BER length at byte %1").arg(position));
+			length = 0;
+			for(int i = 0; i < bytes; i++) length = (length << 8) | kl[17 + i];
+			length_size += bytes;
+		}
+		const qint64 value_offset = position + 16 + length_size;
+		if(length < 0 || value_offset + length > file_size) return Error(Error::UnsupportedEssence, QObject::tr("Truncated KLV packet at byte %1").arg(position));
+		if(is_essence_element(kl)) {
+			mOffsets << value_offset;
+			mSizes << length;
+		}
+		else if(is_encrypted_triplet(kl)) return Error(Error::UnsupportedEssence, QObject::tr("Encrypted essence"));
+		else if(mPictureEncoding == UnknownEncoding) mPictureEncoding = get_picture_encoding(kl);
+		position = value_offset + length;
+	}
+	if(mOffsets.isEmpty()) return Error(Error::UnsupportedEssence, QObject::tr("No essence element"));
+	return Error();
+}
+
+bool MxfIndexTable::IsCurrent(const QFileInfo &rFile) const {
+
+	return IsValid() && rFile.size() == mFileSize && get_modified(rFile) == mModified;
+}
+
+QByteArray MxfIndexTable::Serialize() const {
+
+	QByteArray data;
+	QDataStream stream(&data, QIODevice::WriteOnly);
+	stream << (quint32)MXF_INDEX_MAGIC << (quint32)MXF_INDEX_VERSION << mFileSize << mModified << (qint32)mPictureEncoding << mOffsets << mSizes;
+	// Offsets of frame wrapped essence grow steadily. They compress well.
+	return qCompress(data);
+}
+
+bool MxfIndexTable::Deserialize(const QByteArray &rData) {
+
+	QByteArray data = qUncompress(rData);
+	QDataStream stream(data);
+	quint32 magic = 0;
+	quint32 version = 0;
+	qint32 encoding = 0;
+	stream >> magic >> version;
+	if(magic != MXF_INDEX_MAGIC || version != MXF_INDEX_VERSION) return false;
+	stream >> mFileSize >> mModified >> encoding >> mOffsets >> mSizes;
+	mPictureEncoding = (ePictureEncoding)encoding;
+	if(stream.status() != QDataStream::Ok || mOffsets.size() != mSizes.size()) {
+		mOffsets.clear();
+		mSizes.clear();
+		return false;
+	}
+	return true;
+}
+
+MxfReaderPool& MxfReaderPool::Instance() {
+
+	static MxfReaderPool pool;
+	return pool;
+}
+
+MxfReaderPool::MxfReaderPool() :
+mMutex(), mBuildFinished(), mCacheDir(QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)).absoluteFilePath("mxfindex")), mAssetIds(), mTables(), mBuilding(),
+mIdleFiles(), mIdleFileCount(0), mCachePruned(false), mStatistics() {
+
+}
+
+MxfReaderPool::~MxfReaderPool() {
+
+	Clear();
+}
+
+void MxfReaderPool::RegisterAsset(const QString &rFilePath, const QUuid &rAssetId) {
+
+	QMutexLocker locker(&mMutex);
+	mAssetIds.insert(rFilePath, rAssetId);
+}
+
+void MxfReaderPool::SetCacheDir(const QString &rCacheDir) {
+
+	QMutexLocker locker(&mMutex);
+	if(mCacheDir != rCacheDir) mCachePruned = false;
+	mCacheDir = rCacheDir;
+}
+
+QString MxfReaderPool::GetCacheDir() const {
+
+	QMutexLocker locker(&mMutex);
+	return mCacheDir;
+}
+
+QString MxfReaderPool::GetSidecarPath(const QString &rFilePath) const {
+
+	const QUuid asset_id = mAssetIds.value(rFilePath);
+	QString name;
+	if(asset_id.isNull() == false) name = asset_id.toString().mid(1, 36);
+	else name = QString(QCryptographicHash::hash(rFilePath.toUtf8(), QCryptographicHash::Sha1).toHex());
+	return QDir(mCacheDir).absoluteFilePath(name + ".mxfidx");
+}
+
+Error MxfReaderPool::GetIndexTable(const QString &rFilePath, QSharedPointer<const MxfIndexTable> &rTable) {
+
+	const QFileInfo file_info(rFilePath);
+	QMutexLocker locker(&mMutex);
+	while(mBuilding.contains(rFilePath)) mBuildFinished.wait(&mMutex);
+	QSharedPointer<const MxfIndexTable> table = mTables.value(rFilePath);
+	if(table && table->IsCurrent(file_info)) {
+		mStatistics.memoryHits++;
+		rTable = table;
+		return Error();
+	}
+	mTables.remove(rFilePath);
+	// Offsets of the new table must not be applied to a handle of the previous file.
+	CloseIdleFiles(rFilePath);
+	mBuilding.insert(rFilePath);
+	const QString sidecar_path = GetSidecarPath(rFilePath);
+	const QString cache_dir = mCacheDir;
+	const bool prune_cache = (mCachePruned == false);
+	mCachePruned = true;
+	locker.unlock();
+
+	Error error;
+	bool from_sidecar = false;
+	QElapsedTimer timer;
+	timer.start();
+	QSharedPointer<MxfIndexTable> new_table(new MxfIndexTable);
+	QFile sidecar(sidecar_path);
+	if(sidecar.open(QIODevice::ReadOnly)) {
+		from_sidecar = new_table->Deserialize(sidecar.readAll()) && new_table->IsCurrent(file_info);
+		sidecar.close();
+	}
+	if(from_sidecar == false) {
+		error = new_table->Build(rFilePath);
+		if(error.IsError() == false) {
+			QDir().mkpath(QFileInfo(sidecar_path).absolutePath());
+			QSaveFile sidecar_file(sidecar_path);
+			if(sidecar_file.open(QIODevice::WriteOnly) == false || sidecar_file.write(new_table->Serialize()) < 0 || sidecar_file.commit() == false) {
+				qWarning() << "Couldn't write MXF index cache" << sidecar_path;
+			}
+		}
+	}
+	if(prune_cache == true) prune_cache_dir(cache_dir);
+
+	locker.relock();
+	mBuilding.remove(rFilePath);
+	if(error.IsError() == false) {
+		mTables.insert(rFilePath, new_table);
+		if(from_sidecar) mStatistics.sidecarLoads++;
+		else {
+			mStatistics.builds++;
+			mStatistics.buildTime += timer.elapsed();
+		}
+		rTable = new_table;
+	}
+	mBuildFinished.wakeAll();
+	return error;
+}
+
+Error MxfReaderPool::Read(const QString &rFilePath, qint64 offset, qint64 size, QByteArray &rData) {
+
+	const PooledFile file = AcquireFile(rFilePath);
+	if(file.pFile == NULL) return Error(Error::SourceFileOpenError, rFilePath);
+	rData.resize(size);
+	const bool success = file.pFile->seek(offset) && file.pFile->read(rData.data(), size) == size;
+	ReleaseFile(rFilePath, file);
+	if(success == false) return Error(Error::SourceFileOpenError, QObject::tr("Couldn't read %1 bytes at byte %2 of %3").arg(size).arg(offset).arg(rFilePath));
+	return Error();
+}
+
+Error MxfReaderPool::ReadElement(const QString &rFilePath, qint64 index, QByteArray &rData) {
+
+	QSharedPointer<const MxfIndexTable> table;
+	Error error = GetIndexTable(rFilePath, table);
+	if(error.IsError()) return error;
+	const MxfByteRange range = table->GetElement(index);
+	if(range.IsValid() == false) return Error(Error::UnknownDuration, QObject::tr("Edit unit %1 out of range: %2").arg(index).arg(rFilePath));
+	return Read(rFilePath, range.offset, range.size, rData);
+}
+
+void MxfReaderPool::Clear() {
+
+	QMutexLocker locker(&mMutex);
+	while(mIdleFiles.isEmpty() == false) CloseIdleFiles(mIdleFiles.begin().key());
+	mTables.clear();
+}
+
+MxfReaderPoolStatistics MxfReaderPool::GetStatistics() const {
+
+	QMutexLocker locker(&mMutex);
+	MxfReaderPoolStatistics statistics = mStatistics;
+	statistics.openFiles = mIdleFileCount;
+	return statistics;
+}
+
+MxfReaderPool::PooledFile MxfReaderPool::AcquireFile(const QString &rFilePath) {
+
+	// A handle opened before the file was rewritten or replaced still reads the previous content.
+	const QFileInfo file_info(rFilePath);
+	const qint64 file_size = file_info.size();
+	const qint64 modified = get_modified(file_info);
+	{
+		QMutexLocker locker(&mMutex);
+		QList<PooledFile> &r_idle_files = mIdleFiles[rFilePath];
+		while(r_idle_files.isEmpty() == false) {
+			const PooledFile idle_file = r_idle_files.takeLast();
+			mIdleFileCount--;
+			if(idle_file.fileSize == file_size && idle_file.modified == modified) return idle_file;
+			delete idle_file.pFile;
+		}
+	}
+	PooledFile file;
+	file.pFile = new QFile(rFilePath);
+	if(file.pFile->open(QIODevice::ReadOnly | QIODevice::Unbuffered) == false) {
+		delete file.pFile;
+		return PooledFile();
+	}
+	file.fileSize = file_size;
+	file.modified = modified;
+	return file;
+}
+
+void MxfReaderPool::ReleaseFile(const QString &rFilePath, const PooledFile &rFile) {
+
+	QMutexLocker locker(&mMutex);
+	if(mIdleFiles.value(rFilePath).size() >= MXF_POOL_MAX_IDLE_FILES_PER_TRACK) {
+		delete rFile.pFile;
+		return;
+	}
+	// Closes the handles of another track file first.
+	while(mIdleFileCount >= MXF_POOL_MAX_IDLE_FILES) {
+		QHash<QString, QList<PooledFile> >::iterator i = mIdleFiles.begin();
+		while(i != mIdleFiles.end() && (i.key() == rFilePath || i.value().isEmpty())) ++i;
+		if(i == mIdleFiles.end()) break;
+		CloseIdleFiles(i.key());
+	}
+	mIdleFiles[rFilePath] << rFile;
+	mIdleFileCount++;
+}
+
+void MxfReaderPool::CloseIdleFiles(const QString &rFilePath) {
+
+	const QList<PooledFile> idle_files = mIdleFiles.take(rFilePath);
+	for(int i = 0; i < idle_files.size(); i++) delete idle_files.at(i).pFile;
+	mIdleFileCount -= idle_files.size();
+}
@@ -0,0 +1,144 @@
+/* Copyright(C) 2016 Björn Stresing, Denis Manthey, Wolfgang Ruppel
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include "Error.h"
+#include <QString>
+#include <QUuid>
+#include <QVector>
+#include <QHash>
+#include <QList>
+#include <QSet>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QSharedPointer>
+#include <QByteArray>
+
+class QFile;
+class QFileInfo;
+
+
+//! Position of a KLV value in a track file.
+struct MxfByteRange {
+
+	MxfByteRange(qint64 offset = -1, qint64 size = 0) : offset(offset), size(size) {}
+	bool IsValid() const { return offset >= 0; }
+
+	qint64 offset;
+	qint64 size;
+};
+
+/*! \brief Compact essence element table of an unencrypted AS-02 track file.
+Frame wrapped essence (JPEG 2000) has one element per edit unit, clip wrapped essence (PCM) a single element.
+The table is built from the index table segments of the partitions listed in the random index pack. Files without a usable index are walked KLV packet by KLV packet.
+Lookups are O(1) and don't need asdcplib.
+*/
+class MxfIndexTable {
+
+public:
+	enum ePictureEncoding {
+		UnknownEncoding = 0,
+		Rgba,
+		Cdci
+	};
+	MxfIndexTable() : mOffsets(), mSizes(), mPictureEncoding(UnknownEncoding), mFileSize(-1), mModified(-1) {}
+	//! Reads the index table segments. Walks the KLV packets of the file if there is no usable index.
+	Error Build(const QString &rFilePath);
+	bool IsValid() const { return mOffsets.isEmpty() == false; }
+	qint64 GetElementCount() const { return mOffsets.size(); }
+	MxfByteRange GetElement(qint64 index) const { return (index >= 0 && index < mOffsets.size() ? MxfByteRange(mOffsets.at(index), mSizes.at(index)) : MxfByteRange()); }
+	ePictureEncoding GetPictureEncoding() const { return mPictureEncoding; }
+	//! Returns false if size or modification time of the file changed since the table was built.
+	bool IsCurrent(const QFileInfo &rFile) const;
+	QByteArray Serialize() const;
+	bool Deserialize(const QByteArray &rData);
+
+private:
+	//! Reads the partition packs, header metadata and index table segments. Essence isn't read except the keys and lengths of a few elements.
+	Error ReadIndexTableSegments(QFile &rFile);
+	//! Reads the key and length of every KLV packet. Slow on network file systems.
+	Error WalkKlvPackets(QFile &rFile);
+
+	QVector<qint64> mOffsets;
+	QVector<qint64> mSizes;
+	ePictureEncoding mPictureEncoding;
+	qint64 mFileSize;
+	qint64 mModified; // [ms since epoch]
+};
+
+struct MxfReaderPoolStatistics {
+
+	MxfReaderPoolStatistics() : memoryHits(0), sidecarLoads(0), builds(0), buildTime(0), openFiles(0) {}
+
+	qint64 memoryHits;
+	qint64 sidecarLoads;
+	qint64 builds;
+	qint64 buildTime; // [ms]
+	qint64 openFiles; // Idle file handles.
+};
+
+/*! \brief Process wide pool of opened track files and their index tables. Thread safe.
+Index tables are persisted as sidecar files in the cache directory. They are named after the asset UUID (see RegisterAsset()), or a hash of the path for unknown files,
+and are rebuilt if size or modification time of the track file changed. Sidecar files not used for MXF_INDEX_CACHE_MAX_AGE days and the least recently written
+sidecar files beyond MXF_INDEX_CACHE_MAX_SIZE are removed once per cache directory and process.
+Consumers keep the table returned by GetIndexTable() and read essence with Read() or ReadElement(). File handles are leased per read and kept open for the next consumer.
+An idle handle is only reused while size and modification time of the file are the same as when it was opened. Rebuilding a table closes the idle handles of the file.
+*/
+class MxfReaderPool {
+
+public:
+	static MxfReaderPool& Instance();
+	//! Names the sidecar file of rFilePath after rAssetId.
+	void RegisterAsset(const QString &rFilePath, const QUuid &rAssetId);
+	void SetCacheDir(const QString &rCacheDir);
+	QString GetCacheDir() const;
+	//! Returns the table from memory, loads it from the sidecar file or builds it. Concurrent requests for the same file wait for a single build.
+	Error GetIndexTable(const QString &rFilePath, QSharedPointer<const MxfIndexTable> &rTable);
+	//! Reads size bytes at offset.
+	Error Read(const QString &rFilePath, qint64 offset, qint64 size, QByteArray &rData);
+	//! Reads the value of an essence element.
+	Error ReadElement(const QString &rFilePath, qint64 index, QByteArray &rData);
+	//! Closes idle file handles and forgets the tables in memory. Sidecar files are kept.
+	void Clear();
+	MxfReaderPoolStatistics GetStatistics() const;
+
+private:
+	MxfReaderPool();
+	~MxfReaderPool();
+	Q_DISABLE_COPY(MxfReaderPool);
+	struct PooledFile {
+		PooledFile() : pFile(NULL), fileSize(-1), modified(-1) {}
+		QFile *pFile;
+		qint64 fileSize; // When the file was opened.
+		qint64 modified; // [ms since epoch]
+	};
+	QString GetSidecarPath(const QString &rFilePath) const;
+	//! Returns an idle handle of the current file or opens the file. PooledFile::pFile is NULL if the file couldn't be opened.
+	PooledFile AcquireFile(const QString &rFilePath);
+	void ReleaseFile(const QString &rFilePath, const PooledFile &rFile);
+	//! Closes the idle handles of rFilePath. mMutex must be locked.
+	void CloseIdleFiles(const QString &rFilePath);
+
+	mutable QMutex mMutex;
+	QWaitCondition mBuildFinished;
+	QString mCacheDir;
+	QHash<QString, QUuid> mAssetIds;
+	QHash<QString, QSharedPointer<const MxfIndexTable> > mTables;
+	QSet<QString> mBuilding;
+	QHash<QString, QList<PooledFile> > mIdleFiles;
+	int mIdleFileCount;
+	bool mCachePruned;
+	MxfReaderPoolStatistics mStatistics;
+};
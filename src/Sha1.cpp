@@ -0,0 +1,225 @@
+/* Copyright(C) 2016 Björn Stresing, Denis Manthey, Wolfgang Ruppel
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "Sha1.h"
+#include <QDataStream>
+#include <cstring>
+
+#define SHA1_STATE_VERSION 1
+
+#define SHA1_CHOOSE(x, y, z) (((x) & (y)) | (~(x) & (z)))
+#define SHA1_PARITY(x, y, z) ((x) ^ (y) ^ (z))
+#define SHA1_MAJORITY(x, y, z) (((x) & (y)) | ((z) & ((x) | (y))))
+#define SHA1_SCHEDULE(i) ((i) < 16 ? (w[i] = load_big_endian(pData + 4 * (i))) : (w[(i) & 15] = rotate_left(w[((i) + 13) & 15] ^ w[((i) + 8) & 15] ^ w[((i) + 2) & 15] ^ w[(i) & 15], 1)))
+#define SHA1_ROUND(a, b, c, d, e, i, f, k) \
+	e += rotate_left(a, 5) + f(b, c, d) + (k) + SHA1_SCHEDULE(i); \
+	b = rotate_left(b, 30)
+
+
+namespace
+{
+	inline quint32 rotate_left(quint32 value, int bits) { return (value << bits) | (value >> (32 - bits)); }
+
+	inline quint32 load_big_endian(const unsigned char *pData) {
+
+		return ((quint32)pData[0] << 24) | ((quint32)pData[1] << 16) | ((quint32)pData[2] << 8) | (quint32)pData[3];
+	}
+
+	inline void store_big_endian(quint32 value, unsigned char *pData) {
+
+		pData[0] = (unsigned char)(value >> 24);
+		pData[1] = (unsigned char)(value >> 16);
+		pData[2] = (unsigned char)(value >> 8);
+		pData[3] = (unsigned char)value;
+	}
+}
+
+void Sha1::Reset() {
+
+	mState[0] = 0x67452301;
+	mState[1] = 0xEFCDAB89;
+	mState[2] = 0x98BADCFE;
+	mState[3] = 0x10325476;
+	mState[4] = 0xC3D2E1F0;
+	mLength = 0;
+	std::memset(mBuffer, 0, sizeof(mBuffer));
+}
+
+void Sha1::ProcessBlocks(const unsigned char *pData, qint64 blockCount) {
+
+	quint32 w[16];
+	for(qint64 block = 0; block < blockCount; block++, pData += BlockSize) {
+		quint32 a = mState[0];
+		quint32 b = mState[1];
+		quint32 c = mState[2];
+		quint32 d = mState[3];
+		quint32 e = mState[4];
+		// The rounds are unrolled, the schedule indexes are constants. The message schedule is kept in a ring of 16 words.
+		SHA1_ROUND(a, b, c, d, e, 0, SHA1_CHOOSE, 0x5A827999);
+		SHA1_ROUND(e, a, b, c, d, 1, SHA1_CHOOSE, 0x5A827999);
+		SHA1_ROUND(d, e, a, b, c, 2, SHA1_CHOOSE, 0x5A827999);
+		SHA1_ROUND(c, d, e, a, b, 3, SHA1_CHOOSE, 0x5A827999);
+		SHA1_ROUND(b, c, d, e, a, 4, SHA1_CHOOSE, 0x5A827999);
+		SHA1_ROUND(a, b, c, d, e, 5, SHA1_CHOOSE, 0x5A827999);
+		SHA1_ROUND(e, a, b, c, d, 6, SHA1_CHOOSE, 0x5A827999);
+		SHA1_ROUND(d, e, a, b, c, 7, SHA1_CHOOSE, 0x5A827999);
+		SHA1_ROUND(c, d, e, a, b, 8, SHA1_CHOOSE, 0x5A827999);
+		SHA1_ROUND(b, c, d, e, a, 9, SHA1_CHOOSE, 0x5A827999);
+		SHA1_ROUND(a, b, c, d, e, 10, SHA1_CHOOSE, 0x5A827999);
+		SHA1_ROUND(e, a, b, c, d, 11, SHA1_CHOOSE, 0x5A827999);
+		SHA1_ROUND(d, e, a, b, c, 12, SHA1_CHOOSE, 0x5A827999);
+		SHA1_ROUND(c, d, e, a, b, 13, SHA1_CHOOSE, 0x5A827999);
+		SHA1_ROUND(b, c, d, e, a, 14, SHA1_CHOOSE, 0x5A827999);
+		SHA1_ROUND(a, b, c, d, e, 15, SHA1_CHOOSE, 0x5A827999);
+		SHA1_ROUND(e, a, b, c, d, 16, SHA1_CHOOSE, 0x5A827999);
+		SHA1_ROUND(d, e, a, b, c, 17, SHA1_CHOOSE, 0x5A827999);
+		SHA1_ROUND(c, d, e, a, b, 18, SHA1_CHOOSE, 0x5A827999);
+		SHA1_ROUND(b, c, d, e, a, 19, SHA1_CHOOSE, 0x5A827999);
+		SHA1_ROUND(a, b, c, d, e, 20, SHA1_PARITY, 0x6ED9EBA1);
+		SHA1_ROUND(e, a, b, c, d, 21, SHA1_PARITY, 0x6ED9EBA1);
+		SHA1_ROUND(d, e, a, b, c, 22, SHA1_PARITY, 0x6ED9EBA1);
+		SHA1_ROUND(c, d, e, a, b, 23, SHA1_PARITY, 0x6ED9EBA1);
+		SHA1_ROUND(b, c, d, e, a, 24, SHA1_PARITY, 0x6ED9EBA1);
+		SHA1_ROUND(a, b, c, d, e, 25, SHA1_PARITY, 0x6ED9EBA1);
+		SHA1_ROUND(e, a, b, c, d, 26, SHA1_PARITY, 0x6ED9EBA1);
+		SHA1_ROUND(d, e, a, b, c, 27, SHA1_PARITY, 0x6ED9EBA1);
+		SHA1_ROUND(c, d, e, a, b, 28, SHA1_PARITY, 0x6ED9EBA1);
+		SHA1_ROUND(b, c, d, e, a, 29, SHA1_PARITY, 0x6ED9EBA1);
+		SHA1_ROUND(a, b, c, d, e, 30, SHA1_PARITY, 0x6ED9EBA1);
+		SHA1_ROUND(e, a, b, c, d, 31, SHA1_PARITY, 0x6ED9EBA1);
+		SHA1_ROUND(d, e, a, b, c, 32, SHA1_PARITY, 0x6ED9EBA1);
+		SHA1_ROUND(c, d, e, a, b, 33, SHA1_PARITY, 0x6ED9EBA1);
+		SHA1_ROUND(b, c, d, e, a, 34, SHA1_PARITY, 0x6ED9EBA1);
+		SHA1_ROUND(a, b, c, d, e, 35, SHA1_PARITY, 0x6ED9EBA1);
+		SHA1_ROUND(e, a, b, c, d, 36, SHA1_PARITY, 0x6ED9EBA1);
+		SHA1_ROUND(d, e, a, b, c, 37, SHA1_PARITY, 0x6ED9EBA1);
+		SHA1_ROUND(c, d, e, a, b, 38, SHA1_PARITY, 0x6ED9EBA1);
+		SHA1_ROUND(b, c, d, e, a, 39, SHA1_PARITY, 0x6ED9EBA1);
+		SHA1_ROUND(a, b, c, d, e, 40, SHA1_MAJORITY, 0x8F1BBCDC);
+		SHA1_ROUND(e, a, b, c, d, 41, SHA1_MAJORITY, 0x8F1BBCDC);
+		SHA1_ROUND(d, e, a, b, c, 42, SHA1_MAJORITY, 0x8F1BBCDC);
+		SHA1_ROUND(c, d, e, a, b, 43, SHA1_MAJORITY, 0x8F1BBCDC);
+		SHA1_ROUND(b, c, d, e, a, 44, SHA1_MAJORITY, 0x8F1BBCDC);
+		SHA1_ROUND(a, b, c, d, e, 45, SHA1_MAJORITY, 0x8F1BBCDC);
+		SHA1_ROUND(e, a, b, c, d, 46, SHA1_MAJORITY, 0x8F1BBCDC);
+		SHA1_ROUND(d, e, a, b, c, 47, SHA1_MAJORITY, 0x8F1BBCDC);
+		SHA1_ROUND(c, d, e, a, b, 48, SHA1_MAJORITY, 0x8F1BBCDC);
+		SHA1_ROUND(b, c, d, e, a, 49, SHA1_MAJORITY, 0x8F1BBCDC);
+		SHA1_ROUND(a, b, c, d, e, 50, SHA1_MAJORITY, 0x8F1BBCDC);
+		SHA1_ROUND(e, a, b, c, d, 51, SHA1_MAJORITY, 0x8F1BBCDC);
+		SHA1_ROUND(d, e, a, b, c, 52, SHA1_MAJORITY, 0x8F1BBCDC);
+		SHA1_ROUND(c, d, e, a, b, 53, SHA1_MAJORITY, 0x8F1BBCDC);
+		SHA1_ROUND(b, c, d, e, a, 54, SHA1_MAJORITY, 0x8F1BBCDC);
+		SHA1_ROUND(a, b, c, d, e, 55, SHA1_MAJORITY, 0x8F1BBCDC);
+		SHA1_ROUND(e, a, b, c, d, 56, SHA1_MAJORITY, 0x8F1BBCDC);
+		SHA1_ROUND(d, e, a, b, c, 57, SHA1_MAJORITY, 0x8F1BBCDC);
+		SHA1_ROUND(c, d, e, a, b, 58, SHA1_MAJORITY, 0x8F1BBCDC);
+		SHA1_ROUND(b, c, d, e, a, 59, SHA1_MAJORITY, 0x8F1BBCDC);
+		SHA1_ROUND(a, b, c, d, e, 60, SHA1_PARITY, 0xCA62C1D6);
+		SHA1_ROUND(e, a, b, c, d, 61, SHA1_PARITY, 0xCA62C1D6);
+		SHA1_ROUND(d, e, a, b, c, 62, SHA1_PARITY, 0xCA62C1D6);
+		SHA1_ROUND(c, d, e, a, b, 63, SHA1_PARITY, 0xCA62C1D6);
+		SHA1_ROUND(b, c, d, e, a, 64, SHA1_PARITY, 0xCA62C1D6);
+		SHA1_ROUND(a, b, c, d, e, 65, SHA1_PARITY, 0xCA62C1D6);
+		SHA1_ROUND(e, a, b, c, d, 66, SHA1_PARITY, 0xCA62C1D6);
+		SHA1_ROUND(d, e, a, b, c, 67, SHA1_PARITY, 0xCA62C1D6);
+		SHA1_ROUND(c, d, e, a, b, 68, SHA1_PARITY, 0xCA62C1D6);
+		SHA1_ROUND(b, c, d, e, a, 69, SHA1_PARITY, 0xCA62C1D6);
+		SHA1_ROUND(a, b, c, d, e, 70, SHA1_PARITY, 0xCA62C1D6);
+		SHA1_ROUND(e, a, b, c, d, 71, SHA1_PARITY, 0xCA62C1D6);
+		SHA1_ROUND(d, e, a, b, c, 72, SHA1_PARITY, 0xCA62C1D6);
+		SHA1_ROUND(c, d, e, a, b, 73, SHA1_PARITY, 0xCA62C1D6);
+		SHA1_ROUND(b, c, d, e, a, 74, SHA1_PARITY, 0xCA62C1D6);
+		SHA1_ROUND(a, b, c, d, e, 75, SHA1_PARITY, 0xCA62C1D6);
+		SHA1_ROUND(e, a, b, c, d, 76, SHA1_PARITY, 0xCA62C1D6);
+		SHA1_ROUND(d, e, a, b, c, 77, SHA1_PARITY, 0xCA62C1D6);
+		SHA1_ROUND(c, d, e, a, b, 78, SHA1_PARITY, 0xCA62C1D6);
+		SHA1_ROUND(b, c, d, e, a, 79, SHA1_PARITY, 0xCA62C1D6);
+		mState[0] += a;
+		mState[1] += b;
+		mState[2] += c;
+		mState[3] += d;
+		mState[4] += e;
+	}
+}
+
+void Sha1::AddData(const char *pData, qint64 length) {
+
+	if(length <= 0) return;
+	const unsigned char *p_data = reinterpret_cast<const unsigned char*>(pData);
+	int buffered = (int)(mLength % BlockSize);
+	mLength += length;
+	if(buffered > 0) {
+		const int count = (int)qMin<qint64>(BlockSize - buffered, length);
+		std::memcpy(mBuffer + buffered, p_data, count);
+		p_data += count;
+		length -= count;
+		buffered += count;
+		if(buffered < BlockSize) return;
+		ProcessBlocks(mBuffer, 1);
+	}
+	// Whole blocks are processed in place.
+	ProcessBlocks(p_data, length / BlockSize);
+	std::memcpy(mBuffer, p_data + length / BlockSize * BlockSize, length % BlockSize);
+}
+
+QByteArray Sha1::Result() const {
+
+	Sha1 copy(*this);
+	unsigned char padding[2 * BlockSize];
+	const int buffered = (int)(mLength % BlockSize);
+	// 0x80, zeros and the message length in bits. The length field must end on a block boundary.
+	const int padding_size = (buffered < BlockSize - 8 ? BlockSize : 2 * BlockSize) - buffered;
+	std::memset(padding, 0, sizeof(padding));
+	padding[0] = 0x80;
+	const quint64 bit_length = mLength * 8;
+	store_big_endian((quint32)(bit_length >> 32), padding + padding_size - 8);
+	store_big_endian((quint32)bit_length, padding + padding_size - 4);
+	copy.AddData(reinterpret_cast<const char*>(padding), padding_size);
+	QByteArray digest(20, 0);
+	for(int i = 0; i < 5; i++) store_big_endian(copy.mState[i], reinterpret_cast<unsigned char*>(digest.data()) + 4 * i);
+	return digest;
+}
+
+QByteArray Sha1::SaveState() const {
+
+	QByteArray state;
+	QDataStream stream(&state, QIODevice::WriteOnly);
+	stream << (quint32)SHA1_STATE_VERSION << mLength;
+	for(int i = 0; i < 5; i++) stream << mState[i];
+	stream << QByteArray(reinterpret_cast<const char*>(mBuffer), (int)(mLength % BlockSize));
+	return state;
+}
+
+bool Sha1::RestoreState(const QByteArray &rState) {
+
+	QDataStream stream(rState);
+	quint32 version = 0;
+	quint64 length = 0;
+	quint32 state[5];
+	QByteArray buffer;
+	stream >> version >> length;
+	for(int i = 0; i < 5; i++) stream >> state[i];
+	stream >> buffer;
+	if(stream.status() != QDataStream::Ok || stream.atEnd() == false || version != SHA1_STATE_VERSION || buffer.size() != (int)(length % BlockSize)) {
+		Reset();
+		return false;
+	}
+	mLength = length;
+	for(int i = 0; i < 5; i++) mState[i] = state[i];
+	std::memset(mBuffer, 0, sizeof(mBuffer));
+	std::memcpy(mBuffer, buffer.constData(), buffer.size());
+	return true;
+}
@@ -0,0 +1,47 @@
+/* Copyright(C) 2016 Björn Stresing, Denis Manthey, Wolfgang Ruppel
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <QByteArray>
+#include <QtGlobal>
+
+
+/*! \brief SHA-1 (FIPS 180-4) whose internal state can be saved and restored.
+Unlike QCryptographicHash the midstate, the length and the unprocessed bytes can be serialized with Sha1::SaveState(). A hash restored with
+Sha1::RestoreState() continues exactly where the saved hash stopped. Not thread safe.
+*/
+class Sha1 {
+
+public:
+	Sha1() { Reset(); }
+	void Reset();
+	void AddData(const char *pData, qint64 length);
+	void AddData(const QByteArray &rData) { AddData(rData.constData(), rData.size()); }
+	//! Returns the 20 byte digest of the data added so far. The state isn't changed, more data may be added afterwards.
+	QByteArray Result() const;
+	//! Number of bytes added so far.
+	qint64 GetLength() const { return (qint64)mLength; }
+	QByteArray SaveState() const;
+	//! Returns false and resets the hash if rState is malformed or has trailing data.
+	bool RestoreState(const QByteArray &rState);
+
+private:
+	static const int BlockSize = 64; // [Byte]
+	void ProcessBlocks(const unsigned char *pData, qint64 blockCount);
+
+	quint32 mState[5];
+	quint64 mLength;
+	unsigned char mBuffer[BlockSize];
+};
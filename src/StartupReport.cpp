@@ -0,0 +1,95 @@
+/* Copyright(C) 2016 Björn Stresing, Denis Manthey, Wolfgang Ruppel
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "StartupReport.h"
+#include "Trace.h"
+#include <QGlobalStatic>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QList>
+#include <QPair>
+#include <QStringList>
+#include <QDebug>
+
+
+namespace
+{
+	struct StartupMilestones {
+		StartupMilestones() : mutex(), timer(), milestones(), finished(false) { timer.start(); }
+		QMutex mutex;
+		QElapsedTimer timer;
+		QList<QPair<const char*, qint64> > milestones; // [µs]
+		bool finished;
+	};
+
+	Q_GLOBAL_STATIC(StartupMilestones, theMilestones)
+}
+
+void StartupReport::Start() {
+
+	StartupMilestones *p_milestones = theMilestones();
+	QMutexLocker locker(&p_milestones->mutex);
+	p_milestones->milestones.clear();
+	p_milestones->finished = false;
+	p_milestones->timer.restart();
+}
+
+void StartupReport::Mark(const char *pName) {
+
+	StartupMilestones *p_milestones = theMilestones();
+	QMutexLocker locker(&p_milestones->mutex);
+	const qint64 now = p_milestones->timer.nsecsElapsed() / 1000;
+	const qint64 previous = p_milestones->milestones.isEmpty() ? 0 : p_milestones->milestones.last().second;
+	p_milestones->milestones << qMakePair(pName, now);
+	// The trace clock starts in Trace::Init(). Map the phase to the trace clock.
+	if(Trace::IsEnabled()) {
+		const qint64 trace_now = Trace::Now();
+		if(trace_now >= now - previous) Trace::AddSpan(pName, "startup", trace_now - (now - previous), now - previous);
+	}
+}
+
+qint64 StartupReport::GetElapsed() {
+
+	return theMilestones()->timer.elapsed();
+}
+
+QString StartupReport::GetReport() {
+
+	StartupMilestones *p_milestones = theMilestones();
+	QMutexLocker locker(&p_milestones->mutex);
+	QString ret;
+	qint64 previous = 0;
+	for(int i = 0; i < p_milestones->milestones.size(); i++) {
+		const qint64 time = p_milestones->milestones.at(i).second;
+		ret.append(QString("%1 ms (+%2 ms) %3\n").arg(time / 1000., 9, 'f', 1).arg((time - previous) / 1000., 0, 'f', 1).arg(p_milestones->milestones.at(i).first));
+		previous = time;
+	}
+	return ret;
+}
+
+void StartupReport::Finish() {
+
+	StartupMilestones *p_milestones = theMilestones();
+	{
+		QMutexLocker locker(&p_milestones->mutex);
+		if(p_milestones->finished) return;
+		p_milestones->finished = true;
+	}
+	const QStringList lines = GetReport().split('\n', QString::SkipEmptyParts);
+	qDebug() << "Startup report:";
+	for(int i = 0; i < lines.size(); i++) {
+		qDebug().noquote() << lines.at(i);
+	}
+}
@@ -0,0 +1,37 @@
+/* Copyright(C) 2016 Björn Stresing, Denis Manthey, Wolfgang Ruppel
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <QString>
+
+
+/*! \brief Startup time instrumentation.
+Milestones are measured from StartupReport::Start() (first thing in main()). When the main window painted its first frame the report is written to the debug log.
+Milestones recorded while tracing is enabled also show up as spans (category "startup") in the trace.
+*/
+class StartupReport {
+
+public:
+	//! Starts the clock. Previously recorded milestones are discarded.
+	static void Start();
+	//! Records the time elapsed since StartupReport::Start(). pName must point to a string literal. This method is thread safe.
+	static void Mark(const char *pName);
+	//! Milliseconds since StartupReport::Start().
+	static qint64 GetElapsed();
+	//! Returns one line per milestone: time since start and time since the previous milestone.
+	static QString GetReport();
+	//! Writes the report to the debug log. Only the first call after StartupReport::Start() has an effect.
+	static void Finish();
+};
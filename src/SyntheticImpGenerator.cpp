@@ -0,0 +1,631 @@
+/* Copyright(C) 2016 Björn Stresing, Denis Manthey, Wolfgang Ruppel
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "SyntheticImpGenerator.h"
+#include "Jobs.h"
+#include "global.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDataStream>
+#include <QXmlStreamWriter>
+#include <QCryptographicHash>
+#include <QThreadPool>
+#include <openjpeg.h>
+#include <cmath>
+#include <cstring>
+
+#define SYNTHETIC_ISSUE_DATE "2016-01-01T00:00:00+00:00" // Fixed. Keeps the XML output reproducible.
+#define SYNTHETIC_ISSUER "IMF Tool synthetic IMP generator"
+#define SYNTHETIC_SAMPLE_RATE 48000
+#define XML_NAMESPACE_XSI "http://www.w3.org/2001/XMLSchema-instance"
+#define XML_NAMESPACE_TTML "http://www.w3.org/ns/ttml"
+#define XML_NAMESPACE_TTML_PARAMETER "http://www.w3.org/ns/ttml#parameter"
+#define XML_NAMESPACE_TTML_STYLING "http://www.w3.org/ns/ttml#styling"
+#define XML_NAMESPACE_REGXML_AAF "http://www.smpte-ra.org/reg/395/2014/13/1/aaf"
+#define XML_NAMESPACE_REGXML_ELEMENTS "http://www.smpte-ra.org/reg/335/2012"
+
+
+namespace
+{
+	// Namespace for name based Ids.
+	const QUuid synthetic_namespace("{5b2c3c63-6a0e-4d1f-9a33-0f3c1f5e8d21}");
+
+	QString urn(const QUuid &rId) {
+
+		return QString("urn:uuid:%1").arg(strip_uuid(rId));
+	}
+
+	void write_le(QDataStream &rStream, quint32 value, int bytes) {
+
+		for(int i = 0; i < bytes; i++) rStream << (quint8)((value >> (8 * i)) & 0xff);
+	}
+}
+
+SyntheticImpGenerator::Parameters::Parameters() :
+pcmTrackCount(4), timedTextTrackCount(2), cplCount(1), segmentCount(1000), resourcesPerSequence(2), framesPerResource(24), markersPerSegment(0),
+trackDuration(60), audioChannelCount(2), seed(1), editRate(EditRate::EditRate24) {
+
+}
+
+SyntheticImpGenerator::SyntheticImpGenerator(const Parameters &rParameters, QObject *pParent /*= NULL*/) :
+QObject(pParent), mParameters(rParameters), mRandomState(rParameters.seed ? rParameters.seed : 1), mTracks(), mXmlAssets(), mCplIds(), mWavFiles(), mTrackFiles(), mTargetDir() {
+
+}
+
+QUuid SyntheticImpGenerator::CreateId(const QString &rName) const {
+
+	return QUuid::createUuidV5(synthetic_namespace, QString("%1/%2").arg(mParameters.seed).arg(rName));
+}
+
+QByteArray SyntheticImpGenerator::CreateEssenceDescriptor(int index, int variantCount) const {
+
+	static const int channel_counts[] = { 2, 6, 8, 16 };
+	static const char* languages[] = { "en", "de", "fr", "es", "ja" };
+	const int variant = index % (variantCount > 0 ? variantCount : 1);
+	const int channel_count = channel_counts[variant % 4];
+	const QString language(languages[(variant / 4) % 5]);
+	int instance = 0;
+
+	QByteArray xml;
+	QXmlStreamWriter writer(&xml);
+	writer.setAutoFormatting(true);
+	writer.writeStartDocument();
+	writer.writeNamespace(XML_NAMESPACE_REGXML_AAF, "r0");
+	writer.writeNamespace(XML_NAMESPACE_REGXML_ELEMENTS, "r1");
+	writer.writeStartElement(XML_NAMESPACE_REGXML_AAF, "WAVEPCMDescriptor");
+	writer.writeTextElement(XML_NAMESPACE_REGXML_ELEMENTS, "InstanceID", urn(CreateId(QString("descriptor/%1/%2").arg(index).arg(instance++))));
+	writer.writeTextElement(XML_NAMESPACE_REGXML_ELEMENTS, "SampleRate", QString("%1/1").arg(SYNTHETIC_SAMPLE_RATE));
+	writer.writeTextElement(XML_NAMESPACE_REGXML_ELEMENTS, "EssenceLength", QString::number(mParameters.trackDuration * SYNTHETIC_SAMPLE_RATE));
+	writer.writeTextElement(XML_NAMESPACE_REGXML_ELEMENTS, "ContainerFormat", "urn:smpte:ul:060e2b34.04010101.0d010301.02060300");
+	writer.writeTextElement(XML_NAMESPACE_REGXML_ELEMENTS, "AudioSampleRate", QString("%1/1").arg(SYNTHETIC_SAMPLE_RATE));
+	writer.writeTextElement(XML_NAMESPACE_REGXML_ELEMENTS, "Locked", "False");
+	writer.writeTextElement(XML_NAMESPACE_REGXML_ELEMENTS, "ChannelCount", QString::number(channel_count));
+	writer.writeTextElement(XML_NAMESPACE_REGXML_ELEMENTS, "QuantizationBits", "24");
+	writer.writeTextElement(XML_NAMESPACE_REGXML_ELEMENTS, "SoundCompression", "urn:smpte:ul:060e2b34.04010101.04020201.7f000000");
+	writer.writeTextElement(XML_NAMESPACE_REGXML_ELEMENTS, "BlockAlign", QString::number(channel_count * 3));
+	writer.writeTextElement(XML_NAMESPACE_REGXML_ELEMENTS, "AverageBytesPerSecond", QString::number(channel_count * 3 * SYNTHETIC_SAMPLE_RATE));
+	writer.writeTextElement(XML_NAMESPACE_REGXML_ELEMENTS, "ChannelAssignment", "urn:smpte:ul:060e2b34.0401010d.04020210.04010000");
+	writer.writeStartElement(XML_NAMESPACE_REGXML_ELEMENTS, "SubDescriptors");
+	const QString soundfield_link_id = urn(CreateId(QString("soundfield/%1").arg(variant)));
+	for(int i = 0; i < channel_count; i++) {
+		writer.writeStartElement(XML_NAMESPACE_REGXML_AAF, "AudioChannelLabelSubDescriptor");
+		writer.writeTextElement(XML_NAMESPACE_REGXML_ELEMENTS, "InstanceID", urn(CreateId(QString("descriptor/%1/%2").arg(index).arg(instance++))));
+		writer.writeTextElement(XML_NAMESPACE_REGXML_ELEMENTS, "MCALabelDictionaryID", QString("urn:smpte:ul:060e2b34.0401010d.03020101.%1000000").arg(i + 1, 2, 16, QChar('0')));
+		writer.writeTextElement(XML_NAMESPACE_REGXML_ELEMENTS, "MCALinkID", urn(CreateId(QString("channel/%1/%2").arg(variant).arg(i))));
+		writer.writeTextElement(XML_NAMESPACE_REGXML_ELEMENTS, "MCATagSymbol", QString("ch%1").arg(i + 1));
+		writer.writeTextElement(XML_NAMESPACE_REGXML_ELEMENTS, "MCATagName", QString("Channel %1").arg(i + 1));
+		writer.writeTextElement(XML_NAMESPACE_REGXML_ELEMENTS, "MCAChannelID", QString::number(i + 1));
+		writer.writeTextElement(XML_NAMESPACE_REGXML_ELEMENTS, "RFC5646SpokenLanguage", language);
+		writer.writeTextElement(XML_NAMESPACE_REGXML_ELEMENTS, "SoundfieldGroupLinkID", soundfield_link_id);
+		writer.writeEndElement(); // AudioChannelLabelSubDescriptor
+	}
+	writer.writeStartElement(XML_NAMESPACE_REGXML_AAF, "SoundfieldGroupLabelSubDescriptor");
+	writer.writeTextElement(XML_NAMESPACE_REGXML_ELEMENTS, "InstanceID", urn(CreateId(QString("descriptor/%1/%2").arg(index).arg(instance++))));
+	writer.writeTextElement(XML_NAMESPACE_REGXML_ELEMENTS, "MCALabelDictionaryID", "urn:smpte:ul:060e2b34.0401010d.03020201.00000000");
+	writer.writeTextElement(XML_NAMESPACE_REGXML_ELEMENTS, "MCALinkID", soundfield_link_id);
+	writer.writeTextElement(XML_NAMESPACE_REGXML_ELEMENTS, "MCATagSymbol", channel_count == 2 ? "sgST" : "sg51");
+	writer.writeTextElement(XML_NAMESPACE_REGXML_ELEMENTS, "MCATagName", channel_count == 2 ? "Standard Stereo" : "5.1");
+	writer.writeTextElement(XML_NAMESPACE_REGXML_ELEMENTS, "RFC5646SpokenLanguage", language);
+	writer.writeTextElement(XML_NAMESPACE_REGXML_ELEMENTS, "MCATitle", QString("Synthetic variant %1").arg(variant));
+	writer.writeEndElement(); // SoundfieldGroupLabelSubDescriptor
+	writer.writeEndElement(); // SubDescriptors
+	writer.writeEndElement(); // WAVEPCMDescriptor
+	writer.writeEndDocument();
+	return xml;
+}
+
+quint32 SyntheticImpGenerator::NextRandom() {
+
+	// xorshift32
+	mRandomState ^= mRandomState << 13;
+	mRandomState ^= mRandomState >> 17;
+	mRandomState ^= mRandomState << 5;
+	return mRandomState;
+}
+
+Error SyntheticImpGenerator::GenerateWavSources(const QDir &rTargetDir, QStringList &rFiles) {
+
+	Error error;
+	if(rTargetDir.mkpath("sources") == false) return Error(Error::DestinationFileOpenError, rTargetDir.absoluteFilePath("sources"));
+	QDir source_dir(rTargetDir.absoluteFilePath("sources"));
+	mRandomState = mParameters.seed ? mParameters.seed : 1;
+	rFiles.clear();
+	for(int i = 0; i < mParameters.pcmTrackCount && error.IsError() == false; i++) {
+		QString file_path = source_dir.absoluteFilePath(QString("audio_%1.wav").arg(i, 4, 10, QChar('0')));
+		error = WriteWav(file_path, i);
+		rFiles << file_path;
+	}
+	return error;
+}
+
+Error SyntheticImpGenerator::GenerateJ2cSources(const QDir &rTargetDir, int frameCount, QStringList &rFiles) {
+
+	const int width = 1920;
+	const int height = 1080;
+	const int depth = 12;
+	if(rTargetDir.mkpath("sources/j2c") == false) return Error(Error::DestinationFileOpenError, rTargetDir.absoluteFilePath("sources/j2c"));
+	QDir source_dir(rTargetDir.absoluteFilePath("sources/j2c"));
+	rFiles.clear();
+	for(int i = 0; i < frameCount; i++) rFiles << source_dir.absoluteFilePath(QString("frame_%1.j2c").arg(i, 6, 10, QChar('0')));
+	if(rFiles.isEmpty() == true) return Error();
+	QFileInfo first_frame(rFiles.first());
+	if(first_frame.exists() == false || first_frame.size() == 0) {
+		opj_image_cmptparm_t component_parameters[3];
+		memset(component_parameters, 0, sizeof(component_parameters));
+		for(int c = 0; c < 3; c++) {
+			component_parameters[c].dx = 1;
+			component_parameters[c].dy = 1;
+			component_parameters[c].w = width;
+			component_parameters[c].h = height;
+			component_parameters[c].prec = depth;
+			component_parameters[c].sgnd = 0;
+		}
+		opj_image_t *p_image = opj_image_create(3, component_parameters, OPJ_CLRSPC_SRGB);
+		if(p_image == NULL) return Error(Error::Unknown, tr("Couldn't create JPEG 2000 image."));
+		p_image->x0 = 0;
+		p_image->y0 = 0;
+		p_image->x1 = width;
+		p_image->y1 = height;
+		// Gradients plus noise. Pure gradients would compress far better than real pictures.
+		mRandomState = mParameters.seed ? mParameters.seed : 1;
+		const int max_value = (1 << depth) - 1;
+		for(int y = 0; y < height; y++) {
+			for(int x = 0; x < width; x++) {
+				const int noise = (int)(NextRandom() & 0xff) - 0x80;
+				p_image->comps[0].data[y * width + x] = qBound(0, x * max_value / width + noise, max_value);
+				p_image->comps[1].data[y * width + x] = qBound(0, y * max_value / height + noise, max_value);
+				p_image->comps[2].data[y * width + x] = qBound(0, (x + y) * max_value / (width + height) - noise, max_value);
+			}
+		}
+		opj_cparameters_t parameters;
+		opj_set_default_encoder_parameters(&parameters);
+		parameters.tcp_numlayers = 1;
+		parameters.cp_disto_alloc = 1;
+		parameters.tcp_rates[0] = 10;
+		parameters.irreversible = 1;
+		parameters.tcp_mct = 1;
+		parameters.numresolution = 6;
+		opj_codec_t *p_codec = opj_create_compress(OPJ_CODEC_J2K);
+		opj_stream_t *p_stream = NULL;
+		bool success = (p_codec != NULL && opj_setup_encoder(p_codec, &parameters, p_image));
+		if(success) p_stream = opj_stream_create_default_file_stream(QFile::encodeName(rFiles.first()).constData(), OPJ_FALSE);
+		success = (success && p_stream != NULL && opj_start_compress(p_codec, p_image, p_stream) && opj_encode(p_codec, p_stream) && opj_end_compress(p_codec, p_stream));
+		if(p_stream) opj_stream_destroy(p_stream);
+		if(p_codec) opj_destroy_codec(p_codec);
+		opj_image_destroy(p_image);
+		if(success == false) {
+			QFile::remove(rFiles.first());
+			return Error(Error::Unknown, tr("Couldn't encode JPEG 2000 codestream."));
+		}
+	}
+	// Every frame is a copy of the first one. The benchmarks measure I/O and wrapping, not content.
+	for(int i = 1; i < rFiles.size(); i++) {
+		QFileInfo frame(rFiles.at(i));
+		if(frame.exists() == true && frame.size() == QFileInfo(rFiles.first()).size()) continue;
+		QFile::remove(rFiles.at(i));
+		if(QFile::copy(rFiles.first(), rFiles.at(i)) == false) return Error(Error::DestinationFileOpenError, rFiles.at(i));
+	}
+	return Error();
+}
+
+Error SyntheticImpGenerator::Generate(const QDir &rTargetDir) {
+
+	if(mParameters.editRate.IsValid() == false || mParameters.segmentCount < 1 || mParameters.resourcesPerSequence < 1 || mParameters.framesPerResource < 1) {
+		return Error(Error::Unknown, tr("Invalid synthetic IMP parameters."));
+	}
+	if(mParameters.framesPerResource > mParameters.trackDuration * mParameters.editRate.GetQuotient()) {
+		return Error(Error::Unknown, tr("Resources must not be longer than the track files."));
+	}
+	if(rTargetDir.mkpath(".") == false) return Error(Error::DestinationFileOpenError, rTargetDir.absolutePath());
+	mTargetDir = rTargetDir;
+	mTracks.clear();
+	mXmlAssets.clear();
+	mCplIds.clear();
+	mTrackFiles.clear();
+
+	// PCM track files
+	Error error = GenerateWavSources(rTargetDir, mWavFiles);
+	const SoundfieldGroup soundfield_group = (mParameters.audioChannelCount == 6 ? SoundfieldGroup::SoundFieldGroup51 : SoundfieldGroup::SoundFieldGroupST);
+	for(int i = 0; i < mWavFiles.size() && error.IsError() == false; i++) {
+		TrackFile track;
+		track.id = CreateId(QString("pcm/%1").arg(i));
+		track.fileName = QString("audio_%1.mxf").arg(i, 4, 10, QChar('0'));
+		track.editRate = EditRate::EditRate48000;
+		track.intrinsicDuration = (qint64)mParameters.trackDuration * SYNTHETIC_SAMPLE_RATE;
+		track.isAudio = true;
+		JobWrapWav job(QStringList() << mWavFiles.at(i), mTargetDir.absoluteFilePath(track.fileName), soundfield_group, track.id);
+		job.setAutoDelete(false);
+		error = job.PerformRun();
+		if(error.IsError() == false) error = Hash(mTargetDir.absoluteFilePath(track.fileName), track.hash);
+		track.size = QFileInfo(mTargetDir.absoluteFilePath(track.fileName)).size();
+		mTracks << track;
+		mTrackFiles << mTargetDir.absoluteFilePath(track.fileName);
+	}
+	// Timed text track files. The tracks are wrapped concurrently.
+	QList<TrackFile> text_tracks;
+	QList<JobWrapTimedText*> text_jobs;
+	for(int i = 0; i < mParameters.timedTextTrackCount && error.IsError() == false; i++) {
+		QString source = mTargetDir.absoluteFilePath(QString("sources/text_%1.ttml").arg(i, 4, 10, QChar('0')));
+		error = WriteTtml(source, i);
+		if(error.IsError() == true) break;
+		TrackFile track;
+		track.id = CreateId(QString("ttml/%1").arg(i));
+		track.fileName = QString("text_%1.mxf").arg(i, 4, 10, QChar('0'));
+		track.editRate = mParameters.editRate;
+		track.intrinsicDuration = (qint64)(mParameters.trackDuration * mParameters.editRate.GetQuotient());
+		track.isAudio = false;
+		JobWrapTimedText *p_job = new JobWrapTimedText(QStringList() << source, mTargetDir.absoluteFilePath(track.fileName), EditRate(1000, 1), Duration(mParameters.trackDuration * 1000), track.id, IMSC1_TEXT_PROFILE, mParameters.editRate);
+		p_job->setAutoDelete(false);
+		text_tracks << track;
+		text_jobs << p_job;
+	}
+	if(error.IsError() == false) {
+		QThreadPool thread_pool;
+		for(int i = 0; i < text_jobs.size(); i++) thread_pool.start(text_jobs.at(i));
+		thread_pool.waitForDone();
+	}
+	for(int i = 0; i < text_tracks.size(); i++) {
+		TrackFile track = text_tracks.at(i);
+		if(error.IsError() == false) error = text_jobs.at(i)->GetLastError();
+		if(error.IsError() == false) {
+			error = Hash(mTargetDir.absoluteFilePath(track.fileName), track.hash);
+			track.size = QFileInfo(mTargetDir.absoluteFilePath(track.fileName)).size();
+			mTracks << track;
+			mTrackFiles << mTargetDir.absoluteFilePath(track.fileName);
+		}
+	}
+	qDeleteAll(text_jobs);
+	// CPLs
+	for(int i = 0; i < mParameters.cplCount && error.IsError() == false; i++) {
+		QUuid cpl_id = CreateId(QString("cpl/%1").arg(i));
+		QString file_path = mTargetDir.absoluteFilePath(QString("CPL_%1.xml").arg(strip_uuid(cpl_id)));
+		error = WriteCpl(file_path, cpl_id, i);
+		if(error.IsError() == false) error = AddXmlAsset(QFileInfo(file_path), cpl_id, false);
+		mCplIds << cpl_id;
+	}
+	// PKL, VOLINDEX, ASSETMAP
+	if(error.IsError() == false) {
+		QUuid pkl_id = CreateId("pkl");
+		QString file_path = mTargetDir.absoluteFilePath(QString("PKL_%1.xml").arg(strip_uuid(pkl_id)));
+		error = WritePackingList(file_path, pkl_id);
+		if(error.IsError() == false) error = AddXmlAsset(QFileInfo(file_path), pkl_id, true);
+	}
+	if(error.IsError() == false) error = WriteVolumeIndex(mTargetDir.absoluteFilePath(VOLINDEX_SEARCH_NAME));
+	if(error.IsError() == false) error = WriteAssetMap(mTargetDir.absoluteFilePath(ASSET_SEARCH_NAME));
+	return error;
+}
+
+Error SyntheticImpGenerator::WriteWav(const QString &rFilePath, int index) {
+
+	QFile file(rFilePath);
+	if(file.open(QIODevice::WriteOnly | QIODevice::Truncate) == false) return Error(Error::DestinationFileOpenError, rFilePath);
+	const quint32 channels = mParameters.audioChannelCount;
+	const quint32 bytes_per_sample = 3;
+	const quint32 sample_count = mParameters.trackDuration * SYNTHETIC_SAMPLE_RATE;
+	const quint32 data_size = sample_count * channels * bytes_per_sample;
+	QDataStream stream(&file);
+	stream.writeRawData("RIFF", 4);
+	write_le(stream, 36 + data_size, 4);
+	stream.writeRawData("WAVE", 4);
+	stream.writeRawData("fmt ", 4);
+	write_le(stream, 16, 4);
+	write_le(stream, 1, 2); // PCM
+	write_le(stream, channels, 2);
+	write_le(stream, SYNTHETIC_SAMPLE_RATE, 4);
+	write_le(stream, SYNTHETIC_SAMPLE_RATE * channels * bytes_per_sample, 4);
+	write_le(stream, channels * bytes_per_sample, 2);
+	write_le(stream, bytes_per_sample * 8, 2);
+	stream.writeRawData("data", 4);
+	write_le(stream, data_size, 4);
+
+	// A sine per channel plus low level noise. Written block wise.
+	QByteArray block;
+	block.reserve(SYNTHETIC_SAMPLE_RATE * channels * bytes_per_sample);
+	const double two_pi = 6.283185307179586;
+	for(quint32 sample = 0; sample < sample_count; sample++) {
+		for(quint32 channel = 0; channel < channels; channel++) {
+			double frequency = 110. * (index + 1) + 55. * channel;
+			qint32 value = (qint32)(std::sin(two_pi * frequency * sample / SYNTHETIC_SAMPLE_RATE) * 0x3fffff) + (qint32)(NextRandom() & 0xfff) - 0x800;
+			block.append((char)(value & 0xff));
+			block.append((char)((value >> 8) & 0xff));
+			block.append((char)((value >> 16) & 0xff));
+		}
+		if(block.size() >= SYNTHETIC_SAMPLE_RATE * (int)(channels * bytes_per_sample)) {
+			stream.writeRawData(block.constData(), block.size());
+			block.resize(0);
+		}
+	}
+	if(block.isEmpty() == false) stream.writeRawData(block.constData(), block.size());
+	file.close();
+	if(stream.status() != QDataStream::Ok) return Error(Error::DestinationFileOpenError, rFilePath);
+	return Error();
+}
+
+Error SyntheticImpGenerator::WriteTtml(const QString &rFilePath, int index) {
+
+	QFile file(rFilePath);
+	if(file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text) == false) return Error(Error::DestinationFileOpenError, rFilePath);
+	QXmlStreamWriter writer(&file);
+	writer.setAutoFormatting(true);
+	writer.writeStartDocument();
+	writer.writeNamespace(XML_NAMESPACE_TTML_PARAMETER, "ttp");
+	writer.writeNamespace(XML_NAMESPACE_TTML_STYLING, "tts");
+	writer.writeDefaultNamespace(XML_NAMESPACE_TTML);
+	writer.writeStartElement(XML_NAMESPACE_TTML, "tt");
+	writer.writeAttribute(XML_NAMESPACE_TTML_PARAMETER, "profile", IMSC1_TEXT_PROFILE);
+	writer.writeAttribute(XML_NAMESPACE_TTML_PARAMETER, "frameRate", QString::number(mParameters.editRate.GetRoundendQuotient()));
+	if(mParameters.editRate.GetDenominator() != 1) writer.writeAttribute(XML_NAMESPACE_TTML_PARAMETER, "frameRateMultiplier", QString("1000 1001"));
+	writer.writeAttribute(XML_NAMESPACE_TTML_PARAMETER, "timeBase", "media");
+	writer.writeAttribute("xml:lang", "en");
+	writer.writeStartElement("head");
+	writer.writeStartElement("styling");
+	writer.writeStartElement("style");
+	writer.writeAttribute("xml:id", "s1");
+	writer.writeAttribute(XML_NAMESPACE_TTML_STYLING, "color", "white");
+	writer.writeAttribute(XML_NAMESPACE_TTML_STYLING, "textAlign", "center");
+	writer.writeEndElement(); // style
+	writer.writeEndElement(); // styling
+	writer.writeStartElement("layout");
+	writer.writeStartElement("region");
+	writer.writeAttribute("xml:id", "r1");
+	writer.writeAttribute(XML_NAMESPACE_TTML_STYLING, "origin", "10% 80%");
+	writer.writeAttribute(XML_NAMESPACE_TTML_STYLING, "extent", "80% 10%");
+	writer.writeEndElement(); // region
+	writer.writeEndElement(); // layout
+	writer.writeEndElement(); // head
+	writer.writeStartElement("body");
+	writer.writeAttribute("end", QString("%1s").arg(mParameters.trackDuration));
+	writer.writeStartElement("div");
+	// One cue per second.
+	for(int i = 0; i < mParameters.trackDuration; i++) {
+		writer.writeStartElement("p");
+		writer.writeAttribute("begin", QString("%1.000s").arg(i));
+		writer.writeAttribute("end", QString("%1.800s").arg(i));
+		writer.writeAttribute("region", "r1");
+		writer.writeAttribute("style", "s1");
+		writer.writeCharacters(QString("Track %1 cue %2 (%3)").arg(index).arg(i).arg(NextRandom() % 10000));
+		writer.writeEndElement(); // p
+	}
+	writer.writeEndElement(); // div
+	writer.writeEndElement(); // body
+	writer.writeEndElement(); // tt
+	writer.writeEndDocument();
+	file.close();
+	if(writer.hasError()) return Error(Error::DestinationFileOpenError, rFilePath);
+	return Error();
+}
+
+Error SyntheticImpGenerator::WriteCpl(const QString &rFilePath, const QUuid &rId, int index) {
+
+	QFile file(rFilePath);
+	if(file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text) == false) return Error(Error::DestinationFileOpenError, rFilePath);
+	const QString edit_rate = QString("%1 %2").arg(mParameters.editRate.GetNumerator()).arg(mParameters.editRate.GetDenominator());
+	const qint64 samples_per_frame = (qint64)SYNTHETIC_SAMPLE_RATE * mParameters.editRate.GetDenominator() / mParameters.editRate.GetNumerator();
+	QList<int> audio_tracks, text_tracks;
+	for(int i = 0; i < mTracks.size(); i++) {
+		if(mTracks.at(i).isAudio) audio_tracks << i;
+		else text_tracks << i;
+	}
+	const QUuid audio_track_id = CreateId(QString("cpl/%1/track/audio").arg(index));
+	const QUuid text_track_id = CreateId(QString("cpl/%1/track/text").arg(index));
+	const QUuid marker_track_id = CreateId(QString("cpl/%1/track/marker").arg(index));
+	const qint64 segment_duration = (qint64)mParameters.resourcesPerSequence * mParameters.framesPerResource;
+	const QStringList marker_labels = MarkerLabel::GetMarkerLabels();
+
+	QXmlStreamWriter writer(&file);
+	writer.setAutoFormatting(true);
+	writer.writeStartDocument();
+	writer.writeDefaultNamespace(XML_NAMESPACE_CPL);
+	writer.writeNamespace(XML_NAMESPACE_CC, "cc");
+	writer.writeNamespace(XML_NAMESPACE_XSI, "xsi");
+	writer.writeStartElement(XML_NAMESPACE_CPL, "CompositionPlaylist");
+	writer.writeTextElement("Id", urn(rId));
+	writer.writeTextElement("Annotation", QString("Synthetic CPL %1").arg(index));
+	writer.writeTextElement("IssueDate", SYNTHETIC_ISSUE_DATE);
+	writer.writeTextElement("Issuer", SYNTHETIC_ISSUER);
+	writer.writeTextElement("Creator", CREATOR_STRING);
+	writer.writeTextElement("ContentTitle", QString("Synthetic %1 segments").arg(mParameters.segmentCount));
+	writer.writeTextElement("EditRate", edit_rate);
+	writer.writeStartElement("SegmentList");
+	int resource_counter = 0;
+	for(int segment = 0; segment < mParameters.segmentCount; segment++) {
+		writer.writeStartElement("Segment");
+		writer.writeTextElement("Id", urn(CreateId(QString("cpl/%1/segment/%2").arg(index).arg(segment))));
+		writer.writeStartElement("SequenceList");
+		if(mParameters.markersPerSegment > 0) {
+			writer.writeStartElement("MarkerSequence");
+			writer.writeTextElement("Id", urn(CreateId(QString("cpl/%1/segment/%2/marker").arg(index).arg(segment))));
+			writer.writeTextElement("TrackId", urn(marker_track_id));
+			writer.writeStartElement("ResourceList");
+			writer.writeStartElement("Resource");
+			writer.writeAttribute(XML_NAMESPACE_XSI, "type", "MarkerResourceType");
+			writer.writeTextElement("Id", urn(CreateId(QString("cpl/%1/segment/%2/marker/resource").arg(index).arg(segment))));
+			writer.writeTextElement("EditRate", edit_rate);
+			writer.writeTextElement("IntrinsicDuration", QString::number(segment_duration));
+			for(int marker = 0; marker < mParameters.markersPerSegment; marker++) {
+				writer.writeStartElement("Marker");
+				writer.writeTextElement("Label", marker_labels.isEmpty() ? QString("FFOC") : marker_labels.at(NextRandom() % marker_labels.size()));
+				writer.writeTextElement("Offset", QString::number(NextRandom() % segment_duration));
+				writer.writeEndElement(); // Marker
+			}
+			writer.writeEndElement(); // Resource
+			writer.writeEndElement(); // ResourceList
+			writer.writeEndElement(); // MarkerSequence
+		}
+		for(int type = 0; type < 2; type++) {
+			const QList<int> &r_tracks = (type == 0 ? audio_tracks : text_tracks);
+			if(r_tracks.isEmpty()) continue;
+			writer.writeStartElement(XML_NAMESPACE_CC, type == 0 ? "MainAudioSequence" : "SubtitlesSequence");
+			writer.writeTextElement(XML_NAMESPACE_CPL, "Id", urn(CreateId(QString("cpl/%1/segment/%2/sequence/%3").arg(index).arg(segment).arg(type))));
+			writer.writeTextElement(XML_NAMESPACE_CPL, "TrackId", urn(type == 0 ? audio_track_id : text_track_id));
+			writer.writeStartElement(XML_NAMESPACE_CPL, "ResourceList");
+			for(int resource = 0; resource < mParameters.resourcesPerSequence; resource++) {
+				const TrackFile &r_track = mTracks.at(r_tracks.at(resource_counter % r_tracks.size()));
+				const qint64 units_per_frame = (r_track.isAudio ? samples_per_frame : 1);
+				const qint64 source_duration = units_per_frame * mParameters.framesPerResource;
+				const qint64 entry_point = ((qint64)(NextRandom() % qMax<qint64>(1, (r_track.intrinsicDuration - source_duration) / units_per_frame + 1))) * units_per_frame;
+				writer.writeStartElement(XML_NAMESPACE_CPL, "Resource");
+				writer.writeAttribute(XML_NAMESPACE_XSI, "type", "TrackFileResourceType");
+				writer.writeTextElement(XML_NAMESPACE_CPL, "Id", urn(CreateId(QString("cpl/%1/resource/%2").arg(index).arg(resource_counter))));
+				writer.writeTextElement(XML_NAMESPACE_CPL, "EditRate", QString("%1 %2").arg(r_track.editRate.GetNumerator()).arg(r_track.editRate.GetDenominator()));
+				writer.writeTextElement(XML_NAMESPACE_CPL, "IntrinsicDuration", QString::number(r_track.intrinsicDuration));
+				writer.writeTextElement(XML_NAMESPACE_CPL, "EntryPoint", QString::number(entry_point));
+				writer.writeTextElement(XML_NAMESPACE_CPL, "SourceDuration", QString::number(source_duration));
+				writer.writeTextElement(XML_NAMESPACE_CPL, "SourceEncoding", urn(CreateId(QString("encoding/%1").arg(r_track.id.toString()))));
+				writer.writeTextElement(XML_NAMESPACE_CPL, "TrackFileId", urn(r_track.id));
+				writer.writeEndElement(); // Resource
+				resource_counter++;
+			}
+			writer.writeEndElement(); // ResourceList
+			writer.writeEndElement(); // Sequence
+		}
+		writer.writeEndElement(); // SequenceList
+		writer.writeEndElement(); // Segment
+	}
+	writer.writeEndElement(); // SegmentList
+	writer.writeEndElement(); // CompositionPlaylist
+	writer.writeEndDocument();
+	file.close();
+	if(writer.hasError()) return Error(Error::DestinationFileOpenError, rFilePath);
+	return Error();
+}
+
+Error SyntheticImpGenerator::WritePackingList(const QString &rFilePath, const QUuid &rId) {
+
+	QFile file(rFilePath);
+	if(file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text) == false) return Error(Error::DestinationFileOpenError, rFilePath);
+	QXmlStreamWriter writer(&file);
+	writer.setAutoFormatting(true);
+	writer.writeStartDocument();
+	writer.writeDefaultNamespace(XML_NAMESPACE_PKL);
+	writer.writeStartElement(XML_NAMESPACE_PKL, "PackingList");
+	writer.writeTextElement("Id", urn(rId));
+	writer.writeTextElement("AnnotationText", "Synthetic IMP");
+	writer.writeTextElement("IssueDate", SYNTHETIC_ISSUE_DATE);
+	writer.writeTextElement("Issuer", SYNTHETIC_ISSUER);
+	writer.writeTextElement("Creator", CREATOR_STRING);
+	writer.writeStartElement("AssetList");
+	for(int i = 0; i < mTracks.size(); i++) {
+		writer.writeStartElement("Asset");
+		writer.writeTextElement("Id", urn(mTracks.at(i).id));
+		writer.writeTextElement("Hash", mTracks.at(i).hash.toBase64());
+		writer.writeTextElement("Size", QString::number(mTracks.at(i).size));
+		writer.writeTextElement("Type", MIME_TYPE_MXF);
+		writer.writeTextElement("OriginalFileName", mTracks.at(i).fileName);
+		writer.writeEndElement(); // Asset
+	}
+	for(int i = 0; i < mXmlAssets.size(); i++) {
+		if(mXmlAssets.at(i).isPackingList) continue;
+		writer.writeStartElement("Asset");
+		writer.writeTextElement("Id", urn(mXmlAssets.at(i).id));
+		writer.writeTextElement("Hash", mXmlAssets.at(i).hash.toBase64());
+		writer.writeTextElement("Size", QString::number(mXmlAssets.at(i).size));
+		writer.writeTextElement("Type", MIME_TYPE_XML);
+		writer.writeTextElement("OriginalFileName", mXmlAssets.at(i).fileName);
+		writer.writeEndElement(); // Asset
+	}
+	writer.writeEndElement(); // AssetList
+	writer.writeEndElement(); // PackingList
+	writer.writeEndDocument();
+	file.close();
+	if(writer.hasError()) return Error(Error::DestinationFileOpenError, rFilePath);
+	return Error();
+}
+
+Error SyntheticImpGenerator::WriteAssetMap(const QString &rFilePath) {
+
+	QFile file(rFilePath);
+	if(file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text) == false) return Error(Error::DestinationFileOpenError, rFilePath);
+	QXmlStreamWriter writer(&file);
+	writer.setAutoFormatting(true);
+	writer.writeStartDocument();
+	writer.writeDefaultNamespace(XML_NAMESPACE_AM);
+	writer.writeStartElement(XML_NAMESPACE_AM, "AssetMap");
+	writer.writeTextElement("Id", urn(CreateId("assetmap")));
+	writer.writeTextElement("AnnotationText", "Synthetic IMP");
+	writer.writeTextElement("Creator", CREATOR_STRING);
+	writer.writeTextElement("VolumeCount", "1");
+	writer.writeTextElement("IssueDate", SYNTHETIC_ISSUE_DATE);
+	writer.writeTextElement("Issuer", SYNTHETIC_ISSUER);
+	writer.writeStartElement("AssetList");
+	QList<QPair<QUuid, QString> > assets;
+	for(int i = 0; i < mTracks.size(); i++) assets << qMakePair(mTracks.at(i).id, mTracks.at(i).fileName);
+	for(int i = 0; i < mXmlAssets.size(); i++) {
+		writer.writeStartElement("Asset");
+		writer.writeTextElement("Id", urn(mXmlAssets.at(i).id));
+		if(mXmlAssets.at(i).isPackingList) writer.writeTextElement("PackingList", "true");
+		writer.writeStartElement("ChunkList");
+		writer.writeStartElement("Chunk");
+		writer.writeTextElement("Path", mXmlAssets.at(i).fileName);
+		writer.writeEndElement(); // Chunk
+		writer.writeEndElement(); // ChunkList
+		writer.writeEndElement(); // Asset
+	}
+	for(int i = 0; i < assets.size(); i++) {
+		writer.writeStartElement("Asset");
+		writer.writeTextElement("Id", urn(assets.at(i).first));
+		writer.writeStartElement("ChunkList");
+		writer.writeStartElement("Chunk");
+		writer.writeTextElement("Path", assets.at(i).second);
+		writer.writeEndElement(); // Chunk
+		writer.writeEndElement(); // ChunkList
+		writer.writeEndElement(); // Asset
+	}
+	writer.writeEndElement(); // AssetList
+	writer.writeEndElement(); // AssetMap
+	writer.writeEndDocument();
+	file.close();
+	if(writer.hasError()) return Error(Error::DestinationFileOpenError, rFilePath);
+	return Error();
+}
+
+Error SyntheticImpGenerator::WriteVolumeIndex(const QString &rFilePath) {
+
+	QFile file(rFilePath);
+	if(file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text) == false) return Error(Error::DestinationFileOpenError, rFilePath);
+	QXmlStreamWriter writer(&file);
+	writer.setAutoFormatting(true);
+	writer.writeStartDocument();
+	writer.writeDefaultNamespace(XML_NAMESPACE_AM);
+	writer.writeStartElement(XML_NAMESPACE_AM, "VolumeIndex");
+	writer.writeTextElement("Index", "1");
+	writer.writeEndElement(); // VolumeIndex
+	writer.writeEndDocument();
+	file.close();
+	if(writer.hasError()) return Error(Error::DestinationFileOpenError, rFilePath);
+	return Error();
+}
+
+Error SyntheticImpGenerator::AddXmlAsset(const QFileInfo &rFile, const QUuid &rId, bool isPackingList) {
+
+	XmlAsset asset;
+	asset.id = rId;
+	asset.fileName = rFile.fileName();
+	asset.size = rFile.size();
+	asset.isPackingList = isPackingList;
+	Error error = Hash(rFile.absoluteFilePath(), asset.hash);
+	mXmlAssets << asset;
+	return error;
+}
+
+Error SyntheticImpGenerator::Hash(const QString &rFilePath, QByteArray &rHash) {
+
+	QFile file(rFilePath);
+	if(file.open(QIODevice::ReadOnly) == false) return Error(Error::SourceFileOpenError, rFilePath);
+	QCryptographicHash hasher(QCryptographicHash::Sha1);
+	if(hasher.addData(&file) == false) return Error(Error::HashCalculation, rFilePath);
+	rHash = hasher.result();
+	return Error();
+}
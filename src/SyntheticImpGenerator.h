@@ -0,0 +1,107 @@
+/* Copyright(C) 2016 Björn Stresing, Denis Manthey, Wolfgang Ruppel
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include "Error.h"
+#include "ImfCommon.h"
+#include <QObject>
+#include <QDir>
+#include <QFileInfo>
+#include <QUuid>
+#include <QStringList>
+#include <QList>
+
+
+class QXmlStreamWriter;
+
+/*! \brief Generates IMF packages of configurable size for benchmarks and regression tests.
+The package contains PCM and IMSC1 text track files (wrapped from generated WAV and TTML sources), CPLs with many segments, a Packing List, VOLINDEX.xml and ASSETMAP.xml.
+All Ids are name based (UUID v5) and all essence is derived from SyntheticImpGenerator::Parameters::seed. The same parameters always produce the same sources and XML files.
+*/
+class SyntheticImpGenerator : public QObject {
+
+	Q_OBJECT
+
+public:
+	struct Parameters {
+		Parameters();
+		int pcmTrackCount;
+		int timedTextTrackCount;
+		int cplCount;
+		int segmentCount; // per CPL
+		int resourcesPerSequence;
+		int framesPerResource; // [CPL edit units]
+		int markersPerSegment;
+		int trackDuration; // [s]
+		int audioChannelCount; // 2 or 6
+		quint32 seed;
+		EditRate editRate;
+	};
+
+	SyntheticImpGenerator(const Parameters &rParameters, QObject *pParent = NULL);
+	virtual ~SyntheticImpGenerator() {}
+	//! Generates the package in rTargetDir. Sources are written into the subdirectory "sources". Existing files are overwritten.
+	Error Generate(const QDir &rTargetDir);
+	//! Only writes the WAV sources (no wrapping). Returns the file paths.
+	Error GenerateWavSources(const QDir &rTargetDir, QStringList &rFiles);
+	//! Writes a JPEG 2000 codestream sequence (1920 x 1080, 12 bit RGB, irreversible, 1:10) into the subdirectory "sources/j2c". One frame is encoded and copied. Returns the file paths.
+	Error GenerateJ2cSources(const QDir &rTargetDir, int frameCount, QStringList &rFiles);
+	QList<QUuid> GetCplIds() const { return mCplIds; }
+	QStringList GetWavFiles() const { return mWavFiles; }
+	QStringList GetTrackFiles() const { return mTrackFiles; }
+	//! Name based Id. Identical names and seeds result in identical Ids.
+	QUuid CreateId(const QString &rName) const;
+	/*! \brief RegXML dump of a WAVE PCM essence descriptor as written by regxmllib.
+	The InstanceIDs are unique per index, the remaining content repeats every variantCount indices (channel count, language and labels).
+	*/
+	QByteArray CreateEssenceDescriptor(int index, int variantCount) const;
+
+private:
+	Q_DISABLE_COPY(SyntheticImpGenerator);
+	struct TrackFile {
+		QUuid id;
+		QString fileName;
+		qint64 size;
+		QByteArray hash;
+		EditRate editRate;
+		qint64 intrinsicDuration;
+		bool isAudio;
+	};
+	struct XmlAsset {
+		QUuid id;
+		QString fileName;
+		qint64 size;
+		QByteArray hash;
+		bool isPackingList;
+	};
+	Error WriteWav(const QString &rFilePath, int index);
+	Error WriteTtml(const QString &rFilePath, int index);
+	Error WriteCpl(const QString &rFilePath, const QUuid &rId, int index);
+	Error WritePackingList(const QString &rFilePath, const QUuid &rId);
+	Error WriteAssetMap(const QString &rFilePath);
+	Error WriteVolumeIndex(const QString &rFilePath);
+	Error AddXmlAsset(const QFileInfo &rFile, const QUuid &rId, bool isPackingList);
+	Error Hash(const QString &rFilePath, QByteArray &rHash);
+	quint32 NextRandom();
+
+	const Parameters mParameters;
+	quint32 mRandomState;
+	QList<TrackFile> mTracks;
+	QList<XmlAsset> mXmlAssets;
+	QList<QUuid> mCplIds;
+	QStringList mWavFiles;
+	QStringList mTrackFiles;
+	QDir mTargetDir;
+};
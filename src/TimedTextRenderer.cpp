@@ -0,0 +1,1113 @@
+/* Copyright(C) 2016 Björn Stresing, Denis Manthey, Wolfgang Ruppel
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "TimedTextRenderer.h"
+#include "global.h"
+#include "XmlParserPool.h"
+#include "Trace.h"
+#include "AS_02.h"
+#include <KM_util.h>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDateTime>
+#include <QUuid>
+#include <QRegularExpression>
+#include <QPainter>
+#include <QTextLayout>
+#include <QFontDatabase>
+#include <QElapsedTimer>
+#include <QRunnable>
+#include <QMutexLocker>
+#include <QDebug>
+#include <xercesc/dom/DOM.hpp>
+#include <algorithm>
+#include <limits>
+
+#define XML_NAMESPACE_TTML "http://www.w3.org/ns/ttml"
+#define XML_NAMESPACE_TTML_PARAMETER "http://www.w3.org/ns/ttml#parameter"
+#define XML_NAMESPACE_TTML_STYLING "http://www.w3.org/ns/ttml#styling"
+#define XML_NAMESPACE_SMPTE_TT "http://www.smpte-ra.org/schemas/2052-1/2010/smpte-tt"
+#define XML_NAMESPACE_XML "http://www.w3.org/XML/1998/namespace"
+// Ancillary resources of a timed text track file are small PNG images and fonts.
+#define TIMED_TEXT_RESOURCE_CAPACITY (4 * 1024 * 1024)
+
+
+const qint64 TimedTextDocument::Indefinite = std::numeric_limits<qint64>::max();
+
+namespace {
+
+typedef QHash<QString, QString> StyleSet; // Key: Local name of the tts attribute.
+
+QString to_qstring(const XMLCh *pString) {
+
+	if(pString == NULL) return QString();
+	return QString::fromUtf16(reinterpret_cast<const ushort*>(pString));
+}
+
+const XMLCh* to_xml(const QString &rString) {
+
+	return reinterpret_cast<const XMLCh*>(rString.utf16());
+}
+
+QString local_name(const xercesc::DOMNode *pNode) {
+
+	return to_qstring(pNode->getLocalName() ? pNode->getLocalName() : pNode->getNodeName());
+}
+
+QString attribute(const xercesc::DOMElement *pElement, const QString &rLocalName, const QString &rNamespace = QString()) {
+
+	if(rNamespace.isEmpty() == true) return to_qstring(pElement->getAttribute(to_xml(rLocalName))).trimmed();
+	return to_qstring(pElement->getAttributeNS(to_xml(rNamespace), to_xml(rLocalName))).trimmed();
+}
+
+bool is_tt_element(const xercesc::DOMNode *pNode, const QString &rLocalName) {
+
+	return pNode->getNodeType() == xercesc::DOMNode::ELEMENT_NODE && local_name(pNode) == rLocalName && to_qstring(pNode->getNamespaceURI()) == XML_NAMESPACE_TTML;
+}
+
+QStringList split_tokens(const QString &rText) {
+
+	return rText.split(QRegularExpression("\\s+"), QString::SkipEmptyParts);
+}
+
+qint64 add_time(qint64 time, qint64 offset) {
+
+	if(time == TimedTextDocument::Indefinite || offset == TimedTextDocument::Indefinite) return TimedTextDocument::Indefinite;
+	return time + offset;
+}
+
+bool parse_length(const QString &rText, qreal &rValue, QString &rUnit) {
+
+	static const QRegularExpression length_expression("^([+-]?(?:\\d+\\.?\\d*|\\.\\d+))(px|%|c|em|rw|rh)$");
+	const QRegularExpressionMatch match = length_expression.match(rText.trimmed());
+	if(match.hasMatch() == false) return false;
+	rValue = match.captured(1).toDouble();
+	rUnit = match.captured(2);
+	return true;
+}
+
+// #rrggbb, #rrggbbaa, rgb(), rgba() and the named colors of TTML (which are known to QColor).
+QColor parse_color(const QString &rText, const QColor &rDefault) {
+
+	const QString text = rText.trimmed();
+	if(text.isEmpty() == true) return rDefault;
+	if(text.startsWith('#') == true) {
+		bool ok = true;
+		const uint value = text.mid(1).toUInt(&ok, 16);
+		if(ok == false) return rDefault;
+		if(text.size() == 7) return QColor((value >> 16) & 0xff, (value >> 8) & 0xff, value & 0xff);
+		if(text.size() == 9) return QColor((value >> 24) & 0xff, (value >> 16) & 0xff, (value >> 8) & 0xff, value & 0xff);
+		return rDefault;
+	}
+	if(text.startsWith("rgb") == true) {
+		const int open = text.indexOf('('), close = text.lastIndexOf(')');
+		if(open < 0 || close < open) return rDefault;
+		const QStringList components = text.mid(open + 1, close - open - 1).split(',');
+		if(components.size() != 3 && components.size() != 4) return rDefault;
+		QColor color(components.at(0).trimmed().toInt(), components.at(1).trimmed().toInt(), components.at(2).trimmed().toInt());
+		if(components.size() == 4) color.setAlpha(components.at(3).trimmed().toInt());
+		return color.isValid() ? color : rDefault;
+	}
+	const QColor color(text);
+	return color.isValid() ? color : rDefault;
+}
+
+Qt::Alignment parse_text_align(const QString &rText) {
+
+	if(rText == "center") return Qt::AlignHCenter;
+	if(rText == "right" || rText == "end") return Qt::AlignRight;
+	if(rText == "justify") return Qt::AlignJustify;
+	return Qt::AlignLeft; // start
+}
+
+Qt::Alignment parse_display_align(const QString &rText) {
+
+	if(rText == "center") return Qt::AlignVCenter;
+	if(rText == "after") return Qt::AlignBottom;
+	return Qt::AlignTop; // before
+}
+
+bool is_inherited(const QString &rProperty) {
+
+	static const QSet<QString> inherited_properties = QSet<QString>() << "color" << "fontFamily" << "fontStyle" << "fontWeight" << "textAlign"
+		<< "textDecoration" << "textOutline" << "visibility" << "wrapOption";
+	return inherited_properties.contains(rProperty);
+}
+
+bool cue_less(const TimedTextCue &rLeft, const TimedTextCue &rRight) {
+
+	return rLeft.begin < rRight.begin;
+}
+
+QFont create_font(const TimedTextSpan &rSpan, qreal frameHeight) {
+
+	QFont font;
+	const QString family = rSpan.fontFamily;
+	if(family.startsWith("monospace") == true || family == "default") font = QFontDatabase::systemFont(QFontDatabase::FixedFont);
+	else if(family == "sansSerif" || family == "proportionalSansSerif") font.setStyleHint(QFont::SansSerif);
+	else if(family == "serif" || family == "proportionalSerif") {
+		font.setFamily("Serif");
+		font.setStyleHint(QFont::Serif);
+	}
+	else if(family.isEmpty() == false) font.setFamily(family);
+	font.setPixelSize(qMax(1, qRound(rSpan.fontSize * frameHeight)));
+	font.setBold(rSpan.bold);
+	font.setItalic(rSpan.italic);
+	font.setUnderline(rSpan.underline);
+	return font;
+}
+
+//! Lays out a paragraph. The outline pass draws the outlines only, in the color of the outline.
+QTextLayout* create_layout(const TimedTextParagraph &rParagraph, qreal frameHeight, qreal width, bool outline) {
+
+	QString text;
+	QList<QTextLayout::FormatRange> formats;
+	for(int i = 0; i < rParagraph.spans.size(); i++) {
+		const TimedTextSpan &r_span = rParagraph.spans.at(i);
+		QTextLayout::FormatRange range;
+		range.start = text.size();
+		range.length = r_span.text.size();
+		range.format.setFont(create_font(r_span, frameHeight));
+		if(outline == false) {
+			range.format.setForeground(r_span.color);
+			if(r_span.backgroundColor.alpha() > 0) range.format.setBackground(r_span.backgroundColor);
+		}
+		else if(r_span.outlineWidth > 0 && r_span.outlineColor.alpha() > 0) {
+			range.format.setForeground(r_span.outlineColor);
+			range.format.setTextOutline(QPen(r_span.outlineColor, 2 * r_span.outlineWidth * frameHeight, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin));
+		}
+		else range.format.setForeground(Qt::transparent);
+		formats << range;
+		text.append(r_span.text);
+	}
+	QTextLayout *p_layout = new QTextLayout(text, rParagraph.spans.isEmpty() ? QFont() : create_font(rParagraph.spans.first(), frameHeight));
+	QTextOption option(rParagraph.textAlign);
+	option.setWrapMode(QTextOption::WordWrap);
+	p_layout->setTextOption(option);
+	p_layout->setAdditionalFormats(formats);
+	p_layout->beginLayout();
+	qreal y = 0;
+	for(QTextLine line = p_layout->createLine(); line.isValid() == true; line = p_layout->createLine()) {
+		line.setLineWidth(width);
+		line.setPosition(QPointF(0, y));
+		y += line.height();
+	}
+	p_layout->endLayout();
+	return p_layout;
+}
+
+// XSL style whitespace handling of xml:space="default": Runs of spaces collapse and spaces at the beginning and the end of lines are removed.
+void collapse_spaces(QList<TimedTextSpan> &rSpans) {
+
+	bool previous_space = true; // Line start
+	int pending_span = -1; // Span ending with a space which is removed if the line ends.
+	for(int i = 0; i < rSpans.size(); i++) {
+		QString text;
+		const QString &r_source = rSpans.at(i).text;
+		for(int j = 0; j < r_source.size(); j++) {
+			const QChar c = r_source.at(j);
+			if(c == ' ') {
+				if(previous_space == true) continue;
+				text.append(c);
+				previous_space = true;
+				pending_span = i;
+			}
+			else if(c == QChar::LineSeparator) {
+				if(pending_span == i) text.chop(1);
+				else if(pending_span >= 0) rSpans[pending_span].text.chop(1);
+				text.append(c);
+				previous_space = true;
+				pending_span = -1;
+			}
+			else {
+				text.append(c);
+				previous_space = false;
+				pending_span = -1;
+			}
+		}
+		rSpans[i].text = text;
+	}
+	if(pending_span >= 0) rSpans[pending_span].text.chop(1);
+	for(int i = rSpans.size() - 1; i >= 0; i--) {
+		if(rSpans.at(i).text.isEmpty() == true) rSpans.removeAt(i);
+	}
+}
+
+bool has_visible_text(const QList<TimedTextSpan> &rSpans) {
+
+	for(int i = 0; i < rSpans.size(); i++) {
+		const QString &r_text = rSpans.at(i).text;
+		for(int j = 0; j < r_text.size(); j++) {
+			if(r_text.at(j).isSpace() == false) return true;
+		}
+	}
+	return false;
+}
+
+struct Region {
+
+	Region() : rect(0, 0, 1, 1), displayAlign(Qt::AlignTop), backgroundColor(Qt::transparent), style(), fontSize(-1) {}
+	QRectF rect; // Relative to the root container.
+	Qt::Alignment displayAlign;
+	QColor backgroundColor;
+	StyleSet style; // Inherited by the content flowed into the region.
+	qreal fontSize; // -1 if unspecified.
+};
+
+//! State inherited from the parent element.
+struct Context {
+
+	Context() : begin(0), end(TimedTextDocument::Indefinite), style(), fontSize(-1), backgroundColor(Qt::transparent), region(), preserveSpace(false) {}
+	qint64 begin; // [ms]
+	qint64 end; // [ms]
+	StyleSet style; // Inherited properties only.
+	qreal fontSize; // -1 if no ancestor specifies it.
+	QColor backgroundColor; // Of the enclosing p or span.
+	QString region;
+	bool preserveSpace;
+};
+
+//! Text with the state of its parent element.
+struct Run {
+
+	QString text;
+	Context context;
+};
+
+//! A p element during an interval in which its active spans don't change.
+struct Segment {
+
+	qint64 begin;
+	qint64 end;
+	int order; // Document order of the p element.
+	TimedTextParagraph paragraph;
+};
+
+bool segment_begin_less(const Segment &rLeft, const Segment &rRight) {
+
+	return rLeft.begin < rRight.begin;
+}
+
+bool segment_order_less(const Segment *pLeft, const Segment *pRight) {
+
+	return pLeft->order < pRight->order;
+}
+
+/*! \brief Resolves a TTML document into cues.
+Text is collected per p element and split at the begin and end times of its spans. The paragraph segments of every region are merged into cues at every time
+a segment begins or ends, so a cue holds all paragraphs shown in its region.
+*/
+class TtmlParser {
+
+public:
+	TtmlParser(const QHash<QString, QByteArray> &rResources, const QString &rBaseDir) :
+		mResources(rResources), mBaseDir(rBaseDir), mFrameRate(30), mSubFrameRate(1), mTickRate(1), mRootExtent(), mCellColumns(32), mCellRows(15),
+		mStyleElements(), mStyles(), mRegions(), mDefaultRegion(), mImages(), mSegments(), mImageCues(), mOrder(0) {}
+	Error Parse(xercesc::DOMDocument *pDocument, QVector<TimedTextCue> &rCues, QSize &rRootExtent);
+
+private:
+	Q_DISABLE_COPY(TtmlParser);
+	void ParseParameters(xercesc::DOMElement *pRoot);
+	void ParseHead(xercesc::DOMElement *pHead);
+	StyleSet ResolveStyle(const QString &rId, int depth);
+	StyleSet ReferencedStyle(xercesc::DOMElement *pElement, int depth);
+	StyleSet SpecifiedStyle(xercesc::DOMElement *pElement);
+	//! Sets begin and end of rChild. Returns false if the element is never active.
+	bool ResolveTiming(xercesc::DOMElement *pElement, const Context &rParent, qint64 syncBase, Context &rChild) const;
+	void Inherit(xercesc::DOMElement *pElement, const Context &rParent, Context &rChild);
+	void ParseContainer(xercesc::DOMElement *pElement, const Context &rContext);
+	void ParseParagraph(xercesc::DOMElement *pElement, const Context &rContext);
+	void CollectRuns(xercesc::DOMElement *pElement, const Context &rContext, QList<Run> &rRuns);
+	void AddImage(const QString &rReference, const Context &rContext);
+	QByteArray ResolveImage(const QString &rReference) const;
+	TimedTextSpan CreateSpan(const Run &rRun, const Region &rRegion) const;
+	const Region& GetRegion(const QString &rId) const;
+	void BuildCues(QVector<TimedTextCue> &rCues) const;
+	bool ParseTime(const QString &rText, qint64 &rTime) const;
+	bool ToWidth(const QString &rText, qreal &rWidth) const;
+	bool ToHeight(const QString &rText, qreal &rHeight) const;
+	qreal ResolveFontSize(const QString &rText, qreal parentFontSize) const;
+	qreal ResolveThickness(const QString &rText, qreal fontSize) const;
+	qreal GetRootWidth() const { return mRootExtent.isValid() ? mRootExtent.width() : 1920; } // IMSC1 requires tts:extent if pixels are used.
+	qreal GetRootHeight() const { return mRootExtent.isValid() ? mRootExtent.height() : 1080; }
+
+	const QHash<QString, QByteArray> &mResources;
+	const QString mBaseDir;
+	double mFrameRate; // Includes ttp:frameRateMultiplier.
+	double mSubFrameRate;
+	double mTickRate;
+	QSizeF mRootExtent;
+	int mCellColumns;
+	int mCellRows;
+	QHash<QString, xercesc::DOMElement*> mStyleElements;
+	QHash<QString, StyleSet> mStyles; // Resolved referential styles.
+	QHash<QString, Region> mRegions;
+	Region mDefaultRegion;
+	QHash<QString, QByteArray> mImages; // smpte:image
+	QHash<QString, QList<Segment> > mSegments; // Key: Region Id.
+	QList<TimedTextCue> mImageCues;
+	int mOrder;
+};
+
+Error TtmlParser::Parse(xercesc::DOMDocument *pDocument, QVector<TimedTextCue> &rCues, QSize &rRootExtent) {
+
+	xercesc::DOMElement *p_root = pDocument ? pDocument->getDocumentElement() : NULL;
+	if(p_root == NULL || is_tt_element(p_root, "tt") == false) return Error(Error::XMLSchemeError, QObject::tr("The document isn't a TTML document."));
+	ParseParameters(p_root);
+	xercesc::DOMElement *p_body = NULL;
+	for(xercesc::DOMElement *p_child = p_root->getFirstElementChild(); p_child != NULL; p_child = p_child->getNextElementSibling()) {
+		if(is_tt_element(p_child, "head") == true) ParseHead(p_child);
+		else if(is_tt_element(p_child, "body") == true) p_body = p_child;
+	}
+	if(p_body) {
+		Context root_context;
+		Context body_context;
+		if(ResolveTiming(p_body, root_context, 0, body_context) == true) {
+			Inherit(p_body, root_context, body_context);
+			body_context.backgroundColor = Qt::transparent;
+			ParseContainer(p_body, body_context);
+		}
+	}
+	BuildCues(rCues);
+	rRootExtent = mRootExtent.toSize();
+	return Error();
+}
+
+void TtmlParser::ParseParameters(xercesc::DOMElement *pRoot) {
+
+	const QString frame_rate = attribute(pRoot, "frameRate", XML_NAMESPACE_TTML_PARAMETER);
+	if(frame_rate.isEmpty() == false && frame_rate.toDouble() > 0) mFrameRate = frame_rate.toDouble();
+	const QStringList multiplier = split_tokens(attribute(pRoot, "frameRateMultiplier", XML_NAMESPACE_TTML_PARAMETER));
+	if(multiplier.size() == 2 && multiplier.at(0).toDouble() > 0 && multiplier.at(1).toDouble() > 0) mFrameRate *= multiplier.at(0).toDouble() / multiplier.at(1).toDouble();
+	const QString sub_frame_rate = attribute(pRoot, "subFrameRate", XML_NAMESPACE_TTML_PARAMETER);
+	if(sub_frame_rate.toDouble() > 0) mSubFrameRate = sub_frame_rate.toDouble();
+	const QString tick_rate = attribute(pRoot, "tickRate", XML_NAMESPACE_TTML_PARAMETER);
+	if(tick_rate.toDouble() > 0) mTickRate = tick_rate.toDouble();
+	else if(frame_rate.isEmpty() == false) mTickRate = mFrameRate * mSubFrameRate;
+	const QStringList cell_resolution = split_tokens(attribute(pRoot, "cellResolution", XML_NAMESPACE_TTML_PARAMETER));
+	if(cell_resolution.size() == 2 && cell_resolution.at(0).toInt() > 0 && cell_resolution.at(1).toInt() > 0) {
+		mCellColumns = cell_resolution.at(0).toInt();
+		mCellRows = cell_resolution.at(1).toInt();
+	}
+	const QStringList extent = split_tokens(attribute(pRoot, "extent", XML_NAMESPACE_TTML_STYLING));
+	qreal width = 0, height = 0;
+	QString width_unit, height_unit;
+	if(extent.size() == 2 && parse_length(extent.at(0), width, width_unit) == true && parse_length(extent.at(1), height, height_unit) == true
+		&& width_unit == "px" && height_unit == "px" && width > 0 && height > 0) mRootExtent = QSizeF(width, height);
+}
+
+void TtmlParser::ParseHead(xercesc::DOMElement *pHead) {
+
+	for(xercesc::DOMElement *p_child = pHead->getFirstElementChild(); p_child != NULL; p_child = p_child->getNextElementSibling()) {
+		if(is_tt_element(p_child, "styling") == true) {
+			for(xercesc::DOMElement *p_style = p_child->getFirstElementChild(); p_style != NULL; p_style = p_style->getNextElementSibling()) {
+				const QString id = attribute(p_style, "id", XML_NAMESPACE_XML);
+				if(is_tt_element(p_style, "style") == true && id.isEmpty() == false) mStyleElements.insert(id, p_style);
+			}
+		}
+	}
+	// smpte:image elements may appear in any metadata element of the head.
+	xercesc::DOMNodeList *p_images = pHead->getElementsByTagNameNS(to_xml(XML_NAMESPACE_SMPTE_TT), to_xml("image"));
+	for(XMLSize_t i = 0; i < p_images->getLength(); i++) {
+		xercesc::DOMElement *p_image = static_cast<xercesc::DOMElement*>(p_images->item(i));
+		const QString id = attribute(p_image, "id", XML_NAMESPACE_XML);
+		if(id.isEmpty() == false) mImages.insert(id, QByteArray::fromBase64(to_qstring(p_image->getTextContent()).toLatin1()));
+	}
+	for(xercesc::DOMElement *p_child = pHead->getFirstElementChild(); p_child != NULL; p_child = p_child->getNextElementSibling()) {
+		if(is_tt_element(p_child, "layout") == false) continue;
+		for(xercesc::DOMElement *p_region = p_child->getFirstElementChild(); p_region != NULL; p_region = p_region->getNextElementSibling()) {
+			const QString id = attribute(p_region, "id", XML_NAMESPACE_XML);
+			if(is_tt_element(p_region, "region") == false || id.isEmpty() == true) continue;
+			Region region;
+			region.style = SpecifiedStyle(p_region);
+			const QStringList origin = split_tokens(region.style.value("origin"));
+			qreal left = 0, top = 0;
+			if(origin.size() == 2 && ToWidth(origin.at(0), left) == true && ToHeight(origin.at(1), top) == true) region.rect.moveTopLeft(QPointF(left, top));
+			const QStringList extent = split_tokens(region.style.value("extent"));
+			qreal width = 1 - region.rect.left(), height = 1 - region.rect.top();
+			if(extent.size() == 2) {
+				ToWidth(extent.at(0), width);
+				ToHeight(extent.at(1), height);
+			}
+			region.rect.setSize(QSizeF(width, height));
+			region.displayAlign = parse_display_align(region.style.value("displayAlign"));
+			region.backgroundColor = parse_color(region.style.value("backgroundColor"), Qt::transparent);
+			if(region.style.contains("fontSize") == true) region.fontSize = ResolveFontSize(region.style.value("fontSize"), 1. / mCellRows);
+			mRegions.insert(id, region);
+		}
+	}
+}
+
+StyleSet TtmlParser::ResolveStyle(const QString &rId, int depth) {
+
+	if(mStyles.contains(rId) == true) return mStyles.value(rId);
+	xercesc::DOMElement *p_style = mStyleElements.value(rId, NULL);
+	if(p_style == NULL || depth > 16) return StyleSet(); // Unknown or circular reference
+	StyleSet style = ReferencedStyle(p_style, depth + 1);
+	const StyleSet own_style = SpecifiedStyle(p_style);
+	for(StyleSet::const_iterator i = own_style.constBegin(); i != own_style.constEnd(); ++i) style.insert(i.key(), i.value());
+	mStyles.insert(rId, style);
+	return style;
+}
+
+StyleSet TtmlParser::ReferencedStyle(xercesc::DOMElement *pElement, int depth) {
+
+	StyleSet style;
+	const QStringList references = split_tokens(attribute(pElement, "style"));
+	for(int i = 0; i < references.size(); i++) {
+		const StyleSet referenced_style = ResolveStyle(references.at(i), depth);
+		for(StyleSet::const_iterator j = referenced_style.constBegin(); j != referenced_style.constEnd(); ++j) style.insert(j.key(), j.value());
+	}
+	return style;
+}
+
+StyleSet TtmlParser::SpecifiedStyle(xercesc::DOMElement *pElement) {
+
+	// Referential styles, nested styles (regions), inline styles. Later ones win.
+	StyleSet style = (is_tt_element(pElement, "style") == true ? StyleSet() : ReferencedStyle(pElement, 0));
+	for(xercesc::DOMElement *p_child = pElement->getFirstElementChild(); p_child != NULL; p_child = p_child->getNextElementSibling()) {
+		if(is_tt_element(pElement, "region") == false || is_tt_element(p_child, "style") == false) continue;
+		const StyleSet nested_style = SpecifiedStyle(p_child);
+		StyleSet chained_style = ReferencedStyle(p_child, 0);
+		for(StyleSet::const_iterator i = nested_style.constBegin(); i != nested_style.constEnd(); ++i) chained_style.insert(i.key(), i.value());
+		for(StyleSet::const_iterator i = chained_style.constBegin(); i != chained_style.constEnd(); ++i) style.insert(i.key(), i.value());
+	}
+	xercesc::DOMNamedNodeMap *p_attributes = pElement->getAttributes();
+	for(XMLSize_t i = 0; p_attributes && i < p_attributes->getLength(); i++) {
+		xercesc::DOMNode *p_attribute = p_attributes->item(i);
+		if(to_qstring(p_attribute->getNamespaceURI()) == XML_NAMESPACE_TTML_STYLING) style.insert(local_name(p_attribute), to_qstring(p_attribute->getNodeValue()).trimmed());
+	}
+	return style;
+}
+
+bool TtmlParser::ResolveTiming(xercesc::DOMElement *pElement, const Context &rParent, qint64 syncBase, Context &rChild) const {
+
+	qint64 offset = 0;
+	rChild.begin = add_time(syncBase, ParseTime(attribute(pElement, "begin"), offset) ? offset : 0);
+	rChild.end = TimedTextDocument::Indefinite;
+	if(ParseTime(attribute(pElement, "end"), offset) == true) rChild.end = add_time(syncBase, offset);
+	if(ParseTime(attribute(pElement, "dur"), offset) == true) rChild.end = qMin(rChild.end, add_time(rChild.begin, offset));
+	rChild.end = qMin(rChild.end, rParent.end);
+	return rChild.begin < rChild.end;
+}
+
+void TtmlParser::Inherit(xercesc::DOMElement *pElement, const Context &rParent, Context &rChild) {
+
+	rChild.style = rParent.style;
+	rChild.fontSize = rParent.fontSize;
+	rChild.backgroundColor = rParent.backgroundColor;
+	rChild.region = rParent.region;
+	rChild.preserveSpace = rParent.preserveSpace;
+	const StyleSet style = SpecifiedStyle(pElement);
+	for(StyleSet::const_iterator i = style.constBegin(); i != style.constEnd(); ++i) {
+		if(is_inherited(i.key()) == true) rChild.style.insert(i.key(), i.value());
+	}
+	if(style.contains("fontSize") == true) rChild.fontSize = ResolveFontSize(style.value("fontSize"), rParent.fontSize > 0 ? rParent.fontSize : 1. / mCellRows);
+	if(style.contains("backgroundColor") == true) rChild.backgroundColor = parse_color(style.value("backgroundColor"), Qt::transparent);
+	const QString region = attribute(pElement, "region");
+	if(region.isEmpty() == false) rChild.region = region;
+	const QString space = attribute(pElement, "space", XML_NAMESPACE_XML);
+	if(space.isEmpty() == false) rChild.preserveSpace = (space == "preserve");
+}
+
+void TtmlParser::ParseContainer(xercesc::DOMElement *pElement, const Context &rContext) {
+
+	const bool sequential = (attribute(pElement, "timeContainer") == "seq");
+	qint64 sync_base = rContext.begin;
+	for(xercesc::DOMElement *p_child = pElement->getFirstElementChild(); p_child != NULL; p_child = p_child->getNextElementSibling()) {
+		const bool is_div = is_tt_element(p_child, "div");
+		if(is_div == false && is_tt_element(p_child, "p") == false) continue;
+		Context context;
+		if(ResolveTiming(p_child, rContext, sync_base, context) == true) {
+			Inherit(p_child, rContext, context);
+			if(is_div == true) {
+				context.backgroundColor = Qt::transparent;
+				const QString image = attribute(p_child, "backgroundImage", XML_NAMESPACE_SMPTE_TT);
+				if(image.isEmpty() == false) AddImage(image, context);
+				else ParseContainer(p_child, context);
+			}
+			else ParseParagraph(p_child, context);
+		}
+		if(sequential == true) sync_base = context.end;
+	}
+}
+
+void TtmlParser::ParseParagraph(xercesc::DOMElement *pElement, const Context &rContext) {
+
+	QList<Run> runs;
+	CollectRuns(pElement, rContext, runs);
+	if(runs.isEmpty() == true) return;
+	QVector<qint64> boundaries;
+	boundaries << rContext.begin << rContext.end;
+	for(int i = 0; i < runs.size(); i++) boundaries << runs.at(i).context.begin << runs.at(i).context.end;
+	std::sort(boundaries.begin(), boundaries.end());
+	boundaries.erase(std::unique(boundaries.begin(), boundaries.end()), boundaries.end());
+
+	const Region &r_region = GetRegion(rContext.region);
+	const Qt::Alignment text_align = parse_text_align(rContext.style.value("textAlign", r_region.style.value("textAlign")));
+	for(int i = 0; i + 1 < boundaries.size(); i++) {
+		Segment segment;
+		segment.begin = boundaries.at(i);
+		segment.end = boundaries.at(i + 1);
+		segment.order = mOrder;
+		segment.paragraph.textAlign = text_align;
+		for(int j = 0; j < runs.size(); j++) {
+			const Run &r_run = runs.at(j);
+			if(r_run.context.begin <= segment.begin && r_run.context.end >= segment.end) segment.paragraph.spans << CreateSpan(r_run, r_region);
+		}
+		if(rContext.preserveSpace == false) collapse_spaces(segment.paragraph.spans);
+		if(has_visible_text(segment.paragraph.spans) == true) mSegments[rContext.region] << segment;
+	}
+	mOrder++;
+}
+
+void TtmlParser::CollectRuns(xercesc::DOMElement *pElement, const Context &rContext, QList<Run> &rRuns) {
+
+	const bool sequential = (attribute(pElement, "timeContainer") == "seq");
+	qint64 sync_base = rContext.begin;
+	for(xercesc::DOMNode *p_node = pElement->getFirstChild(); p_node != NULL; p_node = p_node->getNextSibling()) {
+		if(p_node->getNodeType() == xercesc::DOMNode::TEXT_NODE || p_node->getNodeType() == xercesc::DOMNode::CDATA_SECTION_NODE) {
+			Run run;
+			run.text = to_qstring(p_node->getNodeValue());
+			if(rContext.preserveSpace == true) run.text.replace('\n', QChar::LineSeparator);
+			else run.text.replace(QRegularExpression("[ \\t\\r\\n]+"), " ");
+			run.context = rContext;
+			rRuns << run;
+		}
+		else if(is_tt_element(p_node, "br") == true) {
+			Run run;
+			run.text = QChar::LineSeparator;
+			run.context = rContext;
+			rRuns << run;
+		}
+		else if(is_tt_element(p_node, "span") == true) {
+			xercesc::DOMElement *p_span = static_cast<xercesc::DOMElement*>(p_node);
+			Context context;
+			if(ResolveTiming(p_span, rContext, sync_base, context) == true) {
+				Inherit(p_span, rContext, context);
+				CollectRuns(p_span, context, rRuns);
+			}
+			if(sequential == true) sync_base = context.end;
+		}
+	}
+}
+
+void TtmlParser::AddImage(const QString &rReference, const Context &rContext) {
+
+	const QByteArray image = ResolveImage(rReference);
+	if(image.isEmpty() == true) {
+		qWarning() << "Couldn't resolve timed text image" << rReference;
+		return;
+	}
+	const Region &r_region = GetRegion(rContext.region);
+	TimedTextCue cue;
+	cue.begin = rContext.begin;
+	cue.end = rContext.end;
+	cue.region = r_region.rect;
+	cue.displayAlign = r_region.displayAlign;
+	cue.backgroundColor = r_region.backgroundColor;
+	cue.image = image;
+	mImageCues << cue;
+}
+
+QByteArray TtmlParser::ResolveImage(const QString &rReference) const {
+
+	if(rReference.startsWith('#') == true) return mImages.value(rReference.mid(1));
+	if(mResources.contains(rReference) == true) return mResources.value(rReference);
+	const QUuid id(rReference.split(':').last());
+	if(id.isNull() == false) return mResources.value(QString("urn:uuid:").append(strip_uuid(id)));
+	if(mBaseDir.isEmpty() == false) {
+		QFile file(QDir(mBaseDir).absoluteFilePath(rReference));
+		if(file.open(QIODevice::ReadOnly) == true) return file.readAll();
+	}
+	return QByteArray();
+}
+
+TimedTextSpan TtmlParser::CreateSpan(const Run &rRun, const Region &rRegion) const {
+
+	const StyleSet &r_style = rRun.context.style;
+	TimedTextSpan span;
+	span.text = rRun.text;
+	span.fontFamily = r_style.value("fontFamily", rRegion.style.value("fontFamily")).split(',').first().trimmed().remove('"').remove('\'');
+	if(rRun.context.fontSize > 0) span.fontSize = rRun.context.fontSize;
+	else if(rRegion.fontSize > 0) span.fontSize = rRegion.fontSize;
+	else span.fontSize = 1. / mCellRows;
+	span.bold = (r_style.value("fontWeight", rRegion.style.value("fontWeight")) == "bold");
+	const QString font_style = r_style.value("fontStyle", rRegion.style.value("fontStyle"));
+	span.italic = (font_style == "italic" || font_style == "oblique");
+	const QString text_decoration = r_style.value("textDecoration", rRegion.style.value("textDecoration"));
+	span.underline = text_decoration.contains(QRegularExpression("(^|\\s)underline"));
+	span.color = parse_color(r_style.value("color", rRegion.style.value("color")), Qt::white);
+	span.backgroundColor = rRun.context.backgroundColor;
+	// textOutline: none | [color] thickness [blur]
+	QStringList outline = split_tokens(r_style.value("textOutline", rRegion.style.value("textOutline")));
+	if(outline.isEmpty() == false && outline.first() != "none") {
+		qreal value = 0;
+		QString unit;
+		span.outlineColor = span.color;
+		if(parse_length(outline.first(), value, unit) == false) span.outlineColor = parse_color(outline.takeFirst(), span.color);
+		if(outline.isEmpty() == false) span.outlineWidth = ResolveThickness(outline.first(), span.fontSize);
+	}
+	if(r_style.value("visibility", rRegion.style.value("visibility")) == "hidden") {
+		span.color = Qt::transparent;
+		span.backgroundColor = Qt::transparent;
+		span.outlineColor = Qt::transparent;
+	}
+	return span;
+}
+
+const Region& TtmlParser::GetRegion(const QString &rId) const {
+
+	QHash<QString, Region>::const_iterator i = mRegions.constFind(rId);
+	// Content which isn't flowed into a known region is shown in the default region (the root container).
+	return (i != mRegions.constEnd() ? i.value() : mDefaultRegion);
+}
+
+void TtmlParser::BuildCues(QVector<TimedTextCue> &rCues) const {
+
+	rCues.clear();
+	for(QHash<QString, QList<Segment> >::const_iterator i = mSegments.constBegin(); i != mSegments.constEnd(); ++i) {
+		const Region &r_region = GetRegion(i.key());
+		QList<Segment> segments = i.value();
+		std::stable_sort(segments.begin(), segments.end(), segment_begin_less);
+		QVector<qint64> boundaries;
+		for(int j = 0; j < segments.size(); j++) boundaries << segments.at(j).begin << segments.at(j).end;
+		std::sort(boundaries.begin(), boundaries.end());
+		boundaries.erase(std::unique(boundaries.begin(), boundaries.end()), boundaries.end());
+		// Sweep over the boundaries. Every interval between two boundaries is a cue if any segment is active.
+		QList<const Segment*> active;
+		int next = 0;
+		for(int j = 0; j + 1 < boundaries.size(); j++) {
+			const qint64 begin = boundaries.at(j);
+			for(int k = active.size() - 1; k >= 0; k--) {
+				if(active.at(k)->end <= begin) active.removeAt(k);
+			}
+			for(; next < segments.size() && segments.at(next).begin <= begin; next++) active << &segments.at(next);
+			if(active.isEmpty() == true) continue;
+			std::sort(active.begin(), active.end(), segment_order_less);
+			TimedTextCue cue;
+			cue.begin = begin;
+			cue.end = boundaries.at(j + 1);
+			cue.region = r_region.rect;
+			cue.displayAlign = r_region.displayAlign;
+			cue.backgroundColor = r_region.backgroundColor;
+			for(int k = 0; k < active.size(); k++) cue.paragraphs << active.at(k)->paragraph;
+			rCues << cue;
+		}
+	}
+	for(int i = 0; i < mImageCues.size(); i++) rCues << mImageCues.at(i);
+}
+
+bool TtmlParser::ParseTime(const QString &rText, qint64 &rTime) const {
+
+	// Clock time: hh:mm:ss(.fraction) or hh:mm:ss:frames(.subframes). Offset time: count followed by a metric.
+	static const QRegularExpression clock_expression("^(\\d{2,}):(\\d{2}):(\\d{2})(?:(\\.\\d+)|:(\\d{2,})(?:\\.(\\d+))?)?$");
+	static const QRegularExpression offset_expression("^(\\d+(?:\\.\\d+)?)(h|ms|m|s|f|t)$");
+	if(rText.isEmpty() == true) return false;
+	double seconds = 0;
+	QRegularExpressionMatch match = clock_expression.match(rText);
+	if(match.hasMatch() == true) {
+		seconds = match.captured(1).toDouble() * 3600 + match.captured(2).toDouble() * 60 + match.captured(3).toDouble();
+		if(match.capturedLength(4) > 0) seconds += match.captured(4).toDouble();
+		if(match.capturedLength(5) > 0) seconds += (match.captured(5).toDouble() + match.captured(6).toDouble() / mSubFrameRate) / mFrameRate;
+	}
+	else {
+		match = offset_expression.match(rText);
+		if(match.hasMatch() == false) return false;
+		const double count = match.captured(1).toDouble();
+		const QString metric = match.captured(2);
+		if(metric == "h") seconds = count * 3600;
+		else if(metric == "m") seconds = count * 60;
+		else if(metric == "s") seconds = count;
+		else if(metric == "ms") seconds = count / 1000;
+		else if(metric == "f") seconds = count / mFrameRate;
+		else seconds = count / mTickRate;
+	}
+	rTime = qRound64(seconds * 1000);
+	return true;
+}
+
+bool TtmlParser::ToWidth(const QString &rText, qreal &rWidth) const {
+
+	qreal value = 0;
+	QString unit;
+	if(parse_length(rText, value, unit) == false) return false;
+	if(unit == "px") rWidth = value / GetRootWidth();
+	else if(unit == "c") rWidth = value / mCellColumns;
+	else if(unit == "rh") rWidth = value / 100 * GetRootHeight() / GetRootWidth();
+	else if(unit == "em") return false;
+	else rWidth = value / 100; // % and rw
+	return true;
+}
+
+bool TtmlParser::ToHeight(const QString &rText, qreal &rHeight) const {
+
+	qreal value = 0;
+	QString unit;
+	if(parse_length(rText, value, unit) == false) return false;
+	if(unit == "px") rHeight = value / GetRootHeight();
+	else if(unit == "c") rHeight = value / mCellRows;
+	else if(unit == "rw") rHeight = value / 100 * GetRootWidth() / GetRootHeight();
+	else if(unit == "em") return false;
+	else rHeight = value / 100; // % and rh
+	return true;
+}
+
+qreal TtmlParser::ResolveFontSize(const QString &rText, qreal parentFontSize) const {
+
+	// Anamorphic font sizes (two values) are rendered with the vertical size.
+	const QStringList values = split_tokens(rText);
+	qreal value = 0;
+	QString unit;
+	if(values.isEmpty() == true || parse_length(values.last(), value, unit) == false || value <= 0) return parentFontSize;
+	if(unit == "%") return parentFontSize * value / 100;
+	if(unit == "em") return parentFontSize * value;
+	qreal font_size = parentFontSize;
+	ToHeight(values.last(), font_size);
+	return font_size;
+}
+
+qreal TtmlParser::ResolveThickness(const QString &rText, qreal fontSize) const {
+
+	qreal value = 0;
+	QString unit;
+	if(parse_length(rText, value, unit) == false || value <= 0) return 0;
+	if(unit == "%") return fontSize * value / 100;
+	if(unit == "em") return fontSize * value;
+	qreal thickness = 0;
+	ToHeight(rText, thickness);
+	return thickness;
+}
+
+class LoadTask : public QRunnable {
+
+public:
+	LoadTask(const QString &rFilePath) : QRunnable(), mFilePath(rFilePath) {}
+	virtual ~LoadTask() {}
+	virtual void run() {
+
+		Error error;
+		TimedTextRenderCache::Instance().LoadDocument(mFilePath, error);
+		if(error.IsError() == true) qWarning() << "Couldn't load timed text document" << mFilePath << error;
+	}
+
+private:
+	Q_DISABLE_COPY(LoadTask);
+	const QString mFilePath;
+};
+
+class RenderTask : public QRunnable {
+
+public:
+	RenderTask(const QSharedPointer<const TimedTextDocument> &rDocument, int cue, const QSize &rFrameSize) : QRunnable(), mDocument(rDocument), mCue(cue), mFrameSize(rFrameSize) {}
+	virtual ~RenderTask() {}
+	virtual void run() { TimedTextRenderCache::Instance().GetCueImage(mDocument, mCue, mFrameSize); }
+
+private:
+	Q_DISABLE_COPY(RenderTask);
+	const QSharedPointer<const TimedTextDocument> mDocument;
+	const int mCue;
+	const QSize mFrameSize;
+};
+}
+
+TimedTextDocument::TimedTextDocument() :
+mKey(), mRootExtent(), mCues(), mMaxEnd() {
+
+}
+
+Error TimedTextDocument::Load(const QString &rFilePath) {
+
+	TRACE_SPAN_DETAIL("TimedTextDocument::Load", "xml", QFileInfo(rFilePath).fileName());
+	const QFileInfo file_info(rFilePath);
+	if(file_info.isFile() == false) return Error(Error::SourceFileOpenError, rFilePath);
+	Error error;
+	if(file_info.suffix().compare("mxf", Qt::CaseInsensitive) != 0) {
+		QFile file(file_info.absoluteFilePath());
+		if(file.open(QIODevice::ReadOnly) == false) return Error(Error::SourceFileOpenError, rFilePath);
+		error = Parse(file.readAll(), file_info.absoluteFilePath(), QHash<QString, QByteArray>(), file_info.absolutePath());
+	}
+	else {
+		AS_02::TimedText::MXFReader reader;
+		AS_02::TimedText::TimedTextDescriptor descriptor;
+		std::string xml_document;
+		ASDCP::Result_t result = reader.OpenRead(file_info.absoluteFilePath().toStdString());
+		if(ASDCP_SUCCESS(result)) result = reader.FillTimedTextDescriptor(descriptor);
+		if(ASDCP_SUCCESS(result)) result = reader.ReadTimedTextResource(xml_document);
+		if(ASDCP_FAILURE(result)) return Error(result);
+		// Images of the image profile are ancillary resources referenced by urn:uuid. Fonts aren't used.
+		QHash<QString, QByteArray> resources;
+		ASDCP::TimedText::FrameBuffer buffer;
+		buffer.Capacity(TIMED_TEXT_RESOURCE_CAPACITY);
+		for(AS_02::TimedText::ResourceList_t::const_iterator i = descriptor.ResourceList.begin(); i != descriptor.ResourceList.end(); ++i) {
+			if(i->Type != ASDCP::TimedText::MT_PNG) continue;
+			result = reader.ReadAncillaryResource(Kumu::UUID(i->ResourceID), buffer);
+			const QUuid id = QUuid::fromRfc4122(QByteArray((const char*)i->ResourceID, ASDCP::UUIDlen));
+			if(ASDCP_FAILURE(result)) qWarning() << "Couldn't read ancillary resource" << id << "of" << rFilePath << Error(result);
+			else resources.insert(QString("urn:uuid:").append(strip_uuid(id)), QByteArray((const char*)buffer.RoData(), buffer.Size()));
+		}
+		reader.Close();
+		error = Parse(QByteArray(xml_document.data(), (int)xml_document.size()), file_info.absoluteFilePath(), resources);
+	}
+	if(error.IsError() == false) mKey = QString("%1@%2:%3").arg(file_info.absoluteFilePath()).arg(file_info.size()).arg(file_info.lastModified().toMSecsSinceEpoch());
+	return error;
+}
+
+Error TimedTextDocument::Parse(const QByteArray &rDocument, const QString &rSystemId, const QHash<QString, QByteArray> &rResources /*= QHash<QString, QByteArray>()*/, const QString &rBaseDir /*= QString()*/) {
+
+	TRACE_SPAN_DETAIL("TimedTextDocument::Parse", "xml", QFileInfo(rSystemId).fileName());
+	Error error;
+	xsd::cxx::xml::dom::auto_ptr<xercesc::DOMDocument> document(XmlParserPool::Instance().Parse(rDocument, rSystemId, error));
+	if(error.IsError() == true) return error;
+	QVector<TimedTextCue> cues;
+	QSize root_extent;
+	try {
+		TtmlParser parser(rResources, rBaseDir);
+		error = parser.Parse(document.get(), cues, root_extent);
+	}
+	catch(...) {
+		error = Error(Error::XMLSchemeError, rSystemId);
+	}
+	if(error.IsError() == true) return error;
+
+	std::stable_sort(cues.begin(), cues.end(), cue_less);
+	mMaxEnd.resize(cues.size());
+	for(int i = 0; i < cues.size(); i++) {
+		cues[i].id = i;
+		mMaxEnd[i] = (i > 0 ? qMax(mMaxEnd.at(i - 1), cues.at(i).end) : cues.at(i).end);
+	}
+	mCues = cues;
+	mRootExtent = root_extent;
+	mKey = rSystemId;
+	return Error();
+}
+
+QList<int> TimedTextDocument::GetCues(qint64 begin, qint64 end) const {
+
+	QList<int> cues;
+	// The first cue which may end after begin and the first cue which begins at or after end.
+	const int first = std::upper_bound(mMaxEnd.constBegin(), mMaxEnd.constEnd(), begin) - mMaxEnd.constBegin();
+	TimedTextCue end_cue;
+	end_cue.begin = end;
+	const int last = std::lower_bound(mCues.constBegin(), mCues.constEnd(), end_cue, cue_less) - mCues.constBegin();
+	for(int i = first; i < last; i++) {
+		if(mCues.at(i).end > begin) cues << i;
+	}
+	return cues;
+}
+
+QRect TimedTextDocument::GetCueRect(const TimedTextCue &rCue, const QSize &rFrameSize) {
+
+	const QRectF rect(rCue.region.left() * rFrameSize.width(), rCue.region.top() * rFrameSize.height(), rCue.region.width() * rFrameSize.width(), rCue.region.height() * rFrameSize.height());
+	return rect.toAlignedRect().intersected(QRect(QPoint(0, 0), rFrameSize));
+}
+
+QImage TimedTextDocument::Render(const TimedTextCue &rCue, const QSize &rFrameSize) const {
+
+	TRACE_SPAN("TimedTextDocument::Render", "paint");
+	const QRect rect = GetCueRect(rCue, rFrameSize);
+	if(rect.isEmpty() == true) return QImage();
+	QImage image(rect.size(), QImage::Format_ARGB32_Premultiplied);
+	image.fill(Qt::transparent);
+	QPainter painter(&image);
+	painter.setRenderHints(QPainter::Antialiasing | QPainter::TextAntialiasing | QPainter::SmoothPixmapTransform);
+	if(rCue.backgroundColor.alpha() > 0) painter.fillRect(image.rect(), rCue.backgroundColor);
+
+	if(rCue.IsImage() == true) {
+		QImage source;
+		if(source.loadFromData(rCue.image) == false) return image;
+		// Images are authored for the root container.
+		QSizeF target_size(source.size());
+		if(mRootExtent.isValid() == true) target_size *= (qreal)rFrameSize.height() / mRootExtent.height();
+		else target_size.scale(rect.size(), Qt::KeepAspectRatio);
+		QRectF target(QPointF(0, 0), target_size);
+		if(rCue.displayAlign & Qt::AlignVCenter) target.moveTop((rect.height() - target_size.height()) / 2);
+		else if(rCue.displayAlign & Qt::AlignBottom) target.moveTop(rect.height() - target_size.height());
+		painter.drawImage(target, source);
+		return image;
+	}
+
+	const qreal frame_height = rFrameSize.height();
+	QList<QTextLayout*> layouts;
+	QList<QTextLayout*> outline_layouts;
+	qreal height = 0;
+	for(int i = 0; i < rCue.paragraphs.size(); i++) {
+		const TimedTextParagraph &r_paragraph = rCue.paragraphs.at(i);
+		QTextLayout *p_layout = create_layout(r_paragraph, frame_height, rect.width(), false);
+		p_layout->setPosition(QPointF(0, height));
+		height += p_layout->boundingRect().height();
+		layouts << p_layout;
+		bool outline = false;
+		for(int j = 0; j < r_paragraph.spans.size() && outline == false; j++) outline = (r_paragraph.spans.at(j).outlineWidth > 0);
+		if(outline == true) {
+			QTextLayout *p_outline_layout = create_layout(r_paragraph, frame_height, rect.width(), true);
+			p_outline_layout->setPosition(p_layout->position());
+			outline_layouts << p_outline_layout;
+		}
+	}
+	QPointF offset(0, 0);
+	if(rCue.displayAlign & Qt::AlignVCenter) offset.setY((rect.height() - height) / 2);
+	else if(rCue.displayAlign & Qt::AlignBottom) offset.setY(rect.height() - height);
+	// Outlines first, the text is drawn on top.
+	for(int i = 0; i < outline_layouts.size(); i++) outline_layouts.at(i)->draw(&painter, offset);
+	for(int i = 0; i < layouts.size(); i++) layouts.at(i)->draw(&painter, offset);
+	qDeleteAll(outline_layouts);
+	qDeleteAll(layouts);
+	return image;
+}
+
+TimedTextRenderCache& TimedTextRenderCache::Instance() {
+
+	static TimedTextRenderCache cache;
+	return cache;
+}
+
+TimedTextRenderCache::TimedTextRenderCache(int capacity /*= 128*/) :
+QObject(NULL), mMutex(), mDocumentLoaded(), mCueRendered(), mDocuments(), mLoading(), mQueued(), mImages(qMax(1, capacity) * 1024), mRendering(), mStatistics(), mThreadPool() {
+
+	mThreadPool.setMaxThreadCount(2);
+}
+
+TimedTextRenderCache::~TimedTextRenderCache() {
+
+	mThreadPool.clear();
+	mThreadPool.waitForDone();
+}
+
+QSharedPointer<const TimedTextDocument> TimedTextRenderCache::GetDocument(const QString &rFilePath) {
+
+	const QFileInfo file_info(rFilePath);
+	const QString file_path = file_info.absoluteFilePath();
+	{
+		QMutexLocker locker(&mMutex);
+		if(mQueued.contains(file_path) == true || mLoading.contains(file_path) == true) return QSharedPointer<const TimedTextDocument>();
+		QHash<QString, Document>::const_iterator i = mDocuments.constFind(file_path);
+		// Failed loads aren't repeated until the file changes.
+		if(i != mDocuments.constEnd() && i.value().size == file_info.size() && i.value().modified == file_info.lastModified().toMSecsSinceEpoch()) return i.value().document;
+		mQueued.insert(file_path);
+	}
+	mThreadPool.start(new LoadTask(file_path));
+	return QSharedPointer<const TimedTextDocument>();
+}
+
+QSharedPointer<const TimedTextDocument> TimedTextRenderCache::LoadDocument(const QString &rFilePath, Error &rError) {
+
+	const QFileInfo file_info(rFilePath);
+	const QString file_path = file_info.absoluteFilePath();
+	{
+		QMutexLocker locker(&mMutex);
+		while(mLoading.contains(file_path) == true) mDocumentLoaded.wait(&mMutex);
+		mQueued.remove(file_path);
+		QHash<QString, Document>::const_iterator i = mDocuments.constFind(file_path);
+		if(i != mDocuments.constEnd() && i.value().size == file_info.size() && i.value().modified == file_info.lastModified().toMSecsSinceEpoch()) {
+			rError = i.value().error;
+			return i.value().document;
+		}
+		mLoading.insert(file_path);
+	}
+	// Parse outside the lock. Other threads asking for this file wait for the result.
+	Document document;
+	document.size = file_info.size();
+	document.modified = file_info.lastModified().toMSecsSinceEpoch();
+	TimedTextDocument *p_document = new TimedTextDocument;
+	document.error = p_document->Load(file_path);
+	if(document.error.IsError() == false) document.document = QSharedPointer<const TimedTextDocument>(p_document);
+	else delete p_document;
+	{
+		QMutexLocker locker(&mMutex);
+		mDocuments.insert(file_path, document);
+		mLoading.remove(file_path);
+		mStatistics.documentLoads++;
+		mDocumentLoaded.wakeAll();
+	}
+	emit DocumentLoaded(file_path);
+	rError = document.error;
+	return document.document;
+}
+
+QImage TimedTextRenderCache::GetCueImage(const QSharedPointer<const TimedTextDocument> &rDocument, int cue, const QSize &rFrameSize) {
+
+	if(rDocument.isNull() == true || cue < 0 || cue >= rDocument->GetCueCount() || rFrameSize.isEmpty() == true) return QImage();
+	const TimedTextCueKey key(rDocument->GetKey(), cue, rFrameSize);
+	{
+		QMutexLocker locker(&mMutex);
+		while(mRendering.contains(key) == true) mCueRendered.wait(&mMutex);
+		QImage *p_image = mImages.object(key);
+		if(p_image) {
+			mStatistics.cacheHits++;
+			return *p_image;
+		}
+		mStatistics.cacheMisses++;
+		mRendering.insert(key);
+	}
+	QElapsedTimer timer;
+	timer.start();
+	const QImage image = rDocument->Render(rDocument->GetCue(cue), rFrameSize);
+	const qint64 render_time = timer.nsecsElapsed();
+	QMutexLocker locker(&mMutex);
+	// QImage is implicitly shared. The cache holds a reference.
+	mImages.insert(key, new QImage(image), qMax(1, image.byteCount() / 1024));
+	mRendering.remove(key);
+	mStatistics.renderedCues++;
+	mStatistics.renderTime += render_time;
+	mCueRendered.wakeAll();
+	return image;
+}
+
+void TimedTextRenderCache::Prefetch(const QSharedPointer<const TimedTextDocument> &rDocument, const QList<int> &rCues, const QSize &rFrameSize) {
+
+	if(rDocument.isNull() == true || rFrameSize.isEmpty() == true) return;
+	QList<int> missing_cues;
+	{
+		QMutexLocker locker(&mMutex);
+		for(int i = 0; i < rCues.size(); i++) {
+			const TimedTextCueKey key(rDocument->GetKey(), rCues.at(i), rFrameSize);
+			if(mImages.contains(key) == false && mRendering.contains(key) == false) missing_cues << rCues.at(i);
+		}
+	}
+	for(int i = 0; i < missing_cues.size(); i++) mThreadPool.start(new RenderTask(rDocument, missing_cues.at(i), rFrameSize));
+}
+
+void TimedTextRenderCache::SetCapacity(int capacity) {
+
+	QMutexLocker locker(&mMutex);
+	mImages.setMaxCost(qMax(1, capacity) * 1024);
+}
+
+int TimedTextRenderCache::GetCapacity() const {
+
+	QMutexLocker locker(&mMutex);
+	return mImages.maxCost() / 1024;
+}
+
+qint64 TimedTextRenderCache::GetSize() const {
+
+	QMutexLocker locker(&mMutex);
+	return (qint64)mImages.totalCost() * 1024;
+}
+
+void TimedTextRenderCache::Clear() {
+
+	QMutexLocker locker(&mMutex);
+	mDocuments.clear();
+	mImages.clear();
+}
+
+TimedTextRenderStatistics TimedTextRenderCache::GetStatistics() const {
+
+	QMutexLocker locker(&mMutex);
+	return mStatistics;
+}
@@ -0,0 +1,197 @@
+/* Copyright(C) 2016 Björn Stresing, Denis Manthey, Wolfgang Ruppel
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include "Error.h"
+#include <QObject>
+#include <QString>
+#include <QByteArray>
+#include <QList>
+#include <QVector>
+#include <QHash>
+#include <QSet>
+#include <QCache>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QThreadPool>
+#include <QSharedPointer>
+#include <QImage>
+#include <QColor>
+#include <QRectF>
+#include <QSize>
+
+
+//! A run of text with uniform style. Sizes are fractions of the root container height.
+struct TimedTextSpan {
+
+	TimedTextSpan() : text(), fontFamily(), fontSize(1. / 15), bold(false), italic(false), underline(false), color(Qt::white), backgroundColor(Qt::transparent), outlineColor(Qt::transparent), outlineWidth(0) {}
+	QString text; // Forced line breaks are QChar::LineSeparator.
+	QString fontFamily; // First family of tts:fontFamily. Generic family names are mapped when rendering.
+	qreal fontSize;
+	bool bold;
+	bool italic;
+	bool underline;
+	QColor color;
+	QColor backgroundColor;
+	QColor outlineColor;
+	qreal outlineWidth;
+};
+
+//! A p element during the interval of a cue.
+struct TimedTextParagraph {
+
+	TimedTextParagraph() : textAlign(Qt::AlignLeft), spans() {}
+	Qt::Alignment textAlign;
+	QList<TimedTextSpan> spans;
+};
+
+/*! \brief Content of a single region during an interval in which the content doesn't change.
+Text profile cues hold paragraphs, image profile cues the PNG of a div.
+*/
+struct TimedTextCue {
+
+	TimedTextCue() : id(-1), begin(0), end(0), region(0, 0, 1, 1), displayAlign(Qt::AlignTop), backgroundColor(Qt::transparent), paragraphs(), image() {}
+	bool IsImage() const { return image.isEmpty() == false; }
+
+	int id; // Index in the document. Cues are ordered by begin.
+	qint64 begin; // [ms]
+	qint64 end; // [ms], exclusive. TimedTextDocument::Indefinite if the document doesn't end the cue.
+	QRectF region; // Relative to the root container.
+	Qt::Alignment displayAlign;
+	QColor backgroundColor;
+	QList<TimedTextParagraph> paragraphs;
+	QByteArray image;
+};
+
+/*! \brief Time ordered cue index of an IMSC1 document (text and image profile).
+The document is parsed once. Styles (referential, chained, inline, inherited and region styles), regions and timing (par and seq time containers,
+clock and offset times, ttp:frameRate, ttp:frameRateMultiplier, ttp:subFrameRate, ttp:tickRate) are resolved into cues which are ordered by begin.
+A prefix maximum of the cue ends turns GetCues() into two binary searches.
+Not supported: Fonts embedded in the document, ruby, lineHeight, linePadding, multiRowAlign, writing modes other than lrtb and animation (set).
+Immutable after loading, may be shared between threads.
+*/
+class TimedTextDocument {
+
+public:
+	static const qint64 Indefinite;
+	TimedTextDocument();
+	~TimedTextDocument() {}
+	//! Loads a timed text track file (SMPTE ST 2067-2) or a TTML file. Images are read from the ancillary resources of the track file or relative to the TTML file.
+	Error Load(const QString &rFilePath);
+	/*! \brief Parses an in-memory TTML document.
+	rResources maps image references ("urn:uuid:..." or paths relative to the document) to image data. Unknown relative references are read from rBaseDir if it isn't empty.
+	*/
+	Error Parse(const QByteArray &rDocument, const QString &rSystemId, const QHash<QString, QByteArray> &rResources = QHash<QString, QByteArray>(), const QString &rBaseDir = QString());
+	//! Identifies the document in TimedTextRenderCache. Changes if the file is modified.
+	QString GetKey() const { return mKey; }
+	int GetCueCount() const { return mCues.size(); }
+	const TimedTextCue& GetCue(int index) const { return mCues.at(index); }
+	//! Indices of the cues active at time [ms].
+	QList<int> GetCuesAt(qint64 time) const { return GetCues(time, time + 1); }
+	//! Indices of the cues intersecting [begin, end) [ms] ordered by begin.
+	QList<int> GetCues(qint64 begin, qint64 end) const;
+	//! Extent of the root container in pixels (tts:extent). Invalid if the document doesn't specify it.
+	QSize GetRootExtent() const { return mRootExtent; }
+	//! Pixel rectangle of the cue region in a frame of size rFrameSize.
+	static QRect GetCueRect(const TimedTextCue &rCue, const QSize &rFrameSize);
+	//! Renders the region of rCue for a frame of size rFrameSize. The image has the size of GetCueRect(). Thread safe.
+	QImage Render(const TimedTextCue &rCue, const QSize &rFrameSize) const;
+
+private:
+	Q_DISABLE_COPY(TimedTextDocument);
+	QString mKey;
+	QSize mRootExtent;
+	QVector<TimedTextCue> mCues;
+	QVector<qint64> mMaxEnd; // mMaxEnd[i] is the maximum end of mCues[0..i].
+};
+
+//! Identifies a rendered cue in TimedTextRenderCache.
+struct TimedTextCueKey {
+
+	TimedTextCueKey(const QString &rDocument = QString(), int cue = -1, const QSize &rFrameSize = QSize()) : document(rDocument), cue(cue), frameSize(rFrameSize) {}
+	bool operator==(const TimedTextCueKey &rOther) const { return cue == rOther.cue && frameSize == rOther.frameSize && document == rOther.document; }
+
+	QString document; // TimedTextDocument::GetKey()
+	int cue;
+	QSize frameSize;
+};
+
+inline uint qHash(const TimedTextCueKey &rKey, uint seed = 0) { return qHash(rKey.document, seed) ^ qHash(rKey.cue, seed) ^ (uint)(rKey.frameSize.width() << 16) ^ (uint)rKey.frameSize.height(); }
+
+struct TimedTextRenderStatistics {
+
+	TimedTextRenderStatistics() : documentLoads(0), renderedCues(0), renderTime(0), cacheHits(0), cacheMisses(0) {}
+
+	qint64 documentLoads;
+	qint64 renderedCues;
+	qint64 renderTime; // Nanoseconds summed over all threads.
+	qint64 cacheHits;
+	qint64 cacheMisses;
+};
+
+/*! \brief Process wide cache of parsed timed text documents and rendered cues. Thread safe.
+Every file is parsed once and reloaded only if its size or modification time changed. GetDocument() never blocks: A missing document is loaded
+on a worker thread and TimedTextRenderCache::DocumentLoaded() is emitted when it's done.
+Rendered cues are kept in a LRU cache keyed by document, cue and frame size, so consumers don't lay out a cue again while it's shown. The capacity is given in MiB.
+*/
+class TimedTextRenderCache : public QObject {
+
+	Q_OBJECT
+
+public:
+	static TimedTextRenderCache& Instance();
+	//! Returns the document if it's loaded and current. Otherwise loading is started and a null pointer is returned.
+	QSharedPointer<const TimedTextDocument> GetDocument(const QString &rFilePath);
+	//! Loads the document if necessary. Concurrent requests for the same file wait for a single parse.
+	QSharedPointer<const TimedTextDocument> LoadDocument(const QString &rFilePath, Error &rError);
+	//! Returns the rendered cue from the cache or renders it. Waits if the cue is being prefetched.
+	QImage GetCueImage(const QSharedPointer<const TimedTextDocument> &rDocument, int cue, const QSize &rFrameSize);
+	//! Renders the cues on a worker thread unless they are cached.
+	void Prefetch(const QSharedPointer<const TimedTextDocument> &rDocument, const QList<int> &rCues, const QSize &rFrameSize);
+	void SetCapacity(int capacity);
+	int GetCapacity() const;
+	//! Bytes of all rendered cues.
+	qint64 GetSize() const;
+	//! Forgets all documents and rendered cues.
+	void Clear();
+	TimedTextRenderStatistics GetStatistics() const;
+
+signals:
+	//! Emitted (from any thread) when loading rFilePath finished, also if it failed.
+	void DocumentLoaded(const QString &rFilePath);
+
+private:
+	struct Document {
+		Document() : document(), error(), size(-1), modified(-1) {}
+		QSharedPointer<const TimedTextDocument> document; // Null if loading failed.
+		Error error;
+		qint64 size;
+		qint64 modified; // [ms since epoch]
+	};
+	TimedTextRenderCache(int capacity = 128);
+	~TimedTextRenderCache();
+	Q_DISABLE_COPY(TimedTextRenderCache);
+
+	mutable QMutex mMutex;
+	QWaitCondition mDocumentLoaded;
+	QWaitCondition mCueRendered;
+	QHash<QString, Document> mDocuments; // Key: absolute file path.
+	QSet<QString> mLoading;
+	QSet<QString> mQueued; // Loads started by GetDocument().
+	QCache<TimedTextCueKey, QImage> mImages; // Cost in KiB.
+	QSet<TimedTextCueKey> mRendering;
+	TimedTextRenderStatistics mStatistics;
+	QThreadPool mThreadPool;
+};
@@ -0,0 +1,123 @@
+/* Copyright(C) 2016 Björn Stresing, Denis Manthey, Wolfgang Ruppel
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "TimedTextResourceResolver.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QCryptographicHash>
+#include <QMutexLocker>
+#include <cstring>
+
+
+TimedTextResourceCache& TimedTextResourceCache::Instance() {
+
+	static TimedTextResourceCache cache;
+	return cache;
+}
+
+TimedTextResourceCache::TimedTextResourceCache(int capacity /*= 64*/) :
+mMutex(), mCache(qMax(1, capacity) * 1024) {
+
+}
+
+void TimedTextResourceCache::SetCapacity(int capacity) {
+
+	QMutexLocker locker(&mMutex);
+	mCache.setMaxCost(qMax(1, capacity) * 1024);
+}
+
+int TimedTextResourceCache::GetCapacity() const {
+
+	QMutexLocker locker(&mMutex);
+	return mCache.maxCost() / 1024;
+}
+
+bool TimedTextResourceCache::Lookup(const QByteArray &rKey, QByteArray &rData) {
+
+	QMutexLocker locker(&mMutex);
+	QByteArray *p_data = mCache.object(rKey);
+	if(p_data == NULL) return false;
+	rData = *p_data;
+	return true;
+}
+
+void TimedTextResourceCache::Insert(const QByteArray &rKey, const QByteArray &rData) {
+
+	QMutexLocker locker(&mMutex);
+	// Resources larger than the capacity are rejected by QCache.
+	mCache.insert(rKey, new QByteArray(rData), qMax(1, rData.size() / 1024));
+}
+
+void TimedTextResourceCache::Clear() {
+
+	QMutexLocker locker(&mMutex);
+	mCache.clear();
+}
+
+qint64 TimedTextResourceCache::GetSize() const {
+
+	QMutexLocker locker(&mMutex);
+	return (qint64)mCache.totalCost() * 1024;
+}
+
+TimedTextResourceResolver::TimedTextResourceResolver() :
+ASDCP::TimedText::IResourceResolver(), mResolver(), mBaseDir(), mDirectorySignature() {
+
+}
+
+Error TimedTextResourceResolver::Open(const QString &rBaseDir) {
+
+	QDir base_dir(rBaseDir);
+	if(base_dir.exists() == false) return Error(Error::SourceFileOpenError, rBaseDir);
+	mBaseDir = base_dir.absolutePath();
+	ASDCP::Result_t result = mResolver.OpenRead(QDir::toNativeSeparators(mBaseDir).toStdString());
+	if(ASDCP_FAILURE(result)) return Error(result);
+
+	// The signature changes whenever a file in the base directory changes. Stale cache entries are never hit.
+	QCryptographicHash hasher(QCryptographicHash::Sha1);
+	hasher.addData(mBaseDir.toUtf8());
+	QFileInfoList entries = base_dir.entryInfoList(QDir::Files | QDir::NoDotAndDotDot, QDir::Name);
+	for(int i = 0; i < entries.size(); i++) {
+		const QFileInfo &r_entry = entries.at(i);
+		hasher.addData(r_entry.fileName().toUtf8());
+		hasher.addData(QByteArray::number(r_entry.size()));
+		hasher.addData(QByteArray::number(r_entry.lastModified().toMSecsSinceEpoch()));
+	}
+	mDirectorySignature = hasher.result();
+	return Error();
+}
+
+ASDCP::Result_t TimedTextResourceResolver::ResolveRID(const byte_t *pUuid, ASDCP::TimedText::FrameBuffer &rFrameBuffer) const {
+
+	if(pUuid == NULL || mBaseDir.isEmpty() == true) return ASDCP::RESULT_INIT;
+	QByteArray key(mDirectorySignature);
+	key.append((const char*)pUuid, ASDCP::UUIDlen);
+
+	QByteArray data;
+	if(TimedTextResourceCache::Instance().Lookup(key, data) == true) {
+		ASDCP::Result_t result = rFrameBuffer.Capacity(data.size());
+		if(ASDCP_FAILURE(result)) return result;
+		memcpy(rFrameBuffer.Data(), data.constData(), data.size());
+		rFrameBuffer.Size(data.size());
+		return ASDCP::RESULT_OK;
+	}
+	// Asset Id and MIME type are set by the parser.
+	ASDCP::Result_t result = mResolver.ResolveRID(pUuid, rFrameBuffer);
+	if(ASDCP_SUCCESS(result)) {
+		TimedTextResourceCache::Instance().Insert(key, QByteArray((const char*)rFrameBuffer.RoData(), rFrameBuffer.Size()));
+	}
+	return result;
+}
@@ -0,0 +1,68 @@
+/* Copyright(C) 2016 Björn Stresing, Denis Manthey, Wolfgang Ruppel
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include "Error.h"
+#include "AS_02.h"
+#include <QString>
+#include <QByteArray>
+#include <QCache>
+#include <QMutex>
+
+
+/*! \brief Thread safe LRU cache of ancillary timed text resources (fonts and images).
+Shared by all TimedTextResourceResolver instances. The capacity is given in MiB.
+*/
+class TimedTextResourceCache {
+
+public:
+	static TimedTextResourceCache& Instance();
+	void SetCapacity(int capacity);
+	int GetCapacity() const;
+	bool Lookup(const QByteArray &rKey, QByteArray &rData);
+	void Insert(const QByteArray &rKey, const QByteArray &rData);
+	void Clear();
+	//! Bytes of all cached resources.
+	qint64 GetSize() const;
+
+private:
+	TimedTextResourceCache(int capacity = 64);
+	~TimedTextResourceCache() {}
+	Q_DISABLE_COPY(TimedTextResourceCache);
+	mutable QMutex mMutex;
+	QCache<QByteArray, QByteArray> mCache; // Cost in KiB.
+};
+
+/*! \brief Resolves the ancillary resources of a TTML document relative to an explicit base directory.
+Replaces the default resolver of AS_02::TimedText::ST2052_TextParser which depends on the process wide working directory.
+The mapping of resource Ids to files is done by asdcplib (AS_02::TimedText::Type5UUIDFilenameResolver). Wrapped track files don't change.
+Resolved resources are kept in TimedTextResourceCache. The cache entries are invalidated if a file in the base directory is added, removed or modified.
+An instance must not be shared between threads.
+*/
+class TimedTextResourceResolver : public ASDCP::TimedText::IResourceResolver {
+
+public:
+	TimedTextResourceResolver();
+	virtual ~TimedTextResourceResolver() {}
+	//! Scans rBaseDir. Must be called before the resolver is passed to the parser.
+	Error Open(const QString &rBaseDir);
+	virtual ASDCP::Result_t ResolveRID(const byte_t *pUuid, ASDCP::TimedText::FrameBuffer &rFrameBuffer) const;
+
+private:
+	Q_DISABLE_COPY(TimedTextResourceResolver);
+	AS_02::TimedText::Type5UUIDFilenameResolver mResolver;
+	QString mBaseDir;
+	QByteArray mDirectorySignature;
+};
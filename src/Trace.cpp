@@ -0,0 +1,227 @@
+/* Copyright(C) 2016 Björn Stresing, Denis Manthey, Wolfgang Ruppel
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "Trace.h"
+#include "global.h"
+#include <QGlobalStatic>
+#include <QThreadStorage>
+#include <QSharedPointer>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QVector>
+#include <QFile>
+#include <QTextStream>
+#include <QSettings>
+#include <QProcessEnvironment>
+
+#define TRACE_FILE_NAME PROJECT_NAME"-trace.json"
+#define MAX_TRACE_EVENTS_PER_THREAD 2000000
+
+
+namespace
+{
+	struct TraceEvent {
+		const char *pName;
+		const char *pCategory;
+		char phase; // 'X': complete event, 'C': counter
+		qint64 timestamp; // [µs]
+		qint64 value; // duration [µs] or counter value
+		QString detail;
+	};
+
+	struct ThreadBuffer {
+		ThreadBuffer() : mutex(), events(), threadId(0), threadName(), dropped(0), generation(0) {}
+		// Only contended while exporting.
+		QMutex mutex;
+		QVector<TraceEvent> events;
+		int threadId;
+		QString threadName;
+		qint64 dropped;
+		int generation;
+	};
+
+	struct TraceRegistry {
+		TraceRegistry() : mutex(), buffers(), clock(), epoch(0), outputFile(), generation(0) { clock.start(); }
+		QMutex mutex;
+		QList<QSharedPointer<ThreadBuffer> > buffers;
+		// Started once and only read afterwards. Trace::Now() needs no synchronization.
+		QElapsedTimer clock;
+		qint64 epoch; // [µs] Trace::Now() when tracing was enabled. Guarded by mutex.
+		QString outputFile;
+		QAtomicInt generation;
+	};
+
+	Q_GLOBAL_STATIC(TraceRegistry, theRegistry)
+	// The registry shares ownership so events of finished threads survive until export.
+	QThreadStorage<QSharedPointer<ThreadBuffer> > thread_buffer;
+
+	ThreadBuffer* get_thread_buffer() {
+
+		if(thread_buffer.hasLocalData() == false) {
+			QSharedPointer<ThreadBuffer> p_buffer(new ThreadBuffer);
+			QThread *p_thread = QThread::currentThread();
+			TraceRegistry *p_registry = theRegistry();
+			QMutexLocker locker(&p_registry->mutex);
+			p_buffer->threadId = p_registry->buffers.size() + 1;
+			p_buffer->threadName = p_thread->objectName();
+			if(p_buffer->threadName.isEmpty()) {
+				if(qApp && p_thread == qApp->thread()) p_buffer->threadName = "GUI";
+				else p_buffer->threadName = QString("%1 %2").arg(p_thread->metaObject()->className()).arg(p_buffer->threadId);
+			}
+			p_buffer->generation = p_registry->generation;
+			p_registry->buffers.push_back(p_buffer);
+			thread_buffer.setLocalData(p_buffer);
+		}
+		return thread_buffer.localData().data();
+	}
+
+	void add_event(const TraceEvent &rEvent) {
+
+		ThreadBuffer *p_buffer = get_thread_buffer();
+		QMutexLocker locker(&p_buffer->mutex);
+		int generation = theRegistry()->generation;
+		if(p_buffer->generation != generation) {
+			p_buffer->events.clear();
+			p_buffer->dropped = 0;
+			p_buffer->generation = generation;
+		}
+		if(p_buffer->events.size() < MAX_TRACE_EVENTS_PER_THREAD) p_buffer->events.push_back(rEvent);
+		else p_buffer->dropped++;
+	}
+
+	QString escape_json(const QString &rString) {
+
+		QString ret;
+		ret.reserve(rString.size());
+		for(int i = 0; i < rString.size(); i++) {
+			const QChar c = rString.at(i);
+			if(c == '"') ret.append("\\\"");
+			else if(c == '\\') ret.append("\\\\");
+			else if(c.unicode() < 0x20) ret.append(QString("\\u%1").arg(c.unicode(), 4, 16, QChar('0')));
+			else ret.append(c);
+		}
+		return ret;
+	}
+}
+
+QAtomicInt Trace::mEnabled(0);
+
+void Trace::Init() {
+
+	QString output_file = QProcessEnvironment::systemEnvironment().value("IMFTOOL_TRACE");
+	if(output_file.isEmpty() == false) {
+		// Values like "1" or "on" just enable tracing.
+		if(output_file.endsWith(".json", Qt::CaseInsensitive) == false) output_file = GetDefaultOutputFile();
+		Enable(output_file);
+	}
+	else if(QSettings().value(SETTINGS_TRACE_ENABLED, false).toBool() == true) {
+		Enable(QSettings().value(SETTINGS_TRACE_FILE, GetDefaultOutputFile()).toString());
+	}
+}
+
+void Trace::Enable(const QString &rOutputFile) {
+
+	TraceRegistry *p_registry = theRegistry();
+	QMutexLocker locker(&p_registry->mutex);
+	p_registry->outputFile = rOutputFile;
+	p_registry->generation.fetchAndAddOrdered(1); // Discards the events of the last session lazily.
+	// Spans running across Enable() started before the epoch. Export() drops them.
+	p_registry->epoch = Now();
+	mEnabled.store(1);
+	qDebug() << "Tracing enabled:" << rOutputFile;
+}
+
+void Trace::Disable() {
+
+	mEnabled.store(0);
+}
+
+QString Trace::GetOutputFile() {
+
+	TraceRegistry *p_registry = theRegistry();
+	QMutexLocker locker(&p_registry->mutex);
+	return p_registry->outputFile;
+}
+
+QString Trace::GetDefaultOutputFile() {
+
+	return get_app_data_location().absoluteFilePath(TRACE_FILE_NAME);
+}
+
+qint64 Trace::Now() {
+
+	return theRegistry()->clock.nsecsElapsed() / 1000;
+}
+
+void Trace::AddSpan(const char *pName, const char *pCategory, qint64 start, qint64 duration, const QString &rDetail /*= QString()*/) {
+
+	TraceEvent event = {pName, pCategory, 'X', start, duration, rDetail};
+	add_event(event);
+}
+
+void Trace::AddCounter(const char *pName, qint64 value) {
+
+	TraceEvent event = {pName, "counter", 'C', Now(), value, QString()};
+	add_event(event);
+}
+
+bool Trace::Export(const QString &rFilePath /*= QString()*/) {
+
+	QString file_path = rFilePath.isEmpty() ? GetOutputFile() : rFilePath;
+	if(file_path.isEmpty()) file_path = GetDefaultOutputFile();
+	QFile file(file_path);
+	if(file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text) == false) {
+		qWarning() << "Couldn't write trace file:" << file_path;
+		return false;
+	}
+	TraceRegistry *p_registry = theRegistry();
+	QMutexLocker registry_locker(&p_registry->mutex);
+	const int generation = p_registry->generation;
+	const qint64 epoch = p_registry->epoch;
+	const qint64 pid = QCoreApplication::applicationPid();
+	QTextStream stream(&file);
+	stream.setCodec("UTF-8");
+	stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	bool first = true;
+	for(int i = 0; i < p_registry->buffers.size(); i++) {
+		ThreadBuffer *p_buffer = p_registry->buffers.at(i).data();
+		QMutexLocker buffer_locker(&p_buffer->mutex);
+		if(p_buffer->generation != generation || p_buffer->events.isEmpty()) continue;
+		if(first == false) stream << ",\n";
+		first = false;
+		stream << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":" << p_buffer->threadId
+			<< ",\"args\":{\"name\":\"" << escape_json(p_buffer->threadName) << "\"}}";
+		if(p_buffer->dropped > 0) qWarning() << "Trace buffer overflow:" << p_buffer->dropped << "events dropped in thread" << p_buffer->threadName;
+		for(int j = 0; j < p_buffer->events.size(); j++) {
+			const TraceEvent &r_event = p_buffer->events.at(j);
+			if(r_event.timestamp < epoch) continue;
+			stream << ",\n{\"name\":\"" << r_event.pName << "\",\"cat\":\"" << r_event.pCategory << "\",\"ph\":\"" << r_event.phase
+				<< "\",\"ts\":" << r_event.timestamp - epoch << ",\"pid\":" << pid << ",\"tid\":" << p_buffer->threadId;
+			if(r_event.phase == 'X') {
+				stream << ",\"dur\":" << r_event.value;
+				if(r_event.detail.isEmpty() == false) stream << ",\"args\":{\"detail\":\"" << escape_json(r_event.detail) << "\"}";
+			}
+			else {
+				stream << ",\"args\":{\"value\":" << r_event.value << "}";
+			}
+			stream << "}";
+		}
+	}
+	stream << "\n]}\n";
+	stream.flush();
+	file.close();
+	qDebug() << "Trace written:" << file_path;
+	return stream.status() == QTextStream::Ok;
+}
@@ -0,0 +1,73 @@
+/* Copyright(C) 2016 Björn Stresing, Denis Manthey, Wolfgang Ruppel
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <QAtomicInt>
+#include <QString>
+
+
+/*! \brief Lightweight span and counter tracing.
+Events are collected in per-thread buffers and exported to the Chrome trace event format (open with chrome://tracing or ui.perfetto.dev).
+Tracing is enabled if the environment variable IMFTOOL_TRACE is set (the value is used as output file) or if SETTINGS_TRACE_ENABLED is true.
+If tracing is disabled a span costs a single atomic load.
+*/
+class Trace {
+
+public:
+	static bool IsEnabled() { return mEnabled.load() != 0; }
+	//! Reads the environment variable IMFTOOL_TRACE and the settings. Call once after QApplication was created.
+	static void Init();
+	//! Starts collecting events. Previously collected events are discarded.
+	static void Enable(const QString &rOutputFile);
+	//! Stops collecting events. Collected events are kept until Trace::Enable() is called again.
+	static void Disable();
+	static QString GetOutputFile();
+	static QString GetDefaultOutputFile();
+	//! Writes all collected events to rFilePath or Trace::GetOutputFile() if empty. This method is thread safe.
+	static bool Export(const QString &rFilePath = QString());
+	//! Microseconds on a monotonic clock which is never reset. Exported timestamps are relative to the last Trace::Enable(). This method is thread safe.
+	static qint64 Now();
+	//! pName and pCategory must point to string literals.
+	static void AddSpan(const char *pName, const char *pCategory, qint64 start, qint64 duration, const QString &rDetail = QString());
+	static void AddCounter(const char *pName, qint64 value);
+
+private:
+	static QAtomicInt mEnabled;
+};
+
+
+//! Adds a complete event to the trace when the scope is left.
+class TraceSpan {
+
+public:
+	TraceSpan(const char *pName, const char *pCategory, const QString &rDetail = QString()) :
+		mpName(pName), mpCategory(pCategory), mDetail(rDetail), mStart(Trace::IsEnabled() ? Trace::Now() : -1) {}
+	~TraceSpan() { if(mStart >= 0) Trace::AddSpan(mpName, mpCategory, mStart, Trace::Now() - mStart, mDetail); }
+
+private:
+	Q_DISABLE_COPY(TraceSpan);
+
+	const char *mpName;
+	const char *mpCategory;
+	const QString mDetail;
+	const qint64 mStart;
+};
+
+#define TRACE_CONCAT_IMPL(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+//! The detail expression is only evaluated if tracing is enabled.
+#define TRACE_SPAN(name, category) TraceSpan TRACE_CONCAT(trace_span_, __LINE__)(name, category)
+#define TRACE_SPAN_DETAIL(name, category, detail) TraceSpan TRACE_CONCAT(trace_span_, __LINE__)(name, category, Trace::IsEnabled() ? QString(detail) : QString())
+#define TRACE_COUNTER(name, value) do { if(Trace::IsEnabled()) Trace::AddCounter(name, value); } while(0)
@@ -0,0 +1,476 @@
+/* Copyright(C) 2016 Björn Stresing, Denis Manthey, Wolfgang Ruppel
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "VideoDecoder.h"
+#include "global.h"
+#include "Trace.h"
+#include "MxfReaderPool.h"
+#include "AS_02.h"
+#include "Metadata.h"
+#include <openjpeg.h>
+#include <QThread>
+#include <QThreadPool>
+#include <QThreadStorage>
+#include <QElapsedTimer>
+#include <QSettings>
+#include <QVector>
+#include <cstring>
+
+// Requests up to this many frames apart continue playback (frames are skipped if decoding can't keep up). Larger steps are seeks.
+#define VIDEO_MAX_PLAYBACK_STEP 4
+// Initial size of the codestream buffer. Grows if a frame doesn't fit.
+#define VIDEO_FRAME_BUFFER_SIZE (4 * 1024 * 1024)
+#define VIDEO_FRAME_BUFFER_MAX_SIZE (128 * 1024 * 1024)
+
+namespace
+{
+	// Decoders of the VideoDecodePipeline threads. Deleted when the thread exits.
+	QThreadStorage<J2kFrameDecoder*> thread_decoders;
+
+	//! Codestream in memory read by OpenJPEG.
+	struct MemoryStream {
+		const OPJ_BYTE *pData;
+		OPJ_SIZE_T size;
+		OPJ_SIZE_T offset;
+	};
+
+	OPJ_SIZE_T read_memory(void *pBuffer, OPJ_SIZE_T bytes, void *pUserData) {
+
+		MemoryStream *p_stream = static_cast<MemoryStream*>(pUserData);
+		if(p_stream->offset >= p_stream->size) return (OPJ_SIZE_T)-1;
+		const OPJ_SIZE_T count = qMin(bytes, p_stream->size - p_stream->offset);
+		std::memcpy(pBuffer, p_stream->pData + p_stream->offset, count);
+		p_stream->offset += count;
+		return count;
+	}
+
+	OPJ_OFF_T skip_memory(OPJ_OFF_T bytes, void *pUserData) {
+
+		MemoryStream *p_stream = static_cast<MemoryStream*>(pUserData);
+		if(bytes < 0) bytes = qMax(bytes, -(OPJ_OFF_T)p_stream->offset);
+		else bytes = qMin(bytes, (OPJ_OFF_T)(p_stream->size - p_stream->offset));
+		p_stream->offset += bytes;
+		return bytes;
+	}
+
+	OPJ_BOOL seek_memory(OPJ_OFF_T position, void *pUserData) {
+
+		MemoryStream *p_stream = static_cast<MemoryStream*>(pUserData);
+		if(position < 0 || (OPJ_SIZE_T)position > p_stream->size) return OPJ_FALSE;
+		p_stream->offset = position;
+		return OPJ_TRUE;
+	}
+
+	void append_openjpeg_message(const char *pMessage, void *pUserData) {
+
+		QString *p_messages = static_cast<QString*>(pUserData);
+		if(p_messages->isEmpty() == false) p_messages->append(" ");
+		p_messages->append(QString(pMessage).trimmed());
+	}
+
+	//! Shifts a component sample to 8 bit unsigned.
+	inline int to_8_bit(OPJ_INT32 value, const opj_image_comp_t &rComponent) {
+
+		if(rComponent.sgnd) value += (1 << (rComponent.prec - 1));
+		return (rComponent.prec > 8 ? value >> (rComponent.prec - 8) : value << (8 - rComponent.prec));
+	}
+
+	inline int clamp_8_bit(int value) {
+
+		return (value < 0 ? 0 : (value > 255 ? 255 : value));
+	}
+
+	/*! Converts the decoded components to RGB32. YCbCr (CDCI) is converted using the Rec. ITU-R BT.709 matrix and video range.
+	Subsampled chroma components are upsampled by pixel repetition.
+	*/
+	bool convert_image(const opj_image_t *pImage, bool isYCbCr, QImage &rImage) {
+
+		if(pImage->numcomps < 1 || pImage->comps[0].data == NULL) return false;
+		const int width = pImage->comps[0].w;
+		const int height = pImage->comps[0].h;
+		if(width <= 0 || height <= 0) return false;
+		const bool is_color = (pImage->numcomps >= 3 && pImage->comps[1].data && pImage->comps[2].data);
+		QImage image(width, height, QImage::Format_RGB32);
+		if(image.isNull()) return false;
+		const opj_image_comp_t &r_c0 = pImage->comps[0];
+		if(is_color == false) {
+			for(int y = 0; y < height; y++) {
+				QRgb *p_line = reinterpret_cast<QRgb*>(image.scanLine(y));
+				const OPJ_INT32 *p_c0 = r_c0.data + y * r_c0.w;
+				for(int x = 0; x < width; x++) {
+					const int gray = clamp_8_bit(to_8_bit(p_c0[x], r_c0));
+					p_line[x] = qRgb(gray, gray, gray);
+				}
+			}
+			rImage = image;
+			return true;
+		}
+		const opj_image_comp_t &r_c1 = pImage->comps[1];
+		const opj_image_comp_t &r_c2 = pImage->comps[2];
+		// Column of the (subsampled) second and third component for every column of the first one.
+		QVector<int> column_c1(width);
+		QVector<int> column_c2(width);
+		for(int x = 0; x < width; x++) {
+			column_c1[x] = qMin((int)r_c1.w - 1, (int)((qint64)x * r_c1.w / width));
+			column_c2[x] = qMin((int)r_c2.w - 1, (int)((qint64)x * r_c2.w / width));
+		}
+		for(int y = 0; y < height; y++) {
+			QRgb *p_line = reinterpret_cast<QRgb*>(image.scanLine(y));
+			const OPJ_INT32 *p_c0 = r_c0.data + y * r_c0.w;
+			const OPJ_INT32 *p_c1 = r_c1.data + qMin((int)r_c1.h - 1, (int)((qint64)y * r_c1.h / height)) * r_c1.w;
+			const OPJ_INT32 *p_c2 = r_c2.data + qMin((int)r_c2.h - 1, (int)((qint64)y * r_c2.h / height)) * r_c2.w;
+			if(isYCbCr) {
+				for(int x = 0; x < width; x++) {
+					// Fixed point coefficients scaled by 1024.
+					const int luma = 1192 * (to_8_bit(p_c0[x], r_c0) - 16);
+					const int cb = to_8_bit(p_c1[column_c1[x]], r_c1) - 128;
+					const int cr = to_8_bit(p_c2[column_c2[x]], r_c2) - 128;
+					p_line[x] = qRgb(clamp_8_bit((luma + 1836 * cr) >> 10), clamp_8_bit((luma - 218 * cb - 546 * cr) >> 10), clamp_8_bit((luma + 2163 * cb) >> 10));
+				}
+			}
+			else {
+				for(int x = 0; x < width; x++) {
+					p_line[x] = qRgb(clamp_8_bit(to_8_bit(p_c0[x], r_c0)), clamp_8_bit(to_8_bit(p_c1[column_c1[x]], r_c1)), clamp_8_bit(to_8_bit(p_c2[column_c2[x]], r_c2)));
+				}
+			}
+		}
+		rImage = image;
+		return true;
+	}
+}
+
+class J2kFrameDecoder::Private {
+
+public:
+	Private() : table(), codestream(), reader(), buffer(), filePath(), isYCbCr(false), isOpen(false) {}
+	void Close() { if(isOpen && table.isNull()) reader.Close(); table.clear(); isOpen = false; filePath.clear(); }
+
+	// Frames are read through the MxfReaderPool. asdcplib is used if the pool can't index the file.
+	QSharedPointer<const MxfIndexTable> table;
+	QByteArray codestream;
+	AS_02::JP2K::MXFReader reader;
+	ASDCP::JP2K::FrameBuffer buffer;
+	QString filePath;
+	bool isYCbCr;
+	bool isOpen;
+};
+
+J2kFrameDecoder::J2kFrameDecoder(int threadCount /*= 1*/) :
+mpPrivate(new Private), mThreadCount(qMax(1, threadCount)) {
+
+}
+
+J2kFrameDecoder::~J2kFrameDecoder() {
+
+	Close();
+	delete mpPrivate;
+}
+
+void J2kFrameDecoder::Close() {
+
+	mpPrivate->Close();
+}
+
+Error J2kFrameDecoder::Open(const QString &rFilePath) {
+
+	Close();
+	QSharedPointer<const MxfIndexTable> table;
+	Error error = MxfReaderPool::Instance().GetIndexTable(rFilePath, table);
+	if(error.IsError() == false && table->GetElementCount() > 1 && table->GetPictureEncoding() != MxfIndexTable::UnknownEncoding) {
+		mpPrivate->table = table;
+		mpPrivate->isYCbCr = (table->GetPictureEncoding() == MxfIndexTable::Cdci);
+		mpPrivate->filePath = rFilePath;
+		mpPrivate->isOpen = true;
+		return Error();
+	}
+	ASDCP::Result_t result = mpPrivate->reader.OpenRead(rFilePath.toStdString());
+	if(ASDCP_FAILURE(result)) return Error(result);
+	ASDCP::MXF::CDCIEssenceDescriptor *p_cdci_descriptor = NULL;
+	result = mpPrivate->reader.OP1aHeader().GetMDObjectByType(ASDCP::DefaultCompositeDict().ul(ASDCP::MDD_CDCIEssenceDescriptor), reinterpret_cast<ASDCP::MXF::InterchangeObject**>(&p_cdci_descriptor));
+	mpPrivate->isYCbCr = (ASDCP_SUCCESS(result) && p_cdci_descriptor);
+	if(mpPrivate->buffer.Capacity() < VIDEO_FRAME_BUFFER_SIZE) mpPrivate->buffer.Capacity(VIDEO_FRAME_BUFFER_SIZE);
+	mpPrivate->filePath = rFilePath;
+	mpPrivate->isOpen = true;
+	return Error();
+}
+
+Error J2kFrameDecoder::Decode(const QString &rFilePath, qint64 frame, int reduction, QImage &rImage) {
+
+	TRACE_SPAN("J2kFrameDecoder::Decode", "video");
+	if(mpPrivate->isOpen == false || mpPrivate->filePath != rFilePath) {
+		Error error = Open(rFilePath);
+		if(error.IsError()) return error;
+	}
+	MemoryStream memory_stream = { NULL, 0, 0 };
+	if(mpPrivate->table) {
+		const MxfByteRange range = mpPrivate->table->GetElement(frame);
+		if(range.IsValid() == false) return Error(Error::UnknownDuration, QObject::tr("Frame %1 out of range: %2").arg(frame).arg(rFilePath));
+		Error error = MxfReaderPool::Instance().Read(rFilePath, range.offset, range.size, mpPrivate->codestream);
+		if(error.IsError()) return error;
+		memory_stream.pData = reinterpret_cast<const OPJ_BYTE*>(mpPrivate->codestream.constData());
+		memory_stream.size = mpPrivate->codestream.size();
+	}
+	else {
+		ASDCP::Result_t result = mpPrivate->reader.ReadFrame(frame, mpPrivate->buffer);
+		while(result == Kumu::RESULT_SMALLBUF && mpPrivate->buffer.Capacity() < VIDEO_FRAME_BUFFER_MAX_SIZE) {
+			mpPrivate->buffer.Capacity(mpPrivate->buffer.Capacity() * 2);
+			result = mpPrivate->reader.ReadFrame(frame, mpPrivate->buffer);
+		}
+		if(ASDCP_FAILURE(result)) return Error(result);
+		memory_stream.pData = mpPrivate->buffer.RoData();
+		memory_stream.size = mpPrivate->buffer.Size();
+	}
+
+	QString messages;
+	opj_codec_t *p_codec = opj_create_decompress(OPJ_CODEC_J2K);
+	opj_stream_t *p_stream = opj_stream_create(OPJ_J2K_STREAM_CHUNK_SIZE, OPJ_TRUE);
+	opj_image_t *p_image = NULL;
+	bool success = (p_codec && p_stream);
+	if(success) {
+		opj_set_error_handler(p_codec, append_openjpeg_message, &messages);
+		opj_dparameters_t parameters;
+		opj_set_default_decoder_parameters(&parameters);
+		success = opj_setup_decoder(p_codec, &parameters);
+	}
+#if OPJ_VERSION_MAJOR > 2 || (OPJ_VERSION_MAJOR == 2 && OPJ_VERSION_MINOR >= 2)
+	// Decodes the code blocks in parallel.
+	if(success && mThreadCount > 1) opj_codec_set_threads(p_codec, mThreadCount);
+#endif
+	if(success) {
+		opj_stream_set_read_function(p_stream, read_memory);
+		opj_stream_set_skip_function(p_stream, skip_memory);
+		opj_stream_set_seek_function(p_stream, seek_memory);
+		opj_stream_set_user_data(p_stream, &memory_stream, NULL);
+		opj_stream_set_user_data_length(p_stream, memory_stream.size);
+		success = opj_read_header(p_stream, p_codec, &p_image);
+	}
+	if(success) {
+		// We can't discard more resolution levels than the codestream has.
+		int levels = 0;
+		opj_codestream_info_v2_t *p_info = opj_get_cstr_info(p_codec);
+		if(p_info && p_info->m_default_tile_info.tccp_info) levels = p_info->m_default_tile_info.tccp_info[0].numresolutions - 1;
+		opj_destroy_cstr_info(&p_info);
+		success = opj_set_decoded_resolution_factor(p_codec, qBound(0, reduction, levels));
+	}
+	if(success) success = opj_decode(p_codec, p_stream, p_image) && opj_end_decompress(p_codec, p_stream);
+	if(success) success = convert_image(p_image, mpPrivate->isYCbCr, rImage);
+	if(p_image) opj_image_destroy(p_image);
+	if(p_stream) opj_stream_destroy(p_stream);
+	if(p_codec) opj_destroy_codec(p_codec);
+	if(success == false) return Error(Error::VideoDecoding, QObject::tr("Frame %1 of %2. %3").arg(frame).arg(rFilePath).arg(messages));
+	return Error();
+}
+
+VideoFrameCache::VideoFrameCache(int capacity /*= 512*/) :
+mMutex(), mCache(qMax(1, capacity) * 1024) {
+
+}
+
+void VideoFrameCache::SetCapacity(int capacity) {
+
+	QMutexLocker locker(&mMutex);
+	mCache.setMaxCost(qMax(1, capacity) * 1024);
+}
+
+int VideoFrameCache::GetCapacity() const {
+
+	QMutexLocker locker(&mMutex);
+	return mCache.maxCost() / 1024;
+}
+
+bool VideoFrameCache::Lookup(const VideoFrameKey &rKey, QImage &rImage) {
+
+	QMutexLocker locker(&mMutex);
+	QImage *p_image = mCache.object(rKey);
+	if(p_image == NULL) return false;
+	rImage = *p_image;
+	return true;
+}
+
+bool VideoFrameCache::Contains(const VideoFrameKey &rKey) const {
+
+	QMutexLocker locker(&mMutex);
+	return mCache.contains(rKey);
+}
+
+void VideoFrameCache::Insert(const VideoFrameKey &rKey, const QImage &rImage) {
+
+	QMutexLocker locker(&mMutex);
+	// QImage is implicitly shared. The cache holds a reference.
+	mCache.insert(rKey, new QImage(rImage), qMax(1, rImage.byteCount() / 1024));
+}
+
+void VideoFrameCache::Clear() {
+
+	QMutexLocker locker(&mMutex);
+	mCache.clear();
+}
+
+qint64 VideoFrameCache::GetSize() const {
+
+	QMutexLocker locker(&mMutex);
+	return (qint64)mCache.totalCost() * 1024;
+}
+
+VideoDecodePipeline::VideoDecodePipeline(QObject *pParent /*= NULL*/) :
+QObject(pParent), mpThreadPool(NULL), mCache(), mFilePath(), mDuration(0), mReduction(0), mPrefetchCount(8), mDecoderThreads(1), mLastRequest(-1), mPendingFrame(-1), mDirection(1),
+mScheduled(), mGeneration(0), mDecodedFrames(0), mDecodeTime(0), mCancelledFrames(0), mCacheHits(0), mCacheMisses(0) {
+
+	// Frames are decoded in parallel. Every frame decoder gets a share of the remaining cores.
+	const int ideal_thread_count = qMax(1, QThread::idealThreadCount());
+	mpThreadPool = new QThreadPool(this);
+	mpThreadPool->setMaxThreadCount(qMin(4, ideal_thread_count));
+	mDecoderThreads = qMax(1, ideal_thread_count / mpThreadPool->maxThreadCount());
+}
+
+VideoDecodePipeline::~VideoDecodePipeline() {
+
+	Cancel();
+	mpThreadPool->waitForDone();
+}
+
+void VideoDecodePipeline::LoadSettings() {
+
+	QSettings settings;
+	SetCacheCapacity(settings.value(SETTINGS_VIDEO_PREVIEW_CACHE_SIZE, 512).toInt());
+	SetPrefetchCount(settings.value(SETTINGS_VIDEO_PREVIEW_PREFETCH, 8).toInt());
+}
+
+void VideoDecodePipeline::SetTrackFile(const QString &rFilePath, qint64 duration) {
+
+	if(rFilePath == mFilePath && duration == mDuration) return;
+	Cancel();
+	mFilePath = rFilePath;
+	mDuration = duration;
+}
+
+void VideoDecodePipeline::SetReduction(int reduction) {
+
+	if(reduction == mReduction) return;
+	Cancel();
+	mReduction = qMax(0, reduction);
+}
+
+void VideoDecodePipeline::Request(qint64 frame) {
+
+	if(mFilePath.isEmpty() || frame < 0 || frame >= mDuration) return;
+	const qint64 step = frame - mLastRequest;
+	if(mLastRequest >= 0 && step != 0 && qAbs(step) <= VIDEO_MAX_PLAYBACK_STEP) mDirection = (step > 0 ? 1 : -1);
+	else if(step != 0) Cancel();
+	mLastRequest = frame;
+	QImage image;
+	if(mCache.Lookup(VideoFrameKey(mFilePath, frame, mReduction), image)) {
+		mCacheHits++;
+		mPendingFrame = -1;
+		emit FrameReady(frame, image);
+	}
+	else {
+		mCacheMisses++;
+		mPendingFrame = frame;
+		Schedule(frame, 1);
+	}
+	for(int i = 1; i <= mPrefetchCount; i++) {
+		const qint64 prefetch_frame = frame + i * mDirection;
+		if(prefetch_frame < 0 || prefetch_frame >= mDuration) break;
+		if(mCache.Contains(VideoFrameKey(mFilePath, prefetch_frame, mReduction)) == false) Schedule(prefetch_frame, 0);
+	}
+}
+
+bool VideoDecodePipeline::Lookup(qint64 frame, QImage &rImage) {
+
+	return mCache.Lookup(VideoFrameKey(mFilePath, frame, mReduction), rImage);
+}
+
+void VideoDecodePipeline::Cancel() {
+
+	// Queued tasks are deleted. Running tasks finish, their frames are cached but not reported.
+	mGeneration.fetchAndAddOrdered(1);
+	mpThreadPool->clear();
+	mCancelledFrames += mScheduled.size();
+	mScheduled.clear();
+	mPendingFrame = -1;
+	mLastRequest = -1;
+}
+
+void VideoDecodePipeline::WaitForDone() {
+
+	mpThreadPool->waitForDone();
+}
+
+VideoDecodeStatistics VideoDecodePipeline::GetStatistics() const {
+
+	VideoDecodeStatistics statistics;
+	statistics.decodedFrames = mDecodedFrames.loadAcquire();
+	statistics.decodeTime = mDecodeTime.loadAcquire();
+	statistics.cacheHits = mCacheHits;
+	statistics.cacheMisses = mCacheMisses;
+	statistics.cancelledFrames = mCancelledFrames;
+	return statistics;
+}
+
+void VideoDecodePipeline::Schedule(qint64 frame, int priority) {
+
+	if(mScheduled.contains(frame)) return;
+	mScheduled.insert(frame);
+	// Only prefetches may be dropped.
+	VideoDecodeTask *p_task = new VideoDecodeTask(this, mFilePath, frame, mReduction, mGeneration.loadAcquire(), priority == 0);
+	connect(p_task, SIGNAL(Decoded(const QString&, qint64, int, const QImage&, const QString&)), this, SLOT(rFrameDecoded(const QString&, qint64, int, const QImage&, const QString&)), Qt::QueuedConnection);
+	mpThreadPool->start(p_task, priority);
+}
+
+void VideoDecodePipeline::rFrameDecoded(const QString &rFilePath, qint64 frame, int reduction, const QImage &rImage, const QString &rErrorDescription) {
+
+	if(rFilePath != mFilePath || reduction != mReduction) return;
+	mScheduled.remove(frame);
+	if(frame != mPendingFrame) return;
+	if(rErrorDescription.isEmpty() == false) {
+		mPendingFrame = -1;
+		emit DecodeError(frame, rErrorDescription);
+	}
+	else if(rImage.isNull() == false) {
+		mPendingFrame = -1;
+		emit FrameReady(frame, rImage);
+	}
+}
+
+VideoDecodeTask::VideoDecodeTask(VideoDecodePipeline *pPipeline, const QString &rFilePath, qint64 frame, int reduction, int generation, bool cancelable) :
+QObject(NULL), QRunnable(), mpPipeline(pPipeline), mFilePath(rFilePath), mFrame(frame), mReduction(reduction), mGeneration(generation), mCancelable(cancelable) {
+
+	setAutoDelete(true);
+}
+
+void VideoDecodeTask::run() {
+
+	// A seek happened since the prefetch was scheduled.
+	if(mCancelable && mGeneration != mpPipeline->mGeneration.loadAcquire()) {
+		emit Decoded(mFilePath, mFrame, mReduction, QImage(), QString());
+		return;
+	}
+	if(thread_decoders.hasLocalData() == false) thread_decoders.setLocalData(new J2kFrameDecoder(mpPipeline->mDecoderThreads));
+	QImage image;
+	QString error_description;
+	QElapsedTimer timer;
+	timer.start();
+	Error error = thread_decoders.localData()->Decode(mFilePath, mFrame, mReduction, image);
+	mpPipeline->mDecodeTime.fetchAndAddRelaxed(timer.nsecsElapsed());
+	if(error.IsError()) {
+		error_description = QString("%1 %2").arg(error.GetErrorMsg()).arg(error.GetErrorDescription());
+	}
+	else {
+		mpPipeline->mDecodedFrames.fetchAndAddRelaxed(1);
+		mpPipeline->mCache.Insert(VideoFrameKey(mFilePath, mFrame, mReduction), image);
+	}
+	emit Decoded(mFilePath, mFrame, mReduction, image, error_description);
+}
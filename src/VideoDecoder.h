@@ -0,0 +1,187 @@
+/* Copyright(C) 2016 Björn Stresing, Denis Manthey, Wolfgang Ruppel
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include "Error.h"
+#include <QObject>
+#include <QRunnable>
+#include <QImage>
+#include <QCache>
+#include <QMutex>
+#include <QSet>
+#include <QAtomicInteger>
+
+class QThreadPool;
+
+
+//! Identifies a decoded frame in VideoFrameCache.
+struct VideoFrameKey {
+
+	VideoFrameKey(const QString &rFilePath = QString(), qint64 frame = -1, int reduction = 0) : filePath(rFilePath), frame(frame), reduction(reduction) {}
+	bool operator==(const VideoFrameKey &rOther) const { return frame == rOther.frame && reduction == rOther.reduction && filePath == rOther.filePath; }
+
+	QString filePath;
+	qint64 frame;
+	int reduction;
+};
+
+inline uint qHash(const VideoFrameKey &rKey, uint seed = 0) { return qHash(rKey.filePath, seed) ^ qHash(rKey.frame, seed) ^ (uint)rKey.reduction; }
+
+/*! \brief Decodes JPEG 2000 frames of AS-02 track files into 8 bit RGB images.
+reduction DWT resolution levels are discarded: Every level halves width and height and saves most of the decoding work.
+Codestreams are read through the MxfReaderPool. The codestream itself is decoded multi-threaded. Not thread safe, use one instance per thread.
+*/
+class J2kFrameDecoder {
+
+public:
+	J2kFrameDecoder(int threadCount = 1);
+	~J2kFrameDecoder();
+	Error Decode(const QString &rFilePath, qint64 frame, int reduction, QImage &rImage);
+	void Close();
+
+private:
+	Q_DISABLE_COPY(J2kFrameDecoder);
+	Error Open(const QString &rFilePath);
+
+	class Private;
+	Private *mpPrivate;
+	int mThreadCount;
+};
+
+/*! \brief Thread safe LRU cache of decoded frames.
+The capacity is given in MiB. The least recently used frames are evicted first.
+*/
+class VideoFrameCache {
+
+public:
+	VideoFrameCache(int capacity = 512);
+	~VideoFrameCache() {}
+	void SetCapacity(int capacity);
+	int GetCapacity() const;
+	//! Marks the frame as most recently used.
+	bool Lookup(const VideoFrameKey &rKey, QImage &rImage);
+	bool Contains(const VideoFrameKey &rKey) const;
+	void Insert(const VideoFrameKey &rKey, const QImage &rImage);
+	void Clear();
+	//! Bytes of all cached images.
+	qint64 GetSize() const;
+
+private:
+	Q_DISABLE_COPY(VideoFrameCache);
+	mutable QMutex mMutex;
+	QCache<VideoFrameKey, QImage> mCache; // Cost in KiB.
+};
+
+struct VideoDecodeStatistics {
+
+	VideoDecodeStatistics() : decodedFrames(0), decodeTime(0), cacheHits(0), cacheMisses(0), cancelledFrames(0) {}
+	//! Decoded frames per second of decode thread time.
+	double GetDecodeThroughput() const { return (decodeTime > 0 ? decodedFrames * 1e9 / decodeTime : 0); }
+
+	qint64 decodedFrames;
+	qint64 decodeTime; // Nanoseconds summed over all decode threads.
+	qint64 cacheHits;
+	qint64 cacheMisses;
+	qint64 cancelledFrames; // Prefetches dropped because of a seek.
+};
+
+class VideoDecodeTask;
+
+/*! \brief Decodes frames of a single JPEG 2000 track file on a thread pool.
+Request() returns the frame from the VideoFrameCache or decodes it. Consecutive requests define the playback direction:
+The following frames in this direction are prefetched. A request that doesn't continue the previous one is a seek, it cancels all pending prefetches.
+FrameReady() is only emitted for the most recent request. Must be used from the thread it lives in.
+*/
+class VideoDecodePipeline : public QObject {
+
+	Q_OBJECT
+
+public:
+	VideoDecodePipeline(QObject *pParent = NULL);
+	virtual ~VideoDecodePipeline();
+	//! Reads SETTINGS_VIDEO_PREVIEW_CACHE_SIZE and SETTINGS_VIDEO_PREVIEW_PREFETCH.
+	void LoadSettings();
+	//! Cache capacity in MiB.
+	void SetCacheCapacity(int capacity) { mCache.SetCapacity(capacity); }
+	//! Number of frames decoded ahead of the playhead.
+	void SetPrefetchCount(int count) { mPrefetchCount = qMax(0, count); }
+	void SetTrackFile(const QString &rFilePath, qint64 duration);
+	QString GetTrackFile() const { return mFilePath; }
+	void SetReduction(int reduction);
+	int GetReduction() const { return mReduction; }
+	void Request(qint64 frame);
+	//! Returns true if the frame is in the cache. Doesn't decode.
+	bool Lookup(qint64 frame, QImage &rImage);
+	//! Cancels all prefetches and forgets the playback direction.
+	void Cancel();
+	//! Blocks until the running decodes finished.
+	void WaitForDone();
+	void ClearCache() { mCache.Clear(); }
+	VideoDecodeStatistics GetStatistics() const;
+
+signals:
+	void FrameReady(qint64 frame, const QImage &rImage);
+	void DecodeError(qint64 frame, const QString &rDescription);
+
+private slots:
+	//! rErrorDescription is empty on success.
+	void rFrameDecoded(const QString &rFilePath, qint64 frame, int reduction, const QImage &rImage, const QString &rErrorDescription);
+
+private:
+	Q_DISABLE_COPY(VideoDecodePipeline);
+	friend class VideoDecodeTask;
+	void Schedule(qint64 frame, int priority);
+
+	QThreadPool *mpThreadPool;
+	VideoFrameCache mCache;
+	QString mFilePath;
+	qint64 mDuration;
+	int mReduction;
+	int mPrefetchCount;
+	int mDecoderThreads; // Codestream threads per frame.
+	qint64 mLastRequest;
+	qint64 mPendingFrame; // The requested frame FrameReady() wasn't emitted for yet.
+	int mDirection;
+	QSet<qint64> mScheduled;
+	QAtomicInteger<int> mGeneration; // Incremented on every seek.
+	QAtomicInteger<qint64> mDecodedFrames;
+	QAtomicInteger<qint64> mDecodeTime;
+	qint64 mCancelledFrames;
+	qint64 mCacheHits;
+	qint64 mCacheMisses;
+};
+
+//! Decodes one frame for VideoDecodePipeline. Skips decoding if the pipeline saw a seek in the meantime.
+class VideoDecodeTask : public QObject, public QRunnable {
+
+	Q_OBJECT
+
+public:
+	VideoDecodeTask(VideoDecodePipeline *pPipeline, const QString &rFilePath, qint64 frame, int reduction, int generation, bool cancelable);
+	virtual ~VideoDecodeTask() {}
+	virtual void run();
+
+signals:
+	void Decoded(const QString &rFilePath, qint64 frame, int reduction, const QImage &rImage, const QString &rErrorDescription);
+
+private:
+	Q_DISABLE_COPY(VideoDecodeTask);
+	VideoDecodePipeline *mpPipeline;
+	const QString mFilePath;
+	const qint64 mFrame;
+	const int mReduction;
+	const int mGeneration;
+	const bool mCancelable;
+};
@@ -16,24 +16,29 @@
 #include "WidgetCentral.h"
 #include "WidgetComposition.h"
 #include "WidgetCompositionInfo.h"
+#include "WidgetVideoPreview.h"
 #include "ImfPackage.h"
 #include "ImfCommon.h"
+#include "Jobs.h"
 #include <QHBoxLayout>
 #include <QSplitter>
 #include <QTabWidget>
 #include <QMessageBox>
 #include <QPushButton>
 #include <QFileDialog>
+#include <QThreadPool>
 
 
 WidgetCentral::WidgetCentral(QWidget *pParent /*= NULL*/) :
-QWidget(pParent), mpImfPackage(), mpMsgBox(NULL), mpTabWidget(NULL), mpPreview(NULL), mpDetailsWidget(NULL) {
+QWidget(pParent), mpImfPackage(), mpMsgBox(NULL), mpTabWidget(NULL), mpPreview(NULL), mpDetailsWidget(NULL), mpCplWritePool(NULL), mCplWriteJobs(), mPendingCplWrites(0), mSaveAllCplQueued(false) {
 
 	InitLyout();
 }
 
 WidgetCentral::~WidgetCentral() {
 
+	mpCplWritePool->waitForDone();
+	qDeleteAll(mCplWriteJobs);
 	UninstallImp();
 }
 
@@ -42,6 +47,8 @@ void WidgetCentral::InitLyout() {
 	mpMsgBox = new QMessageBox(this);
 	mpMsgBox->setIcon(QMessageBox::Warning);
 
+	mpCplWritePool = new QThreadPool(this);
+
 	mpTabWidget = new QTabWidget(this);
 	mpTabWidget->setTabsClosable(true);
 	mpTabWidget->setMovable(true);
@@ -62,20 +69,30 @@ void WidgetCentral::InitLyout() {
 	p_details_widget_frame_layout->addWidget(mpDetailsWidget);
 	p_details_widget_frame->setLayout(p_details_widget_frame_layout);
 
+	mpPreview = new WidgetVideoPreview(this);
+	QFrame *p_preview_frame = new QFrame(this);
+	p_preview_frame->setFrameStyle(QFrame::StyledPanel);
+	QHBoxLayout *p_preview_frame_layout = new QHBoxLayout();
+	p_preview_frame_layout->setContentsMargins(0, 0, 0, 0);
+	p_preview_frame_layout->addWidget(mpPreview);
+	p_preview_frame->setLayout(p_preview_frame_layout);
+
 	QSplitter *p_inner_splitter = new QSplitter(this);
 	p_inner_splitter->setOrientation(Qt::Horizontal);
 	p_inner_splitter->setChildrenCollapsible(false);
 	p_inner_splitter->setOpaqueResize(true);
 	p_inner_splitter->addWidget(p_details_widget_frame);
+	p_inner_splitter->addWidget(p_preview_frame);
+	p_inner_splitter->setStretchFactor(0, 1);
 
 	QSplitter *p_outer_splitter = new QSplitter(this);
 	p_outer_splitter->setOrientation(Qt::Vertical);
 	p_outer_splitter->setChildrenCollapsible(false);
 	p_outer_splitter->setOpaqueResize(true);
-	p_outer_splitter->addWidget(p_details_widget_frame);
+	p_outer_splitter->addWidget(p_inner_splitter);
 	p_outer_splitter->addWidget(p_tab_widget_frame);
 	QList<int> sizes;
-	sizes << mpDetailsWidget->sizeHint().height() << -1;
+	sizes << qMax(mpDetailsWidget->sizeHint().height(), mpPreview->sizeHint().height()) << -1;
 	p_outer_splitter->setSizes(sizes);
 	p_outer_splitter->setStretchFactor(1, 1);
 
@@ -94,8 +111,10 @@ void WidgetCentral::rCurrentChanged(int tabWidgetIndex) {
 	if(p_composition) {
 	}
 	p_composition = qobject_cast<WidgetComposition*>(mpTabWidget->widget(tabWidgetIndex));
+	mpPreview->Clear();
 	if(p_composition) {
 		mpDetailsWidget->SetComposition(p_composition);
+		mpPreview->SetEditRate(p_composition->GetEditRate());
 	}
 }
 
@@ -142,6 +161,8 @@ int WidgetCentral::ShowCplEditor(const QUuid &rCplAssetId) {
 			mpMsgBox->setDefaultButton(QMessageBox::Ok);
 			mpMsgBox->exec();
 		}
+		connect(p_widget, SIGNAL(CurrentVideoChanged(const QSharedPointer<AssetMxfTrack>&, const Duration&, const Timecode&)), mpPreview, SLOT(ShowFrame(const QSharedPointer<AssetMxfTrack>&, const Duration&, const Timecode&)));
+		connect(p_widget, SIGNAL(CurrentTimedTextChanged(const QSharedPointer<AssetMxfTrack>&, const Duration&, const Timecode&)), mpPreview, SLOT(ShowTimedText(const QSharedPointer<AssetMxfTrack>&, const Duration&, const Timecode&)));
 		int index = mpTabWidget->addTab(p_widget, mpImfPackage->GetAsset(rCplAssetId)->GetOriginalFileName().first);
 		mpTabWidget->setCurrentWidget(p_widget);
 		return index;
@@ -169,6 +190,7 @@ void WidgetCentral::UninstallImp() {
 
 	mpDetailsWidget->setDisabled(true);
 	mpDetailsWidget->Clear();
+	mpPreview->Clear();
 	for(int i = 0; i < mpTabWidget->count(); i++) {
 		if(QWidget *p_widget = mpTabWidget->widget(i)) {
 			p_widget->deleteLater();
@@ -211,18 +233,77 @@ void WidgetCentral::SaveCurrentCpl() const {
 	SaveCpl(mpTabWidget->currentIndex());
 }
 
-void WidgetCentral::SaveAllCpl() const {
+void WidgetCentral::SaveAllCpl() {
 
+	// A save is in progress. The CPLs may have been edited after their snapshots were taken: Save again when it completed.
+	if(mPendingCplWrites > 0) {
+		mSaveAllCplQueued = true;
+		return;
+	}
 	for(int i = 0; i < mpTabWidget->count(); i++) {
 		//QSharedPointer<AssetCpl> asset_cpl = this->GetMpImfPackage()->GetAsset(0).objectCast<AssetCpl>();
 		WidgetComposition *p_composition = qobject_cast<WidgetComposition*>(mpTabWidget->widget(i));
+		if(p_composition == NULL) continue;
 		QSharedPointer<AssetCpl> asset_cpl = this->GetMpImfPackage()->GetAsset(p_composition->GetCplAssetId()).objectCast<AssetCpl>();
 
-		if (asset_cpl->GetIsNewOrModified()) SaveCpl(i);
-		if (asset_cpl->GetIsNewOrModified()) qDebug() << "asset_cpl->GetIsNewOrModified";
+		if(asset_cpl && asset_cpl->GetIsNewOrModified()) {
+			qDebug() << "asset_cpl->GetIsNewOrModified";
+			// The snapshot is taken in the GUI thread. Serialization and file I/O run in the pool.
+			// The CPL is staged in its asset. The package outgest commits it with the Packing List and ASSETMAP.xml.
+			JobWriteCpl *p_job = p_composition->CreateWriteJob(QString(), true);
+			if(p_job) {
+				p_job->setAutoDelete(false);
+				p_job->SetIdentifier(asset_cpl->GetId());
+				connect(p_job, SIGNAL(Finished(bool)), this, SLOT(rCplWriteFinished()));
+				mCplWriteJobs << p_job;
+			}
+		}
+	}
+	if(mCplWriteJobs.isEmpty()) {
+		//WR begin
+		emit SaveAllCplFinished(QList<QUuid>());
+		//WR end
+		return;
+	}
+	// Count before starting. A fast job must not hit the barrier early.
+	mPendingCplWrites = mCplWriteJobs.size();
+	for(int i = 0; i < mCplWriteJobs.size(); i++) {
+		mpCplWritePool->start(mCplWriteJobs.at(i));
+	}
+}
+
+void WidgetCentral::rCplWriteFinished() {
+
+	if(--mPendingCplWrites > 0) return;
+	// Completion barrier: every CPL was written. The jobs may still be returning from run().
+	mpCplWritePool->waitForDone();
+	QStringList errors;
+	QList<QUuid> outdated_cpl_ids;
+	for(int i = 0; i < mCplWriteJobs.size(); i++) {
+		Error error = mCplWriteJobs.at(i)->GetLastError();
+		if(error.IsError() == true) errors << QString("%1\n%2").arg(error.GetErrorMsg()).arg(error.GetErrorDescription());
+		// The composition has processed the result of its job (queued before Finished()).
+		const QUuid cpl_id = mCplWriteJobs.at(i)->GetIdentifier().toUuid();
+		WidgetComposition *p_composition = qobject_cast<WidgetComposition*>(mpTabWidget->widget(GetIndex(cpl_id)));
+		if(p_composition && p_composition->IsWriteOutdated() == true) outdated_cpl_ids << cpl_id;
+	}
+	qDeleteAll(mCplWriteJobs);
+	mCplWriteJobs.clear();
+	if(errors.isEmpty() == false) {
+		mpMsgBox->setText(tr("CPL Critical?"));
+		mpMsgBox->setInformativeText(errors.join("\n\n"));
+		mpMsgBox->setIcon(QMessageBox::Critical);
+		mpMsgBox->setStandardButtons(QMessageBox::Ok);
+		mpMsgBox->setDefaultButton(QMessageBox::Ok);
+		mpMsgBox->exec();
 	}
+	if(mSaveAllCplQueued == true) {
+		mSaveAllCplQueued = false;
+		SaveAllCpl();
+		return;
+	}
 	//WR begin
-	emit SaveAllCplFinished();
+	emit SaveAllCplFinished(outdated_cpl_ids);
 	//WR end
 }
 
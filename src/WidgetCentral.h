@@ -22,6 +22,8 @@ class QTabWidget;
 class WidgetVideoPreview;
 class QMessageBox;	
 class WidgetCompositionInfo;
+class JobWriteCpl;
+class QThreadPool;
 
 
 class WidgetCentral : public QWidget {
@@ -36,7 +38,11 @@ public:
 	bool IsImpInstalled() const { return mpImfPackage; }
 	int ShowCplEditor(const QUuid &rCplAssetId);
 	void SaveCurrentCpl() const;
-	void SaveAllCpl() const;
+	/*! Snapshots every new or modified CPL and writes them in parallel. Returns immediately.
+	SaveAllCplFinished() is emitted when all CPLs were written. A call while a save is in progress is queued: The save is repeated
+	once the running one completed, SaveAllCplFinished() is emitted after the last one.
+	*/
+	void SaveAllCpl();
 	void CopyCPL(const QSharedPointer<AssetCpl> &rDestination);
 	int GetIndex(const QUuid &rCplAssetId);
 	QUndoStack* GetUndoStack(int index) const;
@@ -48,13 +54,15 @@ signals:
 	void UndoStackChanged(QUndoStack *pStack);
 	void CplSaveStateChanged(bool isDirty);
 //WR begin
-	void SaveAllCplFinished() const;
+	//! rOutdatedCplIds are the CPLs edited while their snapshot was written. They are still new or modified.
+	void SaveAllCplFinished(const QList<QUuid> &rOutdatedCplIds) const;
 //WR end;
 
 
 private slots:
 void rCurrentChanged(int tabWidgetIndex);
 void rTabCloseRequested(int index);
+void rCplWriteFinished();
 
 private:
 	Q_DISABLE_COPY(WidgetCentral);
@@ -67,4 +75,8 @@ private:
 	QTabWidget *mpTabWidget;
 	WidgetVideoPreview *mpPreview;
 	WidgetCompositionInfo *mpDetailsWidget;
+	QThreadPool *mpCplWritePool;
+	QList<JobWriteCpl*> mCplWriteJobs; // Pending jobs of SaveAllCpl().
+	int mPendingCplWrites;
+	bool mSaveAllCplQueued; // SaveAllCpl() was invoked while a save was in progress.
 };
@@ -24,6 +24,10 @@
 #include "GraphicsWidgetSegment.h"
 #include "GraphicsWidgetResources.h"
 #include "CompositionPlaylistCommands.h"
+#include "Trace.h"
+#include "Jobs.h"
+#include "AudioPlayback.h"
+#include "XmlParserPool.h"
 
 #include <QMessageBox>
 #include <QToolBar>
@@ -32,7 +36,10 @@
 #include <QToolButton>
 #include <QButtonGroup>
 #include <QMenu>
+#include <QSet>
 #include <fstream>
+#include <sstream>
+#include <QCryptographicHash>
 #include <QPropertyAnimation>
 
 //WR begin
@@ -44,9 +51,10 @@ QFrame(pParent), mpCompositionView(NULL), mpCompositionScene(NULL), mpTimelineVi
 mpLeftInnerSplitter(NULL), mpRightInnerSplitter(NULL), mpOuterSplitter(NULL), mpTrackSplitter(NULL), mpCompositionGraphicsWidget(NULL),
 mpTimelineGraphicsWidget(NULL), mpUndoStack(NULL), mpToolBar(NULL),
 mAssetCpl(rImp->GetAsset(rCplAssetId).objectCast<AssetCpl>()), mImp(rImp), mpSoloButtonGroup(NULL),
-mData(ImfXmlHelper::Convert(QUuid::createUuid()), ImfXmlHelper::Convert(QDateTime::currentDateTimeUtc()), ImfXmlHelper::Convert(UserText(tr("Unnamed"))), ImfXmlHelper::Convert(EditRate::EditRate24), cpl::CompositionPlaylistType::SegmentListType()) {
+mData(ImfXmlHelper::Convert(QUuid::createUuid()), ImfXmlHelper::Convert(QDateTime::currentDateTimeUtc()), ImfXmlHelper::Convert(UserText(tr("Unnamed"))), ImfXmlHelper::Convert(EditRate::EditRate24), cpl::CompositionPlaylistType::SegmentListType()), mpWriteSnapshot(), mWriteDestination(), mWriteUndoIndex(0), mWriteStaged(false), mWriteOutdated(false), mpAudioEngine(NULL), mpPlayAction(NULL) {
 
 	mpUndoStack = new QUndoStack(this);
+	mpAudioEngine = new AudioPlaybackEngine(this);
 	InitLayout();
 	InitToolbar();
 	InitStyle();
@@ -246,6 +254,7 @@ bool WidgetComposition::DoesTrackExist(eSequenceType type) const {
 
 ImfError WidgetComposition::Read() {
 
+	TRACE_SPAN_DETAIL("WidgetComposition::Read", "xml", mAssetCpl ? mAssetCpl->GetPath().fileName() : QString());
 	ImfError error; // Reset last error.
 	if(mAssetCpl) {
 		if(mAssetCpl->Exists() == true) {
@@ -282,7 +291,41 @@ ImfError WidgetComposition::Read() {
 
 ImfError WidgetComposition::Write(const QString &rDestination /*= QString()*/) {
 
-	ImfError error; // Reset last error.
+	TRACE_SPAN_DETAIL("WidgetComposition::Write", "xml", rDestination);
+	JobWriteCpl *p_job = CreateWriteJob(rDestination);
+	if(p_job == NULL) return ImfError(ImfError::DestinationFileUnspecified, tr("Couldn't write cpl!"));
+	// The job emits its signals in this thread. The composition is updated before PerformRun() returns.
+	p_job->setAutoDelete(false);
+	Error error = p_job->PerformRun();
+	delete p_job;
+	if(error.IsError() == true) return ImfError(ImfError::DestinationFileWrite, QString("%1 %2").arg(error.GetErrorMsg()).arg(error.GetErrorDescription()));
+	return ImfError();
+}
+
+JobWriteCpl* WidgetComposition::CreateWriteJob(const QString &rDestination /*= QString()*/, bool stage /*= false*/) {
+
+	QString destination(rDestination);
+	if((destination.isEmpty() || stage == true) && mAssetCpl) {
+		destination = mAssetCpl->GetPath().absoluteFilePath();
+	}
+	if(destination.isEmpty() || mpWriteSnapshot) return NULL;
+	mpWriteSnapshot = CreateSnapshot();
+	mWriteDestination = destination;
+	mWriteUndoIndex = mpUndoStack->index();
+	mWriteStaged = stage;
+	mWriteOutdated = false;
+	// Overwriting the asset file itself? Then we know its digest (Packing List hash).
+	QByteArray previous_hash;
+	if(mAssetCpl && destination == mAssetCpl->GetPath().absoluteFilePath() && mAssetCpl->HasContent()) previous_hash = mAssetCpl->GetHash();
+	JobWriteCpl *p_job = new JobWriteCpl(mpWriteSnapshot, destination, previous_hash, stage);
+	connect(p_job, SIGNAL(Result(const QByteArray&, const QByteArray&, bool, const QVariant&)), this, SLOT(rWriteJobResult(const QByteArray&, const QByteArray&, bool)));
+	connect(p_job, SIGNAL(Finished(bool)), this, SLOT(rWriteJobFinished()));
+	return p_job;
+}
+
+QSharedPointer<cpl::CompositionPlaylistType> WidgetComposition::CreateSnapshot() {
+
+	TRACE_SPAN("WidgetComposition::CreateSnapshot", "xml");
 	// namespace maps
 	xml_schema::NamespaceInfomap cpl_namespace;
 	cpl_namespace[""].name = XML_NAMESPACE_CPL;
@@ -291,9 +334,8 @@ ImfError WidgetComposition::Write(const QString &rDestination /*= QString()*/) {
 	cpl_namespace["ds"].name = XML_NAMESPACE_DS;
 	cpl_namespace["xs"].name = XML_NAMESPACE_XS;
 
-	cpl::CompositionPlaylistType cpl(mData);
-	cpl.setCreator(ImfXmlHelper::Convert(UserText(CREATOR_STRING)));
-	cpl.setIssueDate(ImfXmlHelper::Convert(QDateTime::currentDateTimeUtc()));
+	QSharedPointer<cpl::CompositionPlaylistType> cpl(new cpl::CompositionPlaylistType(mData));
+	cpl->setCreator(ImfXmlHelper::Convert(UserText(CREATOR_STRING)));
 	cpl::CompositionPlaylistType_SegmentListType segment_list;
 	cpl::CompositionPlaylistType_SegmentListType::SegmentSequence &segment_sequence = segment_list.getSegment();
 	//WR begin
@@ -301,8 +343,8 @@ ImfError WidgetComposition::Write(const QString &rDestination /*= QString()*/) {
 	cpl::CompositionPlaylistType_EssenceDescriptorListType essence_descriptor_list;
 	cpl::CompositionPlaylistType_EssenceDescriptorListType::EssenceDescriptorSequence &essence_descriptor_sequence = essence_descriptor_list.getEssenceDescriptor();
 	essence_descriptor_sequence.clear();
-	//List of UUIDs of resources with essence descriptor
-	QStringList resourceIDs;
+	//Ids of the essence descriptors already added
+	QSet<QUuid> essenceDescriptorIDs;
 	//WR end
 	for(int i = 0; i < mpCompositionGraphicsWidget->GetSegmentCount(); i++) {
 		GraphicsWidgetSegment *p_segment = mpCompositionGraphicsWidget->GetSegment(i);
@@ -327,9 +369,9 @@ ImfError WidgetComposition::Write(const QString &rDestination /*= QString()*/) {
 							if (p_file_resource && mxffile){
 								//Set SourceEncoding in CPL
 								p_file_resource->setSourceEncoding(ImfXmlHelper::Convert(mxffile->GetSourceEncoding()));
-								if (!resourceIDs.contains(mxffile->GetId().toString())){
-									//If not yet added:
-									resourceIDs.append(mxffile->GetId().toString());
+								if (!essenceDescriptorIDs.contains(mxffile->GetSourceEncoding())){
+									//If not yet added (assets with identical descriptors share one):
+									essenceDescriptorIDs.insert(mxffile->GetSourceEncoding());
 									//Push Essence Descriptor into CPL
 									essence_descriptor_sequence.push_back(*(mxffile->GetEssenceDescriptor()));
 								}
@@ -398,46 +440,53 @@ ImfError WidgetComposition::Write(const QString &rDestination /*= QString()*/) {
 			segment_sequence.push_back(segment);
 		}
 	}
-	cpl.setSegmentList(segment_list);
+	cpl->setSegmentList(segment_list);
 	//WR begin
-	cpl.setEssenceDescriptorList(essence_descriptor_list);
+	cpl->setEssenceDescriptorList(essence_descriptor_list);
 	//WR end
-	QString destination(rDestination);
-	if(destination.isEmpty() && mAssetCpl) {
-		destination = mAssetCpl->GetPath().absoluteFilePath();
+	return cpl;
+}
+
+void WidgetComposition::rWriteJobResult(const QByteArray &rHash, const QByteArray &rData, bool changed) {
+
+	if(mpWriteSnapshot.isNull()) return;
+	// Don't discard the undo history of edits that were made while the job was running.
+	mWriteOutdated = (mpUndoStack->index() != mWriteUndoIndex);
+	if(mWriteOutdated == false) mpUndoStack->clear();
+	const bool is_asset_file = (mAssetCpl && mWriteDestination == mAssetCpl->GetPath().absoluteFilePath());
+	if(changed == false) {
+		if(is_asset_file) mAssetCpl->SetHash(rHash); // Confirms the hash. The file doesn't need to be read again.
+		qDebug() << "CPL unchanged. Skipped write " << mWriteDestination.toStdString().c_str();
 	}
-	if(destination.isEmpty() == false) {
-		XmlSerializationError serialization_error;
-		std::ofstream cpl_ofs(destination.toStdString().c_str(), std::ofstream::out);
-		try {
-			cpl::serializeCompositionPlaylist(cpl_ofs, cpl, cpl_namespace, "UTF-8", xml_schema::Flags::dont_initialize);
-		}
-		catch(xml_schema::Serialization &e) { serialization_error = XmlSerializationError(e); }
-		catch(xml_schema::UnexpectedElement &e) { serialization_error = XmlSerializationError(e); }
-		catch(xml_schema::NoTypeInfo &e) { serialization_error = XmlSerializationError(e); }
-		catch(...) { serialization_error = XmlSerializationError(XmlSerializationError::Unknown); }
-		cpl_ofs.close();
-		if(serialization_error.IsError() == true) {
-			qDebug() << serialization_error;
-			error = ImfError(serialization_error);
-		}
+	else if(mWriteStaged == true) {
+		// Written by ImfPackage::Outgest() together with the Packing List.
+		mData.setIssueDate(mpWriteSnapshot->getIssueDate());
+		mAssetCpl->StageContent(rData, rHash);
+		mAssetCpl->SetIsNewOrModified(true);
+		qDebug() << "Staged " << mWriteDestination.toStdString().c_str();
 	}
 	else {
-		error = ImfError(ImfError::DestinationFileUnspecified, tr("Couldn't write cpl!"));
-	}
-	if(!error) {
-		mpUndoStack->clear();
+		if(is_asset_file) mData.setIssueDate(mpWriteSnapshot->getIssueDate()); // The next write compares against this issue date.
 		if(mAssetCpl) mAssetCpl->FileModified();
+		// The job hashed the serialized content. No need to read the file again.
+		if(is_asset_file) mAssetCpl->SetHash(rHash);
 		//WR begin
 		if(mAssetCpl) mAssetCpl->SetIsNewOrModified(true);
 		//WR end
-		qDebug() << "Write " << destination.toStdString().c_str();
+		qDebug() << "Write " << mWriteDestination.toStdString().c_str();
 	}
-	return error;
+}
+
+void WidgetComposition::rWriteJobFinished() {
+
+	mpWriteSnapshot.clear();
+	mWriteDestination.clear();
+	mWriteStaged = false;
 }
 
 ImfError WidgetComposition::WriteNew(const QString &rDestination /*= QString()*/) {
 
+	TRACE_SPAN_DETAIL("WidgetComposition::WriteNew", "xml", rDestination);
 	ImfError error; // Reset last error.
 	// namespace maps
 	xml_schema::NamespaceInfomap cpl_namespace;
@@ -456,7 +505,7 @@ ImfError WidgetComposition::WriteNew(const QString &rDestination /*= QString()*/
 	cpl::CompositionPlaylistType_EssenceDescriptorListType essence_descriptor_list;
 	cpl::CompositionPlaylistType_EssenceDescriptorListType::EssenceDescriptorSequence &essence_descriptor_sequence = essence_descriptor_list.getEssenceDescriptor();
 	essence_descriptor_sequence.clear();
-	QStringList resourceIDs;
+	QSet<QUuid> essenceDescriptorIDs;
 	//WR end
 
 	//create for every existing Track ID a new Track ID
@@ -499,9 +548,9 @@ ImfError WidgetComposition::WriteNew(const QString &rDestination /*= QString()*/
 							if (p_file_resource && mxffile){
 								//Set SourceEncoding in CPL
 								p_file_resource->setSourceEncoding(ImfXmlHelper::Convert(mxffile->GetSourceEncoding()));
-								if (!resourceIDs.contains(mxffile->GetId().toString())){
-									//If not yet added:
-									resourceIDs.append(mxffile->GetId().toString());
+								if (!essenceDescriptorIDs.contains(mxffile->GetSourceEncoding())){
+									//If not yet added (assets with identical descriptors share one):
+									essenceDescriptorIDs.insert(mxffile->GetSourceEncoding());
 									//Push Essence Descriptor into CPL
 									essence_descriptor_sequence.push_back(*(mxffile->GetEssenceDescriptor()));
 								}
@@ -613,23 +662,29 @@ ImfError WidgetComposition::WriteNew(const QString &rDestination /*= QString()*/
 
 ImfError WidgetComposition::ParseCpl() {
 
+	TRACE_SPAN_DETAIL("WidgetComposition::ParseCpl", "xml", mAssetCpl ? mAssetCpl->GetPath().fileName() : QString());
 	ImfError error;
 	XmlParsingError parse_error;
 	// ---Parse Cpl---
 	std::auto_ptr<cpl::CompositionPlaylistType> cpl;
-	try {
-		cpl = cpl::parseCompositionPlaylist(mAssetCpl->GetPath().absoluteFilePath().toStdString(), xml_schema::Flags::dont_validate | xml_schema::Flags::dont_initialize);
+	Error dom_error;
+	xml_schema::dom::auto_ptr<xercesc::DOMDocument> cpl_document(XmlParserPool::Instance().Parse(mAssetCpl->GetPath().absoluteFilePath(), dom_error));
+	if(dom_error.IsError() == true) parse_error = XmlParsingError(XmlParsingError::Parsing, dom_error.GetErrorDescription());
+	else {
+		try {
+			cpl = cpl::parseCompositionPlaylist(*cpl_document, xml_schema::Flags::dont_initialize);
+		}
+		catch(const xml_schema::Parsing &e) { parse_error = XmlParsingError(e); }
+		catch(const xml_schema::ExpectedElement &e) { parse_error = XmlParsingError(e); }
+		catch(const xml_schema::UnexpectedElement &e) { parse_error = XmlParsingError(e); }
+		catch(const xml_schema::ExpectedAttribute &e) { parse_error = XmlParsingError(e); }
+		catch(const xml_schema::UnexpectedEnumerator &e) { parse_error = XmlParsingError(e); }
+		catch(const xml_schema::ExpectedTextContent &e) { parse_error = XmlParsingError(e); }
+		catch(const xml_schema::NoTypeInfo &e) { parse_error = XmlParsingError(e); }
+		catch(const xml_schema::NotDerived &e) { parse_error = XmlParsingError(e); }
+		catch(const xml_schema::NoPrefixMapping &e) { parse_error = XmlParsingError(e); }
+		catch(...) { parse_error = XmlParsingError(XmlParsingError::Unknown); }
 	}
-	catch(const xml_schema::Parsing &e) { parse_error = XmlParsingError(e); }
-	catch(const xml_schema::ExpectedElement &e) { parse_error = XmlParsingError(e); }
-	catch(const xml_schema::UnexpectedElement &e) { parse_error = XmlParsingError(e); }
-	catch(const xml_schema::ExpectedAttribute &e) { parse_error = XmlParsingError(e); }
-	catch(const xml_schema::UnexpectedEnumerator &e) { parse_error = XmlParsingError(e); }
-	catch(const xml_schema::ExpectedTextContent &e) { parse_error = XmlParsingError(e); }
-	catch(const xml_schema::NoTypeInfo &e) { parse_error = XmlParsingError(e); }
-	catch(const xml_schema::NotDerived &e) { parse_error = XmlParsingError(e); }
-	catch(const xml_schema::NoPrefixMapping &e) { parse_error = XmlParsingError(e); }
-	catch(...) { parse_error = XmlParsingError(XmlParsingError::Unknown); }
 
 	if(parse_error.IsError() == false) {
 		mData = *cpl;
@@ -734,11 +789,11 @@ ImfError WidgetComposition::ParseCpl() {
 					if(p_file_resource) {
 						switch(p_graphics_sequence->GetType()) {
 							case MainImageSequence:
-								if(mImp) p_graphics_sequence->AddResource(new GraphicsWidgetVideoResource(p_graphics_sequence, p_file_resource->_clone(), mImp->GetAsset(ImfXmlHelper::Convert(p_file_resource->getTrackFileId())).objectCast<AssetMxfTrack>()), p_graphics_sequence->GetResourceCount());
+								if(mImp) p_graphics_sequence->AddResource(new GraphicsWidgetVideoResource(p_graphics_sequence, p_file_resource->_clone(), mImp->ResolveAsset(ImfXmlHelper::Convert(p_file_resource->getTrackFileId())).objectCast<AssetMxfTrack>()), p_graphics_sequence->GetResourceCount());
 								else p_graphics_sequence->AddResource(new GraphicsWidgetVideoResource(p_graphics_sequence, p_file_resource->_clone()), p_graphics_sequence->GetResourceCount());
 								break;
 							case MainAudioSequence:
-								if(mImp) p_graphics_sequence->AddResource(new GraphicsWidgetAudioResource(p_graphics_sequence, p_file_resource->_clone(), mImp->GetAsset(ImfXmlHelper::Convert(p_file_resource->getTrackFileId())).objectCast<AssetMxfTrack>()), p_graphics_sequence->GetResourceCount());
+								if(mImp) p_graphics_sequence->AddResource(new GraphicsWidgetAudioResource(p_graphics_sequence, p_file_resource->_clone(), mImp->ResolveAsset(ImfXmlHelper::Convert(p_file_resource->getTrackFileId())).objectCast<AssetMxfTrack>()), p_graphics_sequence->GetResourceCount());
 								else p_graphics_sequence->AddResource(new GraphicsWidgetAudioResource(p_graphics_sequence, p_file_resource->_clone()), p_graphics_sequence->GetResourceCount());
 								break;
 							case CommentarySequence:
@@ -746,16 +801,16 @@ ImfError WidgetComposition::ParseCpl() {
 							case KaraokeSequence:
 							case SubtitlesSequence:
 							case VisuallyImpairedTextSequence:
-								if(mImp) p_graphics_sequence->AddResource(new GraphicsWidgetTimedTextResource(p_graphics_sequence, p_file_resource->_clone(), mImp->GetAsset(ImfXmlHelper::Convert(p_file_resource->getTrackFileId())).objectCast<AssetMxfTrack>()), p_graphics_sequence->GetResourceCount());
+								if(mImp) p_graphics_sequence->AddResource(new GraphicsWidgetTimedTextResource(p_graphics_sequence, p_file_resource->_clone(), mImp->ResolveAsset(ImfXmlHelper::Convert(p_file_resource->getTrackFileId())).objectCast<AssetMxfTrack>()), p_graphics_sequence->GetResourceCount());
 								else p_graphics_sequence->AddResource(new GraphicsWidgetTimedTextResource(p_graphics_sequence, p_file_resource->_clone()), p_graphics_sequence->GetResourceCount());
 								break;
 							case AncillaryDataSequence:
-								if(mImp) p_graphics_sequence->AddResource(new GraphicsWidgetAncillaryDataResource(p_graphics_sequence, p_file_resource->_clone(), mImp->GetAsset(ImfXmlHelper::Convert(p_file_resource->getTrackFileId())).objectCast<AssetMxfTrack>()), p_graphics_sequence->GetResourceCount());
+								if(mImp) p_graphics_sequence->AddResource(new GraphicsWidgetAncillaryDataResource(p_graphics_sequence, p_file_resource->_clone(), mImp->ResolveAsset(ImfXmlHelper::Convert(p_file_resource->getTrackFileId())).objectCast<AssetMxfTrack>()), p_graphics_sequence->GetResourceCount());
 								else p_graphics_sequence->AddResource(new GraphicsWidgetAncillaryDataResource(p_graphics_sequence, p_file_resource->_clone()), p_graphics_sequence->GetResourceCount());
 								break;
 							case Unknown:
 								qDebug() << "A generic file resource will be added to unknown sequence.";
-								if(mImp) p_graphics_sequence->AddResource(new GraphicsWidgetFileResource(p_graphics_sequence, p_file_resource->_clone(), mImp->GetAsset(ImfXmlHelper::Convert(p_file_resource->getTrackFileId())).objectCast<AssetMxfTrack>()), p_graphics_sequence->GetResourceCount());
+								if(mImp) p_graphics_sequence->AddResource(new GraphicsWidgetFileResource(p_graphics_sequence, p_file_resource->_clone(), mImp->ResolveAsset(ImfXmlHelper::Convert(p_file_resource->getTrackFileId())).objectCast<AssetMxfTrack>()), p_graphics_sequence->GetResourceCount());
 								else p_graphics_sequence->AddResource(new GraphicsWidgetFileResource(p_graphics_sequence, p_file_resource->_clone()), p_graphics_sequence->GetResourceCount());
 								break;
 							default:
@@ -905,6 +960,11 @@ void WidgetComposition::InitToolbar() {
 	QAction *p_action = mpToolBar->addAction(QIcon(":/cutter.png"), tr("Edit"), mpCompositionScene, SLOT(SetEditRequest()));
 	p_action->setShortcut(Qt::Key_E);
 	p_action->setAutoRepeat(false);
+	mpPlayAction = mpToolBar->addAction(QIcon(":/play.png"), tr("Play"), this, SLOT(rTogglePlayback()));
+	mpPlayAction->setShortcut(Qt::Key_Space);
+	mpPlayAction->setAutoRepeat(false);
+	connect(mpAudioEngine, SIGNAL(PositionChanged(qint64)), this, SLOT(rPlaybackPositionChanged(qint64)));
+	connect(mpAudioEngine, SIGNAL(Finished()), this, SLOT(rPlaybackFinished()));
 	connect(p_add_track_menu, SIGNAL(aboutToShow()), this, SLOT(rAddTrackMenuAboutToShow()));
 	connect(p_add_track_menu, SIGNAL(triggered(QAction*)), this, SLOT(rAddTrackMenuActionTriggered(QAction*)));
 }
@@ -1015,6 +1075,7 @@ void WidgetComposition::rCurrentFrameChanged(const Timecode &rCplTimecode) {
 	if(p_segment) {
 		QUuid audio_track_id;
 		QUuid video_track_id;
+		QUuid timed_text_track_id;
 		for(int i = 0; i < GetTrackDetailCount(); i++) {
 			AbstractWidgetTrackDetails *p_track_details = GetTrackDetail(i);
 			if(p_track_details) {
@@ -1026,9 +1087,13 @@ void WidgetComposition::rCurrentFrameChanged(const Timecode &rCplTimecode) {
 				else if(p_track_details->GetType() == MainImageSequence) {
 					video_track_id = p_track_details->GetId();
 				}
+				else if(p_track_details->GetType() == SubtitlesSequence && timed_text_track_id.isNull()) {
+					timed_text_track_id = p_track_details->GetId();
+				}
 			}
 		}
-		QList<AbstractGraphicsWidgetResource*> resources_list = mpCompositionScene->GetResourcesAt(rCplTimecode, MainAudioSequence | MainImageSequence);
+		AbstractGraphicsWidgetResource *p_timed_text_resource = NULL;
+		QList<AbstractGraphicsWidgetResource*> resources_list = mpCompositionScene->GetResourcesAt(rCplTimecode, MainAudioSequence | MainImageSequence | SubtitlesSequence);
 		for(int i = 0; i < resources_list.size(); i++) {
 			GraphicsWidgetSequence *p_seq = dynamic_cast<GraphicsWidgetSequence*>(resources_list.at(i)->GetSequence());
 			if(p_seq) {
@@ -1040,9 +1105,118 @@ void WidgetComposition::rCurrentFrameChanged(const Timecode &rCplTimecode) {
 					AbstractGraphicsWidgetResource *p_resource = resources_list.at(i);
 					emit CurrentVideoChanged(p_resource->GetAsset(), (p_resource->MapToCplTimeline(Timecode()) - rCplTimecode).AsPositiveDuration(), rCplTimecode);
 				}
+				else if(p_seq->GetTrackId() == timed_text_track_id) {
+					p_timed_text_resource = resources_list.at(i);
+				}
+			}
+		}
+		// Emitted after the video so the preview shows the subtitles on top of the current frame.
+		if(p_timed_text_resource && p_timed_text_resource->GetEditRate().IsValid()) {
+			qint64 local_frame = p_timed_text_resource->MapFromCplTimeline(rCplTimecode).GetOverallFrames();
+			const qint64 entry_point = p_timed_text_resource->GetEntryPoint().GetCount();
+			const qint64 source_duration = p_timed_text_resource->GetSourceDuration().GetCount();
+			// Every repetition starts at the entry point again.
+			if(source_duration > 0 && local_frame >= entry_point + source_duration) local_frame = entry_point + (local_frame - entry_point) % source_duration;
+			emit CurrentTimedTextChanged(p_timed_text_resource->GetAsset(), Duration((qint64)(local_frame * 1000. / p_timed_text_resource->GetEditRate().GetQuotient())), rCplTimecode);
+		}
+		else emit CurrentTimedTextChanged(QSharedPointer<AssetMxfTrack>(), Duration(), rCplTimecode);
+	}
+}
+
+QUuid WidgetComposition::GetPlaybackAudioTrackId() const {
+
+	QUuid track_id;
+	for(int i = 0; i < GetTrackDetailCount(); i++) {
+		AbstractWidgetTrackDetails *p_track_details = GetTrackDetail(i);
+		if(p_track_details && p_track_details->GetType() == MainAudioSequence) {
+			if(track_id.isNull()) track_id = p_track_details->GetId();
+			WidgetAudioTrackDetails *p_audio_track = static_cast<WidgetAudioTrackDetails*>(p_track_details);
+			if(p_audio_track->GetSoloButton()->isChecked() == true) return p_audio_track->GetId();
+		}
+	}
+	return track_id;
+}
+
+QList<AudioPlaybackResource> WidgetComposition::GetAudioPlaylist(int sampleRate) const {
+
+	QList<AudioPlaybackResource> playlist;
+	const QUuid track_id = GetPlaybackAudioTrackId();
+	const EditRate cpl_edit_rate = GetEditRate();
+	if(track_id.isNull() || cpl_edit_rate.IsValid() == false) return playlist;
+	for(int i = 0; i < mpCompositionGraphicsWidget->GetSegmentCount(); i++) {
+		GraphicsWidgetSegment *p_segment = mpCompositionGraphicsWidget->GetSegment(i);
+		if(p_segment == NULL) continue;
+		for(int ii = 0; ii < p_segment->GetSequenceCount(); ii++) {
+			GraphicsWidgetSequence *p_sequence = p_segment->GetSequence(ii);
+			if(p_sequence == NULL || p_sequence->GetTrackId() != track_id) continue;
+			for(int iii = 0; iii < p_sequence->GetResourceCount(); iii++) {
+				GraphicsWidgetAudioResource *p_resource = dynamic_cast<GraphicsWidgetAudioResource*>(p_sequence->GetResource(iii));
+				if(p_resource == NULL || p_resource->HasAsset() == false || p_resource->GetAsset()->Exists() == false) continue;
+				const EditRate resource_edit_rate = p_resource->GetEditRate();
+				if(resource_edit_rate.IsValid() == false) continue;
+				// The resource edit rate of IMF audio equals the sample rate.
+				const double samples_per_edit_unit = sampleRate * resource_edit_rate.GetDenominator() / double(resource_edit_rate.GetNumerator());
+				const qint64 cpl_frame = p_resource->MapToCplTimeline(p_resource->GetFirstVisibleFrame()).GetOverallFrames();
+				AudioPlaybackResource resource;
+				resource.filePath = p_resource->GetAsset()->GetPath().absoluteFilePath();
+				resource.timelineStart = cpl_frame * sampleRate * cpl_edit_rate.GetDenominator() / cpl_edit_rate.GetNumerator();
+				resource.entryPoint = (qint64)(p_resource->GetEntryPoint().GetCount() * samples_per_edit_unit);
+				resource.sourceDuration = (qint64)(p_resource->GetSourceDuration().GetCount() * samples_per_edit_unit);
+				resource.repeatCount = p_resource->GetRepeatCount();
+				resource.soundfieldGroup = p_resource->GetSoundfieldGroup();
+				const Metadata metadata = p_resource->GetAsset()->GetMetadata();
+				if(metadata.editRate.GetNumerator() == sampleRate * metadata.editRate.GetDenominator()) {
+					resource.channelCount = metadata.audioChannelCount;
+					resource.quantizationBits = metadata.audioQuantization;
+				}
+				if(resource.sourceDuration > 0) playlist << resource;
 			}
 		}
 	}
+	return playlist;
+}
+
+void WidgetComposition::rTogglePlayback() {
+
+	if(mpAudioEngine->IsPlaying() == true) {
+		mpAudioEngine->Stop();
+		rPlaybackFinished();
+		return;
+	}
+	mpAudioEngine->LoadSettings();
+	const int sample_rate = mpAudioEngine->GetSampleRate();
+	const EditRate edit_rate = GetEditRate();
+	mpAudioEngine->SetPlaylist(GetAudioPlaylist(sample_rate));
+	const qint64 frame = (qint64)mpTimelineScene->GetCurrentFrameIndicator()->pos().x();
+	if(mpAudioEngine->Start(frame * sample_rate * edit_rate.GetDenominator() / edit_rate.GetNumerator()) == true) {
+		mpPlayAction->setIcon(QIcon(":/pause.png"));
+		mpPlayAction->setText(tr("Pause"));
+	}
+	else {
+		QMessageBox::warning(this, tr("Playback"), tr("Couldn't open the audio device. Check the audio settings."));
+	}
+}
+
+void WidgetComposition::rPlaybackPositionChanged(qint64 sample) {
+
+	const EditRate edit_rate = GetEditRate();
+	const qint64 frame = sample * edit_rate.GetNumerator() / ((qint64)mpAudioEngine->GetSampleRate() * edit_rate.GetDenominator());
+	mpTimelineScene->GetCurrentFrameIndicator()->SetXPos(frame);
+}
+
+void WidgetComposition::rPlaybackFinished() {
+
+	mpPlayAction->setIcon(QIcon(":/play.png"));
+	mpPlayAction->setText(tr("Play"));
+}
+
+void WidgetComposition::hideEvent(QHideEvent *pEvent) {
+
+	if(mpAudioEngine->IsPlaying() == true) {
+		mpAudioEngine->Stop();
+		rPlaybackFinished();
+	}
+	QFrame::hideEvent(pEvent);
 }
 
 XmlSerializationError WidgetComposition::WriteMinimal(const QString &rDestination, const QUuid &rId, const EditRate &rEditRate, const UserText &rContentTitle, const UserText &rIssuer /*= UserText()*/, const UserText &rContentOriginator /*= UserText()*/) {
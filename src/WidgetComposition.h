@@ -34,6 +34,9 @@ class QUndoStack;
 class QToolBar;
 class QAction;
 class QButtonGroup;
+class JobWriteCpl;
+class AudioPlaybackEngine;
+struct AudioPlaybackResource;
 
 class WidgetComposition : public QFrame {
 
@@ -73,10 +76,19 @@ public:
 	ImfError Read();
 	//! Writes the cpl to rDestination file. If rDestination is empty the cpl referenced by rCplAssetId will be overwritten.
 	ImfError Write(const QString &rDestination = QString());
+	/*! Snapshots the composition and returns a job that serializes and writes the snapshot to rDestination (see Write()). Must be invoked in the GUI thread. The job may run in any thread.
+	If stage is true the serialized CPL is staged in the CPL asset instead (see Asset::StageContent()) and written by the next ImfPackage::Outgest(). rDestination is ignored.
+	The composition updates itself when the job succeeded. Returns NULL if rDestination is empty or another write job of this composition is pending.
+	*/
+	JobWriteCpl* CreateWriteJob(const QString &rDestination = QString(), bool stage = false);
+	//! True if the composition was edited while the last write job was running. The written or staged CPL doesn't hold these edits.
+	bool IsWriteOutdated() const { return mWriteOutdated; }
 	//! Writes the cpl to rDestination file and creates new IDs for segments and sequences. This method is used to copy the data of an existing CPL into a new one.
 	ImfError WriteNew(const QString &rDestination = QString());
 	//! Disables wheel scrolling in detail track widget.
 	bool eventFilter(QObject *pObj, QEvent *pEvt);
+	//! Returns the resources of the solo audio track (the first main audio track if no track is solo). Positions are counted in samples.
+	QList<AudioPlaybackResource> GetAudioPlaylist(int sampleRate) const;
 	bool DoesTrackExist(const QUuid &rId) const;
 	bool DoesTrackExist(eSequenceType type) const;
 	int GetTrackCount(eSequenceType type) const;
@@ -88,6 +100,8 @@ signals:
 	void FrameInicatorActive(bool active);
 	void CurrentAudioChanged(const QSharedPointer<AssetMxfTrack> &rAsset, const Duration &rOffset, const Timecode &rTimecode);
 	void CurrentVideoChanged(const QSharedPointer<AssetMxfTrack> &rAsset, const Duration &rOffset, const Timecode &rTimecode);
+	//! rOffset is the time in the timed text track file [ms]. rAsset is null if the first subtitles track has no resource at rTimecode.
+	void CurrentTimedTextChanged(const QSharedPointer<AssetMxfTrack> &rAsset, const Duration &rOffset, const Timecode &rTimecode);
 
 	public slots:
 	void AddNewSegmentRequest(int segmentIndex);
@@ -111,6 +125,15 @@ signals:
 	void rAddTrackMenuAboutToShow();
 	void rAddTrackMenuActionTriggered(QAction *pAction);
 	void rToolBarActionTriggered(QAction *pAction);
+	void rWriteJobResult(const QByteArray &rHash, const QByteArray &rData, bool changed);
+	void rWriteJobFinished();
+	void rTogglePlayback();
+	void rPlaybackPositionChanged(qint64 sample);
+	void rPlaybackFinished();
+
+protected:
+	//! Stops the audio playback.
+	virtual void hideEvent(QHideEvent *pEvent);
 
 private:
 	Q_DISABLE_COPY(WidgetComposition);
@@ -118,6 +141,9 @@ private:
 	void InitToolbar();
 	void InitStyle();
 	ImfError ParseCpl();
+	QUuid GetPlaybackAudioTrackId() const;
+	//! Builds the CPL from the timeline. Cheap compared to the serialization.
+	QSharedPointer<cpl::CompositionPlaylistType> CreateSnapshot();
 
 	//! Takes ownership.
 	void AddTrackDetail(AbstractWidgetTrackDetails* pTrack, int TrackIndex);
@@ -147,6 +173,13 @@ private:
 	QSharedPointer<ImfPackage> mImp;
 	QButtonGroup *mpSoloButtonGroup;
 	cpl::CompositionPlaylistType mData;
+	QSharedPointer<cpl::CompositionPlaylistType> mpWriteSnapshot; // Snapshot of the pending write job.
+	QString mWriteDestination;
+	int mWriteUndoIndex;
+	bool mWriteStaged;
+	bool mWriteOutdated;
+	AudioPlaybackEngine *mpAudioEngine;
+	QAction *mpPlayAction;
 	// QActions
 	QAction *mpAddMarkerTrackAction;
 	QAction *mpAddAncillaryDataTrackAction;
@@ -22,13 +22,13 @@
 #include <QFileInfo>
 #include <QDir>
 #include <QHeaderView>
+#include <QTimer>
 
 
 WidgetFileBrowser::WidgetFileBrowser(QWidget *pParent /*= NULL*/) :
 QWidget(pParent), mpModelFS(NULL), mpViewFS(NULL), mLastIndexSelected() {
 
 	InitLayout();
-	InitModel();
 }
 
 WidgetFileBrowser::~WidgetFileBrowser() {
@@ -47,8 +47,16 @@ void WidgetFileBrowser::InitLayout() {
 	connect(mpViewFS, SIGNAL(clicked(const QModelIndex &)), this, SLOT(FilterTreeViewClicked(const QModelIndex &)));
 }
 
+void WidgetFileBrowser::showEvent(QShowEvent *pEvent) {
+
+	QWidget::showEvent(pEvent);
+	// Rooting the model at the home directory can take seconds on network shares. Attach it after the first frame was painted.
+	if(mpModelFS == NULL) QTimer::singleShot(0, this, SLOT(InitModel()));
+}
+
 void WidgetFileBrowser::InitModel() {
 
+	if(mpModelFS) return;
 	mpModelFS = new QFileSystemModel(this);
 	mpModelFS->setNameFilterDisables(true);
 	mpModelFS->setNameFilters(QStringList("*.exr"));
@@ -33,13 +33,17 @@ public:
 signals:
 	void ExrFileSelectionChanged(const QFileInfo &rFileInfo);
 
+protected:
+	virtual void showEvent(QShowEvent *pEvent);
+
 	private slots:
 	void FilterTreeViewClicked(const QModelIndex &rIndex);
+	//! The file system model is attached when the widget is shown for the first time.
+	void InitModel();
 
 private:
 	Q_DISABLE_COPY(WidgetFileBrowser);
 	void InitLayout();
-	void InitModel();
 
 	QFileSystemModel			*mpModelFS;
 	QTreeView							*mpViewFS;
@@ -24,6 +24,7 @@
 #include "UndoProxyModel.h"
 #include "JobQueue.h"
 #include "Jobs.h"
+#include "WidgetXmlValidation.h"
 #include <QStringList>
 #include <QVBoxLayout>
 #include <QHeaderView>
@@ -38,11 +39,12 @@
 #include <QDrag>
 #include <QToolButton>
 #include <QFileDialog>
+#include <QSettings>
 #include <list>
 
 
 WidgetImpBrowser::WidgetImpBrowser(QWidget *pParent /*= NULL*/) :
-QFrame(pParent), mpViewImp(NULL), mpViewAssets(NULL), mpImfPackage(NULL), mpToolBar(NULL), mpUndoStack(NULL), mpUndoProxyModel(NULL), mpSortProxyModelImp(NULL), mpSortProxyModelAssets(NULL), mpMsgBox(NULL), mpJobQueue(NULL) {
+QFrame(pParent), mpViewImp(NULL), mpViewAssets(NULL), mpImfPackage(NULL), mpToolBar(NULL), mpUndoStack(NULL), mpUndoProxyModel(NULL), mpSortProxyModelImp(NULL), mpSortProxyModelAssets(NULL), mpMsgBox(NULL), mpJobQueue(NULL), mpExportQueue(NULL), mExportSummary(), mpVariantQueue(NULL), mVariantAssets() {
 
 	setFrameStyle(QFrame::StyledPanel);
 	setSizePolicy(QSizePolicy::Preferred, QSizePolicy::Preferred);
@@ -50,6 +52,14 @@ QFrame(pParent), mpViewImp(NULL), mpViewAssets(NULL), mpImfPackage(NULL), mpTool
 	mpJobQueue = new JobQueue(this);
 	mpJobQueue->SetInterruptIfError(true);
 	connect(mpJobQueue, SIGNAL(finished()), this, SLOT(rJobQueueFinished()));
+	// Exports must not trigger an outgest. They run in their own queue.
+	mpExportQueue = new JobQueue(this);
+	mpExportQueue->SetInterruptIfError(true);
+	connect(mpExportQueue, SIGNAL(finished()), this, SLOT(rExportQueueFinished()));
+	// CPL variants are added to the package when all of them were written.
+	mpVariantQueue = new JobQueue(this);
+	mpVariantQueue->SetInterruptIfError(true);
+	connect(mpVariantQueue, SIGNAL(finished()), this, SLOT(rVariantQueueFinished()));
 	InitLayout();
 	InitToolbar();
 }
@@ -124,7 +134,14 @@ void WidgetImpBrowser::InitLayout() {
 	connect(mpViewImp, SIGNAL(customContextMenuRequested(QPoint)), SLOT(rCustomMenuRequested(QPoint)));
 	connect(mpJobQueue, SIGNAL(Progress(int)), mpProgressDialog, SLOT(setValue(int)));
 	connect(mpJobQueue, SIGNAL(NextJobStarted(const QString&)), mpProgressDialog, SLOT(setLabelText(const QString&)));
+	connect(mpJobQueue, SIGNAL(Statistics(const JobQueueStatistics&)), this, SLOT(rJobQueueStatistics(const JobQueueStatistics&)));
 	connect(mpProgressDialog, SIGNAL(canceled()), mpJobQueue, SLOT(InterruptQueue()));
+	connect(mpExportQueue, SIGNAL(Progress(int)), mpProgressDialog, SLOT(setValue(int)));
+	connect(mpExportQueue, SIGNAL(Statistics(const JobQueueStatistics&)), this, SLOT(rJobQueueStatistics(const JobQueueStatistics&)));
+	connect(mpProgressDialog, SIGNAL(canceled()), mpExportQueue, SLOT(InterruptQueue()));
+	connect(mpVariantQueue, SIGNAL(Progress(int)), mpProgressDialog, SLOT(setValue(int)));
+	connect(mpVariantQueue, SIGNAL(Statistics(const JobQueueStatistics&)), this, SLOT(rJobQueueStatistics(const JobQueueStatistics&)));
+	connect(mpProgressDialog, SIGNAL(canceled()), mpVariantQueue, SLOT(InterruptQueue()));
 }
 
 void WidgetImpBrowser::InitToolbar() {
@@ -148,12 +165,37 @@ void WidgetImpBrowser::InitToolbar() {
 	connect(p_add_ttml_resource, SIGNAL(triggered(bool)), this, SLOT(ShowResourceGeneratorTimedTextMode()));
 	//p_add_ttml_resource->setDisabled(true);
 	p_add_track_menu->addSeparator();
+	QAction *p_add_cpl_variants = p_add_track_menu->addAction(tr("CPL Variants..."));
+	p_add_cpl_variants->setToolTip(tr("Generate CPLs from a template CPL and a substitution table"));
+	connect(p_add_cpl_variants, SIGNAL(triggered(bool)), this, SLOT(ShowCplVariantGenerator()));
 	p_button_add_track->setMenu(p_add_track_menu);
 
+	QAction *p_action_validate = new QAction(tr("Validate XML"), this);
+	p_action_validate->setToolTip(tr("Validate Asset Map, Packing Lists, CPLs and OPLs against their schemas"));
+	p_action_validate->setDisabled(true);
+	connect(this, SIGNAL(ImplInstalled(bool)), p_action_validate, SLOT(setEnabled(bool)));
+	connect(p_action_validate, SIGNAL(triggered(bool)), this, SLOT(ShowXmlValidation()));
+
+	QToolButton *p_button_export = new QToolButton(NULL);
+	p_button_export->setText(tr("Export"));
+	p_button_export->setToolTip(tr("Clone the package into a new directory. Track files are reflinked or hard linked where the file system allows it"));
+	p_button_export->setPopupMode(QToolButton::InstantPopup);
+	p_button_export->setDisabled(true);
+	connect(this, SIGNAL(ImplInstalled(bool)), p_button_export, SLOT(setEnabled(bool)));
+	QMenu *p_export_menu = new QMenu(tr("Export"), this);
+	QAction *p_export_package = p_export_menu->addAction(tr("Package..."));
+	connect(p_export_package, SIGNAL(triggered(bool)), this, SLOT(ExportPackage()));
+	QAction *p_export_supplemental = p_export_menu->addAction(tr("Supplemental Package..."));
+	connect(p_export_supplemental, SIGNAL(triggered(bool)), this, SLOT(ExportSupplementalPackage()));
+	p_button_export->setMenu(p_export_menu);
+
 	mpToolBar->addAction(p_action_undo);
 	mpToolBar->addAction(p_action_redo);
 	mpToolBar->addSeparator();
 	mpToolBar->addWidget(p_button_add_track);
+	mpToolBar->addSeparator();
+	mpToolBar->addAction(p_action_validate);
+	mpToolBar->addWidget(p_button_export);
 }
 
 void WidgetImpBrowser::InstallImp(const QSharedPointer<ImfPackage> &rImfPackage, bool validateHash /*= false*/) {
@@ -298,13 +340,20 @@ void WidgetImpBrowser::Save() {
 		int ret = mpMsgBox->exec();
 		if(ret == QMessageBox::Ok) {
 			mpJobQueue->FlushQueue();
+			// Asset files rewritten in place need a new hash.
+			mpImfPackage->RescanFiles();
+			const bool analyze_audio = QSettings().value(SETTINGS_AUDIO_ANALYSIS, true).toBool();
 			for(int i = 0; i < mpImfPackage->GetAssetCount(); i++) {
+				bool hashed_by_wrap_job = false;
+				bool written_by_wrap_job = false;
 				QSharedPointer<AssetMxfTrack> mxf_asset = mpImfPackage->GetAsset(i).objectCast<AssetMxfTrack>();
 				if(mxf_asset && mxf_asset->Exists() == false) {
 					if(mxf_asset->GetEssenceType() == Metadata::Pcm) {
-						JobWrapWav *p_wrap_job = new JobWrapWav(mxf_asset->GetSourceFiles(), mxf_asset->GetPath().absoluteFilePath(), mxf_asset->GetSoundfieldGroup(), mxf_asset->GetId());
+						JobWrapWav *p_wrap_job = new JobWrapWav(mxf_asset->GetSourceFiles(), mxf_asset->GetPath().absoluteFilePath(), mxf_asset->GetSoundfieldGroup(), mxf_asset->GetId(), analyze_audio);
+						connect(p_wrap_job, SIGNAL(AudioAnalysisFinished(const AudioAnalysisResult&)), mxf_asset.data(), SLOT(SetAudioAnalysis(const AudioAnalysisResult&)));
 						connect(p_wrap_job, SIGNAL(Success()), mxf_asset.data(), SLOT(FileModified()));
 						mpJobQueue->AddJob(p_wrap_job);
+						written_by_wrap_job = true;
 					}
 
 
@@ -313,13 +362,21 @@ void WidgetImpBrowser::Save() {
 						JobWrapTimedText *p_wrap_job = new JobWrapTimedText(mxf_asset->GetSourceFiles(), mxf_asset->GetPath().absoluteFilePath(), mxf_asset->GetEditRate(), mxf_asset->GetDuration(), mxf_asset->GetId(), mxf_asset->GetProfile(), mxf_asset->GetTimedTextFrameRate());
 						connect(p_wrap_job, SIGNAL(Success()), mxf_asset.data(), SLOT(FileModified()));
 						mpJobQueue->AddJob(p_wrap_job);
+						written_by_wrap_job = true;
 					}
 						/* -----Denis Manthey----- */
+					else if(mxf_asset->GetEssenceType() == Metadata::Jpeg2000 && mxf_asset->HasSourceFiles()) {
+						JobWrapJ2c *p_wrap_job = new JobWrapJ2c(mxf_asset->GetSourceFiles(), mxf_asset->GetPath().absoluteFilePath(), mxf_asset->GetEditRate(), mxf_asset->GetId());
+						connect(p_wrap_job, SIGNAL(Result(const QByteArray&, const QVariant&)), mxf_asset.data(), SLOT(FileWritten(const QByteArray&)));
+						mpJobQueue->AddJob(p_wrap_job);
+						hashed_by_wrap_job = true;
+					}
 
 				}
 				QSharedPointer<Asset> abstract_asset = mpImfPackage->GetAsset(i);
-				if(abstract_asset && abstract_asset->NeedsNewHash() && abstract_asset->GetType() != Asset::pkl) {
-					JobCalculateHash *p_hash_job = new JobCalculateHash(abstract_asset->GetPath().absoluteFilePath());
+				if(abstract_asset && abstract_asset->NeedsNewHash() && abstract_asset->GetType() != Asset::pkl && hashed_by_wrap_job == false) {
+					// Never resume or reuse a hash of a file the wrap job is about to rewrite.
+					JobCalculateHash *p_hash_job = new JobCalculateHash(abstract_asset->GetPath().absoluteFilePath(), written_by_wrap_job == false);
 					connect(p_hash_job, SIGNAL(Result(const QByteArray&, const QVariant&)), abstract_asset.data(), SLOT(SetHash(const QByteArray&)));
 					mpJobQueue->AddJob(p_hash_job);
 				}
@@ -371,6 +428,131 @@ void WidgetImpBrowser::ShowCompositionGenerator() {
 	connect(p_wizard_composition_generator, SIGNAL(accepted()), this, SLOT(rCompositionGeneratorAccepted()));
 }
 
+void WidgetImpBrowser::ShowCplVariantGenerator() {
+
+	if(mpImfPackage.isNull() == true || mpVariantQueue->IsQueueRunning() == true) return;
+	QStringList templates;
+	for(int i = 0; i < mpImfPackage->GetAssetCount(); i++) {
+		QSharedPointer<AssetCpl> asset_cpl = mpImfPackage->GetAsset(i).objectCast<AssetCpl>();
+		if(asset_cpl && asset_cpl->Exists() == true) templates << asset_cpl->GetPath().absoluteFilePath();
+	}
+	if(templates.isEmpty() == true) {
+		mpMsgBox->setText(tr("CPL Variants"));
+		mpMsgBox->setInformativeText(tr("The package contains no CPL that could be used as template."));
+		mpMsgBox->setStandardButtons(QMessageBox::Ok);
+		mpMsgBox->setDefaultButton(QMessageBox::Ok);
+		mpMsgBox->setIcon(QMessageBox::Warning);
+		mpMsgBox->exec();
+		return;
+	}
+	WizardCplVariantGenerator *p_wizard_variant_generator = new WizardCplVariantGenerator(templates, this);
+	p_wizard_variant_generator->setAttribute(Qt::WA_DeleteOnClose, true);
+	p_wizard_variant_generator->show();
+	connect(p_wizard_variant_generator, SIGNAL(accepted()), this, SLOT(rCplVariantGeneratorAccepted()));
+}
+
+void WidgetImpBrowser::ShowXmlValidation() {
+
+	if(mpImfPackage) {
+		WidgetXmlValidation *p_widget_validation = new WidgetXmlValidation(mpImfPackage->GetXmlFiles(), this);
+		p_widget_validation->setAttribute(Qt::WA_DeleteOnClose, true);
+		p_widget_validation->show();
+	}
+}
+
+void WidgetImpBrowser::ExportPackage() {
+
+	StartExport(false);
+}
+
+void WidgetImpBrowser::ExportSupplementalPackage() {
+
+	StartExport(true);
+}
+
+void WidgetImpBrowser::StartExport(bool supplemental) {
+
+	if(mpImfPackage.isNull() == true || mpJobQueue->IsQueueRunning() == true || mpExportQueue->IsQueueRunning() == true) return;
+	if(mpImfPackage->IsDirty() == true) {
+		mpMsgBox->setText(tr("Export Package"));
+		mpMsgBox->setInformativeText(tr("The package has unsaved changes. Save the package before exporting it."));
+		mpMsgBox->setStandardButtons(QMessageBox::Ok);
+		mpMsgBox->setDefaultButton(QMessageBox::Ok);
+		mpMsgBox->setIcon(QMessageBox::Warning);
+		mpMsgBox->exec();
+		return;
+	}
+	QSet<QUuid> base_asset_ids;
+	if(supplemental == true) {
+		QString base_dir = QFileDialog::getExistingDirectory(this, tr("Select the base package"), mpImfPackage->GetRootDir().absolutePath());
+		if(base_dir.isEmpty() == true) return;
+		ImfPackage base_package(base_dir);
+		ImfError error = base_package.Ingest();
+		if(error.IsError() == false) {
+			for(int i = 0; i < base_package.GetAssetCount(); i++) {
+				if(base_package.GetAsset(i)->GetType() != Asset::pkl) base_asset_ids.insert(base_package.GetAsset(i)->GetId());
+			}
+		}
+		else {
+			mpMsgBox->setText(tr("Couldn't open the base package"));
+			mpMsgBox->setInformativeText(QString("%1\n%2").arg(error.GetErrorMsg()).arg(error.GetErrorDescription()));
+			mpMsgBox->setStandardButtons(QMessageBox::Ok);
+			mpMsgBox->setDefaultButton(QMessageBox::Ok);
+			mpMsgBox->setIcon(QMessageBox::Critical);
+			mpMsgBox->exec();
+			return;
+		}
+	}
+	QString target_dir = QFileDialog::getExistingDirectory(this, supplemental ? tr("Export Supplemental Package to") : tr("Export Package to"), mpImfPackage->GetRootDir().absolutePath());
+	if(target_dir.isEmpty() == true) return;
+
+	ImfError error;
+	JobExportPackage *p_export_job = mpImfPackage->CreateExportJob(QDir(target_dir), base_asset_ids, error);
+	if(p_export_job == NULL) {
+		mpMsgBox->setText(tr("Export Error"));
+		mpMsgBox->setInformativeText(QString("%1\n%2").arg(error.GetErrorMsg()).arg(error.GetErrorDescription()));
+		mpMsgBox->setStandardButtons(QMessageBox::Ok);
+		mpMsgBox->setDefaultButton(QMessageBox::Ok);
+		mpMsgBox->setIcon(QMessageBox::Critical);
+		mpMsgBox->exec();
+		return;
+	}
+	mExportSummary.clear();
+	connect(p_export_job, SIGNAL(Result(const QString&, const QVariant&)), this, SLOT(rExportResult(const QString&)));
+	mpExportQueue->FlushQueue();
+	mpExportQueue->AddJob(p_export_job);
+	mpExportQueue->StartQueue();
+}
+
+void WidgetImpBrowser::rExportResult(const QString &rSummary) {
+
+	mExportSummary = rSummary;
+}
+
+void WidgetImpBrowser::rExportQueueFinished() {
+
+	mpProgressDialog->reset();
+	QString error_msg;
+	QList<Error> errors = mpExportQueue->GetErrors();
+	for(int i = 0; i < errors.size(); i++) {
+		error_msg.append(QString("%1: %2\n%3\n").arg(i + 1).arg(errors.at(i).GetErrorMsg()).arg(errors.at(i).GetErrorDescription()));
+	}
+	error_msg.chop(1); // remove last \n
+	if(errors.empty() == true) {
+		mpMsgBox->setText(tr("Export finished"));
+		mpMsgBox->setInformativeText(tr("Files per copy method: %1").arg(mExportSummary));
+		mpMsgBox->setIcon(QMessageBox::Information);
+	}
+	else {
+		mpMsgBox->setText(tr("Export Error"));
+		mpMsgBox->setInformativeText(error_msg);
+		mpMsgBox->setIcon(QMessageBox::Critical);
+	}
+	mpMsgBox->setStandardButtons(QMessageBox::Ok);
+	mpMsgBox->setDefaultButton(QMessageBox::Ok);
+	mpMsgBox->exec();
+}
+
 void WidgetImpBrowser::rShowResourceGeneratorForSelectedRow() {
 
 	if(mpImfPackage) {
@@ -433,6 +615,15 @@ void WidgetImpBrowser::rResourceGeneratorAccepted() {
 					mpUndoStack->push(new AddAssetCommand(mpImfPackage, mxf_asset, mpImfPackage->GetPackingListId()));
 				}
 						/* -----Denis Manthey----- */
+				else if(selected_files.isEmpty() == false && is_j2c_file(selected_files.first())) {
+					QUuid id = QUuid::createUuid();
+					QString file_name = QString("J2K_%1.mxf").arg(strip_uuid(id));
+					QFileInfo mxf_asset_file_path(mpImfPackage->GetRootDir().absoluteFilePath(file_name));
+					QSharedPointer<AssetMxfTrack> mxf_asset(new AssetMxfTrack(mxf_asset_file_path, id));
+					mxf_asset->SetSourceFiles(selected_files);
+					mxf_asset->SetFrameRate(edit_rate);
+					mpUndoStack->push(new AddAssetCommand(mpImfPackage, mxf_asset, mpImfPackage->GetPackingListId()));
+				}
 
 
 			}
@@ -509,6 +700,61 @@ void WidgetImpBrowser::rCompositionGeneratorAccepted() {
 	}
 }
 
+void WidgetImpBrowser::rCplVariantGeneratorAccepted() {
+
+	WizardCplVariantGenerator *p_variant_generator = qobject_cast<WizardCplVariantGenerator *>(sender());
+	if(p_variant_generator && mpImfPackage && mpVariantQueue->IsQueueRunning() == false) {
+		JobGenerateCplVariants *p_variant_job = new JobGenerateCplVariants(p_variant_generator->GetTemplate(), p_variant_generator->GetVariants(), mpImfPackage->GetRootDir());
+		// Every track file with an essence descriptor may replace a template track file. The descriptors are shared, not copied.
+		for(int i = 0; i < mpImfPackage->GetAssetCount(); i++) {
+			QSharedPointer<AssetMxfTrack> asset_mxf = mpImfPackage->GetAsset(i).objectCast<AssetMxfTrack>();
+			if(asset_mxf && asset_mxf->Exists() == true && asset_mxf->GetEssenceDescriptor()) {
+				p_variant_job->AddTrackFile(asset_mxf->GetId(), asset_mxf->GetSourceEncoding(), asset_mxf->GetEditRate(), asset_mxf->GetDuration(), asset_mxf->GetEssenceDescriptor(), asset_mxf->GetHash());
+			}
+		}
+		mVariantAssets.clear();
+		connect(p_variant_job, SIGNAL(Result(const QString&, const QUuid&, const QByteArray&, const QByteArray&, const QVariant&)), this, SLOT(rCplVariantBuilt(const QString&, const QUuid&, const QByteArray&, const QByteArray&)));
+		mpVariantQueue->FlushQueue();
+		mpVariantQueue->AddJob(p_variant_job);
+		mpVariantQueue->StartQueue();
+	}
+}
+
+void WidgetImpBrowser::rCplVariantBuilt(const QString &rFilePath, const QUuid &rId, const QByteArray &rData, const QByteArray &rHash) {
+
+	QSharedPointer<AssetCpl> cpl_asset(new AssetCpl(QFileInfo(rFilePath), rId));
+	cpl_asset->StageContent(rData, rHash);
+	mVariantAssets << cpl_asset;
+}
+
+void WidgetImpBrowser::rVariantQueueFinished() {
+
+	mpProgressDialog->reset();
+	QString error_msg;
+	QList<Error> errors = mpVariantQueue->GetErrors();
+	for(int i = 0; i < errors.size(); i++) {
+		error_msg.append(QString("%1: %2\n%3\n").arg(i + 1).arg(errors.at(i).GetErrorMsg()).arg(errors.at(i).GetErrorDescription()));
+	}
+	error_msg.chop(1); // remove last \n
+	if(errors.empty() == true && mVariantAssets.isEmpty() == false && mpImfPackage) {
+		// One undo step for all variants. The CPLs are staged: the next outgest writes them with the Packing List and Asset Map, undoing before that leaves no file behind.
+		QUndoCommand *p_add_variants_command = new QUndoCommand(tr("Add %n CPL variant(s)", "", mVariantAssets.size()));
+		for(int i = 0; i < mVariantAssets.size(); i++) {
+			new AddAssetCommand(mpImfPackage, mVariantAssets.at(i), mpImfPackage->GetPackingListId(), p_add_variants_command);
+		}
+		mpUndoStack->push(p_add_variants_command);
+	}
+	else if(errors.empty() == false) {
+		mpMsgBox->setText(tr("CPL Variant Error"));
+		mpMsgBox->setInformativeText(error_msg);
+		mpMsgBox->setStandardButtons(QMessageBox::Ok);
+		mpMsgBox->setDefaultButton(QMessageBox::Ok);
+		mpMsgBox->setIcon(QMessageBox::Critical);
+		mpMsgBox->exec();
+	}
+	mVariantAssets.clear();
+}
+
 void WidgetImpBrowser::rMapCurrentRowSelectionChanged(const QModelIndex &rCurrent, const QModelIndex &rPrevious) {
 
 	QItemSelectionModel *p_source_selection_model = qobject_cast<QItemSelectionModel*>(sender());
@@ -545,6 +791,13 @@ void WidgetImpBrowser::rMapCurrentRowSelectionChanged(const QModelIndex &rCurren
 	}
 }
 
+void WidgetImpBrowser::rJobQueueStatistics(const JobQueueStatistics &rStatistics) {
+
+	if(rStatistics.currentJob.isEmpty() == false) {
+		mpProgressDialog->setLabelText(QString("%1\n%2").arg(rStatistics.currentJob).arg(rStatistics.GetAsString()));
+	}
+}
+
 void WidgetImpBrowser::rJobQueueFinished() {
 
 	mpProgressDialog->reset();
@@ -688,15 +941,20 @@ void WidgetImpBrowser::rDeleteSelectedRow() {
 }
 //WR begin
 // Called via signal SaveAllCplFinished() by WidgetCentral::SaveAllCpl
-void WidgetImpBrowser::RecalcHashForCpls() {
+void WidgetImpBrowser::RecalcHashForCpls(const QList<QUuid> &rOutdatedCplIds) {
 	mpJobQueue->FlushQueue();
 	for(int i = 0; i < mpImfPackage->GetAssetCount(); i++) {
 		QSharedPointer<AssetCpl> asset_cpl = mpImfPackage->GetAsset(i).objectCast<AssetCpl>();
-		if(asset_cpl && asset_cpl->NeedsNewHash() ) {
-			JobCalculateHash *p_hash_job = new JobCalculateHash(asset_cpl->GetPath().absoluteFilePath());
-			connect(p_hash_job, SIGNAL(Result(const QByteArray&, const QVariant&)), asset_cpl.data(), SLOT(SetHash(const QByteArray&)));
-			mpJobQueue->AddJob(p_hash_job);
-			asset_cpl->SetIsNewOrModified(false);
+		if(asset_cpl) {
+			// WidgetComposition::Write() sets the hash of the serialized CPL. Only CPLs written by other means must be read again.
+			if(asset_cpl->NeedsNewHash()) {
+				// CPLs are small and were just written.
+				JobCalculateHash *p_hash_job = new JobCalculateHash(asset_cpl->GetPath().absoluteFilePath(), false);
+				connect(p_hash_job, SIGNAL(Result(const QByteArray&, const QVariant&)), asset_cpl.data(), SLOT(SetHash(const QByteArray&)));
+				mpJobQueue->AddJob(p_hash_job);
+			}
+			// The written snapshot lacks the latest edits. rJobQueueFinished() saves the CPL again before the package is written.
+			if(rOutdatedCplIds.contains(asset_cpl->GetId()) == false) asset_cpl->SetIsNewOrModified(false);
 		}
 	}
 	mpJobQueue->StartQueue();
@@ -26,6 +26,7 @@ class UndoProxyModel;
 class QSortFilterProxyModel;
 class QProgressDialog;
 class JobQueue;
+struct JobQueueStatistics;
 
 
 class CustomTableView : public QTableView {
@@ -69,8 +70,16 @@ signals:
 	void ShowResourceGeneratorWavMode();
 	void ShowResourceGeneratorTimedTextMode();
 	void ShowCompositionGenerator();
+	//! Generates CPLs from a template CPL of the package and a substitution table (see JobGenerateCplVariants).
+	void ShowCplVariantGenerator();
+	void ShowXmlValidation();
+	//! Clones the package into a new directory (see ImfPackage::CreateExportJob()).
+	void ExportPackage();
+	//! Exports only the Assets that are not part of a base package the user selects.
+	void ExportSupplementalPackage();
 	//WR begin
-	void RecalcHashForCpls();
+	//! Hashes the written CPLs. rOutdatedCplIds were edited while they were written and stay new or modified.
+	void RecalcHashForCpls(const QList<QUuid> &rOutdatedCplIds);
 	//WR end
 
 	private slots :
@@ -80,12 +89,18 @@ signals:
 	void rShowResourceGeneratorForAsset(const QUuid &rAssetId);
 	void rResourceGeneratorAccepted();
 	void rCompositionGeneratorAccepted();
+	void rCplVariantGeneratorAccepted();
+	void rCplVariantBuilt(const QString &rFilePath, const QUuid &rId, const QByteArray &rData, const QByteArray &rHash);
+	void rVariantQueueFinished();
 	void rCustomMenuRequested(QPoint pos);
 	void rMapCurrentRowSelectionChanged(const QModelIndex &rCurrent, const QModelIndex &rPrevious);
 	void rJobQueueFinished();
+	void rJobQueueStatistics(const JobQueueStatistics &rStatistics);
 	void rImpViewDoubleClicked(const QModelIndex &rIndex);
 	void rOpenCplTimeline();
 	void rReinstallImp();
+	void rExportResult(const QString &rSummary);
+	void rExportQueueFinished();
 
 protected:
 	virtual void keyPressEvent(QKeyEvent *pEvent);
@@ -96,6 +111,7 @@ private:
 	void InitToolbar();
 	void StartOutgest(bool clearUndoStack = true);
 	void ValidateHash();
+	void StartExport(bool supplemental);
 
 	CustomTableView *mpViewImp;
 	CustomTableView *mpViewAssets;
@@ -108,4 +124,8 @@ private:
 	QMessageBox *mpMsgBox;
 	QProgressDialog *mpProgressDialog;
 	JobQueue *mpJobQueue;
+	JobQueue *mpExportQueue;
+	QString mExportSummary;
+	JobQueue *mpVariantQueue;
+	QList<QSharedPointer<AssetCpl> > mVariantAssets; // Built by the running JobGenerateCplVariants.
 };
@@ -28,6 +28,7 @@
 #include <QDialogButtonBox>
 #include <QTableWidget>
 #include <QHeaderView>
+#include <QCheckBox>
 
 
 #define CHANNELS_LIST_PROPERTY "ChannelsList"
@@ -124,6 +125,7 @@ void WidgetAudioSettingsPage::InitLayout() {
 	mpChannelsList7->setProperty(CHANNELS_LIST_PROPERTY, QVariant(7));
 
 	mpAudioTargetChannel = new QComboBox(this);
+	mpAnalyzeAudioCheckBox = new QCheckBox(tr("Measure loudness, true-peak and silent channels while wrapping"), this);
 
 	mpStackedLayout = new QStackedLayout();
 	mpStackedLayout->addWidget(mpChannelsList0);
@@ -148,6 +150,7 @@ void WidgetAudioSettingsPage::InitLayout() {
 	p_layout->addWidget(mpAudioChannelConfigurationSpinBox, 0, 3, 1, 1);
 	p_layout->addItem(new QSpacerItem(0, 0, QSizePolicy::Expanding, QSizePolicy::Minimum), 0, 4, 1, 1);
 	p_layout->addWidget(mpGroupBox, 1, 0, 1, 5);
+	p_layout->addWidget(mpAnalyzeAudioCheckBox, 2, 0, 1, 5);
 	setLayout(p_layout);
 
 	connect(mpAudioDeviceSpinBox, SIGNAL(currentIndexChanged(int)), this, SLOT(rCurrentIndexChanged(int)));
@@ -170,7 +173,7 @@ void WidgetAudioSettingsPage::Read() {
 	ReadChannelsTable(mpChannelsList5);
 	ReadChannelsTable(mpChannelsList6);
 	ReadChannelsTable(mpChannelsList7);
-
+	mpAnalyzeAudioCheckBox->setChecked(settings.value(SETTINGS_AUDIO_ANALYSIS, true).toBool());
 }
 
 void WidgetAudioSettingsPage::Write() {
@@ -186,6 +189,7 @@ void WidgetAudioSettingsPage::Write() {
 	WriteChannelsTable(mpChannelsList5);
 	WriteChannelsTable(mpChannelsList6);
 	WriteChannelsTable(mpChannelsList7);
+	settings.setValue(SETTINGS_AUDIO_ANALYSIS, QVariant(mpAnalyzeAudioCheckBox->isChecked()));
 }
 
 void WidgetAudioSettingsPage::ReadChannelsTable(QListWidget *pList) {
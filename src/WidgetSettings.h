@@ -26,6 +26,7 @@ class QStackedLayout;
 class QDialogButtonBox;
 class QTableWidget;
 class QLabel;
+class QCheckBox;
 
 class AbstractWidgetSettingsPage : public QWidget {
 
@@ -84,6 +85,7 @@ private:
 	QListWidget *mpChannelsList5;
 	QListWidget *mpChannelsList6;
 	QListWidget *mpChannelsList7;
+	QCheckBox *mpAnalyzeAudioCheckBox;
 };
 
 
@@ -0,0 +1,207 @@
+/* Copyright(C) 2016 Björn Stresing, Denis Manthey, Wolfgang Ruppel
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "WidgetVideoPreview.h"
+#include "VideoDecoder.h"
+#include "ImfPackage.h"
+#include "TimedTextRenderer.h"
+#include "Trace.h"
+#include <QPainter>
+#include <QTimer>
+#include <QDebug>
+
+// Each discarded DWT level halves the resolution. IMF application #2 codestreams have at least five levels.
+#define VIDEO_PREVIEW_MAX_REDUCTION 5
+// Cues beginning within this interval are rendered ahead of time [ms].
+#define VIDEO_PREVIEW_TIMED_TEXT_PREFETCH 5000
+#define VIDEO_PREVIEW_TIMED_TEXT_PREFETCH_CUES 8
+
+
+WidgetVideoPreview::WidgetVideoPreview(QWidget *pParent /*= NULL*/) :
+QWidget(pParent), mpPipeline(NULL), mpPresentationTimer(NULL), mImage(), mPendingImage(), mIdleTicks(0), mStoredWidth(0), mCurrentFrame(-1), mMessage(),
+mTimedTextFile(), mTimedTextTime(0), mTimedTextDocument(), mTimedTextCues() {
+
+	setAttribute(Qt::WA_OpaquePaintEvent);
+	setMinimumSize(160, 90);
+	mpPresentationTimer = new QTimer(this);
+	mpPresentationTimer->setTimerType(Qt::PreciseTimer);
+	SetEditRate(EditRate::EditRate24);
+	connect(mpPresentationTimer, SIGNAL(timeout()), this, SLOT(rPresentationTick()));
+	connect(&TimedTextRenderCache::Instance(), SIGNAL(DocumentLoaded(const QString&)), this, SLOT(rTimedTextDocumentLoaded(const QString&)));
+}
+
+VideoDecodePipeline* WidgetVideoPreview::GetPipeline() {
+
+	if(mpPipeline == NULL) {
+		mpPipeline = new VideoDecodePipeline(this);
+		mpPipeline->LoadSettings();
+		connect(mpPipeline, SIGNAL(FrameReady(qint64, const QImage&)), this, SLOT(rFrameReady(qint64, const QImage&)));
+		connect(mpPipeline, SIGNAL(DecodeError(qint64, const QString&)), this, SLOT(rDecodeError(qint64, const QString&)));
+	}
+	return mpPipeline;
+}
+
+void WidgetVideoPreview::SetEditRate(const EditRate &rEditRate) {
+
+	if(rEditRate.IsValid() == false) return;
+	mpPresentationTimer->setInterval(qMax(1, qRound(rEditRate.GetEditUnit() * 1000)));
+}
+
+void WidgetVideoPreview::ShowFrame(const QSharedPointer<AssetMxfTrack> &rAsset, const Duration &rOffset, const Timecode &rTimecode) {
+
+	if(rAsset.isNull() || rAsset->Exists() == false || rAsset->GetEssenceType() != Metadata::Jpeg2000) {
+		Clear();
+		mMessage = tr("No preview available");
+		update();
+		return;
+	}
+	mStoredWidth = rAsset->GetMetadata().storedWidth;
+	VideoDecodePipeline *p_pipeline = GetPipeline();
+	p_pipeline->SetTrackFile(rAsset->GetPath().absoluteFilePath(), rAsset->GetDuration().GetCount());
+	p_pipeline->SetReduction(GetReduction());
+	mCurrentFrame = rOffset.GetCount();
+	mMessage.clear();
+	p_pipeline->Request(mCurrentFrame);
+}
+
+void WidgetVideoPreview::ShowTimedText(const QSharedPointer<AssetMxfTrack> &rAsset, const Duration &rOffset, const Timecode &rTimecode) {
+
+	if(rAsset.isNull() || rAsset->Exists() == false || rAsset->GetEssenceType() != Metadata::TimedText) {
+		mTimedTextFile.clear();
+		mTimedTextDocument.clear();
+		if(mTimedTextCues.isEmpty() == false) {
+			mTimedTextCues.clear();
+			update();
+		}
+		return;
+	}
+	mTimedTextFile = rAsset->GetPath().absoluteFilePath();
+	mTimedTextTime = rOffset.GetCount();
+	UpdateTimedText();
+}
+
+void WidgetVideoPreview::UpdateTimedText() {
+
+	// Doesn't block. rTimedTextDocumentLoaded() is invoked when the document was loaded.
+	const QSharedPointer<const TimedTextDocument> document(TimedTextRenderCache::Instance().GetDocument(mTimedTextFile));
+	QList<int> cues;
+	if(document) cues = document->GetCuesAt(mTimedTextTime);
+	if(document != mTimedTextDocument || cues != mTimedTextCues) {
+		mTimedTextDocument = document;
+		mTimedTextCues = cues;
+		update();
+	}
+	if(document) {
+		const QList<int> upcoming_cues(document->GetCues(mTimedTextTime, mTimedTextTime + VIDEO_PREVIEW_TIMED_TEXT_PREFETCH).mid(0, VIDEO_PREVIEW_TIMED_TEXT_PREFETCH_CUES));
+		TimedTextRenderCache::Instance().Prefetch(document, upcoming_cues, GetFrameRect().size());
+	}
+}
+
+void WidgetVideoPreview::rTimedTextDocumentLoaded(const QString &rFilePath) {
+
+	if(mTimedTextFile.isEmpty() == false && rFilePath == mTimedTextFile) UpdateTimedText();
+}
+
+void WidgetVideoPreview::Clear() {
+
+	if(mpPipeline) mpPipeline->Cancel();
+	mpPresentationTimer->stop();
+	mCurrentFrame = -1;
+	mImage = QImage();
+	mPendingImage = QImage();
+	mMessage.clear();
+	mTimedTextFile.clear();
+	mTimedTextDocument.clear();
+	mTimedTextCues.clear();
+	update();
+}
+
+void WidgetVideoPreview::rFrameReady(qint64 frame, const QImage &rImage) {
+
+	mPendingImage = rImage;
+	// Idle: Present immediately and start pacing.
+	if(mpPresentationTimer->isActive() == false) {
+		rPresentationTick();
+		mpPresentationTimer->start();
+	}
+}
+
+void WidgetVideoPreview::rDecodeError(qint64 frame, const QString &rDescription) {
+
+	qWarning() << "Couldn't decode frame" << frame << rDescription;
+	mImage = QImage();
+	mMessage = rDescription;
+	update();
+}
+
+void WidgetVideoPreview::rPresentationTick() {
+
+	if(mPendingImage.isNull() == false) {
+		mImage = mPendingImage;
+		mPendingImage = QImage();
+		mIdleTicks = 0;
+		update();
+	}
+	else if(++mIdleTicks > 1) mpPresentationTimer->stop();
+}
+
+void WidgetVideoPreview::paintEvent(QPaintEvent *pEvent) {
+
+	TRACE_SPAN("WidgetVideoPreview::paintEvent", "paint");
+	QPainter painter(this);
+	painter.fillRect(rect(), Qt::black);
+	const QRect target = GetFrameRect();
+	if(mImage.isNull() == false) {
+		painter.setRenderHint(QPainter::SmoothPixmapTransform);
+		painter.drawImage(target, mImage);
+	}
+	else if(mMessage.isEmpty() == false) {
+		painter.setPen(palette().color(QPalette::Mid));
+		painter.drawText(rect(), Qt::AlignCenter | Qt::TextWordWrap, mMessage);
+	}
+	// Cue images are cached per frame size. Only the first paint of a cue lays it out.
+	for(int i = 0; mTimedTextDocument && i < mTimedTextCues.size(); i++) {
+		const QImage cue_image = TimedTextRenderCache::Instance().GetCueImage(mTimedTextDocument, mTimedTextCues.at(i), target.size());
+		if(cue_image.isNull() == false) painter.drawImage(target.topLeft() + TimedTextDocument::GetCueRect(mTimedTextDocument->GetCue(mTimedTextCues.at(i)), target.size()).topLeft(), cue_image);
+	}
+}
+
+QRect WidgetVideoPreview::GetFrameRect() const {
+
+	QSize frame_size(16, 9);
+	if(mImage.isNull() == false) frame_size = mImage.size();
+	else if(mTimedTextDocument && mTimedTextDocument->GetRootExtent().isValid()) frame_size = mTimedTextDocument->GetRootExtent();
+	QRect target(QPoint(0, 0), frame_size.scaled(size(), Qt::KeepAspectRatio));
+	target.moveCenter(rect().center());
+	return target;
+}
+
+void WidgetVideoPreview::resizeEvent(QResizeEvent *pEvent) {
+
+	QWidget::resizeEvent(pEvent);
+	const int reduction = GetReduction();
+	if(mpPipeline && mCurrentFrame >= 0 && reduction != mpPipeline->GetReduction()) {
+		mpPipeline->SetReduction(reduction);
+		mpPipeline->Request(mCurrentFrame);
+	}
+}
+
+int WidgetVideoPreview::GetReduction() const {
+
+	const quint32 target_width = qMax(1, width() * devicePixelRatio());
+	int reduction = 0;
+	while(reduction < VIDEO_PREVIEW_MAX_REDUCTION && (mStoredWidth >> (reduction + 1)) >= target_width) reduction++;
+	return reduction;
+}
@@ -0,0 +1,84 @@
+/* Copyright(C) 2016 Björn Stresing, Denis Manthey, Wolfgang Ruppel
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include "ImfCommon.h"
+#include <QWidget>
+#include <QImage>
+#include <QSharedPointer>
+
+
+class AssetMxfTrack;
+class VideoDecodePipeline;
+class TimedTextDocument;
+class QTimer;
+
+/*! \brief Shows the frame of the video track at the current frame indicator.
+JPEG 2000 frames are decoded on the CPU by VideoDecodePipeline. The resolution level is chosen to match the widget size.
+Decoded frames are presented at most once per edit unit of the CPL edit rate.
+The active cues of the first subtitles track are drawn on top. They are rendered once per frame size by TimedTextRenderCache, upcoming cues ahead of time.
+*/
+class WidgetVideoPreview : public QWidget {
+
+	Q_OBJECT
+
+public:
+	WidgetVideoPreview(QWidget *pParent = NULL);
+	virtual ~WidgetVideoPreview() {}
+	virtual QSize sizeHint() const { return QSize(320, 180); }
+	//! Paces the presentation. Use the CPL edit rate.
+	void SetEditRate(const EditRate &rEditRate);
+
+public slots:
+	//! Connect to WidgetComposition::CurrentVideoChanged(). rOffset is the frame in the track file.
+	void ShowFrame(const QSharedPointer<AssetMxfTrack> &rAsset, const Duration &rOffset, const Timecode &rTimecode);
+	//! Connect to WidgetComposition::CurrentTimedTextChanged(). rOffset is the time in the track file [ms].
+	void ShowTimedText(const QSharedPointer<AssetMxfTrack> &rAsset, const Duration &rOffset, const Timecode &rTimecode);
+	void Clear();
+
+protected:
+	virtual void paintEvent(QPaintEvent *pEvent);
+	virtual void resizeEvent(QResizeEvent *pEvent);
+
+private slots:
+	void rFrameReady(qint64 frame, const QImage &rImage);
+	void rDecodeError(qint64 frame, const QString &rDescription);
+	void rPresentationTick();
+	void rTimedTextDocumentLoaded(const QString &rFilePath);
+
+private:
+	Q_DISABLE_COPY(WidgetVideoPreview);
+	//! Number of DWT levels we can discard without dropping below the widget resolution.
+	int GetReduction() const;
+	//! The decode pipeline (and its thread pool) is created when the first frame is requested.
+	VideoDecodePipeline* GetPipeline();
+	//! Looks up the cues active at mTimedTextTime and prefetches the following ones.
+	void UpdateTimedText();
+	//! Area of the frame in widget coordinates.
+	QRect GetFrameRect() const;
+
+	VideoDecodePipeline *mpPipeline;
+	QTimer *mpPresentationTimer;
+	QImage mImage;
+	QImage mPendingImage; // Presented on the next tick.
+	int mIdleTicks;
+	quint32 mStoredWidth;
+	qint64 mCurrentFrame;
+	QString mMessage;
+	QString mTimedTextFile;
+	qint64 mTimedTextTime; // [ms]
+	QSharedPointer<const TimedTextDocument> mTimedTextDocument;
+	QList<int> mTimedTextCues;
+};
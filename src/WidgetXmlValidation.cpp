@@ -0,0 +1,127 @@
+/* Copyright(C) 2016 Björn Stresing, Denis Manthey, Wolfgang Ruppel
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "WidgetXmlValidation.h"
+#include <QTreeWidget>
+#include <QHeaderView>
+#include <QLabel>
+#include <QPushButton>
+#include <QDialogButtonBox>
+#include <QGridLayout>
+#include <QFileInfo>
+#include <QBrush>
+
+
+WidgetXmlValidation::WidgetXmlValidation(const QStringList &rFiles, QWidget *pParent /*= NULL*/) :
+QWidget(pParent), mpService(NULL), mFiles(rFiles), mpTree(NULL), mpStatus(NULL), mpButtonRevalidate(NULL), mValidatedCount(0), mValidCount(0) {
+
+	setSizePolicy(QSizePolicy::Preferred, QSizePolicy::Preferred);
+	setWindowFlags(Qt::Dialog);
+	setWindowTitle(tr("XML Schema Validation"));
+	mpService = new XmlValidationService(this);
+	connect(mpService, SIGNAL(DocumentValidated(const XmlValidationResult&)), this, SLOT(rDocumentValidated(const XmlValidationResult&)));
+	connect(mpService, SIGNAL(Finished()), this, SLOT(rFinished()));
+	InitLayout();
+	Validate();
+}
+
+QSize WidgetXmlValidation::sizeHint() const {
+
+	return QSize(900, 500);
+}
+
+void WidgetXmlValidation::InitLayout() {
+
+	mpTree = new QTreeWidget(this);
+	mpTree->setColumnCount(ColumnMax);
+	mpTree->setHeaderLabels(QStringList() << tr("Document") << tr("Line") << tr("Column") << tr("Message"));
+	mpTree->setUniformRowHeights(true);
+	mpTree->header()->setSectionResizeMode(ColumnDocument, QHeaderView::ResizeToContents);
+	mpTree->header()->setSectionResizeMode(ColumnLine, QHeaderView::ResizeToContents);
+	mpTree->header()->setSectionResizeMode(ColumnColumn, QHeaderView::ResizeToContents);
+	mpTree->header()->setStretchLastSection(true);
+
+	mpStatus = new QLabel(this);
+
+	QDialogButtonBox *p_button_box = new QDialogButtonBox(QDialogButtonBox::Close, this);
+	mpButtonRevalidate = p_button_box->addButton(tr("&Revalidate"), QDialogButtonBox::ActionRole);
+
+	QGridLayout *p_layout = new QGridLayout();
+	p_layout->addWidget(mpTree, 0, 0, 1, 2);
+	p_layout->addWidget(mpStatus, 1, 0, 1, 1);
+	p_layout->addWidget(p_button_box, 1, 1, 1, 1);
+	setLayout(p_layout);
+
+	connect(mpButtonRevalidate, SIGNAL(clicked()), this, SLOT(Validate()));
+	connect(p_button_box, SIGNAL(rejected()), this, SLOT(close()));
+}
+
+void WidgetXmlValidation::Validate() {
+
+	if(mpService->IsRunning() == true) return;
+	mpTree->clear();
+	mpService->Clear();
+	mValidatedCount = 0;
+	mValidCount = 0;
+	mpButtonRevalidate->setDisabled(true);
+	UpdateStatus();
+	if(mFiles.isEmpty() == false) mpService->Validate(mFiles);
+	else rFinished();
+}
+
+void WidgetXmlValidation::rDocumentValidated(const XmlValidationResult &rResult) {
+
+	mValidatedCount++;
+	QTreeWidgetItem *p_document_item = new QTreeWidgetItem(mpTree);
+	p_document_item->setText(ColumnDocument, QFileInfo(rResult.filePath).fileName());
+	p_document_item->setToolTip(ColumnDocument, rResult.filePath);
+	QString status;
+	if(rResult.error.IsError() == true) status = QString("%1 %2").arg(rResult.error.GetErrorMsg()).arg(rResult.error.GetErrorDescription());
+	else if(rResult.IsValid() == true) status = tr("Valid");
+	else status = tr("%n error(s)", "", rResult.GetErrorCount());
+	if(rResult.fromCache == true) status.append(tr(" (unchanged)"));
+	p_document_item->setText(ColumnMessage, status);
+	if(rResult.IsValid() == true) {
+		mValidCount++;
+		p_document_item->setForeground(ColumnMessage, QBrush(Qt::darkGreen));
+	}
+	else p_document_item->setForeground(ColumnMessage, QBrush(Qt::red));
+
+	for(int i = 0; i < rResult.diagnostics.size(); i++) {
+		const XmlDiagnostic &r_diagnostic = rResult.diagnostics.at(i);
+		QTreeWidgetItem *p_item = new QTreeWidgetItem(p_document_item);
+		if(r_diagnostic.line > 0) {
+			p_item->setText(ColumnLine, QString::number(r_diagnostic.line));
+			p_item->setText(ColumnColumn, QString::number(r_diagnostic.column));
+		}
+		p_item->setText(ColumnMessage, r_diagnostic.message);
+		p_item->setToolTip(ColumnMessage, r_diagnostic.message);
+		if(r_diagnostic.severity != XmlDiagnostic::Warning) p_item->setForeground(ColumnMessage, QBrush(Qt::red));
+	}
+	if(rResult.IsValid() == false) p_document_item->setExpanded(true);
+	UpdateStatus();
+}
+
+void WidgetXmlValidation::rFinished() {
+
+	mpButtonRevalidate->setEnabled(true);
+	UpdateStatus();
+}
+
+void WidgetXmlValidation::UpdateStatus() {
+
+	if(mpService->IsRunning() == true) mpStatus->setText(tr("Validating... %1 of %2 documents").arg(mValidatedCount).arg(mFiles.size()));
+	else mpStatus->setText(tr("%1 of %2 documents valid").arg(mValidCount).arg(mFiles.size()));
+}
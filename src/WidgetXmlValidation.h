@@ -0,0 +1,64 @@
+/* Copyright(C) 2016 Björn Stresing, Denis Manthey, Wolfgang Ruppel
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include "XmlValidationService.h"
+#include <QWidget>
+#include <QStringList>
+
+
+class QTreeWidget;
+class QLabel;
+class QPushButton;
+
+/*! \brief Shows the schema validation results of IMP XML documents.
+Documents are validated concurrently by XmlValidationService, results are added as they arrive.
+*/
+class WidgetXmlValidation : public QWidget {
+
+	Q_OBJECT
+
+public:
+	enum eColumn {
+		ColumnDocument = 0,
+		ColumnLine,
+		ColumnColumn,
+		ColumnMessage,
+		ColumnMax
+	};
+	WidgetXmlValidation(const QStringList &rFiles, QWidget *pParent = NULL);
+	virtual ~WidgetXmlValidation() {}
+	virtual QSize sizeHint() const;
+
+	public slots:
+	void Validate();
+
+	private slots:
+	void rDocumentValidated(const XmlValidationResult &rResult);
+	void rFinished();
+
+private:
+	Q_DISABLE_COPY(WidgetXmlValidation);
+	void InitLayout();
+	void UpdateStatus();
+
+	XmlValidationService *mpService;
+	const QStringList mFiles;
+	QTreeWidget *mpTree;
+	QLabel *mpStatus;
+	QPushButton *mpButtonRevalidate;
+	int mValidatedCount;
+	int mValidCount;
+};
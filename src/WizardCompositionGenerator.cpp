@@ -20,6 +20,9 @@
 #include <QLabel>
 #include <QStringListModel>
 #include <QLineEdit>
+#include <QPushButton>
+#include <QFileDialog>
+#include <QFileInfo>
 
 
 WizardCompositionGenerator::WizardCompositionGenerator(QWidget *pParent /*= NULL*/) :
@@ -99,3 +102,95 @@ EditRate WizardCompositionGeneratorPage::GetEditRate() const {
 
 	return EditRate::GetEditRate(mpComboBoxEditRate->currentText());
 }
+
+WizardCplVariantGenerator::WizardCplVariantGenerator(const QStringList &rTemplates, QWidget *pParent /*= NULL*/) :
+QWizard(pParent), mpPage(NULL) {
+
+	setSizePolicy(QSizePolicy::Preferred, QSizePolicy::Preferred);
+	setWindowModality(Qt::WindowModal);
+	setWindowTitle(tr("CPL Variant Generator"));
+	setWizardStyle(QWizard::ModernStyle);
+	setStyleSheet("QWizard QPushButton {min-width: 60 px;}");
+	mpPage = new WizardCplVariantGeneratorPage(rTemplates, this);
+	addPage(mpPage);
+	QList<QWizard::WizardButton> layout;
+	layout << QWizard::Stretch << QWizard::CancelButton << QWizard::FinishButton;
+	setButtonLayout(layout);
+}
+
+QSize WizardCplVariantGenerator::sizeHint() const {
+
+	return QSize(600, 300);
+}
+
+QString WizardCplVariantGenerator::GetTemplate() const {
+
+	return mpPage->GetTemplate();
+}
+
+QList<JobGenerateCplVariants::Variant> WizardCplVariantGenerator::GetVariants() const {
+
+	return mpPage->GetVariants();
+}
+
+WizardCplVariantGeneratorPage::WizardCplVariantGeneratorPage(const QStringList &rTemplates, QWidget *pParent /*= NULL*/) :
+QWizardPage(pParent), mpComboBoxTemplate(NULL), mpLineEditTable(NULL), mpLabelStatus(NULL), mVariants() {
+
+	setTitle(tr("Generate Composition Playlist Variants"));
+	setSubTitle(tr("Every row of the substitution table becomes a copy of the template with its own title and track files."));
+	InitLayout(rTemplates);
+}
+
+void WizardCplVariantGeneratorPage::InitLayout(const QStringList &rTemplates) {
+
+	mpComboBoxTemplate = new QComboBox(this);
+	for(int i = 0; i < rTemplates.size(); i++) mpComboBoxTemplate->addItem(QFileInfo(rTemplates.at(i)).fileName(), rTemplates.at(i));
+
+	mpLineEditTable = new QLineEdit(this);
+	mpLineEditTable->setPlaceholderText(tr("--CSV file: a ContentTitle column and one column per template track file Id--"));
+	mpLineEditTable->setWhatsThis(tr("The header names the column ContentTitle and the Ids of the template track files that are replaced. Every other row is a variant. Empty cells keep the template track file."));
+	QPushButton *p_button_browse = new QPushButton(tr("Browse"), this);
+	mpLabelStatus = new QLabel(this);
+	mpLabelStatus->setWordWrap(true);
+
+	QGridLayout *p_layout = new QGridLayout();
+	p_layout->addWidget(new QLabel(tr("Template CPL:"), this), 0, 0, 1, 1);
+	p_layout->addWidget(mpComboBoxTemplate, 0, 1, 1, 2);
+	p_layout->addWidget(new QLabel(tr("Substitution table:"), this), 1, 0, 1, 1);
+	p_layout->addWidget(mpLineEditTable, 1, 1, 1, 1);
+	p_layout->addWidget(p_button_browse, 1, 2, 1, 1);
+	p_layout->addWidget(mpLabelStatus, 2, 0, 1, 3);
+	setLayout(p_layout);
+
+	connect(p_button_browse, SIGNAL(clicked()), this, SLOT(rBrowse()));
+	connect(mpLineEditTable, SIGNAL(textChanged(const QString&)), this, SLOT(rTableChanged(const QString&)));
+}
+
+bool WizardCplVariantGeneratorPage::isComplete() const {
+
+	return mpComboBoxTemplate->currentIndex() >= 0 && mVariants.isEmpty() == false;
+}
+
+QString WizardCplVariantGeneratorPage::GetTemplate() const {
+
+	return mpComboBoxTemplate->currentData().toString();
+}
+
+void WizardCplVariantGeneratorPage::rBrowse() {
+
+	QString file_path = QFileDialog::getOpenFileName(this, tr("Select Substitution Table"), QFileInfo(GetTemplate()).absolutePath(), tr("Tables (*.csv *.tsv *.txt);;All Files (*)"));
+	if(file_path.isEmpty() == false) mpLineEditTable->setText(file_path);
+}
+
+void WizardCplVariantGeneratorPage::rTableChanged(const QString &rFilePath) {
+
+	mVariants.clear();
+	if(rFilePath.isEmpty() == true) mpLabelStatus->clear();
+	else if(QFileInfo(rFilePath).isFile() == false) mpLabelStatus->setText(tr("File not found."));
+	else {
+		Error error = JobGenerateCplVariants::ParseSubstitutionTable(rFilePath, mVariants);
+		if(error.IsError() == true) mpLabelStatus->setText(QString("%1: %2").arg(error.GetErrorMsg()).arg(error.GetErrorDescription()));
+		else mpLabelStatus->setText(tr("%n variant(s)", "", mVariants.size()));
+	}
+	emit completeChanged();
+}
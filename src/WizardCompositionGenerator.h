@@ -15,11 +15,15 @@
  */
 #pragma once
 #include "ImfCommon.h"
+#include "Jobs.h"
 #include <QWizard>
 #include <QWizardPage>
 
 
 class QComboBox;
+class QLineEdit;
+class QLabel;
+class WizardCplVariantGeneratorPage;
 
 class WizardCompositionGenerator : public QWizard {
 
@@ -57,3 +61,49 @@ private:
 
 	QComboBox *mpComboBoxEditRate;
 };
+
+
+//! Generates variants of a template CPL from a substitution table (see JobGenerateCplVariants::ParseSubstitutionTable()).
+class WizardCplVariantGenerator : public QWizard {
+
+	Q_OBJECT
+
+public:
+	//! rTemplates are the file paths of the CPLs the user can choose the template from.
+	WizardCplVariantGenerator(const QStringList &rTemplates, QWidget *pParent = NULL);
+	virtual ~WizardCplVariantGenerator() {}
+	virtual QSize sizeHint() const;
+	QString GetTemplate() const;
+	QList<JobGenerateCplVariants::Variant> GetVariants() const;
+
+private:
+	Q_DISABLE_COPY(WizardCplVariantGenerator);
+
+	WizardCplVariantGeneratorPage *mpPage;
+};
+
+
+class WizardCplVariantGeneratorPage : public QWizardPage {
+
+	Q_OBJECT
+
+public:
+	WizardCplVariantGeneratorPage(const QStringList &rTemplates, QWidget *pParent = NULL);
+	virtual ~WizardCplVariantGeneratorPage() {}
+	virtual bool isComplete() const;
+	QString GetTemplate() const;
+	QList<JobGenerateCplVariants::Variant> GetVariants() const { return mVariants; }
+
+	private slots:
+	void rBrowse();
+	void rTableChanged(const QString &rFilePath);
+
+private:
+	Q_DISABLE_COPY(WizardCplVariantGeneratorPage);
+	void InitLayout(const QStringList &rTemplates);
+
+	QComboBox *mpComboBoxTemplate;
+	QLineEdit *mpLineEditTable;
+	QLabel *mpLabelStatus;
+	QList<JobGenerateCplVariants::Variant> mVariants;
+};
@@ -19,6 +19,7 @@
 #include "QtWaitingSpinner.h"
 #include "MetadataExtractor.h"
 #include "DelegateComboBox.h"
+#include "ImageSequence.h"
 #include <QFileDialog>
 #include <QLabel>
 #include <QStringList>
@@ -79,10 +80,10 @@ void WizardResourceGenerator::SwitchMode(eMode mode) {
 
 WizardResourceGeneratorPage::WizardResourceGeneratorPage(QWidget *pParent /*= NULL*/) :
 QWizardPage(pParent), mpFileDialog(NULL), mpSoundFieldGroupModel(NULL), mpTimedTextModel(NULL), mpTableViewExr(NULL), mpTableViewWav(NULL), mpTableViewTimedText(NULL), mpProxyImageWidget(NULL), mpStackedLayout(NULL), mpComboBoxEditRate(NULL),
-mpComboBoxSoundfieldGroup(NULL), mpMsgBox(NULL), mpAs02Wrapper(NULL), mpLineEditDuration(NULL) {
+mpComboBoxSoundfieldGroup(NULL), mpMsgBox(NULL), mpAs02Wrapper(NULL), mpLineEditDuration(NULL), mImageSequenceFiles() {
 	mpAs02Wrapper = new MetadataExtractor(this);
 	setTitle(tr("Edit Resource"));
-	setSubTitle(tr("Select  a single (multichannel) wav file or IMSC1/TTML1 file that should build a resource."));
+	setSubTitle(tr("Select  a single (multichannel) wav file, IMSC1/TTML1 file or JPEG 2000 codestream sequence that should build a resource."));
 	InitLayout();
 }
 
@@ -95,7 +96,7 @@ void WizardResourceGeneratorPage::InitLayout() {
 	mpFileDialog = new QFileDialog(this, QString(), QDir::homePath());
 	mpFileDialog->setFileMode(QFileDialog::ExistingFiles);
 	mpFileDialog->setViewMode(QFileDialog::Detail);
-	mpFileDialog->setNameFilters(QStringList() << "*.exr" << "*.wav" << "*.ttml");
+	mpFileDialog->setNameFilters(QStringList() << "*.exr" << "*.j2c" << "*.wav" << "*.ttml");
 	mpFileDialog->setIconProvider(new IconProviderExrWav(this)); // TODO: Does not work.
 
 	mpProxyImageWidget = new WidgetProxyImage(this);
@@ -290,7 +291,20 @@ void WizardResourceGeneratorPage::GenerateEmptyTimedText(){
 		mpLineEditFileDir->clear();
 	}
 	else {
-		mpEmptyTt = new EmptyTimedTextGenerator(filePath.at(0), dur);
+		Error error;
+		const QByteArray document = EmptyTimedTextGenerator::Generate(dur, "en", IMSC1_TEXT_PROFILE);
+		QFile document_file(filePath.at(0));
+		if(document.isEmpty() == true) error = Error(Error::Unknown, tr("Couldn't generate empty timed text document."));
+		else if(document_file.open(QIODevice::WriteOnly) == false || document_file.write(document) != document.size()) error = Error(Error::DestinationFileOpenError, filePath.at(0));
+		document_file.close();
+		if(error.IsError() == true) {
+			mpMsgBox->setText(tr("Error"));
+			mpMsgBox->setInformativeText(QString("%1\n%2").arg(error.GetErrorMsg()).arg(error.GetErrorDescription()));
+			mpMsgBox->setStandardButtons(QMessageBox::Ok);
+			mpMsgBox->setDefaultButton(QMessageBox::Ok);
+			mpMsgBox->exec();
+			return;
+		}
 		Metadata metadata;
 		mpAs02Wrapper->ReadMetadata(metadata, filePath.at(0));
 		mpTimedTextModel->SetFile(filePath);
@@ -412,6 +426,22 @@ void WizardResourceGeneratorPage::SetSourceFiles(const QStringList &rFiles) {
 			emit FilesListChanged();
 		}
 		/* -----Denis Manthey----- */
+		else if(is_j2c_file(rFiles.at(0))) {
+			// The codestream headers are checked by JobWrapJ2c. Only the numbering is checked here.
+			QStringList frames;
+			Error error = ImageSequence::Scan(rFiles, "j2c", frames);
+			if(error.IsError()) {
+				mpMsgBox->setText(error.GetErrorMsg());
+				mpMsgBox->setInformativeText(error.GetErrorDescription());
+				mpMsgBox->setStandardButtons(QMessageBox::Ok);
+				mpMsgBox->setDefaultButton(QMessageBox::Ok);
+				mpMsgBox->exec();
+				return;
+			}
+			mImageSequenceFiles = frames;
+			SwitchMode(WizardResourceGenerator::ExrMode);
+			emit FilesListChanged();
+		}
 
 
 	}
@@ -434,6 +464,9 @@ QStringList WizardResourceGeneratorPage::GetFilesList() const {
 		/* -----Denis Manthey----- */
 
 
+	else if(mpStackedLayout->currentIndex() == WizardResourceGeneratorPage::ExrIndex) {
+		return mImageSequenceFiles;
+	}
 	return QStringList();
 }
 
@@ -518,11 +551,11 @@ void WizardResourceGeneratorPage::SwitchMode(WizardResourceGenerator::eMode mode
 	switch(mode) {
 		case WizardResourceGenerator::ExrMode:
 			mpStackedLayout->setCurrentIndex(ExrIndex);
-			mpFileDialog->setNameFilters(QStringList() << "*.exr" << "*.wav" << "*.ttml");
+			mpFileDialog->setNameFilters(QStringList() << "*.exr" << "*.j2c" << "*.wav" << "*.ttml");
 			break;
 		case WizardResourceGenerator::WavMode:
 			mpStackedLayout->setCurrentIndex(WavIndex);
-			mpFileDialog->setNameFilters(QStringList() << "*.wav" << "*.exr" << "*.ttml");
+			mpFileDialog->setNameFilters(QStringList() << "*.wav" << "*.exr" << "*.j2c" << "*.ttml");
 			break;
 
 
@@ -128,7 +128,7 @@ private:
 	QPushButton *mpGenerateEmpty_button;
 	QMessageBox	*mpMsgBox;
 	MetadataExtractor *mpAs02Wrapper;
-	EmptyTimedTextGenerator *mpEmptyTt;
+	QStringList mImageSequenceFiles; // JPEG 2000 codestream sequence
 	QGroupBox *mpGroupBox;
 	bool mGroupBoxCheck;
 };
@@ -25,7 +25,8 @@
 #include <QWizardPage>
 #include <QFileDialog>
 #include <QCompleter>
-#include <QDirModel>
+#include <QFileSystemModel>
+#include <QListWidget>
 
 
 WizardWorkspaceLauncher::WizardWorkspaceLauncher(QWidget *pParent /*= NULL*/) :
@@ -45,11 +46,11 @@ QWizard(pParent) {
 
 QSize WizardWorkspaceLauncher::sizeHint() const {
 
-	return QSize(600, 300);
+	return QSize(600, 420);
 }
 
 WizardWorkspaceLauncherPage::WizardWorkspaceLauncherPage(QWidget *pParent /*= NULL*/) :
-QWizardPage(pParent), mpFileDialog(NULL), mpLineEdit(NULL) {
+QWizardPage(pParent), mpFileDialog(NULL), mpLineEdit(NULL), mpReferenceList(NULL) {
 
 	setTitle(tr("Open IMF package"));
 	setSubTitle(tr("Please select the root directory of an existing IMF package. The root directory is the directory where the ASSETMAP.xml file is located."));
@@ -58,28 +59,68 @@ QWizardPage(pParent), mpFileDialog(NULL), mpLineEdit(NULL) {
 
 void WizardWorkspaceLauncherPage::InitLayout() {
 
-	mpFileDialog = new QFileDialog(this, QString(), QDir::homePath());
-	mpFileDialog->setFileMode(QFileDialog::Directory);
-	mpFileDialog->setViewMode(QFileDialog::Detail);
 	mpLineEdit = new QLineEdit(this);
 	mpLineEdit->setWhatsThis("You can select the root dir using the directory browser or enter the absolute path directly.");
 	mpLineEdit->setPlaceholderText(tr("--Select IMF package root directory--"));
 	QCompleter *p_completer = new QCompleter(this);
-	p_completer->setModel(new QDirModel(QStringList(), QDir::AllDirs | QDir::NoDotAndDotDot, QDir::NoSort, p_completer));
+	// QFileSystemModel gathers the directory entries in a worker thread.
+	QFileSystemModel *p_completer_model = new QFileSystemModel(p_completer);
+	p_completer_model->setFilter(QDir::AllDirs | QDir::NoDotAndDotDot);
+	p_completer_model->setRootPath(QString());
+	p_completer->setModel(p_completer_model);
 	p_completer->setCompletionMode(QCompleter::UnfilteredPopupCompletion);
 	mpLineEdit->setCompleter(p_completer);
 	QPushButton *p_button_browse = new QPushButton(tr("Browse"), this);
 	p_button_browse->setAutoDefault(false);
+	mpReferenceList = new QListWidget(this);
+	mpReferenceList->setWhatsThis(tr("Packages whose track files the compositions of the workspace reference, e.g. the OV of a supplemental package. Reference packages are read only. Track files listed by several packages are read once."));
+	mpReferenceList->setSelectionMode(QAbstractItemView::ExtendedSelection);
+	QPushButton *p_button_add_reference = new QPushButton(tr("Add"), this);
+	p_button_add_reference->setAutoDefault(false);
+	QPushButton *p_button_remove_reference = new QPushButton(tr("Remove"), this);
+	p_button_remove_reference->setAutoDefault(false);
 	QGridLayout *p_layout = new QGridLayout();
 	p_layout->addWidget(new QLabel(tr("Workspace:"), this), 0, 0, 1, 1);
 	p_layout->addWidget(mpLineEdit, 0, 1, 1, 1);
 	p_layout->addWidget(p_button_browse, 0, 2, 1, 1);
+	p_layout->addWidget(new QLabel(tr("Reference packages (optional):"), this), 1, 0, 1, 1, Qt::AlignTop);
+	p_layout->addWidget(mpReferenceList, 1, 1, 3, 1);
+	p_layout->addWidget(p_button_add_reference, 1, 2, 1, 1);
+	p_layout->addWidget(p_button_remove_reference, 2, 2, 1, 1);
+	p_layout->setRowStretch(3, 1);
 	setLayout(p_layout);
 
 	registerField(FIELD_NAME_WORKING_DIR"*", mpLineEdit);
+	registerField(FIELD_NAME_REFERENCE_DIRS, this, "ReferenceDirsSelected", SIGNAL(ReferenceDirsChanged()));
 
-	connect(p_button_browse, SIGNAL(clicked()), mpFileDialog, SLOT(show()));
-	connect(mpFileDialog, SIGNAL(fileSelected(const QString &)), this, SLOT(rFileSelected(const QString &)));
+	connect(p_button_browse, SIGNAL(clicked()), this, SLOT(rBrowse()));
+	connect(p_button_add_reference, SIGNAL(clicked()), this, SLOT(rAddReferenceDir()));
+	connect(p_button_remove_reference, SIGNAL(clicked()), this, SLOT(rRemoveReferenceDir()));
+}
+
+QStringList WizardWorkspaceLauncherPage::GetReferenceDirs() const {
+
+	QStringList dirs;
+	for(int i = 0; i < mpReferenceList->count(); i++) dirs << mpReferenceList->item(i)->text();
+	return dirs;
+}
+
+void WizardWorkspaceLauncherPage::rAddReferenceDir() {
+
+	QString dir = QFileDialog::getExistingDirectory(this, tr("Select the root directory of a reference package"), QDir::homePath());
+	if(dir.isEmpty() == false && GetReferenceDirs().contains(dir) == false) {
+		mpReferenceList->addItem(dir);
+		emit ReferenceDirsChanged();
+	}
+}
+
+void WizardWorkspaceLauncherPage::rRemoveReferenceDir() {
+
+	QList<QListWidgetItem*> items = mpReferenceList->selectedItems();
+	if(items.isEmpty() == false) {
+		qDeleteAll(items);
+		emit ReferenceDirsChanged();
+	}
 }
 
 void WizardWorkspaceLauncherPage::rFileSelected(const QString &rFile) {
@@ -87,6 +128,17 @@ void WizardWorkspaceLauncherPage::rFileSelected(const QString &rFile) {
 	mpLineEdit->setText(rFile);
 }
 
+void WizardWorkspaceLauncherPage::rBrowse() {
+
+	if(mpFileDialog == NULL) {
+		mpFileDialog = new QFileDialog(this, QString(), QDir::homePath());
+		mpFileDialog->setFileMode(QFileDialog::Directory);
+		mpFileDialog->setViewMode(QFileDialog::Detail);
+		connect(mpFileDialog, SIGNAL(fileSelected(const QString &)), this, SLOT(rFileSelected(const QString &)));
+	}
+	mpFileDialog->show();
+}
+
 WizardWorkspaceLauncherNewImpPage::WizardWorkspaceLauncherNewImpPage(QWidget *pParent /*= NULL*/) :
 	QWizardPage(pParent), mpFileDialog(NULL), mpLineEdit(NULL) {
 
@@ -97,14 +149,15 @@ WizardWorkspaceLauncherNewImpPage::WizardWorkspaceLauncherNewImpPage(QWidget *pP
 
 void WizardWorkspaceLauncherNewImpPage::InitLayout() {
 
-	mpFileDialog = new QFileDialog(this, QString(), QDir::homePath());
-	mpFileDialog->setFileMode(QFileDialog::Directory);
-	mpFileDialog->setViewMode(QFileDialog::Detail);
 	mpLineEdit = new QLineEdit(this);
 	mpLineEdit->setWhatsThis("You can select the root dir using the directory browser or enter the absolute path directly.");
 	mpLineEdit->setPlaceholderText(tr("--Select IMF package root directory--"));
 	QCompleter *p_completer = new QCompleter(this);
-	p_completer->setModel(new QDirModel(QStringList(), QDir::AllDirs | QDir::NoDotAndDotDot, QDir::NoSort, p_completer));
+	// QFileSystemModel gathers the directory entries in a worker thread.
+	QFileSystemModel *p_completer_model = new QFileSystemModel(p_completer);
+	p_completer_model->setFilter(QDir::AllDirs | QDir::NoDotAndDotDot);
+	p_completer_model->setRootPath(QString());
+	p_completer->setModel(p_completer_model);
 	p_completer->setCompletionMode(QCompleter::UnfilteredPopupCompletion);
 	mpLineEdit->setCompleter(p_completer);
 	QPushButton *p_button_browse = new QPushButton(tr("Browse"), this);
@@ -129,11 +182,21 @@ void WizardWorkspaceLauncherNewImpPage::InitLayout() {
 	registerField(FIELD_NAME_ISSUER"*", p_issuer);
 	registerField(FIELD_NAME_ANNOTATION"", p_annotation_text);
 
-	connect(p_button_browse, SIGNAL(clicked()), mpFileDialog, SLOT(show()));
-	connect(mpFileDialog, SIGNAL(fileSelected(const QString &)), this, SLOT(rFileSelected(const QString &)));
+	connect(p_button_browse, SIGNAL(clicked()), this, SLOT(rBrowse()));
 }
 
 void WizardWorkspaceLauncherNewImpPage::rFileSelected(const QString &rFile) {
 
 	mpLineEdit->setText(rFile);
 }
+
+void WizardWorkspaceLauncherNewImpPage::rBrowse() {
+
+	if(mpFileDialog == NULL) {
+		mpFileDialog = new QFileDialog(this, QString(), QDir::homePath());
+		mpFileDialog->setFileMode(QFileDialog::Directory);
+		mpFileDialog->setViewMode(QFileDialog::Detail);
+		connect(mpFileDialog, SIGNAL(fileSelected(const QString &)), this, SLOT(rFileSelected(const QString &)));
+	}
+	mpFileDialog->show();
+}
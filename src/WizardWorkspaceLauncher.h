@@ -15,11 +15,13 @@
  */
 #pragma once
 #include <QWizard>
+#include <QStringList>
 
 
 class QLineEdit;
 class QDialogButtonBox;
 class QFileDialog;
+class QListWidget;
 
 class WizardWorkspaceLauncher : public QWizard {
 
@@ -38,13 +40,23 @@ private:
 class WizardWorkspaceLauncherPage : public QWizardPage {
 
 	Q_OBJECT
+		Q_PROPERTY(QStringList ReferenceDirsSelected READ GetReferenceDirs NOTIFY ReferenceDirsChanged)
 
 public:
 	WizardWorkspaceLauncherPage(QWidget *pParent = NULL);
 	virtual ~WizardWorkspaceLauncherPage() {}
+	//! Root directories of the read only reference packages, e.g. the OV of a supplemental package (see ImfWorkspace).
+	QStringList GetReferenceDirs() const;
+
+signals:
+	void ReferenceDirsChanged();
 
 	private slots:
 	void rFileSelected(const QString &rFile);
+	//! The file dialog is created on first use.
+	void rBrowse();
+	void rAddReferenceDir();
+	void rRemoveReferenceDir();
 
 private:
 	Q_DISABLE_COPY(WizardWorkspaceLauncherPage);
@@ -52,6 +64,7 @@ private:
 
 	QFileDialog *mpFileDialog;
 	QLineEdit		*mpLineEdit;
+	QListWidget *mpReferenceList;
 };
 
 
@@ -65,6 +78,8 @@ public:
 
 	private slots:
 	void rFileSelected(const QString &rFile);
+	//! The file dialog is created on first use.
+	void rBrowse();
 
 private:
 	Q_DISABLE_COPY(WizardWorkspaceLauncherNewImpPage);
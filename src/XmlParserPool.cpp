@@ -0,0 +1,270 @@
+/* Copyright(C) 2016 Björn Stresing, Denis Manthey, Wolfgang Ruppel
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "XmlParserPool.h"
+#include "Trace.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QRegExp>
+#include <QMutexLocker>
+#include <QDebug>
+#include <xercesc/util/PlatformUtils.hpp>
+#include <xercesc/util/XMLException.hpp>
+#include <xercesc/util/OutOfMemoryException.hpp>
+#include <xercesc/parsers/XercesDOMParser.hpp>
+#include <xercesc/framework/LocalFileInputSource.hpp>
+#include <xercesc/framework/MemBufInputSource.hpp>
+#include <xercesc/framework/XMLGrammarPoolImpl.hpp>
+#include <xercesc/validators/common/Grammar.hpp>
+#include <xercesc/sax/ErrorHandler.hpp>
+#include <xercesc/sax/SAXParseException.hpp>
+#include <xercesc/dom/DOMException.hpp>
+
+
+namespace {
+
+// Any schema of the tree, used to recognize the xsd directory.
+const char *schema_probe = "SMPTE-2067-3-2013-CPL.xsd";
+
+QString to_qstring(const XMLCh *pString) {
+
+	if(pString == NULL) return QString();
+	return QString::fromUtf16(reinterpret_cast<const ushort*>(pString));
+}
+
+//! Looks for the xsd directory next to the executable and in up to three parent directories (build tree).
+QString locate_schema_directory() {
+
+	QDir dir(QCoreApplication::applicationDirPath());
+	for(int i = 0; i < 4; i++) {
+		if(QFileInfo(dir.absoluteFilePath(QString("xsd/") + schema_probe)).exists() == true) return dir.absoluteFilePath("xsd");
+		if(dir.cdUp() == false) break;
+	}
+	return QString();
+}
+
+//! Cheap look-up of the targetNamespace attribute of a schema document without parsing it.
+QString read_target_namespace(const QString &rSchemaPath) {
+
+	QFile file(rSchemaPath);
+	if(file.open(QIODevice::ReadOnly) == false) return QString();
+	QRegExp target_namespace("targetNamespace\\s*=\\s*[\"']([^\"']*)[\"']");
+	if(target_namespace.indexIn(QString::fromUtf8(file.read(16 * 1024))) < 0) return QString();
+	return target_namespace.cap(1);
+}
+
+//! Collects the diagnostics of a single parse. Never throws so the parser recovers from validation errors.
+class DiagnosticCollector : public xercesc::ErrorHandler {
+
+public:
+	DiagnosticCollector(QList<XmlDiagnostic> *pDiagnostics) : mpDiagnostics(pDiagnostics), mErrorCount(0), mFirstError() {}
+	virtual ~DiagnosticCollector() {}
+	virtual void warning(const xercesc::SAXParseException &rException) { Add(XmlDiagnostic::Warning, rException); }
+	virtual void error(const xercesc::SAXParseException &rException) { Add(XmlDiagnostic::RecoverableError, rException); }
+	virtual void fatalError(const xercesc::SAXParseException &rException) { Add(XmlDiagnostic::FatalError, rException); }
+	virtual void resetErrors() {}
+	void Add(const XmlDiagnostic &rDiagnostic) {
+
+		if(rDiagnostic.severity != XmlDiagnostic::Warning) {
+			if(mErrorCount == 0) mFirstError = rDiagnostic;
+			mErrorCount++;
+		}
+		if(mpDiagnostics) mpDiagnostics->push_back(rDiagnostic);
+	}
+	int GetErrorCount() const { return mErrorCount; }
+	QString GetFirstErrorDescription() const {
+
+		if(mFirstError.line > 0) return QString("%1 (line %2, column %3): %4").arg(mFirstError.systemId).arg(mFirstError.line).arg(mFirstError.column).arg(mFirstError.message);
+		return QString("%1: %2").arg(mFirstError.systemId).arg(mFirstError.message);
+	}
+
+private:
+	Q_DISABLE_COPY(DiagnosticCollector);
+	void Add(XmlDiagnostic::eSeverity severity, const xercesc::SAXParseException &rException) {
+
+		XmlDiagnostic diagnostic;
+		diagnostic.severity = severity;
+		diagnostic.line = rException.getLineNumber();
+		diagnostic.column = rException.getColumnNumber();
+		diagnostic.systemId = to_qstring(rException.getSystemId());
+		diagnostic.message = to_qstring(rException.getMessage());
+		Add(diagnostic);
+	}
+	QList<XmlDiagnostic> *mpDiagnostics;
+	int mErrorCount;
+	XmlDiagnostic mFirstError;
+};
+}
+
+XmlParserPool& XmlParserPool::Instance() {
+
+	static XmlParserPool pool;
+	return pool;
+}
+
+XmlParserPool::XmlParserPool() :
+mMutex(), mpGrammarPool(NULL), mParsers(), mIdleParsers(), mSchemaDirectory(), mSchemaNamespaces() {
+
+	// Reference counted by Xerces. Balanced in the destructor.
+	xercesc::XMLPlatformUtils::Initialize();
+	mpGrammarPool = new xercesc::XMLGrammarPoolImpl(xercesc::XMLPlatformUtils::fgMemoryManager);
+	LoadGrammars();
+}
+
+XmlParserPool::~XmlParserPool() {
+
+	// Parsers reference the grammar pool.
+	qDeleteAll(mParsers);
+	mParsers.clear();
+	mIdleParsers.clear();
+	delete mpGrammarPool;
+	xercesc::XMLPlatformUtils::Terminate();
+}
+
+void XmlParserPool::LoadGrammars() {
+
+	TRACE_SPAN("XmlParserPool::LoadGrammars", "xml");
+	mSchemaDirectory = locate_schema_directory();
+	if(mSchemaDirectory.isEmpty() == false) {
+		xercesc::XercesDOMParser loader(NULL, xercesc::XMLPlatformUtils::fgMemoryManager, mpGrammarPool);
+		DiagnosticCollector collector(NULL);
+		loader.setErrorHandler(&collector);
+		loader.setDoNamespaces(true);
+		loader.setDoSchema(true);
+		loader.setLoadExternalDTD(false);
+		loader.setHandleMultipleImports(true);
+		loader.useCachedGrammarInParse(true);
+		QDir schema_dir(mSchemaDirectory);
+		QStringList schemas = schema_dir.entryList(QStringList() << "*.xsd", QDir::Files, QDir::Name);
+		for(int i = 0; i < schemas.size(); i++) {
+			const QString schema_path = QDir::toNativeSeparators(schema_dir.absoluteFilePath(schemas.at(i)));
+			// Imported schemas are compiled along with the importing schema. Compiling them twice would fail.
+			if(mSchemaNamespaces.contains(read_target_namespace(schema_path)) == true) continue;
+			try {
+				xercesc::LocalFileInputSource source(reinterpret_cast<const XMLCh*>(schema_path.utf16()));
+				if(loader.loadGrammar(source, xercesc::Grammar::SchemaGrammarType, true) == NULL) qWarning() << "Couldn't compile XML schema" << schema_path;
+			}
+			catch(const xercesc::XMLException &e) { qWarning() << "Couldn't compile XML schema" << schema_path << to_qstring(e.getMessage()); }
+			catch(...) { qWarning() << "Couldn't compile XML schema" << schema_path; }
+			xercesc::RefHashTableOfEnumerator<xercesc::Grammar> grammars = mpGrammarPool->getGrammarEnumerator();
+			while(grammars.hasMoreElements()) mSchemaNamespaces.insert(to_qstring(grammars.nextElement().getTargetNamespace()));
+		}
+		if(collector.GetErrorCount() > 0) qWarning() << "XML schema compilation reported" << collector.GetErrorCount() << "errors, first:" << collector.GetFirstErrorDescription();
+	}
+	else qWarning() << "XML schema directory not found. Schema validation is unavailable.";
+	// A locked pool is read only and may be shared by parsers running concurrently.
+	mpGrammarPool->lockPool();
+}
+
+xsd::cxx::xml::dom::auto_ptr<xercesc::DOMDocument> XmlParserPool::Parse(const QString &rFilePath, Error &rError, eValidation validation /*= NoValidation*/, QList<XmlDiagnostic> *pDiagnostics /*= NULL*/) {
+
+	const QString native_path = QDir::toNativeSeparators(QFileInfo(rFilePath).absoluteFilePath());
+	xercesc::LocalFileInputSource source(reinterpret_cast<const XMLCh*>(native_path.utf16()));
+	return Parse(source, rFilePath, rError, validation, pDiagnostics);
+}
+
+xsd::cxx::xml::dom::auto_ptr<xercesc::DOMDocument> XmlParserPool::Parse(const QByteArray &rBuffer, const QString &rSystemId, Error &rError, eValidation validation /*= NoValidation*/, QList<XmlDiagnostic> *pDiagnostics /*= NULL*/) {
+
+	const QByteArray system_id = rSystemId.toUtf8();
+	xercesc::MemBufInputSource source(reinterpret_cast<const XMLByte*>(rBuffer.constData()), rBuffer.size(), system_id.constData(), false);
+	return Parse(source, rSystemId, rError, validation, pDiagnostics);
+}
+
+xsd::cxx::xml::dom::auto_ptr<xercesc::DOMDocument> XmlParserPool::Parse(xercesc::InputSource &rSource, const QString &rSystemId, Error &rError, eValidation validation, QList<XmlDiagnostic> *pDiagnostics) {
+
+	TRACE_SPAN_DETAIL("XmlParserPool::Parse", "xml", QFileInfo(rSystemId).fileName());
+	xsd::cxx::xml::dom::auto_ptr<xercesc::DOMDocument> document;
+	DiagnosticCollector collector(pDiagnostics);
+	xercesc::XercesDOMParser *p_parser = Acquire(validation);
+	p_parser->setErrorHandler(&collector);
+	XmlDiagnostic exception_diagnostic;
+	exception_diagnostic.severity = XmlDiagnostic::FatalError;
+	exception_diagnostic.systemId = rSystemId;
+	try {
+		p_parser->parse(rSource);
+	}
+	catch(const xercesc::XMLException &e) {
+		exception_diagnostic.message = to_qstring(e.getMessage());
+		collector.Add(exception_diagnostic);
+	}
+	catch(const xercesc::DOMException &e) {
+		exception_diagnostic.message = to_qstring(e.getMessage());
+		collector.Add(exception_diagnostic);
+	}
+	catch(const xercesc::OutOfMemoryException &) {
+		exception_diagnostic.message = "Out of memory";
+		collector.Add(exception_diagnostic);
+	}
+	catch(...) {
+		exception_diagnostic.message = "Unexpected exception";
+		collector.Add(exception_diagnostic);
+	}
+	if(collector.GetErrorCount() == 0 && p_parser->getDocument() != NULL) document.reset(p_parser->adoptDocument());
+	else if(collector.GetErrorCount() == 0) {
+		exception_diagnostic.message = "No document";
+		collector.Add(exception_diagnostic);
+	}
+	if(collector.GetErrorCount() > 0) rError = Error(Error::XMLSchemeError, collector.GetFirstErrorDescription());
+	p_parser->setErrorHandler(NULL);
+	Release(p_parser);
+	return document;
+}
+
+xercesc::XercesDOMParser* XmlParserPool::Acquire(eValidation validation) {
+
+	xercesc::XercesDOMParser *p_parser = NULL;
+	{
+		QMutexLocker locker(&mMutex);
+		if(mIdleParsers.isEmpty() == false) p_parser = mIdleParsers.takeLast();
+	}
+	if(p_parser == NULL) {
+		p_parser = new xercesc::XercesDOMParser(NULL, xercesc::XMLPlatformUtils::fgMemoryManager, mpGrammarPool);
+		p_parser->setDoNamespaces(true);
+		p_parser->setCreateCommentNodes(false);
+		p_parser->setCreateEntityReferenceNodes(false);
+		p_parser->setLoadExternalDTD(false);
+		// Only grammars from the locked pool are used.
+		p_parser->setLoadSchema(false);
+		p_parser->useCachedGrammarInParse(true);
+		p_parser->cacheGrammarFromParse(false);
+		QMutexLocker locker(&mMutex);
+		mParsers.push_back(p_parser);
+	}
+	if(validation == SchemaValidation) {
+		p_parser->setValidationScheme(xercesc::XercesDOMParser::Val_Always);
+		p_parser->setDoSchema(true);
+	}
+	else {
+		p_parser->setValidationScheme(xercesc::XercesDOMParser::Val_Never);
+		p_parser->setDoSchema(false);
+	}
+	return p_parser;
+}
+
+void XmlParserPool::Release(xercesc::XercesDOMParser *pParser) {
+
+	// Frees documents which weren't adopted.
+	pParser->resetDocumentPool();
+	QMutexLocker locker(&mMutex);
+	mIdleParsers.push_back(pParser);
+}
+
+int XmlParserPool::GetParserCount() const {
+
+	QMutexLocker locker(&mMutex);
+	return mParsers.size();
+}
@@ -0,0 +1,91 @@
+/* Copyright(C) 2016 Björn Stresing, Denis Manthey, Wolfgang Ruppel
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include "Error.h"
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QList>
+#include <QSet>
+#include <QMutex>
+#include <xercesc/dom/DOMDocument.hpp>
+#include <xsd/cxx/xml/dom/auto-ptr.hxx>
+
+
+XERCES_CPP_NAMESPACE_BEGIN
+class XercesDOMParser;
+class XMLGrammarPool;
+class InputSource;
+XERCES_CPP_NAMESPACE_END
+
+//! A warning or error reported by Xerces while parsing or validating a document.
+struct XmlDiagnostic {
+
+	enum eSeverity {
+		Warning = 0,
+		RecoverableError,
+		FatalError
+	};
+	XmlDiagnostic() : severity(Warning), line(0), column(0) {}
+	eSeverity severity;
+	quint64 line;
+	quint64 column;
+	QString systemId;
+	QString message;
+};
+
+/*! \brief Process wide pool of preconfigured Xerces DOM parsers.
+All schemas (*.xsd) found in the xsd directory are compiled once into a shared, locked XMLGrammarPool when the pool is created.
+A parser is handed out to one thread for the duration of a single parse and returned to the pool afterwards, so
+repeated parses neither set up a new parser nor compile a schema. The xsd directory is searched next to the executable
+and in its parent directories. Xerces is initialized by the pool. Parse() is thread safe.
+*/
+class XmlParserPool {
+
+public:
+	enum eValidation {
+		NoValidation = 0, //!< Well-formedness only (like xml_schema::Flags::dont_validate).
+		SchemaValidation //!< Validates against the cached grammars. Schemas referenced by the document are never loaded.
+	};
+	static XmlParserPool& Instance();
+	//! Parses a file. Returns a null pointer and sets rError (Error::XMLSchemeError) on failure. All warnings and errors are appended to pDiagnostics.
+	xsd::cxx::xml::dom::auto_ptr<xercesc::DOMDocument> Parse(const QString &rFilePath, Error &rError, eValidation validation = NoValidation, QList<XmlDiagnostic> *pDiagnostics = NULL);
+	//! Parses an in-memory document. rSystemId is used in diagnostics only.
+	xsd::cxx::xml::dom::auto_ptr<xercesc::DOMDocument> Parse(const QByteArray &rBuffer, const QString &rSystemId, Error &rError, eValidation validation = NoValidation, QList<XmlDiagnostic> *pDiagnostics = NULL);
+	//! Empty if the xsd directory wasn't found.
+	QString GetSchemaDirectory() const { return mSchemaDirectory; }
+	//! Target namespaces of all cached grammars.
+	QStringList GetSchemaNamespaces() const { return mSchemaNamespaces.toList(); }
+	bool HasSchema(const QString &rNamespace) const { return mSchemaNamespaces.contains(rNamespace); }
+	//! Number of parsers created so far (idle and in use).
+	int GetParserCount() const;
+
+private:
+	XmlParserPool();
+	~XmlParserPool();
+	Q_DISABLE_COPY(XmlParserPool);
+	void LoadGrammars();
+	xsd::cxx::xml::dom::auto_ptr<xercesc::DOMDocument> Parse(xercesc::InputSource &rSource, const QString &rSystemId, Error &rError, eValidation validation, QList<XmlDiagnostic> *pDiagnostics);
+	xercesc::XercesDOMParser* Acquire(eValidation validation);
+	void Release(xercesc::XercesDOMParser *pParser);
+
+	mutable QMutex mMutex;
+	xercesc::XMLGrammarPool *mpGrammarPool;
+	QList<xercesc::XercesDOMParser*> mParsers;
+	QList<xercesc::XercesDOMParser*> mIdleParsers;
+	QString mSchemaDirectory;
+	QSet<QString> mSchemaNamespaces;
+};
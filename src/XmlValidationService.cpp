@@ -0,0 +1,185 @@
+/* Copyright(C) 2016 Björn Stresing, Denis Manthey, Wolfgang Ruppel
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "XmlValidationService.h"
+#include "Trace.h"
+#include <QRunnable>
+#include <QThread>
+#include <QFile>
+#include <QCryptographicHash>
+#include <QMutexLocker>
+
+
+class XmlValidationTask : public QRunnable {
+
+public:
+	XmlValidationTask(XmlValidationService *pService, const QString &rFilePath) : QRunnable(), mpService(pService), mFilePath(rFilePath) {}
+	virtual ~XmlValidationTask() {}
+	virtual void run();
+
+private:
+	Q_DISABLE_COPY(XmlValidationTask);
+	XmlValidationService *mpService;
+	const QString mFilePath;
+};
+
+void XmlValidationTask::run() {
+
+	if(mpService->mCanceled.load() != 0) {
+		mpService->TaskDone(NULL);
+		return;
+	}
+	TRACE_SPAN_DETAIL("XmlValidationTask::run", "xml", mFilePath);
+	XmlValidationResult result;
+	result.filePath = mFilePath;
+	QFile file(mFilePath);
+	if(file.open(QIODevice::ReadOnly) == true) {
+		const QByteArray document = file.readAll();
+		file.close();
+		result.hash = QCryptographicHash::hash(document, QCryptographicHash::Sha1);
+		if(XmlValidationCache::Instance().Lookup(result.hash, result.diagnostics) == true) {
+			result.fromCache = true;
+			// The cached document may have been validated under another path.
+			for(int i = 0; i < result.diagnostics.size(); i++) result.diagnostics[i].systemId = mFilePath;
+		}
+		else {
+			Error parse_error;
+			// The DOM isn't needed.
+			XmlParserPool::Instance().Parse(document, mFilePath, parse_error, XmlParserPool::SchemaValidation, &result.diagnostics);
+			if(result.diagnostics.size() > XmlValidationService::MaxDiagnostics) {
+				const int suppressed = result.diagnostics.size() - XmlValidationService::MaxDiagnostics;
+				result.diagnostics.erase(result.diagnostics.begin() + XmlValidationService::MaxDiagnostics, result.diagnostics.end());
+				XmlDiagnostic diagnostic;
+				diagnostic.severity = XmlDiagnostic::Warning;
+				diagnostic.systemId = mFilePath;
+				diagnostic.message = QObject::tr("%1 further diagnostics suppressed").arg(suppressed);
+				result.diagnostics.push_back(diagnostic);
+			}
+			XmlValidationCache::Instance().Insert(result.hash, result.diagnostics);
+		}
+	}
+	else result.error = Error(Error::SourceFileOpenError, mFilePath);
+	mpService->TaskDone(&result);
+}
+
+int XmlValidationResult::GetErrorCount() const {
+
+	int count = 0;
+	for(int i = 0; i < diagnostics.size(); i++) {
+		if(diagnostics.at(i).severity != XmlDiagnostic::Warning) count++;
+	}
+	return count;
+}
+
+XmlValidationCache& XmlValidationCache::Instance() {
+
+	static XmlValidationCache cache;
+	return cache;
+}
+
+XmlValidationCache::XmlValidationCache(int capacity /*= 4096*/) :
+mMutex(), mCache(capacity) {
+
+}
+
+bool XmlValidationCache::Lookup(const QByteArray &rHash, QList<XmlDiagnostic> &rDiagnostics) {
+
+	QMutexLocker locker(&mMutex);
+	QList<XmlDiagnostic> *p_diagnostics = mCache.object(rHash);
+	if(p_diagnostics == NULL) return false;
+	rDiagnostics = *p_diagnostics;
+	return true;
+}
+
+void XmlValidationCache::Insert(const QByteArray &rHash, const QList<XmlDiagnostic> &rDiagnostics) {
+
+	QMutexLocker locker(&mMutex);
+	mCache.insert(rHash, new QList<XmlDiagnostic>(rDiagnostics), rDiagnostics.size() + 1);
+}
+
+void XmlValidationCache::Clear() {
+
+	QMutexLocker locker(&mMutex);
+	mCache.clear();
+}
+
+int XmlValidationCache::GetCount() const {
+
+	QMutexLocker locker(&mMutex);
+	return mCache.count();
+}
+
+XmlValidationService::XmlValidationService(QObject *pParent /*= NULL*/) :
+QObject(pParent), mThreadPool(), mMutex(), mResults(), mPendingCount(0), mCanceled(0) {
+
+	mThreadPool.setMaxThreadCount(QThread::idealThreadCount());
+}
+
+XmlValidationService::~XmlValidationService() {
+
+	Cancel();
+	mThreadPool.waitForDone();
+}
+
+void XmlValidationService::Validate(const QStringList &rFiles) {
+
+	if(rFiles.isEmpty() == true) return;
+	mCanceled.store(0);
+	{
+		QMutexLocker locker(&mMutex);
+		mPendingCount += rFiles.size();
+	}
+	for(int i = 0; i < rFiles.size(); i++) mThreadPool.start(new XmlValidationTask(this, rFiles.at(i)));
+}
+
+void XmlValidationService::WaitForDone() {
+
+	mThreadPool.waitForDone();
+}
+
+bool XmlValidationService::IsRunning() const {
+
+	QMutexLocker locker(&mMutex);
+	return mPendingCount > 0;
+}
+
+QList<XmlValidationResult> XmlValidationService::GetResults() const {
+
+	QMutexLocker locker(&mMutex);
+	return mResults;
+}
+
+void XmlValidationService::Clear() {
+
+	QMutexLocker locker(&mMutex);
+	mResults.clear();
+}
+
+void XmlValidationService::Cancel() {
+
+	mCanceled.store(1);
+}
+
+void XmlValidationService::TaskDone(const XmlValidationResult *pResult) {
+
+	bool finished = false;
+	{
+		QMutexLocker locker(&mMutex);
+		if(pResult) mResults.push_back(*pResult);
+		finished = (--mPendingCount == 0);
+	}
+	if(pResult) emit DocumentValidated(*pResult);
+	if(finished == true) emit Finished();
+}
@@ -0,0 +1,111 @@
+/* Copyright(C) 2016 Björn Stresing, Denis Manthey, Wolfgang Ruppel
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include "Error.h"
+#include "XmlParserPool.h"
+#include <QObject>
+#include <QMetaType>
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QList>
+#include <QCache>
+#include <QMutex>
+#include <QAtomicInt>
+#include <QThreadPool>
+
+
+//! Schema validation result of a single XML document.
+struct XmlValidationResult {
+
+	XmlValidationResult() : filePath(), hash(), error(), diagnostics(), fromCache(false) {}
+	//! False if the document couldn't be read or validation reported an error.
+	bool IsValid() const { return error.IsError() == false && GetErrorCount() == 0; }
+	int GetErrorCount() const;
+	QString filePath;
+	QByteArray hash; // SHA-1 of the document.
+	Error error; // Set if the document couldn't be read.
+	QList<XmlDiagnostic> diagnostics;
+	bool fromCache;
+};
+
+Q_DECLARE_METATYPE(XmlValidationResult)
+
+/*! \brief Thread safe cache of validation diagnostics keyed by the SHA-1 of the document.
+Shared by all XmlValidationService instances so unchanged documents are never validated twice per process.
+*/
+class XmlValidationCache {
+
+public:
+	static XmlValidationCache& Instance();
+	bool Lookup(const QByteArray &rHash, QList<XmlDiagnostic> &rDiagnostics);
+	void Insert(const QByteArray &rHash, const QList<XmlDiagnostic> &rDiagnostics);
+	void Clear();
+	int GetCount() const;
+
+private:
+	XmlValidationCache(int capacity = 4096);
+	~XmlValidationCache() {}
+	Q_DISABLE_COPY(XmlValidationCache);
+	mutable QMutex mMutex;
+	QCache<QByteArray, QList<XmlDiagnostic> > mCache; // Cost is the number of diagnostics plus one.
+};
+
+/*! \brief Validates XML documents (CPL, PKL, ASSETMAP, OPL) against the precompiled grammars of XmlParserPool.
+Every document is validated by its own task on a private thread pool. DocumentValidated() is emitted as soon as a
+document is done, Finished() when all queued documents are done. Both signals are emitted from worker threads and are
+queued to receivers living in other threads. Documents whose content was validated before are served from XmlValidationCache.
+*/
+class XmlValidationService : public QObject {
+
+	Q_OBJECT
+
+	friend class XmlValidationTask;
+
+public:
+	//! Diagnostics of a document are truncated after this count.
+	static const int MaxDiagnostics = 200;
+	XmlValidationService(QObject *pParent = NULL);
+	//! Cancels pending documents and waits for running ones.
+	virtual ~XmlValidationService();
+	//! Queues rFiles for validation and returns immediately.
+	void Validate(const QStringList &rFiles);
+	//! Blocks until all queued documents are validated.
+	void WaitForDone();
+	bool IsRunning() const;
+	//! Results of all documents validated since the last Clear().
+	QList<XmlValidationResult> GetResults() const;
+	void Clear();
+
+signals:
+	void DocumentValidated(const XmlValidationResult &rResult);
+	void Finished();
+
+	public slots:
+	//! Documents which aren't validated yet are skipped.
+	void Cancel();
+
+private:
+	Q_DISABLE_COPY(XmlValidationService);
+	//! Invoked by XmlValidationTask. pResult is NULL if the document was skipped.
+	void TaskDone(const XmlValidationResult *pResult);
+
+	QThreadPool mThreadPool;
+	mutable QMutex mMutex;
+	QList<XmlValidationResult> mResults;
+	int mPendingCount;
+	QAtomicInt mCanceled;
+};
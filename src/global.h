@@ -47,6 +47,7 @@
 #define XML_NAMESPACE_DS "http://www.w3.org/2000/09/xmldsig#"
 #define XML_NAMESPACE_XS "http://www.w3.org/2001/XMLSchema"
 #define XML_NAMESPACE_NS "http://www.w3.org/2000/xmlns/"
+#define IMSC1_TEXT_PROFILE "http://www.w3.org/ns/ttml/profile/imsc1/text"
 
 #define SETTINGS_AUDIO_DEVICE "audio/audioDevice"
 #define SETTINGS_AUDIO_CHANNEL_CONFIGURATION "audio/audioChannelConfiguration"
@@ -59,8 +60,13 @@
 #define SETTINGS_AUDIO_SELECTED_CHANNELS_FOR_TARGET_CHANNEL5 "audio/audioChannels5"
 #define SETTINGS_AUDIO_SELECTED_CHANNELS_FOR_TARGET_CHANNEL6 "audio/audioChannels6"
 #define SETTINGS_AUDIO_SELECTED_CHANNELS_FOR_TARGET_CHANNEL7 "audio/audioChannels7"
+#define SETTINGS_AUDIO_ANALYSIS "audio/analysis" // Loudness, true-peak and silence analysis while wrapping WAV files.
+#define SETTINGS_VIDEO_PREVIEW_CACHE_SIZE "video/previewCacheSize" // [MiB]
+#define SETTINGS_VIDEO_PREVIEW_PREFETCH "video/previewPrefetch" // [frames]
 #define SETTINGS_CL_PLATFORM "cl/Platform"
 #define SETTINGS_CL_DEVICE "cl/Device"
+#define SETTINGS_TRACE_ENABLED "trace/enabled"
+#define SETTINGS_TRACE_FILE "trace/file"
 
 #define FIELD_NAME_ISSUER "Issuer"
 #define FIELD_NAME_ANNOTATION "Annotation"
@@ -72,6 +78,7 @@
 #define FIELD_NAME_DURATION "Duration"
 #define FIELD_NAME_SOUNDFIELD_GROUP "SoundfiledGourpName"
 #define FIELD_NAME_WORKING_DIR "WorkingDir"
+#define FIELD_NAME_REFERENCE_DIRS "ReferenceDirs"
 
 
 enum eUserEventType {
@@ -175,6 +182,13 @@ inline bool is_exr_file(const QString &rFilePath) {
 }
 
 
+inline bool is_j2c_file(const QString &rFilePath) {
+
+	if(QFileInfo(rFilePath).suffix().compare("j2c", Qt::CaseInsensitive) == 0) return true;
+	return false;
+}
+
+
 inline bool is_ttml_file(const QString &rFilePath) {
 
 	if(QFileInfo(rFilePath).suffix().compare("ttml", Qt::CaseInsensitive) == 0 || QFileInfo(rFilePath).suffix().compare("xml", Qt::CaseInsensitive) == 0) return true;
@@ -203,6 +217,13 @@ inline bool is_exr_file(const QFileInfo &rFilePath) {
 }
 
 
+inline bool is_j2c_file(const QFileInfo &rFilePath) {
+
+	if(rFilePath.suffix().compare("j2c", Qt::CaseInsensitive) == 0) return true;
+	return false;
+}
+
+
 inline bool is_ttml_file(const QFileInfo &rFilePath) {
 
 	if(rFilePath.suffix().compare("ttml", Qt::CaseInsensitive) == 0 || rFilePath.suffix().compare("xml", Qt::CaseInsensitive) == 0) return true;
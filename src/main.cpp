@@ -20,6 +20,10 @@
 #include "MetadataExtractor.h"
 #include "CustomProxyStyle.h"
 #include "WizardResourceGenerator.h"
+#include "JobQueue.h"
+#include "Trace.h"
+#include "XmlValidationService.h"
+#include "StartupReport.h"
 #ifdef Q_OS_WIN32
 #include <qt_windows.h> // we need this for OutputDebugString()
 #endif // Q_OS_WIN32
@@ -128,6 +132,7 @@ static void dbug_msg_handler(QtMsgType type, const QMessageLogContext &rContext,
 
 int main(int argc, char *argv[]) {
 
+	StartupReport::Start();
 	QApplication a(argc, argv);
 	a.setApplicationName(PROJECT_NAME);
 	a.setOrganizationName("hsrm");
@@ -146,6 +151,7 @@ int main(int argc, char *argv[]) {
 	else {
 		qWarning() << "Couldn't load stylesheet: " << style_file.fileName();
 	}
+	StartupReport::Mark("QApplication");
 
 	// open log file
 	if(log_file.size() > MAX_DEBUG_FILE_SIZE) {
@@ -167,9 +173,11 @@ int main(int argc, char *argv[]) {
 	qDebug() << "**********************" PROJECT_NAME " starting up**********************";
 	qDebug() << "asdcplib version: " << ASDCP::Version();
 	qDebug() << "IMF Tool version: " << a.applicationVersion();
+	Trace::Init();
 	// catch libasdcpmod debug messages
 	Kumu::KMQtLogSink qt_kumu_log_sinc;
 	Kumu::SetDefaultLogSink(&qt_kumu_log_sinc);
+	StartupReport::Mark("Log");
 
 	//--- register Qt metatypes here ---
 	qRegisterMetaType<SoundfieldGroup>("SoundfieldGroup");
@@ -178,11 +186,19 @@ int main(int argc, char *argv[]) {
 	qRegisterMetaType<Timecode>("Timecode");
 	qRegisterMetaType<Duration>("Duration");
 	qRegisterMetaType<WizardResourceGenerator::eMode>("WizardResourceGenerator::eMode");
+	qRegisterMetaType<JobTelemetry>("JobTelemetry");
+	qRegisterMetaType<JobQueueStatistics>("JobQueueStatistics");
+	qRegisterMetaType<XmlValidationResult>("XmlValidationResult");
+	qRegisterMetaType<AudioAnalysisResult>("AudioAnalysisResult");
 
 	xercesc::XMLPlatformUtils::Initialize();
+	StartupReport::Mark("Xerces");
+	// Heavy parts of the main window are initialized on first use or after the first frame was painted (see MainWindow::rDeferredInit()).
 	MainWindow w;
+	StartupReport::Mark("MainWindow");
 	w.showMaximized();
 	int ret = a.exec();
+	if(Trace::IsEnabled()) Trace::Export();
 	//xercesc::XMLPlatformUtils::Terminate();
 	return ret;
 }
@@ -0,0 +1,133 @@
+/* Copyright(C) 2016 Björn Stresing, Denis Manthey, Wolfgang Ruppel
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "AssetIndex.h"
+#include <QtTest>
+#include <QTemporaryDir>
+#include <QDir>
+
+
+/*! \brief Checks that AssetIndex shares one entry per Id and hash and keeps entries only while they are referenced.
+The track files don't exist: Every read yields an entry without metadata and essence descriptor. The tests only rely on the identity of the entries.
+*/
+class TestAssetIndex : public QObject {
+
+	Q_OBJECT
+
+private slots:
+	void init();
+	void concurrentAcquire();
+	void distinctHash();
+	void release();
+	void noHash();
+
+private:
+	QString TrackFilePath(const QString &rName) const;
+
+	QTemporaryDir mDir;
+};
+
+namespace {
+
+	QByteArray hash(char fill) {
+
+		return QByteArray(20, fill);
+	}
+}
+
+void TestAssetIndex::init() {
+
+	QVERIFY(mDir.isValid());
+}
+
+QString TestAssetIndex::TrackFilePath(const QString &rName) const {
+
+	return QDir(mDir.path()).absoluteFilePath(rName);
+}
+
+void TestAssetIndex::concurrentAcquire() {
+
+	AssetIndex &r_index = AssetIndex::Instance();
+	const int count_before = r_index.GetCount();
+	const qint64 hits_before = r_index.GetHitCount();
+	const QUuid id = QUuid::createUuid();
+	// A supplemental package and its OV list the same track file. The prefetch threads ask for it concurrently.
+	QList<AssetIndex::Request> requests;
+	for(int i = 0; i < 8; i++) requests << AssetIndex::Request(id, hash('a'), TrackFilePath(QString("track_%1.mxf").arg(i)));
+	const QList<AssetIndex::Entry> entries = r_index.Prefetch(requests);
+	QCOMPARE(entries.size(), requests.size());
+	QVERIFY(entries.first().isNull() == false);
+	for(int i = 1; i < entries.size(); i++) QVERIFY(entries.at(i) == entries.first());
+	QCOMPARE(r_index.GetCount(), count_before + 1);
+	QCOMPARE(r_index.GetHitCount(), hits_before + requests.size() - 1);
+
+	const AssetIndex::Entry entry = r_index.Acquire(id, hash('a'), TrackFilePath("other.mxf"));
+	QVERIFY(entry == entries.first());
+	QCOMPARE(r_index.GetHitCount(), hits_before + requests.size());
+}
+
+void TestAssetIndex::distinctHash() {
+
+	AssetIndex &r_index = AssetIndex::Instance();
+	const int count_before = r_index.GetCount();
+	const QUuid id = QUuid::createUuid();
+	// The content of a track file is identified by Id and hash. Another hash is another track file.
+	const AssetIndex::Entry entry = r_index.Acquire(id, hash('a'), TrackFilePath("track.mxf"));
+	const AssetIndex::Entry other_hash = r_index.Acquire(id, hash('b'), TrackFilePath("track.mxf"));
+	const AssetIndex::Entry other_id = r_index.Acquire(QUuid::createUuid(), hash('a'), TrackFilePath("track.mxf"));
+	QVERIFY(entry != other_hash);
+	QVERIFY(entry != other_id);
+	QVERIFY(other_hash != other_id);
+	QCOMPARE(r_index.GetCount(), count_before + 3);
+}
+
+void TestAssetIndex::release() {
+
+	AssetIndex &r_index = AssetIndex::Instance();
+	const int count_before = r_index.GetCount();
+	const QUuid id = QUuid::createUuid();
+	AssetIndex::Entry entry = r_index.Acquire(id, hash('a'), TrackFilePath("track.mxf"));
+	AssetIndex::Entry copy = entry;
+	QCOMPARE(r_index.GetCount(), count_before + 1);
+	entry.clear();
+	QCOMPARE(r_index.GetCount(), count_before + 1);
+	copy.clear();
+	QCOMPARE(r_index.GetCount(), count_before);
+
+	// Released entries are read again.
+	const qint64 hits_before = r_index.GetHitCount();
+	entry = r_index.Acquire(id, hash('a'), TrackFilePath("track.mxf"));
+	QVERIFY(entry.isNull() == false);
+	QCOMPARE(r_index.GetHitCount(), hits_before);
+	QCOMPARE(r_index.GetCount(), count_before + 1);
+}
+
+void TestAssetIndex::noHash() {
+
+	AssetIndex &r_index = AssetIndex::Instance();
+	const int count_before = r_index.GetCount();
+	const qint64 hits_before = r_index.GetHitCount();
+	const QUuid id = QUuid::createUuid();
+	// Without hash the content is unknown. The track file is read every time and isn't indexed.
+	const AssetIndex::Entry entry = r_index.Acquire(id, QByteArray(), TrackFilePath("track.mxf"));
+	const AssetIndex::Entry again = r_index.Acquire(id, QByteArray(), TrackFilePath("track.mxf"));
+	QVERIFY(entry.isNull() == false);
+	QVERIFY(entry != again);
+	QCOMPARE(r_index.GetCount(), count_before);
+	QCOMPARE(r_index.GetHitCount(), hits_before);
+}
+
+QTEST_GUILESS_MAIN(TestAssetIndex)
+#include "TestAssetIndex.moc"
@@ -0,0 +1,336 @@
+/* Copyright(C) 2016 Björn Stresing, Denis Manthey, Wolfgang Ruppel
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "AudioKernels.h"
+#include <QtTest>
+#include <QVector>
+#include <QList>
+#include <cstring>
+#include <limits>
+
+
+/*! \brief Checks that every instruction set supported by the CPU produces results bit-identical to the scalar kernels.
+Source buffers are allocated with their exact size so that AddressSanitizer reports reads beyond the end. Destination buffers are followed by guard
+values which must survive every call.
+*/
+class TestAudioKernels : public QObject {
+
+	Q_OBJECT
+
+private slots:
+	void initTestCase();
+	void cleanupTestCase();
+	void toFloat();
+	void fromFloat();
+	void fullScale();
+	void deinterleaveToFloat();
+	void interleave();
+	void minMax();
+
+private:
+	AudioKernels::eInstructionSet mDefaultInstructionSet;
+	QList<AudioKernels::eInstructionSet> mInstructionSets; // Supported vector instruction sets.
+};
+
+namespace {
+
+	const int guard_count = 64;
+	const unsigned char guard_byte = 0xA5;
+	const float guard_float = 12345.f;
+	const int bytes_per_sample[] = { 2, 3, 4 };
+
+	class Random {
+
+	public:
+		explicit Random(quint32 seed) : mState(seed) {}
+		quint32 Next() {
+
+			mState ^= mState << 13;
+			mState ^= mState >> 17;
+			mState ^= mState << 5;
+			return mState;
+		}
+
+	private:
+		quint32 mState;
+	};
+
+	// All lengths up to 40 cover every tail of the 4, 8 and 16 sample wide loops.
+	QVector<int> sample_counts() {
+
+		QVector<int> ret;
+		for(int i = 0; i <= 40; i++) ret << i;
+		ret << 63 << 64 << 65 << 1001;
+		return ret;
+	}
+
+	QVector<int> frame_counts() {
+
+		QVector<int> ret;
+		for(int i = 0; i <= 20; i++) ret << i;
+		ret << 33 << 517;
+		return ret;
+	}
+
+	void set_sample(unsigned char *pSample, int bytesPerSample, quint32 value) {
+
+		for(int b = 0; b < bytesPerSample; b++) pSample[b] = (unsigned char)(value >> (8 * b));
+	}
+
+	quint32 negative_full_scale(int bytesPerSample) { return 1u << (8 * bytesPerSample - 1); }
+	quint32 positive_full_scale(int bytesPerSample) { return negative_full_scale(bytesPerSample) - 1; }
+	// 32 bit samples clip to the largest float below 2^31.
+	quint32 positive_clip(int bytesPerSample) { return bytesPerSample == 4 ? 2147483520u : positive_full_scale(bytesPerSample); }
+
+	// Random samples with both full scale values mixed in.
+	QVector<unsigned char> random_pcm(int bytesPerSample, int count, quint32 seed) {
+
+		Random random(seed);
+		QVector<unsigned char> ret(count * bytesPerSample);
+		for(int i = 0; i < count; i++) {
+			const quint32 value = random.Next();
+			switch(value % 8) {
+				case 0: set_sample(ret.data() + i * bytesPerSample, bytesPerSample, negative_full_scale(bytesPerSample)); break;
+				case 1: set_sample(ret.data() + i * bytesPerSample, bytesPerSample, positive_full_scale(bytesPerSample)); break;
+				default: set_sample(ret.data() + i * bytesPerSample, bytesPerSample, value); break;
+			}
+		}
+		return ret;
+	}
+
+	// Random samples in [-1.25, 1.25) to exercise clipping, mixed with full scale values, ties, values far out of range and NaN.
+	QVector<float> random_float(int count, quint32 seed) {
+
+		static const float special[] = { -1.f, 1.f, -2.f, 2.f, 0.f, -0.f, 1.f - 1.f / 65536.f, -1.f + 1.f / 65536.f, 0.5f / 32768.f, 1.5f / 32768.f,
+			-0.5f / 32768.f, -1.5f / 32768.f, 0.5f / 8388608.f, 1.5f / 8388608.f, 2147483520.f / 2147483648.f, 1e10f, -1e10f,
+			std::numeric_limits<float>::quiet_NaN() };
+		Random random(seed);
+		QVector<float> ret(count);
+		for(int i = 0; i < count; i++) {
+			const quint32 value = random.Next();
+			if(value % 4 == 0) ret[i] = special[(value >> 8) % (sizeof(special) / sizeof(special[0]))];
+			else ret[i] = ((float)(value >> 8) / 8388608.f - 1.f) * 1.25f;
+		}
+		return ret;
+	}
+
+	template<typename T>
+	bool guard_intact(const QVector<T> &rBuffer, int size, T guard) {
+
+		for(int i = size; i < rBuffer.size(); i++) if(rBuffer.at(i) != guard) return false;
+		return true;
+	}
+
+	// Compares the bit patterns, +0.f and -0.f differ.
+	template<typename T>
+	bool identical(const QVector<T> &rFirst, const QVector<T> &rSecond) {
+
+		return rFirst.size() == rSecond.size() && std::memcmp(rFirst.constData(), rSecond.constData(), rFirst.size() * sizeof(T)) == 0;
+	}
+
+	QVector<float> to_float(const QVector<unsigned char> &rSource, int bytesPerSample, int count) {
+
+		QVector<float> ret(count + guard_count, guard_float);
+		AudioKernels::ToFloat(rSource.constData(), bytesPerSample, ret.data(), count);
+		return ret;
+	}
+
+	QVector<unsigned char> from_float(const QVector<float> &rSource, int bytesPerSample) {
+
+		QVector<unsigned char> ret(rSource.size() * bytesPerSample + guard_count, guard_byte);
+		AudioKernels::FromFloat(rSource.constData(), ret.data(), bytesPerSample, rSource.size());
+		return ret;
+	}
+
+	QList<QVector<float> > deinterleave_to_float(const QVector<unsigned char> &rSource, int bytesPerSample, int channelCount, int frameCount) {
+
+		QList<QVector<float> > channels;
+		QVector<float*> destinations;
+		for(int channel = 0; channel < channelCount; channel++) channels << QVector<float>(frameCount + guard_count, guard_float);
+		for(int channel = 0; channel < channelCount; channel++) destinations << channels[channel].data();
+		AudioKernels::DeinterleaveToFloat(rSource.constData(), bytesPerSample, channelCount, destinations.constData(), frameCount);
+		return channels;
+	}
+
+	QString describe(AudioKernels::eInstructionSet instructionSet, int bytesPerSample, int count, int channelCount = 1) {
+
+		return QString("%1, %2 bit, %3 channels, %4 samples").arg(AudioKernels::GetInstructionSetName(instructionSet)).arg(8 * bytesPerSample).arg(channelCount).arg(count);
+	}
+}
+
+void TestAudioKernels::initTestCase() {
+
+	mDefaultInstructionSet = AudioKernels::GetInstructionSet();
+	QVERIFY(AudioKernels::IsSupported(AudioKernels::Scalar));
+	for(int i = AudioKernels::Sse2; i <= AudioKernels::Neon; i++) {
+		const AudioKernels::eInstructionSet instruction_set = (AudioKernels::eInstructionSet)i;
+		if(AudioKernels::IsSupported(instruction_set) == true) mInstructionSets << instruction_set;
+		else qDebug() << AudioKernels::GetInstructionSetName(instruction_set) << "not supported, skipped.";
+	}
+}
+
+void TestAudioKernels::cleanupTestCase() {
+
+	AudioKernels::SetInstructionSet(mDefaultInstructionSet);
+}
+
+void TestAudioKernels::toFloat() {
+
+	const QVector<int> counts = sample_counts();
+	for(int b = 0; b < 3; b++) {
+		const int bytes = bytes_per_sample[b];
+		for(int c = 0; c < counts.size(); c++) {
+			const QVector<unsigned char> source = random_pcm(bytes, counts.at(c), counts.at(c) + 1);
+			QVERIFY(AudioKernels::SetInstructionSet(AudioKernels::Scalar));
+			const QVector<float> expected = to_float(source, bytes, counts.at(c));
+			QVERIFY2(guard_intact(expected, counts.at(c), guard_float), qPrintable(describe(AudioKernels::Scalar, bytes, counts.at(c))));
+			for(int i = 0; i < mInstructionSets.size(); i++) {
+				QVERIFY(AudioKernels::SetInstructionSet(mInstructionSets.at(i)));
+				const QVector<float> result = to_float(source, bytes, counts.at(c));
+				QVERIFY2(identical(result, expected), qPrintable(describe(mInstructionSets.at(i), bytes, counts.at(c))));
+			}
+		}
+	}
+}
+
+void TestAudioKernels::fromFloat() {
+
+	const QVector<int> counts = sample_counts();
+	for(int b = 0; b < 3; b++) {
+		const int bytes = bytes_per_sample[b];
+		for(int c = 0; c < counts.size(); c++) {
+			const QVector<float> source = random_float(counts.at(c), counts.at(c) + 1);
+			QVERIFY(AudioKernels::SetInstructionSet(AudioKernels::Scalar));
+			const QVector<unsigned char> expected = from_float(source, bytes);
+			QVERIFY2(guard_intact(expected, counts.at(c) * bytes, guard_byte), qPrintable(describe(AudioKernels::Scalar, bytes, counts.at(c))));
+			for(int i = 0; i < mInstructionSets.size(); i++) {
+				QVERIFY(AudioKernels::SetInstructionSet(mInstructionSets.at(i)));
+				const QVector<unsigned char> result = from_float(source, bytes);
+				QVERIFY2(identical(result, expected), qPrintable(describe(mInstructionSets.at(i), bytes, counts.at(c))));
+			}
+		}
+	}
+}
+
+void TestAudioKernels::fullScale() {
+
+	QList<AudioKernels::eInstructionSet> instruction_sets = mInstructionSets;
+	instruction_sets.prepend(AudioKernels::Scalar);
+	for(int i = 0; i < instruction_sets.size(); i++) {
+		QVERIFY(AudioKernels::SetInstructionSet(instruction_sets.at(i)));
+		for(int b = 0; b < 3; b++) {
+			const int bytes = bytes_per_sample[b];
+			const QString description = describe(instruction_sets.at(i), bytes, 17);
+			// 17 samples to go through the vector loops and the scalar tail.
+			QVector<unsigned char> pcm(17 * bytes);
+			for(int s = 0; s < 17; s++) set_sample(pcm.data() + s * bytes, bytes, negative_full_scale(bytes));
+			const QVector<float> floats = to_float(pcm, bytes, 17);
+			for(int s = 0; s < 17; s++) QVERIFY2(floats.at(s) == -1.f, qPrintable(description));
+
+			const float lsb = 1.f / (float)negative_full_scale(bytes);
+			const float inputs[] = { -1.f, -2.f, -1e10f, 1.f, 2.f, 1e10f, 0.5f * lsb, 1.5f * lsb, -0.5f * lsb, -1.5f * lsb,
+				std::numeric_limits<float>::quiet_NaN() };
+			const quint32 outputs[] = { negative_full_scale(bytes), negative_full_scale(bytes), negative_full_scale(bytes),
+				positive_clip(bytes), positive_clip(bytes), positive_clip(bytes), 0, 2, 0, ~1u, 0 };
+			for(int k = 0; k < (int)(sizeof(inputs) / sizeof(inputs[0])); k++) {
+				const QVector<unsigned char> result = from_float(QVector<float>(17, inputs[k]), bytes);
+				QVector<unsigned char> expected(17 * bytes);
+				for(int s = 0; s < 17; s++) set_sample(expected.data() + s * bytes, bytes, outputs[k]);
+				QVERIFY2(std::memcmp(result.constData(), expected.constData(), expected.size()) == 0, qPrintable(QString("%1, input %2").arg(description).arg(inputs[k])));
+			}
+		}
+	}
+}
+
+void TestAudioKernels::deinterleaveToFloat() {
+
+	const QVector<int> counts = frame_counts();
+	for(int b = 0; b < 3; b++) {
+		const int bytes = bytes_per_sample[b];
+		for(int channel_count = 1; channel_count <= 16; channel_count++) {
+			for(int c = 0; c < counts.size(); c++) {
+				const QVector<unsigned char> source = random_pcm(bytes, counts.at(c) * channel_count, channel_count * 1000 + counts.at(c));
+				QVERIFY(AudioKernels::SetInstructionSet(AudioKernels::Scalar));
+				const QList<QVector<float> > expected = deinterleave_to_float(source, bytes, channel_count, counts.at(c));
+				const QVector<float> interleaved = to_float(source, bytes, counts.at(c) * channel_count);
+				for(int channel = 0; channel < channel_count; channel++) {
+					const QString description = describe(AudioKernels::Scalar, bytes, counts.at(c), channel_count);
+					QVERIFY2(guard_intact(expected.at(channel), counts.at(c), guard_float), qPrintable(description));
+					for(int i = 0; i < counts.at(c); i++) QVERIFY2(expected.at(channel).at(i) == interleaved.at(i * channel_count + channel), qPrintable(description));
+				}
+				for(int i = 0; i < mInstructionSets.size(); i++) {
+					QVERIFY(AudioKernels::SetInstructionSet(mInstructionSets.at(i)));
+					const QList<QVector<float> > result = deinterleave_to_float(source, bytes, channel_count, counts.at(c));
+					for(int channel = 0; channel < channel_count; channel++) {
+						QVERIFY2(identical(result.at(channel), expected.at(channel)), qPrintable(describe(mInstructionSets.at(i), bytes, counts.at(c), channel_count)));
+					}
+				}
+			}
+		}
+	}
+}
+
+void TestAudioKernels::interleave() {
+
+	// Deinterleave() and Interleave() don't depend on the instruction set. The word wise copies must not touch the bytes behind the last sample.
+	const QVector<int> counts = frame_counts();
+	for(int b = 0; b < 3; b++) {
+		const int bytes = bytes_per_sample[b];
+		for(int channel_count = 1; channel_count <= 16; channel_count++) {
+			for(int c = 0; c < counts.size(); c++) {
+				const QString description = describe(AudioKernels::Scalar, bytes, counts.at(c), channel_count);
+				const QVector<unsigned char> source = random_pcm(bytes, counts.at(c) * channel_count, channel_count * 1000 + counts.at(c));
+				QList<QVector<unsigned char> > channels;
+				QVector<unsigned char*> destinations;
+				QVector<const unsigned char*> sources;
+				for(int channel = 0; channel < channel_count; channel++) channels << QVector<unsigned char>(counts.at(c) * bytes + guard_count, guard_byte);
+				for(int channel = 0; channel < channel_count; channel++) destinations << channels[channel].data();
+				AudioKernels::Deinterleave(source.constData(), bytes, channel_count, destinations.constData(), counts.at(c));
+				for(int channel = 0; channel < channel_count; channel++) {
+					QVERIFY2(guard_intact(channels.at(channel), counts.at(c) * bytes, guard_byte), qPrintable(description));
+					for(int i = 0; i < counts.at(c); i++) {
+						QVERIFY2(std::memcmp(channels.at(channel).constData() + i * bytes, source.constData() + (i * channel_count + channel) * bytes, bytes) == 0, qPrintable(description));
+					}
+					sources << channels.at(channel).constData();
+				}
+				QVector<unsigned char> result(source.size() + guard_count, guard_byte);
+				AudioKernels::Interleave(sources.constData(), bytes, channel_count, result.data(), counts.at(c));
+				QVERIFY2(guard_intact(result, source.size(), guard_byte), qPrintable(description));
+				QVERIFY2(source.isEmpty() || std::memcmp(result.constData(), source.constData(), source.size()) == 0, qPrintable(description));
+			}
+		}
+	}
+}
+
+void TestAudioKernels::minMax() {
+
+	const QVector<int> counts = sample_counts();
+	for(int c = 0; c < counts.size(); c++) {
+		const QVector<float> source = random_float(counts.at(c), counts.at(c) + 1);
+		QVERIFY(AudioKernels::SetInstructionSet(AudioKernels::Scalar));
+		float expected_min = 0.f, expected_max = 0.f;
+		AudioKernels::MinMax(source.constData(), source.size(), expected_min, expected_max);
+		for(int i = 0; i < mInstructionSets.size(); i++) {
+			QVERIFY(AudioKernels::SetInstructionSet(mInstructionSets.at(i)));
+			float min = 0.f, max = 0.f;
+			AudioKernels::MinMax(source.constData(), source.size(), min, max);
+			const QString description = describe(mInstructionSets.at(i), 4, counts.at(c));
+			QVERIFY2(min == expected_min && max == expected_max, qPrintable(description));
+		}
+	}
+}
+
+QTEST_APPLESS_MAIN(TestAudioKernels)
+#include "TestAudioKernels.moc"
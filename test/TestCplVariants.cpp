@@ -0,0 +1,318 @@
+/* Copyright(C) 2016 Björn Stresing, Denis Manthey, Wolfgang Ruppel
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "Jobs.h"
+#include "EssenceDescriptorTable.h"
+#include "ImfPackageCommon.h"
+#include "global.h"
+#include <QtTest>
+#include <QTemporaryDir>
+#include <QXmlStreamReader>
+#include <QCryptographicHash>
+#include <QFile>
+#include <QDir>
+
+
+/*! \brief Checks the variants built by JobGenerateCplVariants from a minimal template CPL and the validation of the substitutes.
+The template references track file A (two resources, 96 edit units needed) and track file C (one resource). Track file B may replace A.
+*/
+class TestCplVariants : public QObject {
+
+	Q_OBJECT
+
+private slots:
+	void initTestCase();
+	void substitute();
+	void editRateMismatch();
+	void shortSubstitute();
+	void unknownTrackFile();
+	void substitutionTable();
+
+private:
+	JobGenerateCplVariants* CreateJob(const QList<JobGenerateCplVariants::Variant> &rVariants, const EditRate &rEditRate, const Duration &rDuration);
+
+	QTemporaryDir mDir;
+	QString mTemplate;
+	QUuid mTemplateId;
+	QUuid mTrackFileA;
+	QUuid mTrackFileB;
+	QUuid mTrackFileC;
+	// Held for the lifetime of the test. EssenceDescriptorTable only keeps weak references.
+	EssenceDescriptorTable::Descriptor mDescriptorA;
+	EssenceDescriptorTable::Descriptor mDescriptorB;
+	EssenceDescriptorTable::Descriptor mDescriptorC;
+	QByteArray mHashB;
+};
+
+namespace {
+
+	QByteArray regxml_descriptor(int channelCount) {
+
+		return QString("<r0:WAVEPCMDescriptor xmlns:r0=\"http://www.smpte-ra.org/reg/395/2014/13/1/aaf\" xmlns:r1=\"http://www.smpte-ra.org/reg/335/2012\">"
+									 "<r1:ChannelCount>%1</r1:ChannelCount></r0:WAVEPCMDescriptor>").arg(channelCount).toUtf8();
+	}
+
+	QString urn(const QUuid &rId) {
+
+		return QString("urn:uuid:").append(strip_uuid(rId));
+	}
+
+	QUuid descriptor_id(const EssenceDescriptorTable::Descriptor &rDescriptor) {
+
+		return ImfXmlHelper::Convert(rDescriptor->getId());
+	}
+
+	QString resource(const QUuid &rTrackFile, const QUuid &rSourceEncoding, int intrinsicDuration, int entryPoint, int sourceDuration) {
+
+		return QString("<Resource xsi:type=\"TrackFileResourceType\"><Id>%1</Id><IntrinsicDuration>%2</IntrinsicDuration><EntryPoint>%3</EntryPoint>"
+									 "<SourceDuration>%4</SourceDuration><SourceEncoding>%5</SourceEncoding><TrackFileId>%6</TrackFileId><Hash>AAAAAAAAAAAAAAAAAAAAAAAAAAA=</Hash></Resource>")
+			.arg(urn(QUuid::createUuid())).arg(intrinsicDuration).arg(entryPoint).arg(sourceDuration).arg(urn(rSourceEncoding)).arg(urn(rTrackFile));
+	}
+
+	//! Text of all elements with local name rName whose parent has local name rParent, in document order.
+	QStringList element_texts(const QByteArray &rXml, const QString &rParent, const QString &rName) {
+
+		QStringList texts;
+		QStringList path;
+		QXmlStreamReader reader(rXml);
+		while(reader.atEnd() == false) {
+			reader.readNext();
+			if(reader.isStartElement() == true) {
+				if(reader.name() == rName && path.isEmpty() == false && path.last() == rParent) {
+					texts << reader.readElementText(QXmlStreamReader::IncludeChildElements).trimmed();
+					continue;
+				}
+				path << reader.name().toString();
+			}
+			else if(reader.isEndElement() == true) path.removeLast();
+		}
+		return texts;
+	}
+
+	QList<QUuid> element_ids(const QByteArray &rXml, const QString &rParent, const QString &rName) {
+
+		QList<QUuid> ids;
+		const QStringList texts = element_texts(rXml, rParent, rName);
+		for(int i = 0; i < texts.size(); i++) ids << QUuid(texts.at(i).split(':').last());
+		return ids;
+	}
+}
+
+void TestCplVariants::initTestCase() {
+
+	QVERIFY(mDir.isValid());
+	Error error;
+	mDescriptorA = EssenceDescriptorTable::Instance().Intern(regxml_descriptor(2), "A", error);
+	QVERIFY2(error.IsError() == false, qPrintable(error.GetErrorDescription()));
+	mDescriptorB = EssenceDescriptorTable::Instance().Intern(regxml_descriptor(6), "B", error);
+	QVERIFY2(error.IsError() == false, qPrintable(error.GetErrorDescription()));
+	mDescriptorC = EssenceDescriptorTable::Instance().Intern(regxml_descriptor(8), "C", error);
+	QVERIFY2(error.IsError() == false, qPrintable(error.GetErrorDescription()));
+	QVERIFY(descriptor_id(mDescriptorA) != descriptor_id(mDescriptorB));
+	mTemplateId = QUuid::createUuid();
+	mTrackFileA = QUuid::createUuid();
+	mTrackFileB = QUuid::createUuid();
+	mTrackFileC = QUuid::createUuid();
+	mHashB = QCryptographicHash::hash("B", QCryptographicHash::Sha1);
+
+	const QString cpl = QString(
+		"<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+		"<CompositionPlaylist xmlns=\"http://www.smpte-ra.org/schemas/2067-3/2013\" xmlns:cc=\"http://www.smpte-ra.org/schemas/2067-2/2013\" xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\">"
+		"<Id>%1</Id><IssueDate>2016-01-01T00:00:00Z</IssueDate><ContentTitle>Template</ContentTitle>"
+		"<EssenceDescriptorList>"
+		"<EssenceDescriptor><Id>%2</Id>%3</EssenceDescriptor>"
+		"<EssenceDescriptor><Id>%4</Id>%5</EssenceDescriptor>"
+		"</EssenceDescriptorList>"
+		"<EditRate>24 1</EditRate>"
+		"<SegmentList><Segment><Id>%6</Id><SequenceList>"
+		"<cc:MainAudioSequence><Id>%7</Id><TrackId>%8</TrackId><ResourceList>%9%10</ResourceList></cc:MainAudioSequence>"
+		"<cc:MainAudioSequence><Id>%11</Id><TrackId>%12</TrackId><ResourceList>%13</ResourceList></cc:MainAudioSequence>"
+		"</SequenceList></Segment></SegmentList>"
+		"</CompositionPlaylist>")
+		.arg(urn(mTemplateId))
+		.arg(urn(descriptor_id(mDescriptorA))).arg(QString::fromUtf8(regxml_descriptor(2)))
+		.arg(urn(descriptor_id(mDescriptorC))).arg(QString::fromUtf8(regxml_descriptor(8)))
+		.arg(urn(QUuid::createUuid()))
+		.arg(urn(QUuid::createUuid())).arg(urn(QUuid::createUuid()))
+		.arg(resource(mTrackFileA, descriptor_id(mDescriptorA), 120, 0, 48)).arg(resource(mTrackFileA, descriptor_id(mDescriptorA), 120, 24, 72))
+		.arg(urn(QUuid::createUuid())).arg(urn(QUuid::createUuid()))
+		.arg(resource(mTrackFileC, descriptor_id(mDescriptorC), 50, 0, 50));
+	mTemplate = QDir(mDir.path()).absoluteFilePath("CPL_template.xml");
+	QFile file(mTemplate);
+	QVERIFY(file.open(QIODevice::WriteOnly));
+	QVERIFY(file.write(cpl.toUtf8()) > 0);
+}
+
+JobGenerateCplVariants* TestCplVariants::CreateJob(const QList<JobGenerateCplVariants::Variant> &rVariants, const EditRate &rEditRate, const Duration &rDuration) {
+
+	JobGenerateCplVariants *p_job = new JobGenerateCplVariants(mTemplate, rVariants, QDir(mDir.path()));
+	p_job->setAutoDelete(false);
+	p_job->AddTrackFile(mTrackFileA, descriptor_id(mDescriptorA), EditRate(24, 1), Duration(120), mDescriptorA);
+	p_job->AddTrackFile(mTrackFileB, descriptor_id(mDescriptorB), rEditRate, rDuration, mDescriptorB, mHashB);
+	p_job->AddTrackFile(mTrackFileC, descriptor_id(mDescriptorC), EditRate(24, 1), Duration(50), mDescriptorC);
+	return p_job;
+}
+
+void TestCplVariants::substitute() {
+
+	QList<JobGenerateCplVariants::Variant> variants;
+	JobGenerateCplVariants::Variant substituted;
+	substituted.contentTitle = QString("Variant B");
+	substituted.trackFiles.insert(mTrackFileA, mTrackFileB);
+	variants << substituted;
+	JobGenerateCplVariants::Variant unchanged;
+	unchanged.contentTitle = QString("Variant A");
+	variants << unchanged;
+
+	QScopedPointer<JobGenerateCplVariants> job(CreateJob(variants, EditRate(24, 1), Duration(200)));
+	QSignalSpy spy(job.data(), SIGNAL(Result(const QString&, const QUuid&, const QByteArray&, const QByteArray&, const QVariant&)));
+	const Error error = job->PerformRun();
+	QVERIFY2(error.IsError() == false, qPrintable(error.GetErrorDescription()));
+	QCOMPARE(spy.count(), 2);
+
+	QFile template_file(mTemplate);
+	QVERIFY(template_file.open(QIODevice::ReadOnly));
+	const QByteArray template_data = template_file.readAll();
+	QSet<QUuid> ids;
+	for(int i = 0; i < spy.count(); i++) {
+		const QString file_path = spy.at(i).at(0).toString();
+		const QUuid id = spy.at(i).at(1).toUuid();
+		const QByteArray data = spy.at(i).at(2).toByteArray();
+		const QByteArray hash = spy.at(i).at(3).toByteArray();
+		QVERIFY(id != mTemplateId);
+		QVERIFY(ids.contains(id) == false);
+		ids.insert(id);
+		QCOMPARE(file_path, QDir(mDir.path()).absoluteFilePath(QString("CPL_%1.xml").arg(strip_uuid(id))));
+		QVERIFY(QFile::exists(file_path) == false); // The job doesn't write files.
+		QCOMPARE(hash, QCryptographicHash::hash(data, QCryptographicHash::Sha1));
+		QCOMPARE(element_ids(data, "CompositionPlaylist", "Id"), QList<QUuid>() << id);
+		QCOMPARE(element_ids(data, "MainAudioSequence", "Id").toSet().intersect(element_ids(template_data, "MainAudioSequence", "Id").toSet()).size(), 0);
+		QCOMPARE(element_ids(data, "Resource", "Id").toSet().intersect(element_ids(template_data, "Resource", "Id").toSet()).size(), 0);
+		QCOMPARE(element_ids(data, "Segment", "Id").toSet().intersect(element_ids(template_data, "Segment", "Id").toSet()).size(), 0);
+	}
+
+	const QByteArray data_b = spy.at(0).at(2).toByteArray();
+	QCOMPARE(element_texts(data_b, "CompositionPlaylist", "ContentTitle"), QStringList() << "Variant B");
+	QCOMPARE(element_ids(data_b, "Resource", "TrackFileId"), QList<QUuid>() << mTrackFileB << mTrackFileB << mTrackFileC);
+	QCOMPARE(element_ids(data_b, "Resource", "SourceEncoding"), QList<QUuid>() << descriptor_id(mDescriptorB) << descriptor_id(mDescriptorB) << descriptor_id(mDescriptorC));
+	QCOMPARE(element_texts(data_b, "Resource", "IntrinsicDuration"), QStringList() << "200" << "200" << "50");
+	QCOMPARE(element_texts(data_b, "Resource", "EntryPoint"), QStringList() << "0" << "24" << "0");
+	QCOMPARE(element_texts(data_b, "Resource", "SourceDuration"), QStringList() << "48" << "72" << "50");
+	QCOMPARE(element_texts(data_b, "Resource", "Hash"), QStringList() << QString::fromLatin1(mHashB.toBase64()) << QString::fromLatin1(mHashB.toBase64()) << "AAAAAAAAAAAAAAAAAAAAAAAAAAA=");
+	// A is no longer referenced.
+	QCOMPARE(element_ids(data_b, "EssenceDescriptor", "Id").toSet(), QSet<QUuid>() << descriptor_id(mDescriptorB) << descriptor_id(mDescriptorC));
+	QCOMPARE(element_ids(data_b, "EssenceDescriptor", "Id").size(), 2);
+
+	const QByteArray data_a = spy.at(1).at(2).toByteArray();
+	QCOMPARE(element_texts(data_a, "CompositionPlaylist", "ContentTitle"), QStringList() << "Variant A");
+	QCOMPARE(element_ids(data_a, "Resource", "TrackFileId"), QList<QUuid>() << mTrackFileA << mTrackFileA << mTrackFileC);
+	QCOMPARE(element_texts(data_a, "Resource", "IntrinsicDuration"), QStringList() << "120" << "120" << "50");
+	QCOMPARE(element_ids(data_a, "EssenceDescriptor", "Id").toSet(), QSet<QUuid>() << descriptor_id(mDescriptorA) << descriptor_id(mDescriptorC));
+	QCOMPARE(element_ids(data_a, "EssenceDescriptor", "Id").size(), 2);
+}
+
+void TestCplVariants::editRateMismatch() {
+
+	JobGenerateCplVariants::Variant variant;
+	variant.contentTitle = QString("Variant");
+	variant.trackFiles.insert(mTrackFileA, mTrackFileB);
+	QScopedPointer<JobGenerateCplVariants> job(CreateJob(QList<JobGenerateCplVariants::Variant>() << variant, EditRate(25, 1), Duration(200)));
+	QSignalSpy spy(job.data(), SIGNAL(Result(const QString&, const QUuid&, const QByteArray&, const QByteArray&, const QVariant&)));
+	const Error error = job->PerformRun();
+	QVERIFY(error.IsError());
+	QCOMPARE(error.GetErrorMsg(), Error(Error::UnsupportedEssence).GetErrorMsg());
+	QCOMPARE(spy.count(), 0);
+}
+
+void TestCplVariants::shortSubstitute() {
+
+	JobGenerateCplVariants::Variant variant;
+	variant.contentTitle = QString("Variant");
+	variant.trackFiles.insert(mTrackFileA, mTrackFileB);
+	// The second resource of A ends at 24 + 72 = 96.
+	QScopedPointer<JobGenerateCplVariants> short_job(CreateJob(QList<JobGenerateCplVariants::Variant>() << variant, EditRate(24, 1), Duration(95)));
+	QSignalSpy short_spy(short_job.data(), SIGNAL(Result(const QString&, const QUuid&, const QByteArray&, const QByteArray&, const QVariant&)));
+	Error error = short_job->PerformRun();
+	QVERIFY(error.IsError());
+	QCOMPARE(error.GetErrorMsg(), Error(Error::UnknownDuration).GetErrorMsg());
+	QCOMPARE(short_spy.count(), 0);
+
+	QScopedPointer<JobGenerateCplVariants> job(CreateJob(QList<JobGenerateCplVariants::Variant>() << variant, EditRate(24, 1), Duration(96)));
+	QSignalSpy spy(job.data(), SIGNAL(Result(const QString&, const QUuid&, const QByteArray&, const QByteArray&, const QVariant&)));
+	error = job->PerformRun();
+	QVERIFY2(error.IsError() == false, qPrintable(error.GetErrorDescription()));
+	QCOMPARE(spy.count(), 1);
+	QCOMPARE(element_texts(spy.at(0).at(2).toByteArray(), "Resource", "IntrinsicDuration"), QStringList() << "96" << "96" << "50");
+}
+
+void TestCplVariants::unknownTrackFile() {
+
+	// The template doesn't reference the replaced track file.
+	JobGenerateCplVariants::Variant not_in_template;
+	not_in_template.contentTitle = QString("Variant");
+	not_in_template.trackFiles.insert(QUuid::createUuid(), mTrackFileB);
+	QScopedPointer<JobGenerateCplVariants> job(CreateJob(QList<JobGenerateCplVariants::Variant>() << not_in_template, EditRate(24, 1), Duration(200)));
+	QSignalSpy spy(job.data(), SIGNAL(Result(const QString&, const QUuid&, const QByteArray&, const QByteArray&, const QVariant&)));
+	Error error = job->PerformRun();
+	QVERIFY(error.IsError());
+	QCOMPARE(error.GetErrorMsg(), Error(Error::SourceFilesMissing).GetErrorMsg());
+	QCOMPARE(spy.count(), 0);
+
+	// The substitute isn't registered. No variant is passed even if another one is valid.
+	JobGenerateCplVariants::Variant valid;
+	valid.contentTitle = QString("Valid");
+	valid.trackFiles.insert(mTrackFileA, mTrackFileB);
+	JobGenerateCplVariants::Variant unregistered;
+	unregistered.contentTitle = QString("Unregistered");
+	unregistered.trackFiles.insert(mTrackFileA, QUuid::createUuid());
+	QScopedPointer<JobGenerateCplVariants> unregistered_job(CreateJob(QList<JobGenerateCplVariants::Variant>() << valid << unregistered, EditRate(24, 1), Duration(200)));
+	QSignalSpy unregistered_spy(unregistered_job.data(), SIGNAL(Result(const QString&, const QUuid&, const QByteArray&, const QByteArray&, const QVariant&)));
+	error = unregistered_job->PerformRun();
+	QVERIFY(error.IsError());
+	QCOMPARE(error.GetErrorMsg(), Error(Error::SourceFilesMissing).GetErrorMsg());
+	QCOMPARE(unregistered_spy.count(), 0);
+}
+
+void TestCplVariants::substitutionTable() {
+
+	const QString table_path = QDir(mDir.path()).absoluteFilePath("variants.csv");
+	QFile table(table_path);
+	QVERIFY(table.open(QIODevice::WriteOnly | QIODevice::Text));
+	table.write(QString("ContentTitle;%1;%2\n").arg(strip_uuid(mTrackFileA)).arg(urn(mTrackFileC)).toUtf8());
+	table.write(QString("\"Title; with separator\";%1;\n").arg(urn(mTrackFileB)).toUtf8());
+	table.write("\n");
+	table.write(QString("Second;;%1\n").arg(strip_uuid(mTrackFileB)).toUtf8());
+	table.close();
+
+	QList<JobGenerateCplVariants::Variant> variants;
+	Error error = JobGenerateCplVariants::ParseSubstitutionTable(table_path, variants);
+	QVERIFY2(error.IsError() == false, qPrintable(error.GetErrorDescription()));
+	QCOMPARE(variants.size(), 2);
+	QCOMPARE(variants.at(0).contentTitle.first, QString("Title; with separator"));
+	QCOMPARE(variants.at(0).trackFiles.size(), 1);
+	QCOMPARE(variants.at(0).trackFiles.value(mTrackFileA), mTrackFileB);
+	QCOMPARE(variants.at(1).contentTitle.first, QString("Second"));
+	QCOMPARE(variants.at(1).trackFiles.size(), 1);
+	QCOMPARE(variants.at(1).trackFiles.value(mTrackFileC), mTrackFileB);
+
+	QVERIFY(table.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text));
+	table.write(QString("%1\n%2\n").arg(strip_uuid(mTrackFileA)).arg(strip_uuid(mTrackFileB)).toUtf8());
+	table.close();
+	error = JobGenerateCplVariants::ParseSubstitutionTable(table_path, variants);
+	QVERIFY(error.IsError()); // No ContentTitle column.
+}
+
+QTEST_GUILESS_MAIN(TestCplVariants)
+#include "TestCplVariants.moc"
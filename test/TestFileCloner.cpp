@@ -0,0 +1,190 @@
+/* Copyright(C) 2016 Björn Stresing, Denis Manthey, Wolfgang Ruppel
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "FileCloner.h"
+#include <QtTest>
+#include <QTemporaryDir>
+#include <QFile>
+#include <QDir>
+
+
+/*! \brief Checks the fallback order of FileCloner::Clone() on the file system of the temporary directory.
+Which methods succeed depends on the file system. The tests only rely on the order of FileCloner::eMethod and on the guarantees of every method.
+*/
+class TestFileCloner : public QObject {
+
+	Q_OBJECT
+
+private slots:
+	void init();
+	void cleanup();
+	void fallbackOrder_data();
+	void fallbackOrder();
+	void stream();
+	void existingDestination();
+	void missingSource();
+	void leftoverPartFile();
+	void cancel();
+
+private:
+	QString Path(const QString &rName) const { return QDir(mpDir->path()).absoluteFilePath(rName); }
+	QTemporaryDir *mpDir;
+	QString mSource;
+	QByteArray mContent;
+};
+
+namespace {
+
+	const qint64 source_size = 5 * 1024 * 1024 + 123; // [bytes] More than one stream buffer.
+
+	class CountingListener : public FileCloner::Listener {
+
+	public:
+		explicit CountingListener(qint64 cancelAfter = -1) : mBytes(0), mCancelAfter(cancelAfter) {}
+		virtual bool BytesCopied(qint64 bytes) { mBytes += bytes; return mCancelAfter < 0 || mBytes < mCancelAfter; }
+		qint64 GetBytes() const { return mBytes; }
+
+	private:
+		qint64 mBytes;
+		const qint64 mCancelAfter;
+	};
+
+	QByteArray read_file(const QString &rFilePath) {
+
+		QFile file(rFilePath);
+		if(file.open(QIODevice::ReadOnly) == false) return QByteArray();
+		return file.readAll();
+	}
+
+	//! Overwrites the first byte in place. Renaming a new file over rFilePath would break a hard link.
+	bool modify_in_place(const QString &rFilePath) {
+
+		QFile file(rFilePath);
+		if(file.open(QIODevice::ReadWrite) == false) return false;
+		char first = 0;
+		if(file.getChar(&first) == false || file.seek(0) == false) return false;
+		return file.putChar(~first);
+	}
+
+	bool has_part_files(const QDir &rDir) {
+
+		return rDir.entryList(QStringList() << "*.part", QDir::Files | QDir::Hidden).isEmpty() == false;
+	}
+}
+
+void TestFileCloner::init() {
+
+	mpDir = new QTemporaryDir;
+	QVERIFY(mpDir->isValid());
+	mContent = QByteArray(source_size, Qt::Uninitialized);
+	quint32 state = 0x12345678;
+	for(int i = 0; i < mContent.size(); i++) {
+		state = state * 1664525 + 1013904223;
+		mContent[i] = (char)(state >> 24);
+	}
+	mSource = Path("source.mxf");
+	QFile source(mSource);
+	QVERIFY(source.open(QIODevice::WriteOnly));
+	QCOMPARE(source.write(mContent), (qint64)mContent.size());
+}
+
+void TestFileCloner::cleanup() {
+
+	delete mpDir;
+	mpDir = NULL;
+}
+
+void TestFileCloner::fallbackOrder_data() {
+
+	QTest::addColumn<int>("firstMethod");
+	for(int i = 0; i < FileCloner::MethodCount; i++) QTest::newRow(qPrintable(FileCloner::GetMethodName((FileCloner::eMethod)i))) << i;
+}
+
+void TestFileCloner::fallbackOrder() {
+
+	QFETCH(int, firstMethod);
+	const QString destination = Path("export/destination.mxf");
+	FileCloner::eMethod method = FileCloner::MethodCount;
+	CountingListener listener;
+	Error error = FileCloner::Clone(mSource, destination, method, (FileCloner::eMethod)firstMethod, &listener);
+	QVERIFY2(error.IsError() == false, qPrintable(error.GetErrorDescription()));
+	// Methods before firstMethod are never tried. Stream is always available.
+	QVERIFY(method >= firstMethod && method < FileCloner::MethodCount);
+	QVERIFY(FileCloner::IsSupported(method));
+	QVERIFY(read_file(destination) == mContent);
+	QCOMPARE(listener.GetBytes(), source_size);
+	QVERIFY(has_part_files(QDir(Path("export"))) == false);
+	// Only a hard link shares later in place modifications with the source.
+	QVERIFY(modify_in_place(mSource));
+	QCOMPARE(read_file(destination) == read_file(mSource), method == FileCloner::Hardlink);
+}
+
+void TestFileCloner::stream() {
+
+	const QString destination = Path("destination.mxf");
+	FileCloner::eMethod method = FileCloner::MethodCount;
+	Error error = FileCloner::Clone(mSource, destination, method, FileCloner::Stream);
+	QVERIFY2(error.IsError() == false, qPrintable(error.GetErrorDescription()));
+	QCOMPARE((int)method, (int)FileCloner::Stream);
+	QVERIFY(read_file(destination) == mContent);
+}
+
+void TestFileCloner::existingDestination() {
+
+	const QString destination = Path("destination.mxf");
+	QFile existing(destination);
+	QVERIFY(existing.open(QIODevice::WriteOnly));
+	existing.write("existing");
+	existing.close();
+	for(int i = 0; i < FileCloner::MethodCount; i++) {
+		FileCloner::eMethod method = FileCloner::MethodCount;
+		QVERIFY(FileCloner::Clone(mSource, destination, method, (FileCloner::eMethod)i).IsError());
+		QCOMPARE(read_file(destination), QByteArray("existing"));
+	}
+}
+
+void TestFileCloner::missingSource() {
+
+	FileCloner::eMethod method = FileCloner::MethodCount;
+	QVERIFY(FileCloner::Clone(Path("missing.mxf"), Path("destination.mxf"), method).IsError());
+	QVERIFY(QFile::exists(Path("destination.mxf")) == false);
+}
+
+void TestFileCloner::leftoverPartFile() {
+
+	// Remains of an interrupted clone are replaced.
+	QFile part(Path(".destination.mxf.part"));
+	QVERIFY(part.open(QIODevice::WriteOnly));
+	part.write("interrupted");
+	part.close();
+	FileCloner::eMethod method = FileCloner::MethodCount;
+	Error error = FileCloner::Clone(mSource, Path("destination.mxf"), method, FileCloner::Stream);
+	QVERIFY2(error.IsError() == false, qPrintable(error.GetErrorDescription()));
+	QVERIFY(read_file(Path("destination.mxf")) == mContent);
+	QVERIFY(has_part_files(QDir(mpDir->path())) == false);
+}
+
+void TestFileCloner::cancel() {
+
+	const QString destination = Path("destination.mxf");
+	FileCloner::eMethod method = FileCloner::MethodCount;
+	CountingListener listener(1);
+	QVERIFY(FileCloner::Clone(mSource, destination, method, FileCloner::Stream, &listener).IsError());
+	QVERIFY(QFile::exists(destination) == false);
+	QVERIFY(has_part_files(QDir(mpDir->path())) == false);
+}
+
+QTEST_GUILESS_MAIN(TestFileCloner)
+#include "TestFileCloner.moc"
@@ -0,0 +1,208 @@
+/* Copyright(C) 2016 Björn Stresing, Denis Manthey, Wolfgang Ruppel
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "HashCheckpoints.h"
+#include <QtTest>
+#include <QTemporaryDir>
+#include <QCryptographicHash>
+#include <QFile>
+#include <QDir>
+
+
+/*! \brief Checks that a hash resumed from a HashCheckpoints record matches a hash of the complete file and that records of changed files are never used.
+The records are kept in a temporary cache directory.
+*/
+class TestHashCheckpoints : public QObject {
+
+	Q_OBJECT
+
+private slots:
+	void initTestCase();
+	void init();
+	void cleanup();
+	void cleanupTestCase();
+	void resume();
+	void digest();
+	void sizeChanged();
+	void fileReplaced();
+	void remove();
+	void corruptRecord();
+	void missingFile();
+
+private:
+	QString Path(const QString &rName) const { return QDir(mpDir->path()).absoluteFilePath(rName); }
+	QString mPreviousCacheDir;
+	QTemporaryDir *mpDir;
+	QString mFile;
+	QByteArray mContent;
+};
+
+namespace {
+
+	const int file_size = 1024 * 1024 + 17; // [bytes]
+	const int checkpoint_offset = 300 * 1024 + 5; // [bytes] Not a multiple of the SHA-1 block size.
+
+	QByteArray test_data(int size, quint32 seed) {
+
+		QByteArray data(size, Qt::Uninitialized);
+		for(int i = 0; i < size; i++) {
+			seed = seed * 1664525 + 1013904223;
+			data[i] = (char)(seed >> 24);
+		}
+		return data;
+	}
+
+	bool write_file(const QString &rFilePath, const QByteArray &rData) {
+
+		QFile file(rFilePath);
+		return file.open(QIODevice::WriteOnly) && file.write(rData) == rData.size();
+	}
+
+	//! Hashes the first rOffset bytes of rFilePath and saves a checkpoint as JobCalculateHash does.
+	void save_checkpoint(const QString &rFilePath, const QByteArray &rData, int offset) {
+
+		const QFileInfo file_info(rFilePath);
+		const HashCheckpoints::FileStamp stamp = HashCheckpoints::GetStamp(file_info);
+		Sha1 hasher;
+		hasher.AddData(rData.constData(), offset);
+		HashCheckpoints::Instance().SaveCheckpoint(file_info, stamp, hasher);
+	}
+}
+
+void TestHashCheckpoints::initTestCase() {
+
+	mPreviousCacheDir = HashCheckpoints::Instance().GetCacheDir();
+	mContent = test_data(file_size, 1);
+}
+
+void TestHashCheckpoints::init() {
+
+	mpDir = new QTemporaryDir;
+	QVERIFY(mpDir->isValid());
+	HashCheckpoints::Instance().SetCacheDir(Path("cache"));
+	mFile = Path("track.mxf");
+	QVERIFY(write_file(mFile, mContent));
+}
+
+void TestHashCheckpoints::cleanup() {
+
+	delete mpDir;
+	mpDir = NULL;
+}
+
+void TestHashCheckpoints::cleanupTestCase() {
+
+	HashCheckpoints::Instance().SetCacheDir(mPreviousCacheDir);
+}
+
+void TestHashCheckpoints::resume() {
+
+	save_checkpoint(mFile, mContent, checkpoint_offset);
+	Sha1 hasher;
+	hasher.AddData("stale", 5);
+	QVERIFY(HashCheckpoints::Instance().Restore(QFileInfo(mFile), hasher));
+	QCOMPARE(hasher.GetLength(), (qint64)checkpoint_offset);
+	// Continue reading where the checkpoint stopped.
+	QFile file(mFile);
+	QVERIFY(file.open(QIODevice::ReadOnly));
+	QVERIFY(file.seek(hasher.GetLength()));
+	hasher.AddData(file.readAll());
+	QCOMPARE(hasher.Result(), QCryptographicHash::hash(mContent, QCryptographicHash::Sha1));
+	// A checkpoint is no digest.
+	QVERIFY(HashCheckpoints::Instance().GetDigest(QFileInfo(mFile)).isEmpty());
+}
+
+void TestHashCheckpoints::digest() {
+
+	const QByteArray digest = QCryptographicHash::hash(mContent, QCryptographicHash::Sha1);
+	save_checkpoint(mFile, mContent, checkpoint_offset);
+	HashCheckpoints::Instance().SaveDigest(QFileInfo(mFile), HashCheckpoints::GetStamp(QFileInfo(mFile)), digest);
+	QCOMPARE(HashCheckpoints::Instance().GetDigest(QFileInfo(mFile)), digest);
+	// The digest replaces the checkpoint.
+	Sha1 hasher;
+	QVERIFY(HashCheckpoints::Instance().Restore(QFileInfo(mFile), hasher) == false);
+	QCOMPARE(hasher.GetLength(), (qint64)0);
+}
+
+void TestHashCheckpoints::sizeChanged() {
+
+	save_checkpoint(mFile, mContent, checkpoint_offset);
+	QFile file(mFile);
+	QVERIFY(file.open(QIODevice::Append));
+	file.write("appended");
+	file.close();
+	Sha1 hasher;
+	QVERIFY(HashCheckpoints::Instance().Restore(QFileInfo(mFile), hasher) == false);
+	QCOMPARE(hasher.GetLength(), (qint64)0);
+}
+
+void TestHashCheckpoints::fileReplaced() {
+
+	const QByteArray digest = QCryptographicHash::hash(mContent, QCryptographicHash::Sha1);
+	HashCheckpoints::Instance().SaveDigest(QFileInfo(mFile), HashCheckpoints::GetStamp(QFileInfo(mFile)), digest);
+	// A file of the same size renamed over the hashed one. Its modification time is set to the old one, like a copy that preserves time stamps.
+	const QDateTime modified = QFileInfo(mFile).lastModified();
+	const QString replacement = Path("replacement.mxf");
+	QVERIFY(write_file(replacement, test_data(file_size, 2)));
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+	{
+		QFile file(replacement);
+		QVERIFY(file.open(QIODevice::ReadWrite));
+		QVERIFY(file.setFileTime(modified, QFileDevice::FileModificationTime));
+	}
+#endif
+	QVERIFY(QFile::remove(mFile));
+	QVERIFY(QFile::rename(replacement, mFile));
+	QVERIFY(HashCheckpoints::Instance().GetDigest(QFileInfo(mFile)).isEmpty());
+}
+
+void TestHashCheckpoints::remove() {
+
+	HashCheckpoints::Instance().SaveDigest(QFileInfo(mFile), HashCheckpoints::GetStamp(QFileInfo(mFile)), QCryptographicHash::hash(mContent, QCryptographicHash::Sha1));
+	HashCheckpoints::Instance().Remove(QFileInfo(mFile));
+	QVERIFY(HashCheckpoints::Instance().GetDigest(QFileInfo(mFile)).isEmpty());
+	save_checkpoint(mFile, mContent, checkpoint_offset);
+	HashCheckpoints::Instance().Remove(QFileInfo(mFile));
+	Sha1 hasher;
+	QVERIFY(HashCheckpoints::Instance().Restore(QFileInfo(mFile), hasher) == false);
+}
+
+void TestHashCheckpoints::corruptRecord() {
+
+	save_checkpoint(mFile, mContent, checkpoint_offset);
+	const QDir cache_dir(Path("cache"));
+	const QStringList records = cache_dir.entryList(QStringList() << "*.sha1", QDir::Files);
+	QCOMPARE(records.size(), 1);
+	QFile record(cache_dir.absoluteFilePath(records.first()));
+	QVERIFY(record.open(QIODevice::ReadWrite));
+	QVERIFY(record.resize(record.size() - 3));
+	record.close();
+	Sha1 hasher;
+	QVERIFY(HashCheckpoints::Instance().Restore(QFileInfo(mFile), hasher) == false);
+	QCOMPARE(hasher.GetLength(), (qint64)0);
+}
+
+void TestHashCheckpoints::missingFile() {
+
+	const QFileInfo missing(Path("missing.mxf"));
+	QCOMPARE(HashCheckpoints::GetStamp(missing).size, (qint64)-1);
+	QVERIFY(HashCheckpoints::Instance().GetDigest(missing).isEmpty());
+	// A stamp of a missing file is never matched.
+	HashCheckpoints::Instance().SaveDigest(missing, HashCheckpoints::GetStamp(missing), QByteArray(20, 'x'));
+	QVERIFY(HashCheckpoints::Instance().GetDigest(missing).isEmpty());
+}
+
+QTEST_GUILESS_MAIN(TestHashCheckpoints)
+#include "TestHashCheckpoints.moc"
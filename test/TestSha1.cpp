@@ -0,0 +1,137 @@
+/* Copyright(C) 2016 Björn Stresing, Denis Manthey, Wolfgang Ruppel
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "Sha1.h"
+#include <QtTest>
+#include <QCryptographicHash>
+
+
+/*! \brief Checks Sha1 against the FIPS 180 test vectors and checks that a hash restored from a saved state continues exactly where it stopped.
+*/
+class TestSha1 : public QObject {
+
+	Q_OBJECT
+
+private slots:
+	void knownAnswer_data();
+	void knownAnswer();
+	void millionA();
+	void resultKeepsState();
+	void splitSaveRestore();
+	void malformedState();
+};
+
+namespace {
+
+	QByteArray test_data(int size) {
+
+		QByteArray data(size, Qt::Uninitialized);
+		quint32 state = 0x9E3779B9;
+		for(int i = 0; i < size; i++) {
+			state = state * 1664525 + 1013904223;
+			data[i] = (char)(state >> 24);
+		}
+		return data;
+	}
+}
+
+void TestSha1::knownAnswer_data() {
+
+	QTest::addColumn<QByteArray>("message");
+	QTest::addColumn<QByteArray>("digest");
+	QTest::newRow("empty") << QByteArray("") << QByteArray("da39a3ee5e6b4b0d3255bfef95601890afd80709");
+	QTest::newRow("abc") << QByteArray("abc") << QByteArray("a9993e364706816aba3e25717850c26c9cd0d89d");
+	QTest::newRow("448 bit") << QByteArray("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq") << QByteArray("84983e441c3bd26ebaae4aa1f95129e5e54670f1");
+	QTest::newRow("896 bit") << QByteArray("abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu") << QByteArray("a49b2446a02c645bf419f995b67091253a04a259");
+}
+
+void TestSha1::knownAnswer() {
+
+	QFETCH(QByteArray, message);
+	QFETCH(QByteArray, digest);
+	Sha1 hasher;
+	hasher.AddData(message);
+	QCOMPARE(hasher.Result().toHex(), digest);
+	QCOMPARE(hasher.GetLength(), (qint64)message.size());
+	// Byte by byte.
+	Sha1 bytewise;
+	for(int i = 0; i < message.size(); i++) bytewise.AddData(message.constData() + i, 1);
+	QCOMPARE(bytewise.Result().toHex(), digest);
+}
+
+void TestSha1::millionA() {
+
+	const QByteArray chunk(1000, 'a');
+	Sha1 hasher;
+	for(int i = 0; i < 1000; i++) hasher.AddData(chunk);
+	QCOMPARE(hasher.Result().toHex(), QByteArray("34aa973cd4c4daa4f61eeb2bdd41a48e0d9e7a1d"));
+}
+
+void TestSha1::resultKeepsState() {
+
+	const QByteArray data = test_data(1000);
+	Sha1 hasher;
+	hasher.AddData(data.left(300));
+	QCOMPARE(hasher.Result(), QCryptographicHash::hash(data.left(300), QCryptographicHash::Sha1));
+	hasher.AddData(data.mid(300));
+	QCOMPARE(hasher.Result(), QCryptographicHash::hash(data, QCryptographicHash::Sha1));
+}
+
+void TestSha1::splitSaveRestore() {
+
+	const QByteArray data = test_data(4 * 64 + 17);
+	const QByteArray expected = QCryptographicHash::hash(data, QCryptographicHash::Sha1);
+	// Every split offset covers an empty buffer, partial blocks and block boundaries.
+	for(int split = 0; split <= data.size(); split++) {
+		Sha1 first;
+		first.AddData(data.constData(), split);
+		const QByteArray state = first.SaveState();
+		Sha1 second;
+		second.AddData("garbage", 7);
+		QVERIFY2(second.RestoreState(state), qPrintable(QString("split %1").arg(split)));
+		QCOMPARE(second.GetLength(), (qint64)split);
+		second.AddData(data.constData() + split, data.size() - split);
+		QVERIFY2(second.Result() == expected, qPrintable(QString("split %1").arg(split)));
+		// A state saved from the restored hash is identical.
+		Sha1 third;
+		QVERIFY(third.RestoreState(state));
+		QCOMPARE(third.SaveState(), state);
+	}
+}
+
+void TestSha1::malformedState() {
+
+	Sha1 source;
+	source.AddData(test_data(100));
+	const QByteArray state = source.SaveState();
+	const QByteArray empty_digest = QCryptographicHash::hash(QByteArray(), QCryptographicHash::Sha1);
+
+	Sha1 hasher;
+	hasher.AddData("abc", 3);
+	QVERIFY(hasher.RestoreState(QByteArray()) == false);
+	QCOMPARE(hasher.GetLength(), (qint64)0);
+	QCOMPARE(hasher.Result(), empty_digest);
+
+	hasher.AddData("abc", 3);
+	QVERIFY(hasher.RestoreState(state.left(state.size() - 1)) == false);
+	QCOMPARE(hasher.Result(), empty_digest);
+
+	hasher.AddData("abc", 3);
+	QVERIFY(hasher.RestoreState(state + 'x') == false);
+	QCOMPARE(hasher.Result(), empty_digest);
+}
+
+QTEST_APPLESS_MAIN(TestSha1)
+#include "TestSha1.moc"
@@ -0,0 +1,144 @@
+/* Copyright(C) 2016 Björn Stresing, Denis Manthey, Wolfgang Ruppel
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "TimedTextResourceResolver.h"
+#include <QtTest>
+#include <QTemporaryDir>
+#include <QFile>
+#include <QDir>
+
+
+/*! \brief Checks the size bound of TimedTextResourceCache and that TimedTextResourceResolver doesn't depend on the working directory.
+*/
+class TestTimedTextResourceResolver : public QObject {
+
+	Q_OBJECT
+
+private slots:
+	void initTestCase();
+	void init();
+	void cleanupTestCase();
+	void cacheLookup();
+	void cacheCapacity();
+	void openMissingDirectory();
+	void resolveBeforeOpen();
+	void unknownResource();
+
+private:
+	int mDefaultCapacity;
+};
+
+namespace {
+
+	const unsigned char png_magic[] = { 0x89, 'P', 'N', 'G', 0x0d, 0x0a, 0x1a, 0x0a };
+
+	QByteArray resource(int size, char fill) {
+
+		return QByteArray(size, fill);
+	}
+}
+
+void TestTimedTextResourceResolver::initTestCase() {
+
+	mDefaultCapacity = TimedTextResourceCache::Instance().GetCapacity();
+}
+
+void TestTimedTextResourceResolver::init() {
+
+	TimedTextResourceCache::Instance().SetCapacity(mDefaultCapacity);
+	TimedTextResourceCache::Instance().Clear();
+}
+
+void TestTimedTextResourceResolver::cleanupTestCase() {
+
+	TimedTextResourceCache::Instance().SetCapacity(mDefaultCapacity);
+	TimedTextResourceCache::Instance().Clear();
+}
+
+void TestTimedTextResourceResolver::cacheLookup() {
+
+	TimedTextResourceCache &r_cache = TimedTextResourceCache::Instance();
+	QByteArray data;
+	QVERIFY(r_cache.Lookup("font", data) == false);
+	r_cache.Insert("font", resource(4096, 'f'));
+	QVERIFY(r_cache.Lookup("font", data));
+	QCOMPARE(data, resource(4096, 'f'));
+	QCOMPARE(r_cache.GetSize(), (qint64)4096);
+	r_cache.Clear();
+	QVERIFY(r_cache.Lookup("font", data) == false);
+	QCOMPARE(r_cache.GetSize(), (qint64)0);
+}
+
+void TestTimedTextResourceResolver::cacheCapacity() {
+
+	TimedTextResourceCache &r_cache = TimedTextResourceCache::Instance();
+	r_cache.SetCapacity(1); // [MiB]
+	QCOMPARE(r_cache.GetCapacity(), 1);
+	for(int i = 0; i < 8; i++) r_cache.Insert(QByteArray::number(i), resource(256 * 1024, 'a' + i));
+	QVERIFY(r_cache.GetSize() <= 1024 * 1024);
+	QByteArray data;
+	// Least recently used resources are evicted first.
+	QVERIFY(r_cache.Lookup("0", data) == false);
+	QVERIFY(r_cache.Lookup("7", data));
+	QCOMPARE(data, resource(256 * 1024, 'h'));
+	// A resource larger than the capacity is rejected.
+	r_cache.Insert("large", resource(2 * 1024 * 1024, 'l'));
+	QVERIFY(r_cache.Lookup("large", data) == false);
+	QVERIFY(r_cache.Lookup("7", data));
+}
+
+void TestTimedTextResourceResolver::openMissingDirectory() {
+
+	QTemporaryDir dir;
+	QVERIFY(dir.isValid());
+	TimedTextResourceResolver resolver;
+	QVERIFY(resolver.Open(QDir(dir.path()).absoluteFilePath("missing")).IsError());
+}
+
+void TestTimedTextResourceResolver::resolveBeforeOpen() {
+
+	TimedTextResourceResolver resolver;
+	const byte_t id[ASDCP::UUIDlen] = { 0 };
+	ASDCP::TimedText::FrameBuffer buffer;
+	QVERIFY(ASDCP_FAILURE(resolver.ResolveRID(id, buffer)));
+}
+
+void TestTimedTextResourceResolver::unknownResource() {
+
+	QTemporaryDir dir;
+	QVERIFY(dir.isValid());
+	QFile image(QDir(dir.path()).absoluteFilePath("image.png"));
+	QVERIFY(image.open(QIODevice::WriteOnly));
+	image.write((const char*)png_magic, sizeof(png_magic));
+	image.write(resource(1024, 0));
+	image.close();
+
+	// The base directory is explicit. Moving the working directory elsewhere must not matter.
+	const QString working_dir = QDir::currentPath();
+	QVERIFY(QDir::setCurrent(QDir::rootPath()));
+	TimedTextResourceResolver resolver;
+	Error error = resolver.Open(dir.path());
+	QDir::setCurrent(working_dir);
+	QVERIFY2(error.IsError() == false, qPrintable(error.GetErrorDescription()));
+
+	const byte_t id[ASDCP::UUIDlen] = { 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x57, 0x08, 0x89, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10 };
+	ASDCP::TimedText::FrameBuffer buffer;
+	QVERIFY(ASDCP_FAILURE(resolver.ResolveRID(id, buffer)));
+	// Failures aren't cached.
+	QCOMPARE(TimedTextResourceCache::Instance().GetSize(), (qint64)0);
+}
+
+QTEST_GUILESS_MAIN(TestTimedTextResourceResolver)
+#include "TestTimedTextResourceResolver.moc"